@@ -91,12 +91,12 @@ class Configure(config.base.Configure):
                                             'unistd', 'sys/sysinfo', 'machine/endian', 'sys/param', 'sys/procfs', 'sys/resource',
                                             'sys/systeminfo', 'sys/times', 'sys/utsname','string', 'stdlib','memory',
                                             'sys/socket','sys/wait','netinet/in','netdb','Direct','time','Ws2tcpip','sys/types',
-                                            'WindowsX', 'cxxabi','float','ieeefp','stdint','fenv','sched','pthread'])
+                                            'WindowsX', 'cxxabi','float','ieeefp','stdint','fenv','sched','pthread','sys/mman'])
     functions = ['access', '_access', 'clock', 'drand48', 'getcwd', '_getcwd', 'getdomainname', 'gethostname', 'getpwuid',
                  'gettimeofday', 'getwd', 'memalign', 'memmove', 'mkstemp', 'popen', 'PXFGETARG', 'rand', 'getpagesize',
                  'readlink', 'realpath',  'sigaction', 'signal', 'sigset', 'usleep', 'sleep', '_sleep', 'socket',
                  'times', 'gethostbyname', 'uname','snprintf','_snprintf','_fullpath','lseek','_lseek','time','fork','stricmp',
-                 'strcasecmp', 'bzero', 'dlopen', 'dlsym', 'dlclose', 'dlerror',
+                 'strcasecmp', 'bzero', 'dlopen', 'dlsym', 'dlclose', 'dlerror', 'mmap', 'pwrite', 'ftruncate',
                  '_intel_fast_memcpy','_intel_fast_memset']
     libraries1 = [(['socket', 'nsl'], 'socket'), (['fpe'], 'handle_sigfpes')]
     self.headers.headers.extend(headersC)
@@ -609,6 +609,21 @@ class Configure(config.base.Configure):
     if self.checkLink('#define _POSIX_C_SOURCE 200112L\n#include <stdlib.h>','long v = atoll("25")') or self.checkLink ('#include <stdlib.h>','long v = atoll("25")'):
        self.addDefine('HAVE_ATOLL', '1')
 
+  def configureMPINeighborhood(self):
+    '''Checks for the MPI-3 distributed graph topologies and neighborhood collectives used by PETSCSFNEIGHBOR'''
+    if self.mpi.usingMPIUni:
+      return
+    found = 1
+    for funcName in ['MPI_Dist_graph_create_adjacent', 'MPI_Neighbor_alltoallv']:
+      if self.libraries.check(self.mpi.lib, funcName):
+        self.addDefine('HAVE_'+funcName.upper(), 1)
+      else:
+        found = 0
+    if found:
+      # the PETSCSFNEIGHBOR tests are only run when it is built
+      self.regression.addMakeMacro('TEST_RUNS', self.regression.makeMacros['TEST_RUNS']+' MPI_NEIGHBOR')
+    return
+
   def configureUnused(self):
     '''Sees if __attribute((unused)) is supported'''
     if self.framework.argDB['with-ios']:
@@ -890,6 +905,7 @@ class Configure(config.base.Configure):
     self.executeTest(self.configureFortranFlush)
     self.executeTest(self.configureFeatureTestMacros)
     self.executeTest(self.configureAtoll)
+    self.executeTest(self.configureMPINeighborhood)
     # dummy rules, always needed except for remote builds
     self.addMakeRule('remote','')
     self.addMakeRule('remoteclean','')
@@ -55,6 +55,8 @@
       PetscEnum MAT_SPD
       PetscEnum MAT_NO_OFF_PROC_ENTRIES
       PetscEnum MAT_NO_OFF_PROC_ZERO_ROWS
+      PetscEnum MAT_CONCURRENT_ADD_VALUES
+      PetscEnum MAT_SAME_OFF_PROC_ENTRIES
       PetscEnum MAT_DIAGBLOCK_CSR
       PetscEnum MAT_OFFDIAGBLOCK_CSR
       PetscEnum MAT_CSR
@@ -92,7 +94,9 @@
       parameter (MAT_SPD=15)
       parameter (MAT_NO_OFF_PROC_ENTRIES=-5)
       parameter (MAT_NO_OFF_PROC_ZERO_ROWS=-6)
-      parameter (MAT_OPTION_MAX=16)
+      parameter (MAT_CONCURRENT_ADD_VALUES=16)
+      parameter (MAT_SAME_OFF_PROC_ENTRIES=17)
+      parameter (MAT_OPTION_MAX=18)
 !
 !  MatFactorShiftType
 !
@@ -486,6 +490,8 @@
 !
       PetscEnum MATRIX_BINARY_FORMAT_DENSE
       parameter (MATRIX_BINARY_FORMAT_DENSE=-1)
+      PetscEnum MATRIX_BINARY_FORMAT_PARTITIONED
+      parameter (MATRIX_BINARY_FORMAT_PARTITIONED=-2)
 !
 ! MPChacoGlobalType
       PetscEnum MP_CHACO_MULTILEVEL_KL
@@ -75,6 +75,12 @@
 #define MATAIJCRL          'aijcrl'
 #define MATSEQAIJCRL       'seqaijcrl'
 #define MATMPIAIJCRL       'mpiaijcrl'
+#define MATSELL            'sell'
+#define MATSEQSELL         'seqsell'
+#define MATMPISELL         'mpisell'
+#define MATAIJDELTA        'aijdelta'
+#define MATSEQAIJDELTA     'seqaijdelta'
+#define MATMPIAIJDELTA     'mpiaijdelta'
 #define MATAIJCUSP         'aijcusp'
 #define MATSEQAIJCUSP      'seqaijcusp'
 #define MATMPIAIJCUSP      'mpiaijcusp'
@@ -212,6 +212,8 @@ PETSC_EXTERN PetscErrorCode MatHeaderMerge(Mat,Mat);
 PETSC_EXTERN PetscErrorCode MatHeaderReplace(Mat,Mat);
 PETSC_EXTERN PetscErrorCode MatAXPYGetxtoy_Private(PetscInt,PetscInt*,PetscInt*,PetscInt*, PetscInt*,PetscInt*,PetscInt*, PetscInt**);
 PETSC_EXTERN PetscErrorCode MatDiagonalSet_Default(Mat,Vec,InsertMode);
+PETSC_EXTERN PetscErrorCode MatView_Binary_Partitioned_Private(Mat,PetscViewer,PetscInt,PetscInt[],PetscInt[],PetscScalar[]);
+PETSC_EXTERN PetscErrorCode MatLoad_Binary_Partitioned_Private(Mat,PetscViewer);
 
 #if defined(PETSC_USE_DEBUG)
 #  define MatCheckPreallocated(A,arg) do {                              \
@@ -242,6 +244,26 @@ PETSC_EXTERN PetscErrorCode PetscMatStashSpaceGet(PetscInt,PetscInt,PetscMatStas
 PETSC_EXTERN PetscErrorCode PetscMatStashSpaceContiguous(PetscInt,PetscMatStashSpace *,PetscScalar *,PetscInt *,PetscInt *);
 PETSC_EXTERN PetscErrorCode PetscMatStashSpaceDestroy(PetscMatStashSpace*);
 
+/*
+   The communication plan of a stash, recorded by the first assembly with MAT_SAME_OFF_PROC_ENTRIES.
+   The following assemblies only send the values, to the same processes and in the same order, and
+   the receivers take the row and column indices from the plan. The message buffers of the stash
+   are kept with the plan.
+*/
+typedef struct {
+  PetscInt      n;                      /* number of stashed entries */
+  PetscInt      *slot;                  /* position in svalues of each stashed entry, -(first+1) if it repeats the entry first */
+  PetscInt      *idx;                   /* rows and columns of the stashed entries, to check they do not change (debug only) */
+  PetscMPIInt   nsends,nrecvs;
+  PetscMPIInt   *sranks,*rranks;        /* the processes sent to and received from */
+  PetscInt      *sstarts,*slens;        /* start in svalues and number of entries of each send */
+  PetscInt      *rstarts,*rlens;        /* start in the received entries and number of entries of each receive */
+  PetscBool     inuse;                  /* the current assembly uses the plan, it is false while it is recorded */
+  PetscInt      current;                /* the receive returned by the last MatStashScatterGetMesg_Private() */
+  PetscInt      *loc;                   /* locations of the received entries in the matrix storage, computed by the matrix type */
+  PetscInt      locstate[2];            /* the state of the matrix storage loc was computed for, -1 if it is not computed */
+} MatStashPlan;
+
 typedef struct {
   PetscInt      nmax;                   /* maximum stash size */
   PetscInt      umax;                   /* user specified max-size */
@@ -266,6 +288,8 @@ typedef struct {
   PetscMPIInt   *flg_v;                 /* indicates what messages have arrived so far and from whom */
   PetscBool     reproduce;
   PetscInt      reproduce_count;
+  PetscBool     coalesce;               /* combine the entries with the same (row,col) before sending them */
+  MatStashPlan  *plan;                  /* communication plan reused with MAT_SAME_OFF_PROC_ENTRIES */
 } MatStash;
 
 PETSC_EXTERN PetscErrorCode MatStashCreate_Private(MPI_Comm,PetscInt,MatStash*);
@@ -279,6 +303,7 @@ PETSC_EXTERN PetscErrorCode MatStashValuesRowBlocked_Private(MatStash*,PetscInt,
 PETSC_EXTERN PetscErrorCode MatStashValuesColBlocked_Private(MatStash*,PetscInt,PetscInt,const PetscInt[],const PetscScalar[],PetscInt,PetscInt,PetscInt);
 PETSC_EXTERN PetscErrorCode MatStashScatterBegin_Private(Mat,MatStash*,PetscInt*);
 PETSC_EXTERN PetscErrorCode MatStashScatterGetMesg_Private(MatStash*,PetscMPIInt*,PetscInt**,PetscInt**,PetscScalar**,PetscInt*);
+PETSC_EXTERN PetscErrorCode MatStashPlanGetMesgLocations_Private(MatStash*,PetscInt**,PetscInt**);
 
 typedef struct {
   PetscInt   dim;
@@ -317,6 +342,8 @@ struct _p_Mat {
   PetscBool              symmetric_set,hermitian_set,structurally_symmetric_set,spd_set; /* if true, then corresponding flag is correct*/
   PetscBool              symmetric_eternal;
   PetscBool              nooffprocentries,nooffproczerorows;
+  PetscBool              concurrentadd;    /* MatSetValues() may be called by several threads at once, see MAT_CONCURRENT_ADD_VALUES */
+  PetscBool              sameoffprocentries; /* the off-process entries are the same in every assembly, see MAT_SAME_OFF_PROC_ENTRIES */
 #if defined(PETSC_HAVE_CUSP)
   PetscCUSPFlag          valid_GPU_matrix; /* flag pointing to the matrix on the gpu*/
 #endif
@@ -494,6 +521,39 @@ struct _p_MatNullSpace {
   void*          rmctx;                 /* context for remove() function */
 };
 
+/*
+   Atomic addition of a matrix entry, used by the MAT_CONCURRENT_ADD_VALUES assembly path.
+   The value is updated with a compare-and-swap loop on its bit pattern; complex entries
+   are updated one part at a time.
+*/
+#if defined(__GNUC__) && (defined(PETSC_USE_REAL_SINGLE) || defined(PETSC_USE_REAL_DOUBLE))
+#define PETSC_USE_MAT_ATOMIC_ADD 1
+PETSC_STATIC_INLINE void MatAtomicAddReal_Private(MatReal *a,MatReal v)
+{
+#if defined(PETSC_USE_REAL_SINGLE)
+  union {MatReal r; unsigned int u;} cur,upd;
+  volatile unsigned int *p = (volatile unsigned int*)a;
+#else
+  union {MatReal r; unsigned long long u;} cur,upd;
+  volatile unsigned long long *p = (volatile unsigned long long*)a;
+#endif
+  do {
+    cur.u = *p;
+    upd.r = cur.r + v;
+  } while (!__sync_bool_compare_and_swap(p,cur.u,upd.u));
+}
+
+PETSC_STATIC_INLINE void MatAtomicAdd_Private(MatScalar *a,MatScalar v)
+{
+#if defined(PETSC_USE_COMPLEX)
+  MatAtomicAddReal_Private((MatReal*)a,PetscRealPart(v));
+  MatAtomicAddReal_Private((MatReal*)a+1,PetscImaginaryPart(v));
+#else
+  MatAtomicAddReal_Private(a,v);
+#endif
+}
+#endif
+
 /*
    Checking zero pivot for LU, ILU preconditioners.
 */
@@ -102,6 +102,7 @@ struct _PetscThreadCommOps {
   PetscErrorCode (*view)(PetscThreadComm,PetscViewer);
   PetscErrorCode (*barrier)(PetscThreadComm);
   PetscErrorCode (*getrank)(PetscInt*);
+  PetscErrorCode (*runtasks)(MPI_Comm,PetscInt,const PetscInt[],PetscThreadTaskKernel,void*);
 };
 
 struct _p_PetscThreadComm{
@@ -285,6 +285,8 @@ struct _VecOps {
   PetscErrorCode (*dotnorm2)(Vec,Vec,PetscScalar*,PetscScalar*);
   PetscErrorCode (*getsubvector)(Vec,IS,Vec*);
   PetscErrorCode (*restoresubvector)(Vec,IS,Vec*);
+  PetscErrorCode (*multiaxpbydot)(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar*); /* w[j] = alpha[j] x[j] + beta[j] w[j], then z[k] = dx[k] dot dy[k] */
+  PetscErrorCode (*multiaxpbydot_local)(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar*);
 };
 
 /*
@@ -319,6 +321,7 @@ typedef struct {
   PetscBool     ignorenegidx;           /* ignore negative indices passed into VecSetValues/VetGetValues */
   InsertMode    insertmode;
   PetscInt      *bowners;
+  PetscBool     coalesce;               /* combine the entries with the same row before sending them */
 } VecStash;
 
 #if defined(PETSC_HAVE_CUSP)
@@ -350,12 +353,14 @@ struct _p_Vec {
 #endif
 };
 
+PETSC_EXTERN PetscErrorCode VecMultiAXPBYDotCheck_Private(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar[]);
+
 PETSC_EXTERN PetscLogEvent VEC_View, VEC_Max, VEC_Min, VEC_DotBarrier, VEC_Dot, VEC_MDotBarrier, VEC_MDot, VEC_TDot, VEC_MTDot;
 PETSC_EXTERN PetscLogEvent VEC_Norm, VEC_Normalize, VEC_Scale, VEC_Copy, VEC_Set, VEC_AXPY, VEC_AYPX, VEC_WAXPY, VEC_MAXPY;
 PETSC_EXTERN PetscLogEvent VEC_AssemblyEnd, VEC_PointwiseMult, VEC_SetValues, VEC_Load, VEC_ScatterBarrier, VEC_ScatterBegin, VEC_ScatterEnd;
 PETSC_EXTERN PetscLogEvent VEC_SetRandom, VEC_ReduceArithmetic, VEC_ReduceBarrier, VEC_ReduceCommunication;
 PETSC_EXTERN PetscLogEvent VEC_ReduceBegin,VEC_ReduceEnd;
-PETSC_EXTERN PetscLogEvent VEC_Swap, VEC_AssemblyBegin, VEC_NormBarrier, VEC_DotNormBarrier, VEC_DotNorm, VEC_AXPBYPCZ, VEC_Ops;
+PETSC_EXTERN PetscLogEvent VEC_Swap, VEC_AssemblyBegin, VEC_NormBarrier, VEC_DotNormBarrier, VEC_DotNorm, VEC_AXPBYPCZ, VEC_MultiAXPBYDot, VEC_Ops;
 PETSC_EXTERN PetscLogEvent VEC_CUSPCopyToGPU, VEC_CUSPCopyFromGPU;
 PETSC_EXTERN PetscLogEvent VEC_CUSPCopyToGPUSome, VEC_CUSPCopyFromGPUSome;
 
@@ -534,6 +539,16 @@ typedef struct {
   MPI_Win                window;
   PetscInt               *winstarts;    /* displacements in the processes I am putting to */
 #endif
+  /* for packing and unpacking with the threads of the communicator's thread pool */
+  PetscBool              use_threads;
+  PetscBool              threads_send;  /* each thread starts the sends of the messages it packed, needs MPI_THREAD_MULTIPLE */
+  PetscInt               nthreads;
+  PetscInt               *tpackstarts;  /* entries packed by each thread */
+  PetscInt               *tmsgstarts;   /* messages sent by each thread when threads_send is set */
+  PetscInt               *tunpackstarts,*tunpackslots; /* tunpackslots[tunpackstarts[i*nthreads+t]:tunpackstarts[i*nthreads+t+1]] are the
+                                                           entries of message i that land in the part of the vector owned by thread t */
+  PetscMPIInt            *tarrived;     /* received messages, in the order they arrived */
+  PetscInt               *tbatch;       /* number of messages in each batch returned by MPI_Waitsome() */
 } VecScatter_MPI_General;
 
 struct _p_VecScatter {
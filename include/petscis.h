@@ -166,9 +166,9 @@ PETSC_EXTERN PetscClassId IS_LTOGM_CLASSID;
 
    Level: intermediate
 
-   Note: mapping from Local to Global is scalable; but Global
-  to Local may not be if the range of global values represented locally
-  is very large.
+   Note: mapping from Local to Global is scalable; Global to Local uses an array
+  covering the range of global values represented locally, or a hash table when
+  that range is large compared to the number of local values, see ISGlobalToLocalMappingSetUseHash().
 
    Note: the ISLocalToGlobalMapping is actually a private object; it is included
   here for the inline function ISLocalToGlobalMappingApply() to allow it to be inlined since
@@ -183,6 +183,9 @@ struct _p_ISLocalToGlobalMapping{
   PetscInt globalstart;        /* first global referenced in indices */
   PetscInt globalend;          /* last + 1 global referenced in indices */
   PetscInt *globals;           /* local index for each global index between start and end */
+  void     *globalht;          /* hash table from global to local index, used instead of globals for sparse ranges */
+  PetscBool globalhash;        /* use the hash table, see ISGlobalToLocalMappingSetUseHash() */
+  PetscBool globalhashset;     /* globalhash was set by the user, otherwise it is chosen from the range */
 };
 typedef struct _p_ISLocalToGlobalMapping* ISLocalToGlobalMapping;
 
@@ -206,6 +209,7 @@ PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingView(ISLocalToGlobalMapping,Pe
 PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingDestroy(ISLocalToGlobalMapping*);
 PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingApplyIS(ISLocalToGlobalMapping,IS,IS*);
 PETSC_EXTERN PetscErrorCode ISGlobalToLocalMappingApply(ISLocalToGlobalMapping,ISGlobalToLocalMappingType,PetscInt,const PetscInt[],PetscInt*,PetscInt[]);
+PETSC_EXTERN PetscErrorCode ISGlobalToLocalMappingSetUseHash(ISLocalToGlobalMapping,PetscBool);
 PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingGetSize(ISLocalToGlobalMapping,PetscInt*);
 PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingGetInfo(ISLocalToGlobalMapping,PetscInt*,PetscInt*[],PetscInt*[],PetscInt**[]);
 PETSC_EXTERN PetscErrorCode ISLocalToGlobalMappingRestoreInfo(ISLocalToGlobalMapping,PetscInt*,PetscInt*[],PetscInt*[],PetscInt**[]);
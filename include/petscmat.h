@@ -39,6 +39,12 @@ typedef const char* MatType;
 #define MATAIJCRL          "aijcrl"
 #define MATSEQAIJCRL       "seqaijcrl"
 #define MATMPIAIJCRL       "mpiaijcrl"
+#define MATSELL            "sell"
+#define MATSEQSELL         "seqsell"
+#define MATMPISELL         "mpisell"
+#define MATAIJDELTA        "aijdelta"
+#define MATSEQAIJDELTA     "seqaijdelta"
+#define MATMPIAIJDELTA     "mpiaijdelta"
 #define MATAIJCUSP         "aijcusp"
 #define MATSEQAIJCUSP      "seqaijcusp"
 #define MATMPIAIJCUSP      "mpiaijcusp"
@@ -269,6 +275,10 @@ PETSC_EXTERN PetscErrorCode MatCreateLRC(Mat,Mat,Mat,Mat*);
 PETSC_EXTERN PetscErrorCode MatCreateIS(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt,PetscInt,ISLocalToGlobalMapping,Mat*);
 PETSC_EXTERN PetscErrorCode MatCreateSeqAIJCRL(MPI_Comm,PetscInt,PetscInt,PetscInt,const PetscInt[],Mat*);
 PETSC_EXTERN PetscErrorCode MatCreateMPIAIJCRL(MPI_Comm,PetscInt,PetscInt,PetscInt,const PetscInt[],PetscInt,const PetscInt[],Mat*);
+PETSC_EXTERN PetscErrorCode MatCreateSeqSELL(MPI_Comm,PetscInt,PetscInt,PetscInt,const PetscInt[],Mat*);
+PETSC_EXTERN PetscErrorCode MatCreateSELL(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt,PetscInt,const PetscInt[],PetscInt,const PetscInt[],Mat*);
+PETSC_EXTERN PetscErrorCode MatCreateSeqAIJDelta(MPI_Comm,PetscInt,PetscInt,PetscInt,const PetscInt[],Mat*);
+PETSC_EXTERN PetscErrorCode MatCreateAIJDelta(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt,PetscInt,const PetscInt[],PetscInt,const PetscInt[],Mat*);
 
 PETSC_EXTERN PetscErrorCode MatCreateSeqBSTRM(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt,const PetscInt[],Mat*);
 PETSC_EXTERN PetscErrorCode MatCreateMPIBSTRM(MPI_Comm,PetscInt,PetscInt,PetscInt,PetscInt,PetscInt,PetscInt,const PetscInt[],PetscInt,const PetscInt[],Mat*);
@@ -385,7 +395,9 @@ typedef enum {MAT_OPTION_MIN = -8,
               MAT_ERROR_LOWER_TRIANGULAR = 13,
               MAT_GETROW_UPPERTRIANGULAR = 14,
               MAT_SPD = 15,
-              MAT_OPTION_MAX = 16} MatOption;
+              MAT_CONCURRENT_ADD_VALUES = 16,
+              MAT_SAME_OFF_PROC_ENTRIES = 17,
+              MAT_OPTION_MAX = 18} MatOption;
 
 PETSC_EXTERN const char *MatOptions[];
 PETSC_EXTERN PetscErrorCode MatSetOption(Mat,MatOption,PetscBool );
@@ -950,6 +962,7 @@ PETSC_EXTERN PetscErrorCode MatDenseGetLocalMatrix(Mat,Mat*);
 
 PETSC_EXTERN PetscErrorCode MatStoreValues(Mat);
 PETSC_EXTERN PetscErrorCode MatRetrieveValues(Mat);
+PETSC_EXTERN PetscErrorCode MatStoreSinglePrecision(Mat,PetscBool);
 
 PETSC_EXTERN PetscErrorCode MatDAADSetCtx(Mat,void*);
 
@@ -1397,6 +1410,7 @@ J*/
 typedef const char* MatCoarsenType;
 #define MATCOARSENMIS  "mis"
 #define MATCOARSENHEM  "hem"
+#define MATCOARSENLUBY "luby"
 
 /* linked list for aggregates */
 typedef struct _PetscCDIntNd{
@@ -1648,9 +1662,12 @@ PETSC_EXTERN PetscErrorCode MatShellSetContext(Mat,void*);
    PetscViewerSetFormat(viewer,PETSC_VIEWER_NATIVE); the matrices will
    be stored in a way natural for the matrix, for example dense matrices
    would be stored as dense. Matrices stored this way may only be
-   read into matrices of the same type.
+   read into matrices of the same type. AIJ matrices viewed with
+   PetscViewerBinarySetPartitioned() are stored in blocks of rows
+   with an index, so each process loads only its own rows.
 */
 #define MATRIX_BINARY_FORMAT_DENSE -1
+#define MATRIX_BINARY_FORMAT_PARTITIONED -2
 
 PETSC_EXTERN PetscErrorCode MatMPIBAIJSetHashTableFactor(Mat,PetscReal);
 PETSC_EXTERN PetscErrorCode MatISGetLocalMat(Mat,Mat*);
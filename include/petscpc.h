@@ -219,6 +219,7 @@ PETSC_EXTERN PetscErrorCode PCSetDiagonalScale(PC,Vec);
 PETSC_EXTERN PetscErrorCode PCJacobiSetUseRowMax(PC);
 PETSC_EXTERN PetscErrorCode PCJacobiSetUseRowSum(PC);
 PETSC_EXTERN PetscErrorCode PCJacobiSetUseAbs(PC);
+PETSC_EXTERN PetscErrorCode PCPBJacobiSetBlockSizes(PC,PetscInt,const PetscInt[]);
 PETSC_EXTERN PetscErrorCode PCSORSetSymmetric(PC,MatSORType);
 PETSC_EXTERN PetscErrorCode PCSORSetOmega(PC,PetscReal);
 PETSC_EXTERN PetscErrorCode PCSORSetIterations(PC,PetscInt,PetscInt);
@@ -486,6 +487,7 @@ PETSC_EXTERN PetscErrorCode PCGAMGSetNSmooths(PC pc, PetscInt n);
 PETSC_EXTERN PetscErrorCode PCGAMGSetSymGraph(PC pc, PetscBool n);
 PETSC_EXTERN PetscErrorCode PCGAMGSetSquareGraph(PC,PetscBool);
 PETSC_EXTERN PetscErrorCode PCGAMGSetReuseProl(PC,PetscBool);
+PETSC_EXTERN PetscErrorCode PCGAMGSetRefreshEigenEstimates(PC,PetscBool);
 
 #if defined(PETSC_HAVE_PCBDDC)
 /* Enum defining how to treat the coarse problem */
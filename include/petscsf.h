@@ -29,8 +29,9 @@ typedef struct _p_PetscSF* PetscSF;
 .seealso: PetscSFSetType(), PetscSF
 J*/
 typedef const char *PetscSFType;
-#define PETSCSFWINDOW "window"
-#define PETSCSFBASIC  "basic"
+#define PETSCSFWINDOW   "window"
+#define PETSCSFBASIC    "basic"
+#define PETSCSFNEIGHBOR "neighbor"
 
 /*S
    PetscSFNode - specifier of owner and index
@@ -6,6 +6,9 @@
 /* Function pointer cast for the kernel function */
 PETSC_EXTERN_TYPEDEF typedef PetscErrorCode (*PetscThreadKernel)(PetscInt,...);
 
+/* Function pointer for the task kernel: thread rank, start and end of the task, user context */
+PETSC_EXTERN_TYPEDEF typedef PetscErrorCode (*PetscThreadTaskKernel)(PetscInt,PetscInt,PetscInt,void*);
+
 /*
   PetscThreadComm - Abstract object that manages all thread communication models
 
@@ -54,6 +57,7 @@ PETSC_EXTERN PetscErrorCode PetscThreadCommRunKernel2(MPI_Comm,PetscErrorCode (*
 PETSC_EXTERN PetscErrorCode PetscThreadCommRunKernel3(MPI_Comm,PetscErrorCode (*)(PetscInt,...),void*,void*,void*);
 PETSC_EXTERN PetscErrorCode PetscThreadCommRunKernel4(MPI_Comm,PetscErrorCode (*)(PetscInt,...),void*,void*,void*,void*);
 PETSC_EXTERN PetscErrorCode PetscThreadCommRunKernel6(MPI_Comm,PetscErrorCode (*)(PetscInt,...),void*,void*,void*,void*,void*,void*);
+PETSC_EXTERN PetscErrorCode PetscThreadCommRunTasks(MPI_Comm,PetscInt,const PetscInt[],PetscThreadTaskKernel,void*);
 PETSC_EXTERN PetscErrorCode PetscThreadCommBarrier(MPI_Comm);
 PETSC_EXTERN PetscErrorCode PetscThreadCommGetOwnershipRanges(MPI_Comm,PetscInt,PetscInt*[]);
 PETSC_EXTERN PetscErrorCode PetscThreadCommRegisterDestroy(void);
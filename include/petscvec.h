@@ -137,6 +137,7 @@ PETSC_EXTERN PetscErrorCode VecGetOptionsPrefix(Vec,const char*[]);
 PETSC_EXTERN PetscErrorCode VecSetSizes(Vec,PetscInt,PetscInt);
 
 PETSC_EXTERN PetscErrorCode VecDotNorm2(Vec,Vec,PetscScalar*,PetscReal*);
+PETSC_EXTERN PetscErrorCode VecMultiAXPBYDot(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar[]);
 PETSC_EXTERN PetscErrorCode VecDot(Vec,Vec,PetscScalar*);
 PETSC_EXTERN PetscErrorCode VecDotRealPart(Vec,Vec,PetscReal*);
 PETSC_EXTERN PetscErrorCode VecTDot(Vec,Vec,PetscScalar*);
@@ -449,6 +450,7 @@ PETSC_EXTERN PetscErrorCode VecMDotBegin(Vec,PetscInt,const Vec[],PetscScalar[])
 PETSC_EXTERN PetscErrorCode VecMDotEnd(Vec,PetscInt,const Vec[],PetscScalar[]);
 PETSC_EXTERN PetscErrorCode VecMTDotBegin(Vec,PetscInt,const Vec[],PetscScalar[]);
 PETSC_EXTERN PetscErrorCode VecMTDotEnd(Vec,PetscInt,const Vec[],PetscScalar[]);
+PETSC_EXTERN PetscErrorCode VecMultiAXPBYDotBegin(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar[]);
 PETSC_EXTERN PetscErrorCode PetscCommSplitReductionBegin(MPI_Comm);
 
 
@@ -210,6 +210,15 @@ PETSC_EXTERN PetscErrorCode PetscViewerBinaryGetDescriptor(PetscViewer,int*);
 PETSC_EXTERN PetscErrorCode PetscViewerBinaryGetInfoPointer(PetscViewer,FILE **);
 PETSC_EXTERN PetscErrorCode PetscViewerBinaryRead(PetscViewer,void*,PetscInt,PetscDataType);
 PETSC_EXTERN PetscErrorCode PetscViewerBinaryWrite(PetscViewer,void*,PetscInt,PetscDataType,PetscBool );
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryWriteAsync(PetscViewer,const void*,PetscInt,PetscDataType);
+PETSC_EXTERN PetscErrorCode PetscViewerBinarySetAsync(PetscViewer,PetscBool);
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryGetAsync(PetscViewer,PetscBool*);
+PETSC_EXTERN PetscErrorCode PetscViewerBinarySetMmap(PetscViewer,PetscBool);
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryGetMmap(PetscViewer,PetscBool*);
+PETSC_EXTERN PetscErrorCode PetscViewerBinarySetPartitioned(PetscViewer,PetscBool);
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryGetPartitioned(PetscViewer,PetscBool*);
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryReadMapped(PetscViewer,PetscInt,PetscDataType,void**,PetscObject*);
+PETSC_EXTERN PetscErrorCode PetscViewerBinaryWait(PetscViewer);
 PETSC_EXTERN PetscErrorCode PetscViewerStringSPrintf(PetscViewer,const char[],...);
 PETSC_EXTERN PetscErrorCode PetscViewerStringSetString(PetscViewer,char[],PetscInt);
 PETSC_EXTERN PetscErrorCode PetscViewerDrawClear(PetscViewer);
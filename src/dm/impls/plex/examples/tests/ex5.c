@@ -0,0 +1,237 @@
+static char help[] = "Tests the sum factorized Q_k operators on quadrilaterals, DMPlexCreateTensorJacobianAction()\n\n";
+
+#include <petscdmplex.h>
+#include <petscksp.h>
+
+#define MAX_COMP 3
+
+typedef struct {
+  PetscInt  cells[2];  /* The number of cells in each direction */
+  PetscInt  order;     /* The polynomial order k */
+  PetscInt  numComp;   /* The number of components of the field */
+  PetscBool perturb;   /* Move the interior vertices, so that the cells are not affine */
+} AppCtx;
+
+static PetscInt numComponents = 1;
+
+PetscScalar quintic(const PetscReal x[]) {
+  return x[0]*x[0]*x[0]*x[1]*x[1];
+}
+
+void f0_projection(const PetscScalar u[], const PetscScalar gradU[], const PetscReal x[], PetscScalar f0[]) {
+  PetscInt c;
+
+  for (c = 0; c < numComponents; ++c) f0[c] = u[c] - quintic(x);
+}
+
+void g0_mass(const PetscScalar u[], const PetscScalar gradU[], const PetscReal x[], PetscScalar g0[]) {
+  PetscInt c;
+
+  for (c = 0; c < numComponents; ++c) g0[c*numComponents+c] = 1.0;
+}
+
+void g3_laplacian(const PetscScalar u[], const PetscScalar gradU[], const PetscReal x[], PetscScalar g3[]) {
+  PetscInt c, d;
+
+  for (c = 0; c < numComponents; ++c) {
+    for (d = 0; d < 2; ++d) g3[((c*numComponents+c)*2+d)*2+d] = 1.0;
+  }
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "ProcessOptions"
+PetscErrorCode ProcessOptions(MPI_Comm comm, AppCtx *options)
+{
+  PetscInt       n = 2;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  options->cells[0] = 3;
+  options->cells[1] = 3;
+  options->order    = 3;
+  options->numComp  = 1;
+  options->perturb  = PETSC_FALSE;
+
+  ierr = PetscOptionsBegin(comm, "", "Sum Factorization Test Options", "DMPLEX");CHKERRQ(ierr);
+  ierr = PetscOptionsIntArray("-cells", "The number of cells in each direction", "ex5.c", options->cells, &n, PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-order", "The polynomial order", "ex5.c", options->order, &options->order, PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-num_comp", "The number of components", "ex5.c", options->numComp, &options->numComp, PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-perturb", "Move the interior vertices", "ex5.c", options->perturb, &options->perturb, PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();
+  if (options->numComp < 1 || options->numComp > MAX_COMP) SETERRQ1(comm, PETSC_ERR_ARG_OUTOFRANGE, "The number of components %D must be in [1, 3]", options->numComp);
+  numComponents = options->numComp;
+  PetscFunctionReturn(0);
+};
+
+#undef __FUNCT__
+#define __FUNCT__ "CreateMesh"
+PetscErrorCode CreateMesh(MPI_Comm comm, AppCtx *user, DM *dm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = DMPlexCreateHexBoxMesh(comm, 2, user->cells, dm);CHKERRQ(ierr);
+  if (user->perturb) {
+    PetscSection cSection;
+    Vec          coordinates;
+    PetscScalar *coords;
+    PetscInt     vStart, vEnd, v, off;
+
+    ierr = DMPlexGetDepthStratum(*dm, 0, &vStart, &vEnd);CHKERRQ(ierr);
+    ierr = DMPlexGetCoordinateSection(*dm, &cSection);CHKERRQ(ierr);
+    ierr = DMGetCoordinatesLocal(*dm, &coordinates);CHKERRQ(ierr);
+    ierr = VecGetArray(coordinates, &coords);CHKERRQ(ierr);
+    for (v = vStart; v < vEnd; ++v) {
+      PetscReal *x;
+
+      ierr = PetscSectionGetOffset(cSection, v, &off);CHKERRQ(ierr);
+      x    = (PetscReal *) &coords[off];
+      if (x[0] > 0.0 && x[0] < 1.0 && x[1] > 0.0 && x[1] < 1.0) {
+        x[0] += 0.2/user->cells[0]*PetscSinReal(7.0*v);
+        x[1] += 0.2/user->cells[1]*PetscCosReal(5.0*v);
+      }
+    }
+    ierr = VecRestoreArray(coordinates, &coords);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "SetupSection"
+PetscErrorCode SetupSection(DM dm, AppCtx *user)
+{
+  PetscSection   section;
+  PetscInt       numComp[1] = {user->numComp};
+  PetscInt       numDof[3];
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  numDof[0] = user->numComp;
+  numDof[1] = user->numComp*(user->order-1);
+  numDof[2] = user->numComp*(user->order-1)*(user->order-1);
+  ierr = DMPlexCreateSection(dm, 2, 1, numComp, numDof, 0, PETSC_NULL, PETSC_NULL, &section);CHKERRQ(ierr);
+  ierr = DMSetDefaultSection(dm, section);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckOperator"
+/* Compare the diagonal with that of the assembled operator, and check the symmetry */
+PetscErrorCode CheckOperator(Mat J, const char name[])
+{
+  Mat            E, Et;
+  Vec            d, e;
+  PetscReal      err, nrm;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatComputeExplicitOperator(J, &E);CHKERRQ(ierr);
+  ierr = MatGetVecs(J, &d, &e);CHKERRQ(ierr);
+  ierr = MatGetDiagonal(J, d);CHKERRQ(ierr);
+  ierr = MatGetDiagonal(E, e);CHKERRQ(ierr);
+  ierr = VecNorm(e, NORM_INFINITY, &nrm);CHKERRQ(ierr);
+  ierr = VecAXPY(e, -1.0, d);CHKERRQ(ierr);
+  ierr = VecNorm(e, NORM_INFINITY, &err);CHKERRQ(ierr);
+  if (err > 1.0e-10*nrm) {ierr = PetscPrintf(PETSC_COMM_WORLD, "%s: the diagonal differs by %G\n", name, err);CHKERRQ(ierr);}
+  ierr = MatNorm(E, NORM_FROBENIUS, &nrm);CHKERRQ(ierr);
+  ierr = MatTranspose(E, MAT_INITIAL_MATRIX, &Et);CHKERRQ(ierr);
+  ierr = MatAXPY(Et, -1.0, E, SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatNorm(Et, NORM_FROBENIUS, &err);CHKERRQ(ierr);
+  if (err > 1.0e-10*nrm) {ierr = PetscPrintf(PETSC_COMM_WORLD, "%s: the operator is not symmetric, %G\n", name, err);CHKERRQ(ierr);}
+  ierr = MatDestroy(&Et);CHKERRQ(ierr);
+  ierr = VecDestroy(&d);CHKERRQ(ierr);
+  ierr = VecDestroy(&e);CHKERRQ(ierr);
+  ierr = MatDestroy(&E);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc, char **argv)
+{
+  DM             dm;
+  AppCtx         user;
+  PetscFEM       mass, laplacian;
+  Mat            M, K;
+  KSP            ksp;
+  PC             pc;
+  Vec            one, u, b, r, localU, localR;
+  PetscScalar    dot;
+  PetscReal      nrm;
+  void         (*f0Funcs[1])(const PetscScalar[], const PetscScalar[], const PetscReal[], PetscScalar[]) = {f0_projection};
+  void         (*g0Funcs[1])(const PetscScalar[], const PetscScalar[], const PetscReal[], PetscScalar[]) = {g0_mass};
+  void         (*g3Funcs[1])(const PetscScalar[], const PetscScalar[], const PetscReal[], PetscScalar[]) = {g3_laplacian};
+  PetscErrorCode ierr;
+
+  ierr = PetscInitialize(&argc, &argv, PETSC_NULL, help);CHKERRQ(ierr);
+  ierr = ProcessOptions(PETSC_COMM_WORLD, &user);CHKERRQ(ierr);
+  ierr = CreateMesh(PETSC_COMM_WORLD, &user, &dm);CHKERRQ(ierr);
+  ierr = SetupSection(dm, &user);CHKERRQ(ierr);
+  ierr = PetscMemzero(&mass, sizeof(PetscFEM));CHKERRQ(ierr);
+  ierr = PetscMemzero(&laplacian, sizeof(PetscFEM));CHKERRQ(ierr);
+  mass.f0Funcs      = f0Funcs;
+  mass.g0Funcs      = g0Funcs;
+  laplacian.g3Funcs = g3Funcs;
+  ierr = DMPlexCreateTensorJacobianAction(dm, user.order, &mass, &M);CHKERRQ(ierr);
+  ierr = DMPlexCreateTensorJacobianAction(dm, user.order, &laplacian, &K);CHKERRQ(ierr);
+  ierr = CheckOperator(M, "Mass");CHKERRQ(ierr);
+  ierr = CheckOperator(K, "Laplacian");CHKERRQ(ierr);
+
+  /* The constants: 1^T M 1 is the area times the number of components, and K 1 = 0 */
+  ierr = MatGetVecs(M, &one, &r);CHKERRQ(ierr);
+  ierr = VecSet(one, 1.0);CHKERRQ(ierr);
+  ierr = MatMult(M, one, r);CHKERRQ(ierr);
+  ierr = VecDot(r, one, &dot);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD, "Area: %G\n", PetscRealPart(dot)/user.numComp);CHKERRQ(ierr);
+  ierr = MatMult(K, one, r);CHKERRQ(ierr);
+  ierr = VecNorm(r, NORM_2, &nrm);CHKERRQ(ierr);
+  if (nrm > 1.0e-10) {ierr = PetscPrintf(PETSC_COMM_WORLD, "The Laplacian of a constant is %G\n", nrm);CHKERRQ(ierr);}
+
+  /* The L_2 projection of x^3 y^2 from the residual, which is exact for k >= 3 */
+  ierr = VecDuplicate(one, &u);CHKERRQ(ierr);
+  ierr = VecDuplicate(one, &b);CHKERRQ(ierr);
+  ierr = DMGetLocalVector(dm, &localU);CHKERRQ(ierr);
+  ierr = DMGetLocalVector(dm, &localR);CHKERRQ(ierr);
+  ierr = VecSet(localU, 0.0);CHKERRQ(ierr);
+  ierr = DMPlexComputeTensorResidualFEM(dm, localU, localR, M);CHKERRQ(ierr);
+  ierr = VecSet(b, 0.0);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalBegin(dm, localR, ADD_VALUES, b);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalEnd(dm, localR, ADD_VALUES, b);CHKERRQ(ierr);
+  ierr = VecScale(b, -1.0);CHKERRQ(ierr);
+  ierr = KSPCreate(PETSC_COMM_WORLD, &ksp);CHKERRQ(ierr);
+  ierr = KSPSetOperators(ksp, M, M, SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = KSPSetType(ksp, KSPCG);CHKERRQ(ierr);
+  ierr = KSPGetPC(ksp, &pc);CHKERRQ(ierr);
+  ierr = PCSetType(pc, PCJACOBI);CHKERRQ(ierr);
+  ierr = KSPSetTolerances(ksp, 1.0e-12, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT);CHKERRQ(ierr);
+  ierr = KSPSetFromOptions(ksp);CHKERRQ(ierr);
+  ierr = KSPSolve(ksp, b, u);CHKERRQ(ierr);
+  /* The residual at the solution vanishes */
+  ierr = DMGlobalToLocalBegin(dm, u, INSERT_VALUES, localU);CHKERRQ(ierr);
+  ierr = DMGlobalToLocalEnd(dm, u, INSERT_VALUES, localU);CHKERRQ(ierr);
+  ierr = DMPlexComputeTensorResidualFEM(dm, localU, localR, M);CHKERRQ(ierr);
+  ierr = VecSet(r, 0.0);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalBegin(dm, localR, ADD_VALUES, r);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalEnd(dm, localR, ADD_VALUES, r);CHKERRQ(ierr);
+  ierr = VecNorm(r, NORM_2, &nrm);CHKERRQ(ierr);
+  if (nrm > 1.0e-10) {ierr = PetscPrintf(PETSC_COMM_WORLD, "The residual of the projection is %G\n", nrm);CHKERRQ(ierr);}
+  ierr = MatMult(M, u, r);CHKERRQ(ierr);
+  ierr = VecDot(r, one, &dot);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD, "Integral: %G\n", PetscRealPart(dot)/user.numComp);CHKERRQ(ierr);
+  ierr = MatMult(K, u, r);CHKERRQ(ierr);
+  ierr = VecDot(r, u, &dot);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD, "Energy: %G\n", PetscRealPart(dot)/user.numComp);CHKERRQ(ierr);
+
+  ierr = DMRestoreLocalVector(dm, &localU);CHKERRQ(ierr);
+  ierr = DMRestoreLocalVector(dm, &localR);CHKERRQ(ierr);
+  ierr = KSPDestroy(&ksp);CHKERRQ(ierr);
+  ierr = VecDestroy(&one);CHKERRQ(ierr);
+  ierr = VecDestroy(&u);CHKERRQ(ierr);
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = VecDestroy(&r);CHKERRQ(ierr);
+  ierr = MatDestroy(&M);CHKERRQ(ierr);
+  ierr = MatDestroy(&K);CHKERRQ(ierr);
+  ierr = DMDestroy(&dm);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
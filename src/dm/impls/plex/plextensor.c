@@ -0,0 +1,896 @@
+#include <petsc-private/pleximpl.h>   /*I      "petscdmplex.h"   I*/
+#include <petscdt.h>
+
+/*
+  Matrix-free FEM operators on tensor product cells (quadrilaterals and hexahedra)
+
+  The discretization is the Lagrange space Q_k on the Gauss-Lobatto-Legendre nodes, integrated with k+1 Gauss points
+  in each direction. Both the basis and the quadrature are tensor products of 1D objects, so the interpolation to the
+  quadrature points and the integration against the test functions are done one direction at a time (sum factorization).
+  This costs O(k^{d+1}) per cell instead of the O(k^{2d}) of a tabulated basis, and no element matrix is ever formed.
+
+  The dofs of a mesh point are numbered in a frame defined by the point itself (the cone of an edge, the first edge of
+  a face), so that all cells sharing the point agree on their order. Each cell keeps the local vector offset of every
+  node of its lattice, which replaces the closure traversal.
+*/
+
+typedef struct {
+  JacActionCtx  jac;          /* Must be first, DMPlexComputeJacobianFEM() copies the base state into jac.u */
+  PetscFEM     *fem;          /* The pointwise functions */
+  PetscInt      dim;          /* The topological dimension */
+  PetscInt      order;        /* The polynomial order k */
+  PetscInt      Nb;           /* The number of 1D nodes, k+1 */
+  PetscInt      Nq;           /* The number of 1D quadrature points */
+  PetscInt      NbD, NqD;     /* The number of nodes and quadrature points on a cell */
+  PetscReal    *B, *D;        /* The 1D basis and its derivative at the quadrature points, Nq x Nb */
+  PetscReal    *BB, *BD, *DD; /* Pointwise products of B and D, for the diagonal */
+  PetscReal    *w;            /* The 1D quadrature weights */
+  PetscInt      numFields;    /* The number of fields in the default section, at least 1 */
+  PetscInt     *numComp;      /* The number of components of each field */
+  PetscInt      totComp;      /* The total number of components */
+  PetscInt      numCells;     /* The number of cells */
+  PetscInt     *offsets;      /* The local offset of the first component of each node, for each cell and field */
+  PetscReal    *geom;         /* The coordinates, inverse Jacobian and weighted determinant at each quadrature point */
+  PetscScalar  *elemU, *elemA, *elemF;                /* Cell values of the base state, argument and result */
+  PetscScalar  *uq, *duq, *aq, *daq, *f0q, *f1q;      /* Values and reference gradients at the quadrature points */
+  PetscScalar  *t[2];         /* Work space for the contractions */
+  PetscScalar  *g;            /* Work space for the pointwise functions */
+} DMPlexTensorCtx;
+
+#define DMPlexTensorGeomSize(dim) ((dim) + (dim)*(dim) + 1)
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorGLLNodes_Private"
+/* The Gauss-Lobatto-Legendre nodes are the end points and the roots of P_k', found by Newton from the Chebyshev nodes */
+static PetscErrorCode DMPlexTensorGLLNodes_Private(PetscInt k, PetscReal z[])
+{
+  PetscInt      *degrees;
+  PetscReal     *D, *D2;
+  PetscInt       i, it;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc3(k+1,PetscInt,&degrees,k+1,PetscReal,&D,k+1,PetscReal,&D2);CHKERRQ(ierr);
+  for (i = 0; i <= k; ++i) degrees[i] = i;
+  z[0] = -1.0; z[k] = 1.0;
+  for (i = 1; i < k; ++i) {
+    PetscReal x = -PetscCosReal(PETSC_PI*i/k);
+
+    for (it = 0; it < 100; ++it) {
+      PetscReal dx;
+
+      ierr = PetscDTLegendreEval(1, &x, k+1, degrees, PETSC_NULL, D, D2);CHKERRQ(ierr);
+      dx = D[k]/D2[k];
+      x -= dx;
+      if (PetscAbsReal(dx) < 10*PETSC_MACHINE_EPSILON) break;
+    }
+    z[i] = x;
+  }
+  ierr = PetscFree3(degrees,D,D2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* The Lagrange basis on the nodes z[] and its derivative at x */
+static void DMPlexTensorLagrange_Private(PetscInt Nb, const PetscReal z[], PetscReal x, PetscReal B[], PetscReal D[])
+{
+  PetscInt i, j, m;
+
+  for (i = 0; i < Nb; ++i) {
+    B[i] = 1.0;
+    D[i] = 0.0;
+    for (j = 0; j < Nb; ++j) {
+      PetscReal prod = 1.0/(z[i] - z[j]);
+
+      if (j == i) continue;
+      B[i] *= (x - z[j])/(z[i] - z[j]);
+      for (m = 0; m < Nb; ++m) {
+        if (m != i && m != j) prod *= (x - z[m])/(z[i] - z[m]);
+      }
+      D[i] += prod;
+    }
+  }
+}
+
+/* Contract direction a of in[], with extents ext[] (direction 0 fastest), with the m x ext[a] matrix M or the transpose of the ext[a] x m matrix M */
+static void DMPlexTensorContract_Private(PetscInt dim, const PetscInt ext[], PetscInt a, PetscInt m, const PetscReal M[], PetscBool transpose, const PetscScalar in[], PetscScalar out[], PetscLogDouble *flops)
+{
+  PetscInt pre = 1, post = 1, n = ext[a], d, s, i, j, r;
+
+  for (d = 0; d < a; ++d)       pre  *= ext[d];
+  for (d = a+1; d < dim; ++d)   post *= ext[d];
+  for (s = 0; s < post; ++s) {
+    for (i = 0; i < m; ++i) {
+      PetscScalar *o = &out[(s*m+i)*pre];
+
+      for (r = 0; r < pre; ++r) o[r] = 0.0;
+      for (j = 0; j < n; ++j) {
+        const PetscReal    c = transpose ? M[j*m+i] : M[i*n+j];
+        const PetscScalar *v = &in[(s*n+j)*pre];
+
+        for (r = 0; r < pre; ++r) o[r] += c*v[r];
+      }
+    }
+  }
+  *flops += 2.0*pre*post*m*n;
+}
+
+/* out = (M[dim-1] x ... x M[0]) in from nodes to quadrature points, or its transpose from quadrature points to nodes; when add is set the result is added to out */
+static void DMPlexTensorApply_Private(DMPlexTensorCtx *ctx, const PetscReal *M[], PetscBool transpose, const PetscScalar in[], PetscScalar out[], PetscBool add, PetscLogDouble *flops)
+{
+  const PetscInt     dim  = ctx->dim;
+  const PetscInt     nout = transpose ? ctx->Nb  : ctx->Nq;
+  const PetscInt     size = transpose ? ctx->NbD : ctx->NqD;
+  PetscInt           ext[3], a, i;
+  const PetscScalar *src = in;
+  PetscScalar       *dst = PETSC_NULL;
+
+  for (a = 0; a < dim; ++a) ext[a] = transpose ? ctx->Nq : ctx->Nb;
+  for (a = 0; a < dim; ++a) {
+    dst = (a == dim-1 && !add) ? out : ctx->t[a%2];
+    DMPlexTensorContract_Private(dim, ext, a, nout, M[a], transpose, src, dst, flops);
+    ext[a] = nout;
+    src    = dst;
+  }
+  if (add) {
+    for (i = 0; i < size; ++i) out[i] += dst[i];
+    *flops += size;
+  }
+}
+
+/* Values and reference gradients at the quadrature points of the cell values v[], for each component */
+static void DMPlexTensorInterpolate_Private(DMPlexTensorCtx *ctx, const PetscScalar v[], PetscScalar vq[], PetscScalar dvq[], PetscLogDouble *flops)
+{
+  const PetscInt  dim = ctx->dim;
+  const PetscReal *M[3];
+  PetscInt        c, a, b;
+
+  for (c = 0; c < ctx->totComp; ++c) {
+    for (b = 0; b < dim; ++b) M[b] = ctx->B;
+    DMPlexTensorApply_Private(ctx, M, PETSC_FALSE, &v[c*ctx->NbD], &vq[c*ctx->NqD], PETSC_FALSE, flops);
+    for (a = 0; a < dim; ++a) {
+      for (b = 0; b < dim; ++b) M[b] = (b == a) ? ctx->D : ctx->B;
+      DMPlexTensorApply_Private(ctx, M, PETSC_FALSE, &v[c*ctx->NbD], &dvq[(c*dim+a)*ctx->NqD], PETSC_FALSE, flops);
+    }
+  }
+}
+
+/* Integrate f0q[] against the test functions and the reference f1q[] against their reference gradients, for each component */
+static void DMPlexTensorIntegrate_Private(DMPlexTensorCtx *ctx, const PetscScalar f0q[], const PetscScalar f1q[], PetscScalar f[], PetscLogDouble *flops)
+{
+  const PetscInt  dim = ctx->dim;
+  const PetscReal *M[3];
+  PetscInt        c, a, b;
+
+  for (c = 0; c < ctx->totComp; ++c) {
+    for (b = 0; b < dim; ++b) M[b] = ctx->B;
+    DMPlexTensorApply_Private(ctx, M, PETSC_TRUE, &f0q[c*ctx->NqD], &f[c*ctx->NbD], PETSC_FALSE, flops);
+    for (a = 0; a < dim; ++a) {
+      for (b = 0; b < dim; ++b) M[b] = (b == a) ? ctx->D : ctx->B;
+      DMPlexTensorApply_Private(ctx, M, PETSC_TRUE, &f1q[(c*dim+a)*ctx->NqD], &f[c*ctx->NbD], PETSC_TRUE, flops);
+    }
+  }
+}
+
+/* The values and physical gradients of all components at quadrature point q */
+static void DMPlexTensorPointValues_Private(DMPlexTensorCtx *ctx, PetscInt q, const PetscReal invJ[], const PetscScalar vq[], const PetscScalar dvq[], PetscScalar v[], PetscScalar gradV[])
+{
+  const PetscInt dim = ctx->dim;
+  PetscInt       c, a, d;
+
+  for (c = 0; c < ctx->totComp; ++c) {
+    v[c] = vq[c*ctx->NqD+q];
+    for (d = 0; d < dim; ++d) {
+      gradV[c*dim+d] = 0.0;
+      for (a = 0; a < dim; ++a) gradV[c*dim+d] += invJ[a*dim+d]*dvq[(c*dim+a)*ctx->NqD+q];
+    }
+  }
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorGatherCell_Private"
+static PetscErrorCode DMPlexTensorGatherCell_Private(DMPlexTensorCtx *ctx, PetscInt cell, const PetscScalar x[], PetscScalar v[])
+{
+  PetscInt f, c, cOff, n;
+
+  PetscFunctionBegin;
+  for (f = 0, cOff = 0; f < ctx->numFields; cOff += ctx->numComp[f], ++f) {
+    const PetscInt *off = &ctx->offsets[(cell*ctx->numFields+f)*ctx->NbD];
+
+    for (c = 0; c < ctx->numComp[f]; ++c) {
+      for (n = 0; n < ctx->NbD; ++n) v[(cOff+c)*ctx->NbD+n] = x[off[n]+c];
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorScatterCell_Private"
+static PetscErrorCode DMPlexTensorScatterCell_Private(DMPlexTensorCtx *ctx, PetscInt cell, const PetscScalar v[], PetscScalar y[])
+{
+  PetscInt f, c, cOff, n;
+
+  PetscFunctionBegin;
+  for (f = 0, cOff = 0; f < ctx->numFields; cOff += ctx->numComp[f], ++f) {
+    const PetscInt *off = &ctx->offsets[(cell*ctx->numFields+f)*ctx->NbD];
+
+    for (c = 0; c < ctx->numComp[f]; ++c) {
+      for (n = 0; n < ctx->NbD; ++n) y[off[n]+c] += v[(cOff+c)*ctx->NbD+n];
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorSetUpCell_Private"
+/*
+  Label the vertices of the cell with the corners of the reference cell, using only its edges: the first vertex of the
+  closure is the origin, its neighbors along the edges of the closure give the directions, and a vertex lies on the far
+  side of direction a when it is closer to that neighbor than to the origin. Then the lattice nodes of each point of the
+  closure are numbered in the frame of that point, and the geometry is evaluated at the quadrature points.
+*/
+static PetscErrorCode DMPlexTensorSetUpCell_Private(DM dm, DMPlexTensorCtx *ctx, PetscInt cell, const PetscInt depthStart[], const PetscInt depthEnd[], PetscSection section, PetscSection cSection, const PetscScalar coords[], const PetscReal xq[])
+{
+  const PetscInt  dim = ctx->dim, k = ctx->order, Nb = ctx->Nb, nc = 1 << dim;
+  PetscInt       *closure = PETSC_NULL, *pclosure = PETSC_NULL;
+  PetscInt        numPoints, numPPoints, verts[8], edges[12][2], corner[8], dist[4][8], nbr[3];
+  PetscInt        nv = 0, ne = 0, nn = 0, used = 0, p, i, j, a, d, it, f;
+  PetscReal       X[8][3];
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  ierr = DMPlexGetTransitiveClosure(dm, cell, PETSC_TRUE, &numPoints, &closure);CHKERRQ(ierr);
+  for (p = 0; p < numPoints; ++p) {
+    const PetscInt point = closure[p*2];
+
+    if (point >= depthStart[0] && point < depthEnd[0]) {
+      if (nv == nc) SETERRQ2(PETSC_COMM_SELF, PETSC_ERR_SUP, "Cell %D has more than %D vertices, it is not a tensor product cell", cell, nc);
+      verts[nv++] = point;
+    }
+  }
+  if (nv != nc) SETERRQ3(PETSC_COMM_SELF, PETSC_ERR_SUP, "Cell %D has %D vertices instead of %D, it is not a tensor product cell", cell, nv, nc);
+  for (p = 0; p < numPoints; ++p) {
+    const PetscInt  point = closure[p*2];
+    const PetscInt *cone;
+
+    if (point < depthStart[1] || point >= depthEnd[1]) continue;
+    if (ne == 12) SETERRQ1(PETSC_COMM_SELF, PETSC_ERR_SUP, "Cell %D has too many edges, it is not a tensor product cell", cell);
+    ierr = DMPlexGetCone(dm, point, &cone);CHKERRQ(ierr);
+    for (j = 0; j < 2; ++j) {
+      for (i = 0; i < nv; ++i) if (verts[i] == cone[j]) break;
+      edges[ne][j] = i;
+    }
+    if (edges[ne][0] == nv || edges[ne][1] == nv) SETERRQ2(PETSC_COMM_SELF, PETSC_ERR_PLIB, "Edge %D is not in the closure of cell %D", point, cell);
+    if (edges[ne][0] == 0) nbr[nn++ % 3] = edges[ne][1];
+    if (edges[ne][1] == 0) nbr[nn++ % 3] = edges[ne][0];
+    ++ne;
+  }
+  if (nn != dim) SETERRQ3(PETSC_COMM_SELF, PETSC_ERR_SUP, "Vertex %D of cell %D has %D neighbors, it is not a tensor product cell", verts[0], cell, nn);
+  /* Graph distances from the origin and from each of its neighbors */
+  for (d = 0; d <= dim; ++d) {
+    for (i = 0; i < nv; ++i) dist[d][i] = nv;
+    dist[d][d ? nbr[d-1] : 0] = 0;
+    for (it = 0; it < nv; ++it) {
+      for (j = 0; j < ne; ++j) {
+        dist[d][edges[j][0]] = PetscMin(dist[d][edges[j][0]], dist[d][edges[j][1]]+1);
+        dist[d][edges[j][1]] = PetscMin(dist[d][edges[j][1]], dist[d][edges[j][0]]+1);
+      }
+    }
+  }
+  for (i = 0; i < nv; ++i) {
+    PetscInt off, dof;
+
+    for (a = 0, corner[i] = 0; a < dim; ++a) {
+      if (dist[a+1][i] < dist[0][i]) corner[i] |= 1 << a;
+    }
+    if (used & (1 << corner[i])) SETERRQ1(PETSC_COMM_SELF, PETSC_ERR_SUP, "The edges of cell %D do not form a tensor product cell", cell);
+    used |= 1 << corner[i];
+    ierr = PetscSectionGetDof(cSection, verts[i], &dof);CHKERRQ(ierr);
+    ierr = PetscSectionGetOffset(cSection, verts[i], &off);CHKERRQ(ierr);
+    for (d = 0; d < dim; ++d) X[corner[i]][d] = d < dof ? PetscRealPart(coords[off+d]) : 0.0;
+  }
+
+  /* Number the nodes of each point of the closure */
+  for (p = 0; p < numPoints; ++p) {
+    const PetscInt point = closure[p*2];
+    PetscInt       depth, pcorners[8], npc = 0, fixed = nc-1, value = 0, frame[4], fc[4], nf = 0, nframe = 0;
+    PetscInt       L[3], node;
+
+    for (depth = 0; depth <= dim; ++depth) if (point >= depthStart[depth] && point < depthEnd[depth]) break;
+    if (depth > dim) continue;
+    /* The corners of the point */
+    ierr = DMPlexGetTransitiveClosure(dm, point, PETSC_TRUE, &numPPoints, &pclosure);CHKERRQ(ierr);
+    for (i = 0; i < numPPoints; ++i) {
+      for (j = 0; j < nv; ++j) if (verts[j] == pclosure[i*2]) pcorners[npc++] = corner[j];
+    }
+    ierr = DMPlexRestoreTransitiveClosure(dm, point, PETSC_TRUE, &numPPoints, &pclosure);CHKERRQ(ierr);
+    /* The reference directions along which the point extends */
+    for (i = 1; i < npc; ++i) fixed &= ~(pcorners[i] ^ pcorners[0]);
+    for (a = 0; a < dim; ++a) if (!(fixed & (1 << a))) ++nf;
+    if (nf != depth || npc != 1 << depth) SETERRQ2(PETSC_COMM_SELF, PETSC_ERR_SUP, "Point %D of cell %D is not a face of a tensor product cell", point, cell);
+    value = pcorners[0] & fixed;
+    /* The frame of the point: an origin corner and the corners along each of its directions */
+    if (depth == 0 || depth == dim) {
+      frame[0] = depth ? 0 : pcorners[0];
+      for (a = 0; a < dim; ++a) if (!(fixed & (1 << a))) frame[++nframe] = frame[0] | (1 << a);
+    } else {
+      const PetscInt *cone, *econe;
+      PetscInt        coneSize, e = point;
+
+      if (depth == 2) {
+        ierr = DMPlexGetCone(dm, point, &cone);CHKERRQ(ierr);
+        e    = cone[0];
+      }
+      ierr = DMPlexGetCone(dm, e, &econe);CHKERRQ(ierr);
+      for (i = 0; i < 2; ++i) {
+        for (j = 0; j < nv; ++j) if (verts[j] == econe[i]) fc[i] = corner[j];
+      }
+      frame[0] = fc[0]; frame[++nframe] = fc[1];
+      if (depth == 2) {
+        ierr = DMPlexGetConeSize(dm, point, &coneSize);CHKERRQ(ierr);
+        for (i = 1; i < coneSize; ++i) {
+          ierr = DMPlexGetCone(dm, cone[i], &econe);CHKERRQ(ierr);
+          for (j = 0; j < 2; ++j) {
+            PetscInt v;
+
+            for (v = 0; v < nv; ++v) if (verts[v] == econe[j]) fc[j] = corner[v];
+          }
+          if (fc[0] == frame[0] && fc[1] != frame[1]) {frame[++nframe] = fc[1]; break;}
+          if (fc[1] == frame[0] && fc[0] != frame[1]) {frame[++nframe] = fc[0]; break;}
+        }
+        if (nframe != 2) SETERRQ1(PETSC_COMM_SELF, PETSC_ERR_SUP, "Face %D is not a quadrilateral", point);
+      }
+    }
+    /* Visit the lattice nodes interior to the point */
+    for (node = 0; node < ctx->NbD; ++node) {
+      PetscInt rest = node, idx = 0, stride = 1, inside = 1;
+
+      for (a = 0; a < dim; ++a) {L[a] = rest % Nb; rest /= Nb;}
+      for (a = 0; a < dim; ++a) {
+        if (fixed & (1 << a)) {if (L[a] != ((value >> a) & 1)*k) inside = 0;}
+        else if (L[a] == 0 || L[a] == k) inside = 0;
+      }
+      if (!inside) continue;
+      for (i = 1; i <= nframe; ++i) {
+        const PetscInt dir = frame[i] ^ frame[0];
+        PetscInt       ax, t;
+
+        for (ax = 0; ax < dim; ++ax) if (dir == 1 << ax) break;
+        t       = (frame[0] & dir) ? k - L[ax] : L[ax];
+        idx    += (t-1)*stride;
+        stride *= k-1;
+      }
+      for (f = 0; f < ctx->numFields; ++f) {
+        PetscInt off, dof;
+
+        if (section->numFields) {
+          ierr = PetscSectionGetFieldDof(section, point, f, &dof);CHKERRQ(ierr);
+          ierr = PetscSectionGetFieldOffset(section, point, f, &off);CHKERRQ(ierr);
+        } else {
+          ierr = PetscSectionGetDof(section, point, &dof);CHKERRQ(ierr);
+          ierr = PetscSectionGetOffset(section, point, &off);CHKERRQ(ierr);
+        }
+        if (dof != ctx->numComp[f]*PetscPowInt(k-1, depth)) SETERRQ5(PETSC_COMM_SELF, PETSC_ERR_ARG_WRONG, "Point %D has %D dofs in field %D, but Q_%D needs %D", point, dof, f, k, ctx->numComp[f]*PetscPowInt(k-1, depth));
+        ctx->offsets[(cell*ctx->numFields+f)*ctx->NbD+node] = off + idx*ctx->numComp[f];
+      }
+    }
+  }
+  ierr = DMPlexRestoreTransitiveClosure(dm, cell, PETSC_TRUE, &numPoints, &closure);CHKERRQ(ierr);
+
+  /* The multilinear map from the reference cell at the quadrature points */
+  for (i = 0; i < ctx->NqD; ++i) {
+    PetscReal *geom = &ctx->geom[(cell*ctx->NqD+i)*DMPlexTensorGeomSize(dim)];
+    PetscReal *x = geom, *invJ = &geom[dim], J[9], xi[3], detJ = 0.0;
+    PetscInt   rest = i, c;
+
+    for (a = 0; a < dim; ++a) {xi[a] = xq[rest % ctx->Nq]; rest /= ctx->Nq;}
+    for (d = 0; d < dim; ++d) {
+      x[d] = 0.0;
+      for (a = 0; a < dim; ++a) J[d*dim+a] = 0.0;
+    }
+    for (c = 0; c < nc; ++c) {
+      PetscReal N = 1.0, dN[3];
+
+      for (a = 0; a < dim; ++a) {
+        const PetscReal s = (c & (1 << a)) ? 1.0 : -1.0;
+
+        N    *= 0.5*(1.0 + s*xi[a]);
+        dN[a] = 0.5*s;
+        for (j = 0; j < dim; ++j) if (j != a) dN[a] *= 0.5*(1.0 + ((c & (1 << j)) ? 1.0 : -1.0)*xi[j]);
+      }
+      for (d = 0; d < dim; ++d) {
+        x[d] += N*X[c][d];
+        for (a = 0; a < dim; ++a) J[d*dim+a] += dN[a]*X[c][d];
+      }
+    }
+    if (dim == 2) {
+      detJ    =  J[0]*J[3] - J[1]*J[2];
+      invJ[0] =  J[3]/detJ; invJ[1] = -J[1]/detJ;
+      invJ[2] = -J[2]/detJ; invJ[3] =  J[0]/detJ;
+    } else {
+      detJ = J[0]*(J[4]*J[8] - J[5]*J[7]) + J[1]*(J[5]*J[6] - J[3]*J[8]) + J[2]*(J[3]*J[7] - J[4]*J[6]);
+      invJ[0] = (J[4]*J[8] - J[5]*J[7])/detJ; invJ[1] = (J[2]*J[7] - J[1]*J[8])/detJ; invJ[2] = (J[1]*J[5] - J[2]*J[4])/detJ;
+      invJ[3] = (J[5]*J[6] - J[3]*J[8])/detJ; invJ[4] = (J[0]*J[8] - J[2]*J[6])/detJ; invJ[5] = (J[2]*J[3] - J[0]*J[5])/detJ;
+      invJ[6] = (J[3]*J[7] - J[4]*J[6])/detJ; invJ[7] = (J[1]*J[6] - J[0]*J[7])/detJ; invJ[8] = (J[0]*J[4] - J[1]*J[3])/detJ;
+    }
+    if (detJ == 0.0) SETERRQ1(PETSC_COMM_SELF, PETSC_ERR_ARG_OUTOFRANGE, "Degenerate cell %D", cell);
+    /* The frame of the cell may be a reflection of its orientation */
+    geom[dim+dim*dim] = PetscAbsReal(detJ);
+    rest = i;
+    for (a = 0; a < dim; ++a) {geom[dim+dim*dim] *= ctx->w[rest % ctx->Nq]; rest /= ctx->Nq;}
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorPointJacobian_Private"
+/* The coefficients of the Jacobian at one quadrature point, for test field fieldI and trial field fieldJ, or PETSC_FALSE when there are none */
+static PetscErrorCode DMPlexTensorPointJacobian_Private(DMPlexTensorCtx *ctx, PetscInt fieldI, PetscInt fieldJ, const PetscScalar u[], const PetscScalar gradU[], const PetscReal x[],
+                                                        PetscScalar **g0, PetscScalar **g1, PetscScalar **g2, PetscScalar **g3)
+{
+  PetscFEM       *fem = ctx->fem;
+  const PetscInt  dim = ctx->dim, nf = ctx->numFields, n = ctx->numComp[fieldI]*ctx->numComp[fieldJ], pair = fieldI*nf+fieldJ;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  *g0 = *g1 = *g2 = *g3 = PETSC_NULL;
+  if (fem->g0Funcs && fem->g0Funcs[pair]) {
+    *g0  = ctx->g;
+    ierr = PetscMemzero(*g0, n * sizeof(PetscScalar));CHKERRQ(ierr);
+    fem->g0Funcs[pair](u, gradU, x, *g0);
+  }
+  if (fem->g1Funcs && fem->g1Funcs[pair]) {
+    *g1  = &ctx->g[n];
+    ierr = PetscMemzero(*g1, n*dim * sizeof(PetscScalar));CHKERRQ(ierr);
+    fem->g1Funcs[pair](u, gradU, x, *g1);
+  }
+  if (fem->g2Funcs && fem->g2Funcs[pair]) {
+    *g2  = &ctx->g[n*(1+dim)];
+    ierr = PetscMemzero(*g2, n*dim * sizeof(PetscScalar));CHKERRQ(ierr);
+    fem->g2Funcs[pair](u, gradU, x, *g2);
+  }
+  if (fem->g3Funcs && fem->g3Funcs[pair]) {
+    *g3  = &ctx->g[n*(1+2*dim)];
+    ierr = PetscMemzero(*g3, n*dim*dim * sizeof(PetscScalar));CHKERRQ(ierr);
+    fem->g3Funcs[pair](u, gradU, x, *g3);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorMultLocal_Private"
+/* Y += J(u) X for local vectors; when diag is set Y += diag(J(u)) and X is not used */
+static PetscErrorCode DMPlexTensorMultLocal_Private(DMPlexTensorCtx *ctx, Vec X, Vec Y, PetscBool diag)
+{
+  const PetscInt  dim = ctx->dim, NqD = ctx->NqD, nc = ctx->totComp;
+  const PetscInt  gsize = DMPlexTensorGeomSize(dim);
+  PetscScalar    *u, *gradU, *a, *gradA;
+  PetscScalar    *x = PETSC_NULL, *y, *ubase;
+  PetscLogDouble  flops = 0.0;
+  PetscInt        cell, q, fI, fJ, cI, cJ, offI, offJ, c, d, e, i;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMalloc4(nc,PetscScalar,&u,nc*dim,PetscScalar,&gradU,nc,PetscScalar,&a,nc*dim,PetscScalar,&gradA);CHKERRQ(ierr);
+  ierr = VecGetArray(ctx->jac.u, &ubase);CHKERRQ(ierr);
+  if (!diag) {ierr = VecGetArray(X, &x);CHKERRQ(ierr);}
+  ierr = VecGetArray(Y, &y);CHKERRQ(ierr);
+  for (cell = 0; cell < ctx->numCells; ++cell) {
+    const PetscReal *geom = &ctx->geom[cell*NqD*gsize];
+
+    ierr = DMPlexTensorGatherCell_Private(ctx, cell, ubase, ctx->elemU);CHKERRQ(ierr);
+    DMPlexTensorInterpolate_Private(ctx, ctx->elemU, ctx->uq, ctx->duq, &flops);
+    if (!diag) {
+      ierr = DMPlexTensorGatherCell_Private(ctx, cell, x, ctx->elemA);CHKERRQ(ierr);
+      DMPlexTensorInterpolate_Private(ctx, ctx->elemA, ctx->aq, ctx->daq, &flops);
+    }
+    /* f0q[] and f1q[] hold the coefficients of the test functions and their reference gradients. For the diagonal,
+       f0q[] holds the coefficients of phi_i^2, f1q[] those of phi_i d_a phi_i, and daq[] those of d_a phi_i d_b phi_i */
+    ierr = PetscMemzero(ctx->f0q, nc*NqD * sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = PetscMemzero(ctx->f1q, nc*dim*NqD * sizeof(PetscScalar));CHKERRQ(ierr);
+    if (diag) {ierr = PetscMemzero(ctx->daq, nc*dim*dim*NqD * sizeof(PetscScalar));CHKERRQ(ierr);}
+    for (q = 0; q < NqD; ++q) {
+      const PetscReal *xq   = &geom[q*gsize];
+      const PetscReal *invJ = &geom[q*gsize+dim];
+      const PetscReal  wdet = geom[q*gsize+dim+dim*dim];
+
+      DMPlexTensorPointValues_Private(ctx, q, invJ, ctx->uq, ctx->duq, u, gradU);
+      if (!diag) DMPlexTensorPointValues_Private(ctx, q, invJ, ctx->aq, ctx->daq, a, gradA);
+      for (fI = 0, offI = 0; fI < ctx->numFields; offI += ctx->numComp[fI], ++fI) {
+        const PetscInt NcI = ctx->numComp[fI];
+
+        for (fJ = 0, offJ = 0; fJ < ctx->numFields; offJ += ctx->numComp[fJ], ++fJ) {
+          const PetscInt NcJ = ctx->numComp[fJ];
+          PetscScalar   *g0, *g1, *g2, *g3;
+
+          if (diag && fJ != fI) continue;
+          ierr = DMPlexTensorPointJacobian_Private(ctx, fI, fJ, u, gradU, xq, &g0, &g1, &g2, &g3);CHKERRQ(ierr);
+          for (cI = 0; cI < NcI; ++cI) {
+            PetscScalar f0 = 0.0, f1[3] = {0.0, 0.0, 0.0};
+
+            if (diag) {
+              const PetscInt pc = cI*NcJ+cI;
+
+              if (g0) f0 = g0[pc];
+              for (d = 0; d < dim; ++d) {
+                if (g1) f1[d] += g1[pc*dim+d];
+                if (g2) f1[d] += g2[pc*dim+d];
+              }
+              ctx->f0q[(offI+cI)*NqD+q] += wdet*f0;
+              for (i = 0; i < dim; ++i) {
+                for (d = 0; d < dim; ++d) ctx->f1q[((offI+cI)*dim+i)*NqD+q] += wdet*invJ[i*dim+d]*f1[d];
+              }
+              if (g3) {
+                for (i = 0; i < dim; ++i) {
+                  for (c = 0; c < dim; ++c) {
+                    PetscScalar r = 0.0;
+
+                    for (d = 0; d < dim; ++d) {
+                      for (e = 0; e < dim; ++e) r += invJ[i*dim+d]*g3[(pc*dim+d)*dim+e]*invJ[c*dim+e];
+                    }
+                    ctx->daq[(((offI+cI)*dim+i)*dim+c)*NqD+q] += wdet*r;
+                  }
+                }
+              }
+              continue;
+            }
+            for (cJ = 0; cJ < NcJ; ++cJ) {
+              const PetscInt     pc = cI*NcJ+cJ;
+              const PetscScalar *ga = &gradA[(offJ+cJ)*dim];
+
+              if (g0) f0 += g0[pc]*a[offJ+cJ];
+              for (d = 0; d < dim; ++d) {
+                if (g1) f0    += g1[pc*dim+d]*ga[d];
+                if (g2) f1[d] += g2[pc*dim+d]*a[offJ+cJ];
+                if (g3) {for (e = 0; e < dim; ++e) f1[d] += g3[(pc*dim+d)*dim+e]*ga[e];}
+              }
+            }
+            ctx->f0q[(offI+cI)*NqD+q] += wdet*f0;
+            for (i = 0; i < dim; ++i) {
+              for (d = 0; d < dim; ++d) ctx->f1q[((offI+cI)*dim+i)*NqD+q] += wdet*invJ[i*dim+d]*f1[d];
+            }
+          }
+        }
+      }
+    }
+    if (diag) {
+      const PetscReal *M[3];
+      PetscInt         b;
+
+      for (cI = 0; cI < nc; ++cI) {
+        for (b = 0; b < dim; ++b) M[b] = ctx->BB;
+        DMPlexTensorApply_Private(ctx, M, PETSC_TRUE, &ctx->f0q[cI*NqD], &ctx->elemF[cI*ctx->NbD], PETSC_FALSE, &flops);
+        for (i = 0; i < dim; ++i) {
+          for (b = 0; b < dim; ++b) M[b] = (b == i) ? ctx->BD : ctx->BB;
+          DMPlexTensorApply_Private(ctx, M, PETSC_TRUE, &ctx->f1q[(cI*dim+i)*NqD], &ctx->elemF[cI*ctx->NbD], PETSC_TRUE, &flops);
+          for (c = 0; c < dim; ++c) {
+            for (b = 0; b < dim; ++b) M[b] = (b == i && b == c) ? ctx->DD : ((b == i || b == c) ? ctx->BD : ctx->BB);
+            DMPlexTensorApply_Private(ctx, M, PETSC_TRUE, &ctx->daq[((cI*dim+i)*dim+c)*NqD], &ctx->elemF[cI*ctx->NbD], PETSC_TRUE, &flops);
+          }
+        }
+      }
+    } else {
+      DMPlexTensorIntegrate_Private(ctx, ctx->f0q, ctx->f1q, ctx->elemF, &flops);
+    }
+    ierr = DMPlexTensorScatterCell_Private(ctx, cell, ctx->elemF, y);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(Y, &y);CHKERRQ(ierr);
+  if (!diag) {ierr = VecRestoreArray(X, &x);CHKERRQ(ierr);}
+  ierr = VecRestoreArray(ctx->jac.u, &ubase);CHKERRQ(ierr);
+  ierr = PetscFree4(u,gradU,a,gradA);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_DMPlexTensor"
+static PetscErrorCode MatMult_DMPlexTensor(Mat J, Vec X, Vec Y)
+{
+  DMPlexTensorCtx *ctx;
+  DM               dm;
+  Vec              localX, localY;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  ierr = MatShellGetContext(J, &ctx);CHKERRQ(ierr);
+  dm   = ctx->jac.dm;
+  ierr = DMGetLocalVector(dm, &localX);CHKERRQ(ierr);
+  ierr = DMGetLocalVector(dm, &localY);CHKERRQ(ierr);
+  ierr = VecSet(localX, 0.0);CHKERRQ(ierr);
+  ierr = VecSet(localY, 0.0);CHKERRQ(ierr);
+  ierr = DMGlobalToLocalBegin(dm, X, INSERT_VALUES, localX);CHKERRQ(ierr);
+  ierr = DMGlobalToLocalEnd(dm, X, INSERT_VALUES, localX);CHKERRQ(ierr);
+  ierr = DMPlexTensorMultLocal_Private(ctx, localX, localY, PETSC_FALSE);CHKERRQ(ierr);
+  ierr = VecSet(Y, 0.0);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalBegin(dm, localY, ADD_VALUES, Y);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalEnd(dm, localY, ADD_VALUES, Y);CHKERRQ(ierr);
+  ierr = DMRestoreLocalVector(dm, &localX);CHKERRQ(ierr);
+  ierr = DMRestoreLocalVector(dm, &localY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetDiagonal_DMPlexTensor"
+static PetscErrorCode MatGetDiagonal_DMPlexTensor(Mat J, Vec Y)
+{
+  DMPlexTensorCtx *ctx;
+  DM               dm;
+  Vec              localY;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  ierr = MatShellGetContext(J, &ctx);CHKERRQ(ierr);
+  dm   = ctx->jac.dm;
+  ierr = DMGetLocalVector(dm, &localY);CHKERRQ(ierr);
+  ierr = VecSet(localY, 0.0);CHKERRQ(ierr);
+  ierr = DMPlexTensorMultLocal_Private(ctx, PETSC_NULL, localY, PETSC_TRUE);CHKERRQ(ierr);
+  ierr = VecSet(Y, 0.0);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalBegin(dm, localY, ADD_VALUES, Y);CHKERRQ(ierr);
+  ierr = DMLocalToGlobalEnd(dm, localY, ADD_VALUES, Y);CHKERRQ(ierr);
+  ierr = DMRestoreLocalVector(dm, &localY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDestroy_DMPlexTensor"
+static PetscErrorCode MatDestroy_DMPlexTensor(Mat J)
+{
+  DMPlexTensorCtx *ctx;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  ierr = MatShellGetContext(J, &ctx);CHKERRQ(ierr);
+  ierr = VecDestroy(&ctx->jac.u);CHKERRQ(ierr);
+  ierr = DMDestroy(&ctx->jac.dm);CHKERRQ(ierr);
+  ierr = PetscFree6(ctx->B,ctx->D,ctx->BB,ctx->BD,ctx->DD,ctx->w);CHKERRQ(ierr);
+  ierr = PetscFree3(ctx->numComp,ctx->offsets,ctx->geom);CHKERRQ(ierr);
+  ierr = PetscFree6(ctx->elemU,ctx->elemA,ctx->elemF,ctx->uq,ctx->duq,ctx->aq);CHKERRQ(ierr);
+  ierr = PetscFree6(ctx->daq,ctx->f0q,ctx->f1q,ctx->t[0],ctx->t[1],ctx->g);CHKERRQ(ierr);
+  ierr = PetscFree(ctx);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexCreateTensorJacobianAction"
+/*@C
+  DMPlexCreateTensorJacobianAction - Create a matrix-free Jacobian for a Q_k discretization on a mesh of quadrilaterals or
+  hexahedra, applied by sum factorization.
+
+  Collective on DM
+
+  Input Parameters:
++ dm    - The interpolated mesh, with the layout of Q_k in its default section
+. order - The polynomial order k
+- fem   - The pointwise functions, only g0Funcs, g1Funcs, g2Funcs and g3Funcs are used
+
+  Output Parameter:
+. J - The MATSHELL, which supports MatMult() and MatGetDiagonal()
+
+  Notes:
+  The space is Q_k on the Gauss-Lobatto-Legendre nodes, integrated with k+1 Gauss points in each direction. The section
+  must have, for each field with Nc components, Nc*(k-1)^d dofs on each point of dimension d. The components of a node
+  are contiguous, and the nodes of an edge are numbered from the first to the second vertex of its cone; the nodes of a
+  face are numbered lexicographically from the first vertex of its first edge, along that edge first.
+
+  Interpolation to the quadrature points and integration against the test functions are applied one direction at a
+  time, so that one application costs O(k^{d+1}) flops per cell instead of O(k^{2d}) for dense element matrices, and
+  only the geometry at the quadrature points is stored. Cells need not be affine, the multilinear map is used.
+
+  The matrix is linearized about a local base state which is zero initially. The context of the MATSHELL starts with a
+  JacActionCtx, so DMPlexComputeJacobianFEM() keeps the base state current when J is the Jacobian given to SNES; it can
+  also be set with DMPlexTensorJacobianActionSetState().
+
+  Level: developer
+
+.seealso: DMPlexComputeTensorResidualFEM(), DMPlexComputeJacobianActionFEM(), MATSHELL
+@*/
+PetscErrorCode DMPlexCreateTensorJacobianAction(DM dm, PetscInt order, PetscFEM *fem, Mat *J)
+{
+  DMPlexTensorCtx *ctx;
+  PetscSection     section, cSection;
+  Vec              coordinates, global;
+  PetscScalar     *coords;
+  PetscReal       *z, *xq;
+  PetscInt         depthStart[4], depthEnd[4], depth, cStart, cEnd, cell, f, i, j, m, M, maxN, maxNc = 0;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(dm, DM_CLASSID, 1);
+  PetscValidPointer(fem, 3);
+  PetscValidPointer(J, 4);
+  if (order < 1) SETERRQ1(((PetscObject) dm)->comm, PETSC_ERR_ARG_OUTOFRANGE, "The order %D must be positive", order);
+  ierr = PetscNew(DMPlexTensorCtx, &ctx);CHKERRQ(ierr);
+  ierr = DMPlexGetDimension(dm, &ctx->dim);CHKERRQ(ierr);
+  if (ctx->dim < 2 || ctx->dim > 3) SETERRQ1(((PetscObject) dm)->comm, PETSC_ERR_SUP, "Dimension %D not supported, only quadrilaterals and hexahedra", ctx->dim);
+  ierr = DMPlexGetDepth(dm, &depth);CHKERRQ(ierr);
+  if (depth != ctx->dim) SETERRQ(((PetscObject) dm)->comm, PETSC_ERR_ARG_WRONG, "The mesh must be interpolated");
+  for (i = 0; i <= depth; ++i) {
+    ierr = DMPlexGetDepthStratum(dm, i, &depthStart[i], &depthEnd[i]);CHKERRQ(ierr);
+  }
+  ierr = PetscObjectReference((PetscObject) dm);CHKERRQ(ierr);
+  ctx->jac.dm = dm;
+  ctx->fem    = fem;
+  ctx->order  = order;
+  ctx->Nb     = order+1;
+  ctx->Nq     = order+1;
+  ctx->NbD    = PetscPowInt(ctx->Nb, ctx->dim);
+  ctx->NqD    = PetscPowInt(ctx->Nq, ctx->dim);
+  ierr = DMCreateLocalVector(dm, &ctx->jac.u);CHKERRQ(ierr);
+  ierr = VecSet(ctx->jac.u, 0.0);CHKERRQ(ierr);
+
+  /* The 1D basis at the quadrature points */
+  ierr = PetscMalloc6(ctx->Nq*ctx->Nb,PetscReal,&ctx->B,ctx->Nq*ctx->Nb,PetscReal,&ctx->D,ctx->Nq*ctx->Nb,PetscReal,&ctx->BB,ctx->Nq*ctx->Nb,PetscReal,&ctx->BD,ctx->Nq*ctx->Nb,PetscReal,&ctx->DD,ctx->Nq,PetscReal,&ctx->w);CHKERRQ(ierr);
+  ierr = PetscMalloc2(ctx->Nb,PetscReal,&z,ctx->Nq,PetscReal,&xq);CHKERRQ(ierr);
+  ierr = DMPlexTensorGLLNodes_Private(order, z);CHKERRQ(ierr);
+  ierr = PetscDTGaussQuadrature(ctx->Nq, -1.0, 1.0, xq, ctx->w);CHKERRQ(ierr);
+  for (i = 0; i < ctx->Nq; ++i) {
+    DMPlexTensorLagrange_Private(ctx->Nb, z, xq[i], &ctx->B[i*ctx->Nb], &ctx->D[i*ctx->Nb]);
+    for (j = 0; j < ctx->Nb; ++j) {
+      const PetscInt ij = i*ctx->Nb+j;
+
+      ctx->BB[ij] = ctx->B[ij]*ctx->B[ij];
+      ctx->BD[ij] = ctx->B[ij]*ctx->D[ij];
+      ctx->DD[ij] = ctx->D[ij]*ctx->D[ij];
+    }
+  }
+
+  /* The fields */
+  ierr = DMGetDefaultSection(dm, &section);CHKERRQ(ierr);
+  ierr = PetscSectionGetNumFields(section, &ctx->numFields);CHKERRQ(ierr);
+  ierr = DMPlexGetHeightStratum(dm, 0, &cStart, &cEnd);CHKERRQ(ierr);
+  ctx->numCells = cEnd - cStart;
+  ierr = PetscMalloc3(PetscMax(ctx->numFields,1),PetscInt,&ctx->numComp,ctx->numCells*PetscMax(ctx->numFields,1)*ctx->NbD,PetscInt,&ctx->offsets,ctx->numCells*ctx->NqD*DMPlexTensorGeomSize(ctx->dim),PetscReal,&ctx->geom);CHKERRQ(ierr);
+  if (ctx->numFields) {
+    for (f = 0; f < ctx->numFields; ++f) {
+      ierr = PetscSectionGetFieldComponents(section, f, &ctx->numComp[f]);CHKERRQ(ierr);
+    }
+  } else {
+    ctx->numFields = 1;
+    if (depthEnd[0] > depthStart[0]) {ierr = PetscSectionGetDof(section, depthStart[0], &ctx->numComp[0]);CHKERRQ(ierr);}
+    else ctx->numComp[0] = 1;
+  }
+  for (f = 0, ctx->totComp = 0; f < ctx->numFields; ++f) {
+    ctx->totComp += ctx->numComp[f];
+    maxNc         = PetscMax(maxNc, ctx->numComp[f]);
+  }
+  maxN = PetscPowInt(PetscMax(ctx->Nb, ctx->Nq), ctx->dim);
+  ierr = PetscMalloc6(ctx->totComp*ctx->NbD,PetscScalar,&ctx->elemU,ctx->totComp*ctx->NbD,PetscScalar,&ctx->elemA,ctx->totComp*ctx->NbD,PetscScalar,&ctx->elemF,
+                      ctx->totComp*ctx->NqD,PetscScalar,&ctx->uq,ctx->totComp*ctx->dim*ctx->NqD,PetscScalar,&ctx->duq,ctx->totComp*ctx->NqD,PetscScalar,&ctx->aq);CHKERRQ(ierr);
+  ierr = PetscMalloc6(ctx->totComp*ctx->dim*ctx->dim*ctx->NqD,PetscScalar,&ctx->daq,ctx->totComp*ctx->NqD,PetscScalar,&ctx->f0q,ctx->totComp*ctx->dim*ctx->NqD,PetscScalar,&ctx->f1q,
+                      maxN,PetscScalar,&ctx->t[0],maxN,PetscScalar,&ctx->t[1],maxNc*maxNc*(1+ctx->dim)*(1+ctx->dim),PetscScalar,&ctx->g);CHKERRQ(ierr);
+
+  /* The node offsets and the geometry of each cell */
+  ierr = DMPlexGetCoordinateSection(dm, &cSection);CHKERRQ(ierr);
+  ierr = DMGetCoordinatesLocal(dm, &coordinates);CHKERRQ(ierr);
+  ierr = VecGetArray(coordinates, &coords);CHKERRQ(ierr);
+  for (cell = cStart; cell < cEnd; ++cell) {
+    ierr = DMPlexTensorSetUpCell_Private(dm, ctx, cell-cStart, depthStart, depthEnd, section, cSection, coords, xq);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(coordinates, &coords);CHKERRQ(ierr);
+  ierr = PetscFree2(z,xq);CHKERRQ(ierr);
+  ierr = PetscInfo3(dm, "Q_%D sum factorization on %D cells with %D quadrature points each\n", order, ctx->numCells, ctx->NqD);CHKERRQ(ierr);
+
+  ierr = DMCreateGlobalVector(dm, &global);CHKERRQ(ierr);
+  ierr = VecGetLocalSize(global, &m);CHKERRQ(ierr);
+  ierr = VecGetSize(global, &M);CHKERRQ(ierr);
+  ierr = VecDestroy(&global);CHKERRQ(ierr);
+  ierr = MatCreate(((PetscObject) dm)->comm, J);CHKERRQ(ierr);
+  ierr = MatSetSizes(*J, m, m, M, M);CHKERRQ(ierr);
+  ierr = MatSetType(*J, MATSHELL);CHKERRQ(ierr);
+  ierr = MatShellSetContext(*J, ctx);CHKERRQ(ierr);
+  ierr = MatShellSetOperation(*J, MATOP_MULT, (void (*)(void)) MatMult_DMPlexTensor);CHKERRQ(ierr);
+  ierr = MatShellSetOperation(*J, MATOP_GET_DIAGONAL, (void (*)(void)) MatGetDiagonal_DMPlexTensor);CHKERRQ(ierr);
+  ierr = MatShellSetOperation(*J, MATOP_DESTROY, (void (*)(void)) MatDestroy_DMPlexTensor);CHKERRQ(ierr);
+  ierr = MatSetUp(*J);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexTensorJacobianActionSetState"
+/*@
+  DMPlexTensorJacobianActionSetState - Set the base state about which the Jacobian is linearized
+
+  Logically collective on Mat
+
+  Input Parameters:
++ J - The matrix from DMPlexCreateTensorJacobianAction()
+- u - The local base state
+
+  Level: developer
+
+.seealso: DMPlexCreateTensorJacobianAction()
+@*/
+PetscErrorCode DMPlexTensorJacobianActionSetState(Mat J, Vec u)
+{
+  DMPlexTensorCtx *ctx;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(J, MAT_CLASSID, 1);
+  PetscValidHeaderSpecific(u, VEC_CLASSID, 2);
+  ierr = MatShellGetContext(J, &ctx);CHKERRQ(ierr);
+  ierr = VecCopy(u, ctx->jac.u);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "DMPlexComputeTensorResidualFEM"
+/*@
+  DMPlexComputeTensorResidualFEM - Form the local residual F from the local input X on a mesh of quadrilaterals or
+  hexahedra by sum factorization
+
+  Input Parameters:
++ dm   - The mesh
+. X    - Local input vector
+- user - The matrix from DMPlexCreateTensorJacobianAction(), whose f0Funcs and f1Funcs are used
+
+  Output Parameter:
+. F  - Local output vector
+
+  Note:
+  The boundary values in X are used as they are. The signature allows it to be given to DMSNESSetFunctionLocal().
+
+  Level: developer
+
+.seealso: DMPlexCreateTensorJacobianAction(), DMPlexComputeResidualFEM()
+@*/
+PetscErrorCode DMPlexComputeTensorResidualFEM(DM dm, Vec X, Vec F, void *user)
+{
+  Mat              J = (Mat) user;
+  DMPlexTensorCtx *ctx;
+  PetscFEM        *fem;
+  PetscScalar     *u, *gradU, *f0, *f1, *x, *y;
+  PetscLogDouble   flops = 0.0;
+  PetscInt         dim, NqD, gsize, nc, cell, q, fI, offI, c, d, i;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(dm, DM_CLASSID, 1);
+  PetscValidHeaderSpecific(J, MAT_CLASSID, 4);
+  ierr  = MatShellGetContext(J, &ctx);CHKERRQ(ierr);
+  fem   = ctx->fem;
+  dim   = ctx->dim;
+  NqD   = ctx->NqD;
+  nc    = ctx->totComp;
+  gsize = DMPlexTensorGeomSize(dim);
+  ierr  = PetscMalloc4(nc,PetscScalar,&u,nc*dim,PetscScalar,&gradU,nc,PetscScalar,&f0,nc*dim,PetscScalar,&f1);CHKERRQ(ierr);
+  ierr  = VecSet(F, 0.0);CHKERRQ(ierr);
+  ierr  = VecGetArray(X, &x);CHKERRQ(ierr);
+  ierr  = VecGetArray(F, &y);CHKERRQ(ierr);
+  for (cell = 0; cell < ctx->numCells; ++cell) {
+    const PetscReal *geom = &ctx->geom[cell*NqD*gsize];
+
+    ierr = DMPlexTensorGatherCell_Private(ctx, cell, x, ctx->elemU);CHKERRQ(ierr);
+    DMPlexTensorInterpolate_Private(ctx, ctx->elemU, ctx->uq, ctx->duq, &flops);
+    for (q = 0; q < NqD; ++q) {
+      const PetscReal *xq   = &geom[q*gsize];
+      const PetscReal *invJ = &geom[q*gsize+dim];
+      const PetscReal  wdet = geom[q*gsize+dim+dim*dim];
+
+      DMPlexTensorPointValues_Private(ctx, q, invJ, ctx->uq, ctx->duq, u, gradU);
+      for (fI = 0, offI = 0; fI < ctx->numFields; offI += ctx->numComp[fI], ++fI) {
+        const PetscInt NcI = ctx->numComp[fI];
+
+        ierr = PetscMemzero(f0, NcI * sizeof(PetscScalar));CHKERRQ(ierr);
+        ierr = PetscMemzero(f1, NcI*dim * sizeof(PetscScalar));CHKERRQ(ierr);
+        if (fem->f0Funcs && fem->f0Funcs[fI]) fem->f0Funcs[fI](u, gradU, xq, f0);
+        if (fem->f1Funcs && fem->f1Funcs[fI]) fem->f1Funcs[fI](u, gradU, xq, f1);
+        for (c = 0; c < NcI; ++c) {
+          ctx->f0q[(offI+c)*NqD+q] = wdet*f0[c];
+          for (i = 0; i < dim; ++i) {
+            PetscScalar r = 0.0;
+
+            for (d = 0; d < dim; ++d) r += invJ[i*dim+d]*f1[c*dim+d];
+            ctx->f1q[((offI+c)*dim+i)*NqD+q] = wdet*r;
+          }
+        }
+      }
+    }
+    DMPlexTensorIntegrate_Private(ctx, ctx->f0q, ctx->f1q, ctx->elemF, &flops);
+    ierr = DMPlexTensorScatterCell_Private(ctx, cell, ctx->elemF, y);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(F, &y);CHKERRQ(ierr);
+  ierr = VecRestoreArray(X, &x);CHKERRQ(ierr);
+  ierr = PetscFree4(u,gradU,f0,f1);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
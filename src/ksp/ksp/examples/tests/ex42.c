@@ -0,0 +1,113 @@
+
+static char help[] = "Tests PCPBJACOBI with large point blocks and with blocks of varying sizes set with PCPBJacobiSetBlockSizes().\n\
+Input arguments are:\n\
+  -m <blocks> : number of local point blocks\n\
+  -bs <bs>    : size of all the blocks, the default 0 cycles through several sizes\n\n";
+
+#include <petscksp.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,D;
+  Vec            x,b,y;
+  KSP            ksp;
+  PC             pc;
+  PetscRandom    rdm;
+  PetscErrorCode ierr;
+  PetscInt       m = 20,bs = 0,sizes[] = {40,40,3,9,1,12,40,17},nsizes = 8,*bsizes,n,N,rstart,i,j,k,s;
+  PetscScalar    v;
+  PetscReal      nrm,err;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-bs",&bs,PETSC_NULL);CHKERRQ(ierr);
+
+  ierr = PetscMalloc(m*sizeof(PetscInt),&bsizes);CHKERRQ(ierr);
+  for (k=0,n=0; k<m; k++) {
+    bsizes[k] = bs ? bs : sizes[k%nsizes];
+    n        += bsizes[k];
+  }
+
+  /* A couples the blocks to each other, D is only its block diagonal part */
+  ierr = MatCreate(PETSC_COMM_WORLD,&A);CHKERRQ(ierr);
+  ierr = MatSetSizes(A,n,n,PETSC_DETERMINE,PETSC_DETERMINE);CHKERRQ(ierr);
+  if (bs) {ierr = MatSetBlockSize(A,bs);CHKERRQ(ierr);}
+  ierr = MatSetType(A,MATAIJ);CHKERRQ(ierr);
+  ierr = MatSetUp(A);CHKERRQ(ierr);
+  ierr = MatCreate(PETSC_COMM_WORLD,&D);CHKERRQ(ierr);
+  ierr = MatSetSizes(D,n,n,PETSC_DETERMINE,PETSC_DETERMINE);CHKERRQ(ierr);
+  if (bs) {ierr = MatSetBlockSize(D,bs);CHKERRQ(ierr);}
+  ierr = MatSetType(D,MATAIJ);CHKERRQ(ierr);
+  ierr = MatSetUp(D);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatGetSize(A,&N,PETSC_NULL);CHKERRQ(ierr);
+  for (k=0,s=rstart; k<m; s+=bsizes[k],k++) {
+    for (i=s; i<s+bsizes[k]; i++) {
+      for (j=s; j<s+bsizes[k]; j++) {
+        v    = (i == j) ? bsizes[k] + 1.0 : (1.0 + k%3)/(2.0 + (i-s) + 2*(j-s));
+        ierr = MatSetValues(A,1,&i,1,&j,&v,INSERT_VALUES);CHKERRQ(ierr);
+        ierr = MatSetValues(D,1,&i,1,&j,&v,INSERT_VALUES);CHKERRQ(ierr);
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FLUSH_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FLUSH_ASSEMBLY);CHKERRQ(ierr);
+  for (i=rstart; i<rstart+n; i++) {
+    v    = -0.2;
+    j    = (i+5)%N;
+    ierr = MatSetValues(A,1,&i,1,&j,&v,ADD_VALUES);CHKERRQ(ierr);
+    j    = (i+N-5)%N;
+    ierr = MatSetValues(A,1,&i,1,&j,&v,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(D,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(D,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatGetVecs(A,&x,&b);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rdm);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rdm);CHKERRQ(ierr);
+  ierr = VecSetRandom(x,rdm);CHKERRQ(ierr);
+  ierr = VecNorm(x,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+
+  ierr = KSPCreate(PETSC_COMM_WORLD,&ksp);CHKERRQ(ierr);
+  ierr = KSPSetOperators(ksp,A,D,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = KSPGetPC(ksp,&pc);CHKERRQ(ierr);
+  ierr = PCSetType(pc,PCPBJACOBI);CHKERRQ(ierr);
+  ierr = KSPSetTolerances(ksp,1.e-10,PETSC_DEFAULT,PETSC_DEFAULT,PETSC_DEFAULT);CHKERRQ(ierr);
+  ierr = KSPSetFromOptions(ksp);CHKERRQ(ierr);
+  if (!bs) {ierr = PCPBJacobiSetBlockSizes(pc,m,bsizes);CHKERRQ(ierr);}
+  ierr = KSPSetUp(ksp);CHKERRQ(ierr);
+
+  /* the preconditioner is the exact inverse of D */
+  ierr = MatMult(D,x,b);CHKERRQ(ierr);
+  ierr = PCApply(pc,b,y);CHKERRQ(ierr);
+  ierr = VecAXPY(y,-1.0,x);CHKERRQ(ierr);
+  ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+  if (err > 1.e-10*nrm) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"PCApply(): relative error %G\n",err/nrm);CHKERRQ(ierr);
+  }
+
+  ierr = MatMult(A,x,b);CHKERRQ(ierr);
+  ierr = KSPSolve(ksp,b,y);CHKERRQ(ierr);
+  ierr = VecAXPY(y,-1.0,x);CHKERRQ(ierr);
+  ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+  if (err > 1.e-6*nrm) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"KSPSolve(): relative error %G\n",err/nrm);CHKERRQ(ierr);
+  }
+
+  ierr = KSPDestroy(&ksp);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rdm);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&D);CHKERRQ(ierr);
+  ierr = PetscFree(bsizes);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
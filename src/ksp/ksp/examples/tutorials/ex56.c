@@ -3,7 +3,8 @@ of linear elasticity.  E=1.0, nu=0.25.\n\
 Unit square domain with Dirichelet boundary condition on the y=0 side only.\n\
 Load of 1.0 in x + 2y direction on all nodes (not a true uniform load).\n\
   -ne <size>      : number of (square) quadrilateral elements in each dimension\n\
-  -alpha <v>      : scaling of material coeficient in embedded circle\n\n";
+  -alpha <v>      : scaling of material coeficient in embedded circle\n\
+  -alpha2 <v>     : with -two_solves, the coefficient in the circle for the 2nd solve, the 3rd goes back to -alpha\n\n";
 
 #include <petscksp.h>
 #include <assert.h>
@@ -16,11 +17,11 @@ static PetscErrorCode MaybeLogStagePop() { return log_stages ? PetscLogStagePop(
 #define __FUNCT__ "main"
 int main(int argc,char **args)
 {
-  Mat            Amat;
+  Mat            Amat,Smat = PETSC_NULL;
   PetscErrorCode ierr;
   PetscInt       m,nn,M,Istart,Iend,i,j,k,ii,jj,kk,ic,ne=4,id;
-  PetscReal      x,y,z,h,*coords,soft_alpha=1.e-3;
-  PetscBool      two_solves = PETSC_FALSE,test_nonzero_cols = PETSC_FALSE;
+  PetscReal      x,y,z,h,*coords,soft_alpha=1.e-3,soft_alpha2=1.e-3;
+  PetscBool      two_solves = PETSC_FALSE,test_nonzero_cols = PETSC_FALSE,change_alpha = PETSC_FALSE;
   Vec            xx,bb;
   KSP            ksp;
   MPI_Comm       wcomm;
@@ -44,6 +45,7 @@ int main(int argc,char **args)
     ierr = PetscOptionsBool("-log_stages","Log stages of solve separately","",log_stages,&log_stages,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscOptionsReal("-alpha","material coefficient inside circle","",soft_alpha,&soft_alpha,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscOptionsBool("-two_solves","solve additional variant of the problem","",two_solves,&two_solves,PETSC_NULL);CHKERRQ(ierr);
+    ierr = PetscOptionsReal("-alpha2","material coefficient inside circle for the 2nd solve","",soft_alpha2,&soft_alpha2,&change_alpha);CHKERRQ(ierr);
     ierr = PetscOptionsBool("-test_nonzero_cols","nonzero test","",test_nonzero_cols,&test_nonzero_cols,PETSC_NULL);CHKERRQ(ierr);
   }
   ierr = PetscOptionsEnd();CHKERRQ(ierr);
@@ -119,6 +121,16 @@ int main(int argc,char **args)
     ierr = MatSeqAIJSetPreallocation(Amat,0,d_nnz);CHKERRQ(ierr);
     ierr = MatMPIAIJSetPreallocation(Amat,0,d_nnz,0,o_nnz);CHKERRQ(ierr);
 
+    /* the element matrices of the circle alone, with coefficient 1, to change its coefficient for the 2nd solve */
+    if (two_solves && change_alpha) {
+      ierr = MatCreate(wcomm,&Smat);CHKERRQ(ierr);
+      ierr = MatSetSizes(Smat,m,m,M,M);CHKERRQ(ierr);
+      ierr = MatSetBlockSize(Smat,3);CHKERRQ(ierr);
+      ierr = MatSetType(Smat,MATAIJ);CHKERRQ(ierr);
+      ierr = MatSeqAIJSetPreallocation(Smat,0,d_nnz);CHKERRQ(ierr);
+      ierr = MatMPIAIJSetPreallocation(Smat,0,d_nnz,0,o_nnz);CHKERRQ(ierr);
+    }
+
     ierr = PetscFree( d_nnz );CHKERRQ(ierr);
     ierr = PetscFree( o_nnz );CHKERRQ(ierr);
 
@@ -230,6 +242,9 @@ int main(int argc,char **args)
               ierr = MatSetValuesBlocked(Amat,8,idx,8,idx,(const PetscScalar*)DD,ADD_VALUES);CHKERRQ(ierr);
               ierr = VecSetValuesBlocked(bb,8,idx,(const PetscScalar*)v2,ADD_VALUES);CHKERRQ(ierr);
             }
+            if (Smat && radius < 0.25) {
+              ierr = MatSetValuesBlocked(Smat,8,idx,8,idx,k>0 ? (const PetscScalar*)DD1 : (const PetscScalar*)DD2,ADD_VALUES);CHKERRQ(ierr);
+            }
           }
         }
       }
@@ -239,6 +254,10 @@ int main(int argc,char **args)
     ierr = MatAssemblyEnd(Amat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
     ierr = VecAssemblyBegin(bb);CHKERRQ(ierr);
     ierr = VecAssemblyEnd(bb);CHKERRQ(ierr);
+    if (Smat) {
+      ierr = MatAssemblyBegin(Smat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+      ierr = MatAssemblyEnd(Smat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    }
   }
 
   if ( !PETSC_TRUE ) {
@@ -282,7 +301,11 @@ int main(int argc,char **args)
     PetscReal emax, emin;
     ierr = MaybeLogStagePush(stage[2]);CHKERRQ(ierr);
     /* PC setup basically */
-    ierr = MatScale( Amat, 100000.0 );CHKERRQ(ierr);
+    if (Smat) {
+      ierr = MatAXPY( Amat, soft_alpha2 - soft_alpha, Smat, SUBSET_NONZERO_PATTERN );CHKERRQ(ierr);
+    } else {
+      ierr = MatScale( Amat, 100000.0 );CHKERRQ(ierr);
+    }
     ierr = KSPSetOperators( ksp, Amat, Amat, SAME_NONZERO_PATTERN );CHKERRQ(ierr);
     ierr = KSPSetUp( ksp );CHKERRQ(ierr);
 
@@ -295,7 +318,11 @@ int main(int argc,char **args)
     ierr = MaybeLogStagePush(stage[4]);CHKERRQ(ierr);
 
     /* 3rd solve */
-    ierr = MatScale( Amat, 100000.0 );CHKERRQ(ierr);
+    if (Smat) {
+      ierr = MatAXPY( Amat, soft_alpha - soft_alpha2, Smat, SUBSET_NONZERO_PATTERN );CHKERRQ(ierr);
+    } else {
+      ierr = MatScale( Amat, 100000.0 );CHKERRQ(ierr);
+    }
     ierr = KSPSetOperators( ksp, Amat, Amat, SAME_NONZERO_PATTERN );CHKERRQ(ierr);
     ierr = KSPSetUp( ksp );CHKERRQ(ierr);
 
@@ -342,6 +369,7 @@ int main(int argc,char **args)
   ierr = VecDestroy(&xx);CHKERRQ(ierr);
   ierr = VecDestroy(&bb);CHKERRQ(ierr);
   ierr = MatDestroy(&Amat);CHKERRQ(ierr);
+  ierr = MatDestroy(&Smat);CHKERRQ(ierr);
   ierr = PetscFree( coords );CHKERRQ(ierr);
 
   ierr = PetscFinalize();
@@ -40,10 +40,12 @@ PetscErrorCode KSPSetUp_GROPPCG(KSP ksp)
 PetscErrorCode  KSPSolve_GROPPCG(KSP ksp)
 {
   PetscErrorCode ierr;
-  PetscInt       i;
+  PetscInt       i,nd;
   PetscScalar    alpha,beta = 0.0,gamma,gammaNew,t;
+  PetscScalar    ualpha[3],ubeta[3];
   PetscReal      dp = 0.0;
   Vec            x,b,r,p,s,S,z,Z;
+  Vec            up[3],ux[3],dx[2],dy[2];
   Mat            Amat,Pmat;
   MatStructure   pflag;
   PetscBool      diagonalscale;
@@ -104,27 +106,31 @@ PetscErrorCode  KSPSolve_GROPPCG(KSP ksp)
 
   i = 0;
   do {
+    if (i == 0) {               /* later iterations start this reduction in the update of p and s below */
+      ierr = VecDotBegin(p,s,&t);CHKERRQ(ierr);
+    }
     ksp->its = i+1;
     i++;
 
-    ierr = VecDotBegin(p,s,&t);CHKERRQ(ierr);
     ierr = PetscCommSplitReductionBegin(((PetscObject)p)->comm);CHKERRQ(ierr);
 
     ierr = KSP_PCApply(ksp,s,S);CHKERRQ(ierr);         /*   S <- Bs       */
 
     ierr = VecDotEnd(p,s,&t);CHKERRQ(ierr);
 
+    /* update x, r and z and compute the local part of the following reductions in a single pass */
     alpha = gamma / t;
-    ierr = VecAXPY(x, alpha,p);CHKERRQ(ierr);    /*     x <- x + alpha * p   */
-    ierr = VecAXPY(r,-alpha,s);CHKERRQ(ierr);    /*     r <- r - alpha * s   */
-    ierr = VecAXPY(z,-alpha,S);CHKERRQ(ierr);    /*     z <- z - alpha * S   */
-
+    up[0] = x; ux[0] = p; ualpha[0] =  alpha; ubeta[0] = 1.0;  /*     x <- x + alpha * p   */
+    up[1] = r; ux[1] = s; ualpha[1] = -alpha; ubeta[1] = 1.0;  /*     r <- r - alpha * s   */
+    up[2] = z; ux[2] = S; ualpha[2] = -alpha; ubeta[2] = 1.0;  /*     z <- z - alpha * S   */
+    nd = 0;
     if (ksp->normtype == KSP_NORM_UNPRECONDITIONED) {
-      ierr = VecNormBegin(r,NORM_2,&dp);CHKERRQ(ierr);
+      dx[nd] = r; dy[nd++] = r;                                /*     dp <- sqrt(r'*r)     */
     } else if (ksp->normtype == KSP_NORM_PRECONDITIONED) {
-      ierr = VecNormBegin(z,NORM_2,&dp);CHKERRQ(ierr);
+      dx[nd] = z; dy[nd++] = z;                                /*     dp <- sqrt(z'*z)     */
     }
-    ierr = VecDotBegin(r,z,&gammaNew);CHKERRQ(ierr);
+    dx[nd] = r; dy[nd++] = z;                                  /*     gammaNew <- z'*r     */
+    ierr = VecMultiAXPBYDotBegin(3,up,ualpha,ubeta,ux,nd,dx,dy,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscCommSplitReductionBegin(((PetscObject)r)->comm);CHKERRQ(ierr);
 
     ierr = KSP_MatMult(ksp,Amat,z,Z);CHKERRQ(ierr);      /*   Z <- Az       */
@@ -150,8 +156,11 @@ PetscErrorCode  KSPSolve_GROPPCG(KSP ksp)
 
     beta = gammaNew / gamma;
     gamma = gammaNew;
-    ierr = VecAYPX(p,beta,z);CHKERRQ(ierr);    /*     p <- z + beta * p   */
-    ierr = VecAYPX(s,beta,Z);CHKERRQ(ierr);    /*     s <- Z + beta * s   */
+    up[0] = p; ux[0] = z; ualpha[0] = 1.0; ubeta[0] = beta;    /*     p <- z + beta * p   */
+    up[1] = s; ux[1] = Z; ualpha[1] = 1.0; ubeta[1] = beta;    /*     s <- Z + beta * s   */
+    dx[0] = p; dy[0] = s;                                      /*     t <- s'*p           */
+    nd = (i < ksp->max_it) ? 1 : 0;            /* no reduction is needed after the last iteration */
+    ierr = VecMultiAXPBYDotBegin(2,up,ualpha,ubeta,ux,nd,dx,dy,PETSC_NULL);CHKERRQ(ierr);
 
   } while (i<ksp->max_it);
   if (i >= ksp->max_it) {
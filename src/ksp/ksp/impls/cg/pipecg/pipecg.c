@@ -46,10 +46,13 @@ PetscErrorCode KSPSetUp_PIPECG(KSP ksp)
 PetscErrorCode  KSPSolve_PIPECG(KSP ksp)
 {
   PetscErrorCode ierr;
-  PetscInt       i;
+  PetscInt       i,k;
   PetscScalar    alpha = 0.0,beta = 0.0,gamma = 0.0,gammaold = 0.0,delta = 0.0;
   PetscReal      dp = 0.0;
   Vec            X,B,Z,P,W,Q,U,M,N,R,S;
+  Vec            up[8],ux[8],dx[3],dy[3];
+  PetscScalar    ualpha[8],ubeta[8];
+  PetscInt       nd,ndnext = 0;
   Mat            Amat,Pmat;
   MatStructure   pflag;
   PetscBool      diagonalscale;
@@ -115,16 +118,34 @@ PetscErrorCode  KSPSolve_PIPECG(KSP ksp)
   ierr = (*ksp->converged)(ksp,0,dp,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);      /* test for convergence */
   if (ksp->reason) PetscFunctionReturn(0);
 
+  /*
+     The eight vector updates at the end of each iteration are done with a single pass over the
+     vectors, which also computes the local part of the reductions needed by the next iteration
+  */
+  up[0] = Z; ux[0] = N;                        /*     z <- n + beta * z   */
+  up[1] = Q; ux[1] = M;                        /*     q <- m + beta * q   */
+  up[2] = P; ux[2] = U;                        /*     p <- u + beta * p   */
+  up[3] = S; ux[3] = W;                        /*     s <- w + beta * s   */
+  up[4] = X; ux[4] = P;                        /*     x <- x + alpha * p  */
+  up[5] = U; ux[5] = Q;                        /*     u <- u - alpha * q  */
+  up[6] = W; ux[6] = Z;                        /*     w <- w - alpha * z  */
+  up[7] = R; ux[7] = S;                        /*     r <- r - alpha * s  */
+  if (ksp->normtype == KSP_NORM_UNPRECONDITIONED) {
+    dx[ndnext] = R; dy[ndnext++] = R;          /*     dp <- sqrt(r'*r)    */
+  } else if (ksp->normtype == KSP_NORM_PRECONDITIONED) {
+    dx[ndnext] = U; dy[ndnext++] = U;          /*     dp <- sqrt(u'*u)    */
+  }
+  dx[ndnext] = R; dy[ndnext++] = U;            /*     gamma <- u'*r       */
+  dx[ndnext] = W; dy[ndnext++] = U;            /*     delta <- u'*w       */
+
   i = 0;
   do {
-    if (i > 0 && ksp->normtype == KSP_NORM_UNPRECONDITIONED) {
-      ierr = VecNormBegin(R,NORM_2,&dp);CHKERRQ(ierr);
-    } else if (i > 0 && ksp->normtype == KSP_NORM_PRECONDITIONED) {
-      ierr = VecNormBegin(U,NORM_2,&dp);CHKERRQ(ierr);
-    } else if (! (i == 0 && ksp->normtype == KSP_NORM_NATURAL)) {
-      ierr = VecDotBegin(R,U,&gamma);CHKERRQ(ierr);
+    if (i == 0) {                /* later iterations start the reductions in the vector update below */
+      if (ksp->normtype != KSP_NORM_NATURAL) {
+        ierr = VecDotBegin(R,U,&gamma);CHKERRQ(ierr);
+      }
+      ierr = VecDotBegin(W,U,&delta);CHKERRQ(ierr);
     }
-    ierr = VecDotBegin(W,U,&delta);CHKERRQ(ierr);
     ierr = PetscCommSplitReductionBegin(((PetscObject)R)->comm);CHKERRQ(ierr);
 
     ierr = KSP_PCApply(ksp,W,M);CHKERRQ(ierr);           /*   m <- Bw       */
@@ -134,7 +155,8 @@ PetscErrorCode  KSPSolve_PIPECG(KSP ksp)
       ierr = VecNormEnd(R,NORM_2,&dp);CHKERRQ(ierr);
     } else if (i > 0 && ksp->normtype == KSP_NORM_PRECONDITIONED) {
       ierr = VecNormEnd(U,NORM_2,&dp);CHKERRQ(ierr);
-    } else if (! (i == 0 && ksp->normtype == KSP_NORM_NATURAL)) {
+    }
+    if (!(i == 0 && ksp->normtype == KSP_NORM_NATURAL)) {
       ierr = VecDotEnd(R,U,&gamma);CHKERRQ(ierr);
     }
     ierr = VecDotEnd(W,U,&delta);CHKERRQ(ierr);
@@ -154,22 +176,18 @@ PetscErrorCode  KSPSolve_PIPECG(KSP ksp)
 
     if (i == 0) {
       alpha = gamma / delta;
-      ierr = VecCopy(N,Z);CHKERRQ(ierr);         /*     z <- n          */
-      ierr = VecCopy(M,Q);CHKERRQ(ierr);         /*     q <- m          */
-      ierr = VecCopy(U,P);CHKERRQ(ierr);         /*     p <- u          */
-      ierr = VecCopy(W,S);CHKERRQ(ierr);         /*     s <- w          */
+      beta  = 0.0;                               /*     z <- n, q <- m, p <- u, s <- w */
     } else {
       beta = gamma / gammaold;
       alpha = gamma / ( delta - beta / alpha * gamma );
-      ierr = VecAYPX(Z,beta,N);CHKERRQ(ierr);    /*     z <- n + beta * z   */
-      ierr = VecAYPX(Q,beta,M);CHKERRQ(ierr);    /*     q <- m + beta * q   */
-      ierr = VecAYPX(P,beta,U);CHKERRQ(ierr);    /*     p <- u + beta * p   */
-      ierr = VecAYPX(S,beta,W);CHKERRQ(ierr);    /*     s <- w + beta * s   */
     }
-    ierr = VecAXPY(X, alpha,P);CHKERRQ(ierr);    /*     x <- x + alpha * p   */
-    ierr = VecAXPY(U,-alpha,Q);CHKERRQ(ierr);    /*     u <- u - alpha * q   */
-    ierr = VecAXPY(W,-alpha,Z);CHKERRQ(ierr);    /*     w <- w - alpha * z   */
-    ierr = VecAXPY(R,-alpha,S);CHKERRQ(ierr);    /*     r <- r - alpha * s   */
+    for (k=0; k<4; k++) {
+      ualpha[k]   = 1.0;    ubeta[k]   = beta;
+      ualpha[k+4] = -alpha; ubeta[k+4] = 1.0;
+    }
+    ualpha[4] = alpha;
+    nd = (i+1 < ksp->max_it) ? ndnext : 0;          /* no reductions are needed after the last iteration */
+    ierr = VecMultiAXPBYDotBegin(8,up,ualpha,ubeta,ux,nd,dx,dy,PETSC_NULL);CHKERRQ(ierr);
     gammaold = gamma;
     i++;
     ksp->its = i;
@@ -54,8 +54,10 @@ static PetscErrorCode KSPPGMRESCycle(PetscInt *itcount,KSP ksp)
   KSP_PGMRES     *pgmres = (KSP_PGMRES*)(ksp->data);
   PetscReal      res_norm,res,newnorm;
   PetscErrorCode ierr;
-  PetscInt       it = 0,j,k;
+  PetscInt       it = 0,j,k,mu;
   PetscBool      hapend = PETSC_FALSE;
+  PetscScalar    *work,*ubeta;
+  Vec            *up,*ux,*dx,*dy;
 
   PetscFunctionBegin;
   if (itcount) *itcount = 0;
@@ -77,8 +79,12 @@ static PetscErrorCode KSPPGMRESCycle(PetscInt *itcount,KSP ksp)
   }
 
   ierr = (*ksp->converged)(ksp,ksp->its,res,&ksp->reason,ksp->cnvP);CHKERRQ(ierr);
+  /* work space for the fused vector updates and reductions at the end of each iteration */
+  mu   = 2*pgmres->max_k+5;
+  ierr = PetscMalloc6(mu,PetscScalar,&work,mu,PetscScalar,&ubeta,mu,Vec,&up,mu,Vec,&ux,mu,Vec,&dx,mu,Vec,&dy);CHKERRQ(ierr);
   for ( ; !ksp->reason; it++) {
-    Vec Zcur,Znext;
+    Vec      Zcur,Znext;
+    PetscInt nu,nd;
     if (pgmres->vv_allocated <= it + VEC_OFFSET + 1) {
       ierr = KSPGMRESGetNewVectors(ksp,it+1);CHKERRQ(ierr);
     }
@@ -130,10 +136,9 @@ static PetscErrorCode KSPPGMRESCycle(PetscInt *itcount,KSP ksp)
       *HH(it-1,it-1) /= *HH(it-1,it-2);
     }
 
+    nu = 0;
+    nd = 0;
     if (it > 0) {
-      PetscScalar *work;
-      if (!pgmres->orthogwork) {ierr = PetscMalloc((pgmres->max_k + 2)*sizeof(PetscScalar),&pgmres->orthogwork);CHKERRQ(ierr);}
-      work = pgmres->orthogwork;
       /* Apply correction computed by the VecMDot in the last iteration to Znext. The original form is
        *
        *   Znext -= sum_{j=0}^{i-1} Z[j+1] * H[j,i-1]
@@ -156,25 +161,33 @@ static PetscErrorCode KSPPGMRESCycle(PetscInt *itcount,KSP ksp)
       for (k=0; k<it+1; k++) {
         work[k] = 0;
         for (j=PetscMax(0,k-1); j<it-1; j++) work[k] -= *HES(k,j) * *HH(j,it-1);
+        up[k] = Znext; ux[k] = VEC_VV(k); ubeta[k] = 1.0;
       }
-      ierr = VecMAXPY(Znext,it+1,work,&VEC_VV(0));CHKERRQ(ierr);
-      ierr = VecAXPY(Znext,-*HH(it-1,it-1),Zcur);CHKERRQ(ierr);
+      work[it] -= *HH(it-1,it-1);   /* VEC_VV(it) is Zcur */
 
       /* Orthogonalize Zcur against existing basis vectors. */
-      for (k=0; k<it; k++) work[k] = - *HH(k,it-1);
-      ierr = VecMAXPY(Zcur,it,work,&VEC_VV(0));CHKERRQ(ierr);
+      for (k=0; k<it; k++) {
+        work[it+1+k] = - *HH(k,it-1);
+        up[it+1+k] = Zcur; ux[it+1+k] = VEC_VV(k); ubeta[it+1+k] = 1.0;
+      }
+      nu = 2*it+1;
       /* Zcur is now orthogonal, and will be referred to as VEC_VV(it) again, though it is still not normalized. */
       /* Begin computing the norm of the new vector, will be normalized after the MatMult in the next iteration. */
-      ierr = VecNormBegin(VEC_VV(it),NORM_2,&newnorm);CHKERRQ(ierr);
+      dx[nd] = Zcur; dy[nd++] = Zcur;
     }
 
     /* Compute column of H (to the diagonal, but not the subdiagonal) to be able to orthogonalize the newest vector. */
-    ierr = VecMDotBegin(Znext,it+1,&VEC_VV(0),HH(0,it));CHKERRQ(ierr);
+    for (k=0; k<it+1; k++) {
+      dx[nd] = Znext; dy[nd++] = VEC_VV(k);
+    }
+    /* Both updates and the local parts of the norm and the dot products are done in a single pass over the vectors */
+    ierr = VecMultiAXPBYDotBegin(nu,up,work,ubeta,ux,nd,dx,dy,PETSC_NULL);CHKERRQ(ierr);
 
     /* Start an asynchronous split-mode reduction, the result of the MDot and Norm will be collected on the next iteration. */
     ierr = PetscCommSplitReductionBegin(((PetscObject)Znext)->comm);CHKERRQ(ierr);
   }
 
+  ierr = PetscFree6(work,ubeta,up,ux,dx,dy);CHKERRQ(ierr);
   if (itcount) *itcount = it-1; /* Number of iterations actually completed. */
 
   /*
@@ -145,7 +145,10 @@ EXTERN_C_END
 .  -pc_factor_in_place - only for ICC(0) with natural ordering, reuses the space of the matrix for
                       its factorization (overwrites original matrix)
 .  -pc_factor_fill <nfill> - expected amount of fill in factored matrix compared to original matrix, nfill > 1
--  -pc_factor_mat_ordering_type <natural,nd,1wd,rcm,qmd> - set the row/column ordering of the factored matrix
+.  -pc_factor_mat_ordering_type <natural,nd,1wd,rcm,qmd> - set the row/column ordering of the factored matrix
+.  -mat_solve_levels - for AIJ and SBAIJ matrices with block size 1, apply the factor with level scheduled triangular
+                      solves that use all the threads of the thread communicator
+-  -mat_solve_levels_syncfree - the same, threads wait for the rows they depend on instead of for each level
 
    Level: beginner
 
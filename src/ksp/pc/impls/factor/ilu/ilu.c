@@ -323,6 +323,9 @@ static PetscErrorCode PCApplySymmetricRight_ILU(PC pc,Vec x,Vec y)
 .  -pc_factor_pivot_in_blocks - for block ILU(k) factorization, i.e. with BAIJ matrices with block size larger
                              than 1 the diagonal blocks are factored with partial pivoting (this increases the
                              stability of the ILU factorization
+.  -mat_solve_levels - for AIJ matrices, apply the factors with level scheduled triangular solves that use all the
+                      threads of the thread communicator
+-  -mat_solve_levels_syncfree - the same, threads wait for the rows they depend on instead of for each level
 
    Level: beginner
 
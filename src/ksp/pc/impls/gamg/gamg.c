@@ -20,8 +20,6 @@ PetscLogEvent PC_GAMGOptprol_AGG;
 PetscLogEvent PC_GAMGKKTProl_AGG;
 #endif
 
-#define GAMG_MAXLEVELS 30
-
 /* #define GAMG_STAGES */
 #if (defined PETSC_GAMG_USE_LOG && defined GAMG_STAGES)
 static PetscLogStage gamg_stages[GAMG_MAXLEVELS];
@@ -29,6 +27,119 @@ static PetscLogStage gamg_stages[GAMG_MAXLEVELS];
 
 static PetscFunctionList GAMGList = 0;
 
+/* ----------------------------------------------------------------------------- */
+#undef __FUNCT__
+#define __FUNCT__ "PCGAMGResetReuse_Private"
+/* forgets what is kept from one setup to the next one when the prolongators are reused */
+static PetscErrorCode PCGAMGResetReuse_Private(PC pc)
+{
+  PetscErrorCode  ierr;
+  PC_MG           *mg = (PC_MG*)pc->data;
+  PC_GAMG         *pc_gamg = (PC_GAMG*)mg->innerctx;
+  PetscInt        level;
+
+  PetscFunctionBegin;
+  for (level=0; level<GAMG_MAXLEVELS; level++) {
+    ierr = VecDestroy(&pc_gamg->eig_vec[level]);CHKERRQ(ierr);
+    pc_gamg->ptap_kept[level] = PETSC_FALSE;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PCGAMGEstimateEigen_Private"
+/*
+   PCGAMGEstimateEigen_Private - estimates the extreme eigenvalues of Lmat preconditioned by subpc with its iterations
+   of a Krylov method.
+
+   If warm is given, the random start vector is enriched with *warm when it exists, and *warm is replaced by the start
+   vector after one step of the power method with the preconditioned operator, so that a later estimate for a slightly
+   different operator needs fewer iterations.
+*/
+static PetscErrorCode PCGAMGEstimateEigen_Private(PC pc,Mat Lmat,PC subpc,PetscInt its,Vec *warm,PetscReal *emax,PetscReal *emin)
+{
+  PetscErrorCode  ierr;
+  MPI_Comm        wcomm = ((PetscObject)pc)->comm;
+  KSP             eksp;
+  Vec             bb, xx;
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(Lmat, &bb, 0);CHKERRQ(ierr);
+  ierr = MatGetVecs(Lmat, &xx, 0);CHKERRQ(ierr);
+  {
+    {
+      PetscRandom    rctx;
+      ierr = PetscRandomCreate(wcomm,&rctx);CHKERRQ(ierr);
+      ierr = PetscRandomSetFromOptions(rctx);CHKERRQ(ierr);
+      ierr = VecSetRandom(bb,rctx);CHKERRQ(ierr);
+      ierr = PetscRandomDestroy(&rctx);CHKERRQ(ierr);
+    }
+
+    /* zeroing out BC rows -- needed for crazy matrices */
+    {
+      PetscInt Istart,Iend,ncols,jj,Ii;
+      PetscScalar zero = 0.0;
+      ierr = MatGetOwnershipRange(Lmat, &Istart, &Iend);CHKERRQ(ierr);
+      for (Ii = Istart, jj = 0 ; Ii < Iend ; Ii++, jj++) {
+        ierr = MatGetRow(Lmat,Ii,&ncols,0,0);CHKERRQ(ierr);
+        if(ncols <= 1) {
+          ierr = VecSetValues(bb, 1, &Ii, &zero, INSERT_VALUES);CHKERRQ(ierr);
+        }
+        ierr = MatRestoreRow(Lmat,Ii,&ncols,0,0);CHKERRQ(ierr);
+      }
+      ierr = VecAssemblyBegin(bb);CHKERRQ(ierr);
+      ierr = VecAssemblyEnd(bb);CHKERRQ(ierr);
+    }
+  }
+  if (warm && *warm) {
+    /* the random part keeps the whole spectrum in the Krylov space, the warm part its upper end */
+    ierr = VecNormalize(bb, PETSC_NULL);CHKERRQ(ierr);
+    ierr = VecAXPY(bb, 1.0, *warm);CHKERRQ(ierr);
+  }
+
+  ierr = KSPCreate(wcomm, &eksp);CHKERRQ(ierr);
+  ierr = KSPSetTolerances(eksp, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT, its);CHKERRQ(ierr);
+  ierr = KSPSetNormType(eksp, KSP_NORM_NONE);CHKERRQ(ierr);
+  ierr = KSPSetOptionsPrefix(eksp,((PetscObject)pc)->prefix);CHKERRQ(ierr);
+  ierr = KSPAppendOptionsPrefix(eksp, "gamg_est_");CHKERRQ(ierr);
+  ierr = KSPSetFromOptions(eksp);CHKERRQ(ierr);
+
+  ierr = KSPSetInitialGuessNonzero(eksp, PETSC_FALSE);CHKERRQ(ierr);
+  ierr = KSPSetOperators(eksp, Lmat, Lmat, SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = KSPSetComputeSingularValues(eksp,PETSC_TRUE);CHKERRQ(ierr);
+
+  /* set PC type to be same as smoother */
+  ierr = KSPSetPC(eksp, subpc);CHKERRQ(ierr);
+
+  /* solve - keep stuff out of logging */
+  ierr = PetscLogEventDeactivate(KSP_Solve);CHKERRQ(ierr);
+  ierr = PetscLogEventDeactivate(PC_Apply);CHKERRQ(ierr);
+  ierr = KSPSolve(eksp, bb, xx);CHKERRQ(ierr);
+  ierr = PetscLogEventActivate(KSP_Solve);CHKERRQ(ierr);
+  ierr = PetscLogEventActivate(PC_Apply);CHKERRQ(ierr);
+
+  ierr = KSPComputeExtremeSingularValues(eksp, emax, emin);CHKERRQ(ierr);
+
+  if (warm) {
+    /* one step of the power method enriches the start vector in the eigenvectors of the largest eigenvalues */
+    PetscReal nrm;
+    ierr = MatMult(Lmat, bb, xx);CHKERRQ(ierr);
+    ierr = PCApply(subpc, xx, bb);CHKERRQ(ierr);
+    ierr = VecNormalize(bb, &nrm);CHKERRQ(ierr);
+    if (nrm > 0.0) {
+      if (!*warm) {
+        ierr = VecDuplicate(bb, warm);CHKERRQ(ierr);
+      }
+      ierr = VecCopy(bb, *warm);CHKERRQ(ierr);
+    }
+  }
+
+  ierr = VecDestroy(&xx);CHKERRQ(ierr);
+  ierr = VecDestroy(&bb);CHKERRQ(ierr);
+  ierr = KSPDestroy(&eksp);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /* ----------------------------------------------------------------------------- */
 #undef __FUNCT__
 #define __FUNCT__ "PCReset_GAMG"
@@ -48,6 +159,7 @@ PetscErrorCode PCReset_GAMG(PC pc)
   if (pc_gamg->orig_data) {
     ierr = PetscFree(pc_gamg->orig_data);CHKERRQ(ierr);
   }
+  ierr = PCGAMGResetReuse_Private(pc);CHKERRQ(ierr);
 
   PetscFunctionReturn(0);
 }
@@ -539,7 +651,7 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
   PetscInt         fine_level,level,level1,bs,M,qq,lidx,nASMBlocksArr[GAMG_MAXLEVELS];
   MPI_Comm         wcomm = ((PetscObject)pc)->comm;
   PetscMPIInt      mype,npe,nactivepe;
-  Mat              Aarr[GAMG_MAXLEVELS],Parr[GAMG_MAXLEVELS];
+  Mat              Aarr[GAMG_MAXLEVELS],Parr[GAMG_MAXLEVELS],Pold;
   PetscReal        emaxs[GAMG_MAXLEVELS];
   IS              *ASMLocalIDsArr[GAMG_MAXLEVELS];
   GAMGKKTMat       kktMatsArr[GAMG_MAXLEVELS];
@@ -562,6 +674,7 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
       PC_MG_Levels **mglevels = mg->levels;
       /* just do Galerkin grids */
       Mat B,dA,dB;
+      PetscInt nreused = 0, nrefreshed = 0;
       assert(pc->setupcalled);
 
       if (pc_gamg->Nlevels > 1) {
@@ -571,14 +684,16 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
         ierr = KSPSetOperators(mglevels[pc_gamg->Nlevels-1]->smoothd,dA,dB,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
 
         for (level=pc_gamg->Nlevels-2; level>-1; level--) {
-          /* the first time through the matrix structure has changed from repartitioning */
-          if (pc_gamg->setup_count==2 /*&& (pc_gamg->repart || level==0)*/) {
+          /* the first time through the matrix structure has changed from repartitioning, unless the coarse
+             operator is still the one made by MatPtAP() so only its numeric part needs to be redone */
+          if (pc_gamg->setup_count==2 && !pc_gamg->ptap_kept[pc_gamg->Nlevels-1-level]) {
             ierr = MatPtAP(dB,mglevels[level+1]->interpolate,MAT_INITIAL_MATRIX,1.0,&B);CHKERRQ(ierr);
             ierr = MatDestroy(&mglevels[level]->A);CHKERRQ(ierr);
             mglevels[level]->A = B;
           } else {
             ierr = KSPGetOperators(mglevels[level]->smoothd,PETSC_NULL,&B,PETSC_NULL);CHKERRQ(ierr);
             ierr = MatPtAP(dB,mglevels[level+1]->interpolate,MAT_REUSE_MATRIX,1.0,&B);CHKERRQ(ierr);
+            nreused++;
           }
           ierr = KSPSetOperators(mglevels[level]->smoothd,B,B,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
           dB = B;
@@ -590,10 +705,52 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
       /* PCSetUp_MG seems to insists on setting this to GMRES */
       ierr = KSPSetType(mglevels[0]->smoothd, KSPPREONLY);CHKERRQ(ierr);
 
+      /* the operators changed, so the Chebyshev bounds of the first setup can be stale */
+      if (pc_gamg->refresh_eig) {
+        for (lidx = 1; lidx < pc_gamg->Nlevels; lidx++) {
+          KSP       smoother;
+          PC        subpc;
+          PetscBool flag;
+          PetscReal emax, emin;
+
+          ierr = PCMGGetSmoother(pc, lidx, &smoother);CHKERRQ(ierr);
+          ierr = KSPGetPC(smoother, &subpc);CHKERRQ(ierr);
+          ierr = PetscObjectTypeCompare((PetscObject)subpc, PCFIELDSPLIT, &flag);CHKERRQ(ierr);
+          if (flag) {
+            KSP *ksps;
+            PetscInt nn;
+            ierr = PCFieldSplitGetSubKSP(subpc,&nn,&ksps);CHKERRQ(ierr);
+            smoother = ksps[0];
+            ierr = KSPGetPC(smoother, &subpc);CHKERRQ(ierr);
+            ierr = PetscFree(ksps);CHKERRQ(ierr);
+          }
+          ierr = PetscObjectTypeCompare((PetscObject)smoother, KSPCHEBYSHEV, &flag);CHKERRQ(ierr);
+          if (!flag) continue;
+          ierr = KSPGetOperators(smoother,PETSC_NULL,&B,PETSC_NULL);CHKERRQ(ierr);
+          ierr = PCSetUp(subpc);CHKERRQ(ierr);
+          ierr = PCGAMGEstimateEigen_Private(pc, B, subpc, pc_gamg->eig_vec[lidx] ? pc_gamg->refresh_eig_its : 10, &pc_gamg->eig_vec[lidx], &emax, &emin);CHKERRQ(ierr);
+          if (pc_gamg->verbose > 0) {
+            PetscInt N1;
+            ierr = MatGetSize(B, &N1, PETSC_NULL);CHKERRQ(ierr);
+            PetscPrintf(wcomm,"\t\t\t%s PC refresh max eigen=%e min=%e on level %d (N=%d)\n",__FUNCT__,emax,emin,lidx,N1);
+          }
+          emin = emax * pc_gamg->eigtarget[0];
+          emax *= pc_gamg->eigtarget[1];
+          ierr = KSPChebyshevSetEigenvalues(smoother, emax, emin);CHKERRQ(ierr);
+          nrefreshed++;
+        }
+      }
+
+      ierr = PetscInfo4(pc,"Reused the prolongators of %D levels, %D of %D coarse operators only needed a numeric MatPtAP(), refreshed %D eigen estimates\n",pc_gamg->Nlevels-1,nreused,pc_gamg->Nlevels-1,nrefreshed);CHKERRQ(ierr);
+      if (pc_gamg->verbose > 0) {
+        PetscPrintf(wcomm,"\t[%d]%s reused prolongators on %d levels, numeric PtAP on %d of %d levels, %s eigen estimates (%d refreshed)\n",mype,__FUNCT__,pc_gamg->Nlevels-1,nreused,pc_gamg->Nlevels-1,pc_gamg->refresh_eig ? "refreshed" : "kept",nrefreshed);
+      }
       PetscFunctionReturn(0);
     }
   }
 
+  ierr = PCGAMGResetReuse_Private(pc);CHKERRQ(ierr);
+
   ierr = PetscOptionsGetBool(((PetscObject)pc)->prefix,"-pc_fieldsplit_detect_saddle_point",&stokes,PETSC_NULL);CHKERRQ(ierr);
 
   ierr = GAMGKKTMatCreate(Pmat, stokes, &kktMatsArr[0]);CHKERRQ(ierr);
@@ -725,8 +882,11 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
     ierr = PetscLogEventBegin(petsc_gamg_setup_events[SET2],0,0,0,0);CHKERRQ(ierr);
 #endif
 
+    Pold = Parr[level1];
     ierr = createLevel(pc, Aarr[level], bs, (PetscBool)(level==pc_gamg->Nlevels-2),
                         stokes, &Parr[level1], &Aarr[level1], &nactivepe);CHKERRQ(ierr);
+    /* repartitioning replaces both the coarse operator and the prolongator */
+    pc_gamg->ptap_kept[level1] = (PetscBool)(Parr[level1] == Pold && (level == 0 || pc_gamg->ptap_kept[level]));
 
 #if defined PETSC_GAMG_USE_LOG
     ierr = PetscLogEventEnd(petsc_gamg_setup_events[SET2],0,0,0,0);CHKERRQ(ierr);
@@ -895,62 +1055,7 @@ PetscErrorCode PCSetUp_GAMG(PC pc)
         ierr = PetscObjectTypeCompare((PetscObject)subpc, PCJACOBI, &flag);CHKERRQ(ierr);
         if (flag && emaxs[level] > 0.0) emax=emaxs[level]; /* eigen estimate only for diagnal PC */
         else{ /* eigen estimate 'emax' */
-          KSP eksp;
-          Mat Lmat = Aarr[level];
-          Vec bb, xx;
-
-          ierr = MatGetVecs(Lmat, &bb, 0);CHKERRQ(ierr);
-          ierr = MatGetVecs(Lmat, &xx, 0);CHKERRQ(ierr);
-          {
-            PetscRandom    rctx;
-            ierr = PetscRandomCreate(wcomm,&rctx);CHKERRQ(ierr);
-            ierr = PetscRandomSetFromOptions(rctx);CHKERRQ(ierr);
-            ierr = VecSetRandom(bb,rctx);CHKERRQ(ierr);
-            ierr = PetscRandomDestroy(&rctx);CHKERRQ(ierr);
-          }
-
-          /* zeroing out BC rows -- needed for crazy matrices */
-          {
-            PetscInt Istart,Iend,ncols,jj,Ii;
-            PetscScalar zero = 0.0;
-            ierr = MatGetOwnershipRange(Lmat, &Istart, &Iend);CHKERRQ(ierr);
-            for (Ii = Istart, jj = 0 ; Ii < Iend ; Ii++, jj++) {
-              ierr = MatGetRow(Lmat,Ii,&ncols,0,0);CHKERRQ(ierr);
-              if(ncols <= 1) {
-                ierr = VecSetValues(bb, 1, &Ii, &zero, INSERT_VALUES);CHKERRQ(ierr);
-              }
-              ierr = MatRestoreRow(Lmat,Ii,&ncols,0,0);CHKERRQ(ierr);
-            }
-            ierr = VecAssemblyBegin(bb);CHKERRQ(ierr);
-            ierr = VecAssemblyEnd(bb);CHKERRQ(ierr);
-          }
-
-          ierr = KSPCreate(wcomm, &eksp);CHKERRQ(ierr);
-          ierr = KSPSetTolerances(eksp, PETSC_DEFAULT, PETSC_DEFAULT, PETSC_DEFAULT, 10);CHKERRQ(ierr);
-          ierr = KSPSetNormType(eksp, KSP_NORM_NONE);CHKERRQ(ierr);
-          ierr = KSPSetOptionsPrefix(eksp,((PetscObject)pc)->prefix);CHKERRQ(ierr);
-          ierr = KSPAppendOptionsPrefix(eksp, "gamg_est_");CHKERRQ(ierr);
-          ierr = KSPSetFromOptions(eksp);CHKERRQ(ierr);
-
-          ierr = KSPSetInitialGuessNonzero(eksp, PETSC_FALSE);CHKERRQ(ierr);
-          ierr = KSPSetOperators(eksp, Lmat, Lmat, SAME_NONZERO_PATTERN);CHKERRQ(ierr);
-          ierr = KSPSetComputeSingularValues(eksp,PETSC_TRUE);CHKERRQ(ierr);
-
-          /* set PC type to be same as smoother */
-          ierr = KSPSetPC(eksp, subpc);CHKERRQ(ierr);
-
-          /* solve - keep stuff out of logging */
-          ierr = PetscLogEventDeactivate(KSP_Solve);CHKERRQ(ierr);
-          ierr = PetscLogEventDeactivate(PC_Apply);CHKERRQ(ierr);
-          ierr = KSPSolve(eksp, bb, xx);CHKERRQ(ierr);
-          ierr = PetscLogEventActivate(KSP_Solve);CHKERRQ(ierr);
-          ierr = PetscLogEventActivate(PC_Apply);CHKERRQ(ierr);
-
-          ierr = KSPComputeExtremeSingularValues(eksp, &emax, &emin);CHKERRQ(ierr);
-
-          ierr = VecDestroy(&xx);CHKERRQ(ierr);
-          ierr = VecDestroy(&bb);CHKERRQ(ierr);
-          ierr = KSPDestroy(&eksp);CHKERRQ(ierr);
+          ierr = PCGAMGEstimateEigen_Private(pc, Aarr[level], subpc, 10, pc_gamg->refresh_eig ? &pc_gamg->eig_vec[lidx] : PETSC_NULL, &emax, &emin);CHKERRQ(ierr);
 
           if (pc_gamg->verbose > 0) {
             PetscInt N1, tt;
@@ -1199,6 +1304,59 @@ PetscErrorCode PCGAMGSetReuseProl_GAMG(PC pc, PetscBool n)
 }
 EXTERN_C_END
 
+#undef __FUNCT__
+#define __FUNCT__ "PCGAMGSetRefreshEigenEstimates"
+/*@
+   PCGAMGSetRefreshEigenEstimates - Re-estimate the eigenvalues used by the Chebyshev smoothers when the
+   prolongators are reused for a new matrix
+
+   Collective on PC
+
+   Input Parameters:
++  pc - the preconditioner context
+-  n - PETSC_TRUE to refresh the estimates
+
+   Options Database Keys:
++  -pc_gamg_refresh_eigen_estimates - refresh the estimates
+-  -pc_gamg_refresh_eigen_its <its> - number of iterations of each refreshed estimate (default 7)
+
+   Notes:
+   The estimates of a new setup start from the vectors kept by the previous one, so a few iterations suffice when the
+   matrix changes slowly. The aggregates, prolongators and the symbolic part of the Galerkin products are reused as
+   with PCGAMGSetReuseProl(). Use -info to see what has been reused.
+
+   The refreshed estimates replace the ones of -mg_levels_ksp_chebyshev_estimate_eigenvalues.
+
+   Level: intermediate
+
+   Concepts: Unstructured multrigrid preconditioner
+
+.seealso: PCGAMGSetReuseProl()
+@*/
+PetscErrorCode PCGAMGSetRefreshEigenEstimates(PC pc, PetscBool n)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(pc,PC_CLASSID,1);
+  ierr = PetscTryMethod(pc,"PCGAMGSetRefreshEigenEstimates_C",(PC,PetscBool),(pc,n));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "PCGAMGSetRefreshEigenEstimates_GAMG"
+PetscErrorCode PCGAMGSetRefreshEigenEstimates_GAMG(PC pc, PetscBool n)
+{
+  PC_MG           *mg = (PC_MG*)pc->data;
+  PC_GAMG         *pc_gamg = (PC_GAMG*)mg->innerctx;
+
+  PetscFunctionBegin;
+  pc_gamg->refresh_eig = n;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
 #undef __FUNCT__
 #define __FUNCT__ "PCGAMGSetUseASMAggs"
 /*@
@@ -1408,6 +1566,20 @@ PetscErrorCode PCSetFromOptions_GAMG(PC pc)
                             pc_gamg->reuse_prol,
                             &pc_gamg->reuse_prol,
                             &flag);CHKERRQ(ierr);
+    /* -pc_gamg_refresh_eigen_estimates */
+    ierr = PetscOptionsBool("-pc_gamg_refresh_eigen_estimates",
+                            "Re-estimate the Chebyshev eigenvalues when the prolongation is reused (false)",
+                            "PCGAMGSetRefreshEigenEstimates",
+                            pc_gamg->refresh_eig,
+                            &pc_gamg->refresh_eig,
+                            &flag);CHKERRQ(ierr);
+    /* -pc_gamg_refresh_eigen_its */
+    ierr = PetscOptionsInt("-pc_gamg_refresh_eigen_its",
+                           "Number of iterations of a warm started eigen estimate (7)",
+                           "PCGAMGSetRefreshEigenEstimates",
+                           pc_gamg->refresh_eig_its,
+                           &pc_gamg->refresh_eig_its,
+                           &flag);CHKERRQ(ierr);
     /* -pc_gamg_use_agg_gasm */
     ierr = PetscOptionsBool("-pc_gamg_use_agg_gasm",
                             "Use aggregation agragates for GASM smoother (false)",
@@ -1532,6 +1704,10 @@ PetscErrorCode  PCCreate_GAMG(PC pc)
                                             "PCGAMGSetReuseProl_C",
                                             "PCGAMGSetReuseProl_GAMG",
                                             PCGAMGSetReuseProl_GAMG);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)pc,
+                                            "PCGAMGSetRefreshEigenEstimates_C",
+                                            "PCGAMGSetRefreshEigenEstimates_GAMG",
+                                            PCGAMGSetRefreshEigenEstimates_GAMG);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)pc,
                                             "PCGAMGSetUseASMAggs_C",
                                             "PCGAMGSetUseASMAggs_GAMG",
@@ -1546,6 +1722,8 @@ PetscErrorCode  PCCreate_GAMG(PC pc)
                                             PCGAMGSetType_GAMG);CHKERRQ(ierr);
   pc_gamg->repart = PETSC_FALSE;
   pc_gamg->reuse_prol = PETSC_TRUE;
+  pc_gamg->refresh_eig = PETSC_FALSE;
+  pc_gamg->refresh_eig_its = 7;
   pc_gamg->use_aggs_in_gasm = PETSC_FALSE;
   pc_gamg->min_eq_proc = 100;
   pc_gamg->coarse_eq_limit = 800;
@@ -6,12 +6,18 @@
 #include <../src/mat/impls/aij/mpi/mpiaij.h>
 #include <assert.h>
 
+#define GAMG_MAXLEVELS 30
+
 /* Private context for the GAMG preconditioner */
 typedef struct gamg_TAG{
   PetscInt       Nlevels;
   PetscInt       setup_count;
   PetscBool      repart;
   PetscBool      reuse_prol;
+  PetscBool      refresh_eig; /* re-estimate the eigenvalues for the Chebyshev smoothers when the prolongators are reused */
+  PetscInt       refresh_eig_its;
+  PetscBool      ptap_kept[GAMG_MAXLEVELS]; /* coarse operator of level k is the result of MatPtAP(), so MAT_REUSE_MATRIX can be used */
+  Vec            eig_vec[GAMG_MAXLEVELS];   /* start vector of the eigen estimate on PCMG level k, for warm starts */
   PetscBool      use_aggs_in_gasm;
   PetscInt       min_eq_proc;
   PetscInt       coarse_eq_limit;
@@ -6,13 +6,27 @@
 
 #include <petsc-private/matimpl.h>
 #include <petsc-private/pcimpl.h>   /*I "petscpc.h" I*/
+#include <../src/mat/blockinvert.h>
+
+/*
+   Number of blocks that are applied together by PCApply_PBJacobi_Batched(); each block is one lane
+*/
+#define PC_PBJACOBI_LANES 8
 
 /*
    Private context (data structure) for the PBJacobi preconditioner.
+
+   Blocks larger than 7 and blocks of varying size are stored in batches of up to PC_PBJACOBI_LANES
+   consecutive blocks of the same size. Within a batch the entries are interleaved: entry (r,c) of the
+   inverse of block l of the batch is values[(r+bs*c)*PC_PBJACOBI_LANES+l], unused lanes are zero.
 */
 typedef struct {
   const MatScalar *diag;
-  PetscInt    bs,mbs;
+  PetscInt        bs,mbs;
+  PetscInt        nblocks,*bsizes;     /* block sizes set with PCPBJacobiSetBlockSizes() */
+  PetscInt        nbatch,*batchbs,*batchnb; /* number of batches, the block size and number of blocks in each */
+  MatScalar       *values;             /* the interleaved inverses of the blocks */
+  PetscScalar     *work;               /* interleaved input and output of one batch */
 } PC_PBJacobi;
 
 
@@ -199,6 +213,144 @@ static PetscErrorCode PCApply_PBJacobi_7(PC pc,Vec x,Vec y)
   PetscFunctionReturn(0);
 }
 /* -------------------------------------------------------------------------- */
+#undef __FUNCT__
+#define __FUNCT__ "PCApply_PBJacobi_Batched"
+/*
+   Applies the batched inverses; the innermost loops run over the lanes with a fixed trip count so the
+   compiler vectorizes them with one block per vector lane
+*/
+static PetscErrorCode PCApply_PBJacobi_Batched(PC pc,Vec x,Vec y)
+{
+  PC_PBJacobi       *jac = (PC_PBJacobi*)pc->data;
+  PetscErrorCode    ierr;
+  const MatScalar   *d = jac->values;
+  const PetscScalar *xx,*xb;
+  PetscScalar       *yy,*yb,*xw = jac->work,*yw;
+  PetscInt          b,bs,nb,r,c,l;
+  PetscLogDouble    flops = 0.0;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(x,&xx);CHKERRQ(ierr);
+  ierr = VecGetArray(y,&yy);CHKERRQ(ierr);
+  xb = xx; yb = yy;
+  for (b=0; b<jac->nbatch; b++) {
+    bs = jac->batchbs[b];
+    nb = jac->batchnb[b];
+    yw = xw + bs*PC_PBJACOBI_LANES;
+    for (c=0; c<bs; c++) {
+      for (l=0; l<nb; l++) xw[c*PC_PBJACOBI_LANES+l] = xb[l*bs+c];
+      for (; l<PC_PBJACOBI_LANES; l++) xw[c*PC_PBJACOBI_LANES+l] = 0.0;
+    }
+    for (r=0; r<bs*PC_PBJACOBI_LANES; r++) yw[r] = 0.0;
+    for (c=0; c<bs; c++) {
+      for (r=0; r<bs; r++) {
+        for (l=0; l<PC_PBJACOBI_LANES; l++) yw[r*PC_PBJACOBI_LANES+l] += d[l]*xw[c*PC_PBJACOBI_LANES+l];
+        d += PC_PBJACOBI_LANES;
+      }
+    }
+    for (r=0; r<bs; r++) {
+      for (l=0; l<nb; l++) yb[l*bs+r] = yw[r*PC_PBJACOBI_LANES+l];
+    }
+    xb    += bs*nb;
+    yb    += bs*nb;
+    flops += (2.0*bs-1.0)*bs*nb;
+  }
+  ierr = VecRestoreArrayRead(x,&xx);CHKERRQ(ierr);
+  ierr = VecRestoreArray(y,&yy);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PCPBJacobiSetUpBatches"
+/*
+   Groups the blocks into batches and stores their inverses interleaved. The inverses come from
+   MatInvertBlockDiagonal() (stored by columns) when the blocks all have size bs, otherwise each block is
+   extracted with MatGetValues() and inverted here.
+*/
+static PetscErrorCode PCPBJacobiSetUpBatches(PC pc,PetscInt n,const PetscInt bsizes[],PetscInt bs)
+{
+  PC_PBJacobi    *jac = (PC_PBJacobi*)pc->data;
+  Mat            A = pc->pmat;
+  PetscErrorCode ierr;
+  PetscInt       i,b,l,r,c,nbatch,size,maxbs,nvalues,rstart,row,*idx = 0,*pivots = 0;
+  PetscScalar    *vals = 0;
+  MatScalar      *blk = 0,*work = 0,*d;
+  const MatScalar *inv;
+
+  PetscFunctionBegin;
+  /* count the batches: runs of consecutive blocks of the same size, at most PC_PBJACOBI_LANES each */
+  nbatch = 0; maxbs = 0; nvalues = 0;
+  for (i=0; i<n; i+=l) {
+    size = bsizes ? bsizes[i] : bs;
+    for (l=1; l<PC_PBJACOBI_LANES && i+l<n && (bsizes ? bsizes[i+l] : bs) == size; l++) ;
+    nbatch++;
+    maxbs    = PetscMax(maxbs,size);
+    nvalues += size*size*PC_PBJACOBI_LANES;
+  }
+  jac->nbatch = nbatch;
+  ierr = PetscMalloc2(nbatch,PetscInt,&jac->batchbs,nbatch,PetscInt,&jac->batchnb);CHKERRQ(ierr);
+  ierr = PetscMalloc(nvalues*sizeof(MatScalar),&jac->values);CHKERRQ(ierr);
+  ierr = PetscMemzero(jac->values,nvalues*sizeof(MatScalar));CHKERRQ(ierr);
+  ierr = PetscMalloc(2*maxbs*PC_PBJACOBI_LANES*sizeof(PetscScalar),&jac->work);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(pc,2*nbatch*sizeof(PetscInt)+nvalues*sizeof(MatScalar)+2*maxbs*PC_PBJACOBI_LANES*sizeof(PetscScalar));CHKERRQ(ierr);
+  if (bsizes) {
+    ierr = PetscMalloc5(maxbs,PetscInt,&idx,maxbs,PetscInt,&pivots,maxbs*maxbs,PetscScalar,&vals,maxbs*maxbs,MatScalar,&blk,maxbs,MatScalar,&work);CHKERRQ(ierr);
+  }
+  ierr = MatGetOwnershipRange(A,&rstart,PETSC_NULL);CHKERRQ(ierr);
+
+  i   = 0;
+  row = rstart;
+  d   = jac->values;
+  inv = jac->diag;
+  for (b=0; b<nbatch; b++) {
+    size = bsizes ? bsizes[i] : bs;
+    for (l=0; l<PC_PBJACOBI_LANES && i<n && (bsizes ? bsizes[i] : bs) == size; l++,i++) {
+      if (bsizes) {
+        /* the values come back by rows, inverting them in place as if stored by columns gives the inverse by rows */
+        for (r=0; r<size; r++) idx[r] = row + r;
+        ierr = MatGetValues(A,size,idx,size,idx,vals);CHKERRQ(ierr);
+        for (r=0; r<size*size; r++) blk[r] = vals[r];
+        ierr = PetscKernel_A_gets_inverse_A(size,blk,pivots,work);CHKERRQ(ierr);
+        for (c=0; c<size; c++) {
+          for (r=0; r<size; r++) d[(r+size*c)*PC_PBJACOBI_LANES+l] = blk[r*size+c];
+        }
+      } else {
+        for (c=0; c<size; c++) {
+          for (r=0; r<size; r++) d[(r+size*c)*PC_PBJACOBI_LANES+l] = inv[r+size*c];
+        }
+        inv += size*size;
+      }
+      row += size;
+    }
+    jac->batchbs[b] = size;
+    jac->batchnb[b] = l;
+    d              += size*size*PC_PBJACOBI_LANES;
+  }
+  if (bsizes) {
+    ierr = PetscFree5(idx,pivots,vals,blk,work);CHKERRQ(ierr);
+  }
+  pc->ops->apply = PCApply_PBJacobi_Batched;
+  PetscFunctionReturn(0);
+}
+
+/* -------------------------------------------------------------------------- */
+#undef __FUNCT__
+#define __FUNCT__ "PCReset_PBJacobi"
+static PetscErrorCode PCReset_PBJacobi(PC pc)
+{
+  PC_PBJacobi    *jac = (PC_PBJacobi*)pc->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree2(jac->batchbs,jac->batchnb);CHKERRQ(ierr);
+  ierr = PetscFree(jac->values);CHKERRQ(ierr);
+  ierr = PetscFree(jac->work);CHKERRQ(ierr);
+  jac->nbatch = 0;
+  jac->diag   = 0;
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "PCSetUp_PBJacobi"
 static PetscErrorCode PCSetUp_PBJacobi(PC pc)
@@ -206,9 +358,20 @@ static PetscErrorCode PCSetUp_PBJacobi(PC pc)
   PC_PBJacobi    *jac = (PC_PBJacobi*)pc->data;
   PetscErrorCode ierr;
   Mat            A = pc->pmat;
+  PetscInt       i,n;
 
   PetscFunctionBegin;
   if (A->rmap->n != A->cmap->n) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Supported only for square matrices and square storage");
+  ierr = PCReset_PBJacobi(pc);CHKERRQ(ierr);
+
+  if (jac->bsizes) {
+    for (i=0,n=0; i<jac->nblocks; i++) n += jac->bsizes[i];
+    if (n != A->rmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Sum of block sizes %D does not match the local matrix size %D",n,A->rmap->n);
+    jac->bs  = 0;
+    jac->mbs = jac->nblocks;
+    ierr     = PCPBJacobiSetUpBatches(pc,jac->nblocks,jac->bsizes,0);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
 
   ierr        = MatInvertBlockDiagonal(A,&jac->diag);CHKERRQ(ierr);
   jac->bs     = A->rmap->bs;
@@ -236,7 +399,7 @@ static PetscErrorCode PCSetUp_PBJacobi(PC pc)
       pc->ops->apply = PCApply_PBJacobi_7;
       break;
     default:
-      SETERRQ1(((PetscObject)pc)->comm,PETSC_ERR_SUP,"not supported for block size %D",jac->bs);
+      ierr = PCPBJacobiSetUpBatches(pc,jac->mbs,PETSC_NULL,jac->bs);CHKERRQ(ierr);
   }
 
   PetscFunctionReturn(0);
@@ -246,9 +409,13 @@ static PetscErrorCode PCSetUp_PBJacobi(PC pc)
 #define __FUNCT__ "PCDestroy_PBJacobi"
 static PetscErrorCode PCDestroy_PBJacobi(PC pc)
 {
+  PC_PBJacobi    *jac = (PC_PBJacobi*)pc->data;
   PetscErrorCode ierr;
 
   PetscFunctionBegin;
+  ierr = PCReset_PBJacobi(pc);CHKERRQ(ierr);
+  ierr = PetscFree(jac->bsizes);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)pc,"PCPBJacobiSetBlockSizes_C","",PETSC_NULL);CHKERRQ(ierr);
   /*
       Free the private data structure that was hanging off the PC
   */
@@ -267,21 +434,91 @@ static PetscErrorCode PCView_PBJacobi(PC pc,PetscViewer viewer)
   PetscFunctionBegin;
   ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
   if (iascii) {
-    ierr = PetscViewerASCIIPrintf(viewer,"  point-block Jacobi: block size %D\n",jac->bs);CHKERRQ(ierr);
+    if (jac->bsizes) {
+      ierr = PetscViewerASCIIPrintf(viewer,"  point-block Jacobi: variable block sizes, %D local blocks\n",jac->nblocks);CHKERRQ(ierr);
+    } else {
+      ierr = PetscViewerASCIIPrintf(viewer,"  point-block Jacobi: block size %D\n",jac->bs);CHKERRQ(ierr);
+    }
+    if (jac->nbatch) {
+      ierr = PetscViewerASCIIPrintf(viewer,"  point-block Jacobi: blocks applied in batches of up to %d\n",PC_PBJACOBI_LANES);CHKERRQ(ierr);
+    }
   } else SETERRQ1(((PetscObject)pc)->comm,PETSC_ERR_SUP,"Viewer type %s not supported for point-block Jacobi",((PetscObject)viewer)->type_name);
   PetscFunctionReturn(0);
 }
 
+/* -------------------------------------------------------------------------- */
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "PCPBJacobiSetBlockSizes_PBJacobi"
+PetscErrorCode  PCPBJacobiSetBlockSizes_PBJacobi(PC pc,PetscInt n,const PetscInt bsizes[])
+{
+  PC_PBJacobi    *jac = (PC_PBJacobi*)pc->data;
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  for (i=0; i<n; i++) {
+    if (bsizes[i] < 1) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Block %D has size %D, must be positive",i,bsizes[i]);
+  }
+  ierr = PetscFree(jac->bsizes);CHKERRQ(ierr);
+  ierr = PetscMalloc(n*sizeof(PetscInt),&jac->bsizes);CHKERRQ(ierr);
+  ierr = PetscMemcpy(jac->bsizes,bsizes,n*sizeof(PetscInt));CHKERRQ(ierr);
+  jac->nblocks = n;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "PCPBJacobiSetBlockSizes"
+/*@
+   PCPBJacobiSetBlockSizes - Sets the sizes of the point blocks on this process for the point block
+   Jacobi preconditioner, for matrices whose diagonal blocks do not all have the same size
+
+   Logically Collective on PC
+
+   Input Parameters:
++  pc - the preconditioner context
+.  n - the number of blocks on this process
+-  bsizes - the sizes of the blocks, in the order of the local rows; they must add up to the local number of rows
+
+   Notes:
+   Without this the blocks all have the block size of the matrix.
+
+   Blocks larger than 7 are applied in batches of consecutive blocks of the same size, interleaved so that
+   the batch is processed with one block per vector lane; ordering the unknowns so blocks of the same size
+   are adjacent keeps the batches full.
+
+   Level: intermediate
+
+   Concepts: point block Jacobi
+
+.seealso: PCPBJACOBI, MatInvertBlockDiagonal(), MatSetBlockSize()
+@*/
+PetscErrorCode  PCPBJacobiSetBlockSizes(PC pc,PetscInt n,const PetscInt bsizes[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(pc,PC_CLASSID,1);
+  if (n) PetscValidIntPointer(bsizes,3);
+  ierr = PetscTryMethod(pc,"PCPBJacobiSetBlockSizes_C",(PC,PetscInt,const PetscInt[]),(pc,n,bsizes));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /* -------------------------------------------------------------------------- */
 /*MC
      PCPBJACOBI - Point block Jacobi
 
+   Notes: The point blocks are the diagonal blocks of the size of the matrix block size, or those given with
+   PCPBJacobiSetBlockSizes(). Blocks larger than 7 and blocks of varying size are applied in batches of
+   consecutive blocks of the same size with their entries interleaved, so one vector lane handles one block.
+
    Level: beginner
 
   Concepts: point block Jacobi
 
 
-.seealso:  PCCreate(), PCSetType(), PCType (for list of available types), PC
+.seealso:  PCCreate(), PCSetType(), PCType (for list of available types), PC, PCPBJacobiSetBlockSizes()
 
 M*/
 
@@ -318,12 +555,14 @@ PetscErrorCode  PCCreate_PBJacobi(PC pc)
   pc->ops->apply               = 0; /*set depending on the block size */
   pc->ops->applytranspose      = 0;
   pc->ops->setup               = PCSetUp_PBJacobi;
+  pc->ops->reset               = PCReset_PBJacobi;
   pc->ops->destroy             = PCDestroy_PBJacobi;
   pc->ops->setfromoptions      = 0;
   pc->ops->view                = PCView_PBJacobi;
   pc->ops->applyrichardson     = 0;
   pc->ops->applysymmetricleft  = 0;
   pc->ops->applysymmetricright = 0;
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)pc,"PCPBJacobiSetBlockSizes_C","PCPBJacobiSetBlockSizes_PBJacobi",PCPBJacobiSetBlockSizes_PBJacobi);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 EXTERN_C_END
@@ -293,7 +293,8 @@ PetscErrorCode  PCSORSetIterations(PC pc,PetscInt its,PetscInt lits)
 .  -pc_sor_local_backward - Activates local backward version
 .  -pc_sor_omega <omega> - Sets omega
 .  -pc_sor_its <its> - Sets number of iterations   (default 1)
--  -pc_sor_lits <lits> - Sets number of local iterations  (default 1)
+.  -pc_sor_lits <lits> - Sets number of local iterations  (default 1)
+-  -mat_sor_threaded <multicolor,hybrid> - For SeqAIJ matrices (and the diagonal blocks of MPIAIJ), sweep with the threads
 
    Level: beginner
 
@@ -305,6 +306,12 @@ PetscErrorCode  PCSORSetIterations(PC pc,PetscInt its,PetscInt lits)
 
           For SeqBAIJ matrices this implements point-block SOR, but the omega, its, lits options are not supported.
 
+          With -mat_sor_threaded multicolor the rows are colored such that no two rows of the same color are coupled and
+          the rows of each color are relaxed in parallel; this is Gauss-Seidel in a different ordering of the unknowns,
+          independent of the number of threads. With -mat_sor_threaded hybrid each thread relaxes its own rows and uses
+          the values of the other threads' rows from the start of the sweep, with one thread this is the usual SOR.
+          Both ignore the inodes of the matrix; PCEISENSTAT still uses the sequential sweeps.
+
 .seealso:  PCCreate(), PCSetType(), PCType (for list of available types), PC,
            PCSORSetIterations(), PCSORSetSymmetric(), PCSORSetOmega(), PCEISENSTAT
 M*/
@@ -0,0 +1,378 @@
+#include <petsc-private/matimpl.h>    /*I "petscmat.h" I*/
+#include <../src/mat/impls/aij/seq/aij.h>
+#include <../src/mat/impls/aij/mpi/mpiaij.h>
+#include <petscthreadcomm.h>
+
+/* states of the vertices, a selected vertex has its global index as state */
+typedef PetscInt NState;
+static const NState NOT_DONE=-2;
+static const NState DELETED=-1;
+#define IS_SELECTED(s) (s>=0)
+
+typedef struct {
+  PetscInt seed;      /* seed of the random weights */
+  PetscInt nrounds;   /* number of rounds of the last MatCoarsenApply() */
+} MatCoarsen_Luby;
+
+/*
+   The random weight of a vertex is a hash of its global index, so that it does not depend on the
+   number of processes and the weights of the ghost vertices need not be communicated. Ties are
+   broken by the global index.
+*/
+PETSC_STATIC_INLINE unsigned int LubyWeight(PetscInt gid,PetscInt seed)
+{
+  unsigned int h = (unsigned int)gid ^ (unsigned int)(((size_t)gid >> 16) >> 16);
+  h ^= (unsigned int)seed*0x9e3779b9U;
+  h ^= h >> 16; h *= 0x85ebca6bU;
+  h ^= h >> 13; h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+#define LUBY_GREATER(wa,ga,wb,gb) ((wa) > (wb) || ((wa) == (wb) && (ga) > (gb)))
+
+typedef struct {
+  const PetscInt *ai,*aj,*bi,*bj,*garray;
+  PetscInt       my0;
+  unsigned int   *lweight,*gweight;  /* weights of the local and the ghost vertices */
+  NState         *lstate;
+  PetscScalar    *gstate;           /* states of the ghost vertices from the last exchange */
+  PetscInt       *parent;           /* local index of the local vertex selected this round that deletes a vertex, or -1 */
+  PetscBool      *cand;             /* the vertex is selected this round */
+} LubyCtx;
+
+#undef __FUNCT__
+#define __FUNCT__ "LubySelect_Task"
+/* a vertex that is not done is selected when its weight is larger than the one of all its neighbors that are not done */
+static PetscErrorCode LubySelect_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  LubyCtx  *lc = (LubyCtx*)ctx;
+  PetscInt lid,j,col;
+
+  for (lid=start; lid<end; lid++) {
+    PetscBool    max = PETSC_TRUE;
+    unsigned int w = lc->lweight[lid];
+    PetscInt     gid = lid + lc->my0;
+
+    lc->cand[lid] = PETSC_FALSE;
+    if (lc->lstate[lid] != NOT_DONE) continue;
+    for (j=lc->ai[lid]; j<lc->ai[lid+1] && max; j++) {
+      col = lc->aj[j];
+      if (col == lid || lc->lstate[col] != NOT_DONE) continue;
+      if (LUBY_GREATER(lc->lweight[col],col+lc->my0,w,gid)) max = PETSC_FALSE;
+    }
+    if (lc->bi) {
+      for (j=lc->bi[lid]; j<lc->bi[lid+1] && max; j++) {
+        col = lc->bj[j];
+        if ((NState)PetscRealPart(lc->gstate[col]) != NOT_DONE) continue;
+        if (LUBY_GREATER(lc->gweight[col],lc->garray[col],w,gid)) max = PETSC_FALSE;
+      }
+    }
+    lc->cand[lid] = max;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "LubyParent_Task"
+/* a vertex that is not done and not selected is deleted by its selected local neighbor of largest weight */
+static PetscErrorCode LubyParent_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  LubyCtx  *lc = (LubyCtx*)ctx;
+  PetscInt lid,j,col,p;
+
+  for (lid=start; lid<end; lid++) {
+    lc->parent[lid] = -1;
+    if (lc->lstate[lid] != NOT_DONE || lc->cand[lid]) continue;
+    for (j=lc->ai[lid],p=-1; j<lc->ai[lid+1]; j++) {
+      col = lc->aj[j];
+      if (!lc->cand[col]) continue;
+      if (p == -1 || LUBY_GREATER(lc->lweight[col],col,lc->lweight[p],p)) p = col;
+    }
+    lc->parent[lid] = p;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "LubyGhostParent_Task"
+/* a vertex that is not done and has a selected ghost neighbor is deleted by the one of largest weight, parent is then its ghost index */
+static PetscErrorCode LubyGhostParent_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  LubyCtx  *lc = (LubyCtx*)ctx;
+  PetscInt lid,j,col,p;
+
+  for (lid=start; lid<end; lid++) {
+    lc->parent[lid] = -1;
+    if (lc->lstate[lid] != NOT_DONE) continue;
+    for (j=lc->bi[lid],p=-1; j<lc->bi[lid+1]; j++) {
+      col = lc->bj[j];
+      if (!IS_SELECTED((NState)PetscRealPart(lc->gstate[col]))) continue;
+      if (p == -1 || LUBY_GREATER(lc->gweight[col],lc->garray[col],lc->gweight[p],lc->garray[p])) p = col;
+    }
+    lc->parent[lid] = p;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCoarsenApply_Luby"
+/*
+   Luby's randomized maximal independent set: in each round every vertex whose weight is a local maximum among
+   the vertices that are not done is selected, and the neighbors of the selected vertices are deleted. The rounds
+   only need one exchange of the states with the neighbor processes and a reduction, and the vertices of a round
+   are independent, so they are processed by the threads of the communicator.
+
+   The aggregates are the same as the ones of MATCOARSENMIS: with strict_aggs the list of a selected vertex has the
+   global indices of its aggregate, otherwise the local indices with the ghost vertices numbered after the local ones.
+*/
+static PetscErrorCode MatCoarsenApply_Luby(MatCoarsen coarse)
+{
+  MatCoarsen_Luby  *luby = (MatCoarsen_Luby*)coarse->subctx;
+  PetscErrorCode   ierr;
+  Mat              Gmat = coarse->graph;
+  MPI_Comm         wcomm = ((PetscObject)Gmat)->comm;
+  PetscBool        isMPI,strict_aggs = coarse->strict_aggs;
+  Mat_SeqAIJ       *matA,*matB = 0;
+  Mat_MPIAIJ       *mpimat = 0;
+  Vec              locState = 0,ghostState = 0;
+  PetscScalar      *array;
+  PetscMPIInt      mype;
+  PetscInt         nloc = Gmat->rmap->n,num_fine_ghosts = 0,my0,Iend,lid,j,ntasks,*tstarts,nremoved = 0,nselected = 0,ntodo,gtodo;
+  PetscInt         *lid_parent_gid = 0;
+  LubyCtx          lc;
+  PetscCoarsenData *agg_lists;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(wcomm,&mype);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)Gmat,MATMPIAIJ,&isMPI);CHKERRQ(ierr);
+  if (isMPI) {
+    mpimat = (Mat_MPIAIJ*)Gmat->data;
+    matA   = (Mat_SeqAIJ*)mpimat->A->data;
+    matB   = (Mat_SeqAIJ*)mpimat->B->data;
+    /* force compressed storage of B as MATCOARSENMIS does, GAMG's aggregate smoothing relies on it */
+    matB->compressedrow.check = PETSC_TRUE;
+    ierr   = MatCheckCompressedRow(mpimat->B,&matB->compressedrow,matB->i,Gmat->rmap->n,-1.0);CHKERRQ(ierr);
+    ierr   = VecGetLocalSize(mpimat->lvec,&num_fine_ghosts);CHKERRQ(ierr);
+  } else {
+    PetscBool isAIJ;
+    ierr = PetscObjectTypeCompare((PetscObject)Gmat,MATSEQAIJ,&isAIJ);CHKERRQ(ierr);
+    if (!isAIJ) SETERRQ1(wcomm,PETSC_ERR_SUP,"Luby coarsening needs an AIJ graph, not %s",((PetscObject)Gmat)->type_name);
+    matA = (Mat_SeqAIJ*)Gmat->data;
+  }
+  ierr = MatGetOwnershipRange(Gmat,&my0,&Iend);CHKERRQ(ierr);
+
+  ierr = PetscMemzero(&lc,sizeof(lc));CHKERRQ(ierr);
+  lc.ai  = matA->i; lc.aj = matA->j;
+  lc.my0 = my0;
+  if (matB) {
+    lc.bi = matB->i; lc.bj = matB->j; lc.garray = mpimat->garray;
+  }
+  ierr = PetscMalloc2(nloc+1,unsigned int,&lc.lweight,num_fine_ghosts+1,unsigned int,&lc.gweight);CHKERRQ(ierr);
+  ierr = PetscMalloc3(nloc+1,NState,&lc.lstate,nloc+1,PetscInt,&lc.parent,nloc+1,PetscBool,&lc.cand);CHKERRQ(ierr);
+  for (lid=0; lid<nloc; lid++) {
+    lc.lweight[lid] = LubyWeight(lid+my0,luby->seed);
+    lc.lstate[lid]  = NOT_DONE;
+  }
+  for (j=0; j<num_fine_ghosts; j++) lc.gweight[j] = LubyWeight(lc.garray[j],luby->seed);
+  if (strict_aggs) {
+    ierr = PetscMalloc((nloc+1)*sizeof(PetscInt),&lid_parent_gid);CHKERRQ(ierr);
+    for (lid=0; lid<nloc; lid++) lid_parent_gid[lid] = -1;
+  }
+  if (mpimat) {
+    ierr = MatGetVecs(Gmat,&locState,0);CHKERRQ(ierr);
+    ierr = VecDuplicate(mpimat->lvec,&ghostState);CHKERRQ(ierr);
+    ierr = VecSet(ghostState,(PetscScalar)((PetscReal)NOT_DONE));CHKERRQ(ierr);
+  }
+
+  /* has ghost nodes for !strict and uses local indexing */
+  ierr = PetscCDCreate(strict_aggs ? nloc : num_fine_ghosts+nloc,&agg_lists);CHKERRQ(ierr);
+  coarse->agg_lists = agg_lists;
+
+  /* isolated vertices are not aggregated */
+  for (lid=0; lid<nloc; lid++) {
+    PetscInt n = lc.ai[lid+1] - lc.ai[lid];
+    if (n < 2 && (!lc.bi || lc.bi[lid+1] == lc.bi[lid])) {
+      lc.lstate[lid] = DELETED;
+      nremoved++;
+    }
+  }
+
+  ierr = PetscThreadCommGetOwnershipRanges(wcomm,nloc,&tstarts);CHKERRQ(ierr);
+  ierr = PetscThreadCommGetNThreads(wcomm,&ntasks);CHKERRQ(ierr);
+
+  luby->nrounds = 0;
+  do {
+    luby->nrounds++;
+    if (mpimat) {ierr = VecGetArray(ghostState,&lc.gstate);CHKERRQ(ierr);}
+
+    /* select the local maxima and find who deletes their local neighbors */
+    ierr = PetscThreadCommRunTasks(wcomm,ntasks,tstarts,LubySelect_Task,&lc);CHKERRQ(ierr);
+    ierr = PetscThreadCommRunTasks(wcomm,ntasks,tstarts,LubyParent_Task,&lc);CHKERRQ(ierr);
+    for (lid=0; lid<nloc; lid++) {
+      if (!lc.cand[lid]) continue;
+      lc.lstate[lid] = lid + my0;
+      nselected++;
+      ierr = PetscCDAppendID(agg_lists,lid,strict_aggs ? lid+my0 : lid);CHKERRQ(ierr);
+      if (!strict_aggs && lc.bi) {
+        /* ghosts that are not done are deleted by this vertex or by one of their neighbors, aggregates may overlap */
+        for (j=lc.bi[lid]; j<lc.bi[lid+1]; j++) {
+          if ((NState)PetscRealPart(lc.gstate[lc.bj[j]]) == NOT_DONE) {
+            ierr = PetscCDAppendID(agg_lists,lid,nloc+lc.bj[j]);CHKERRQ(ierr);
+          }
+        }
+      }
+    }
+    for (lid=0; lid<nloc; lid++) {
+      if (lc.parent[lid] == -1) continue;
+      lc.lstate[lid] = DELETED;
+      ierr = PetscCDAppendID(agg_lists,lc.parent[lid],strict_aggs ? lid+my0 : lid);CHKERRQ(ierr);
+    }
+    if (mpimat) {ierr = VecRestoreArray(ghostState,&lc.gstate);CHKERRQ(ierr);}
+
+    if (mpimat) {
+      /* exchange the states, the vertices next to a selected ghost are deleted */
+      ierr = VecGetArray(locState,&array);CHKERRQ(ierr);
+      for (lid=0; lid<nloc; lid++) array[lid] = (PetscScalar)((PetscReal)lc.lstate[lid]);
+      ierr = VecRestoreArray(locState,&array);CHKERRQ(ierr);
+      ierr = VecScatterBegin(mpimat->Mvctx,locState,ghostState,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecScatterEnd(mpimat->Mvctx,locState,ghostState,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+      ierr = VecGetArray(ghostState,&lc.gstate);CHKERRQ(ierr);
+      ierr = PetscThreadCommRunTasks(wcomm,ntasks,tstarts,LubyGhostParent_Task,&lc);CHKERRQ(ierr);
+      for (lid=0; lid<nloc; lid++) {
+        PetscInt cpid = lc.parent[lid];
+        if (cpid == -1) continue;
+        lc.lstate[lid] = DELETED;
+        if (strict_aggs) lid_parent_gid[lid] = lc.garray[cpid];
+        else {
+          ierr = PetscCDAppendID(agg_lists,nloc+cpid,lid);CHKERRQ(ierr);
+        }
+      }
+      ierr = VecRestoreArray(ghostState,&lc.gstate);CHKERRQ(ierr);
+    }
+
+    for (lid=0,ntodo=0; lid<nloc; lid++) if (lc.lstate[lid] == NOT_DONE) ntodo++;
+    ierr = MPI_Allreduce(&ntodo,&gtodo,1,MPIU_INT,MPI_SUM,wcomm);CHKERRQ(ierr);
+  } while (gtodo);
+  ierr = PetscInfo3(coarse,"%D vertices selected, %D isolated vertices, in %D rounds\n",nselected,nremoved,luby->nrounds);CHKERRQ(ierr);
+
+  if (coarse->verbose) {
+    PetscInt N,gsel,grem;
+    ierr = MatGetSize(Gmat,&N,PETSC_NULL);CHKERRQ(ierr);
+    ierr = MPI_Allreduce(&nremoved,&grem,1,MPIU_INT,MPI_SUM,wcomm);CHKERRQ(ierr);
+    ierr = MPI_Allreduce(&nselected,&gsel,1,MPIU_INT,MPI_SUM,wcomm);CHKERRQ(ierr);
+    ierr = PetscPrintf(wcomm,"\t[%d]%s removed %d of %d vertices. %d selected in %d rounds.\n",mype,__FUNCT__,grem,N,gsel,luby->nrounds);CHKERRQ(ierr);
+  }
+
+  /* tell the selected ghosts which of my vertices they deleted - fill in the strict aggregates */
+  if (strict_aggs && mpimat) {
+    ierr = VecGetArray(locState,&array);CHKERRQ(ierr);
+    for (lid=0; lid<nloc; lid++) array[lid] = (PetscScalar)((PetscReal)lid_parent_gid[lid]);
+    ierr = VecRestoreArray(locState,&array);CHKERRQ(ierr);
+    ierr = VecScatterBegin(mpimat->Mvctx,locState,ghostState,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    ierr = VecScatterEnd(mpimat->Mvctx,locState,ghostState,INSERT_VALUES,SCATTER_FORWARD);CHKERRQ(ierr);
+    ierr = VecGetArray(ghostState,&array);CHKERRQ(ierr);
+    for (j=0; j<num_fine_ghosts; j++) {
+      PetscInt sgid = (PetscInt)PetscRealPart(array[j]);
+      if (sgid >= my0 && sgid < Iend) {
+        ierr = PetscCDAppendID(agg_lists,sgid-my0,lc.garray[j]);CHKERRQ(ierr);
+      }
+    }
+    ierr = VecRestoreArray(ghostState,&array);CHKERRQ(ierr);
+  }
+
+  ierr = PetscFree(tstarts);CHKERRQ(ierr);
+  ierr = PetscFree(lid_parent_gid);CHKERRQ(ierr);
+  ierr = PetscFree2(lc.lweight,lc.gweight);CHKERRQ(ierr);
+  ierr = PetscFree3(lc.lstate,lc.parent,lc.cand);CHKERRQ(ierr);
+  ierr = VecDestroy(&ghostState);CHKERRQ(ierr);
+  ierr = VecDestroy(&locState);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCoarsenSetFromOptions_Luby"
+static PetscErrorCode MatCoarsenSetFromOptions_Luby(MatCoarsen coarse)
+{
+  MatCoarsen_Luby *luby = (MatCoarsen_Luby*)coarse->subctx;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead("Luby coarsening options");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-mat_coarsen_luby_seed","Seed of the random weights","None",luby->seed,&luby->seed,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCoarsenView_Luby"
+static PetscErrorCode MatCoarsenView_Luby(MatCoarsen coarse,PetscViewer viewer)
+{
+  MatCoarsen_Luby *luby = (MatCoarsen_Luby*)coarse->subctx;
+  PetscErrorCode  ierr;
+  PetscBool       iascii;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(coarse,MAT_COARSEN_CLASSID,1);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerASCIIPrintf(viewer,"  Luby MIS aggregator, seed %D, %D rounds\n",luby->seed,luby->nrounds);CHKERRQ(ierr);
+  } else SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_SUP,"Viewer type %s not supported for this Luby coarsener",((PetscObject)viewer)->type_name);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCoarsenDestroy_Luby"
+static PetscErrorCode MatCoarsenDestroy_Luby(MatCoarsen coarse)
+{
+  MatCoarsen_Luby *luby = (MatCoarsen_Luby*)coarse->subctx;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(coarse,MAT_COARSEN_CLASSID,1);
+  ierr = PetscFree(luby);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*MC
+   MATCOARSENLUBY - Coarsening with Luby's randomized parallel maximal independent set
+
+   Options Database Keys:
+.  -mat_coarsen_luby_seed <seed> - seed of the random weights
+
+   Notes:
+   The vertices get random weights, a hash of their global index, and in each round the vertices whose weight is
+   larger than the one of their neighbors still to be done are selected, so the rounds do not depend on the order of the
+   processes as with MATCOARSENMIS, and the independent set does not depend on the number of processes. The vertices
+   of a round are processed by the threads of the PetscThreadComm of the graph. The greedy ordering of
+   MatCoarsenSetGreedyOrdering() is not used.
+
+   The number of rounds grows like the logarithm of the number of vertices, each one costs one exchange with the
+   neighbor processes and a reduction.
+
+   Level: beginner
+
+.keywords: Coarsen, create, context
+
+.seealso: MatCoarsenSetType(), MatCoarsenType, MATCOARSENMIS
+
+M*/
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatCoarsenCreate_Luby"
+PetscErrorCode  MatCoarsenCreate_Luby(MatCoarsen coarse)
+{
+  PetscErrorCode  ierr;
+  MatCoarsen_Luby *luby;
+
+  PetscFunctionBegin;
+  ierr  = PetscNewLog(coarse,MatCoarsen_Luby,&luby);CHKERRQ(ierr);
+  coarse->subctx = (void*)luby;
+
+  coarse->ops->apply          = MatCoarsenApply_Luby;
+  coarse->ops->view           = MatCoarsenView_Luby;
+  coarse->ops->destroy        = MatCoarsenDestroy_Luby;
+  coarse->ops->setfromoptions = MatCoarsenSetFromOptions_Luby;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
@@ -4,6 +4,7 @@
 EXTERN_C_BEGIN
 extern PetscErrorCode  MatCoarsenCreate_MIS(MatCoarsen);
 extern PetscErrorCode  MatCoarsenCreate_HEM(MatCoarsen);
+extern PetscErrorCode  MatCoarsenCreate_Luby(MatCoarsen);
 EXTERN_C_END
 
 #undef __FUNCT__
@@ -38,6 +39,7 @@ PetscErrorCode  MatCoarsenRegisterAll(const char path[])
   MatCoarsenRegisterAllCalled = PETSC_TRUE;
   ierr = MatCoarsenRegisterDynamic(MATCOARSENMIS,path,"MatCoarsenCreate_MIS",MatCoarsenCreate_MIS);CHKERRQ(ierr);
   ierr = MatCoarsenRegisterDynamic(MATCOARSENHEM,path,"MatCoarsenCreate_HEM",MatCoarsenCreate_HEM);CHKERRQ(ierr);
+  ierr = MatCoarsenRegisterDynamic(MATCOARSENLUBY,path,"MatCoarsenCreate_Luby",MatCoarsenCreate_Luby);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -0,0 +1,138 @@
+
+static char help[] = "Tests the MATSELL (sliced ELLPACK) matrix vector products against MATAIJ.\n\
+Input arguments are:\n\
+  -m <local rows> : number of local rows of the test matrix\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckProducts"
+static PetscErrorCode CheckProducts(Mat A,Mat B,const char *label)
+{
+  PetscErrorCode ierr;
+  Vec            x,y,z,w,v;
+  PetscReal      nrm[4];
+  PetscScalar    one = 1.0;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&w);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&v);CHKERRQ(ierr);
+  ierr = VecSet(x,one);CHKERRQ(ierr);
+  ierr = VecShift(x,one);CHKERRQ(ierr);
+  ierr = VecSetValue(x,0,-3.0,ADD_VALUES);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+
+  /* MatMult() */
+  ierr = MatMult(A,x,y);CHKERRQ(ierr);
+  ierr = MatMult(B,x,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[0]);CHKERRQ(ierr);
+
+  /* MatMultAdd(), in place and out of place */
+  ierr = MatMultAdd(A,x,y,y);CHKERRQ(ierr);
+  ierr = VecSet(z,one);CHKERRQ(ierr);
+  ierr = MatMult(A,x,z);CHKERRQ(ierr);
+  ierr = MatMultAdd(B,x,z,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[1]);CHKERRQ(ierr);
+
+  /* MatMultTranspose() */
+  ierr = MatMultTranspose(A,y,w);CHKERRQ(ierr);
+  ierr = MatMultTranspose(B,y,v);CHKERRQ(ierr);
+  ierr = VecAXPY(v,-1.0,w);CHKERRQ(ierr);
+  ierr = VecNorm(v,NORM_INFINITY,&nrm[2]);CHKERRQ(ierr);
+
+  /* MatMultTransposeAdd() */
+  ierr = MatMultTransposeAdd(A,y,x,w);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd(B,y,x,v);CHKERRQ(ierr);
+  ierr = VecAXPY(v,-1.0,w);CHKERRQ(ierr);
+  ierr = VecNorm(v,NORM_INFINITY,&nrm[3]);CHKERRQ(ierr);
+
+  for (i=0; i<4; i++) {
+    if (nrm[i] > 1.e-10) {
+      ierr = PetscPrintf(((PetscObject)A)->comm,"%s: error in product %D %G\n",label,i,nrm[i]);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = VecDestroy(&w);CHKERRQ(ierr);
+  ierr = VecDestroy(&v);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,B,C;
+  PetscErrorCode ierr;
+  PetscInt       m = 37,N,rstart,rend,i,j,k,col,h,s;
+  PetscInt       heights[] = {1,4,8,13,16},sigmas[] = {1,32};
+  PetscScalar    v;
+  PetscBool      flg;
+  char           label[64],value[16];
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+
+  /* A matrix with very irregular row lengths, including empty rows */
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,m,m,PETSC_DETERMINE,PETSC_DETERMINE,20,PETSC_NULL,20,PETSC_NULL,&A);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetSize(A,&N,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    k = (i*i) % 11;
+    if (i % 5 == 3) k = 0;
+    for (j=0; j<k; j++) {
+      col  = (i + 3*j*j + 7*j) % N;
+      v    = 1.0 + i - 0.5*j;
+      ierr = MatSetValues(A,1,&i,1,&col,&v,ADD_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  for (h=0; h<5; h++) {
+    for (s=0; s<2; s++) {
+      ierr = PetscSNPrintf(value,sizeof(value),"%D",heights[h]);CHKERRQ(ierr);
+      ierr = PetscOptionsSetValue("-mat_sell_slice_height",value);CHKERRQ(ierr);
+      ierr = PetscSNPrintf(value,sizeof(value),"%D",sigmas[s]);CHKERRQ(ierr);
+      ierr = PetscOptionsSetValue("-mat_sell_sigma",value);CHKERRQ(ierr);
+      ierr = PetscSNPrintf(label,sizeof(label),"C=%D sigma=%D",heights[h],sigmas[s]);CHKERRQ(ierr);
+
+      ierr = MatConvert(A,MATSELL,MAT_INITIAL_MATRIX,&B);CHKERRQ(ierr);
+      ierr = CheckProducts(A,B,label);CHKERRQ(ierr);
+
+      /* values changed after the SELL arrays have been built */
+      ierr = MatScale(A,2.0);CHKERRQ(ierr);
+      ierr = MatScale(B,2.0);CHKERRQ(ierr);
+      ierr = CheckProducts(A,B,label);CHKERRQ(ierr);
+      ierr = MatShift(A,1.0);CHKERRQ(ierr);
+      ierr = MatShift(B,1.0);CHKERRQ(ierr);
+      ierr = CheckProducts(A,B,label);CHKERRQ(ierr);
+
+      ierr = MatDuplicate(B,MAT_COPY_VALUES,&C);CHKERRQ(ierr);
+      ierr = PetscObjectTypeCompareAny((PetscObject)C,&flg,MATSEQSELL,MATMPISELL,"");CHKERRQ(ierr);
+      if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: MatDuplicate() lost the matrix type\n",label);CHKERRQ(ierr);}
+      ierr = CheckProducts(A,C,label);CHKERRQ(ierr);
+      ierr = MatDestroy(&C);CHKERRQ(ierr);
+
+      /* back to AIJ */
+      ierr = MatConvert(B,MATAIJ,MAT_REUSE_MATRIX,&B);CHKERRQ(ierr);
+      ierr = PetscObjectTypeCompareAny((PetscObject)B,&flg,MATSEQAIJ,MATMPIAIJ,"");CHKERRQ(ierr);
+      if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: MatConvert() to AIJ failed\n",label);CHKERRQ(ierr);}
+      ierr = CheckProducts(A,B,label);CHKERRQ(ierr);
+      ierr = MatDestroy(&B);CHKERRQ(ierr);
+    }
+  }
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
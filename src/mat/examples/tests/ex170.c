@@ -0,0 +1,131 @@
+
+static char help[] = "Tests the SeqAIJ and SeqBAIJ products and diagonal extraction on matrices with very unbalanced row lengths.\n\
+Run with -threadcomm_type pthread -threadcomm_nthreads <n> to test the threaded kernels.\n\
+Input arguments are:\n\
+  -mbs <block rows> : number of block rows of the test matrix\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckProducts"
+static PetscErrorCode CheckProducts(Mat A,Mat B,const char *label)
+{
+  PetscErrorCode ierr;
+  Vec            x,y,z,w;
+  PetscReal      nrm[4];
+  PetscInt       i,rstart,rend;
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&w);CHKERRQ(ierr);
+  ierr = VecGetOwnershipRange(x,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    ierr = VecSetValue(x,i,1.0 + (i % 7) - 0.25*(i % 3),INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+
+  /* MatMult() */
+  ierr = MatMult(A,x,y);CHKERRQ(ierr);
+  ierr = MatMult(B,x,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[0]);CHKERRQ(ierr);
+
+  /* MatMultAdd(), out of place */
+  ierr = VecCopy(x,w);CHKERRQ(ierr);
+  ierr = MatMultAdd(B,x,w,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,w);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[1]);CHKERRQ(ierr);
+
+  /* MatMultAdd(), in place */
+  ierr = VecCopy(x,z);CHKERRQ(ierr);
+  ierr = MatMultAdd(B,x,z,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,x);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[2]);CHKERRQ(ierr);
+
+  /* MatGetDiagonal() */
+  ierr = MatGetDiagonal(A,y);CHKERRQ(ierr);
+  ierr = MatGetDiagonal(B,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[3]);CHKERRQ(ierr);
+
+  for (i=0; i<4; i++) {
+    if (nrm[i] > 1.e-10) {
+      ierr = PetscPrintf(((PetscObject)A)->comm,"%s: error in test %D %G\n",label,i,nrm[i]);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = VecDestroy(&w);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,B,D;
+  PetscErrorCode ierr;
+  PetscInt       mbs = 53,bs,m,i,j,k,r,c,row,col,nb;
+  PetscScalar    v;
+  char           label[64];
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-mbs",&mbs,PETSC_NULL);CHKERRQ(ierr);
+
+  for (bs=1; bs<=5; bs++) {
+    m    = mbs*bs;
+    ierr = MatCreateSeqBAIJ(PETSC_COMM_SELF,bs,m,m,0,PETSC_NULL,&B);CHKERRQ(ierr);
+    ierr = MatSetOption(B,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+    /* a few dense block rows at the top, followed by many short and empty block rows */
+    for (i=0; i<mbs; i++) {
+      if (i < 3)           nb = mbs;
+      else if (i % 4 == 1) nb = 0;
+      else                 nb = 1 + (i % 3);
+      for (k=0; k<nb; k++) {
+        col = (i + 5*k) % mbs;
+        for (r=0; r<bs; r++) {
+          for (c=0; c<bs; c++) {
+            row  = i*bs + r;
+            j    = col*bs + c;
+            v    = 1.0 + 0.5*r - 0.25*c + 0.01*i;
+            ierr = MatSetValues(B,1,&row,1,&j,&v,ADD_VALUES);CHKERRQ(ierr);
+          }
+        }
+      }
+    }
+    ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatConvert(B,MATSEQDENSE,MAT_INITIAL_MATRIX,&D);CHKERRQ(ierr);
+    ierr = MatConvert(B,MATSEQAIJ,MAT_INITIAL_MATRIX,&A);CHKERRQ(ierr);
+    ierr = MatSetOption(A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+
+    ierr = PetscSNPrintf(label,sizeof(label),"BAIJ bs=%D",bs);CHKERRQ(ierr);
+    ierr = CheckProducts(D,B,label);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"AIJ bs=%D",bs);CHKERRQ(ierr);
+    ierr = CheckProducts(D,A,label);CHKERRQ(ierr);
+
+    /* the partition must follow a change of the values and of the nonzero structure */
+    ierr = MatZeroEntries(A);CHKERRQ(ierr);
+    ierr = MatZeroEntries(B);CHKERRQ(ierr);
+    ierr = MatZeroEntries(D);CHKERRQ(ierr);
+    ierr = MatShift(A,2.0);CHKERRQ(ierr);
+    ierr = MatShift(B,2.0);CHKERRQ(ierr);
+    ierr = MatShift(D,2.0);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"shifted BAIJ bs=%D",bs);CHKERRQ(ierr);
+    ierr = CheckProducts(D,B,label);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"shifted AIJ bs=%D",bs);CHKERRQ(ierr);
+    ierr = CheckProducts(D,A,label);CHKERRQ(ierr);
+
+    ierr = MatDestroy(&A);CHKERRQ(ierr);
+    ierr = MatDestroy(&B);CHKERRQ(ierr);
+    ierr = MatDestroy(&D);CHKERRQ(ierr);
+  }
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,340 @@
+
+static char help[] = "Tests the assembly of a finite element matrix from its element matrices.\n\
+By default tests concurrent MatSetValues() and MatSetValuesBlocked() with MAT_CONCURRENT_ADD_VALUES on SeqAIJ and SeqBAIJ;\n\
+run with -threadcomm_type pthread -threadcomm_nthreads <n> to add the values from several threads.\n\
+Input arguments are:\n\
+  -n <elements> : number of elements in each direction of the grid\n\
+  -coalesce     : test the coalescing of repeated off-process entries in the matrix and vector stashes instead\n\
+  -same_off_proc_entries : test repeated parallel assembly with MAT_SAME_OFF_PROC_ENTRIES instead\n\
+  -its <its>    : number of assemblies for -same_off_proc_entries\n\n";
+
+#include <petscmat.h>
+#include <petscthreadcomm.h>
+
+#define BS 2
+
+typedef struct {
+  PetscInt  n;              /* number of elements in each direction */
+  PetscBool blocked;        /* use MatSetValuesBlocked() */
+} AppCtx;
+
+/* the bilinear quadrilateral element e at iteration it, with BS unknowns per vertex; for INSERT_VALUES v[] only depends
+   on the positions, so the elements sharing a vertex insert the same values */
+static void ElementMatrix(PetscInt n,PetscInt e,PetscInt it,InsertMode mode,PetscInt idx[],PetscInt pidx[],PetscScalar v[])
+{
+  PetscInt i,j,c,r,ex = e % n,ey = e / n;
+
+  idx[0] = ey*(n+1) + ex;   idx[1] = idx[0] + 1;
+  idx[2] = idx[1] + n + 1;  idx[3] = idx[2] - 1;
+  for (i=0; i<4; i++) {
+    for (c=0; c<BS; c++) pidx[i*BS+c] = idx[i]*BS + c;
+  }
+  for (r=0; r<4*BS; r++) {
+    for (j=0; j<4*BS; j++) {
+      if (mode == ADD_VALUES) v[r*4*BS+j] = (r == j) ? 4.0 + (e + it) % 5 : -0.25 + 0.01*((r*7 + j + e + it) % 11);
+      else                    v[r*4*BS+j] = 1.0 + it + pidx[r] + 0.001*pidx[j];
+    }
+  }
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CreateMat"
+/* the preallocation routines of the other types do nothing */
+static PetscErrorCode CreateMat(MPI_Comm comm,MatType type,PetscInt m,Mat *A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(comm,A);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,PETSC_DECIDE,PETSC_DECIDE,m,m);CHKERRQ(ierr);
+  ierr = MatSetBlockSize(*A,BS);CHKERRQ(ierr);
+  ierr = MatSetType(*A,type);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation(*A,9*BS,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatSeqBAIJSetPreallocation(*A,BS,9,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(*A,9*BS,PETSC_NULL,9*BS,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatMPIBAIJSetPreallocation(*A,BS,9,PETSC_NULL,9,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatSetUp(*A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "AssembleKernel"
+/* each thread adds a strided subset of the elements, so neighbouring elements are added by different threads */
+static PetscErrorCode AssembleKernel(PetscInt thread_id,Mat A,AppCtx *user,PetscInt *nthreads)
+{
+  PetscErrorCode ierr;
+  PetscInt       e,idx[4],pidx[4*BS];
+  PetscScalar    v[16*BS*BS];
+
+  for (e=thread_id; e<user->n*user->n; e+=*nthreads) {
+    ElementMatrix(user->n,e,0,ADD_VALUES,idx,pidx,v);
+    if (user->blocked) {
+      ierr = MatSetValuesBlocked(A,4,idx,4,idx,v,ADD_VALUES);CHKERRQ(ierr);
+    } else {
+      ierr = MatSetValues(A,4*BS,pidx,4*BS,pidx,v,ADD_VALUES);CHKERRQ(ierr);
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckConcurrentAssembly"
+static PetscErrorCode CheckConcurrentAssembly(Mat A,AppCtx *user,const char *label)
+{
+  PetscErrorCode ierr;
+  Mat            B;
+  PetscInt       nthreads,i;
+  PetscReal      nrm,err;
+
+  PetscFunctionBegin;
+  ierr = PetscThreadCommGetNThreads(PETSC_COMM_SELF,&nthreads);CHKERRQ(ierr);
+  ierr = MatDuplicate(A,MAT_DO_NOT_COPY_VALUES,&B);CHKERRQ(ierr);
+  ierr = MatSetOption(B,MAT_CONCURRENT_ADD_VALUES,PETSC_TRUE);CHKERRQ(ierr);
+  /* twice, the second time into an assembled matrix */
+  for (i=0; i<2; i++) {
+    ierr = PetscThreadCommRunKernel(PETSC_COMM_SELF,(PetscThreadKernel)AssembleKernel,3,B,user,&nthreads);CHKERRQ(ierr);
+    ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  }
+  ierr = MatSetOption(B,MAT_CONCURRENT_ADD_VALUES,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatScale(B,0.5);CHKERRQ(ierr);
+  ierr = MatAXPY(B,-1.0,A,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatNorm(B,NORM_FROBENIUS,&err);CHKERRQ(ierr);
+  ierr = MatNorm(A,NORM_FROBENIUS,&nrm);CHKERRQ(ierr);
+  if (err > 1.e-12*nrm) {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"%s: concurrent assembly differs by %G\n",label,err);CHKERRQ(ierr);
+  }
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "TestConcurrent"
+static PetscErrorCode TestConcurrent(AppCtx *user)
+{
+  Mat            A;
+  PetscErrorCode ierr;
+  PetscInt       e,t,m,one = 1,idx[4],pidx[4*BS];
+  PetscScalar    v[16*BS*BS];
+  MatType        types[] = {MATSEQAIJ,MATSEQBAIJ};
+  PetscBool      flg;
+  char           label[64];
+
+  PetscFunctionBegin;
+  m = (user->n+1)*(user->n+1)*BS;
+  for (t=0; t<2; t++) {
+    ierr = CreateMat(PETSC_COMM_SELF,types[t],m,&A);CHKERRQ(ierr);
+    for (e=0; e<user->n*user->n; e++) {
+      ElementMatrix(user->n,e,0,ADD_VALUES,idx,pidx,v);
+      ierr = MatSetValues(A,4*BS,pidx,4*BS,pidx,v,ADD_VALUES);CHKERRQ(ierr);
+    }
+    ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+    user->blocked = PETSC_FALSE;
+    ierr = PetscSNPrintf(label,sizeof(label),"%s MatSetValues()",types[t]);CHKERRQ(ierr);
+    ierr = CheckConcurrentAssembly(A,user,label);CHKERRQ(ierr);
+    user->blocked = PETSC_TRUE;
+    ierr = PetscSNPrintf(label,sizeof(label),"%s MatSetValuesBlocked()",types[t]);CHKERRQ(ierr);
+    ierr = CheckConcurrentAssembly(A,user,label);CHKERRQ(ierr);
+
+    /* a new nonzero is an error in the concurrent mode */
+    ierr = MatSetOption(A,MAT_CONCURRENT_ADD_VALUES,PETSC_TRUE);CHKERRQ(ierr);
+    ierr = PetscPushErrorHandler(PetscReturnErrorHandler,PETSC_NULL);CHKERRQ(ierr);
+    flg  = MatSetValue(A,0,m-1,1.0,ADD_VALUES) ? PETSC_TRUE : PETSC_FALSE;
+    ierr = PetscPopErrorHandler();CHKERRQ(ierr);
+    if (!flg) {ierr = PetscPrintf(PETSC_COMM_SELF,"%s: new nonzero was not detected\n",types[t]);CHKERRQ(ierr);}
+    ierr = MatSetValues(A,1,&one,1,&one,v,ADD_VALUES);CHKERRQ(ierr);
+    ierr = MatSetOption(A,MAT_CONCURRENT_ADD_VALUES,PETSC_FALSE);CHKERRQ(ierr);
+    ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatDestroy(&A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "Assemble"
+/* the elements are dealt round-robin to the processes, so most vertices are shared by elements on several processes.
+   Every element is set twice; for INSERT_VALUES the first values are wrong and must be replaced by the second ones.
+   x may be PETSC_NULL */
+static PetscErrorCode Assemble(Mat A,Vec x,PetscInt n,PetscInt it,InsertMode mode,PetscBool blocked)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size,rank;
+  PetscInt       e,k,i,idx[4],pidx[4*BS];
+  PetscScalar    v[16*BS*BS],w[4*BS];
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_size(((PetscObject)A)->comm,&size);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(((PetscObject)A)->comm,&rank);CHKERRQ(ierr);
+  for (e=rank; e<n*n; e+=size) {
+    for (k=0; k<2; k++) {
+      ElementMatrix(n,e,it,mode,idx,pidx,v);
+      for (i=0; i<4*BS; i++) w[i] = (mode == ADD_VALUES) ? v[i*4*BS+i] : 1.0 + it + pidx[i];
+      if (mode == INSERT_VALUES && !k) v[0] = v[4*BS+1] = w[1] = -100.0;
+      if (blocked) {
+        ierr = MatSetValuesBlocked(A,4,idx,4,idx,v,mode);CHKERRQ(ierr);
+        if (x) {ierr = VecSetValuesBlocked(x,4,idx,w,mode);CHKERRQ(ierr);}
+      } else {
+        ierr = MatSetValues(A,4*BS,pidx,4*BS,pidx,v,mode);CHKERRQ(ierr);
+        if (x) {ierr = VecSetValues(x,4*BS,pidx,w,mode);CHKERRQ(ierr);}
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  if (x) {
+    ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+    ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CreateMatVec"
+static PetscErrorCode CreateMatVec(MatType type,PetscInt m,PetscBool coalesce,Mat *A,Vec *x)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  /* the stashes read the options when they are created */
+  ierr = PetscOptionsSetValue("-matstash_coalesce",coalesce ? "1" : "0");CHKERRQ(ierr);
+  ierr = PetscOptionsSetValue("-vecstash_coalesce",coalesce ? "1" : "0");CHKERRQ(ierr);
+  ierr = CreateMat(PETSC_COMM_WORLD,type,m,A);CHKERRQ(ierr);
+  ierr = MatSetOption(*A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetVecs(*A,x,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsClearValue("-matstash_coalesce");CHKERRQ(ierr);
+  ierr = PetscOptionsClearValue("-vecstash_coalesce");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "TestCoalesce"
+/* the same assembly with and without coalescing the stashes */
+static PetscErrorCode TestCoalesce(PetscInt n)
+{
+  Mat            A,B;
+  Vec            x,y;
+  PetscErrorCode ierr;
+  PetscInt       m,t,i,b;
+  PetscReal      nrm,err;
+  MatType        types[] = {MATMPIAIJ,MATMPIBAIJ,MATMPIDENSE};
+  InsertMode     modes[] = {ADD_VALUES,INSERT_VALUES};
+  const char     *modenames[] = {"ADD_VALUES","INSERT_VALUES"};
+
+  PetscFunctionBegin;
+  m = (n+1)*(n+1)*BS;
+  for (t=0; t<3; t++) {
+    for (i=0; i<2; i++) {
+      for (b=0; b<2; b++) {
+        ierr = CreateMatVec(types[t],m,PETSC_FALSE,&A,&x);CHKERRQ(ierr);
+        ierr = CreateMatVec(types[t],m,PETSC_TRUE,&B,&y);CHKERRQ(ierr);
+        ierr = Assemble(A,x,n,0,modes[i],(PetscBool)b);CHKERRQ(ierr);
+        ierr = Assemble(B,y,n,0,modes[i],(PetscBool)b);CHKERRQ(ierr);
+
+        ierr = MatAXPY(B,-1.0,A,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+        ierr = MatNorm(B,NORM_FROBENIUS,&err);CHKERRQ(ierr);
+        ierr = MatNorm(A,NORM_FROBENIUS,&nrm);CHKERRQ(ierr);
+        if (err > 1.e-12*nrm) {
+          ierr = PetscPrintf(PETSC_COMM_WORLD,"%s %s%s: coalesced matrix differs by %G\n",types[t],modenames[i],b ? " blocked" : "",err);CHKERRQ(ierr);
+        }
+        ierr = VecAXPY(y,-1.0,x);CHKERRQ(ierr);
+        ierr = VecNorm(y,NORM_2,&err);CHKERRQ(ierr);
+        ierr = VecNorm(x,NORM_2,&nrm);CHKERRQ(ierr);
+        if (err > 1.e-12*nrm) {
+          ierr = PetscPrintf(PETSC_COMM_WORLD,"%s%s: coalesced vector differs by %G\n",modenames[i],b ? " blocked" : "",err);CHKERRQ(ierr);
+        }
+        ierr = MatDestroy(&A);CHKERRQ(ierr);
+        ierr = MatDestroy(&B);CHKERRQ(ierr);
+        ierr = VecDestroy(&x);CHKERRQ(ierr);
+        ierr = VecDestroy(&y);CHKERRQ(ierr);
+      }
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "TestSameOffProc"
+/* repeated assemblies with and without MAT_SAME_OFF_PROC_ENTRIES */
+static PetscErrorCode TestSameOffProc(PetscInt n,PetscInt its)
+{
+  Mat            A,B,C;
+  PetscErrorCode ierr;
+  PetscInt       m,t,i,b,f,it;
+  PetscReal      nrm,err;
+  MatType        types[] = {MATMPIAIJ,MATMPIBAIJ,MATMPIDENSE};
+  InsertMode     modes[] = {ADD_VALUES,INSERT_VALUES};
+  const char     *modenames[] = {"ADD_VALUES","INSERT_VALUES"};
+
+  PetscFunctionBegin;
+  m = (n+1)*(n+1)*BS;
+  for (t=0; t<3; t++) {
+    for (i=0; i<2; i++) {
+      for (b=0; b<2; b++) {
+        /* f = 1 freezes the nonzero structure after the first assembly, so MPIAIJ places the values directly */
+        for (f=0; f<2; f++) {
+          ierr = CreateMat(PETSC_COMM_WORLD,types[t],m,&A);CHKERRQ(ierr);
+          ierr = CreateMat(PETSC_COMM_WORLD,types[t],m,&B);CHKERRQ(ierr);
+          ierr = MatSetOption(B,MAT_SAME_OFF_PROC_ENTRIES,PETSC_TRUE);CHKERRQ(ierr);
+          for (it=0; it<its; it++) {
+            if (it == 1 && f) {
+              ierr = MatSetOption(A,MAT_NEW_NONZERO_LOCATION_ERR,PETSC_TRUE);CHKERRQ(ierr);
+              ierr = MatSetOption(B,MAT_NEW_NONZERO_LOCATION_ERR,PETSC_TRUE);CHKERRQ(ierr);
+            }
+            /* the record is dropped by one assembly without the option, and made again by the last one */
+            if (it == its-2) {ierr = MatSetOption(B,MAT_SAME_OFF_PROC_ENTRIES,PETSC_FALSE);CHKERRQ(ierr);}
+            if (it == its-1) {ierr = MatSetOption(B,MAT_SAME_OFF_PROC_ENTRIES,PETSC_TRUE);CHKERRQ(ierr);}
+            if (it) {
+              ierr = MatZeroEntries(A);CHKERRQ(ierr);
+              ierr = MatZeroEntries(B);CHKERRQ(ierr);
+            }
+            ierr = Assemble(A,PETSC_NULL,n,it,modes[i],(PetscBool)b);CHKERRQ(ierr);
+            ierr = Assemble(B,PETSC_NULL,n,it,modes[i],(PetscBool)b);CHKERRQ(ierr);
+
+            ierr = MatNorm(A,NORM_FROBENIUS,&nrm);CHKERRQ(ierr);
+            ierr = MatDuplicate(B,MAT_COPY_VALUES,&C);CHKERRQ(ierr);
+            ierr = MatAXPY(C,-1.0,A,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+            ierr = MatNorm(C,NORM_FROBENIUS,&err);CHKERRQ(ierr);
+            ierr = MatDestroy(&C);CHKERRQ(ierr);
+            if (err > 1.e-12*nrm) {
+              ierr = PetscPrintf(PETSC_COMM_WORLD,"%s %s%s%s assembly %D: differs by %G\n",types[t],modenames[i],b ? " blocked" : "",f ? " frozen" : "",it,err);CHKERRQ(ierr);
+            }
+          }
+          ierr = MatDestroy(&A);CHKERRQ(ierr);
+          ierr = MatDestroy(&B);CHKERRQ(ierr);
+        }
+      }
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  PetscErrorCode ierr;
+  AppCtx         user;
+  PetscInt       its = 6;
+  PetscBool      coalesce = PETSC_FALSE,same = PETSC_FALSE;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  user.n = 20;
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&user.n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(PETSC_NULL,"-coalesce",&coalesce,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(PETSC_NULL,"-same_off_proc_entries",&same,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-its",&its,PETSC_NULL);CHKERRQ(ierr);
+
+  if (coalesce) {
+    ierr = TestCoalesce(user.n);CHKERRQ(ierr);
+  } else if (same) {
+    ierr = TestSameOffProc(user.n,its);CHKERRQ(ierr);
+  } else {
+    ierr = TestConcurrent(&user);CHKERRQ(ierr);
+  }
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,147 @@
+
+static char help[] = "Tests the hash accumulator products -matmatmult_hash and -matptap_hash for SeqAIJ on one process,\n\
+and the all-at-once parallel MatPtAP() for MPIAIJ, -matptap_allatonce, on several processes.\n\
+Run with -threadcomm_type pthread -threadcomm_nthreads <n> to compute the rows of the hash products with several threads.\n\
+Input arguments are:\n\
+  -n <n> : number of grid points in each direction\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "FormMatrices"
+/*
+   A is the 5-point Laplacian with a dense first row and a few empty rows, P aggregates 2x2 blocks of the grid with
+   random weights and, for some rows, adds an entry in a column owned by another process
+*/
+static PetscErrorCode FormMatrices(PetscInt n,PetscRandom rdm,Mat *A,Mat *P)
+{
+  PetscErrorCode ierr;
+  PetscInt       N = n*n,nc = (n+1)/2,i,j,row,col,c,rstart,rend;
+  PetscScalar    v;
+
+  PetscFunctionBegin;
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,PETSC_DECIDE,PETSC_DECIDE,N,N,5,PETSC_NULL,5,PETSC_NULL,A);CHKERRQ(ierr);
+  ierr = MatSetOption(*A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(*A,&rstart,&rend);CHKERRQ(ierr);
+  for (row=rstart; row<rend; row++) {
+    if (row % 17 == 5) continue;
+    i = row / n; j = row % n;
+    v = 4.0;
+    ierr = MatSetValues(*A,1,&row,1,&row,&v,INSERT_VALUES);CHKERRQ(ierr);
+    v = -1.0;
+    if (i > 0)   {col = row - n; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (i < n-1) {col = row + n; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j > 0)   {col = row - 1; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j < n-1) {col = row + 1; ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);}
+  }
+  if (!rstart) {
+    row = 0;
+    for (col=0; col<N; col++) {
+      ierr = PetscRandomGetValue(rdm,&v);CHKERRQ(ierr);
+      ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,rend-rstart,PETSC_DECIDE,N,nc*nc,2,PETSC_NULL,2,PETSC_NULL,P);CHKERRQ(ierr);
+  for (row=rstart; row<rend; row++) {
+    i = row / n; j = row % n;
+    c = (i/2)*nc + j/2;
+    ierr = PetscRandomGetValue(rdm,&v);CHKERRQ(ierr);
+    ierr = MatSetValues(*P,1,&row,1,&c,&v,INSERT_VALUES);CHKERRQ(ierr);
+    if (row % 7 == 3) {
+      c    = (c + nc*nc/2) % (nc*nc);
+      ierr = MatSetValues(*P,1,&row,1,&c,&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(*P,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*P,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckProduct"
+static PetscErrorCode CheckProduct(Mat C,Mat D,const char *label)
+{
+  PetscErrorCode ierr;
+  Mat            E;
+  PetscReal      nrm,err;
+  MatInfo        infoc,infod;
+
+  PetscFunctionBegin;
+  ierr = MatGetInfo(C,MAT_GLOBAL_SUM,&infoc);CHKERRQ(ierr);
+  ierr = MatGetInfo(D,MAT_GLOBAL_SUM,&infod);CHKERRQ(ierr);
+  if (infoc.nz_used != infod.nz_used) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: %D nonzeros instead of %D\n",label,(PetscInt)infod.nz_used,(PetscInt)infoc.nz_used);CHKERRQ(ierr);
+  }
+  ierr = MatDuplicate(D,MAT_COPY_VALUES,&E);CHKERRQ(ierr);
+  ierr = MatAXPY(E,-1.0,C,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatNorm(E,NORM_FROBENIUS,&err);CHKERRQ(ierr);
+  ierr = MatNorm(C,NORM_FROBENIUS,&nrm);CHKERRQ(ierr);
+  if (err > 1.e-12*nrm) {ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: product differs by %G\n",label,err);CHKERRQ(ierr);}
+  ierr = MatDestroy(&E);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,P,C,D,Ct,Dt;
+  Vec            l;
+  PetscErrorCode ierr;
+  PetscRandom    rdm;
+  PetscInt       n = 30,k;
+  PetscMPIInt    size;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rdm);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rdm);CHKERRQ(ierr);
+  ierr = FormMatrices(n,rdm,&A,&P);CHKERRQ(ierr);
+  ierr = MatGetVecs(A,PETSC_NULL,&l);CHKERRQ(ierr);
+
+  /* the reference products */
+  ierr = MatMatMult(A,P,MAT_INITIAL_MATRIX,2.0,&C);CHKERRQ(ierr);
+  ierr = MatPtAP(A,P,MAT_INITIAL_MATRIX,2.0,&Ct);CHKERRQ(ierr);
+  if (size == 1) {
+    ierr = PetscOptionsSetValue("-matmatmult_hash","1");CHKERRQ(ierr);
+    ierr = PetscOptionsSetValue("-matptap_hash","1");CHKERRQ(ierr);
+  } else {
+    ierr = PetscOptionsSetValue("-matptap_allatonce","1");CHKERRQ(ierr);
+  }
+  ierr = MatMatMult(A,P,MAT_INITIAL_MATRIX,2.0,&D);CHKERRQ(ierr);
+  ierr = MatPtAP(A,P,MAT_INITIAL_MATRIX,2.0,&Dt);CHKERRQ(ierr);
+  ierr = PetscOptionsClearValue("-matmatmult_hash");CHKERRQ(ierr);
+  ierr = PetscOptionsClearValue("-matptap_hash");CHKERRQ(ierr);
+  ierr = PetscOptionsClearValue("-matptap_allatonce");CHKERRQ(ierr);
+  ierr = CheckProduct(C,D,"MatMatMult()");CHKERRQ(ierr);
+  ierr = CheckProduct(Ct,Dt,"MatPtAP()");CHKERRQ(ierr);
+
+  /* new values with the same structure */
+  for (k=0; k<2; k++) {
+    ierr = VecSetRandom(l,rdm);CHKERRQ(ierr);
+    ierr = MatDiagonalScale(A,l,PETSC_NULL);CHKERRQ(ierr);
+    ierr = MatScale(P,-0.5);CHKERRQ(ierr);
+    ierr = MatMatMult(A,P,MAT_REUSE_MATRIX,2.0,&C);CHKERRQ(ierr);
+    ierr = MatMatMult(A,P,MAT_REUSE_MATRIX,2.0,&D);CHKERRQ(ierr);
+    ierr = MatPtAP(A,P,MAT_REUSE_MATRIX,2.0,&Ct);CHKERRQ(ierr);
+    ierr = MatPtAP(A,P,MAT_REUSE_MATRIX,2.0,&Dt);CHKERRQ(ierr);
+    ierr = CheckProduct(C,D,"MatMatMult() reuse");CHKERRQ(ierr);
+    ierr = CheckProduct(Ct,Dt,"MatPtAP() reuse");CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroy(&l);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&P);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = MatDestroy(&D);CHKERRQ(ierr);
+  ierr = MatDestroy(&Ct);CHKERRQ(ierr);
+  ierr = MatDestroy(&Dt);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rdm);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
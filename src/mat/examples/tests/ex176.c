@@ -0,0 +1,104 @@
+
+static char help[] = "Tests the Luby maximal independent set coarsening MATCOARSENLUBY.\n\
+The independent set does not depend on the number of processes.\n\
+Input arguments are:\n\
+  -n <n> : number of grid points in each direction\n\n";
+
+#include <petsc-private/matimpl.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat              G;
+  Vec              cnt,sel,nsel;
+  MatCoarsen       crs;
+  PetscCoarsenData *agg_lists;
+  PetscCDPos       pos;
+  PetscErrorCode   ierr;
+  PetscInt         n = 20,N,i,j,row,col,Istart,Iend,lid,gid,nagg = 0,gagg,nbad = 0,gbad;
+  PetscScalar      one = 1.0,*c,*s,*y;
+  PetscBool        empty;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  N    = n*n;
+
+  /* graph of the 5-point stencil, with a few isolated vertices */
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,PETSC_DECIDE,PETSC_DECIDE,N,N,5,PETSC_NULL,2,PETSC_NULL,&G);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(G,&Istart,&Iend);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    i = row/n; j = row - i*n;
+    ierr = MatSetValues(G,1,&row,1,&row,&one,INSERT_VALUES);CHKERRQ(ierr);
+    if (row % 37 == 11) continue;
+    if (i>0   && (row-n) % 37 != 11) {col = row-n; ierr = MatSetValues(G,1,&row,1,&col,&one,INSERT_VALUES);CHKERRQ(ierr);}
+    if (i<n-1 && (row+n) % 37 != 11) {col = row+n; ierr = MatSetValues(G,1,&row,1,&col,&one,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j>0   && (row-1) % 37 != 11) {col = row-1; ierr = MatSetValues(G,1,&row,1,&col,&one,INSERT_VALUES);CHKERRQ(ierr);}
+    if (j<n-1 && (row+1) % 37 != 11) {col = row+1; ierr = MatSetValues(G,1,&row,1,&col,&one,INSERT_VALUES);CHKERRQ(ierr);}
+  }
+  ierr = MatAssemblyBegin(G,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(G,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatCoarsenCreate(PETSC_COMM_WORLD,&crs);CHKERRQ(ierr);
+  ierr = MatCoarsenSetType(crs,MATCOARSENLUBY);CHKERRQ(ierr);
+  ierr = MatCoarsenSetFromOptions(crs);CHKERRQ(ierr);
+  ierr = MatCoarsenSetAdjacency(crs,G);CHKERRQ(ierr);
+  ierr = MatCoarsenSetStrictAggs(crs,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = MatCoarsenApply(crs);CHKERRQ(ierr);
+  ierr = MatCoarsenGetData(crs,&agg_lists);CHKERRQ(ierr);
+  ierr = MatCoarsenDestroy(&crs);CHKERRQ(ierr);
+
+  /* count the aggregates of each vertex and mark the selected vertices */
+  ierr = MatGetVecs(G,&cnt,&sel);CHKERRQ(ierr);
+  ierr = VecDuplicate(sel,&nsel);CHKERRQ(ierr);
+  for (lid=0; lid<Iend-Istart; lid++) {
+    ierr = PetscCDEmptyAt(agg_lists,lid,&empty);CHKERRQ(ierr);
+    if (empty) continue;
+    nagg++;
+    row  = lid + Istart;
+    ierr = VecSetValues(sel,1,&row,&one,INSERT_VALUES);CHKERRQ(ierr);
+    ierr = PetscCDGetHeadPos(agg_lists,lid,&pos);CHKERRQ(ierr);
+    while (pos) {
+      ierr = PetscLLNGetID(pos,&gid);CHKERRQ(ierr);
+      ierr = VecSetValues(cnt,1,&gid,&one,ADD_VALUES);CHKERRQ(ierr);
+      ierr = PetscCDGetNextPos(agg_lists,lid,&pos);CHKERRQ(ierr);
+    }
+  }
+  ierr = PetscCDDestroy(agg_lists);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(cnt);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(cnt);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(sel);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(sel);CHKERRQ(ierr);
+
+  /* the selected vertices have no selected neighbor, the others have one unless they are isolated */
+  ierr = MatMult(G,sel,nsel);CHKERRQ(ierr);
+  ierr = VecGetArray(cnt,&c);CHKERRQ(ierr);
+  ierr = VecGetArray(sel,&s);CHKERRQ(ierr);
+  ierr = VecGetArray(nsel,&y);CHKERRQ(ierr);
+  for (row=Istart; row<Iend; row++) {
+    PetscInt  k = row - Istart;
+    PetscBool isolated = (PetscBool)(row % 37 == 11);
+    if (isolated) {
+      if (PetscRealPart(c[k]) != 0.0 || PetscRealPart(s[k]) != 0.0) nbad++;
+    } else {
+      if (PetscRealPart(c[k]) != 1.0) nbad++;
+      if (PetscRealPart(s[k]) == 1.0 && PetscRealPart(y[k]) != 1.0) nbad++;
+      if (PetscRealPart(s[k]) == 0.0 && PetscRealPart(y[k]) < 1.0) nbad++;
+    }
+  }
+  ierr = VecRestoreArray(cnt,&c);CHKERRQ(ierr);
+  ierr = VecRestoreArray(sel,&s);CHKERRQ(ierr);
+  ierr = VecRestoreArray(nsel,&y);CHKERRQ(ierr);
+
+  ierr = MPI_Allreduce(&nagg,&gagg,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  ierr = MPI_Allreduce(&nbad,&gbad,1,MPIU_INT,MPI_SUM,PETSC_COMM_WORLD);CHKERRQ(ierr);
+  if (gbad) {ierr = PetscPrintf(PETSC_COMM_WORLD,"%D vertices with wrong aggregates\n",gbad);CHKERRQ(ierr);}
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"%D aggregates of %D vertices\n",gagg,N);CHKERRQ(ierr);
+
+  ierr = VecDestroy(&cnt);CHKERRQ(ierr);
+  ierr = VecDestroy(&sel);CHKERRQ(ierr);
+  ierr = VecDestroy(&nsel);CHKERRQ(ierr);
+  ierr = MatDestroy(&G);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
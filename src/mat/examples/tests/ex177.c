@@ -0,0 +1,142 @@
+
+static char help[] = "Tests the level scheduled triangular solves -mat_solve_levels and -mat_solve_levels_syncfree of ILU and ICC factors.\n\
+Run with -threadcomm_type pthread -threadcomm_nthreads <n> to run the levels with several threads.\n\
+Input arguments are:\n\
+  -n <n>   : number of grid points in each direction\n\
+  -dof <d> : number of unknowns per grid point, more than one gives inodes\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "FormMatrix"
+/* nonsymmetric 5-point stencil with dof coupled unknowns per grid point, all unknowns of neighboring points are coupled;
+   ICC only uses the upper triangular part */
+static PetscErrorCode FormMatrix(PetscInt n,PetscInt dof,Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscInt       N = n*n*dof,i,j,d,e,row,col,node;
+  PetscScalar    v,vn;
+
+  PetscFunctionBegin;
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF,N,N,5*dof,PETSC_NULL,A);CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    for (j=0; j<n; j++) {
+      node = i*n + j;
+      for (d=0; d<dof; d++) {
+        row = node*dof + d;
+        for (e=0; e<dof; e++) {
+          col  = node*dof + e;
+          v    = (d == e) ? 4.0 + d : -0.1*(e+1);
+          ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);
+        }
+        for (e=0; e<dof; e++) {
+          v = (d == e) ? 1.0 : 0.1;
+          if (i > 0)   {col = (node-n)*dof + e; vn = -1.3*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (i < n-1) {col = (node+n)*dof + e; vn = -0.7*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (j > 0)   {col = (node-1)*dof + e; vn = -1.2*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (j < n-1) {col = (node+1)*dof + e; vn = -0.8*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+        }
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "FactorNumeric"
+static PetscErrorCode FactorNumeric(Mat F,Mat A,MatFactorInfo *info,PetscInt t)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (t) {ierr = MatCholeskyFactorNumeric(F,A,info);CHKERRQ(ierr);}
+  else   {ierr = MatLUFactorNumeric(F,A,info);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat               A,S,F;
+  Vec               b,x,y;
+  IS                isrow,iscol;
+  MatFactorInfo     info;
+  PetscErrorCode    ierr;
+  PetscInt          n = 24,dof = 1,o,t,k,s,levels[] = {0,2};
+  PetscReal         nrm,err;
+  PetscRandom       rdm;
+  const MatOrderingType orderings[] = {MATORDERINGNATURAL,MATORDERINGRCM};
+  const char        *schedules[] = {"-mat_solve_levels","-mat_solve_levels_syncfree"};
+  const char        *factors[] = {"AIJ ILU","AIJ ICC","SBAIJ ICC"};
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-dof",&dof,PETSC_NULL);CHKERRQ(ierr);
+  ierr = FormMatrix(n,dof,&A);CHKERRQ(ierr);
+  /* S is the symmetric part of A in SBAIJ format */
+  ierr = MatTranspose(A,MAT_INITIAL_MATRIX,&S);CHKERRQ(ierr);
+  ierr = MatAXPY(S,1.0,A,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatSetOption(S,MAT_SYMMETRIC,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = MatConvert(S,MATSEQSBAIJ,MAT_REUSE_MATRIX,&S);CHKERRQ(ierr);
+  ierr = MatGetVecs(A,&x,&b);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_SELF,&rdm);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rdm);CHKERRQ(ierr);
+  ierr = VecSetRandom(b,rdm);CHKERRQ(ierr);
+
+  for (o=0; o<2; o++) {
+    ierr = MatGetOrdering(A,orderings[o],&isrow,&iscol);CHKERRQ(ierr);
+    for (t=0; t<3; t++) {
+      for (k=0; k<2; k++) {
+        ierr = MatFactorInfoInitialize(&info);CHKERRQ(ierr);
+        info.levels = levels[k];
+        info.fill   = 3.0;
+        if (t == 0) {
+          ierr = MatGetFactor(A,MATSOLVERPETSC,MAT_FACTOR_ILU,&F);CHKERRQ(ierr);
+          ierr = MatILUFactorSymbolic(F,A,isrow,iscol,&info);CHKERRQ(ierr);
+        } else if (t == 1) {
+          ierr = MatGetFactor(A,MATSOLVERPETSC,MAT_FACTOR_ICC,&F);CHKERRQ(ierr);
+          ierr = MatICCFactorSymbolic(F,A,isrow,&info);CHKERRQ(ierr);
+        } else {
+          /* the SBAIJ factorization with block size 1 only supports the natural ordering */
+          if (o) continue;
+          ierr = MatGetFactor(S,MATSOLVERPETSC,MAT_FACTOR_ICC,&F);CHKERRQ(ierr);
+          ierr = MatICCFactorSymbolic(F,S,isrow,&info);CHKERRQ(ierr);
+        }
+        ierr = FactorNumeric(F,t ? (t == 1 ? A : S) : A,&info,t);CHKERRQ(ierr);
+        ierr = MatSolve(F,b,x);CHKERRQ(ierr);
+        ierr = VecNorm(x,NORM_2,&nrm);CHKERRQ(ierr);
+
+        /* refactor with each schedule, the solves must agree with the sequential one up to rounding */
+        for (s=0; s<2; s++) {
+          ierr = PetscOptionsSetValue(schedules[s],"1");CHKERRQ(ierr);
+          ierr = FactorNumeric(F,t ? (t == 1 ? A : S) : A,&info,t);CHKERRQ(ierr);
+          ierr = PetscOptionsClearValue(schedules[s]);CHKERRQ(ierr);
+          ierr = MatSolve(F,b,y);CHKERRQ(ierr);
+          ierr = MatSolve(F,b,y);CHKERRQ(ierr);
+          ierr = VecAXPY(y,-1.0,x);CHKERRQ(ierr);
+          ierr = VecNorm(y,NORM_2,&err);CHKERRQ(ierr);
+          if (err > 1.e-12*nrm) {
+            ierr = PetscPrintf(PETSC_COMM_SELF,"%s %s ordering, levels %D, %s: solution differs by %G\n",factors[t],orderings[o],levels[k],schedules[s],err);CHKERRQ(ierr);
+          }
+        }
+        ierr = MatDestroy(&F);CHKERRQ(ierr);
+      }
+    }
+    ierr = ISDestroy(&isrow);CHKERRQ(ierr);
+    ierr = ISDestroy(&iscol);CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&S);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rdm);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
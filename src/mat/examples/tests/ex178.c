@@ -0,0 +1,116 @@
+
+static char help[] = "Tests the threaded Gauss-Seidel/SOR sweeps -mat_sor_threaded <multicolor,hybrid> of SeqAIJ matrices.\n\
+Run with -threadcomm_type pthread -threadcomm_nthreads <n> to sweep with several threads.\n\
+Input arguments are:\n\
+  -n <n>   : number of grid points in each direction\n\
+  -dof <d> : number of unknowns per grid point, more than one gives inodes\n\n";
+
+#include <petscmat.h>
+#include <petscthreadcomm.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "FormMatrix"
+/* nonsymmetric, diagonally dominant 5-point stencil with dof coupled unknowns per grid point */
+static PetscErrorCode FormMatrix(PetscInt n,PetscInt dof,Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscInt       N = n*n*dof,i,j,d,e,row,col,node;
+  PetscScalar    v,vn;
+
+  PetscFunctionBegin;
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF,N,N,5*dof,PETSC_NULL,A);CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    for (j=0; j<n; j++) {
+      node = i*n + j;
+      for (d=0; d<dof; d++) {
+        row = node*dof + d;
+        for (e=0; e<dof; e++) {
+          v   = (d == e) ? 5.0 + d : -0.1;
+          col = node*dof + e;
+          ierr = MatSetValues(*A,1,&row,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);
+          v   = (d == e) ? 1.0 : 0.05;
+          if (i > 0)   {col = (node-n)*dof + e; vn = -1.2*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (i < n-1) {col = (node+n)*dof + e; vn = -0.8*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (j > 0)   {col = (node-1)*dof + e; vn = -1.1*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+          if (j < n-1) {col = (node+1)*dof + e; vn = -0.9*v; ierr = MatSetValues(*A,1,&row,1,&col,&vn,INSERT_VALUES);CHKERRQ(ierr);}
+        }
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat               A,B;
+  Vec               b,x,y,r;
+  PetscErrorCode    ierr;
+  PetscInt          n = 24,dof = 1,nthreads,s,f,o,its = 50;
+  PetscReal         bnrm,rnrm,err,omegas[] = {1.0,1.3};
+  PetscRandom       rdm;
+  const char        *types[] = {"multicolor","hybrid"};
+  const char        *sweeps[] = {"symmetric","forward","backward"};
+  const MatSORType  flags[] = {SOR_SYMMETRIC_SWEEP,SOR_FORWARD_SWEEP,SOR_BACKWARD_SWEEP};
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-dof",&dof,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscThreadCommGetNThreads(PETSC_COMM_SELF,&nthreads);CHKERRQ(ierr);
+  ierr = FormMatrix(n,dof,&A);CHKERRQ(ierr);
+  ierr = MatGetVecs(A,&x,&b);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&r);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_SELF,&rdm);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rdm);CHKERRQ(ierr);
+  ierr = VecSetRandom(b,rdm);CHKERRQ(ierr);
+  ierr = VecNorm(b,NORM_2,&bnrm);CHKERRQ(ierr);
+
+  /* the sequential sweeps */
+  ierr = MatSOR(A,b,1.0,(MatSORType)(SOR_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),0.0,1,1,x);CHKERRQ(ierr);
+  ierr = MatSOR(A,b,1.0,SOR_SYMMETRIC_SWEEP,0.0,2,1,x);CHKERRQ(ierr);
+
+  for (s=0; s<2; s++) {
+    /* the option is read at the first MatSOR() of a matrix */
+    ierr = PetscOptionsSetValue("-mat_sor_threaded",types[s]);CHKERRQ(ierr);
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+    ierr = MatSOR(B,b,1.0,(MatSORType)(SOR_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),0.0,1,1,y);CHKERRQ(ierr);
+    ierr = MatSOR(B,b,1.0,SOR_SYMMETRIC_SWEEP,0.0,2,1,y);CHKERRQ(ierr);
+    ierr = PetscOptionsClearValue("-mat_sor_threaded");CHKERRQ(ierr);
+
+    /* with one thread the hybrid sweeps are the sequential ones, unless those use the inodes */
+    if (s == 1 && nthreads == 1 && dof == 1) {
+      ierr = VecAXPY(y,-1.0,x);CHKERRQ(ierr);
+      ierr = VecNorm(y,NORM_2,&err);CHKERRQ(ierr);
+      ierr = VecNorm(x,NORM_2,&rnrm);CHKERRQ(ierr);
+      if (err > 1.e-12*rnrm) {ierr = PetscPrintf(PETSC_COMM_SELF,"hybrid sweeps with one thread differ from the sequential ones by %G\n",err);CHKERRQ(ierr);}
+    }
+
+    /* the sweeps must converge to the solution */
+    for (f=0; f<3; f++) {
+      for (o=0; o<2; o++) {
+        ierr = MatSOR(B,b,omegas[o],(MatSORType)(flags[f] | SOR_ZERO_INITIAL_GUESS),0.0,its,1,y);CHKERRQ(ierr);
+        ierr = MatMult(B,y,r);CHKERRQ(ierr);
+        ierr = VecAYPX(r,-1.0,b);CHKERRQ(ierr);
+        ierr = VecNorm(r,NORM_2,&rnrm);CHKERRQ(ierr);
+        if (rnrm > 1.e-6*bnrm) {
+          ierr = PetscPrintf(PETSC_COMM_SELF,"%s %s sweeps with omega %G: relative residual %G after %D sweeps\n",types[s],sweeps[f],omegas[o],rnrm/bnrm,its);CHKERRQ(ierr);
+        }
+      }
+    }
+    ierr = MatDestroy(&B);CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&r);CHKERRQ(ierr);
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rdm);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,172 @@
+
+static char help[] = "Tests the MATAIJDELTA (16 bit column differences) matrix vector products against MATAIJ.\n\
+Input arguments are:\n\
+  -m <local rows>    : number of local rows of the test matrix\n\
+  -n <local columns> : number of local columns, rows with gaps larger than 65535 columns use the AIJ indices\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckProducts"
+static PetscErrorCode CheckProducts(Mat A,Mat B,const char *label)
+{
+  PetscErrorCode ierr;
+  Vec            x,y,z,w,v;
+  PetscReal      nrm[4];
+  PetscScalar    one = 1.0;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&w);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&v);CHKERRQ(ierr);
+  ierr = VecSet(x,one);CHKERRQ(ierr);
+  ierr = VecShift(x,one);CHKERRQ(ierr);
+  ierr = VecSetValue(x,0,-3.0,ADD_VALUES);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+
+  /* MatMult() */
+  ierr = MatMult(A,x,y);CHKERRQ(ierr);
+  ierr = MatMult(B,x,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[0]);CHKERRQ(ierr);
+
+  /* MatMultAdd(), in place and out of place */
+  ierr = MatMultAdd(A,x,y,y);CHKERRQ(ierr);
+  ierr = VecSet(z,one);CHKERRQ(ierr);
+  ierr = MatMult(A,x,z);CHKERRQ(ierr);
+  ierr = MatMultAdd(B,x,z,z);CHKERRQ(ierr);
+  ierr = VecAXPY(z,-1.0,y);CHKERRQ(ierr);
+  ierr = VecNorm(z,NORM_INFINITY,&nrm[1]);CHKERRQ(ierr);
+
+  /* MatMultTranspose() */
+  ierr = MatMultTranspose(A,y,w);CHKERRQ(ierr);
+  ierr = MatMultTranspose(B,y,v);CHKERRQ(ierr);
+  ierr = VecAXPY(v,-1.0,w);CHKERRQ(ierr);
+  ierr = VecNorm(v,NORM_INFINITY,&nrm[2]);CHKERRQ(ierr);
+
+  /* MatMultTransposeAdd() */
+  ierr = MatMultTransposeAdd(A,y,x,w);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd(B,y,x,v);CHKERRQ(ierr);
+  ierr = VecAXPY(v,-1.0,w);CHKERRQ(ierr);
+  ierr = VecNorm(v,NORM_INFINITY,&nrm[3]);CHKERRQ(ierr);
+
+  for (i=0; i<4; i++) {
+    if (nrm[i] > 1.e-10) {
+      ierr = PetscPrintf(((PetscObject)A)->comm,"%s: error in product %D %G\n",label,i,nrm[i]);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = VecDestroy(&w);CHKERRQ(ierr);
+  ierr = VecDestroy(&v);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,B,C;
+  PetscErrorCode ierr;
+  PetscInt       m = 37,n = 150000,N,rstart,rend,i,j,k,col,ncols,*first;
+  const PetscInt *cols;
+  PetscScalar    v;
+  PetscBool      flg;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+
+  /* A wide matrix: most rows are banded, every fourth row also couples to columns far away, and some rows are empty */
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,m,n,PETSC_DETERMINE,PETSC_DETERMINE,20,PETSC_NULL,20,PETSC_NULL,&A);CHKERRQ(ierr);
+  ierr = MatSetOption(A,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatGetSize(A,PETSC_NULL,&N);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    k = (i*i) % 11;
+    if (i % 5 == 3) k = 0;
+    for (j=0; j<k; j++) {
+      col  = (i*(N/(m+1)) + 3*j*j + 7*j) % N;
+      v    = 1.0 + i - 0.5*j;
+      ierr = MatSetValues(A,1,&i,1,&col,&v,ADD_VALUES);CHKERRQ(ierr);
+      if (i % 4 == 1) {
+        col  = (col + 70001*(j+1)) % N;
+        ierr = MatSetValues(A,1,&i,1,&col,&v,ADD_VALUES);CHKERRQ(ierr);
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatConvert(A,MATAIJDELTA,MAT_INITIAL_MATRIX,&B);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompareAny((PetscObject)B,&flg,MATSEQAIJDELTA,MATMPIAIJDELTA,"");CHKERRQ(ierr);
+  if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"MatConvert() to AIJDELTA failed\n");CHKERRQ(ierr);}
+  ierr = CheckProducts(A,B,"convert");CHKERRQ(ierr);
+
+  /* values changed after the differences have been computed */
+  ierr = MatScale(A,2.0);CHKERRQ(ierr);
+  ierr = MatScale(B,2.0);CHKERRQ(ierr);
+  ierr = CheckProducts(A,B,"scale");CHKERRQ(ierr);
+
+  /* values added to existing entries keep the nonzero structure */
+  ierr = PetscMalloc((rend-rstart+1)*sizeof(PetscInt),&first);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    ierr = MatGetRow(A,i,&ncols,&cols,PETSC_NULL);CHKERRQ(ierr);
+    first[i-rstart] = ncols ? cols[0] : -1;
+    ierr = MatRestoreRow(A,i,&ncols,&cols,PETSC_NULL);CHKERRQ(ierr);
+  }
+  for (i=rstart; i<rend; i++) {
+    if (first[i-rstart] < 0) continue;
+    v    = 0.5;
+    ierr = MatSetValues(A,1,&i,1,&first[i-rstart],&v,ADD_VALUES);CHKERRQ(ierr);
+    ierr = MatSetValues(B,1,&i,1,&first[i-rstart],&v,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(first);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = CheckProducts(A,B,"same structure");CHKERRQ(ierr);
+
+  /* new nonzeros change the structure; on several processes this also disassembles the off-diagonal block */
+  for (i=rstart; i<rend; i+=3) {
+    col  = (7*i + 12345) % N;
+    v    = -1.0;
+    ierr = MatSetValues(A,1,&i,1,&col,&v,ADD_VALUES);CHKERRQ(ierr);
+    ierr = MatSetValues(B,1,&i,1,&col,&v,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = CheckProducts(A,B,"new nonzeros");CHKERRQ(ierr);
+
+  ierr = MatDuplicate(B,MAT_COPY_VALUES,&C);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompareAny((PetscObject)C,&flg,MATSEQAIJDELTA,MATMPIAIJDELTA,"");CHKERRQ(ierr);
+  if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"MatDuplicate() lost the matrix type\n");CHKERRQ(ierr);}
+  ierr = CheckProducts(A,C,"duplicate");CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+
+  /* created directly rather than converted */
+  ierr = MatCreateAIJDelta(PETSC_COMM_WORLD,m,n,PETSC_DETERMINE,PETSC_DETERMINE,20,PETSC_NULL,20,PETSC_NULL,&C);CHKERRQ(ierr);
+  ierr = MatSetOption(C,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatCopy(A,C,DIFFERENT_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = CheckProducts(A,C,"create");CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+
+  /* back to AIJ */
+  ierr = MatConvert(B,MATAIJ,MAT_REUSE_MATRIX,&B);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompareAny((PetscObject)B,&flg,MATSEQAIJ,MATMPIAIJ,"");CHKERRQ(ierr);
+  if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"MatConvert() to AIJ failed\n");CHKERRQ(ierr);}
+  ierr = CheckProducts(A,B,"back to AIJ");CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,286 @@
+static char help[] = "Tests MatStoreSinglePrecision(): products, SOR, ILU and the other operations with the values of AIJ and BAIJ matrices stored in single precision.\n\
+Input arguments are:\n\
+  -m <local rows> : number of local rows of the test matrix, a multiple of 3 on one process\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckClose"
+/* y is a result computed with the single precision values and z the same with full precision values */
+static PetscErrorCode CheckClose(Vec y,Vec z,const char *label)
+{
+  PetscErrorCode ierr;
+  PetscReal      nrm,err;
+
+  PetscFunctionBegin;
+  ierr = VecNorm(z,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+  ierr = VecAXPY(y,-1.0,z);CHKERRQ(ierr);
+  ierr = VecNorm(y,NORM_INFINITY,&err);CHKERRQ(ierr);
+  if (err > 1.e-5*nrm) {
+    ierr = PetscPrintf(((PetscObject)y)->comm,"%s: relative error %G\n",label,err/nrm);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckMat"
+static PetscErrorCode CheckMat(Mat A,Mat B,MatSORType sortype,const char *label)
+{
+  PetscErrorCode ierr;
+  Vec            x,y,z;
+  PetscRandom    rand;
+  char           str[64];
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(((PetscObject)A)->comm,&rand);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rand);CHKERRQ(ierr);
+  ierr = VecSetRandom(x,rand);CHKERRQ(ierr);
+
+  ierr = MatMult(B,x,y);CHKERRQ(ierr);
+  ierr = MatMult(A,x,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatMult",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = VecSet(y,1.0);CHKERRQ(ierr);
+  ierr = VecSet(z,1.0);CHKERRQ(ierr);
+  ierr = MatMultAdd(B,x,y,y);CHKERRQ(ierr);
+  ierr = MatMultAdd(A,x,z,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatMultAdd",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = MatMultTranspose(B,x,y);CHKERRQ(ierr);
+  ierr = MatMultTranspose(A,x,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatMultTranspose",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = MatGetDiagonal(B,y);CHKERRQ(ierr);
+  ierr = MatGetDiagonal(A,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatGetDiagonal",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = MatSOR(B,x,1.0,sortype,0.0,1,1,y);CHKERRQ(ierr);
+  ierr = MatSOR(A,x,1.0,sortype,0.0,1,1,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatSOR",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = PetscRandomDestroy(&rand);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckOps"
+/* operations without a single precision kernel, which work on a temporary full precision copy of B */
+static PetscErrorCode CheckOps(Mat A,Mat B,MatType newtype,const char *label)
+{
+  PetscErrorCode    ierr;
+  Mat               C;
+  Vec               x,y,z;
+  PetscInt          i,j,n,bs,rstart,rend,cols[3];
+  PetscScalar       va[3],vb[3];
+  const PetscScalar *da,*db;
+  char              str[64];
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecSet(x,1.0);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  ierr = MatGetSize(A,&n,PETSC_NULL);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    cols[0] = i-1; cols[1] = i; cols[2] = i+1 < n ? i+1 : -1;
+    ierr = MatGetValues(A,1,&i,3,cols,va);CHKERRQ(ierr);
+    ierr = MatGetValues(B,1,&i,3,cols,vb);CHKERRQ(ierr);
+    for (j=0; j<3; j++) {
+      if (cols[j] >= 0 && PetscAbsScalar(va[j]-vb[j]) > 1.e-6*PetscAbsScalar(va[j])) {
+        ierr = PetscPrintf(PETSC_COMM_SELF,"%s MatGetValues: wrong entry (%D,%D)\n",label,i,cols[j]);CHKERRQ(ierr);
+      }
+    }
+  }
+
+  /* used by PCPBJACOBI */
+  ierr = MatGetBlockSize(A,&bs);CHKERRQ(ierr);
+  ierr = MatInvertBlockDiagonal(A,&da);CHKERRQ(ierr);
+  ierr = MatInvertBlockDiagonal(B,&db);CHKERRQ(ierr);
+  for (i=0; i<(rend-rstart)*bs; i++) {
+    if (PetscAbsScalar(da[i]-db[i]) > 1.e-5*PetscAbsScalar(da[i])) {
+      ierr = PetscPrintf(PETSC_COMM_SELF,"%s MatInvertBlockDiagonal: wrong value %D\n",label,i);CHKERRQ(ierr);
+    }
+  }
+
+  /* X and then Y stored in single precision */
+  ierr = MatDuplicate(A,MAT_COPY_VALUES,&C);CHKERRQ(ierr);
+  ierr = MatAXPY(C,1.0,B,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatMult(C,x,y);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = MatDuplicate(B,MAT_COPY_VALUES,&C);CHKERRQ(ierr);
+  ierr = MatAXPY(C,1.0,A,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+  ierr = MatMult(C,x,z);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatAXPY",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = MatConvert(B,newtype,MAT_INITIAL_MATRIX,&C);CHKERRQ(ierr);
+  ierr = MatMult(C,x,y);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = MatMult(A,x,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatConvert",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = MatTranspose(B,MAT_INITIAL_MATRIX,&C);CHKERRQ(ierr);
+  ierr = MatMult(C,x,y);CHKERRQ(ierr);
+  ierr = MatDestroy(&C);CHKERRQ(ierr);
+  ierr = MatMultTranspose(A,x,z);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(str,sizeof(str),"%s MatTranspose",label);CHKERRQ(ierr);
+  ierr = CheckClose(y,z,str);CHKERRQ(ierr);
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckILU"
+static PetscErrorCode CheckILU(Mat A,Mat B)
+{
+  PetscErrorCode ierr;
+  Mat            FA,FB;
+  IS             row,col;
+  MatFactorInfo  info;
+  Vec            x,y,z;
+  PetscInt       k;
+
+  PetscFunctionBegin;
+  ierr = MatGetVecs(A,&x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(y,&z);CHKERRQ(ierr);
+  ierr = VecSet(x,1.0);CHKERRQ(ierr);
+  ierr = MatGetOrdering(A,MATORDERINGRCM,&row,&col);CHKERRQ(ierr);
+  ierr = MatFactorInfoInitialize(&info);CHKERRQ(ierr);
+  info.levels = 1;
+  info.fill   = 2.0;
+  ierr = MatGetFactor(A,MATSOLVERPETSC,MAT_FACTOR_ILU,&FA);CHKERRQ(ierr);
+  ierr = MatGetFactor(B,MATSOLVERPETSC,MAT_FACTOR_ILU,&FB);CHKERRQ(ierr);
+  ierr = MatILUFactorSymbolic(FA,A,row,col,&info);CHKERRQ(ierr);
+  ierr = MatILUFactorSymbolic(FB,B,row,col,&info);CHKERRQ(ierr);
+  /* the second numeric factorization reuses the factor stored in single precision */
+  for (k=0; k<2; k++) {
+    ierr = MatLUFactorNumeric(FA,A,&info);CHKERRQ(ierr);
+    ierr = MatLUFactorNumeric(FB,B,&info);CHKERRQ(ierr);
+    ierr = MatSolve(FB,x,y);CHKERRQ(ierr);
+    ierr = MatSolve(FA,x,z);CHKERRQ(ierr);
+    ierr = CheckClose(y,z,"MatSolve");CHKERRQ(ierr);
+  }
+  ierr = MatDestroy(&FA);CHKERRQ(ierr);
+  ierr = MatDestroy(&FB);CHKERRQ(ierr);
+  ierr = ISDestroy(&row);CHKERRQ(ierr);
+  ierr = ISDestroy(&col);CHKERRQ(ierr);
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "FillMatrix"
+/* a diagonally dominant banded matrix whose values are not exactly representable in single precision */
+static PetscErrorCode FillMatrix(Mat A)
+{
+  PetscErrorCode ierr;
+  PetscInt       N,rstart,rend,i,j,col;
+  PetscScalar    v;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(A,&N,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    for (j=-4; j<=4; j++) {
+      col = i + j;
+      if (col < 0 || col >= N) continue;
+      v    = j ? -1.0/(5.0+j+0.1*(i%7)) : 10.0/3.0;
+      ierr = MatSetValues(A,1,&i,1,&col,&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  Mat            A,B,Ab,Bb,C;
+  PetscErrorCode ierr;
+  PetscInt       m = 30,rstart,rend,i;
+  PetscScalar    v;
+  PetscMPIInt    size;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+
+  ierr = MatCreate(PETSC_COMM_WORLD,&A);CHKERRQ(ierr);
+  ierr = MatSetSizes(A,m,m,PETSC_DETERMINE,PETSC_DETERMINE);CHKERRQ(ierr);
+  ierr = MatSetType(A,MATAIJ);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation(A,9,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(A,9,PETSC_NULL,4,PETSC_NULL);CHKERRQ(ierr);
+  ierr = FillMatrix(A);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+
+  /* the copy is stored in single precision when it is assembled */
+  ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  ierr = MatStoreSinglePrecision(B,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = CheckMat(A,B,(MatSORType)(SOR_LOCAL_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"AIJ");CHKERRQ(ierr);
+  if (size == 1) {ierr = CheckILU(A,B);CHKERRQ(ierr);}
+
+  /* changing the values returns to full precision until the next assembly */
+  for (i=rstart; i<rend; i++) {
+    v    = 0.7;
+    ierr = MatSetValues(A,1,&i,1,&i,&v,ADD_VALUES);CHKERRQ(ierr);
+    ierr = MatSetValues(B,1,&i,1,&i,&v,ADD_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = CheckMat(A,B,(MatSORType)(SOR_LOCAL_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"AIJ set values");CHKERRQ(ierr);
+
+  ierr = MatScale(A,2.0);CHKERRQ(ierr);
+  ierr = MatScale(B,2.0);CHKERRQ(ierr);
+  ierr = CheckMat(A,B,(MatSORType)(SOR_LOCAL_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"AIJ scale");CHKERRQ(ierr);
+
+  ierr = CheckOps(A,B,MATBAIJ,"AIJ");CHKERRQ(ierr);
+  ierr = CheckMat(A,B,(MatSORType)(SOR_LOCAL_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"AIJ after the other operations");CHKERRQ(ierr);
+
+  if (size == 1) {
+    ierr = MatCreateSeqBAIJ(PETSC_COMM_SELF,3,m,m,5,PETSC_NULL,&Ab);CHKERRQ(ierr);
+    ierr = FillMatrix(Ab);CHKERRQ(ierr);
+    ierr = MatDuplicate(Ab,MAT_COPY_VALUES,&Bb);CHKERRQ(ierr);
+    ierr = MatStoreSinglePrecision(Bb,PETSC_TRUE);CHKERRQ(ierr);
+    ierr = CheckMat(Ab,Bb,(MatSORType)(SOR_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"BAIJ");CHKERRQ(ierr);
+    ierr = CheckOps(Ab,Bb,MATSEQAIJ,"BAIJ");CHKERRQ(ierr);
+    ierr = MatDestroy(&Bb);CHKERRQ(ierr);
+
+    /* the values of a matrix whose nonzero structure is shared stay in full precision */
+    ierr = MatDuplicate(Ab,MAT_COPY_VALUES,&Bb);CHKERRQ(ierr);
+    ierr = MatDuplicate(Bb,MAT_SHARE_NONZERO_PATTERN,&C);CHKERRQ(ierr);
+    ierr = MatCopy(Ab,C,SAME_NONZERO_PATTERN);CHKERRQ(ierr);
+    ierr = MatStoreSinglePrecision(Bb,PETSC_TRUE);CHKERRQ(ierr);
+    ierr = CheckMat(Ab,Bb,(MatSORType)(SOR_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"BAIJ shared structure");CHKERRQ(ierr);
+    ierr = CheckMat(Ab,C,(MatSORType)(SOR_SYMMETRIC_SWEEP | SOR_ZERO_INITIAL_GUESS),"BAIJ sharing the structure");CHKERRQ(ierr);
+    ierr = MatDestroy(&C);CHKERRQ(ierr);
+    ierr = MatDestroy(&Bb);CHKERRQ(ierr);
+    ierr = MatDestroy(&Ab);CHKERRQ(ierr);
+  }
+
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,122 @@
+
+static char help[] = "Tests VecLoad() and MatLoad() of SEQAIJ matrices using the memory mapped file, set with PetscViewerBinarySetMmap().\n\
+Each process writes and loads its own file.\n\
+Input arguments are:\n\
+  -m <rows> : number of rows of the vectors and matrices\n\n";
+
+#include <petscmat.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CreateMatrix"
+/* the matrix with the upper diagonal only has an odd number of nonzeros */
+static PetscErrorCode CreateMatrix(PetscInt m,PetscBool lower,Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,j;
+  PetscScalar    v;
+
+  PetscFunctionBegin;
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF,m,m,3,PETSC_NULL,A);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    v    = 2.0 + i;
+    ierr = MatSetValues(*A,1,&i,1,&i,&v,INSERT_VALUES);CHKERRQ(ierr);
+    j    = i+1;
+    v    = -1.0 - 0.5*i;
+    if (j < m) {ierr = MatSetValues(*A,1,&i,1,&j,&v,INSERT_VALUES);CHKERRQ(ierr);}
+    j    = i-1;
+    if (lower && j >= 0) {ierr = MatSetValues(*A,1,&i,1,&j,&v,INSERT_VALUES);CHKERRQ(ierr);}
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    rank;
+  PetscInt       m = 20,i,k;
+  PetscScalar    v;
+  Vec            x,y,lx,ly;
+  Mat            A[2],lA[2];
+  PetscViewer    viewer;
+  PetscBool      flg;
+  char           file[PETSC_MAX_PATH_LEN];
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = PetscSNPrintf(file,sizeof(file),"ex181_%d.dat",rank);CHKERRQ(ierr);
+
+  ierr = VecCreateSeq(PETSC_COMM_SELF,m,&x);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    v    = i + 100.0*rank;
+    ierr = VecSetValues(x,1,&i,&v,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+  ierr = VecSet(y,-3.0);CHKERRQ(ierr);
+  ierr = CreateMatrix(m,PETSC_FALSE,&A[0]);CHKERRQ(ierr);
+  ierr = CreateMatrix(m,PETSC_TRUE,&A[1]);CHKERRQ(ierr);
+
+  ierr = PetscViewerBinaryOpen(PETSC_COMM_SELF,file,FILE_MODE_WRITE,&viewer);CHKERRQ(ierr);
+  ierr = VecView(x,viewer);CHKERRQ(ierr);
+  ierr = MatView(A[0],viewer);CHKERRQ(ierr);
+  ierr = MatView(A[1],viewer);CHKERRQ(ierr);
+  ierr = VecView(y,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  for (k=0; k<2; k++) {
+    /* the second time the loaded objects were changed, that must not have changed the file */
+    ierr = PetscViewerBinaryOpen(PETSC_COMM_SELF,file,FILE_MODE_READ,&viewer);CHKERRQ(ierr);
+    ierr = PetscViewerBinarySetMmap(viewer,PETSC_TRUE);CHKERRQ(ierr);
+    ierr = VecCreate(PETSC_COMM_SELF,&lx);CHKERRQ(ierr);
+    ierr = VecLoad(lx,viewer);CHKERRQ(ierr);
+    for (i=0; i<2; i++) {
+      ierr = MatCreate(PETSC_COMM_SELF,&lA[i]);CHKERRQ(ierr);
+      ierr = MatSetType(lA[i],MATSEQAIJ);CHKERRQ(ierr);
+      ierr = MatLoad(lA[i],viewer);CHKERRQ(ierr);
+    }
+    /* loaded into a vector that already has its array */
+    ierr = VecDuplicate(x,&ly);CHKERRQ(ierr);
+    ierr = VecLoad(ly,viewer);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_MMAP)
+    {
+      PetscObject map;
+      ierr = PetscObjectQuery((PetscObject)lx,"PetscViewerBinaryMap",&map);CHKERRQ(ierr);
+      if (!map) {ierr = PetscPrintf(PETSC_COMM_SELF,"[%d] Vector was not loaded from the mapped file\n",rank);CHKERRQ(ierr);}
+      ierr = PetscObjectQuery((PetscObject)lA[0],"PetscViewerBinaryMap",&map);CHKERRQ(ierr);
+      if (!map) {ierr = PetscPrintf(PETSC_COMM_SELF,"[%d] Matrix was not loaded from the mapped file\n",rank);CHKERRQ(ierr);}
+    }
+#endif
+    /* the objects outlive the viewer */
+    ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+    ierr = VecEqual(x,lx,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = PetscPrintf(PETSC_COMM_SELF,"[%d] Loaded vector %D differs\n",rank,k);CHKERRQ(ierr);}
+    ierr = VecEqual(y,ly,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = PetscPrintf(PETSC_COMM_SELF,"[%d] Second loaded vector %D differs\n",rank,k);CHKERRQ(ierr);}
+    for (i=0; i<2; i++) {
+      ierr = MatEqual(A[i],lA[i],&flg);CHKERRQ(ierr);
+      if (!flg) {ierr = PetscPrintf(PETSC_COMM_SELF,"[%d] Loaded matrix %D differs\n",rank,i);CHKERRQ(ierr);}
+      ierr = MatMult(lA[i],lx,ly);CHKERRQ(ierr);
+      ierr = MatScale(lA[i],2.0);CHKERRQ(ierr);
+      ierr = MatShift(lA[i],1.0);CHKERRQ(ierr);
+      ierr = MatDestroy(&lA[i]);CHKERRQ(ierr);
+    }
+    ierr = VecSet(lx,7.0);CHKERRQ(ierr);
+    ierr = VecDestroy(&lx);CHKERRQ(ierr);
+    ierr = VecDestroy(&ly);CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = MatDestroy(&A[0]);CHKERRQ(ierr);
+  ierr = MatDestroy(&A[1]);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
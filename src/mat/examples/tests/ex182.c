@@ -0,0 +1,165 @@
+
+static char help[] = "Tests MatView() and MatLoad() of AIJ matrices stored in the partitioned format, set with PetscViewerBinarySetPartitioned().\n\
+The matrices are loaded on all the processes with different row distributions and on groups of fewer processes.\n\
+Input arguments are:\n\
+  -m <rows> : number of rows of the matrices\n\n";
+
+#include <petscmat.h>
+
+/* row i has the entries (i,j) for j = i-1, i, i+1 and 7i mod n, except the empty rows i = 3 mod 7 */
+#define InRow(i,j,n) ((i)%7 != 3 && (j) >= 0 && (j) < (n) && (((j) >= (i)-1 && (j) <= (i)+1) || (j) == (7*(i))%(n)))
+#define Value(i,j,n) (1.0 + (i)*(n) + (j))
+
+#undef __FUNCT__
+#define __FUNCT__ "CreateMatrix"
+static PetscErrorCode CreateMatrix(PetscInt m,PetscInt n,Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,j,k,rstart,rend,cols[4];
+  PetscScalar    v;
+
+  PetscFunctionBegin;
+  ierr = MatCreateAIJ(PETSC_COMM_WORLD,PETSC_DECIDE,PETSC_DECIDE,m,n,4,PETSC_NULL,4,PETSC_NULL,A);CHKERRQ(ierr);
+  ierr = MatGetOwnershipRange(*A,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    cols[0] = i-1; cols[1] = i; cols[2] = i+1; cols[3] = (7*i)%n;
+    for (k=0; k<4; k++) {
+      j = cols[k];
+      if (InRow(i,j,n)) {
+        v    = Value(i,j,n);
+        ierr = MatSetValues(*A,1,&i,1,&j,&v,INSERT_VALUES);CHKERRQ(ierr);
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(*A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckMatrix"
+/* checks the local rows of the loaded matrix, whatever its distribution */
+static PetscErrorCode CheckMatrix(Mat A,PetscInt m,PetscInt n,const char *label)
+{
+  PetscErrorCode    ierr;
+  PetscInt          i,j,k,rstart,rend,M,N,ncols,count;
+  const PetscInt    *cols;
+  const PetscScalar *vals;
+
+  PetscFunctionBegin;
+  ierr = MatGetSize(A,&M,&N);CHKERRQ(ierr);
+  if (M != m || N != n) {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"%s: loaded matrix has size %D by %D instead of %D by %D\n",label,M,N,m,n);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = MatGetOwnershipRange(A,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    for (j=0,count=0; j<n; j++) if (InRow(i,j,n)) count++;
+    ierr = MatGetRow(A,i,&ncols,&cols,&vals);CHKERRQ(ierr);
+    if (ncols != count) {ierr = PetscPrintf(PETSC_COMM_SELF,"%s: row %D has %D entries instead of %D\n",label,i,ncols,count);CHKERRQ(ierr);}
+    for (k=0; k<ncols; k++) {
+      if (!InRow(i,cols[k],n) || vals[k] != Value(i,cols[k],n)) {
+        ierr = PetscPrintf(PETSC_COMM_SELF,"%s: wrong entry (%D,%D)\n",label,i,cols[k]);CHKERRQ(ierr);
+      }
+    }
+    ierr = MatRestoreRow(A,i,&ncols,&cols,&vals);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "LoadAndCheck"
+/* loads both matrices and the vector following them, the vector has the values 0, 1, ..., m-1 */
+static PetscErrorCode LoadAndCheck(MPI_Comm comm,PetscInt mlocal,PetscInt m,const char *label)
+{
+  PetscErrorCode ierr;
+  PetscViewer    viewer;
+  Mat            A,B;
+  Vec            y;
+  PetscScalar    sum;
+  PetscInt       N;
+
+  PetscFunctionBegin;
+  ierr = PetscViewerBinaryOpen(comm,"ex182.dat",FILE_MODE_READ,&viewer);CHKERRQ(ierr);
+  ierr = MatCreate(comm,&A);CHKERRQ(ierr);
+  ierr = MatSetType(A,MATAIJ);CHKERRQ(ierr);
+  if (mlocal >= 0) {ierr = MatSetSizes(A,mlocal,mlocal,m,m);CHKERRQ(ierr);}
+  ierr = MatLoad(A,viewer);CHKERRQ(ierr);
+  ierr = MatCreate(comm,&B);CHKERRQ(ierr);
+  ierr = MatSetType(B,MATAIJ);CHKERRQ(ierr);
+  ierr = MatLoad(B,viewer);CHKERRQ(ierr);
+  ierr = VecCreate(comm,&y);CHKERRQ(ierr);
+  ierr = VecLoad(y,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  ierr = CheckMatrix(A,m,m,label);CHKERRQ(ierr);
+  ierr = CheckMatrix(B,m,m+5,label);CHKERRQ(ierr);
+  ierr = VecGetSize(y,&N);CHKERRQ(ierr);
+  ierr = VecSum(y,&sum);CHKERRQ(ierr);
+  if (N != m || PetscRealPart(sum) != m*(m-1)/2) {
+    ierr = PetscPrintf(comm,"%s: loaded vector has size %D and sum %G\n",label,N,PetscRealPart(sum));CHKERRQ(ierr);
+  }
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    rank,size;
+  PetscInt       m = 37,i,rstart,rend,mlocal,mlast;
+  PetscScalar    v;
+  Mat            A,B;
+  Vec            x;
+  PetscViewer    viewer;
+  PetscSubcomm   psubcomm;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+
+  ierr = CreateMatrix(m,m,&A);CHKERRQ(ierr);
+  ierr = CreateMatrix(m,m+5,&B);CHKERRQ(ierr);
+  ierr = MatGetVecs(A,&x,PETSC_NULL);CHKERRQ(ierr);
+  ierr = VecGetOwnershipRange(x,&rstart,&rend);CHKERRQ(ierr);
+  for (i=rstart; i<rend; i++) {
+    v    = i;
+    ierr = VecSetValues(x,1,&i,&v,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+
+  ierr = PetscViewerBinaryOpen(PETSC_COMM_WORLD,"ex182.dat",FILE_MODE_WRITE,&viewer);CHKERRQ(ierr);
+  ierr = PetscViewerBinarySetPartitioned(viewer,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = MatView(A,viewer);CHKERRQ(ierr);
+  ierr = MatView(B,viewer);CHKERRQ(ierr);
+  ierr = VecView(x,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  /* the distribution the matrices were written with */
+  ierr = LoadAndCheck(PETSC_COMM_WORLD,-1,m,"same distribution");CHKERRQ(ierr);
+
+  /* uneven local sizes, the rows of a process come from several chunks, the last process gets the remaining rows */
+  mlocal = m/(2*size);
+  mlast  = m - (size-1)*mlocal;
+  ierr   = LoadAndCheck(PETSC_COMM_WORLD,rank == size-1 ? mlast : mlocal,m,"uneven distribution");CHKERRQ(ierr);
+
+  /* groups of fewer processes, one process each when there are two */
+  ierr = PetscSubcommCreate(PETSC_COMM_WORLD,&psubcomm);CHKERRQ(ierr);
+  ierr = PetscSubcommSetNumber(psubcomm,size > 1 ? 2 : 1);CHKERRQ(ierr);
+  ierr = PetscSubcommSetType(psubcomm,PETSC_SUBCOMM_INTERLACED);CHKERRQ(ierr);
+  ierr = LoadAndCheck(psubcomm->comm,-1,m,"fewer processes");CHKERRQ(ierr);
+  ierr = PetscSubcommDestroy(&psubcomm);CHKERRQ(ierr);
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
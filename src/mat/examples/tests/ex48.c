@@ -3,6 +3,82 @@ static char help[] = "Tests the vatious routines in MatSeqBAIJ format.\n";
 
 #include <petscmat.h>
 
+#undef __FUNCT__
+#define __FUNCT__ "TestSOR"
+/*
+   Compares MatSOR() of SeqBAIJ with that of its AIJ copy. The diagonal blocks are diagonal, so the point
+   block sweeps of BAIJ and the point sweeps of AIJ give the same result.
+*/
+static PetscErrorCode TestSOR(PetscInt bs,PetscInt m,PetscRandom rdm)
+{
+  Mat            A,B;
+  Vec            b,x0,x1,x2;
+  PetscErrorCode ierr;
+  PetscInt       M = m*bs,i,j,k,r,c,row,col;
+  PetscScalar    rval;
+  PetscReal      nrm,rnorm;
+  MatSORType     types[3] = {SOR_FORWARD_SWEEP,SOR_BACKWARD_SWEEP,SOR_SYMMETRIC_SWEEP};
+  const char     *names[3] = {"forward","backward","symmetric"};
+
+  PetscFunctionBegin;
+  ierr = MatCreateSeqBAIJ(PETSC_COMM_SELF,bs,M,M,4,PETSC_NULL,&A);CHKERRQ(ierr);
+  ierr = MatCreateSeqAIJ(PETSC_COMM_SELF,M,M,4*bs,PETSC_NULL,&B);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    for (r=0; r<bs; r++) {
+      row  = bs*i+r;
+      ierr = PetscRandomGetValue(rdm,&rval);CHKERRQ(ierr);
+      rval = 4.0*bs + rval;
+      ierr = MatSetValues(A,1,&row,1,&row,&rval,INSERT_VALUES);CHKERRQ(ierr);
+      ierr = MatSetValues(B,1,&row,1,&row,&rval,INSERT_VALUES);CHKERRQ(ierr);
+    }
+    for (k=1; k<4; k++) {
+      j = (i + k*(m/4+1)) % m;
+      if (j == i) continue;
+      for (r=0; r<bs; r++) {
+        for (c=0; c<bs; c++) {
+          row  = bs*i+r; col = bs*j+c;
+          ierr = PetscRandomGetValue(rdm,&rval);CHKERRQ(ierr);
+          ierr = MatSetValues(A,1,&row,1,&col,&rval,INSERT_VALUES);CHKERRQ(ierr);
+          ierr = MatSetValues(B,1,&row,1,&col,&rval,INSERT_VALUES);CHKERRQ(ierr);
+        }
+      }
+    }
+  }
+  ierr = MatAssemblyBegin(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(A,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(B,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = MatGetVecs(A,&x0,&b);CHKERRQ(ierr);
+  ierr = VecDuplicate(x0,&x1);CHKERRQ(ierr);
+  ierr = VecDuplicate(x0,&x2);CHKERRQ(ierr);
+  ierr = VecSetRandom(b,rdm);CHKERRQ(ierr);
+  ierr = VecSetRandom(x0,rdm);CHKERRQ(ierr);
+  for (i=0; i<3; i++) {
+    for (k=0; k<2; k++) {
+      /* only the kernels of the block sizes 8 to 16 support a nonzero initial guess */
+      if (!k && (bs < 8 || bs > 16)) continue;
+      ierr = VecCopy(x0,x1);CHKERRQ(ierr);
+      ierr = VecCopy(x0,x2);CHKERRQ(ierr);
+      ierr = MatSOR(A,b,1.0,k ? (MatSORType)(types[i] | SOR_ZERO_INITIAL_GUESS) : types[i],0.0,1,1,x1);CHKERRQ(ierr);
+      ierr = MatSOR(B,b,1.0,k ? (MatSORType)(types[i] | SOR_ZERO_INITIAL_GUESS) : types[i],0.0,1,1,x2);CHKERRQ(ierr);
+      ierr = VecNorm(x2,NORM_2,&nrm);CHKERRQ(ierr);
+      ierr = VecAXPY(x1,-1.0,x2);CHKERRQ(ierr);
+      ierr = VecNorm(x1,NORM_2,&rnorm);CHKERRQ(ierr);
+      if (rnorm > 1.e-10*nrm) {
+        ierr = PetscPrintf(PETSC_COMM_SELF,"Error: MatSOR() %s sweep%s - Norm=%G bs = %D\n",names[i],k ? " with zero initial guess" : "",rnorm/nrm,bs);CHKERRQ(ierr);
+      }
+    }
+  }
+  ierr = VecDestroy(&b);CHKERRQ(ierr);
+  ierr = VecDestroy(&x0);CHKERRQ(ierr);
+  ierr = VecDestroy(&x1);CHKERRQ(ierr);
+  ierr = VecDestroy(&x2);CHKERRQ(ierr);
+  ierr = MatDestroy(&A);CHKERRQ(ierr);
+  ierr = MatDestroy(&B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "main"
 int main(int argc,char **args)
@@ -153,6 +229,9 @@ int main(int argc,char **args)
     ierr = PetscPrintf(PETSC_COMM_SELF,"Error: MatMultTransposeAdd()\n");CHKERRQ(ierr);
   }
 
+  /* Test MatSOR() */
+  ierr = TestSOR(bs,m,rdm);CHKERRQ(ierr);
+
   /* Do LUFactor() on both the matrices */
   ierr = PetscMalloc(M*sizeof(PetscInt),&idx);CHKERRQ(ierr);
   for (i=0; i<M; i++) idx[i] = i;
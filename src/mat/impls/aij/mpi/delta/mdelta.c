@@ -0,0 +1,260 @@
+
+/*
+  Defines the MATMPIAIJDELTA matrix class. This class is derived from the MATMPIAIJ
+  class; the diagonal and off-diagonal parts of the local submatrix are stored
+  as MATSEQAIJDELTA matrices, so the parallel products (including the overlap of
+  communication and computation done by MATMPIAIJ) read 16 bit column differences.
+
+  The column indices of the off-diagonal part are compressed to the columns that
+  actually appear, so their differences are small as well.
+
+   See src/mat/impls/aij/seq/delta/delta.c for the sequential version
+*/
+
+#include <../src/mat/impls/aij/mpi/mpiaij.h>
+#include <../src/mat/impls/aij/seq/delta/delta.h>
+
+EXTERN_C_BEGIN
+extern PetscErrorCode MatConvert_SeqAIJ_SeqAIJDelta(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode MatConvert_SeqAIJDelta_SeqAIJ(Mat,MatType,MatReuse,Mat*);
+EXTERN_C_END
+extern PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat,MatAssemblyType);
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMPIAIJDeltaSetUpLocal_Private"
+/*
+   Makes sure the local diagonal and off-diagonal blocks are of type MATSEQAIJDELTA; MatDisAssemble_MPIAIJ()
+   replaces the off-diagonal block by a plain MATSEQAIJ matrix when new nonzeros are inserted.
+*/
+static PetscErrorCode MatMPIAIJDeltaSetUpLocal_Private(Mat A)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  PetscBool      flg;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (a->A) {
+    ierr = PetscObjectTypeCompare((PetscObject)a->A,MATSEQAIJDELTA,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = MatConvert_SeqAIJ_SeqAIJDelta(a->A,MATSEQAIJDELTA,MAT_REUSE_MATRIX,&a->A);CHKERRQ(ierr);}
+  }
+  if (a->B) {
+    ierr = PetscObjectTypeCompare((PetscObject)a->B,MATSEQAIJDELTA,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = MatConvert_SeqAIJ_SeqAIJDelta(a->B,MATSEQAIJDELTA,MAT_REUSE_MATRIX,&a->B);CHKERRQ(ierr);}
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_MPIAIJDelta"
+PetscErrorCode MatAssemblyEnd_MPIAIJDelta(Mat A,MatAssemblyType mode)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatAssemblyEnd_MPIAIJ(A,mode);CHKERRQ(ierr);
+  ierr = MatMPIAIJDeltaSetUpLocal_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDestroy_MPIAIJDelta"
+PetscErrorCode MatDestroy_MPIAIJDelta(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_mpiaijdelta_mpiaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)A,MATMPIAIJ);CHKERRQ(ierr);
+  ierr = MatDestroy_MPIAIJ(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatMPIAIJSetPreallocation_MPIAIJDelta"
+PetscErrorCode  MatMPIAIJSetPreallocation_MPIAIJDelta(Mat B,PetscInt d_nz,const PetscInt d_nnz[],PetscInt o_nz,const PetscInt o_nnz[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJSetPreallocation_MPIAIJ(B,d_nz,d_nnz,o_nz,o_nnz);CHKERRQ(ierr);
+  ierr = MatMPIAIJDeltaSetUpLocal_Private(B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_MPIAIJDelta_MPIAIJ"
+PetscErrorCode  MatConvert_MPIAIJDelta_MPIAIJ(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  /* This routine is only called to convert a MATMPIAIJDELTA to its base PETSc type, */
+  /* so we will ignore 'MatType type'. */
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+  Mat_MPIAIJ     *b;
+  PetscBool      flg;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+  b = (Mat_MPIAIJ*)B->data;
+  if (b->A) {
+    ierr = PetscObjectTypeCompare((PetscObject)b->A,MATSEQAIJDELTA,&flg);CHKERRQ(ierr);
+    if (flg) {ierr = MatConvert_SeqAIJDelta_SeqAIJ(b->A,MATSEQAIJ,MAT_REUSE_MATRIX,&b->A);CHKERRQ(ierr);}
+  }
+  if (b->B) {
+    ierr = PetscObjectTypeCompare((PetscObject)b->B,MATSEQAIJDELTA,&flg);CHKERRQ(ierr);
+    if (flg) {ierr = MatConvert_SeqAIJDelta_SeqAIJ(b->B,MATSEQAIJ,MAT_REUSE_MATRIX,&b->B);CHKERRQ(ierr);}
+  }
+
+  /* Reset the original function pointers. */
+  B->ops->assemblyend = MatAssemblyEnd_MPIAIJ;
+  B->ops->destroy     = MatDestroy_MPIAIJ;
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatMPIAIJSetPreallocation_C","MatMPIAIJSetPreallocation_MPIAIJ",MatMPIAIJSetPreallocation_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaijdelta_mpiaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATMPIAIJ);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+/* MatConvert_MPIAIJ_MPIAIJDelta converts a MPIAIJ matrix into a
+ * MPIAIJDelta matrix.  This routine is called by the MatCreate_MPIAIJDelta()
+ * routine, but can also be used to convert an assembled MPIAIJ matrix
+ * into a MPIAIJDelta one. */
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_MPIAIJ_MPIAIJDelta"
+PetscErrorCode  MatConvert_MPIAIJ_MPIAIJDelta(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+
+  /* Set function pointers for methods that we inherit from MPIAIJ but override. */
+  B->ops->assemblyend = MatAssemblyEnd_MPIAIJDelta;
+  B->ops->destroy     = MatDestroy_MPIAIJDelta;
+
+  /* If A has already been preallocated, convert the local blocks now. */
+  ierr = MatMPIAIJDeltaSetUpLocal_Private(B);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatMPIAIJSetPreallocation_C","MatMPIAIJSetPreallocation_MPIAIJDelta",MatMPIAIJSetPreallocation_MPIAIJDelta);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaijdelta_mpiaij_C","MatConvert_MPIAIJDelta_MPIAIJ",MatConvert_MPIAIJDelta_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATMPIAIJDELTA);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCreateAIJDelta"
+/*@C
+   MatCreateAIJDelta - Creates a sparse parallel matrix whose local
+   portions are stored as SEQAIJDELTA matrices (a matrix class that inherits
+   from SEQAIJ but stores an additional copy of the column indices as 16 bit
+   differences, which reduces the memory traffic of the matrix vector
+   products).  The same guidelines that apply to MPIAIJ matrices for
+   preallocating the matrix storage apply here as well.
+
+   Collective on MPI_Comm
+
+   Input Parameters:
++  comm - MPI communicator
+.  m - number of local rows (or PETSC_DECIDE to have calculated if M is given)
+           This value should be the same as the local size used in creating the
+           y vector for the matrix-vector product y = Ax.
+.  n - This value should be the same as the local size used in creating the
+       x vector for the matrix-vector product y = Ax. (or PETSC_DECIDE to have
+       calculated if N is given) For square matrices n is almost always m.
+.  M - number of global rows (or PETSC_DETERMINE to have calculated if m is given)
+.  N - number of global columns (or PETSC_DETERMINE to have calculated if n is given)
+.  d_nz  - number of nonzeros per row in DIAGONAL portion of local submatrix
+           (same value is used for all local rows)
+.  d_nnz - array containing the number of nonzeros in the various rows of the
+           DIAGONAL portion of the local submatrix (possibly different for each row)
+           or PETSC_NULL, if d_nz is used to specify the nonzero structure.
+.  o_nz  - number of nonzeros per row in the OFF-DIAGONAL portion of local
+           submatrix (same value is used for all local rows).
+-  o_nnz - array containing the number of nonzeros in the various rows of the
+           OFF-DIAGONAL portion of the local submatrix (possibly different for
+           each row) or PETSC_NULL, if o_nz is used to specify the nonzero
+           structure.
+
+   Output Parameter:
+.  A - the matrix
+
+   Notes:
+   If the *_nnz parameter is given then the *_nz parameter is ignored
+
+   When calling this routine with a single process communicator, a matrix of
+   type SEQAIJDELTA is returned.
+
+   Level: intermediate
+
+.keywords: matrix, aij, compressed indices, sparse, parallel
+
+.seealso: MatCreate(), MatCreateSeqAIJDelta(), MatCreateAIJ(), MatSetValues(), MATAIJDELTA
+@*/
+PetscErrorCode  MatCreateAIJDelta(MPI_Comm comm,PetscInt m,PetscInt n,PetscInt M,PetscInt N,PetscInt d_nz,const PetscInt d_nnz[],PetscInt o_nz,const PetscInt o_nnz[],Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(comm,A);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,m,n,M,N);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  if (size > 1) {
+    ierr = MatSetType(*A,MATMPIAIJDELTA);CHKERRQ(ierr);
+    ierr = MatMPIAIJSetPreallocation(*A,d_nz,d_nnz,o_nz,o_nnz);CHKERRQ(ierr);
+  } else {
+    ierr = MatSetType(*A,MATSEQAIJDELTA);CHKERRQ(ierr);
+    ierr = MatSeqAIJSetPreallocation(*A,d_nz,d_nnz);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatCreate_MPIAIJDelta"
+PetscErrorCode  MatCreate_MPIAIJDelta(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSetType(A,MATMPIAIJ);CHKERRQ(ierr);
+  ierr = MatConvert_MPIAIJ_MPIAIJDelta(A,MATMPIAIJDELTA,MAT_REUSE_MATRIX,&A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+/*MC
+   MATAIJDELTA - MATAIJDELTA = "aijdelta" - A matrix type to be used for sparse matrices.
+
+   This matrix type is identical to MATSEQAIJDELTA when constructed with a single process communicator,
+   and MATMPIAIJDELTA otherwise.  As a result, for single process communicators,
+  MatSeqAIJSetPreallocation() is supported, and similarly MatMPIAIJSetPreallocation() is supported
+  for communicators controlling multiple processes.  It is recommended that you call both of
+  the above preallocation routines for simplicity.
+
+   The matrix is stored in AIJ format, plus a copy of the column indices as 16 bit differences between
+   consecutive columns of each row, which is used for MatMult(), MatMultAdd(), MatMultTranspose() and
+   MatMultTransposeAdd(); the products read 2 bytes per column index instead of 4 (or 8 with
+   --with-64-bit-indices). Rows in which two consecutive columns are more than 65535 apart keep
+   using the AIJ column indices. All other operations use the AIJ data. Use MatConvert() to switch
+   between MATAIJ and MATAIJDELTA.
+
+   Options Database Keys:
+. -mat_type aijdelta - sets the matrix type to "aijdelta" during a call to MatSetFromOptions()
+
+  Level: beginner
+
+.seealso: MatCreateAIJDelta(), MatCreateSeqAIJDelta(), MATSEQAIJDELTA, MATMPIAIJDELTA, MATSELL, MATAIJCRL
+M*/
@@ -650,6 +650,43 @@ PetscErrorCode MatAssemblyBegin_MPIAIJ(Mat mat,MatAssemblyType mode)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "MatStashLocate_MPIAIJ"
+/*
+   Finds where the entry (row,col) of a local row is stored: loc >= 0 is its position in the values of
+   the diagonal block, loc <= -2 is position -(loc+2) in the off-diagonal block, and -1 means it is
+   not in the nonzero structure.
+*/
+static PetscErrorCode MatStashLocate_MPIAIJ(Mat mat,PetscInt row,PetscInt col,PetscInt *loc)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)aij->A->data,*b = (Mat_SeqAIJ*)aij->B->data;
+  PetscInt       lrow = row - mat->rmap->rstart,k;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  *loc = -1;
+  if (col < 0) PetscFunctionReturn(0);
+  if (col >= mat->cmap->rstart && col < mat->cmap->rend) {
+    ierr = PetscFindInt(col - mat->cmap->rstart,a->ilen[lrow],a->j+a->i[lrow],&k);CHKERRQ(ierr);
+    if (k >= 0) *loc = a->i[lrow] + k;
+  } else {
+    if (!aij->colmap) {
+      ierr = MatCreateColmap_MPIAIJ_Private(mat);CHKERRQ(ierr);
+    }
+#if defined (PETSC_USE_CTABLE)
+    ierr = PetscTableFind(aij->colmap,col+1,&col);CHKERRQ(ierr);
+    col--;
+#else
+    col = aij->colmap[col] - 1;
+#endif
+    if (col < 0) PetscFunctionReturn(0);
+    ierr = PetscFindInt(col,b->ilen[lrow],b->j+b->i[lrow],&k);CHKERRQ(ierr);
+    if (k >= 0) *loc = -(b->i[lrow] + k) - 2;
+  }
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatAssemblyEnd_MPIAIJ"
 PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
@@ -658,19 +695,46 @@ PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
   Mat_SeqAIJ     *a=(Mat_SeqAIJ *)aij->A->data;
   PetscErrorCode ierr;
   PetscMPIInt    n;
-  PetscInt       i,j,rstart,ncols,flg;
-  PetscInt       *row,*col;
-  PetscBool      other_disassembled;
-  PetscScalar    *val;
+  PetscInt       i,j,rstart,ncols,flg,nonewB;
+  PetscInt       *row,*col,*loc,*locstate = PETSC_NULL;
+  PetscBool      other_disassembled,frozen,computeloc = PETSC_FALSE;
+  PetscScalar    *val,*aa,*ba;
   InsertMode     addv = mat->insertmode;
 
   /* do not use 'b = (Mat_SeqAIJ *)aij->B->data' as B can be reset in disassembly */
   PetscFunctionBegin;
   if (!aij->donotstash && !mat->nooffprocentries) {
+    /* once the nonzero structure cannot change, the entries received with a MAT_SAME_OFF_PROC_ENTRIES plan are
+       located once and then added directly into the storage, as long as the number of nonzeros is unchanged;
+       MAT_NEW_NONZERO_ALLOCATION_ERR (nonew == -2) still allows new nonzeros in the preallocated space */
+    nonewB = ((Mat_SeqAIJ*)aij->B->data)->nonew;
+    frozen = (PetscBool)(mat->was_assembled && (a->nonew == 1 || a->nonew == -1) && (nonewB == 1 || nonewB == -1));
     while (1) {
       ierr = MatStashScatterGetMesg_Private(&mat->stash,&n,&row,&col,&val,&flg);CHKERRQ(ierr);
       if (!flg) break;
 
+      ierr = MatStashPlanGetMesgLocations_Private(&mat->stash,&loc,&locstate);CHKERRQ(ierr);
+      if (loc && frozen) {
+        if (locstate[0] != a->nz || locstate[1] != ((Mat_SeqAIJ*)aij->B->data)->nz) computeloc = PETSC_TRUE;
+        if (computeloc) {
+          for (i=0; i<n; i++) {ierr = MatStashLocate_MPIAIJ(mat,row[i],col[i],loc+i);CHKERRQ(ierr);}
+        }
+        aa = a->a;
+        ba = ((Mat_SeqAIJ*)aij->B->data)->a;
+        for (i=0; i<n; i++) {
+          if (loc[i] >= 0) {
+            if (addv == ADD_VALUES) aa[loc[i]] += val[i];
+            else                    aa[loc[i]]  = val[i];
+          } else if (loc[i] < -1) {
+            if (addv == ADD_VALUES) ba[-(loc[i]+2)] += val[i];
+            else                    ba[-(loc[i]+2)]  = val[i];
+          } else {
+            ierr = MatSetValues_MPIAIJ(mat,1,row+i,1,col+i,val+i,addv);CHKERRQ(ierr);
+          }
+        }
+        continue;
+      }
+
       for (i=0; i<n;) {
         /* Now identify the consecutive vals belonging to the same row */
         for (j=i,rstart=row[j]; j<n; j++) { if (row[j] != rstart) break; }
@@ -681,6 +745,10 @@ PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
         i = j;
       }
     }
+    if (computeloc) {
+      locstate[0] = a->nz;
+      locstate[1] = ((Mat_SeqAIJ*)aij->B->data)->nz;
+    }
     ierr = MatStashScatterEnd_Private(&mat->stash);CHKERRQ(ierr);
   }
   ierr = MatAssemblyBegin(aij->A,mode);CHKERRQ(ierr);
@@ -715,6 +783,7 @@ PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat mat,MatAssemblyType mode)
 
   ierr = VecDestroy(&aij->diag);CHKERRQ(ierr);
   if (a->inode.size) mat->ops->multdiagonalblock = MatMultDiagonalBlock_MPIAIJ;
+  if (aij->storesingle && mode == MAT_FINAL_ASSEMBLY) {ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);}
   PetscFunctionReturn(0);
 }
 
@@ -1293,11 +1362,13 @@ PetscErrorCode MatDestroy_MPIAIJ(Mat mat)
   ierr = VecScatterDestroy(&aij->Mvctx);CHKERRQ(ierr);
   ierr = PetscFree2(aij->rowvalues,aij->rowindices);CHKERRQ(ierr);
   ierr = PetscFree(aij->ld);CHKERRQ(ierr);
+  ierr = PetscFree(aij->singleops);CHKERRQ(ierr);
   ierr = PetscFree(mat->data);CHKERRQ(ierr);
 
   ierr = PetscObjectChangeTypeName((PetscObject)mat,0);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatStoreValues_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatRetrieveValues_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)mat,"MatStoreSinglePrecision_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatGetDiagonalBlock_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatIsTranspose_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)mat,"MatMPIAIJSetPreallocation_C","",PETSC_NULL);CHKERRQ(ierr);
@@ -1322,11 +1393,37 @@ PetscErrorCode MatView_MPIAIJ_Binary(Mat mat,PetscViewer viewer)
   PetscScalar       *column_values;
   PetscInt          message_count,flowcontrolcount;
   FILE              *file;
+  PetscBool         partitioned;
 
   PetscFunctionBegin;
   ierr = MPI_Comm_rank(((PetscObject)mat)->comm,&rank);CHKERRQ(ierr);
   ierr = MPI_Comm_size(((PetscObject)mat)->comm,&size);CHKERRQ(ierr);
   nz   = A->nz + B->nz;
+  ierr = PetscViewerBinaryGetPartitioned(viewer,&partitioned);CHKERRQ(ierr);
+  if (partitioned) {
+    /* each process hands over its rows in the global column order */
+    ierr = PetscMalloc3(mat->rmap->n+1,PetscInt,&row_lengths,nz+1,PetscInt,&column_indices,nz+1,PetscScalar,&column_values);CHKERRQ(ierr);
+    cnt  = 0;
+    for (i=0; i<mat->rmap->n; i++) {
+      row_lengths[i] = A->i[i+1] - A->i[i] + B->i[i+1] - B->i[i];
+      for (j=B->i[i]; j<B->i[i+1]; j++) {
+        if ((col = garray[B->j[j]]) > cstart) break;
+        column_values[cnt]    = B->a[j];
+        column_indices[cnt++] = col;
+      }
+      for (k=A->i[i]; k<A->i[i+1]; k++) {
+        column_values[cnt]    = A->a[k];
+        column_indices[cnt++] = A->j[k] + cstart;
+      }
+      for (; j<B->i[i+1]; j++) {
+        column_values[cnt]    = B->a[j];
+        column_indices[cnt++] = garray[B->j[j]];
+      }
+    }
+    ierr = MatView_Binary_Partitioned_Private(mat,viewer,nz,row_lengths,column_indices,column_values);CHKERRQ(ierr);
+    ierr = PetscFree3(row_lengths,column_indices,column_values);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (!rank) {
     header[0] = MAT_FILE_CLASSID;
     header[1] = mat->rmap->N;
@@ -2317,6 +2414,13 @@ PetscErrorCode MatAXPY_MPIAIJ(Mat Y,PetscScalar a,Mat X,MatStructure str)
   Mat_SeqAIJ     *x,*y;
 
   PetscFunctionBegin;
+  if (xx->singleops) {
+    /* the values of X are stored in single precision, MatAXPY_MPIAIJ_Single() has already unpacked Y */
+    ierr = MatMPIAIJUnpackSingle_Private(X);CHKERRQ(ierr);
+    ierr = MatAXPY_MPIAIJ(Y,a,X,str);CHKERRQ(ierr);
+    ierr = MatMPIAIJPackSingle_Private(X);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (str == SAME_NONZERO_PATTERN) {
     PetscScalar alpha = a;
     x = (Mat_SeqAIJ *)xx->A->data;
@@ -3319,6 +3423,7 @@ PetscErrorCode  MatMPIAIJSetPreallocation_MPIAIJ(Mat B,PetscInt d_nz,const Petsc
     }
   }
   b = (Mat_MPIAIJ*)B->data;
+  ierr = MatMPIAIJUnpackSingle_Private(B);CHKERRQ(ierr);
 
   if (!B->preallocated) {
     /* Explicitly create 2 MATSEQAIJ matrices. */
@@ -3425,14 +3530,15 @@ PetscErrorCode MatLoad_MPIAIJ(Mat newMat, PetscViewer viewer)
   PetscInt       cend,cstart,n,*rowners,sizesset=1;
   int            fd;
   PetscInt       bs = 1;
+  PetscBool      useMPIIO = PETSC_FALSE;
 
   PetscFunctionBegin;
   ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
   ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryRead(viewer,header,4,PETSC_INT);CHKERRQ(ierr);
+  if (header[0] != MAT_FILE_CLASSID) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"not matrix object");
   if (!rank) {
     ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
-    ierr = PetscBinaryRead(fd,(char *)header,4,PETSC_INT);CHKERRQ(ierr);
-    if (header[0] != MAT_FILE_CLASSID) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"not matrix object");
   }
 
   ierr = PetscOptionsBegin(comm,PETSC_NULL,"Options for loading SEQAIJ matrix","Mat");CHKERRQ(ierr);
@@ -3441,7 +3547,6 @@ PetscErrorCode MatLoad_MPIAIJ(Mat newMat, PetscViewer viewer)
 
   if (newMat->rmap->n < 0 && newMat->rmap->N < 0 && newMat->cmap->n < 0 && newMat->cmap->N < 0) sizesset = 0;
 
-  ierr = MPI_Bcast(header+1,3,MPIU_INT,0,comm);CHKERRQ(ierr);
   M = header[1]; N = header[2];
   /* If global rows/cols are set to PETSC_DECIDE, set it to the sizes given in the file */
   if (sizesset && newMat->rmap->N < 0) newMat->rmap->N = M;
@@ -3459,6 +3564,24 @@ PetscErrorCode MatLoad_MPIAIJ(Mat newMat, PetscViewer viewer)
   if (newMat->rmap->n < 0 ) m    = bs*((M/bs)/size + (((M/bs) % size) > rank)); /* PETSC_DECIDE */
   else m = newMat->rmap->n; /* Set by user */
 
+  /* each process reads its own rows */
+  if (header[3] == MATRIX_BINARY_FORMAT_PARTITIONED) {
+    if (N != M) {
+      if (newMat->cmap->n < 0) n = N/size + ((N % size) > rank);
+      else n = newMat->cmap->n;
+    } else n = m;
+    if (!sizesset) {
+      ierr = MatSetSizes(newMat,m,n,M,N);CHKERRQ(ierr);
+    }
+    if (bs > 1) {ierr = MatSetBlockSize(newMat,bs);CHKERRQ(ierr);}
+    ierr = MatLoad_Binary_Partitioned_Private(newMat,viewer);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#if defined(PETSC_HAVE_MPIIO)
+  ierr = PetscViewerBinaryGetMPIIO(viewer,&useMPIIO);CHKERRQ(ierr);
+#endif
+  if (useMPIIO) SETERRQ(comm,PETSC_ERR_SUP,"MPI-IO viewers only load matrices stored with PetscViewerBinarySetPartitioned()");
+
   ierr = PetscMalloc((size+1)*sizeof(PetscInt),&rowners);CHKERRQ(ierr);
   ierr = MPI_Allgather(&m,1,MPIU_INT,rowners+1,1,MPIU_INT,comm);CHKERRQ(ierr);
 
@@ -5516,6 +5639,8 @@ PetscErrorCode  MatGetCommunicationStructs(Mat A, Vec *lvec, PetscInt *colmap[],
 
 EXTERN_C_BEGIN
 extern PetscErrorCode  MatConvert_MPIAIJ_MPIAIJCRL(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode  MatConvert_MPIAIJ_MPISELL(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode  MatConvert_MPIAIJ_MPIAIJDelta(Mat,MatType,MatReuse,Mat*);
 extern PetscErrorCode  MatConvert_MPIAIJ_MPIAIJPERM(Mat,MatType,MatReuse,Mat*);
 extern PetscErrorCode  MatConvert_MPIAIJ_MPISBAIJ(Mat,MatType,MatReuse,Mat*);
 EXTERN_C_END
@@ -5675,6 +5800,9 @@ PetscErrorCode  MatCreate_MPIAIJ(Mat B)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatRetrieveValues_C",
                                      "MatRetrieveValues_MPIAIJ",
                                      MatRetrieveValues_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatStoreSinglePrecision_C",
+                                     "MatStoreSinglePrecision_MPIAIJ",
+                                     MatStoreSinglePrecision_MPIAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatGetDiagonalBlock_C",
                                      "MatGetDiagonalBlock_MPIAIJ",
                                      MatGetDiagonalBlock_MPIAIJ);CHKERRQ(ierr);
@@ -5696,6 +5824,12 @@ PetscErrorCode  MatCreate_MPIAIJ(Mat B)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaij_mpiaijcrl_C",
                                      "MatConvert_MPIAIJ_MPIAIJCRL",
                                       MatConvert_MPIAIJ_MPIAIJCRL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaij_mpisell_C",
+                                     "MatConvert_MPIAIJ_MPISELL",
+                                      MatConvert_MPIAIJ_MPISELL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaij_mpiaijdelta_C",
+                                     "MatConvert_MPIAIJ_MPIAIJDelta",
+                                      MatConvert_MPIAIJ_MPIAIJDelta);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpiaij_mpisbaij_C",
                                      "MatConvert_MPIAIJ_MPISBAIJ",
                                       MatConvert_MPIAIJ_MPISBAIJ);CHKERRQ(ierr);
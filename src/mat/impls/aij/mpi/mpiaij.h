@@ -72,6 +72,10 @@ typedef struct {
   /* used by MatMatMatMult() */
   Mat_MatMatMatMult *matmatmatmult;
 
+  /* Used by MatStoreSinglePrecision() */
+  PetscBool      storesingle;      /* store the values of A and B in single precision after each final assembly */
+  struct _MatOps *singleops;       /* the operations of the matrix while A and B are stored in single precision */
+
   /* Used by MPICUSP and MPICUSPARSE classes */
   void * spptr;
 } Mat_MPIAIJ;
@@ -111,8 +115,12 @@ extern PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ(Mat,Mat,Mat);
 extern PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ(Mat,Mat,Mat);
+extern PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ_allatonce(Mat,Mat,PetscReal,Mat*);
+extern PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ_allatonce(Mat,Mat,Mat);
 extern PetscErrorCode MatDestroy_MPIAIJ_PtAP(Mat);
 extern PetscErrorCode MatDestroy_MPIAIJ(Mat);
+extern PetscErrorCode MatMPIAIJPackSingle_Private(Mat);
+extern PetscErrorCode MatMPIAIJUnpackSingle_Private(Mat);
 
 extern PetscErrorCode MatGetBrowsOfAoCols_MPIAIJ(Mat,Mat,MatReuse,PetscInt**,PetscInt**,MatScalar**,Mat*);
 extern PetscErrorCode MatSetValues_MPIAIJ(Mat,PetscInt,const PetscInt[],PetscInt,const PetscInt[],const PetscScalar [],InsertMode);
@@ -130,6 +138,7 @@ extern PetscErrorCode MatGetSeqNonzeroStructure_MPIAIJ(Mat,Mat*);
 
 EXTERN_C_BEGIN
 extern PetscErrorCode MatMPIAIJSetPreallocation_MPIAIJ(Mat,PetscInt,const PetscInt[],PetscInt,const PetscInt[]);
+extern PetscErrorCode MatStoreSinglePrecision_MPIAIJ(Mat,PetscBool);
 EXTERN_C_END
 
 #if !defined(PETSC_USE_COMPLEX) && !defined(PETSC_USE_REAL_SINGLE) && !defined(PETSC_USE_REAL___FLOAT128)
@@ -0,0 +1,289 @@
+/*
+   Storage of the values of MPIAIJ matrices in single precision, see MatStoreSinglePrecision()
+
+   The diagonal and off-diagonal blocks are stored in single precision by the SeqAIJ code; the parallel
+   matrix only saves its operations and replaces them with a list that either calls the blocks or returns
+   the blocks to full precision first.
+*/
+#include <../src/mat/impls/aij/mpi/mpiaij.h>   /*I "petscmat.h" I*/
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValues_MPIAIJ_Single"
+static PetscErrorCode MatSetValues_MPIAIJ_Single(Mat mat,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->setvalues)(mat,m,im,n,in,v,is);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyBegin_MPIAIJ_Single"
+/* the values received from other processes are added into the blocks during the assembly, also on the processes that set no values */
+static PetscErrorCode MatAssemblyBegin_MPIAIJ_Single(Mat mat,MatAssemblyType mode)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->assemblybegin)(mat,mode);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRows_MPIAIJ_Single"
+static PetscErrorCode MatZeroRows_MPIAIJ_Single(Mat mat,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->zerorows)(mat,N,rows,diag,x,b);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRowsColumns_MPIAIJ_Single"
+static PetscErrorCode MatZeroRowsColumns_MPIAIJ_Single(Mat mat,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->zerorowscolumns)(mat,N,rows,diag,x,b);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDiagonalScale_MPIAIJ_Single"
+static PetscErrorCode MatDiagonalScale_MPIAIJ_Single(Mat mat,Vec ll,Vec rr)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->diagonalscale)(mat,ll,rr);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatNorm_MPIAIJ_Single"
+static PetscErrorCode MatNorm_MPIAIJ_Single(Mat mat,NormType type,PetscReal *nrm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->norm)(mat,type,nrm);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatView_MPIAIJ_Single"
+static PetscErrorCode MatView_MPIAIJ_Single(Mat mat,PetscViewer viewer)
+{
+  PetscErrorCode    ierr;
+  PetscBool         iascii;
+  PetscViewerFormat format;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->view)(mat,viewer);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerGetFormat(viewer,&format);CHKERRQ(ierr);
+    if (format == PETSC_VIEWER_ASCII_INFO || format == PETSC_VIEWER_ASCII_INFO_DETAIL) {
+      ierr = PetscViewerASCIIPrintf(viewer,"values stored in single precision\n");CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDuplicate_MPIAIJ_Single"
+static PetscErrorCode MatDuplicate_MPIAIJ_Single(Mat mat,MatDuplicateOption op,Mat *B)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->duplicate)(mat,op,B);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  ((Mat_MPIAIJ*)(*B)->data)->storesingle = aij->storesingle;
+  ierr = MatMPIAIJPackSingle_Private(*B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetSubMatrices_MPIAIJ_Single"
+static PetscErrorCode MatGetSubMatrices_MPIAIJ_Single(Mat mat,PetscInt n,const IS irow[],const IS icol[],MatReuse scall,Mat *B[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->getsubmatrices)(mat,n,irow,icol,scall,B);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetSubMatrix_MPIAIJ_Single"
+static PetscErrorCode MatGetSubMatrix_MPIAIJ_Single(Mat mat,IS isrow,IS iscol,MatReuse scall,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->getsubmatrix)(mat,isrow,iscol,scall,B);CHKERRQ(ierr);
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAXPY_MPIAIJ_Single"
+/* MatAXPY_MPIAIJ() itself unpacks X when only X is stored in single precision */
+static PetscErrorCode MatAXPY_MPIAIJ_Single(Mat Y,PetscScalar a,Mat X,MatStructure str)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(Y);CHKERRQ(ierr);
+  ierr = (*Y->ops->axpy)(Y,a,X,str);CHKERRQ(ierr);
+  /* with a different nonzero pattern the data of Y was replaced */
+  ((Mat_MPIAIJ*)Y->data)->storesingle = PETSC_TRUE;
+  ierr = MatMPIAIJPackSingle_Private(Y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatTranspose_MPIAIJ_Single"
+static PetscErrorCode MatTranspose_MPIAIJ_Single(Mat mat,MatReuse reuse,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  ierr = (*mat->ops->transpose)(mat,reuse,B);CHKERRQ(ierr);
+  /* the in place transpose replaced the data of mat */
+  ((Mat_MPIAIJ*)mat->data)->storesingle = PETSC_TRUE;
+  ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetOps_MPIAIJ_Single"
+static PetscErrorCode MatSetOps_MPIAIJ_Single(Mat mat)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  struct _MatOps *full = aij->singleops;
+
+  PetscFunctionBegin;
+  mat->ops->setvalues       = MatSetValues_MPIAIJ_Single;
+  mat->ops->assemblybegin   = MatAssemblyBegin_MPIAIJ_Single;
+  mat->ops->assemblyend     = full->assemblyend;
+  mat->ops->zerorows        = MatZeroRows_MPIAIJ_Single;
+  mat->ops->zerorowscolumns = MatZeroRowsColumns_MPIAIJ_Single;
+  mat->ops->diagonalscale   = MatDiagonalScale_MPIAIJ_Single;
+  mat->ops->norm            = MatNorm_MPIAIJ_Single;
+  mat->ops->view            = MatView_MPIAIJ_Single;
+  mat->ops->duplicate       = MatDuplicate_MPIAIJ_Single;
+  mat->ops->getsubmatrices  = MatGetSubMatrices_MPIAIJ_Single;
+  mat->ops->getsubmatrix    = MatGetSubMatrix_MPIAIJ_Single;
+  mat->ops->axpy            = full->axpy ? MatAXPY_MPIAIJ_Single : 0;
+  mat->ops->transpose       = full->transpose ? MatTranspose_MPIAIJ_Single : 0;
+
+  /* these call the operations of the blocks, which work on the single precision values */
+  mat->ops->mult                = full->mult;
+  mat->ops->multadd             = full->multadd;
+  mat->ops->multtranspose       = full->multtranspose;
+  mat->ops->multtransposeadd    = full->multtransposeadd;
+  mat->ops->sor                 = full->sor;
+  mat->ops->getdiagonal         = full->getdiagonal;
+  mat->ops->getrow              = full->getrow;
+  mat->ops->restorerow          = full->restorerow;
+  mat->ops->getvalues           = full->getvalues;
+  mat->ops->invertblockdiagonal = full->invertblockdiagonal;
+  mat->ops->scale               = full->scale;
+  mat->ops->zeroentries         = full->zeroentries;
+  mat->ops->destroy             = full->destroy;
+  mat->ops->setoption           = full->setoption;
+  mat->ops->getinfo             = full->getinfo;
+  mat->ops->getvecs             = full->getvecs;
+  mat->ops->increaseoverlap     = full->increaseoverlap;
+  mat->ops->getghosts           = full->getghosts;
+  mat->ops->setblocksizes       = full->setblocksizes;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMPIAIJPackSingle_Private"
+/*
+   MatMPIAIJPackSingle_Private - Stores the values of both blocks of an assembled MPIAIJ matrix in single precision
+*/
+PetscErrorCode MatMPIAIJPackSingle_Private(Mat mat)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!aij->storesingle || aij->singleops) PetscFunctionReturn(0);
+  ierr = MatSeqAIJPackSingle_Private(aij->A);CHKERRQ(ierr);
+  ierr = MatSeqAIJPackSingle_Private(aij->B);CHKERRQ(ierr);
+  ierr = PetscNew(struct _MatOps,&aij->singleops);CHKERRQ(ierr);
+  *aij->singleops = *mat->ops;
+  ierr = PetscMemzero(mat->ops,sizeof(struct _MatOps));CHKERRQ(ierr);
+  ierr = MatSetOps_MPIAIJ_Single(mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMPIAIJUnpackSingle_Private"
+/*
+   MatMPIAIJUnpackSingle_Private - Returns both blocks to full precision and restores the operations
+*/
+PetscErrorCode MatMPIAIJUnpackSingle_Private(Mat mat)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!aij->singleops) PetscFunctionReturn(0);
+  if (aij->getrowactive) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"MatRestoreRow() must be called first");
+  ierr = MatSeqAIJUnpackSingle_Private(aij->A);CHKERRQ(ierr);
+  ierr = MatSeqAIJUnpackSingle_Private(aij->B);CHKERRQ(ierr);
+  *mat->ops = *aij->singleops;
+  ierr = PetscFree(aij->singleops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision_MPIAIJ"
+PetscErrorCode MatStoreSinglePrecision_MPIAIJ(Mat mat,PetscBool flg)
+{
+  Mat_MPIAIJ     *aij = (Mat_MPIAIJ*)mat->data;
+  PetscBool      ismpiaij;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)mat,MATMPIAIJ,&ismpiaij);CHKERRQ(ierr);
+  if (flg && !ismpiaij) SETERRQ1(((PetscObject)mat)->comm,PETSC_ERR_SUP,"Not for matrix type %s",((PetscObject)mat)->type_name);
+  if (!flg) {
+    ierr = MatMPIAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
+  }
+  aij->storesingle = flg;
+  if (flg && mat->assembled) {
+    ierr = MatMPIAIJPackSingle_Private(mat);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
@@ -8,6 +8,7 @@
 #include <../src/mat/utils/freespace.h>
 #include <../src/mat/impls/aij/mpi/mpiaij.h>
 #include <petscbt.h>
+#include <../src/sys/utils/hash.h>
 
 /* #define PTAP_PROFILE */
 
@@ -69,6 +70,217 @@ PetscErrorCode MatDuplicate_MPIAIJ_MatPtAP(Mat A, MatDuplicateOption op, Mat *M)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPSymbolicSendCo_MPIAIJ_Private"
+/*
+   Sends the rows of Co = (p->B)^T*A*P, given by coi[] and coj[] and indexed by the off-diagonal columns prmap[] of P,
+   to the processes that own them, and creates the merge context of the product with pn local rows
+*/
+static PetscErrorCode MatPtAPSymbolicSendCo_MPIAIJ_Private(MPI_Comm comm,PetscInt pn,PetscInt pon,const PetscInt prmap[],PetscInt coi[],PetscInt coj[],Mat_Merge_SeqsToMPI **mergeout)
+{
+  PetscErrorCode       ierr;
+  Mat_Merge_SeqsToMPI  *merge;
+  PetscMPIInt          size,tagi,tagj,*len_si,*len_s,*len_ri,icompleted=0;
+  PetscInt             **buf_rj,**buf_ri,*owners,*owners_co;
+  PetscInt             i,k,len,proc,nzi,nrows,*buf_s,*buf_si,*buf_si_i;
+  MPI_Request          *swaits,*rwaits;
+  MPI_Status           *sstatus,rstatus;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+
+  /* determine row ownership */
+  ierr = PetscNew(Mat_Merge_SeqsToMPI,&merge);CHKERRQ(ierr);
+  ierr = PetscLayoutCreate(comm,&merge->rowmap);CHKERRQ(ierr);
+  merge->rowmap->n  = pn;
+  merge->rowmap->bs = 1;
+  ierr = PetscLayoutSetUp(merge->rowmap);CHKERRQ(ierr);
+  owners = merge->rowmap->range;
+
+  /* determine the number of messages to send, their lengths */
+  ierr = PetscMalloc2(size,PetscMPIInt,&len_si,size,MPI_Status,&sstatus);CHKERRQ(ierr);
+  ierr = PetscMemzero(len_si,size*sizeof(PetscMPIInt));CHKERRQ(ierr);
+  ierr = PetscMalloc(size*sizeof(PetscMPIInt),&merge->len_s);CHKERRQ(ierr);
+  len_s = merge->len_s;
+  merge->nsend = 0;
+
+  ierr = PetscMalloc((size+2)*sizeof(PetscInt),&owners_co);CHKERRQ(ierr);
+  ierr = PetscMemzero(len_s,size*sizeof(PetscMPIInt));CHKERRQ(ierr);
+
+  proc = 0;
+  for (i=0; i<pon; i++){
+    while (prmap[i] >= owners[proc+1]) proc++;
+    len_si[proc]++;  /* num of rows in Co to be sent to [proc] */
+    len_s[proc] += coi[i+1] - coi[i];
+  }
+
+  len   = 0;  /* max length of buf_si[] */
+  owners_co[0] = 0;
+  for (proc=0; proc<size; proc++){
+    owners_co[proc+1] = owners_co[proc] + len_si[proc];
+    if (len_si[proc]){
+      merge->nsend++;
+      len_si[proc] = 2*(len_si[proc] + 1);
+      len += len_si[proc];
+    }
+  }
+
+  /* determine the number and length of messages to receive for coi and coj  */
+  ierr = PetscGatherNumberOfMessages(comm,PETSC_NULL,len_s,&merge->nrecv);CHKERRQ(ierr);
+  ierr = PetscGatherMessageLengths2(comm,merge->nsend,merge->nrecv,len_s,len_si,&merge->id_r,&merge->len_r,&len_ri);CHKERRQ(ierr);
+
+  /* post the Irecv and Isend of coj */
+  ierr = PetscCommGetNewTag(comm,&tagj);CHKERRQ(ierr);
+  ierr = PetscPostIrecvInt(comm,tagj,merge->nrecv,merge->id_r,merge->len_r,&buf_rj,&rwaits);CHKERRQ(ierr);
+  ierr = PetscMalloc((merge->nsend+1)*sizeof(MPI_Request),&swaits);CHKERRQ(ierr);
+  for (proc=0, k=0; proc<size; proc++){
+    if (!len_s[proc]) continue;
+    i = owners_co[proc];
+    ierr = MPI_Isend(coj+coi[i],len_s[proc],MPIU_INT,proc,tagj,comm,swaits+k);CHKERRQ(ierr);
+    k++;
+  }
+
+  /* receives and sends of coj are complete */
+  for (i=0; i<merge->nrecv; i++){
+    ierr = MPI_Waitany(merge->nrecv,rwaits,&icompleted,&rstatus);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(rwaits);CHKERRQ(ierr);
+  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,swaits,sstatus);CHKERRQ(ierr);}
+
+  /* send and recv coi */
+  /*-------------------*/
+  ierr = PetscCommGetNewTag(comm,&tagi);CHKERRQ(ierr);
+  ierr = PetscPostIrecvInt(comm,tagi,merge->nrecv,merge->id_r,len_ri,&buf_ri,&rwaits);CHKERRQ(ierr);
+  ierr = PetscMalloc((len+1)*sizeof(PetscInt),&buf_s);CHKERRQ(ierr);
+  buf_si = buf_s;  /* points to the beginning of k-th msg to be sent */
+  for (proc=0,k=0; proc<size; proc++){
+    if (!len_s[proc]) continue;
+    /* form outgoing message for i-structure:
+         buf_si[0]:                 nrows to be sent
+               [1:nrows]:           row index (global)
+               [nrows+1:2*nrows+1]: i-structure index
+    */
+    /*-------------------------------------------*/
+    nrows = len_si[proc]/2 - 1;
+    buf_si_i    = buf_si + nrows+1;
+    buf_si[0]   = nrows;
+    buf_si_i[0] = 0;
+    nrows = 0;
+    for (i=owners_co[proc]; i<owners_co[proc+1]; i++){
+      nzi = coi[i+1] - coi[i];
+      buf_si_i[nrows+1] = buf_si_i[nrows] + nzi; /* i-structure */
+      buf_si[nrows+1] =prmap[i] -owners[proc]; /* local row index */
+      nrows++;
+    }
+    ierr = MPI_Isend(buf_si,len_si[proc],MPIU_INT,proc,tagi,comm,swaits+k);CHKERRQ(ierr);
+    k++;
+    buf_si += len_si[proc];
+  }
+  i = merge->nrecv;
+  while (i--) {
+    ierr = MPI_Waitany(merge->nrecv,rwaits,&icompleted,&rstatus);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(rwaits);CHKERRQ(ierr);
+  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,swaits,sstatus);CHKERRQ(ierr);}
+
+  ierr = PetscFree2(len_si,sstatus);CHKERRQ(ierr);
+  ierr = PetscFree(len_ri);CHKERRQ(ierr);
+  ierr = PetscFree(swaits);CHKERRQ(ierr);
+  ierr = PetscFree(buf_s);CHKERRQ(ierr);
+
+  merge->coi       = coi;
+  merge->coj       = coj;
+  merge->buf_ri    = buf_ri;
+  merge->buf_rj    = buf_rj;
+  merge->owners_co = owners_co;
+  *mergeout        = merge;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPNumericAddCo_MPIAIJ_Private"
+/*
+   Sends the values coa[] of Co = (p->B)^T*A*P to the owners of its rows, adds the received values to the values ba[]
+   of the local rows of C, with the structure merge->bi and merge->bj, and assembles C
+*/
+static PetscErrorCode MatPtAPNumericAddCo_MPIAIJ_Private(Mat C,Mat_Merge_SeqsToMPI *merge,MatScalar coa[],MatScalar ba[])
+{
+  PetscErrorCode       ierr;
+  MPI_Comm             comm=((PetscObject)C)->comm;
+  PetscMPIInt          size,rank,taga,*len_s;
+  PetscInt             i,j,k,proc,row,cnz,bnz,nextcj,nrows,*cj,*bj_i;
+  PetscInt             *owners=merge->rowmap->range,*coi=merge->coi,*bi=merge->bi,*bj=merge->bj,cm=merge->rowmap->n;
+  PetscInt             **buf_ri,**buf_rj,**buf_ri_k,**nextrow,**nextci;
+  MPI_Request          *s_waits,*r_waits;
+  MPI_Status           *status;
+  MatScalar            **abuf_r,*ba_i,*ca;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+
+  /* send and recv matrix values coa */
+  buf_ri = merge->buf_ri;
+  buf_rj = merge->buf_rj;
+  len_s  = merge->len_s;
+  ierr = PetscCommGetNewTag(comm,&taga);CHKERRQ(ierr);
+  ierr = PetscPostIrecvScalar(comm,taga,merge->nrecv,merge->id_r,merge->len_r,&abuf_r,&r_waits);CHKERRQ(ierr);
+
+  ierr = PetscMalloc2(merge->nsend+1,MPI_Request,&s_waits,size,MPI_Status,&status);CHKERRQ(ierr);
+  for (proc=0,k=0; proc<size; proc++){
+    if (!len_s[proc]) continue;
+    i = merge->owners_co[proc];
+    ierr = MPI_Isend(coa+coi[i],len_s[proc],MPIU_MATSCALAR,proc,taga,comm,s_waits+k);CHKERRQ(ierr);
+    k++;
+  }
+  if (merge->nrecv) {ierr = MPI_Waitall(merge->nrecv,r_waits,status);CHKERRQ(ierr);}
+  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,s_waits,status);CHKERRQ(ierr);}
+
+  ierr = PetscFree2(s_waits,status);CHKERRQ(ierr);
+  ierr = PetscFree(r_waits);CHKERRQ(ierr);
+
+  /* insert local Cseq and received values into Cmpi */
+  ierr = PetscMalloc3(merge->nrecv,PetscInt**,&buf_ri_k,merge->nrecv,PetscInt*,&nextrow,merge->nrecv,PetscInt*,&nextci);CHKERRQ(ierr);
+  for (k=0; k<merge->nrecv; k++){
+    buf_ri_k[k] = buf_ri[k]; /* beginning of k-th recved i-structure */
+    nrows       = *(buf_ri_k[k]);
+    nextrow[k]  = buf_ri_k[k]+1;  /* next row number of k-th recved i-structure */
+    nextci[k]   = buf_ri_k[k] + (nrows + 1);/* poins to the next i-structure of k-th recved i-structure  */
+  }
+
+  for (i=0; i<cm; i++) {
+    row = owners[rank] + i; /* global row index of C_seq */
+    bj_i = bj + bi[i];  /* col indices of the i-th row of C */
+    ba_i = ba + bi[i];
+    bnz  = bi[i+1] - bi[i];
+    /* add received vals into ba */
+    for (k=0; k<merge->nrecv; k++){ /* k-th received message */
+      /* i-th row */
+      if (i == *nextrow[k]) {
+        cnz = *(nextci[k]+1) - *nextci[k];
+        cj  = buf_rj[k] + *(nextci[k]);
+        ca  = abuf_r[k] + *(nextci[k]);
+        nextcj = 0;
+        for (j=0; nextcj<cnz; j++){
+          if (bj_i[j] == cj[nextcj]){ /* bcol == ccol */
+            ba_i[j] += ca[nextcj++];
+          }
+        }
+        nextrow[k]++; nextci[k]++;
+        ierr = PetscLogFlops(2.0*cnz);CHKERRQ(ierr);
+      }
+    }
+    ierr = MatSetValues(C,1,&row,bnz,bj_i,ba_i,INSERT_VALUES);CHKERRQ(ierr);
+  }
+  ierr = MatAssemblyBegin(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+
+  ierr = PetscFree(abuf_r[0]);CHKERRQ(ierr);
+  ierr = PetscFree(abuf_r);CHKERRQ(ierr);
+  ierr = PetscFree3(buf_ri_k,nextrow,nextci);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatPtAP_MPIAIJ_MPIAIJ"
 PetscErrorCode MatPtAP_MPIAIJ_MPIAIJ(Mat A,Mat P,MatReuse scall,PetscReal fill,Mat *C)
@@ -79,7 +291,7 @@ PetscErrorCode MatPtAP_MPIAIJ_MPIAIJ(Mat A,Mat P,MatReuse scall,PetscReal fill,M
   if (scall == MAT_INITIAL_MATRIX){
     ierr = MatPtAPSymbolic_MPIAIJ_MPIAIJ(A,P,fill,C);CHKERRQ(ierr);
   }
-  ierr = MatPtAPNumeric_MPIAIJ_MPIAIJ(A,P,*C);CHKERRQ(ierr);
+  ierr = (*(*C)->ops->ptapnumeric)(A,P,*C);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -96,21 +308,20 @@ PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
   Mat_SeqAIJ           *p_loc,*p_oth;
   PetscInt             *pi_loc,*pj_loc,*pi_oth,*pj_oth,*pdti,*pdtj,*poti,*potj,*ptJ;
   PetscInt             *adi=ad->i,*aj,*aoi=ao->i,nnz;
-  PetscInt             *lnk,*owners_co,*coi,*coj,i,k,pnz,row;
+  PetscInt             *lnk,*coi,*coj,i,k,pnz,row;
   PetscInt             am=A->rmap->n,pN=P->cmap->N,pm=P->rmap->n,pn=P->cmap->n;
   PetscBT              lnkbt;
   MPI_Comm             comm=((PetscObject)A)->comm;
-  PetscMPIInt          size,rank,tagi,tagj,*len_si,*len_s,*len_ri,icompleted=0;
+  PetscMPIInt          rank;
   PetscInt             **buf_rj,**buf_ri,**buf_ri_k;
-  PetscInt             len,proc,*dnz,*onz,*owners;
+  PetscInt             *dnz,*onz,*owners;
   PetscInt             nzi,*pti,*ptj;
-  PetscInt             nrows,*buf_s,*buf_si,*buf_si_i,**nextrow,**nextci;
-  MPI_Request          *swaits,*rwaits;
-  MPI_Status           *sstatus,rstatus;
+  PetscInt             nrows,**nextrow,**nextci;
   Mat_Merge_SeqsToMPI  *merge;
   PetscInt             *api,*apj,*Jptr,apnz,*prmap=p->garray,pon,nspacedouble=0,j,ap_rmax=0;
   PetscReal            afill=1.0,afill_tmp;
   PetscInt             rmax;
+  PetscBool            allatonce=PETSC_FALSE;
 #if defined(PTAP_PROFILE)
   PetscLogDouble       t0,t1,t2,t3,t4;
 #endif
@@ -128,7 +339,13 @@ PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
     SETERRQ4(comm,PETSC_ERR_ARG_SIZ,"Matrix local dimensions are incompatible, Acol (%D, %D) != Prow (%D,%D)",A->cmap->rstart,A->cmap->rend,P->rmap->rstart,P->rmap->rend);
   }
 
-  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  /* the all-at-once product does not form A*P, nor the transposes of the local parts of P */
+  ierr = PetscOptionsGetBool(((PetscObject)A)->prefix,"-matptap_allatonce",&allatonce,PETSC_NULL);CHKERRQ(ierr);
+  if (allatonce) {
+    ierr = MatPtAPSymbolic_MPIAIJ_MPIAIJ_allatonce(A,P,fill,C);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
   ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
 
   /* create struct Mat_PtAPMPI and attached it to C later */
@@ -255,106 +472,12 @@ PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
   if (afill_tmp > afill) afill = afill_tmp;
   ierr = MatRestoreSymbolicTranspose_SeqAIJ(p->B,&poti,&potj);CHKERRQ(ierr);
 
-  /* send j-array (coj) of Co to other processors */
-  /*----------------------------------------------*/
-  /* determine row ownership */
-  ierr = PetscNew(Mat_Merge_SeqsToMPI,&merge);CHKERRQ(ierr);
-  ierr = PetscLayoutCreate(comm,&merge->rowmap);CHKERRQ(ierr);
-  merge->rowmap->n  = pn;
-  merge->rowmap->bs = 1;
-  ierr = PetscLayoutSetUp(merge->rowmap);CHKERRQ(ierr);
+  /* send the structure of Co to the owners of its rows */
+  /*----------------------------------------------------*/
+  ierr = MatPtAPSymbolicSendCo_MPIAIJ_Private(comm,pn,pon,prmap,coi,coj,&merge);CHKERRQ(ierr);
   owners = merge->rowmap->range;
-
-  /* determine the number of messages to send, their lengths */
-  ierr = PetscMalloc2(size,PetscMPIInt,&len_si,size,MPI_Status,&sstatus);CHKERRQ(ierr);
-  ierr = PetscMemzero(len_si,size*sizeof(PetscMPIInt));CHKERRQ(ierr);
-  ierr = PetscMalloc(size*sizeof(PetscMPIInt),&merge->len_s);CHKERRQ(ierr);
-  len_s = merge->len_s;
-  merge->nsend = 0;
-
-  ierr = PetscMalloc((size+2)*sizeof(PetscInt),&owners_co);CHKERRQ(ierr);
-  ierr = PetscMemzero(len_s,size*sizeof(PetscMPIInt));CHKERRQ(ierr);
-
-  proc = 0;
-  for (i=0; i<pon; i++){
-    while (prmap[i] >= owners[proc+1]) proc++;
-    len_si[proc]++;  /* num of rows in Co to be sent to [proc] */
-    len_s[proc] += coi[i+1] - coi[i];
-  }
-
-  len   = 0;  /* max length of buf_si[] */
-  owners_co[0] = 0;
-  for (proc=0; proc<size; proc++){
-    owners_co[proc+1] = owners_co[proc] + len_si[proc];
-    if (len_si[proc]){
-      merge->nsend++;
-      len_si[proc] = 2*(len_si[proc] + 1);
-      len += len_si[proc];
-    }
-  }
-
-  /* determine the number and length of messages to receive for coi and coj  */
-  ierr = PetscGatherNumberOfMessages(comm,PETSC_NULL,len_s,&merge->nrecv);CHKERRQ(ierr);
-  ierr = PetscGatherMessageLengths2(comm,merge->nsend,merge->nrecv,len_s,len_si,&merge->id_r,&merge->len_r,&len_ri);CHKERRQ(ierr);
-
-  /* post the Irecv and Isend of coj */
-  ierr = PetscCommGetNewTag(comm,&tagj);CHKERRQ(ierr);
-  ierr = PetscPostIrecvInt(comm,tagj,merge->nrecv,merge->id_r,merge->len_r,&buf_rj,&rwaits);CHKERRQ(ierr);
-  ierr = PetscMalloc((merge->nsend+1)*sizeof(MPI_Request),&swaits);CHKERRQ(ierr);
-  for (proc=0, k=0; proc<size; proc++){
-    if (!len_s[proc]) continue;
-    i = owners_co[proc];
-    ierr = MPI_Isend(coj+coi[i],len_s[proc],MPIU_INT,proc,tagj,comm,swaits+k);CHKERRQ(ierr);
-    k++;
-  }
-
-  /* receives and sends of coj are complete */
-  for (i=0; i<merge->nrecv; i++){
-    ierr = MPI_Waitany(merge->nrecv,rwaits,&icompleted,&rstatus);CHKERRQ(ierr);
-  }
-  ierr = PetscFree(rwaits);CHKERRQ(ierr);
-  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,swaits,sstatus);CHKERRQ(ierr);}
-
-  /* send and recv coi */
-  /*-------------------*/
-  ierr = PetscCommGetNewTag(comm,&tagi);CHKERRQ(ierr);
-  ierr = PetscPostIrecvInt(comm,tagi,merge->nrecv,merge->id_r,len_ri,&buf_ri,&rwaits);CHKERRQ(ierr);
-  ierr = PetscMalloc((len+1)*sizeof(PetscInt),&buf_s);CHKERRQ(ierr);
-  buf_si = buf_s;  /* points to the beginning of k-th msg to be sent */
-  for (proc=0,k=0; proc<size; proc++){
-    if (!len_s[proc]) continue;
-    /* form outgoing message for i-structure:
-         buf_si[0]:                 nrows to be sent
-               [1:nrows]:           row index (global)
-               [nrows+1:2*nrows+1]: i-structure index
-    */
-    /*-------------------------------------------*/
-    nrows = len_si[proc]/2 - 1;
-    buf_si_i    = buf_si + nrows+1;
-    buf_si[0]   = nrows;
-    buf_si_i[0] = 0;
-    nrows = 0;
-    for (i=owners_co[proc]; i<owners_co[proc+1]; i++){
-      nzi = coi[i+1] - coi[i];
-      buf_si_i[nrows+1] = buf_si_i[nrows] + nzi; /* i-structure */
-      buf_si[nrows+1] =prmap[i] -owners[proc]; /* local row index */
-      nrows++;
-    }
-    ierr = MPI_Isend(buf_si,len_si[proc],MPIU_INT,proc,tagi,comm,swaits+k);CHKERRQ(ierr);
-    k++;
-    buf_si += len_si[proc];
-  }
-  i = merge->nrecv;
-  while (i--) {
-    ierr = MPI_Waitany(merge->nrecv,rwaits,&icompleted,&rstatus);CHKERRQ(ierr);
-  }
-  ierr = PetscFree(rwaits);CHKERRQ(ierr);
-  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,swaits,sstatus);CHKERRQ(ierr);}
-
-  ierr = PetscFree2(len_si,sstatus);CHKERRQ(ierr);
-  ierr = PetscFree(len_ri);CHKERRQ(ierr);
-  ierr = PetscFree(swaits);CHKERRQ(ierr);
-  ierr = PetscFree(buf_s);CHKERRQ(ierr);
+  buf_ri = merge->buf_ri;
+  buf_rj = merge->buf_rj;
 
 #if defined(PTAP_PROFILE)
   ierr = PetscGetTime(&t3);CHKERRQ(ierr);
@@ -439,11 +562,6 @@ PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
 
   merge->bi            = pti;  /* Cseq->i */
   merge->bj            = ptj;  /* Cseq->j */
-  merge->coi           = coi;  /* Co->i   */
-  merge->coj           = coj;  /* Co->j   */
-  merge->buf_ri        = buf_ri;
-  merge->buf_rj        = buf_rj;
-  merge->owners_co     = owners_co;
   merge->destroy       = Cmpi->ops->destroy;
   merge->duplicate     = Cmpi->ops->duplicate;
 
@@ -507,27 +625,21 @@ PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ(Mat A,Mat P,Mat C)
   PetscInt             i,j,k,anz,pnz,apnz,nextap,row,*cj;
   MatScalar            *ada,*aoa,*apa,*pa,*ca,*pa_loc,*pa_oth,valtmp;
   PetscInt             am=A->rmap->n,cm=C->rmap->n,pon=(p->B)->cmap->n;
-  MPI_Comm             comm=((PetscObject)C)->comm;
-  PetscMPIInt          size,rank,taga,*len_s;
-  PetscInt             *owners,proc,nrows,**buf_ri_k,**nextrow,**nextci;
-  PetscInt             **buf_ri,**buf_rj;
-  PetscInt             cnz=0,*bj_i,*bi,*bj,bnz,nextcj; /* bi,bj,ba: local array of C(mpi mat) */
-  MPI_Request          *s_waits,*r_waits;
-  MPI_Status           *status;
-  MatScalar            **abuf_r,*ba_i,*pA,*coa,*ba;
+  PetscInt             cnz=0,*bi,*bj; /* bi,bj,ba: local array of C(mpi mat) */
+  MatScalar            *pA,*coa,*ba;
   PetscInt             *api,*apj,*coi,*coj;
   PetscInt             *poJ=po->j,*pdJ=pd->j,pcstart=P->cmap->rstart,pcend=P->cmap->rend;
   PetscBool            scalable;
 #if defined(PTAP_PROFILE)
-  PetscLogDouble       t0,t1,t2,t3,t4,et2_AP=0.0,et2_PtAP=0.0,t2_0,t2_1,t2_2;
+  PetscMPIInt          rank;
+  PetscLogDouble       t0,t1,t2,t4,et2_AP=0.0,et2_PtAP=0.0,t2_0,t2_1,t2_2;
 #endif
 
   PetscFunctionBegin;
 #if defined(PTAP_PROFILE)
+  ierr = MPI_Comm_rank(((PetscObject)C)->comm,&rank);CHKERRQ(ierr);
   ierr = PetscGetTime(&t0);CHKERRQ(ierr);
 #endif
-  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
-  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
 
   ptap = c->ptap;
   if (!ptap) SETERRQ(((PetscObject)C)->comm,PETSC_ERR_ARG_INCOMP,"MatPtAP() has not been called to create matrix C yet, cannot use MAT_REUSE_MATRIX");
@@ -560,7 +672,6 @@ PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ(Mat A,Mat P,Mat C)
   ierr = PetscMemzero(coa,coi[pon]*sizeof(MatScalar));CHKERRQ(ierr);
 
   bi     = merge->bi; bj = merge->bj;
-  owners = merge->rowmap->range;
   ierr   = PetscMalloc((bi[cm]+1)*sizeof(MatScalar),&ba);CHKERRQ(ierr);  /* ba: Cseq->a */
   ierr   = PetscMemzero(ba,bi[cm]*sizeof(MatScalar));CHKERRQ(ierr);
 
@@ -748,75 +859,302 @@ PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ(Mat A,Mat P,Mat C)
   ierr = PetscGetTime(&t2);CHKERRQ(ierr);
 #endif
 
-  /* 3) send and recv matrix values coa */
-  /*------------------------------------*/
-  buf_ri = merge->buf_ri;
-  buf_rj = merge->buf_rj;
-  len_s  = merge->len_s;
-  ierr = PetscCommGetNewTag(comm,&taga);CHKERRQ(ierr);
-  ierr = PetscPostIrecvScalar(comm,taga,merge->nrecv,merge->id_r,merge->len_r,&abuf_r,&r_waits);CHKERRQ(ierr);
-
-  ierr = PetscMalloc2(merge->nsend+1,MPI_Request,&s_waits,size,MPI_Status,&status);CHKERRQ(ierr);
-  for (proc=0,k=0; proc<size; proc++){
-    if (!len_s[proc]) continue;
-    i = merge->owners_co[proc];
-    ierr = MPI_Isend(coa+coi[i],len_s[proc],MPIU_MATSCALAR,proc,taga,comm,s_waits+k);CHKERRQ(ierr);
-    k++;
-  }
-  if (merge->nrecv) {ierr = MPI_Waitall(merge->nrecv,r_waits,status);CHKERRQ(ierr);}
-  if (merge->nsend) {ierr = MPI_Waitall(merge->nsend,s_waits,status);CHKERRQ(ierr);}
-
-  ierr = PetscFree2(s_waits,status);CHKERRQ(ierr);
-  ierr = PetscFree(r_waits);CHKERRQ(ierr);
+  /* 3) send the values of Co, add the received values to the local rows and insert them into C */
+  /*---------------------------------------------------------------------------------------------*/
+  ierr = MatPtAPNumericAddCo_MPIAIJ_Private(C,merge,coa,ba);CHKERRQ(ierr);
   ierr = PetscFree(coa);CHKERRQ(ierr);
+  ierr = PetscFree(ba);CHKERRQ(ierr);
 #if defined(PTAP_PROFILE)
-  ierr = PetscGetTime(&t3);CHKERRQ(ierr);
+  ierr = PetscGetTime(&t4);CHKERRQ(ierr);
+  if (rank==1) PetscPrintf(MPI_COMM_SELF,"  [%d] PtAPNum %g/P + %g/PtAP( %g + %g ) + %g/comm and Cloc = %g\n\n",rank,t1-t0,t2-t1,et2_AP,et2_PtAP,t4-t2,t4-t0);CHKERRQ(ierr);
 #endif
+  PetscFunctionReturn(0);
+}
+
+/*
+   The all-at-once product computes each row of A*P in turn and immediately adds its outer product with the
+   corresponding row of P into the rows of C, so neither A*P nor the transposes of the local parts of P are stored.
+   The rows of C owned by other processes are accumulated in Co = (p->B)^T*A*P and sent to their owners, as in
+   MatPtAPNumeric_MPIAIJ_MPIAIJ().
+*/
+#define MatPtAPHashSlot(col,mask) ((PetscInt)(((size_t)(col)*2654435761U) & (size_t)(mask)))
+
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPSymbolic_MPIAIJ_MPIAIJ_allatonce"
+PetscErrorCode MatPtAPSymbolic_MPIAIJ_MPIAIJ_allatonce(Mat A,Mat P,PetscReal fill,Mat *C)
+{
+  PetscErrorCode       ierr;
+  Mat                  Cmpi;
+  Mat_PtAPMPI          *ptap;
+  Mat_MPIAIJ           *a=(Mat_MPIAIJ*)A->data,*p=(Mat_MPIAIJ*)P->data,*c;
+  Mat_SeqAIJ           *ad=(Mat_SeqAIJ*)(a->A)->data,*ao=(Mat_SeqAIJ*)(a->B)->data;
+  Mat_SeqAIJ           *pd=(Mat_SeqAIJ*)(p->A)->data,*po=(Mat_SeqAIJ*)(p->B)->data;
+  Mat_SeqAIJ           *p_loc,*p_oth;
+  PetscInt             *pi_loc,*pj_loc,*pi_oth,*pj_oth,*adi=ad->i,*aoi=ao->i,*aj;
+  PetscInt             *lnk,*apJ,*coi,*coj,*pti,*ptj,*dnz,*onz,*owners,*prmap=p->garray;
+  PetscInt             i,j,k,nzi,row,apnz,ap_rmax=0,ap_bound,bound,nrows;
+  PetscInt             am=A->rmap->n,pN=P->cmap->N,pn=P->cmap->n,pon=(p->B)->cmap->n;
+  PetscInt             **buf_ri,**buf_rj,**buf_ri_k,**nextrow,**nextci;
+  PetscHashI           *hd,*ho;
+  MPI_Comm             comm=((PetscObject)A)->comm;
+  PetscMPIInt          rank;
+  Mat_Merge_SeqsToMPI  *merge;
+  PetscReal            afill;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+
+  /* create struct Mat_PtAPMPI and attached it to C later */
+  ierr = PetscNew(Mat_PtAPMPI,&ptap);CHKERRQ(ierr);
+  ptap->reuse = MAT_INITIAL_MATRIX;
+
+  /* get P_oth by taking rows of P (= non-zero cols of local A) from other processors, and P_loc */
+  ierr = MatGetBrowsOfAoCols_MPIAIJ(A,P,MAT_INITIAL_MATRIX,&ptap->startsj_s,&ptap->startsj_r,&ptap->bufa,&ptap->P_oth);CHKERRQ(ierr);
+  ierr = MatMPIAIJGetLocalMat(P,MAT_INITIAL_MATRIX,&ptap->P_loc);CHKERRQ(ierr);
+  p_loc  = (Mat_SeqAIJ*)(ptap->P_loc)->data;
+  p_oth  = (Mat_SeqAIJ*)(ptap->P_oth)->data;
+  pi_loc = p_loc->i; pj_loc = p_loc->j;
+  pi_oth = p_oth->i; pj_oth = p_oth->j;
+
+  /* bound the length of the rows of A*P */
+  ap_bound = 0;
+  for (i=0; i<am; i++) {
+    bound = 0;
+    for (j=adi[i]; j<adi[i+1]; j++) {row = ad->j[j]; bound += pi_loc[row+1] - pi_loc[row];}
+    for (j=aoi[i]; j<aoi[i+1]; j++) {row = ao->j[j]; bound += pi_oth[row+1] - pi_oth[row];}
+    ap_bound = PetscMax(ap_bound,PetscMin(bound,pN));
+  }
+  ierr = PetscLLCondensedCreate_Scalable(ap_bound,&lnk);CHKERRQ(ierr);
+  ierr = PetscMalloc((ap_bound+1)*sizeof(PetscInt),&apJ);CHKERRQ(ierr);
+
+  /* the column indices of each row of C, for the local rows in hd[] and for the rows of Co in ho[] */
+  ierr = PetscMalloc2(pn,PetscHashI,&hd,pon,PetscHashI,&ho);CHKERRQ(ierr);
+  for (i=0; i<pn; i++)  {PetscHashICreate(hd[i]);}
+  for (i=0; i<pon; i++) {PetscHashICreate(ho[i]);}
+
+  for (i=0; i<am; i++) {
+    /* the structure of the i-th row of A*P = A_diag*P_loc + A_off*P_oth */
+    nzi = adi[i+1] - adi[i];
+    aj  = ad->j + adi[i];
+    for (j=0; j<nzi; j++) {
+      row  = aj[j];
+      ierr = PetscLLCondensedAddSorted_Scalable(pi_loc[row+1]-pi_loc[row],pj_loc+pi_loc[row],lnk);CHKERRQ(ierr);
+    }
+    nzi = aoi[i+1] - aoi[i];
+    aj  = ao->j + aoi[i];
+    for (j=0; j<nzi; j++) {
+      row  = aj[j];
+      ierr = PetscLLCondensedAddSorted_Scalable(pi_oth[row+1]-pi_oth[row],pj_oth+pi_oth[row],lnk);CHKERRQ(ierr);
+    }
+    apnz = lnk[0];
+    ierr = PetscLLCondensedClean_Scalable(apnz,apJ,lnk);CHKERRQ(ierr);
+    if (ap_rmax < apnz) ap_rmax = apnz;
+
+    /* which is added to the rows of C given by the columns of the i-th row of P */
+    for (j=pd->i[i]; j<pd->i[i+1]; j++) {
+      row = pd->j[j];
+      for (k=0; k<apnz; k++) {PetscHashIAdd(hd[row],apJ[k],0);}
+    }
+    for (j=po->i[i]; j<po->i[i+1]; j++) {
+      row = po->j[j];
+      for (k=0; k<apnz; k++) {PetscHashIAdd(ho[row],apJ[k],0);}
+    }
+  }
+  ierr = PetscLLCondensedDestroy_Scalable(lnk);CHKERRQ(ierr);
+  ierr = PetscFree(apJ);CHKERRQ(ierr);
+
+  /* gather the structure of Co, sorted by rows */
+  ierr = PetscMalloc((pon+1)*sizeof(PetscInt),&coi);CHKERRQ(ierr);
+  coi[0] = 0;
+  for (i=0; i<pon; i++) {
+    PetscHashISize(ho[i],nzi);
+    coi[i+1] = coi[i] + nzi;
+  }
+  ierr = PetscMalloc((coi[pon]+1)*sizeof(PetscInt),&coj);CHKERRQ(ierr);
+  for (i=0; i<pon; i++) {
+    nzi = coi[i];
+    if (coi[i+1] > coi[i]) {PetscHashIGetKeys(ho[i],nzi,coj);}
+    ierr = PetscSortInt(coi[i+1]-coi[i],coj+coi[i]);CHKERRQ(ierr);
+    PetscHashIDestroy(ho[i]);
+  }
+
+  /* send the structure of Co to the owners of its rows */
+  ierr = MatPtAPSymbolicSendCo_MPIAIJ_Private(comm,pn,pon,prmap,coi,coj,&merge);CHKERRQ(ierr);
+  owners = merge->rowmap->range;
+  buf_ri = merge->buf_ri;
+  buf_rj = merge->buf_rj;
 
-  /* 4) insert local Cseq and received values into Cmpi */
-  /*------------------------------------------------------*/
+  /* add the received column indices to the local rows */
   ierr = PetscMalloc3(merge->nrecv,PetscInt**,&buf_ri_k,merge->nrecv,PetscInt*,&nextrow,merge->nrecv,PetscInt*,&nextci);CHKERRQ(ierr);
   for (k=0; k<merge->nrecv; k++){
     buf_ri_k[k] = buf_ri[k]; /* beginning of k-th recved i-structure */
-    nrows       = *(buf_ri_k[k]);
-    nextrow[k]  = buf_ri_k[k]+1;  /* next row number of k-th recved i-structure */
+    nrows       = *buf_ri_k[k];
+    nextrow[k]  = buf_ri_k[k] + 1;  /* next row number of k-th recved i-structure */
     nextci[k]   = buf_ri_k[k] + (nrows + 1);/* poins to the next i-structure of k-th recved i-structure  */
   }
-
-  for (i=0; i<cm; i++) {
-    row = owners[rank] + i; /* global row index of C_seq */
-    bj_i = bj + bi[i];  /* col indices of the i-th row of C */
-    ba_i = ba + bi[i];
-    bnz  = bi[i+1] - bi[i];
-    /* add received vals into ba */
+  for (i=0; i<pn; i++) {
     for (k=0; k<merge->nrecv; k++){ /* k-th received message */
-      /* i-th row */
-      if (i == *nextrow[k]) {
-        cnz = *(nextci[k]+1) - *nextci[k];
-        cj  = buf_rj[k] + *(nextci[k]);
-        ca  = abuf_r[k] + *(nextci[k]);
-        nextcj = 0;
-        for (j=0; nextcj<cnz; j++){
-          if (bj_i[j] == cj[nextcj]){ /* bcol == ccol */
-            ba_i[j] += ca[nextcj++];
-          }
-        }
+      if (i == *nextrow[k]) { /* i-th row */
+        for (j=*nextci[k]; j<*(nextci[k]+1); j++) {PetscHashIAdd(hd[i],buf_rj[k][j],0);}
         nextrow[k]++; nextci[k]++;
-        ierr = PetscLogFlops(2.0*cnz);CHKERRQ(ierr);
       }
     }
-    ierr = MatSetValues(C,1,&row,bnz,bj_i,ba_i,INSERT_VALUES);CHKERRQ(ierr);
   }
-  ierr = MatAssemblyBegin(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
-  ierr = MatAssemblyEnd(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
-
-  ierr = PetscFree(ba);CHKERRQ(ierr);
-  ierr = PetscFree(abuf_r[0]);CHKERRQ(ierr);
-  ierr = PetscFree(abuf_r);CHKERRQ(ierr);
   ierr = PetscFree3(buf_ri_k,nextrow,nextci);CHKERRQ(ierr);
-#if defined(PTAP_PROFILE)
-  ierr = PetscGetTime(&t4);CHKERRQ(ierr);
-  if (rank==1) PetscPrintf(MPI_COMM_SELF,"  [%d] PtAPNum %g/P + %g/PtAP( %g + %g ) + %g/comm + %g/Cloc = %g\n\n",rank,t1-t0,t2-t1,et2_AP,et2_PtAP,t3-t2,t4-t3,t4-t0);CHKERRQ(ierr);
+
+  /* the local rows of C */
+  ierr = PetscMalloc((pn+1)*sizeof(PetscInt),&pti);CHKERRQ(ierr);
+  pti[0] = 0;
+  for (i=0; i<pn; i++) {
+    PetscHashISize(hd[i],nzi);
+    pti[i+1] = pti[i] + nzi;
+  }
+  ierr = PetscMalloc((pti[pn]+1)*sizeof(PetscInt),&ptj);CHKERRQ(ierr);
+  ierr = MatPreallocateInitialize(comm,pn,pn,dnz,onz);CHKERRQ(ierr);
+  for (i=0; i<pn; i++) {
+    nzi = pti[i];
+    if (pti[i+1] > pti[i]) {PetscHashIGetKeys(hd[i],nzi,ptj);}
+    ierr = PetscSortInt(pti[i+1]-pti[i],ptj+pti[i]);CHKERRQ(ierr);
+    ierr = MatPreallocateSet(i+owners[rank],pti[i+1]-pti[i],ptj+pti[i],dnz,onz);CHKERRQ(ierr);
+    PetscHashIDestroy(hd[i]);
+  }
+  ierr = PetscFree2(hd,ho);CHKERRQ(ierr);
+
+  /* create symbolic parallel matrix Cmpi */
+  /*--------------------------------------*/
+  ierr = MatCreate(comm,&Cmpi);CHKERRQ(ierr);
+  ierr = MatSetSizes(Cmpi,pn,pn,PETSC_DETERMINE,PETSC_DETERMINE);CHKERRQ(ierr);
+  ierr = MatSetBlockSizes(Cmpi,P->cmap->bs,P->cmap->bs);CHKERRQ(ierr);
+  ierr = MatSetType(Cmpi,MATMPIAIJ);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocation(Cmpi,0,dnz,0,onz);CHKERRQ(ierr);
+  ierr = MatPreallocateFinalize(dnz,onz);CHKERRQ(ierr);
+
+  merge->bi            = pti;  /* Cseq->i */
+  merge->bj            = ptj;  /* Cseq->j */
+  merge->destroy       = Cmpi->ops->destroy;
+  merge->duplicate     = Cmpi->ops->duplicate;
+
+  /* Cmpi is not ready for use - assembly will be done by MatPtAPNumeric() */
+  Cmpi->assembled         = PETSC_FALSE;
+  Cmpi->ops->destroy      = MatDestroy_MPIAIJ_PtAP;
+  Cmpi->ops->duplicate    = MatDuplicate_MPIAIJ_MatPtAP;
+  Cmpi->ops->ptapnumeric  = MatPtAPNumeric_MPIAIJ_MPIAIJ_allatonce;
+
+  /* attach the supporting struct to Cmpi for reuse */
+  c = (Mat_MPIAIJ*)Cmpi->data;
+  c->ptap        = ptap;
+  ptap->merge    = merge;
+  ptap->rmax     = ap_rmax;
+  *C             = Cmpi;
+
+  afill = (PetscReal)(pti[pn] + coi[pon])/(adi[am] + aoi[am] + pi_loc[am] + 1);
+  (*C)->info.fill_ratio_given  = fill;
+  (*C)->info.fill_ratio_needed = afill;
+#if defined(PETSC_USE_INFO)
+  if (pti[pn] != 0) {
+    ierr = PetscInfo2(Cmpi,"All-at-once product with %D local nonzeros, fill ratio needed %G\n",pti[pn],afill);CHKERRQ(ierr);
+  } else {
+    ierr = PetscInfo(Cmpi,"Empty matrix product\n");CHKERRQ(ierr);
+  }
 #endif
   PetscFunctionReturn(0);
 }
+
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPNumeric_MPIAIJ_MPIAIJ_allatonce"
+PetscErrorCode MatPtAPNumeric_MPIAIJ_MPIAIJ_allatonce(Mat A,Mat P,Mat C)
+{
+  PetscErrorCode       ierr;
+  Mat_Merge_SeqsToMPI  *merge;
+  Mat_MPIAIJ           *a=(Mat_MPIAIJ*)A->data,*p=(Mat_MPIAIJ*)P->data,*c=(Mat_MPIAIJ*)C->data;
+  Mat_SeqAIJ           *ad=(Mat_SeqAIJ*)(a->A)->data,*ao=(Mat_SeqAIJ*)(a->B)->data;
+  Mat_SeqAIJ           *pd=(Mat_SeqAIJ*)(p->A)->data,*po=(Mat_SeqAIJ*)(p->B)->data;
+  Mat_SeqAIJ           *p_loc,*p_oth;
+  Mat_PtAPMPI          *ptap;
+  PetscInt             *pi,*pj,*ai,*aj,*coi,*coj,*bi,*bj,*cj,*apJ,*keys,*pos,*used;
+  PetscInt             i,j,k,l,h,col,row,apnz,cnz,nextap,hsize,mask,cm=C->rmap->n,am=A->rmap->n,pon=(p->B)->cmap->n;
+  MatScalar            *aa,*pa,*apa,*coa,*ba,*ca,valtmp;
+  PetscLogDouble       flops=0.0;
+
+  PetscFunctionBegin;
+  ptap = c->ptap;
+  if (!ptap) SETERRQ(((PetscObject)C)->comm,PETSC_ERR_ARG_INCOMP,"MatPtAP() has not been called to create matrix C yet, cannot use MAT_REUSE_MATRIX");
+  merge = ptap->merge;
+
+  /* get P_oth = ptap->P_oth  and P_loc = ptap->P_loc */
+  if (ptap->reuse == MAT_INITIAL_MATRIX){
+    ptap->reuse = MAT_REUSE_MATRIX;
+  } else { /* update numerical values of P_oth and P_loc */
+    ierr = MatGetBrowsOfAoCols_MPIAIJ(A,P,MAT_REUSE_MATRIX,&ptap->startsj_s,&ptap->startsj_r,&ptap->bufa,&ptap->P_oth);CHKERRQ(ierr);
+    ierr = MatMPIAIJGetLocalMat(P,MAT_REUSE_MATRIX,&ptap->P_loc);CHKERRQ(ierr);
+  }
+  p_loc = (Mat_SeqAIJ*)(ptap->P_loc)->data;
+  p_oth = (Mat_SeqAIJ*)(ptap->P_oth)->data;
+
+  coi = merge->coi; coj = merge->coj;
+  bi  = merge->bi;  bj  = merge->bj;
+  ierr = PetscMalloc((coi[pon]+1)*sizeof(MatScalar),&coa);CHKERRQ(ierr);
+  ierr = PetscMemzero(coa,coi[pon]*sizeof(MatScalar));CHKERRQ(ierr);
+  ierr = PetscMalloc((bi[cm]+1)*sizeof(MatScalar),&ba);CHKERRQ(ierr);
+  ierr = PetscMemzero(ba,bi[cm]*sizeof(MatScalar));CHKERRQ(ierr);
+
+  /* a row of A*P is accumulated in an open addressing hash table keyed by the global column */
+  for (hsize=16; hsize < 2*ptap->rmax; hsize *= 2) ;
+  mask = hsize - 1;
+  ierr = PetscMalloc5(ptap->rmax+1,PetscInt,&apJ,ptap->rmax+1,MatScalar,&apa,hsize,PetscInt,&keys,hsize,PetscInt,&pos,ptap->rmax+1,PetscInt,&used);CHKERRQ(ierr);
+  for (h=0; h<hsize; h++) keys[h] = -1;
+
+  for (i=0; i<am; i++) {
+    /* the i-th row of A*P = A_diag*P_loc + A_off*P_oth */
+    apnz = 0;
+    for (l=0; l<2; l++) {
+      if (!l) {ai = ad->i; aj = ad->j; aa = ad->a; pi = p_loc->i; pj = p_loc->j; pa = p_loc->a;}
+      else    {ai = ao->i; aj = ao->j; aa = ao->a; pi = p_oth->i; pj = p_oth->j; pa = p_oth->a;}
+      for (j=ai[i]; j<ai[i+1]; j++) {
+        row    = aj[j];
+        valtmp = aa[j];
+        for (k=pi[row]; k<pi[row+1]; k++) {
+          col = pj[k];
+          h   = MatPtAPHashSlot(col,mask);
+          while (keys[h] >= 0 && keys[h] != col) h = (h+1) & mask;
+          if (keys[h] < 0) {
+            keys[h]      = col;
+            pos[h]       = apnz;
+            used[apnz]   = h;
+            apJ[apnz]    = col;
+            apa[apnz++]  = valtmp*pa[k];
+          } else apa[pos[h]] += valtmp*pa[k];
+        }
+        flops += 2.0*(pi[row+1] - pi[row]);
+      }
+    }
+    for (k=0; k<apnz; k++) keys[used[k]] = -1;
+    ierr = PetscSortIntWithScalarArray(apnz,apJ,apa);CHKERRQ(ierr);
+
+    /* add its outer product with the i-th row of P to the local rows of C and to the rows of Co */
+    for (l=0; l<2; l++) {
+      if (!l) {pi = pd->i; pj = pd->j; pa = pd->a;}
+      else    {pi = po->i; pj = po->j; pa = po->a;}
+      for (j=pi[i]; j<pi[i+1]; j++) {
+        row = pj[j];
+        if (!l) {cj = bj + bi[row];  ca = ba + bi[row];  cnz = bi[row+1] - bi[row];}
+        else    {cj = coj + coi[row]; ca = coa + coi[row]; cnz = coi[row+1] - coi[row];}
+        valtmp = pa[j];
+        nextap = 0;
+        for (k=0; nextap<apnz && k<cnz; k++) {
+          if (cj[k] == apJ[nextap]) ca[k] += valtmp*apa[nextap++];
+        }
+        if (nextap < apnz) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Column %D is missing from the structure of the product",apJ[nextap]);
+        flops += 2.0*apnz;
+      }
+    }
+  }
+  ierr = PetscFree5(apJ,apa,keys,pos,used);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+
+  /* send the values of Co, add the received values to the local rows and insert them into C */
+  ierr = MatPtAPNumericAddCo_MPIAIJ_Private(C,merge,coa,ba);CHKERRQ(ierr);
+  ierr = PetscFree(coa);CHKERRQ(ierr);
+  ierr = PetscFree(ba);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
@@ -0,0 +1,353 @@
+
+/*
+  Defines the MATMPISELL matrix class. This class is derived from the MATMPIAIJ
+  class; the diagonal and off-diagonal parts of the local submatrix are stored
+  as MATSEQSELL matrices, so the parallel products (including the overlap of
+  communication and computation done by MATMPIAIJ) use the sliced ELLPACK kernels.
+
+   See src/mat/impls/aij/seq/sell/sell.c for the sequential version
+*/
+
+#include <../src/mat/impls/aij/mpi/mpiaij.h>
+#include <../src/mat/impls/aij/seq/sell/sell.h>
+
+typedef struct {
+  PetscInt state;   /* object state of the parallel matrix last seen by a product */
+} Mat_MPISELL;
+
+EXTERN_C_BEGIN
+extern PetscErrorCode MatConvert_SeqAIJ_SeqSELL(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode MatConvert_SeqSELL_SeqAIJ(Mat,MatType,MatReuse,Mat*);
+EXTERN_C_END
+extern PetscErrorCode MatAssemblyEnd_MPIAIJ(Mat,MatAssemblyType);
+extern PetscErrorCode MatMult_MPIAIJ(Mat,Vec,Vec);
+extern PetscErrorCode MatMultAdd_MPIAIJ(Mat,Vec,Vec,Vec);
+extern PetscErrorCode MatMultTranspose_MPIAIJ(Mat,Vec,Vec);
+extern PetscErrorCode MatMultTransposeAdd_MPIAIJ(Mat,Vec,Vec,Vec);
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMPISELLSetUpLocal_Private"
+/*
+   Makes sure the local diagonal and off-diagonal blocks are of type MATSEQSELL; MatDisAssemble_MPIAIJ()
+   replaces the off-diagonal block by a plain MATSEQAIJ matrix when new nonzeros are inserted.
+*/
+static PetscErrorCode MatMPISELLSetUpLocal_Private(Mat A)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  PetscBool      flg;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (a->A) {
+    ierr = PetscObjectTypeCompare((PetscObject)a->A,MATSEQSELL,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = MatConvert_SeqAIJ_SeqSELL(a->A,MATSEQSELL,MAT_REUSE_MATRIX,&a->A);CHKERRQ(ierr);}
+  }
+  if (a->B) {
+    ierr = PetscObjectTypeCompare((PetscObject)a->B,MATSEQSELL,&flg);CHKERRQ(ierr);
+    if (!flg) {ierr = MatConvert_SeqAIJ_SeqSELL(a->B,MATSEQSELL,MAT_REUSE_MATRIX,&a->B);CHKERRQ(ierr);}
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMPISELLUpdate_Private"
+/*
+   Some MATMPIAIJ routines (for example MatAXPY_MPIAIJ() and MatDiagonalScale_MPIAIJ()) change the values of
+   the local blocks without going through the public interface, so the state of the blocks does not change.
+   Forward any state change of the parallel matrix to the blocks so their SELL arrays get rebuilt.
+*/
+PETSC_STATIC_INLINE PetscErrorCode MatMPISELLUpdate_Private(Mat A)
+{
+  Mat_MPIAIJ     *a = (Mat_MPIAIJ*)A->data;
+  Mat_MPISELL    *sell = (Mat_MPISELL*)A->spptr;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (sell->state != ((PetscObject)A)->state) {
+    ierr = PetscObjectStateIncrease((PetscObject)a->A);CHKERRQ(ierr);
+    ierr = PetscObjectStateIncrease((PetscObject)a->B);CHKERRQ(ierr);
+    sell->state = ((PetscObject)A)->state;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_MPISELL"
+PetscErrorCode MatMult_MPISELL(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPISELLUpdate_Private(A);CHKERRQ(ierr);
+  ierr = MatMult_MPIAIJ(A,xx,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_MPISELL"
+PetscErrorCode MatMultAdd_MPISELL(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPISELLUpdate_Private(A);CHKERRQ(ierr);
+  ierr = MatMultAdd_MPIAIJ(A,xx,yy,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTranspose_MPISELL"
+PetscErrorCode MatMultTranspose_MPISELL(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPISELLUpdate_Private(A);CHKERRQ(ierr);
+  ierr = MatMultTranspose_MPIAIJ(A,xx,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTransposeAdd_MPISELL"
+PetscErrorCode MatMultTransposeAdd_MPISELL(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPISELLUpdate_Private(A);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_MPIAIJ(A,xx,yy,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_MPISELL"
+PetscErrorCode MatAssemblyEnd_MPISELL(Mat A,MatAssemblyType mode)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatAssemblyEnd_MPIAIJ(A,mode);CHKERRQ(ierr);
+  ierr = MatMPISELLSetUpLocal_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDestroy_MPISELL"
+PetscErrorCode MatDestroy_MPISELL(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(A->spptr);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_mpisell_mpiaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)A,MATMPIAIJ);CHKERRQ(ierr);
+  ierr = MatDestroy_MPIAIJ(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatMPIAIJSetPreallocation_MPISELL"
+PetscErrorCode  MatMPIAIJSetPreallocation_MPISELL(Mat B,PetscInt d_nz,const PetscInt d_nnz[],PetscInt o_nz,const PetscInt o_nnz[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatMPIAIJSetPreallocation_MPIAIJ(B,d_nz,d_nnz,o_nz,o_nnz);CHKERRQ(ierr);
+  ierr = MatMPISELLSetUpLocal_Private(B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_MPISELL_MPIAIJ"
+PetscErrorCode  MatConvert_MPISELL_MPIAIJ(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  /* This routine is only called to convert a MATMPISELL to its base PETSc type, */
+  /* so we will ignore 'MatType type'. */
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+  Mat_MPIAIJ     *b;
+  PetscBool      flg;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+  b = (Mat_MPIAIJ*)B->data;
+  if (b->A) {
+    ierr = PetscObjectTypeCompare((PetscObject)b->A,MATSEQSELL,&flg);CHKERRQ(ierr);
+    if (flg) {ierr = MatConvert_SeqSELL_SeqAIJ(b->A,MATSEQAIJ,MAT_REUSE_MATRIX,&b->A);CHKERRQ(ierr);}
+  }
+  if (b->B) {
+    ierr = PetscObjectTypeCompare((PetscObject)b->B,MATSEQSELL,&flg);CHKERRQ(ierr);
+    if (flg) {ierr = MatConvert_SeqSELL_SeqAIJ(b->B,MATSEQAIJ,MAT_REUSE_MATRIX,&b->B);CHKERRQ(ierr);}
+  }
+
+  /* Reset the original function pointers. */
+  B->ops->assemblyend      = MatAssemblyEnd_MPIAIJ;
+  B->ops->destroy          = MatDestroy_MPIAIJ;
+  B->ops->mult             = MatMult_MPIAIJ;
+  B->ops->multadd          = MatMultAdd_MPIAIJ;
+  B->ops->multtranspose    = MatMultTranspose_MPIAIJ;
+  B->ops->multtransposeadd = MatMultTransposeAdd_MPIAIJ;
+  ierr = PetscFree(B->spptr);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatMPIAIJSetPreallocation_C","MatMPIAIJSetPreallocation_MPIAIJ",MatMPIAIJSetPreallocation_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpisell_mpiaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATMPIAIJ);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+/* MatConvert_MPIAIJ_MPISELL converts a MPIAIJ matrix into a
+ * MPISELL matrix.  This routine is called by the MatCreate_MPISELL()
+ * routine, but can also be used to convert an assembled MPIAIJ matrix
+ * into a MPISELL one. */
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_MPIAIJ_MPISELL"
+PetscErrorCode  MatConvert_MPIAIJ_MPISELL(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+  Mat_MPISELL    *sell;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+
+  ierr = PetscNewLog(B,Mat_MPISELL,&sell);CHKERRQ(ierr);
+  B->spptr    = (void*)sell;
+  sell->state = -1;
+
+  /* Set function pointers for methods that we inherit from MPIAIJ but override. */
+  B->ops->assemblyend      = MatAssemblyEnd_MPISELL;
+  B->ops->destroy          = MatDestroy_MPISELL;
+  B->ops->mult             = MatMult_MPISELL;
+  B->ops->multadd          = MatMultAdd_MPISELL;
+  B->ops->multtranspose    = MatMultTranspose_MPISELL;
+  B->ops->multtransposeadd = MatMultTransposeAdd_MPISELL;
+
+  /* If A has already been preallocated, convert the local blocks now. */
+  ierr = MatMPISELLSetUpLocal_Private(B);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatMPIAIJSetPreallocation_C","MatMPIAIJSetPreallocation_MPISELL",MatMPIAIJSetPreallocation_MPISELL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_mpisell_mpiaij_C","MatConvert_MPISELL_MPIAIJ",MatConvert_MPISELL_MPIAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATMPISELL);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCreateSELL"
+/*@C
+   MatCreateSELL - Creates a sparse parallel matrix whose local
+   portions are stored as SEQSELL matrices (a matrix class that inherits
+   from SEQAIJ but stores an additional sliced ELLPACK copy of the matrix
+   that allows vectorized matrix vector products).  The same guidelines
+   that apply to MPIAIJ matrices for preallocating the matrix storage
+   apply here as well.
+
+   Collective on MPI_Comm
+
+   Input Parameters:
++  comm - MPI communicator
+.  m - number of local rows (or PETSC_DECIDE to have calculated if M is given)
+           This value should be the same as the local size used in creating the
+           y vector for the matrix-vector product y = Ax.
+.  n - This value should be the same as the local size used in creating the
+       x vector for the matrix-vector product y = Ax. (or PETSC_DECIDE to have
+       calculated if N is given) For square matrices n is almost always m.
+.  M - number of global rows (or PETSC_DETERMINE to have calculated if m is given)
+.  N - number of global columns (or PETSC_DETERMINE to have calculated if n is given)
+.  d_nz  - number of nonzeros per row in DIAGONAL portion of local submatrix
+           (same value is used for all local rows)
+.  d_nnz - array containing the number of nonzeros in the various rows of the
+           DIAGONAL portion of the local submatrix (possibly different for each row)
+           or PETSC_NULL, if d_nz is used to specify the nonzero structure.
+.  o_nz  - number of nonzeros per row in the OFF-DIAGONAL portion of local
+           submatrix (same value is used for all local rows).
+-  o_nnz - array containing the number of nonzeros in the various rows of the
+           OFF-DIAGONAL portion of the local submatrix (possibly different for
+           each row) or PETSC_NULL, if o_nz is used to specify the nonzero
+           structure.
+
+   Output Parameter:
+.  A - the matrix
+
+   Options Database Keys:
++  -mat_sell_slice_height <8> - number of rows in each slice
+-  -mat_sell_sigma <1> - rows are sorted by length within windows of this many rows
+
+   Notes:
+   If the *_nnz parameter is given then the *_nz parameter is ignored
+
+   When calling this routine with a single process communicator, a matrix of
+   type SEQSELL is returned.
+
+   Level: intermediate
+
+.keywords: matrix, sell, sliced ellpack, sparse, parallel
+
+.seealso: MatCreate(), MatCreateSeqSELL(), MatCreateAIJ(), MatSetValues(), MATSELL
+@*/
+PetscErrorCode  MatCreateSELL(MPI_Comm comm,PetscInt m,PetscInt n,PetscInt M,PetscInt N,PetscInt d_nz,const PetscInt d_nnz[],PetscInt o_nz,const PetscInt o_nnz[],Mat *A)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(comm,A);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,m,n,M,N);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  if (size > 1) {
+    ierr = MatSetType(*A,MATMPISELL);CHKERRQ(ierr);
+    ierr = MatMPIAIJSetPreallocation(*A,d_nz,d_nnz,o_nz,o_nnz);CHKERRQ(ierr);
+  } else {
+    ierr = MatSetType(*A,MATSEQSELL);CHKERRQ(ierr);
+    ierr = MatSeqAIJSetPreallocation(*A,d_nz,d_nnz);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatCreate_MPISELL"
+PetscErrorCode  MatCreate_MPISELL(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSetType(A,MATMPIAIJ);CHKERRQ(ierr);
+  ierr = MatConvert_MPIAIJ_MPISELL(A,MATMPISELL,MAT_REUSE_MATRIX,&A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+/*MC
+   MATSELL - MATSELL = "sell" - A matrix type to be used for sparse matrices.
+
+   This matrix type is identical to MATSEQSELL when constructed with a single process communicator,
+   and MATMPISELL otherwise.  As a result, for single process communicators,
+  MatSeqAIJSetPreallocation() is supported, and similarly MatMPIAIJSetPreallocation() is supported
+  for communicators controlling multiple processes.  It is recommended that you call both of
+  the above preallocation routines for simplicity.
+
+   The matrix is stored in AIJ format, plus a sliced ELLPACK (SELL-C-sigma) copy that is used for
+   MatMult(), MatMultAdd(), MatMultTranspose() and MatMultTransposeAdd(). All other operations use
+   the AIJ data. Use MatConvert() to switch between MATAIJ and MATSELL.
+
+   Options Database Keys:
++ -mat_type sell - sets the matrix type to "sell" during a call to MatSetFromOptions()
+. -mat_sell_slice_height <8> - number of rows in each slice
+- -mat_sell_sigma <1> - rows are sorted by length within windows of this many rows
+
+  Level: beginner
+
+.seealso: MatCreateSELL(), MatCreateSeqSELL(), MATSEQSELL, MATMPISELL, MATAIJCRL
+M*/
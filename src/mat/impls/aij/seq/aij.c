@@ -9,9 +9,7 @@
 #include <petscblaslapack.h>
 #include <petscbt.h>
 #include <../src/mat/blocktranspose.h>
-#if defined(PETSC_THREADCOMM_ACTIVE)
 #include <petscthreadcomm.h>
-#endif
 
 #undef __FUNCT__
 #define __FUNCT__ "MatGetColumnNorms_SeqAIJ"
@@ -288,6 +286,64 @@ PetscErrorCode MatSetValuesRow_SeqAIJ(Mat A,PetscInt row,const PetscScalar v[])
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValues_SeqAIJ_Concurrent"
+/*
+   Adds values into the existing nonzero structure only; nothing but the entries is modified,
+   so this may be called by several threads at once, see MAT_CONCURRENT_ADD_VALUES
+*/
+static PetscErrorCode MatSetValues_SeqAIJ_Concurrent(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[])
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  const PetscInt *rp,*ai = a->i,*ailen = a->ilen,*aj = a->j;
+  PetscInt       k,l,t,row,col,nrow,low,high,lastcol;
+  MatScalar      *ap,*aa = a->a,value;
+  PetscBool      ignorezeroentries = a->ignorezeroentries;
+  PetscBool      roworiented = a->roworiented;
+
+  PetscFunctionBegin;
+  for (k=0; k<m; k++) { /* loop over added rows */
+    row  = im[k];
+    if (row < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+    if (row >= A->rmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row too large: row %D max %D",row,A->rmap->n-1);
+#endif
+    rp      = aj + ai[row]; ap = aa + ai[row];
+    nrow    = ailen[row];
+    low     = 0;
+    high    = nrow;
+    lastcol = -1;
+    for (l=0; l<n; l++) { /* loop over added columns */
+      if (in[l] < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+      if (in[l] >= A->cmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Column too large: col %D max %D",in[l],A->cmap->n-1);
+#endif
+      col = in[l];
+      if (v) value = roworiented ? v[l + k*n] : v[k + l*m];
+      else   value = 0.;
+      if (value == 0.0 && ignorezeroentries) continue;
+
+      if (col <= lastcol) low = 0; else high = nrow;
+      lastcol = col;
+      while (high-low > 5) {
+        t = (low+high)/2;
+        if (rp[t] > col) high = t;
+        else             low  = t;
+      }
+      while (low < high && rp[low] < col) low++;
+      if (low == high || rp[low] != col) {
+        if (a->nonew == 1) continue;
+        SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero at (%D,%D) is not allowed with MAT_CONCURRENT_ADD_VALUES",row,col);
+      }
+      MatAtomicAdd_Private(ap+low,value);
+      low++;
+    }
+  }
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatSetValues_SeqAIJ"
 PetscErrorCode MatSetValues_SeqAIJ(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
@@ -303,6 +359,12 @@ PetscErrorCode MatSetValues_SeqAIJ(Mat A,PetscInt m,const PetscInt im[],PetscInt
 
   PetscFunctionBegin;
   if (v) PetscValidScalarPointer(v,6);
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+  if (A->concurrentadd) {
+    ierr = MatSetValues_SeqAIJ_Concurrent(A,m,im,n,in,v);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   for (k=0; k<m; k++) { /* loop over added rows */
     row  = im[k];
     if (row < 0) continue;
@@ -418,8 +480,17 @@ PetscErrorCode MatView_SeqAIJ_Binary(Mat A,PetscViewer viewer)
   PetscInt       i,*col_lens;
   int            fd;
   FILE           *file;
+  PetscBool      partitioned;
 
   PetscFunctionBegin;
+  ierr = PetscViewerBinaryGetPartitioned(viewer,&partitioned);CHKERRQ(ierr);
+  if (partitioned) {
+    ierr = PetscMalloc(A->rmap->n*sizeof(PetscInt),&col_lens);CHKERRQ(ierr);
+    for (i=0; i<A->rmap->n; i++) col_lens[i] = a->i[i+1] - a->i[i];
+    ierr = MatView_Binary_Partitioned_Private(A,viewer,a->nz,col_lens,a->j,a->a);CHKERRQ(ierr);
+    ierr = PetscFree(col_lens);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
   ierr = PetscMalloc((4+A->rmap->n)*sizeof(PetscInt),&col_lens);CHKERRQ(ierr);
   col_lens[0] = MAT_FILE_CLASSID;
@@ -851,6 +922,8 @@ PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat A,MatAssemblyType mode)
   ierr = PetscInfo4(A,"Matrix size: %D X %D; storage space: %D unneeded,%D used\n",m,A->cmap->n,fshift,a->nz);CHKERRQ(ierr);
   ierr = PetscInfo1(A,"Number of mallocs during MatSetValues() is %D\n",a->reallocs);CHKERRQ(ierr);
   ierr = PetscInfo1(A,"Maximum nonzeros in any row is %D\n",rmax);CHKERRQ(ierr);
+  /* the coloring or blocks of the threaded MatSOR() depend on the nonzero structure */
+  if (fshift || a->reallocs) {ierr = MatSeqAIJSORThreadedDestroy_Private(&a->sorthreaded);CHKERRQ(ierr);}
   A->info.mallocs     += a->reallocs;
   a->reallocs          = 0;
   A->info.nz_unneeded  = (double)fshift;
@@ -858,10 +931,14 @@ PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat A,MatAssemblyType mode)
 
   ierr = MatCheckCompressedRow(A,&a->compressedrow,a->i,m,ratio);CHKERRQ(ierr);
   A->same_nonzero = PETSC_TRUE;
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  ierr = MatSeqXAIJComputeThreadPartition(A,m,a->i,&a->trstarts);CHKERRQ(ierr);
+#endif
 
   ierr = MatAssemblyEnd_SeqAIJ_Inode(A,mode);CHKERRQ(ierr);
 
   ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  if (a->storesingle) {ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);}
   PetscFunctionReturn(0);
 }
 
@@ -895,13 +972,55 @@ PetscErrorCode MatImaginaryPart_SeqAIJ(Mat A)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJComputeThreadPartition"
+/*
+   MatSeqXAIJComputeThreadPartition - Splits the m (block) rows with row offsets ai[] between the threads
+   of the matrix's thread communicator so that each thread gets about the same number of nonzeros.
+
+   Every row also counts as one nonzero, for the work done per row independent of its length, so that
+   long stretches of empty or very short rows are split as well.
+
+   *trstarts (length nthreads+1) is allocated when it is PETSC_NULL and reused otherwise.
+*/
+PetscErrorCode MatSeqXAIJComputeThreadPartition(Mat A,PetscInt m,const PetscInt ai[],PetscInt *trstarts[])
+{
+  PetscErrorCode ierr;
+  PetscInt       nthreads,t,lo,hi,mid,*ts;
+  PetscReal      work,target;
+
+  PetscFunctionBegin;
+  ierr = PetscThreadCommGetNThreads(((PetscObject)A)->comm,&nthreads);CHKERRQ(ierr);
+  if (!*trstarts) {
+    ierr = PetscMalloc((nthreads+1)*sizeof(PetscInt),trstarts);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory(A,(nthreads+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  }
+  ts    = *trstarts;
+  work  = (PetscReal)(ai[m] - ai[0] + m);
+  ts[0] = 0;
+  for (t=1; t<nthreads; t++) {
+    /* first row i with ai[i] - ai[0] + i >= t*work/nthreads */
+    target = (work*t)/nthreads;
+    lo     = ts[t-1];
+    hi     = m;
+    while (lo < hi) {
+      mid = lo + (hi - lo)/2;
+      if ((PetscReal)(ai[mid] - ai[0] + mid) < target) lo = mid + 1;
+      else hi = mid;
+    }
+    ts[t] = lo;
+  }
+  ts[nthreads] = m;
+  PetscFunctionReturn(0);
+}
+
 #if defined(PETSC_THREADCOMM_ACTIVE)
 PetscErrorCode MatZeroEntries_SeqAIJ_Kernel(PetscInt thread_id,Mat A)
 {
   PetscErrorCode ierr;
-  PetscInt       *trstarts=A->rmap->trstarts;
-  PetscInt       n,start,end;
   Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       *trstarts=a->trstarts;
+  PetscInt       n,start,end;
 
   start = trstarts[thread_id];
   end   = trstarts[thread_id+1];
@@ -914,9 +1033,11 @@ PetscErrorCode MatZeroEntries_SeqAIJ_Kernel(PetscInt thread_id,Mat A)
 #define __FUNCT__ "MatZeroEntries_SeqAIJ"
 PetscErrorCode MatZeroEntries_SeqAIJ(Mat A)
 {
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
   PetscErrorCode ierr;
 
   PetscFunctionBegin;
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,A->rmap->n,a->i,&a->trstarts);CHKERRQ(ierr);}
   ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatZeroEntries_SeqAIJ_Kernel,1,A);CHKERRQ(ierr);
   ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -962,6 +1083,10 @@ PetscErrorCode MatDestroy_SeqAIJ(Mat A)
   ierr = MatDestroy(&a->XtoY);CHKERRQ(ierr);
   ierr = PetscFree2(a->compressedrow.i,a->compressedrow.rindex);CHKERRQ(ierr);
   ierr = PetscFree(a->matmult_abdense);CHKERRQ(ierr);
+  ierr = PetscFree(a->trstarts);CHKERRQ(ierr);
+  ierr = MatSolveLevelsDestroy_Private(&a->solvelevels);CHKERRQ(ierr);
+  ierr = MatSeqAIJSORThreadedDestroy_Private(&a->sorthreaded);CHKERRQ(ierr);
+  ierr = MatSeqXAIJDestroySingle_Private(A);CHKERRQ(ierr);
 
   ierr = MatDestroy_SeqAIJ_Inode(A);CHKERRQ(ierr);
   ierr = PetscFree(A->data);CHKERRQ(ierr);
@@ -970,6 +1095,7 @@ PetscErrorCode MatDestroy_SeqAIJ(Mat A)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatSeqAIJSetColumnIndices_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatStoreValues_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatRetrieveValues_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatStoreSinglePrecision_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_seqaij_seqsbaij_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_seqaij_seqbaij_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_seqaij_seqaijperm_C","",PETSC_NULL);CHKERRQ(ierr);
@@ -1013,6 +1139,13 @@ PetscErrorCode MatSetOption_SeqAIJ(Mat A,MatOption op,PetscBool  flg)
   case MAT_CHECK_COMPRESSED_ROW:
     a->compressedrow.check = flg;
     break;
+  case MAT_CONCURRENT_ADD_VALUES:
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+    A->concurrentadd     = flg;
+#else
+    if (flg) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"MAT_CONCURRENT_ADD_VALUES needs atomic operations that are not available with this compiler or precision");
+#endif
+    break;
   case MAT_SPD:
   case MAT_SYMMETRIC:
   case MAT_STRUCTURALLY_SYMMETRIC:
@@ -1035,14 +1168,37 @@ PetscErrorCode MatSetOption_SeqAIJ(Mat A,MatOption op,PetscBool  flg)
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_THREADCOMM_ACTIVE)
+PetscErrorCode MatGetDiagonal_SeqAIJ_Kernel(PetscInt thread_id,Mat A,PetscScalar *x)
+{
+  Mat_SeqAIJ      *a = (Mat_SeqAIJ*)A->data;
+  const PetscInt  *ai = a->i,*aj = a->j;
+  const MatScalar *aa = a->a;
+  PetscInt        i,j,start,end;
+
+  start = a->trstarts[thread_id];
+  end   = a->trstarts[thread_id+1];
+  for (i=start; i<end; i++) {
+    x[i] = 0.0;
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      if (aj[j] == i) {
+        x[i] = aa[j];
+        break;
+      }
+    }
+  }
+  return 0;
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatGetDiagonal_SeqAIJ"
 PetscErrorCode MatGetDiagonal_SeqAIJ(Mat A,Vec v)
 {
   Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
   PetscErrorCode ierr;
-  PetscInt       i,j,n,*ai=a->i,*aj=a->j,nz;
-  PetscScalar    *aa=a->a,*x,zero=0.0;
+  PetscInt       i,n;
+  PetscScalar    *aa=a->a,*x;
 
   PetscFunctionBegin;
   ierr = VecGetLocalSize(v,&n);CHKERRQ(ierr);
@@ -1056,19 +1212,31 @@ PetscErrorCode MatGetDiagonal_SeqAIJ(Mat A,Vec v)
     PetscFunctionReturn(0);
   }
 
-  ierr = VecSet(v,zero);CHKERRQ(ierr);
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,A->rmap->n,a->i,&a->trstarts);CHKERRQ(ierr);}
   ierr = VecGetArray(v,&x);CHKERRQ(ierr);
-  for (i=0; i<n; i++) {
-    nz = ai[i+1] - ai[i];
-    if (!nz) x[i] = 0.0;
-    for (j=ai[i]; j<ai[i+1]; j++){
-      if (aj[j] == i) {
-        x[i] = aa[j];
-        break;
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatGetDiagonal_SeqAIJ_Kernel,2,A,x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+#else
+  {
+    PetscInt    j,*ai = a->i,*aj = a->j,nz;
+    PetscScalar zero = 0.0;
+
+    ierr = VecSet(v,zero);CHKERRQ(ierr);
+    ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+    for (i=0; i<n; i++) {
+      nz = ai[i+1] - ai[i];
+      if (!nz) x[i] = 0.0;
+      for (j=ai[i]; j<ai[i+1]; j++){
+        if (aj[j] == i) {
+          x[i] = aa[j];
+          break;
+        }
       }
     }
+    ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
   }
-  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+#endif
   PetscFunctionReturn(0);
 }
 
@@ -1136,24 +1304,18 @@ PetscErrorCode MatMultTranspose_SeqAIJ(Mat A,Vec xx,Vec yy)
 
 #include <../src/mat/impls/aij/seq/ftn-kernels/fmult.h>
 #if defined(PETSC_THREADCOMM_ACTIVE)
-PetscErrorCode MatMult_SeqAIJ_Kernel(PetscInt thread_id,Mat A,Vec xx,Vec yy)
+/* the vector arrays are obtained by the calling thread, VecGetArray() must not be called concurrently */
+PetscErrorCode MatMult_SeqAIJ_Kernel(PetscInt thread_id,Mat A,const PetscScalar *x,PetscScalar *y)
 {
-  PetscErrorCode    ierr;
   Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
-  PetscScalar       *y;
-  const PetscScalar *x;
   const MatScalar   *aa;
-  PetscInt          *trstarts=A->rmap->trstarts;
+  PetscInt          *trstarts=a->trstarts;
   PetscInt          n,start,end,i;
   const PetscInt   *aj,*ai;
   PetscScalar      sum;
 
-  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
-  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
   start = trstarts[thread_id];
   end   = trstarts[thread_id+1];
-  aj    = a->j;
-  aa    = a->a;
   ai    = a->i;
   for (i=start;i<end;i++) {
     n = ai[i+1] - ai[i];
@@ -1163,8 +1325,6 @@ PetscErrorCode MatMult_SeqAIJ_Kernel(PetscInt thread_id,Mat A,Vec xx,Vec yy)
     PetscSparseDensePlusDot(sum,x,aa,aj,n);
     y[i] = sum;
   }
-  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
-  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
   return 0;
 }
 
@@ -1188,12 +1348,12 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
 #endif
 
   PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
   aj  = a->j;
   aa  = a->a;
   ii  = a->i;
   if (usecprow){ /* use compressed row format */
-    ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
-    ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
     m    = a->compressedrow.nrows;
     ii   = a->compressedrow.i;
     ridx = a->compressedrow.rindex;
@@ -1207,16 +1367,17 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
       /* for (j=0; j<n; j++) sum += (*aa++)*x[*aj++]; */
       y[*ridx++] = sum;
     }
-    ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
-    ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
   } else { /* do not use compressed row format */
 #if defined(PETSC_USE_FORTRAN_KERNEL_MULTAIJ)
     fortranmultaij_(&m,x,ii,aj,aa,y);
 #else
-    ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMult_SeqAIJ_Kernel,3,A,xx,yy);CHKERRQ(ierr);
+    if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,m,a->i,&a->trstarts);CHKERRQ(ierr);}
+    ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMult_SeqAIJ_Kernel,3,A,x,y);CHKERRQ(ierr);
 #endif
   }
   ierr = PetscLogFlops(2.0*a->nz - nonzerorow);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 #else
@@ -1262,9 +1423,6 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
   } else { /* do not use compressed row format */
 #if defined(PETSC_USE_FORTRAN_KERNEL_MULTAIJ)
     fortranmultaij_(&m,x,ii,aj,aa,y);
-#else
-#if defined(PETSC_THREADCOMM_ACTIVE)
-    ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMult_SeqAIJ_Kernel,3,A,xx,yy);CHKERRQ(ierr);
 #else
     for (i=0; i<m; i++) {
       n   = ii[i+1] - ii[i];
@@ -1275,7 +1433,6 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
       PetscSparseDensePlusDot(sum,x,aa,aj,n);
       y[i] = sum;
     }
-#endif
 #endif
   }
   ierr = PetscLogFlops(2.0*a->nz - nonzerorow);CHKERRQ(ierr);
@@ -1286,6 +1443,29 @@ PetscErrorCode MatMult_SeqAIJ(Mat A,Vec xx,Vec yy)
 #endif
 
 #include <../src/mat/impls/aij/seq/ftn-kernels/fmultadd.h>
+#if defined(PETSC_THREADCOMM_ACTIVE)
+PetscErrorCode MatMultAdd_SeqAIJ_Kernel(PetscInt thread_id,Mat A,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const MatScalar   *aa;
+  const PetscInt    *aj,*ai = a->i;
+  PetscInt          n,i,start,end;
+  PetscScalar       sum;
+
+  start = a->trstarts[thread_id];
+  end   = a->trstarts[thread_id+1];
+  for (i=start; i<end; i++) {
+    n   = ai[i+1] - ai[i];
+    aj  = a->j + ai[i];
+    aa  = a->a + ai[i];
+    sum = y[i];
+    PetscSparseDensePlusDot(sum,x,aa,aj,n);
+    z[i] = sum;
+  }
+  return 0;
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatMultAdd_SeqAIJ"
 PetscErrorCode MatMultAdd_SeqAIJ(Mat A,Vec xx,Vec yy,Vec zz)
@@ -1330,6 +1510,9 @@ PetscErrorCode MatMultAdd_SeqAIJ(Mat A,Vec xx,Vec yy,Vec zz)
   } else { /* do not use compressed row format */
 #if defined(PETSC_USE_FORTRAN_KERNEL_MULTADDAIJ)
   fortranmultaddaij_(&m,x,ii,aj,aa,y,z);
+#elif defined(PETSC_THREADCOMM_ACTIVE)
+    if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,m,a->i,&a->trstarts);CHKERRQ(ierr);}
+    ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqAIJ_Kernel,4,A,x,y,z);CHKERRQ(ierr);
 #else
     for (i=0; i<m; i++) {
       n    = ii[i+1] - ii[i];
@@ -1469,8 +1652,14 @@ PetscErrorCode MatSOR_SeqAIJ(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscR
   PetscErrorCode     ierr;
   PetscInt           n = A->cmap->n,m = A->rmap->n,i;
   const PetscInt     *idx,*diag;
+  PetscBool          threaded;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJUseSORThreaded(A,flag,&threaded);CHKERRQ(ierr);
+  if (threaded) {
+    ierr = MatSOR_SeqAIJ_Threaded(A,bb,omega,flag,fshift,its,lits,xx);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   its = its*lits;
 
   if (fshift != a->fshift || omega != a->omega) a->idiagvalid = PETSC_FALSE; /* must recompute idiag[] */
@@ -2671,6 +2860,13 @@ PetscErrorCode MatAXPY_SeqAIJ(Mat Y,PetscScalar a,Mat X,MatStructure str)
   PetscBLASInt   one=1,bnz = PetscBLASIntCast(x->nz);
 
   PetscFunctionBegin;
+  if (x->single) {
+    /* the values of X are stored in single precision, MatAXPY_SeqAIJ_Single() has already unpacked Y */
+    ierr = MatSeqAIJUnpackSingle_Private(X);CHKERRQ(ierr);
+    ierr = MatAXPY_SeqAIJ(Y,a,X,str);CHKERRQ(ierr);
+    ierr = MatSeqAIJPackSingle_Private(X);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (str == SAME_NONZERO_PATTERN) {
     PetscScalar alpha = a;
     BLASaxpy_(&bnz,&alpha,x->a,&one,y->a,&one);
@@ -2973,7 +3169,7 @@ PetscErrorCode  MatInvertBlockDiagonal_SeqAIJ(Mat A,const PetscScalar **values)
       break;
     case 7:
       for (i=0; i<mbs; i++) {
-        ij[0] = 7*i; ij[1] = 7*i + 1; ij[2] = 7*i + 2; ij[3] = 7*i + 3; ij[4] = 7*i + 4; ij[5] = 7*i + 5; ij[5] = 7*i + 6;
+        ij[0] = 7*i; ij[1] = 7*i + 1; ij[2] = 7*i + 2; ij[3] = 7*i + 3; ij[4] = 7*i + 4; ij[5] = 7*i + 5; ij[6] = 7*i + 6;
         ierr  = MatGetValues(A,7,ij,7,ij,diag);CHKERRQ(ierr);
         ierr  = PetscKernel_A_gets_inverse_A_7(diag,shift);CHKERRQ(ierr);
         ierr  = PetscKernel_A_gets_transpose_A_7(diag);CHKERRQ(ierr);
@@ -3248,7 +3444,12 @@ PetscErrorCode  MatStoreValues_SeqAIJ(Mat mat)
   }
 
   /* copy values over */
-  ierr = PetscMemcpy(aij->saved_values,aij->a,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+  if (aij->single) {
+    PetscInt i;
+    for (i=0; i<(PetscInt)nz; i++) aij->saved_values[i] = aij->single->a[i];
+  } else {
+    ierr = PetscMemcpy(aij->saved_values,aij->a,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
   PetscFunctionReturn(0);
 }
 EXTERN_C_END
@@ -3330,6 +3531,7 @@ PetscErrorCode  MatRetrieveValues_SeqAIJ(Mat mat)
   if (!aij->saved_values) {
     SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ORDER,"Must call MatStoreValues(A);first");
   }
+  ierr = MatSeqAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
   /* copy values over */
   ierr = PetscMemcpy(aij->a,aij->saved_values,nz*sizeof(PetscScalar));CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -3528,6 +3730,7 @@ PetscErrorCode  MatSeqAIJSetPreallocation_SeqAIJ(Mat B,PetscInt nz,const PetscIn
 
   B->preallocated = PETSC_TRUE;
   b = (Mat_SeqAIJ*)B->data;
+  ierr = MatSeqAIJUnpackSingle_Private(B);CHKERRQ(ierr);
 
   if (!skipallocation) {
     if (!b->imax) {
@@ -3558,6 +3761,8 @@ PetscErrorCode  MatSeqAIJSetPreallocation_SeqAIJ(Mat B,PetscInt nz,const PetscIn
     b->free_a       = PETSC_TRUE;
     b->free_ij      = PETSC_TRUE;
 #if defined(PETSC_THREADCOMM_ACTIVE)
+  /* zero the entries with the threads that will later work on them */
+  ierr = MatSeqXAIJComputeThreadPartition(B,B->rmap->n,b->i,&b->trstarts);CHKERRQ(ierr);
   ierr = MatZeroEntries_SeqAIJ(B);CHKERRQ(ierr);
 #endif
   } else {
@@ -3798,6 +4003,8 @@ extern PetscErrorCode MatGetFactor_seqaij_pastix(Mat,MatFactorType,Mat*);
 extern PetscErrorCode MatGetFactor_seqaij_essl(Mat,MatFactorType,Mat *);
 #endif
 extern PetscErrorCode  MatConvert_SeqAIJ_SeqAIJCRL(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode  MatConvert_SeqAIJ_SeqSELL(Mat,MatType,MatReuse,Mat*);
+extern PetscErrorCode  MatConvert_SeqAIJ_SeqAIJDelta(Mat,MatType,MatReuse,Mat*);
 extern PetscErrorCode  MatGetFactor_seqaij_petsc(Mat,MatFactorType,Mat*);
 extern PetscErrorCode  MatGetFactor_seqaij_bas(Mat,MatFactorType,Mat*);
 extern PetscErrorCode  MatGetFactorAvailable_seqaij_petsc(Mat,MatFactorType,PetscBool  *);
@@ -3962,10 +4169,13 @@ PetscErrorCode  MatCreate_SeqAIJ(Mat B)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatSeqAIJSetColumnIndices_C","MatSeqAIJSetColumnIndices_SeqAIJ",MatSeqAIJSetColumnIndices_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatStoreValues_C","MatStoreValues_SeqAIJ",MatStoreValues_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatRetrieveValues_C","MatRetrieveValues_SeqAIJ",MatRetrieveValues_SeqAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatStoreSinglePrecision_C","MatStoreSinglePrecision_SeqAIJ",MatStoreSinglePrecision_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqsbaij_C","MatConvert_SeqAIJ_SeqSBAIJ",MatConvert_SeqAIJ_SeqSBAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqbaij_C","MatConvert_SeqAIJ_SeqBAIJ",MatConvert_SeqAIJ_SeqBAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqaijperm_C","MatConvert_SeqAIJ_SeqAIJPERM",MatConvert_SeqAIJ_SeqAIJPERM);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqaijcrl_C","MatConvert_SeqAIJ_SeqAIJCRL",MatConvert_SeqAIJ_SeqAIJCRL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqsell_C","MatConvert_SeqAIJ_SeqSELL",MatConvert_SeqAIJ_SeqSELL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaij_seqaijdelta_C","MatConvert_SeqAIJ_SeqAIJDelta",MatConvert_SeqAIJ_SeqAIJDelta);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatIsTranspose_C","MatIsTranspose_SeqAIJ",MatIsTranspose_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatIsHermitianTranspose_C","MatIsHermitianTranspose_SeqAIJ",MatIsTranspose_SeqAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatSeqAIJSetPreallocation_C","MatSeqAIJSetPreallocation_SeqAIJ",MatSeqAIJSetPreallocation_SeqAIJ);CHKERRQ(ierr);
@@ -4088,6 +4298,59 @@ PetscErrorCode MatDuplicate_SeqAIJ(Mat A,MatDuplicateOption cpvalues,Mat *B)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "MatLoad_SeqAIJ_Mapped"
+/*
+   Finishes MatLoad_SeqAIJ() with the arrays in place in the memory mapped file, see PetscViewerBinarySetMmap().
+   ai is the entry for the number of nonzeros in the header, it is followed by the row lengths so the row starts
+   are computed over them; aj are the column indices, the values follow them in the file.
+*/
+static PetscErrorCode MatLoad_SeqAIJ_Mapped(Mat B,PetscViewer viewer,int fd,PetscInt nz,PetscInt *ai,PetscInt *aj,PetscObject map)
+{
+  Mat_SeqAIJ     *b = (Mat_SeqAIJ*)B->data;
+  PetscErrorCode ierr;
+  PetscInt       i,m = B->rmap->n,*rowlengths = ai+1;
+  PetscScalar    *aa;
+  PetscBool      free_a = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  ierr = PetscViewerBinaryReadMapped(viewer,nz,PETSC_SCALAR,(void**)&aa,PETSC_NULL);CHKERRQ(ierr);
+  if (!aa) {
+    /* the values are not aligned in the file, for example after an odd number of 32 bit column indices */
+    ierr = PetscMalloc(nz*sizeof(PetscScalar),&aa);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory(B,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+    ierr = PetscBinaryRead(fd,aa,nz,PETSC_SCALAR);CHKERRQ(ierr);
+    free_a = PETSC_TRUE;
+  }
+
+  /* release the arrays of a matrix that was already preallocated */
+  ierr = MatSeqAIJUnpackSingle_Private(B);CHKERRQ(ierr);
+  ierr = MatSeqXAIJFreeAIJ(B,&b->a,&b->j,&b->i);CHKERRQ(ierr);
+  ierr = PetscFree2(b->imax,b->ilen);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation_SeqAIJ(B,MAT_SKIP_ALLOCATION,PETSC_NULL);CHKERRQ(ierr);
+
+  ierr = PetscMalloc2(m,PetscInt,&b->imax,m,PetscInt,&b->ilen);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(B,2*m*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<m; i++) b->imax[i] = b->ilen[i] = rowlengths[i];
+  ai[0] = 0;
+  for (i=0; i<m; i++) ai[i+1] = ai[i] + b->ilen[i];
+
+  b->i            = ai;
+  b->j            = aj;
+  b->a            = aa;
+  b->singlemalloc = PETSC_FALSE;
+  b->free_a       = free_a;
+  b->free_ij      = PETSC_FALSE;
+  b->maxnz        = nz;
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  ierr = MatSeqXAIJComputeThreadPartition(B,m,b->i,&b->trstarts);CHKERRQ(ierr);
+#endif
+  /* the matrix keeps the mapping until it is destroyed */
+  ierr = PetscObjectCompose((PetscObject)B,"PetscViewerBinaryMap",map);CHKERRQ(ierr);
+  ierr = MatSetOption(B,MAT_NEW_NONZERO_ALLOCATION_ERR,PETSC_TRUE);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatLoad_SeqAIJ"
 PetscErrorCode MatLoad_SeqAIJ(Mat newMat, PetscViewer viewer)
@@ -4095,10 +4358,13 @@ PetscErrorCode MatLoad_SeqAIJ(Mat newMat, PetscViewer viewer)
   Mat_SeqAIJ     *a;
   PetscErrorCode ierr;
   PetscInt       i,sum,nz,header[4],*rowlengths = 0,M,N,rows,cols;
+  PetscInt       *mheader = 0,*mrowlengths = 0,*mj = 0;
+  PetscObject    map = 0;
   int            fd;
   PetscMPIInt    size;
   MPI_Comm       comm;
   PetscInt       bs = 1;
+  PetscBool      useMPIIO = PETSC_FALSE;
 
   PetscFunctionBegin;
   ierr = PetscObjectGetComm((PetscObject)viewer,&comm);CHKERRQ(ierr);
@@ -4110,15 +4376,44 @@ PetscErrorCode MatLoad_SeqAIJ(Mat newMat, PetscViewer viewer)
   ierr = PetscOptionsEnd();CHKERRQ(ierr);
 
   ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
-  ierr = PetscBinaryRead(fd,header,4,PETSC_INT);CHKERRQ(ierr);
+  /* with PetscViewerBinarySetMmap() the header, row lengths and column indices are used in place in the file */
+  ierr = PetscViewerBinaryReadMapped(viewer,4,PETSC_INT,(void**)&mheader,&map);CHKERRQ(ierr);
+  if (mheader) {
+    ierr = PetscMemcpy(header,mheader,4*sizeof(PetscInt));CHKERRQ(ierr);
+  } else {
+    ierr = PetscViewerBinaryRead(viewer,header,4,PETSC_INT);CHKERRQ(ierr);
+  }
   if (header[0] != MAT_FILE_CLASSID) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"not matrix object in file");
   M = header[1]; N = header[2]; nz = header[3];
 
+  if (nz == MATRIX_BINARY_FORMAT_PARTITIONED) {
+    if (newMat->rmap->n < 0 && newMat->rmap->N < 0 && newMat->cmap->n < 0 && newMat->cmap->N < 0) {
+      ierr = MatSetSizes(newMat,PETSC_DECIDE,PETSC_DECIDE,M,N);CHKERRQ(ierr);
+    } else {
+      ierr = MatGetSize(newMat,&rows,&cols);CHKERRQ(ierr);
+      if (rows < 0 && cols < 0){
+        ierr = MatGetLocalSize(newMat,&rows,&cols);CHKERRQ(ierr);
+      }
+      if (M != rows ||  N != cols) SETERRQ4(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED, "Matrix in file of different length (%d, %d) than the input matrix (%d, %d)",M,N,rows,cols);
+    }
+    if (bs > 1) {ierr = MatSetBlockSize(newMat,bs);CHKERRQ(ierr);}
+    ierr = MatLoad_Binary_Partitioned_Private(newMat,viewer);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#if defined(PETSC_HAVE_MPIIO)
+  ierr = PetscViewerBinaryGetMPIIO(viewer,&useMPIIO);CHKERRQ(ierr);
+#endif
+  if (useMPIIO) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"MPI-IO viewers only load matrices stored with PetscViewerBinarySetPartitioned()");
   if (nz < 0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"Matrix stored in special format on disk,cannot load as SeqAIJ");
 
   /* read in row lengths */
-  ierr = PetscMalloc(M*sizeof(PetscInt),&rowlengths);CHKERRQ(ierr);
-  ierr = PetscBinaryRead(fd,rowlengths,M,PETSC_INT);CHKERRQ(ierr);
+  if (mheader) {ierr = PetscViewerBinaryReadMapped(viewer,M,PETSC_INT,(void**)&mrowlengths,PETSC_NULL);CHKERRQ(ierr);}
+  if (mrowlengths) {
+    rowlengths = mrowlengths;
+  } else {
+    ierr = PetscMalloc(M*sizeof(PetscInt),&rowlengths);CHKERRQ(ierr);
+    ierr = PetscBinaryRead(fd,rowlengths,M,PETSC_INT);CHKERRQ(ierr);
+  }
 
   /* check if sum of rowlengths is same as nz */
   for (i=0,sum=0; i< M; i++) sum +=rowlengths[i];
@@ -4135,6 +4430,16 @@ PetscErrorCode MatLoad_SeqAIJ(Mat newMat, PetscViewer viewer)
     }
     if (M != rows ||  N != cols) SETERRQ4(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED, "Matrix in file of different length (%d, %d) than the input matrix (%d, %d)",M,N,rows,cols);
   }
+  if (mrowlengths) {ierr = PetscViewerBinaryReadMapped(viewer,nz,PETSC_INT,(void**)&mj,PETSC_NULL);CHKERRQ(ierr);}
+  if (mj) {
+    ierr = PetscLayoutSetUp(newMat->rmap);CHKERRQ(ierr);
+    ierr = PetscLayoutSetUp(newMat->cmap);CHKERRQ(ierr);
+    ierr = MatLoad_SeqAIJ_Mapped(newMat,viewer,fd,nz,mheader+3,mj,map);CHKERRQ(ierr);
+    ierr = MatAssemblyBegin(newMat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    ierr = MatAssemblyEnd(newMat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+    if (bs > 1) {ierr = MatSetBlockSize(newMat,bs);CHKERRQ(ierr);}
+    PetscFunctionReturn(0);
+  }
   ierr = MatSeqAIJSetPreallocation_SeqAIJ(newMat,0,rowlengths);CHKERRQ(ierr);
   a = (Mat_SeqAIJ*)newMat->data;
 
@@ -4149,7 +4454,7 @@ PetscErrorCode MatLoad_SeqAIJ(Mat newMat, PetscViewer viewer)
     a->i[i]      = a->i[i-1] + rowlengths[i-1];
     a->ilen[i-1] = rowlengths[i-1];
   }
-  ierr = PetscFree(rowlengths);CHKERRQ(ierr);
+  if (!mrowlengths) {ierr = PetscFree(rowlengths);CHKERRQ(ierr);}
 
   ierr = MatAssemblyBegin(newMat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
   ierr = MatAssemblyEnd(newMat,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
@@ -4173,6 +4478,13 @@ PetscErrorCode MatEqual_SeqAIJ(Mat A,Mat B,PetscBool * flg)
     *flg = PETSC_FALSE;
     PetscFunctionReturn(0);
   }
+  if (b->single) {
+    /* the values of B are stored in single precision, MatEqual_SeqAIJ_Single() has already unpacked A */
+    ierr = MatSeqAIJUnpackSingle_Private(B);CHKERRQ(ierr);
+    ierr = MatEqual_SeqAIJ(A,B,flg);CHKERRQ(ierr);
+    ierr = MatSeqAIJPackSingle_Private(B);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
 
   /* if the a->i are the same */
   ierr = PetscMemcmp(a->i,b->i,(A->rmap->n+1)*sizeof(PetscInt),flg);CHKERRQ(ierr);
@@ -4,6 +4,21 @@
 
 #include <petsc-private/matimpl.h>
 
+/*
+    Single precision copy of the values of a SeqAIJ or SeqBAIJ matrix, see MatStoreSinglePrecision().
+    While it is in use the full precision values a->a are released and the operations of the matrix
+    are replaced by those that work on the single precision values; ops holds the original ones.
+*/
+typedef float MatScalarSingle;
+#define MAT_SINGLE_NCONVERTERS 8
+typedef struct {
+  MatScalarSingle *a;                 /* the nonzero values, in the layout of a->a */
+  struct _MatOps  ops;                /* the operations of the matrix with full precision values */
+  PetscScalar     *rowvalues;         /* MatGetRow() converts the values of the row into this */
+  PetscBool       getrowactive;       /* indicates MatGetRow(), not restored */
+  void            (*converters[MAT_SINGLE_NCONVERTERS])(void); /* the conversions composed with the matrix, replaced meanwhile */
+} Mat_SeqXAIJSingle;
+
 /*
     Struct header shared by SeqAIJ, SeqBAIJ and SeqSBAIJ matrix formats
 */
@@ -35,6 +50,10 @@
   PetscScalar       *solve_work;      /* work space used in MatSolve */                    \
   IS                row, col, icol;   /* index sets, used for reorderings */ \
   PetscBool         pivotinblocks;    /* pivot inside factorization of each diagonal block */ \
+  PetscInt          *trstarts;        /* (block) rows of each thread, balanced by the number of nonzeros */ \
+  PetscBool         storesingle;      /* store the values in single precision after the final assembly */ \
+  PetscBool         shared_ij;        /* i and j are also used by a matrix from MatDuplicate(...,MAT_SHARE_NONZERO_PATTERN,...) */ \
+  Mat_SeqXAIJSingle *single;          /* set while the values are stored in single precision */ \
   Mat               parent             /* set if this matrix was formed with MatDuplicate(...,MAT_SHARE_NONZERO_PATTERN,....);
                                          means that this shares some data structures with the parent including diag, ilen, imax, i, j */
 
@@ -48,7 +67,9 @@ typedef struct {
 
 typedef struct {
   PetscInt       *api,*apj;    /* symbolic structure of A*P */
-  PetscScalar    *apa;         /* temporary array for storing one row of A*P */
+  PetscScalar    *apa;         /* temporary array for storing one row of A*P, or all of A*P with -matptap_hash */
+  PetscInt       *pti,*ptj;    /* symbolic structure of P^T, with -matptap_hash */
+  PetscInt       *ptperm;      /* location in P of each entry of P^T, with -matptap_hash */
   PetscErrorCode (*destroy)(Mat);
 } Mat_PtAP;
 
@@ -86,6 +107,64 @@ typedef struct {
   PetscBool  checked;                       /* if inodes have been checked for */
 } Mat_SeqAIJ_Inode;
 
+/* Level schedule of the triangular solves of a SeqAIJ LU/ILU or SeqSBAIJ Cholesky/ICC factor, used with -mat_solve_levels */
+typedef struct {
+  PetscBool  syncfree;                /* threads wait for the rows they depend on instead of for the whole level */
+  PetscInt   nlevels[2];              /* number of levels of L and U */
+  PetscInt   *levelstart[2];          /* level l of L (U) consists of rows[0][levelstart[0][l]] to rows[0][levelstart[0][l+1]-1] (rows[1]) */
+  PetscInt   *rows[2];
+  PetscInt   *ready;                  /* sync-free solves: ready[i] == stamp once row i has been computed */
+  PetscInt   stamp;
+  PetscInt   *ti,*trow,*tpos;         /* SBAIJ factors: the entries of column i of U are in rows trow[ti[i]..ti[i+1]-1] at tpos[] */
+} Mat_SeqAIJ_SolveLevels;
+
+extern PetscErrorCode MatSolveLevelsCreate_Private(Mat,Mat_SeqAIJ_SolveLevels**);
+extern PetscErrorCode MatSolveLevelsSetLevels_Private(Mat_SeqAIJ_SolveLevels*,PetscInt,PetscInt,const PetscInt[]);
+extern PetscErrorCode MatSolveLevelsDestroy_Private(Mat_SeqAIJ_SolveLevels**);
+
+/* Arguments of the level scheduled solve kernels of SeqAIJ and SeqSBAIJ factors, adiag and c are only used by SeqAIJ */
+typedef struct {
+  Mat_SeqAIJ_SolveLevels *sl;
+  const PetscInt         *ai,*aj,*adiag,*r,*c;
+  const MatScalar        *aa;
+  const PetscScalar      *b;
+  PetscScalar            *x,*tmp;
+  PetscInt               level,ntasks,nthreads,stamp;
+} MatSolveLevelsCtx;
+
+/* levels with fewer rows than this per task are not split further between threads */
+#define MATSOLVELEVELS_MINROWS 16
+
+/* Threaded Gauss-Seidel/SOR sweeps of a SeqAIJ matrix, used by MatSOR() with -mat_sor_threaded */
+typedef enum {MAT_SOR_THREADED_NONE,MAT_SOR_THREADED_MULTICOLOR,MAT_SOR_THREADED_HYBRID} MatSORThreadedType;
+typedef struct {
+  MatSORThreadedType type;
+  PetscInt    ncolors;                /* multicolor: the rows of color c are rows[colorstart[c]..colorstart[c+1]-1] */
+  PetscInt    *colorstart,*rows;
+  PetscInt    nblocks,*bstarts;       /* hybrid: block k consists of the rows bstarts[k] to bstarts[k+1]-1 */
+  PetscInt    *blo,*bhi;              /* hybrid: the columns of row i inside its block are a->j[blo[i]..bhi[i]-1] */
+  PetscScalar *xold[2];               /* hybrid: x at the start of the current and of the next sweep */
+} Mat_SeqAIJ_SORThreaded;
+
+extern PetscErrorCode MatSeqAIJUseSORThreaded(Mat,MatSORType,PetscBool*);
+extern PetscErrorCode MatSeqAIJSORThreadedDestroy_Private(Mat_SeqAIJ_SORThreaded**);
+extern PetscErrorCode MatSOR_SeqAIJ_Threaded(Mat,Vec,PetscReal,MatSORType,PetscReal,PetscInt,PetscInt,Vec);
+EXTERN_C_BEGIN
+extern PetscErrorCode MatInvertDiagonal_SeqAIJ(Mat,PetscScalar,PetscScalar);
+EXTERN_C_END
+
+extern PetscErrorCode MatSeqXAIJPackSingle_Private(Mat,PetscInt,PetscInt,PetscInt,PetscErrorCode (*)(Mat));
+extern PetscErrorCode MatSeqXAIJUnpackSingle_Private(Mat,PetscInt,PetscInt);
+extern PetscErrorCode MatSeqXAIJDestroySingle_Private(Mat);
+extern PetscErrorCode MatSeqXAIJSetConvertersSingle_Private(Mat,PetscErrorCode (*)(Mat,MatType,MatReuse,Mat*));
+extern PetscErrorCode MatSeqAIJPackSingle_Private(Mat);
+extern PetscErrorCode MatSeqAIJUnpackSingle_Private(Mat);
+extern PetscErrorCode MatSeqAIJFactorBeginSingle_Private(Mat,Mat,PetscBool*);
+extern PetscErrorCode MatSeqAIJFactorEndSingle_Private(Mat,Mat,PetscBool,PetscBool);
+EXTERN_C_BEGIN
+extern PetscErrorCode MatStoreSinglePrecision_SeqAIJ(Mat,PetscBool);
+EXTERN_C_END
+
 extern PetscErrorCode MatView_SeqAIJ_Inode(Mat,PetscViewer);
 extern PetscErrorCode MatAssemblyEnd_SeqAIJ_Inode(Mat,MatAssemblyType);
 extern PetscErrorCode MatDestroy_SeqAIJ_Inode(Mat);
@@ -112,6 +191,8 @@ typedef struct {
   PetscScalar      *matmult_abdense;     /* used by MatMatMult() */
   Mat_PtAP         *ptap;                /* used by MatPtAP() */
   Mat_MatMatMatMult *matmatmatmult;      /* used by MatMatMatMult() */
+  Mat_SeqAIJ_SolveLevels *solvelevels;   /* used by MatSolve() of factors with -mat_solve_levels */
+  Mat_SeqAIJ_SORThreaded *sorthreaded;   /* used by MatSOR() with -mat_sor_threaded */
 } Mat_SeqAIJ;
 
 /*
@@ -188,6 +269,7 @@ extern PetscErrorCode MatCopy_SeqAIJ(Mat,Mat,MatStructure);
 extern PetscErrorCode MatMissingDiagonal_SeqAIJ(Mat,PetscBool *,PetscInt*);
 extern PetscErrorCode MatMarkDiagonal_SeqAIJ(Mat);
 extern PetscErrorCode MatFindZeroDiagonals_SeqAIJ_Private(Mat,PetscInt*,PetscInt**);
+extern PetscErrorCode MatSeqXAIJComputeThreadPartition(Mat,PetscInt,const PetscInt[],PetscInt*[]);
 
 extern PetscErrorCode MatMult_SeqAIJ(Mat A,Vec,Vec);
 extern PetscErrorCode MatMultAdd_SeqAIJ(Mat A,Vec,Vec,Vec);
@@ -217,6 +299,8 @@ extern PetscErrorCode MatSolve_SeqAIJ_Inode(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqAIJ_NaturalOrdering_inplace(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqAIJ_NaturalOrdering(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqAIJ_InplaceWithPerm(Mat,Vec,Vec);
+extern PetscErrorCode MatSolve_SeqAIJ_Levels(Mat,Vec,Vec);
+extern PetscErrorCode MatSeqAIJCheckSolveLevels(Mat);
 extern PetscErrorCode MatSolveAdd_SeqAIJ_inplace(Mat,Vec,Vec,Vec);
 extern PetscErrorCode MatSolveAdd_SeqAIJ(Mat,Vec,Vec,Vec);
 extern PetscErrorCode MatSolveTranspose_SeqAIJ_inplace(Mat,Vec,Vec);
@@ -238,12 +322,18 @@ extern PetscErrorCode MatMatMultSymbolic_SeqAIJ_SeqAIJ_Heap(Mat,Mat,PetscReal,Ma
 extern PetscErrorCode MatMatMultSymbolic_SeqAIJ_SeqAIJ_BTHeap(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatMatMultNumeric_SeqAIJ_SeqAIJ(Mat,Mat,Mat);
 extern PetscErrorCode MatMatMultNumeric_SeqAIJ_SeqAIJ_Scalable(Mat,Mat,Mat);
+extern PetscErrorCode MatMatMultSymbolic_SeqAIJ_SeqAIJ_Hash(Mat,Mat,PetscReal,Mat*);
+extern PetscErrorCode MatMatMultNumeric_SeqAIJ_SeqAIJ_Hash(Mat,Mat,Mat);
+extern PetscErrorCode MatSeqAIJHashProductSymbolic(MPI_Comm,PetscInt,PetscInt,const PetscInt[],const PetscInt[],const PetscInt[],const PetscInt[],PetscInt*[],PetscInt*[]);
+extern PetscErrorCode MatSeqAIJHashProductNumeric(MPI_Comm,PetscInt,const PetscInt[],const PetscInt[],const PetscInt[],const MatScalar[],const PetscInt[],const PetscInt[],const MatScalar[],const PetscInt[],const PetscInt[],MatScalar[]);
 
 extern PetscErrorCode MatPtAP_SeqAIJ_SeqAIJ(Mat,Mat,MatReuse,PetscReal,Mat*);
 extern PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ_SparseAxpy(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatPtAPNumeric_SeqAIJ_SeqAIJ(Mat,Mat,Mat);
 extern PetscErrorCode MatPtAPNumeric_SeqAIJ_SeqAIJ_SparseAxpy(Mat,Mat,Mat);
+extern PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ_Hash(Mat,Mat,PetscReal,Mat*);
+extern PetscErrorCode MatPtAPNumeric_SeqAIJ_SeqAIJ_Hash(Mat,Mat,Mat);
 
 extern PetscErrorCode MatRARtSymbolic_SeqAIJ_SeqAIJ(Mat,Mat,PetscReal,Mat*);
 extern PetscErrorCode MatRARtNumeric_SeqAIJ_SeqAIJ(Mat,Mat,Mat);
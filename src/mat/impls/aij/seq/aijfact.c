@@ -3,6 +3,8 @@
 #include <../src/mat/impls/sbaij/seq/sbaij.h>
 #include <petscbt.h>
 #include <../src/mat/utils/freespace.h>
+#include <petscthreadcomm.h>
+#include <petsc-private/threadcommimpl.h>
 
 EXTERN_C_BEGIN
 #undef __FUNCT__
@@ -464,12 +466,13 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *info)
   Mat_SeqAIJ       *a=(Mat_SeqAIJ*)A->data,*b=(Mat_SeqAIJ *)C->data;
   IS               isrow = b->row,isicol = b->icol;
   PetscErrorCode   ierr;
+  PetscBool        single;
   const PetscInt   *r,*ic,*ics;
   const PetscInt   n=A->rmap->n,*ai=a->i,*aj=a->j,*bi=b->i,*bj=b->j,*bdiag=b->diag;
   PetscInt         i,j,k,nz,nzL,row,*pj;
   const PetscInt   *ajtmp,*bjtmp;
   MatScalar        *rtmp,*pc,multiplier,*pv;
-  const  MatScalar *aa=a->a,*v;
+  const  MatScalar *aa,*v;
   PetscBool        row_identity,col_identity;
   FactorShiftCtx   sctx;
   const PetscInt   *ddiag;
@@ -477,6 +480,8 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *info)
   MatScalar        d;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,B,&single);CHKERRQ(ierr);
+  aa   = a->a;
   /* MatPivotSetUp(): initialize shift context sctx */
   ierr = PetscMemzero(&sctx,sizeof(FactorShiftCtx));CHKERRQ(ierr);
 
@@ -621,6 +626,8 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *info)
     }
   }
   ierr = Mat_CheckInode_FactorLU(C,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatSeqAIJCheckSolveLevels(C);CHKERRQ(ierr);
+  ierr = MatSeqAIJFactorEndSingle_Private(A,B,single,PETSC_TRUE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -632,18 +639,21 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_inplace(Mat B,Mat A,const MatFactorInfo
   Mat_SeqAIJ      *a=(Mat_SeqAIJ*)A->data,*b=(Mat_SeqAIJ *)C->data;
   IS              isrow = b->row,isicol = b->icol;
   PetscErrorCode  ierr;
+  PetscBool       single;
   const PetscInt   *r,*ic,*ics;
   PetscInt        nz,row,i,j,n=A->rmap->n,diag;
   const PetscInt  *ai=a->i,*aj=a->j,*bi=b->i,*bj=b->j;
   const PetscInt  *ajtmp,*bjtmp,*diag_offset = b->diag,*pj;
   MatScalar       *pv,*rtmp,*pc,multiplier,d;
-  const MatScalar *v,*aa=a->a;
+  const MatScalar *v,*aa;
   PetscReal       rs=0.0;
   FactorShiftCtx  sctx;
   const PetscInt  *ddiag;
   PetscBool       row_identity, col_identity;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,B,&single);CHKERRQ(ierr);
+  aa   = a->a;
   /* MatPivotSetUp(): initialize shift context sctx */
   ierr = PetscMemzero(&sctx,sizeof(FactorShiftCtx));CHKERRQ(ierr);
 
@@ -765,6 +775,7 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_inplace(Mat B,Mat A,const MatFactorInfo
   (C)->ops->solve            = MatSolve_SeqAIJ_inplace;
   (C)->ops->solvetranspose   = MatSolveTranspose_SeqAIJ_inplace;
   ierr = Mat_CheckInode(C,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatSeqAIJFactorEndSingle_Private(A,B,single,PETSC_FALSE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -2081,17 +2092,20 @@ PetscErrorCode MatCholeskyFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *
   Mat_SeqSBAIJ   *b=(Mat_SeqSBAIJ*)C->data;
   IS             ip=b->row,iip = b->icol;
   PetscErrorCode ierr;
+  PetscBool      single;
   const PetscInt *rip,*riip;
   PetscInt       i,j,mbs=A->rmap->n,*bi=b->i,*bj=b->j,*bdiag=b->diag,*bjtmp;
   PetscInt       *ai=a->i,*aj=a->j;
   PetscInt       k,jmin,jmax,*c2r,*il,col,nexti,ili,nz;
-  MatScalar      *rtmp,*ba=b->a,*bval,*aa=a->a,dk,uikdi;
+  MatScalar      *rtmp,*ba=b->a,*bval,*aa,dk,uikdi;
   PetscBool      perm_identity;
   FactorShiftCtx sctx;
   PetscReal      rs;
   MatScalar      d,*v;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,PETSC_NULL,&single);CHKERRQ(ierr);
+  aa   = a->a;
   /* MatPivotSetUp(): initialize shift context sctx */
   ierr = PetscMemzero(&sctx,sizeof(FactorShiftCtx));CHKERRQ(ierr);
 
@@ -2210,6 +2224,7 @@ PetscErrorCode MatCholeskyFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *
     B->ops->forwardsolve    = MatForwardSolve_SeqSBAIJ_1;
     B->ops->backwardsolve   = MatBackwardSolve_SeqSBAIJ_1;
   }
+  ierr = MatSeqSBAIJCheckSolveLevels(B);CHKERRQ(ierr);
 
   C->assembled    = PETSC_TRUE;
   C->preallocated = PETSC_TRUE;
@@ -2225,6 +2240,7 @@ PetscErrorCode MatCholeskyFactorNumeric_SeqAIJ(Mat B,Mat A,const MatFactorInfo *
       ierr = PetscInfo2(A,"number of shift_inblocks applied %D, each shift_amount %G\n",sctx.nshift,info->shiftamount);CHKERRQ(ierr);
     }
   }
+  ierr = MatSeqAIJFactorEndSingle_Private(A,PETSC_NULL,single,PETSC_FALSE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -2237,17 +2253,20 @@ PetscErrorCode MatCholeskyFactorNumeric_SeqAIJ_inplace(Mat B,Mat A,const MatFact
   Mat_SeqSBAIJ   *b=(Mat_SeqSBAIJ*)C->data;
   IS             ip=b->row,iip = b->icol;
   PetscErrorCode ierr;
+  PetscBool      single;
   const PetscInt *rip,*riip;
   PetscInt       i,j,mbs=A->rmap->n,*bi=b->i,*bj=b->j,*bcol,*bjtmp;
   PetscInt       *ai=a->i,*aj=a->j;
   PetscInt       k,jmin,jmax,*jl,*il,col,nexti,ili,nz;
-  MatScalar      *rtmp,*ba=b->a,*bval,*aa=a->a,dk,uikdi;
+  MatScalar      *rtmp,*ba=b->a,*bval,*aa,dk,uikdi;
   PetscBool      perm_identity;
   FactorShiftCtx sctx;
   PetscReal      rs;
   MatScalar      d,*v;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,PETSC_NULL,&single);CHKERRQ(ierr);
+  aa   = a->a;
   /* MatPivotSetUp(): initialize shift context sctx */
   ierr = PetscMemzero(&sctx,sizeof(FactorShiftCtx));CHKERRQ(ierr);
 
@@ -2381,6 +2400,7 @@ PetscErrorCode MatCholeskyFactorNumeric_SeqAIJ_inplace(Mat B,Mat A,const MatFact
       ierr = PetscInfo2(A,"number of shiftpd tries %D, shift_amount %G\n",sctx.nshift,sctx.shift_amount);CHKERRQ(ierr);
     }
   }
+  ierr = MatSeqAIJFactorEndSingle_Private(A,PETSC_NULL,single,PETSC_FALSE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -3222,6 +3242,300 @@ PetscErrorCode MatSolve_SeqAIJ(Mat A,Vec bb,Vec xx)
   PetscFunctionReturn(0);
 }
 
+/*
+   Level scheduled triangular solves of SeqAIJ and SeqSBAIJ factors.
+
+   Row i of L depends on the rows j < i of its nonzeros, so it is placed one level above the highest of
+   them, and likewise for U from the last row up. All the rows of one level can then be computed at the
+   same time by the threads of the matrix's communicator. With -mat_solve_levels all threads finish a
+   level before the next one is started; with -mat_solve_levels_syncfree each thread gets a fixed part of
+   every level, works through its parts level by level and only waits for the rows it depends on, using a
+   ready flag per row.
+*/
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsCreate_Private"
+/*
+   MatSolveLevelsCreate_Private - Called at the end of a numeric factorization. With -mat_solve_levels or
+   -mat_solve_levels_syncfree it makes sure *sl exists for the n rows of the factor A and resets the ready
+   flags, otherwise it destroys *sl.
+
+   The levels are recomputed with every numeric factorization since the factor may have been given
+   a new nonzero structure by a symbolic factorization in the meantime.
+*/
+PetscErrorCode MatSolveLevelsCreate_Private(Mat A,Mat_SeqAIJ_SolveLevels **sl)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,n = A->rmap->n;
+  PetscBool      flg = PETSC_FALSE,syncfree = PETSC_FALSE;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsGetBool(((PetscObject)A)->prefix,"-mat_solve_levels",&flg,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)A)->prefix,"-mat_solve_levels_syncfree",&syncfree,PETSC_NULL);CHKERRQ(ierr);
+  if (!flg && !syncfree) {
+    ierr = MatSolveLevelsDestroy_Private(sl);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (!*sl) {
+    ierr = PetscNewLog(A,Mat_SeqAIJ_SolveLevels,sl);CHKERRQ(ierr);
+    ierr = PetscMalloc5(n+1,PetscInt,&(*sl)->levelstart[0],n+1,PetscInt,&(*sl)->levelstart[1],n,PetscInt,&(*sl)->rows[0],n,PetscInt,&(*sl)->rows[1],n,PetscInt,&(*sl)->ready);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory(A,(5*n+2)*sizeof(PetscInt));CHKERRQ(ierr);
+  }
+  (*sl)->syncfree = syncfree;
+  (*sl)->stamp    = 0;
+  for (i=0; i<n; i++) (*sl)->ready[i] = -1;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsSetLevels_Private"
+/*
+   MatSolveLevelsSetLevels_Private - Sorts the n rows of L (k=0) or U (k=1) by their levels lev[], the rows of
+   each level stay in increasing order
+*/
+PetscErrorCode MatSolveLevelsSetLevels_Private(Mat_SeqAIJ_SolveLevels *sl,PetscInt k,PetscInt n,const PetscInt lev[])
+{
+  PetscErrorCode ierr;
+  PetscInt       i,l,nlev = 0,*levelstart = sl->levelstart[k],*rows = sl->rows[k];
+
+  PetscFunctionBegin;
+  for (i=0; i<n; i++) nlev = PetscMax(nlev,lev[i]+1);
+  sl->nlevels[k] = nlev;
+  ierr = PetscMemzero(levelstart,(nlev+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<n; i++) levelstart[lev[i]+1]++;
+  for (l=0; l<nlev; l++) levelstart[l+1] += levelstart[l];
+  for (i=0; i<n; i++) rows[levelstart[lev[i]]++] = i;
+  for (l=nlev; l>0; l--) levelstart[l] = levelstart[l-1];
+  levelstart[0] = 0;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsDestroy_Private"
+PetscErrorCode MatSolveLevelsDestroy_Private(Mat_SeqAIJ_SolveLevels **sl)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!*sl) PetscFunctionReturn(0);
+  ierr = PetscFree5((*sl)->levelstart[0],(*sl)->levelstart[1],(*sl)->rows[0],(*sl)->rows[1],(*sl)->ready);CHKERRQ(ierr);
+  if ((*sl)->ti) {ierr = PetscFree3((*sl)->ti,(*sl)->trow,(*sl)->tpos);CHKERRQ(ierr);}
+  ierr = PetscFree(*sl);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJCheckSolveLevels"
+/*
+   MatSeqAIJCheckSolveLevels - Called at the end of the numeric LU/ILU factorization of a SeqAIJ matrix;
+   with -mat_solve_levels or -mat_solve_levels_syncfree it computes the levels of the factor and replaces
+   its MatSolve() with the threaded one.
+*/
+PetscErrorCode MatSeqAIJCheckSolveLevels(Mat A)
+{
+  Mat_SeqAIJ             *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJ_SolveLevels *sl;
+  PetscErrorCode         ierr;
+  PetscInt               n = A->rmap->n,*ai = a->i,*aj = a->j,*adiag = a->diag,*lev,i,j,l;
+
+  PetscFunctionBegin;
+  ierr = MatSolveLevelsCreate_Private(A,&a->solvelevels);CHKERRQ(ierr);
+  if (!(sl = a->solvelevels)) PetscFunctionReturn(0);
+
+  ierr = PetscMalloc(n*sizeof(PetscInt),&lev);CHKERRQ(ierr);
+  /* L, forward from the first row */
+  for (i=0; i<n; i++) {
+    for (j=ai[i],l=0; j<ai[i+1]; j++) l = PetscMax(l,lev[aj[j]]+1);
+    lev[i] = l;
+  }
+  ierr = MatSolveLevelsSetLevels_Private(sl,0,n,lev);CHKERRQ(ierr);
+  /* U, backward from the last row */
+  for (i=n-1; i>=0; i--) {
+    for (j=adiag[i+1]+1,l=0; j<adiag[i]; j++) l = PetscMax(l,lev[aj[j]]+1);
+    lev[i] = l;
+  }
+  ierr = MatSolveLevelsSetLevels_Private(sl,1,n,lev);CHKERRQ(ierr);
+  ierr = PetscFree(lev);CHKERRQ(ierr);
+
+  A->ops->solve = MatSolve_SeqAIJ_Levels;
+  ierr = PetscInfo4(A,"Triangular solves with %D levels for L and %D levels for U of %D rows%s\n",sl->nlevels[0],sl->nlevels[1],n,sl->syncfree ? ", sync-free" : "");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsForward_Task"
+/* task t of the current level of L */
+static PetscErrorCode MatSolveLevelsForward_Task(PetscInt thread_id,PetscInt t,PetscInt tend,void *ctx)
+{
+  MatSolveLevelsCtx *lc = (MatSolveLevelsCtx*)ctx;
+  const PetscInt    *ls = lc->sl->levelstart[0] + lc->level,*rows = lc->sl->rows[0],*ai = lc->ai,*r = lc->r,*vi;
+  const MatScalar   *v;
+  const PetscScalar *b = lc->b;
+  PetscScalar       *tmp = lc->tmp,sum;
+  PetscInt          k,i,nz,kstart = ls[0] + ((ls[1]-ls[0])*t)/lc->ntasks,kend = ls[0] + ((ls[1]-ls[0])*(t+1))/lc->ntasks;
+
+  for (k=kstart; k<kend; k++) {
+    i   = rows[k];
+    nz  = ai[i+1] - ai[i];
+    v   = lc->aa + ai[i];
+    vi  = lc->aj + ai[i];
+    sum = b[r[i]];
+    PetscSparseDenseMinusDot(sum,tmp,v,vi,nz);
+    tmp[i] = sum;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsBackward_Task"
+/* task t of the current level of U */
+static PetscErrorCode MatSolveLevelsBackward_Task(PetscInt thread_id,PetscInt t,PetscInt tend,void *ctx)
+{
+  MatSolveLevelsCtx *lc = (MatSolveLevelsCtx*)ctx;
+  const PetscInt    *ls = lc->sl->levelstart[1] + lc->level,*rows = lc->sl->rows[1],*adiag = lc->adiag,*c = lc->c,*vi;
+  const MatScalar   *v;
+  PetscScalar       *tmp = lc->tmp,*x = lc->x,sum;
+  PetscInt          k,i,nz,kstart = ls[0] + ((ls[1]-ls[0])*t)/lc->ntasks,kend = ls[0] + ((ls[1]-ls[0])*(t+1))/lc->ntasks;
+
+  for (k=kstart; k<kend; k++) {
+    i   = rows[k];
+    v   = lc->aa + adiag[i+1]+1;
+    vi  = lc->aj + adiag[i+1]+1;
+    nz  = adiag[i]-adiag[i+1]-1;
+    sum = tmp[i];
+    PetscSparseDenseMinusDot(sum,tmp,v,vi,nz);
+    x[c[i]] = tmp[i] = sum*v[nz];
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsForward_SyncFree"
+/* thread thread_id computes its part of every level of L, waiting for the rows owned by other threads */
+static PetscErrorCode MatSolveLevelsForward_SyncFree(PetscInt thread_id,MatSolveLevelsCtx *lc)
+{
+  Mat_SeqAIJ_SolveLevels *sl = lc->sl;
+  const PetscInt         *ls = sl->levelstart[0],*rows = sl->rows[0],*ai = lc->ai,*aj = lc->aj,*r = lc->r;
+  const MatScalar        *aa = lc->aa;
+  const PetscScalar      *b = lc->b;
+  PetscScalar            *tmp = lc->tmp,sum;
+  PetscInt               *ready = sl->ready,stamp = lc->stamp,nt = lc->nthreads,l,k,i,j,col,kstart,kend;
+
+  for (l=0; l<sl->nlevels[0]; l++) {
+    kstart = ls[l] + ((ls[l+1]-ls[l])*thread_id)/nt;
+    kend   = ls[l] + ((ls[l+1]-ls[l])*(thread_id+1))/nt;
+    for (k=kstart; k<kend; k++) {
+      i   = rows[k];
+      sum = b[r[i]];
+      for (j=ai[i]; j<ai[i+1]; j++) {
+        col = aj[j];
+        while (PetscReadOnce(PetscInt,ready[col]) != stamp) ;
+        PetscReadMemoryBarrier();
+        sum -= aa[j]*PetscReadOnce(PetscScalar,tmp[col]);
+      }
+      PetscReadOnce(PetscScalar,tmp[i]) = sum;
+      PetscWriteMemoryBarrier();
+      PetscReadOnce(PetscInt,ready[i]) = stamp;
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsBackward_SyncFree"
+static PetscErrorCode MatSolveLevelsBackward_SyncFree(PetscInt thread_id,MatSolveLevelsCtx *lc)
+{
+  Mat_SeqAIJ_SolveLevels *sl = lc->sl;
+  const PetscInt         *ls = sl->levelstart[1],*rows = sl->rows[1],*adiag = lc->adiag,*aj = lc->aj,*c = lc->c;
+  const MatScalar        *aa = lc->aa;
+  PetscScalar            *tmp = lc->tmp,*x = lc->x,sum;
+  PetscInt               *ready = sl->ready,stamp = lc->stamp,nt = lc->nthreads,l,k,i,j,col,kstart,kend;
+
+  for (l=0; l<sl->nlevels[1]; l++) {
+    kstart = ls[l] + ((ls[l+1]-ls[l])*thread_id)/nt;
+    kend   = ls[l] + ((ls[l+1]-ls[l])*(thread_id+1))/nt;
+    for (k=kstart; k<kend; k++) {
+      i   = rows[k];
+      sum = tmp[i];
+      for (j=adiag[i+1]+1; j<adiag[i]; j++) {
+        col = aj[j];
+        while (PetscReadOnce(PetscInt,ready[col]) != stamp) ;
+        PetscReadMemoryBarrier();
+        sum -= aa[j]*PetscReadOnce(PetscScalar,tmp[col]);
+      }
+      sum *= aa[adiag[i]];
+      x[c[i]] = sum;
+      PetscReadOnce(PetscScalar,tmp[i]) = sum;
+      PetscWriteMemoryBarrier();
+      PetscReadOnce(PetscInt,ready[i]) = stamp;
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolve_SeqAIJ_Levels"
+PetscErrorCode MatSolve_SeqAIJ_Levels(Mat A,Vec bb,Vec xx)
+{
+  Mat_SeqAIJ             *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJ_SolveLevels *sl = a->solvelevels;
+  MPI_Comm               comm = ((PetscObject)A)->comm;
+  PetscErrorCode         ierr;
+  PetscInt               n = A->rmap->n,l,k,nrows;
+  MatSolveLevelsCtx      lc;
+
+  PetscFunctionBegin;
+  if (!n) PetscFunctionReturn(0);
+  ierr = PetscThreadCommGetNThreads(comm,&lc.nthreads);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&lc.b);CHKERRQ(ierr);
+  ierr = VecGetArray(xx,&lc.x);CHKERRQ(ierr);
+  ierr = ISGetIndices(a->row,&lc.r);CHKERRQ(ierr);
+  ierr = ISGetIndices(a->col,&lc.c);CHKERRQ(ierr);
+  lc.sl    = sl;
+  lc.ai    = a->i;
+  lc.aj    = a->j;
+  lc.adiag = a->diag;
+  lc.aa    = a->a;
+  lc.tmp   = a->solve_work;
+
+  if (sl->syncfree && lc.nthreads > 1) {
+    if (sl->stamp > PETSC_MAX_INT - 2) {
+      for (k=0; k<n; k++) sl->ready[k] = -1;
+      sl->stamp = 0;
+    }
+    /* The end of the forward kernel is the only synchronization between L and U, tmp[] is overwritten by U.
+       lc lives on this stack, so wait for all threads after each kernel even if the pool does not synchronize
+       after kernels; the barrier returns at once when it does */
+    lc.stamp = ++sl->stamp;
+    ierr = PetscThreadCommRunKernel(comm,(PetscThreadKernel)MatSolveLevelsForward_SyncFree,1,&lc);CHKERRQ(ierr);
+    ierr = PetscThreadCommBarrier(comm);CHKERRQ(ierr);
+    lc.stamp = ++sl->stamp;
+    ierr = PetscThreadCommRunKernel(comm,(PetscThreadKernel)MatSolveLevelsBackward_SyncFree,1,&lc);CHKERRQ(ierr);
+    ierr = PetscThreadCommBarrier(comm);CHKERRQ(ierr);
+  } else {
+    for (k=0; k<2; k++) {
+      PetscThreadTaskKernel kernel = k ? MatSolveLevelsBackward_Task : MatSolveLevelsForward_Task;
+      for (l=0; l<sl->nlevels[k]; l++) {
+        nrows     = sl->levelstart[k][l+1] - sl->levelstart[k][l];
+        lc.level  = l;
+        lc.ntasks = PetscMax(1,PetscMin(lc.nthreads,nrows/MATSOLVELEVELS_MINROWS));
+        if (lc.ntasks == 1) {
+          ierr = (*kernel)(0,0,1,&lc);CHKERRQ(ierr);
+        } else {
+          ierr = PetscThreadCommRunTasks(comm,lc.ntasks,PETSC_NULL,kernel,&lc);CHKERRQ(ierr);
+        }
+      }
+    }
+  }
+
+  ierr = ISRestoreIndices(a->row,&lc.r);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(a->col,&lc.c);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&lc.b);CHKERRQ(ierr);
+  ierr = VecRestoreArray(xx,&lc.x);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2*a->nz - A->cmap->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatILUDTFactor_SeqAIJ"
 /*
@@ -3245,9 +3559,10 @@ PetscErrorCode MatILUDTFactor_SeqAIJ(Mat A,IS isrow,IS iscol,const MatFactorInfo
   PetscInt           j,nz,*pj,*bjtmp,k,ncut,*jtmp;
   PetscReal          dt=info->dt,shift=info->shiftamount;
   PetscInt           dtcount=(PetscInt)info->dtcount,nnz_max;
-  PetscBool          missing;
+  PetscBool          missing,single;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,PETSC_NULL,&single);CHKERRQ(ierr);
 
   if (dt      == PETSC_DEFAULT) dt      = 0.005;
   if (dtcount == PETSC_DEFAULT) dtcount = (PetscInt)(1.5*a->rmax);
@@ -3466,6 +3781,7 @@ PetscErrorCode MatILUDTFactor_SeqAIJ(Mat A,IS isrow,IS iscol,const MatFactorInfo
   B->ops->matsolve          = 0;
   B->assembled              = PETSC_TRUE;
   B->preallocated           = PETSC_TRUE;
+  ierr = MatSeqAIJFactorEndSingle_Private(A,PETSC_NULL,single,PETSC_FALSE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -0,0 +1,1348 @@
+
+/*
+   Storage of the values of SeqAIJ (and SeqBAIJ) matrices in single precision, see MatStoreSinglePrecision()
+
+   After the final assembly the values a->a are converted into a single precision copy and released. The
+   operations of the matrix are saved and replaced with a short list that works on the single precision
+   values, accumulating in the precision of PetscScalar. Operations that change the values first convert
+   them back to full precision; they are stored in single precision again at the next final assembly.
+*/
+#include <../src/mat/impls/aij/seq/aij.h>          /*I "petscmat.h" I*/
+#include <petscthreadcomm.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision"
+/*@
+   MatStoreSinglePrecision - Keeps the values of the matrix in single precision, while the vectors
+   it is applied to stay in the precision PETSc was configured with.
+
+   Logically Collective on Mat
+
+   Input Parameters:
++  mat - the matrix, SEQAIJ, MPIAIJ or SEQBAIJ
+-  flg - PETSC_TRUE to store the values in single precision, PETSC_FALSE to return to full precision
+
+   Options Database Key:
+.  -mat_store_single - calls MatStoreSinglePrecision(mat,PETSC_TRUE) from MatSetFromOptions(), ignored by other matrix types
+
+   Notes:
+   The values are converted to single precision at the end of each MatAssemblyEnd() with MAT_FINAL_ASSEMBLY,
+   or right away if the matrix is already assembled; this halves the memory used by the values.
+   MatMult(), MatMultAdd(), MatMultTranspose(), MatSOR(), MatGetDiagonal() and MatGetRow() work directly
+   on the single precision values and accumulate in full precision. The LU and ILU factors of a
+   SEQAIJ matrix are computed in full precision and then also stored in single precision, so MatSolve()
+   works on them as well; the Cholesky and ICC factors are kept in full precision. A SEQBAIJ matrix
+   cannot be factored while its values are stored in single precision.
+
+   This is meant for matrices from which preconditioners are built, which tolerate the lower precision,
+   for example the second matrix passed to KSPSetOperators().
+
+   MatSetValues() and MatZeroRows() convert the values back to full precision (with the rounding of single
+   precision) until the next final assembly. MatGetValues() also works on the single precision values; most other
+   operations, such as MatAXPY(), MatTranspose() or MatConvert(), work on a temporary full precision copy, which is
+   slow if they are called often. Matrix products such as MatMatMult() and MatPtAP() are not available while the
+   values are stored in single precision; call MatStoreSinglePrecision(mat,PETSC_FALSE) before them.
+   A SEQBAIJ matrix whose nonzero structure is shared by a duplicate from MatDuplicate() with
+   MAT_SHARE_NONZERO_PATTERN may keep its values in full precision.
+
+   Not available with complex numbers.
+
+   Level: advanced
+
+.seealso: MatStoreValues(), KSPSetOperators()
+@*/
+PetscErrorCode MatStoreSinglePrecision(Mat mat,PetscBool flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(mat,MAT_CLASSID,1);
+  PetscValidLogicalCollectiveBool(mat,flg,2);
+  if (mat->factortype) SETERRQ(((PetscObject)mat)->comm,PETSC_ERR_ARG_WRONGSTATE,"Not for factored matrix");
+  ierr = PetscUseMethod(mat,"MatStoreSinglePrecision_C",(Mat,PetscBool),(mat,flg));CHKERRQ(ierr);
+  ierr = PetscObjectStateIncrease((PetscObject)mat);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#if defined(PETSC_USE_COMPLEX)
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJPackSingle_Private"
+PetscErrorCode MatSeqXAIJPackSingle_Private(Mat A,PetscInt mbs,PetscInt nz,PetscInt bs2,PetscErrorCode (*setops)(Mat))
+{
+  PetscFunctionBegin;
+  SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Single precision storage of the values is not available with complex numbers");
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJUnpackSingle_Private"
+PetscErrorCode MatSeqXAIJUnpackSingle_Private(Mat A,PetscInt nz,PetscInt bs2)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJDestroySingle_Private"
+PetscErrorCode MatSeqXAIJDestroySingle_Private(Mat A)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJPackSingle_Private"
+PetscErrorCode MatSeqAIJPackSingle_Private(Mat A)
+{
+  PetscFunctionBegin;
+  SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Single precision storage of the values is not available with complex numbers");
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJUnpackSingle_Private"
+PetscErrorCode MatSeqAIJUnpackSingle_Private(Mat A)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJFactorBeginSingle_Private"
+PetscErrorCode MatSeqAIJFactorBeginSingle_Private(Mat A,Mat fact,PetscBool *single)
+{
+  PetscFunctionBegin;
+  *single = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJFactorEndSingle_Private"
+PetscErrorCode MatSeqAIJFactorEndSingle_Private(Mat A,Mat fact,PetscBool single,PetscBool packfactor)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision_SeqAIJ"
+PetscErrorCode MatStoreSinglePrecision_SeqAIJ(Mat A,PetscBool flg)
+{
+  PetscFunctionBegin;
+  if (flg) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Single precision storage of the values is not available with complex numbers");
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#else
+/* ----------------------------------------------------------------------------------------------------
+   Shared by SeqAIJ and SeqBAIJ: nz is the number of (block) entries of a->j and bs2 the size of a block
+*/
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJPackSingle_Private"
+/*
+   MatSeqXAIJPackSingle_Private - Replaces the values of the matrix with a single precision copy; setops() installs
+   the operations that work on it, after the original ones have been saved in a->single->ops.
+
+   The arrays a->j and a->i of a matrix obtained with one malloc are moved into their own allocations, so that
+   the space of the full precision values is returned; this is not done while they are shared with a duplicate,
+   which then keeps the values in full precision. Values provided by the user are left alone.
+*/
+PetscErrorCode MatSeqXAIJPackSingle_Private(Mat A,PetscInt mbs,PetscInt nz,PetscInt bs2,PetscErrorCode (*setops)(Mat))
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqXAIJSingle *single;
+  PetscInt          k,*ai,*aj;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (a->single) PetscFunctionReturn(0);
+  if (!a->singlemalloc && !a->free_a) {
+    ierr = PetscInfo(A,"The values are provided by the user, they are not stored in single precision\n");CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (a->singlemalloc && a->shared_ij) {
+    ierr = PetscInfo(A,"The nonzero structure is shared with a duplicate, the values are not stored in single precision\n");CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  ierr = PetscNew(Mat_SeqXAIJSingle,&single);CHKERRQ(ierr);
+  ierr = PetscMalloc((nz*bs2+1)*sizeof(MatScalarSingle),&single->a);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(A,sizeof(Mat_SeqXAIJSingle)+nz*bs2*sizeof(MatScalarSingle));CHKERRQ(ierr);
+  for (k=0; k<nz*bs2; k++) single->a[k] = (MatScalarSingle)a->a[k];
+
+  if (a->singlemalloc) {
+    ierr = PetscMalloc((nz+1)*sizeof(PetscInt),&aj);CHKERRQ(ierr);
+    ierr = PetscMalloc((mbs+1)*sizeof(PetscInt),&ai);CHKERRQ(ierr);
+    ierr = PetscMemcpy(aj,a->j,nz*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscMemcpy(ai,a->i,(mbs+1)*sizeof(PetscInt));CHKERRQ(ierr);
+    ierr = PetscFree3(a->a,a->j,a->i);CHKERRQ(ierr);
+    a->j            = aj;
+    a->i            = ai;
+    a->singlemalloc = PETSC_FALSE;
+    a->free_ij      = PETSC_TRUE;
+  } else {
+    ierr = PetscFree(a->a);CHKERRQ(ierr);
+  }
+  a->a      = PETSC_NULL;
+  a->free_a = PETSC_TRUE;
+  a->maxnz  = nz;
+  a->single = single;
+
+  single->ops = *A->ops;
+  ierr = PetscMemzero(A->ops,sizeof(struct _MatOps));CHKERRQ(ierr);
+  ierr = (*setops)(A);CHKERRQ(ierr);
+  ierr = PetscInfo2(A,"Storing %D values in single precision, %D bytes released\n",nz*bs2,(PetscInt)(nz*bs2*(sizeof(MatScalar)-sizeof(MatScalarSingle))));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJUnpackSingle_Private"
+/*
+   MatSeqXAIJUnpackSingle_Private - Converts the values back to full precision and restores the operations
+*/
+PetscErrorCode MatSeqXAIJUnpackSingle_Private(Mat A,PetscInt nz,PetscInt bs2)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqXAIJSingle *single = a->single;
+  PetscInt          k;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!single) PetscFunctionReturn(0);
+  if (single->getrowactive) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"MatRestoreRow() must be called first");
+  ierr = PetscMalloc((nz*bs2+1)*sizeof(MatScalar),&a->a);CHKERRQ(ierr);
+  for (k=0; k<nz*bs2; k++) a->a[k] = single->a[k];
+  *A->ops = single->ops;
+  ierr = MatSeqXAIJSetConvertersSingle_Private(A,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MatSeqXAIJDestroySingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJDestroySingle_Private"
+PetscErrorCode MatSeqXAIJDestroySingle_Private(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!a->single) PetscFunctionReturn(0);
+  ierr = PetscFree(a->single->a);CHKERRQ(ierr);
+  ierr = PetscFree(a->single->rowvalues);CHKERRQ(ierr);
+  ierr = PetscFree(a->single);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* the types SeqAIJ and SeqBAIJ matrices are converted to with composed functions, which read a->a */
+static const char *const MatConvertSingleTypes[MAT_SINGLE_NCONVERTERS] = {MATSEQAIJ,MATSEQBAIJ,MATSEQSBAIJ,MATSEQAIJPERM,MATSEQAIJCRL,MATSEQSELL,MATSEQAIJDELTA,MATSEQBSTRM};
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqXAIJSetConvertersSingle_Private"
+/*
+   MatSeqXAIJSetConvertersSingle_Private - Composes convert, which unpacks the matrix first, in place of the conversions
+   of the matrix and saves them in a->single; with convert PETSC_NULL they are composed again
+*/
+PetscErrorCode MatSeqXAIJSetConvertersSingle_Private(Mat A,PetscErrorCode (*convert)(Mat,MatType,MatReuse,Mat*))
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqXAIJSingle *single = a->single;
+  char              name[256];
+  PetscInt          k;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<MAT_SINGLE_NCONVERTERS; k++) {
+    ierr = PetscStrcpy(name,"MatConvert_");CHKERRQ(ierr);
+    ierr = PetscStrcat(name,((PetscObject)A)->type_name);CHKERRQ(ierr);
+    ierr = PetscStrcat(name,"_");CHKERRQ(ierr);
+    ierr = PetscStrcat(name,MatConvertSingleTypes[k]);CHKERRQ(ierr);
+    ierr = PetscStrcat(name,"_C");CHKERRQ(ierr);
+    if (convert) {
+      ierr = PetscObjectQueryFunction((PetscObject)A,name,&single->converters[k]);CHKERRQ(ierr);
+      if (single->converters[k]) {ierr = PetscObjectComposeFunction((PetscObject)A,name,"",(PetscVoidFunction)convert);CHKERRQ(ierr);}
+    } else if (single->converters[k]) {
+      ierr = PetscObjectComposeFunction((PetscObject)A,name,"",single->converters[k]);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+#if defined(PETSC_THREADCOMM_ACTIVE)
+PetscErrorCode MatMultAdd_SeqAIJ_Single_Kernel(PetscInt thread_id,Mat A,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *aa;
+  const PetscInt        *aj,*ai = a->i;
+  PetscInt              n,i,start,end;
+  PetscScalar           sum;
+
+  start = a->trstarts[thread_id];
+  end   = a->trstarts[thread_id+1];
+  for (i=start; i<end; i++) {
+    n   = ai[i+1] - ai[i];
+    aj  = a->j + ai[i];
+    aa  = a->single->a + ai[i];
+    sum = y ? y[i] : 0.0;
+    PetscSparseDensePlusDot(sum,x,aa,aj,n);
+    z[i] = sum;
+  }
+  return 0;
+}
+#endif
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqAIJ_Single_Private"
+/* z = A x + y, or z = A x if y is null */
+static PetscErrorCode MatMultAdd_SeqAIJ_Single_Private(Mat A,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *aa;
+  const PetscInt        *aj,*ii,*ridx;
+  PetscInt              m = A->rmap->n,n,i;
+  PetscScalar           sum;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (a->compressedrow.use) {
+    if (!y) {
+      ierr = PetscMemzero(z,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    } else if (z != y) {
+      ierr = PetscMemcpy(z,y,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    }
+    m    = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+    for (i=0; i<m; i++) {
+      n   = ii[i+1] - ii[i];
+      aj  = a->j + ii[i];
+      aa  = a->single->a + ii[i];
+      sum = z[ridx[i]];
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+      z[ridx[i]] = sum;
+    }
+  } else {
+#if defined(PETSC_THREADCOMM_ACTIVE)
+    if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,m,a->i,&a->trstarts);CHKERRQ(ierr);}
+    ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqAIJ_Single_Kernel,4,A,x,y,z);CHKERRQ(ierr);
+#else
+    ii = a->i;
+    for (i=0; i<m; i++) {
+      n   = ii[i+1] - ii[i];
+      aj  = a->j + ii[i];
+      aa  = a->single->a + ii[i];
+      sum = y ? y[i] : 0.0;
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+      z[i] = sum;
+    }
+#endif
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqAIJ_Single"
+static PetscErrorCode MatMult_SeqAIJ_Single(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqAIJ_Single_Private(A,x,PETSC_NULL,y);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz - (a->compressedrow.use ? a->compressedrow.nrows : A->rmap->n));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqAIJ_Single"
+static PetscErrorCode MatMultAdd_SeqAIJ_Single(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y,*z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  } else {
+    z = y;
+  }
+  ierr = MatMultAdd_SeqAIJ_Single_Private(A,x,y,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTransposeAdd_SeqAIJ_Single"
+static PetscErrorCode MatMultTransposeAdd_SeqAIJ_Single(Mat A,Vec xx,Vec zz,Vec yy)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar     *x;
+  PetscScalar           *y,alpha;
+  const MatScalarSingle *v;
+  const PetscInt        *idx,*ii,*ridx = PETSC_NULL;
+  PetscInt              m = A->rmap->n,n,i,j;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (zz != yy) {ierr = VecCopy(zz,yy);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  if (a->compressedrow.use) {
+    m    = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  } else {
+    ii = a->i;
+  }
+  for (i=0; i<m; i++) {
+    idx   = a->j + ii[i];
+    v     = a->single->a + ii[i];
+    n     = ii[i+1] - ii[i];
+    alpha = ridx ? x[ridx[i]] : x[i];
+    for (j=0; j<n; j++) y[idx[j]] += alpha*v[j];
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTranspose_SeqAIJ_Single"
+static PetscErrorCode MatMultTranspose_SeqAIJ_Single(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSet(yy,0.0);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_SeqAIJ_Single(A,xx,yy,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetDiagonal_SeqAIJ_Single"
+static PetscErrorCode MatGetDiagonal_SeqAIJ_Single(Mat A,Vec v)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       i,j,n;
+  PetscScalar    *x;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetLocalSize(v,&n);CHKERRQ(ierr);
+  if (n != A->rmap->n) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Nonconforming matrix and vector");
+  ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    x[i] = 0.0;
+    for (j=a->i[i]; j<a->i[i+1]; j++) {
+      if (a->j[j] == i) {
+        x[i] = a->single->a[j];
+        break;
+      }
+    }
+  }
+  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRow_SeqAIJ_Single"
+static PetscErrorCode MatGetRow_SeqAIJ_Single(Mat A,PetscInt row,PetscInt *nz,PetscInt **idx,PetscScalar **v)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqXAIJSingle *single = a->single;
+  PetscInt          k;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (row < 0 || row >= A->rmap->n) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row %D out of range",row);
+  if (single->getrowactive) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Already active row");
+  *nz = a->i[row+1] - a->i[row];
+  if (v) {
+    if (!single->rowvalues) {
+      ierr = PetscMalloc((a->rmax+1)*sizeof(PetscScalar),&single->rowvalues);CHKERRQ(ierr);
+    }
+    for (k=0; k<*nz; k++) single->rowvalues[k] = single->a[a->i[row]+k];
+    *v = *nz ? single->rowvalues : 0;
+    single->getrowactive = PETSC_TRUE;
+  }
+  if (idx) *idx = *nz ? a->j + a->i[row] : 0;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatRestoreRow_SeqAIJ_Single"
+static PetscErrorCode MatRestoreRow_SeqAIJ_Single(Mat A,PetscInt row,PetscInt *nz,PetscInt **idx,PetscScalar **v)
+{
+  Mat_SeqAIJ *a = (Mat_SeqAIJ*)A->data;
+
+  PetscFunctionBegin;
+  if (v) a->single->getrowactive = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetValues_SeqAIJ_Single"
+static PetscErrorCode MatGetValues_SeqAIJ_Single(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],PetscScalar v[])
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *ap;
+  PetscInt              *rp,k,l,i,t,low,high,row,col,nrow;
+
+  PetscFunctionBegin;
+  for (k=0; k<m; k++) {
+    row = im[k];
+    if (row < 0) {v += n; continue;}
+    if (row >= A->rmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row too large: row %D max %D",row,A->rmap->n-1);
+    rp   = a->j + a->i[row];
+    ap   = a->single->a + a->i[row];
+    nrow = a->ilen[row];
+    for (l=0; l<n; l++) {
+      col = in[l];
+      if (col < 0) {v++; continue;}
+      if (col >= A->cmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Column too large: col %D max %D",col,A->cmap->n-1);
+      high = nrow; low = 0;
+      while (high-low > 5) {
+        t = (low+high)/2;
+        if (rp[t] > col) high = t;
+        else             low  = t;
+      }
+      *v = 0.0;
+      for (i=low; i<high; i++) {
+        if (rp[i] > col) break;
+        if (rp[i] == col) {*v = ap[i]; break;}
+      }
+      v++;
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatNorm_SeqAIJ_Single"
+static PetscErrorCode MatNorm_SeqAIJ_Single(Mat A,NormType type,PetscReal *nrm)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *v = a->single->a;
+  PetscReal             sum = 0.0,*tmp;
+  PetscInt              i,j;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (type == NORM_FROBENIUS) {
+    for (i=0; i<a->nz; i++) sum += (PetscReal)v[i]*v[i];
+    *nrm = PetscSqrtReal(sum);
+  } else if (type == NORM_1) {
+    ierr = PetscMalloc((A->cmap->n+1)*sizeof(PetscReal),&tmp);CHKERRQ(ierr);
+    ierr = PetscMemzero(tmp,A->cmap->n*sizeof(PetscReal));CHKERRQ(ierr);
+    for (i=0; i<a->nz; i++) tmp[a->j[i]] += PetscAbsReal(v[i]);
+    *nrm = 0.0;
+    for (j=0; j<A->cmap->n; j++) {
+      if (tmp[j] > *nrm) *nrm = tmp[j];
+    }
+    ierr = PetscFree(tmp);CHKERRQ(ierr);
+  } else if (type == NORM_INFINITY) {
+    *nrm = 0.0;
+    for (j=0; j<A->rmap->n; j++) {
+      sum = 0.0;
+      for (i=a->i[j]; i<a->i[j+1]; i++) sum += PetscAbsReal(v[i]);
+      if (sum > *nrm) *nrm = sum;
+    }
+  } else SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support for two norm");
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroEntries_SeqAIJ_Single"
+static PetscErrorCode MatZeroEntries_SeqAIJ_Single(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMemzero(a->single->a,a->nz*sizeof(MatScalarSingle));CHKERRQ(ierr);
+  ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatScale_SeqAIJ_Single"
+static PetscErrorCode MatScale_SeqAIJ_Single(Mat A,PetscScalar alpha)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       i;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  for (i=0; i<a->nz; i++) a->single->a[i] = (MatScalarSingle)(alpha*a->single->a[i]);
+  ierr = PetscLogFlops(a->nz);CHKERRQ(ierr);
+  ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatInvertDiagonal_SeqAIJ_Single"
+static PetscErrorCode MatInvertDiagonal_SeqAIJ_Single(Mat A,PetscScalar omega,PetscScalar fshift)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *v = a->single->a;
+  PetscInt              i,*diag,m = A->rmap->n;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (a->idiagvalid) PetscFunctionReturn(0);
+  ierr = MatMarkDiagonal_SeqAIJ(A);CHKERRQ(ierr);
+  diag = a->diag;
+  if (!a->idiag) {
+    ierr = PetscMalloc3(m,PetscScalar,&a->idiag,m,PetscScalar,&a->mdiag,m,PetscScalar,&a->ssor_work);CHKERRQ(ierr);
+    ierr = PetscLogObjectMemory(A,3*m*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+  for (i=0; i<m; i++) {
+    a->mdiag[i] = v[diag[i]];
+    if (omega == 1.0 && !PetscAbsScalar(fshift)) {
+      if (!PetscAbsScalar(a->mdiag[i])) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_INCOMP,"Zero diagonal on row %D",i);
+      a->idiag[i] = 1.0/a->mdiag[i];
+    } else {
+      a->idiag[i] = omega/(fshift + a->mdiag[i]);
+    }
+  }
+  ierr = PetscLogFlops(2.0*m);CHKERRQ(ierr);
+  a->idiagvalid = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSOR_SeqAIJ_Single"
+/* the sweeps of MatSOR_SeqAIJ() */
+static PetscErrorCode MatSOR_SeqAIJ_Single(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscReal fshift,PetscInt its,PetscInt lits,Vec xx)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  const MatScalarSingle *v;
+  const PetscScalar     *b,*xb,*idiag,*mdiag;
+  PetscScalar           *x,*t,sum;
+  const PetscInt        *idx,*diag;
+  PetscInt              m = A->rmap->n,i,n;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (flag == SOR_APPLY_UPPER || flag == SOR_APPLY_LOWER || (flag & SOR_EISENSTAT)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Not for values stored in single precision");
+  its = its*lits;
+
+  if (fshift != a->fshift || omega != a->omega) a->idiagvalid = PETSC_FALSE;
+  ierr = MatInvertDiagonal_SeqAIJ_Single(A,omega,fshift);CHKERRQ(ierr);
+  a->fshift = fshift;
+  a->omega  = omega;
+
+  diag  = a->diag;
+  t     = a->ssor_work;
+  idiag = a->idiag;
+  mdiag = a->mdiag;
+
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  if (flag & SOR_ZERO_INITIAL_GUESS) {
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      for (i=0; i<m; i++) {
+        n    = diag[i] - a->i[i];
+        idx  = a->j + a->i[i];
+        v    = a->single->a + a->i[i];
+        sum  = b[i];
+        PetscSparseDenseMinusDot(sum,x,v,idx,n);
+        t[i] = sum;
+        x[i] = sum*idiag[i];
+      }
+      xb = t;
+      ierr = PetscLogFlops(a->nz);CHKERRQ(ierr);
+    } else xb = b;
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      for (i=m-1; i>=0; i--) {
+        n    = a->i[i+1] - diag[i] - 1;
+        idx  = a->j + diag[i] + 1;
+        v    = a->single->a + diag[i] + 1;
+        sum  = xb[i];
+        PetscSparseDenseMinusDot(sum,x,v,idx,n);
+        if (xb == b) {
+          x[i] = sum*idiag[i];
+        } else {
+          x[i] = (1-omega)*x[i] + sum*idiag[i];
+        }
+      }
+      ierr = PetscLogFlops(a->nz);CHKERRQ(ierr);
+    }
+    its--;
+  }
+  while (its--) {
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      for (i=0; i<m; i++) {
+        n    = a->i[i+1] - a->i[i];
+        idx  = a->j + a->i[i];
+        v    = a->single->a + a->i[i];
+        sum  = b[i];
+        PetscSparseDenseMinusDot(sum,x,v,idx,n);
+        x[i] = (1. - omega)*x[i] + (sum + mdiag[i]*x[i])*idiag[i];
+      }
+      ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+    }
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      for (i=m-1; i>=0; i--) {
+        n    = a->i[i+1] - a->i[i];
+        idx  = a->j + a->i[i];
+        v    = a->single->a + a->i[i];
+        sum  = b[i];
+        PetscSparseDenseMinusDot(sum,x,v,idx,n);
+        x[i] = (1. - omega)*x[i] + (sum + mdiag[i]*x[i])*idiag[i];
+      }
+      ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolve_SeqAIJ_Single"
+/* MatSolve_SeqAIJ() for a factor stored in single precision */
+static PetscErrorCode MatSolve_SeqAIJ_Single(Mat A,Vec bb,Vec xx)
+{
+  Mat_SeqAIJ            *a = (Mat_SeqAIJ*)A->data;
+  PetscInt              i,n = A->rmap->n,*ai = a->i,*aj = a->j,*adiag = a->diag,nz;
+  const PetscInt        *vi,*r,*c;
+  PetscScalar           *x,*tmp,sum;
+  const PetscScalar     *b;
+  const MatScalarSingle *aa = a->single->a,*v;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (!n) PetscFunctionReturn(0);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  tmp  = a->solve_work;
+  ierr = ISGetIndices(a->row,&r);CHKERRQ(ierr);
+  ierr = ISGetIndices(a->col,&c);CHKERRQ(ierr);
+
+  /* forward solve the lower triangular */
+  tmp[0] = b[r[0]];
+  v      = aa;
+  vi     = aj;
+  for (i=1; i<n; i++) {
+    nz  = ai[i+1] - ai[i];
+    sum = b[r[i]];
+    PetscSparseDenseMinusDot(sum,tmp,v,vi,nz);
+    tmp[i] = sum;
+    v += nz; vi += nz;
+  }
+
+  /* backward solve the upper triangular */
+  for (i=n-1; i>=0; i--) {
+    v   = aa + adiag[i+1]+1;
+    vi  = aj + adiag[i+1]+1;
+    nz  = adiag[i]-adiag[i+1]-1;
+    sum = tmp[i];
+    PetscSparseDenseMinusDot(sum,tmp,v,vi,nz);
+    x[c[i]] = tmp[i] = sum*v[nz];
+  }
+
+  ierr = ISRestoreIndices(a->row,&r);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(a->col,&c);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2*a->nz - A->cmap->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+/*
+   Operations that change the values return to full precision first; those that need the values in the
+   layout of a->a work on a temporary full precision copy
+*/
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValues_SeqAIJ_Single"
+static PetscErrorCode MatSetValues_SeqAIJ_Single(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->setvalues)(A,m,im,n,in,v,is);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRows_SeqAIJ_Single"
+static PetscErrorCode MatZeroRows_SeqAIJ_Single(Mat A,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->zerorows)(A,N,rows,diag,x,b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRowsColumns_SeqAIJ_Single"
+static PetscErrorCode MatZeroRowsColumns_SeqAIJ_Single(Mat A,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->zerorowscolumns)(A,N,rows,diag,x,b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_SeqAIJ_Single"
+/* nothing changed since the values were stored in single precision, MatSetValues() would have undone it */
+static PetscErrorCode MatAssemblyEnd_SeqAIJ_Single(Mat A,MatAssemblyType mode)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatView_SeqAIJ_Single"
+static PetscErrorCode MatView_SeqAIJ_Single(Mat A,PetscViewer viewer)
+{
+  PetscErrorCode    ierr;
+  PetscBool         iascii;
+  PetscViewerFormat format;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->view)(A,viewer);CHKERRQ(ierr);
+  ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerGetFormat(viewer,&format);CHKERRQ(ierr);
+    if (format == PETSC_VIEWER_ASCII_INFO || format == PETSC_VIEWER_ASCII_INFO_DETAIL) {
+      ierr = PetscViewerASCIIPrintf(viewer,"values stored in single precision\n");CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDuplicate_SeqAIJ_Single"
+static PetscErrorCode MatDuplicate_SeqAIJ_Single(Mat A,MatDuplicateOption op,Mat *B)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->duplicate)(A,op,B);CHKERRQ(ierr);
+  ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);
+  ((Mat_SeqAIJ*)(*B)->data)->storesingle = a->storesingle;
+  ierr = MatSeqAIJPackSingle_Private(*B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetSubMatrices_SeqAIJ_Single"
+static PetscErrorCode MatGetSubMatrices_SeqAIJ_Single(Mat A,PetscInt n,const IS irow[],const IS icol[],MatReuse scall,Mat *B[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getsubmatrices)(A,n,irow,icol,scall,B);CHKERRQ(ierr);
+  ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJRepackSingle_Private"
+/* stores the values in single precision again after a temporary unpack, also when the operation replaced the data of A */
+static PetscErrorCode MatSeqAIJRepackSingle_Private(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ((Mat_SeqAIJ*)A->data)->storesingle = PETSC_TRUE;
+  if (A->assembled) {ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValuesRow_SeqAIJ_Single"
+static PetscErrorCode MatSetValuesRow_SeqAIJ_Single(Mat A,PetscInt row,const PetscScalar v[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->setvaluesrow)(A,row,v);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDiagonalScale_SeqAIJ_Single"
+static PetscErrorCode MatDiagonalScale_SeqAIJ_Single(Mat A,Vec l,Vec r)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->diagonalscale)(A,l,r);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDiagonalSet_SeqAIJ_Single"
+static PetscErrorCode MatDiagonalSet_SeqAIJ_Single(Mat A,Vec d,InsertMode is)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->diagonalset)(A,d,is);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetRandom_SeqAIJ_Single"
+static PetscErrorCode MatSetRandom_SeqAIJ_Single(Mat A,PetscRandom rctx)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->setrandom)(A,rctx);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAXPY_SeqAIJ_Single"
+/* MatAXPY_SeqAIJ() itself unpacks X when only X is stored in single precision */
+static PetscErrorCode MatAXPY_SeqAIJ_Single(Mat Y,PetscScalar a,Mat X,MatStructure str)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(Y);CHKERRQ(ierr);
+  ierr = (*Y->ops->axpy)(Y,a,X,str);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(Y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCopy_SeqAIJ_Single"
+static PetscErrorCode MatCopy_SeqAIJ_Single(Mat A,Mat B,MatStructure str)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->copy)(A,B,str);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatEqual_SeqAIJ_Single"
+static PetscErrorCode MatEqual_SeqAIJ_Single(Mat A,Mat B,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->equal)(A,B,flg);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatTranspose_SeqAIJ_Single"
+static PetscErrorCode MatTranspose_SeqAIJ_Single(Mat A,MatReuse reuse,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->transpose)(A,reuse,B);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatPermute_SeqAIJ_Single"
+static PetscErrorCode MatPermute_SeqAIJ_Single(Mat A,IS rowp,IS colp,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->permute)(A,rowp,colp,B);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRowMax_SeqAIJ_Single"
+static PetscErrorCode MatGetRowMax_SeqAIJ_Single(Mat A,Vec v,PetscInt idx[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getrowmax)(A,v,idx);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRowMaxAbs_SeqAIJ_Single"
+static PetscErrorCode MatGetRowMaxAbs_SeqAIJ_Single(Mat A,Vec v,PetscInt idx[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getrowmaxabs)(A,v,idx);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRowMin_SeqAIJ_Single"
+static PetscErrorCode MatGetRowMin_SeqAIJ_Single(Mat A,Vec v,PetscInt idx[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getrowmin)(A,v,idx);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRowMinAbs_SeqAIJ_Single"
+static PetscErrorCode MatGetRowMinAbs_SeqAIJ_Single(Mat A,Vec v,PetscInt idx[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getrowminabs)(A,v,idx);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetColumnNorms_SeqAIJ_Single"
+static PetscErrorCode MatGetColumnNorms_SeqAIJ_Single(Mat A,NormType type,PetscReal *norms)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getcolumnnorms)(A,type,norms);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatFindZeroDiagonals_SeqAIJ_Single"
+static PetscErrorCode MatFindZeroDiagonals_SeqAIJ_Single(Mat A,IS *zerorows)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->findzerodiagonals)(A,zerorows);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatFindNonzeroRows_SeqAIJ_Single"
+static PetscErrorCode MatFindNonzeroRows_SeqAIJ_Single(Mat A,IS *keptrows)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->findnonzerorows)(A,keptrows);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatIsSymmetric_SeqAIJ_Single"
+static PetscErrorCode MatIsSymmetric_SeqAIJ_Single(Mat A,PetscReal tol,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->issymmetric)(A,tol,flg);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatIsHermitian_SeqAIJ_Single"
+static PetscErrorCode MatIsHermitian_SeqAIJ_Single(Mat A,PetscReal tol,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->ishermitian)(A,tol,flg);CHKERRQ(ierr);
+  ierr = MatSeqAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqAIJ_Single"
+/* composed in place of the conversions of SeqAIJ, which read a->a */
+PetscErrorCode MatConvert_SeqAIJ_Single(Mat A,MatType newtype,MatReuse reuse,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = MatConvert(A,newtype,reuse,B);CHKERRQ(ierr);
+  /* an in place conversion replaced the data of A */
+  if (reuse != MAT_REUSE_MATRIX) {ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatLUFactorSymbolic_SeqAIJ_Single"
+/* symbolic factorization into a factor that still holds the values of a previous numeric factorization */
+static PetscErrorCode MatLUFactorSymbolic_SeqAIJ_Single(Mat fact,Mat A,IS row,IS col,const MatFactorInfo *info)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(fact);CHKERRQ(ierr);
+  ierr = (*fact->ops->lufactorsymbolic)(fact,A,row,col,info);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatILUFactorSymbolic_SeqAIJ_Single"
+static PetscErrorCode MatILUFactorSymbolic_SeqAIJ_Single(Mat fact,Mat A,IS row,IS col,const MatFactorInfo *info)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJUnpackSingle_Private(fact);CHKERRQ(ierr);
+  ierr = (*fact->ops->ilufactorsymbolic)(fact,A,row,col,info);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetOps_SeqAIJ_Single"
+static PetscErrorCode MatSetOps_SeqAIJ_Single(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  struct _MatOps *full = &a->single->ops;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  A->ops->mult             = MatMult_SeqAIJ_Single;
+  A->ops->multadd          = MatMultAdd_SeqAIJ_Single;
+  A->ops->multtranspose    = MatMultTranspose_SeqAIJ_Single;
+  A->ops->multtransposeadd = MatMultTransposeAdd_SeqAIJ_Single;
+  A->ops->sor              = MatSOR_SeqAIJ_Single;
+  A->ops->getdiagonal      = MatGetDiagonal_SeqAIJ_Single;
+  A->ops->getrow           = MatGetRow_SeqAIJ_Single;
+  A->ops->restorerow       = MatRestoreRow_SeqAIJ_Single;
+  A->ops->norm             = MatNorm_SeqAIJ_Single;
+  A->ops->zeroentries      = MatZeroEntries_SeqAIJ_Single;
+  A->ops->scale            = MatScale_SeqAIJ_Single;
+  A->ops->setvalues        = MatSetValues_SeqAIJ_Single;
+  A->ops->zerorows         = MatZeroRows_SeqAIJ_Single;
+  A->ops->zerorowscolumns  = MatZeroRowsColumns_SeqAIJ_Single;
+  A->ops->assemblyend      = MatAssemblyEnd_SeqAIJ_Single;
+  A->ops->view             = MatView_SeqAIJ_Single;
+  A->ops->duplicate        = MatDuplicate_SeqAIJ_Single;
+  A->ops->getsubmatrices   = MatGetSubMatrices_SeqAIJ_Single;
+  A->ops->getvalues        = MatGetValues_SeqAIJ_Single;
+  A->ops->setvaluesrow     = full->setvaluesrow ? MatSetValuesRow_SeqAIJ_Single : 0;
+
+  /* these work on a temporary full precision copy of the values */
+  A->ops->diagonalscale     = full->diagonalscale ? MatDiagonalScale_SeqAIJ_Single : 0;
+  A->ops->diagonalset       = full->diagonalset ? MatDiagonalSet_SeqAIJ_Single : 0;
+  A->ops->setrandom         = full->setrandom ? MatSetRandom_SeqAIJ_Single : 0;
+  A->ops->axpy              = full->axpy ? MatAXPY_SeqAIJ_Single : 0;
+  A->ops->copy              = full->copy ? MatCopy_SeqAIJ_Single : 0;
+  A->ops->equal             = full->equal ? MatEqual_SeqAIJ_Single : 0;
+  A->ops->transpose         = full->transpose ? MatTranspose_SeqAIJ_Single : 0;
+  A->ops->permute           = full->permute ? MatPermute_SeqAIJ_Single : 0;
+  A->ops->getrowmax         = full->getrowmax ? MatGetRowMax_SeqAIJ_Single : 0;
+  A->ops->getrowmaxabs      = full->getrowmaxabs ? MatGetRowMaxAbs_SeqAIJ_Single : 0;
+  A->ops->getrowmin         = full->getrowmin ? MatGetRowMin_SeqAIJ_Single : 0;
+  A->ops->getrowminabs      = full->getrowminabs ? MatGetRowMinAbs_SeqAIJ_Single : 0;
+  A->ops->getcolumnnorms    = full->getcolumnnorms ? MatGetColumnNorms_SeqAIJ_Single : 0;
+  A->ops->findzerodiagonals = full->findzerodiagonals ? MatFindZeroDiagonals_SeqAIJ_Single : 0;
+  A->ops->findnonzerorows   = full->findnonzerorows ? MatFindNonzeroRows_SeqAIJ_Single : 0;
+  A->ops->issymmetric       = full->issymmetric ? MatIsSymmetric_SeqAIJ_Single : 0;
+  A->ops->ishermitian       = full->ishermitian ? MatIsHermitian_SeqAIJ_Single : 0;
+  ierr = MatSeqXAIJSetConvertersSingle_Private(A,MatConvert_SeqAIJ_Single);CHKERRQ(ierr);
+
+  /* these only use the nonzero structure, or get the values through MatGetValues() */
+  A->ops->destroy                 = full->destroy;
+  A->ops->setoption               = full->setoption;
+  A->ops->getinfo                 = full->getinfo;
+  A->ops->setup                   = full->setup;
+  A->ops->getvecs                 = full->getvecs;
+  A->ops->getrowij                = full->getrowij;
+  A->ops->restorerowij            = full->restorerowij;
+  A->ops->getcolumnij             = full->getcolumnij;
+  A->ops->restorecolumnij         = full->restorecolumnij;
+  A->ops->increaseoverlap         = full->increaseoverlap;
+  A->ops->missingdiagonal         = full->missingdiagonal;
+  A->ops->isstructurallysymmetric = full->isstructurallysymmetric;
+  A->ops->setblocksizes           = full->setblocksizes;
+  A->ops->fdcoloringcreate        = full->fdcoloringcreate;
+  A->ops->invertblockdiagonal     = full->invertblockdiagonal;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetOps_SeqAIJFactor_Single"
+static PetscErrorCode MatSetOps_SeqAIJFactor_Single(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  struct _MatOps *full = &a->single->ops;
+
+  PetscFunctionBegin;
+  A->ops->solve             = MatSolve_SeqAIJ_Single;
+  A->ops->view              = MatView_SeqAIJ_Single;
+  A->ops->lufactorsymbolic  = full->lufactorsymbolic ? MatLUFactorSymbolic_SeqAIJ_Single : 0;
+  A->ops->ilufactorsymbolic = full->ilufactorsymbolic ? MatILUFactorSymbolic_SeqAIJ_Single : 0;
+  /* the numeric factorization returns the factor to full precision itself */
+  A->ops->lufactornumeric   = full->lufactornumeric;
+  A->ops->destroy           = full->destroy;
+  A->ops->getinfo           = full->getinfo;
+  A->ops->setoption         = full->setoption;
+  A->ops->getvecs           = full->getvecs;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJPackSingle_Private"
+/*
+   MatSeqAIJPackSingle_Private - Stores the values of an assembled SeqAIJ matrix, or of an LU factor in the
+   format of MatLUFactorNumeric_SeqAIJ(), in single precision
+*/
+PetscErrorCode MatSeqAIJPackSingle_Private(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscInt       m = A->rmap->n;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (A->factortype) {
+    if (!m) PetscFunctionReturn(0);
+    ierr = MatSeqXAIJPackSingle_Private(A,m,a->diag[0]+1,1,MatSetOps_SeqAIJFactor_Single);CHKERRQ(ierr);
+  } else {
+    ierr = MatSeqXAIJPackSingle_Private(A,m,a->i[m],1,MatSetOps_SeqAIJ_Single);CHKERRQ(ierr);
+    ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJUnpackSingle_Private"
+PetscErrorCode MatSeqAIJUnpackSingle_Private(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!a->single) PetscFunctionReturn(0);
+  if (A->factortype) {
+    ierr = MatSeqXAIJUnpackSingle_Private(A,a->diag[0]+1,1);CHKERRQ(ierr);
+  } else {
+    ierr = MatSeqXAIJUnpackSingle_Private(A,a->i[A->rmap->n],1);CHKERRQ(ierr);
+    ierr = MatSeqAIJInvalidateDiagonal(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJFactorBeginSingle_Private"
+/*
+   MatSeqAIJFactorBeginSingle_Private - Called at the start of the numeric factorizations of a SeqAIJ matrix, which
+   read a->a of the matrix and write that of the factor; returns whether the matrix values were in single precision
+*/
+PetscErrorCode MatSeqAIJFactorBeginSingle_Private(Mat A,Mat fact,PetscBool *single)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  *single = a->single ? PETSC_TRUE : PETSC_FALSE;
+  ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  if (fact) {ierr = MatSeqAIJUnpackSingle_Private(fact);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJFactorEndSingle_Private"
+/*
+   MatSeqAIJFactorEndSingle_Private - Returns the matrix to single precision, and with packfactor also stores
+   its factor in single precision
+*/
+PetscErrorCode MatSeqAIJFactorEndSingle_Private(Mat A,Mat fact,PetscBool single,PetscBool packfactor)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!single) PetscFunctionReturn(0);
+  ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);
+  if (fact && packfactor) {ierr = MatSeqAIJPackSingle_Private(fact);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision_SeqAIJ"
+PetscErrorCode MatStoreSinglePrecision_SeqAIJ(Mat A,PetscBool flg)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscBool      isseqaij;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  /* the derived types keep their own data computed from the values */
+  ierr = PetscObjectTypeCompare((PetscObject)A,MATSEQAIJ,&isseqaij);CHKERRQ(ierr);
+  if (flg && !isseqaij) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_SUP,"Not for matrix type %s",((PetscObject)A)->type_name);
+  a->storesingle = flg;
+  if (!flg) {
+    ierr = MatSeqAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  } else if (A->assembled) {
+    ierr = MatSeqAIJPackSingle_Private(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+#endif
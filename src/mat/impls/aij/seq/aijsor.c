@@ -0,0 +1,284 @@
+
+/*
+   Threaded Gauss-Seidel/SOR sweeps for SeqAIJ matrices, selected with -mat_sor_threaded <multicolor,hybrid>
+
+   multicolor - the rows are colored so that no two rows of the same color are coupled; a forward sweep
+                relaxes the colors one after another, the rows of each color in parallel. This is
+                Gauss-Seidel in the multicolor ordering, its result does not depend on the number of threads.
+   hybrid     - each thread relaxes its own block of consecutive rows with Gauss-Seidel, using the values
+                of the other blocks from the start of the sweep (Jacobi coupling between the blocks).
+                With one thread this is the sequential sweep.
+*/
+#include <../src/mat/impls/aij/seq/aij.h>
+#include <petscthreadcomm.h>
+
+/* multicolor: a color is split into at most 4 tasks per thread of at least this many rows */
+#define MATSORTHREADED_MINROWS 64
+
+static const char *const MatSORThreadedTypes[] = {"none","multicolor","hybrid"};
+
+typedef struct {
+  Mat_SeqAIJ             *a;
+  Mat_SeqAIJ_SORThreaded *sor;
+  const PetscScalar      *b,*xold;
+  PetscScalar            *x,*xnext;
+  PetscScalar            omega;
+  PetscInt               color,ntasks;
+  PetscBool              backward;
+} MatSORThreadedCtx;
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSORThreadedColor_Private"
+/*
+   Greedy coloring of the graph of A + A^T in the natural ordering, row i gets the smallest color
+   none of its neighbors has. The colorings of MatGetColoring() are distance-2 colorings for finite
+   difference Jacobians, which need many more colors than Gauss-Seidel does.
+*/
+static PetscErrorCode MatSORThreadedColor_Private(Mat A,Mat_SeqAIJ_SORThreaded *sor)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+  PetscInt       m = A->rmap->n,*ai = a->i,*aj = a->j,*ti,*tj,*color,*mark,i,j,c,ncolors = 0;
+
+  PetscFunctionBegin;
+  ierr = MatGetSymbolicTranspose_SeqAIJ(A,&ti,&tj);CHKERRQ(ierr);
+  ierr = PetscMalloc2(m,PetscInt,&color,m+1,PetscInt,&mark);CHKERRQ(ierr);
+  for (i=0; i<m+1; i++) mark[i] = -1;
+  for (i=0; i<m; i++) {
+    for (j=ai[i]; j<ai[i+1]; j++) if (aj[j] < i) mark[color[aj[j]]] = i;
+    for (j=ti[i]; j<ti[i+1]; j++) if (tj[j] < i) mark[color[tj[j]]] = i;
+    for (c=0; mark[c] == i; c++) ;
+    color[i] = c;
+    ncolors  = PetscMax(ncolors,c+1);
+  }
+  ierr = MatRestoreSymbolicTranspose_SeqAIJ(A,&ti,&tj);CHKERRQ(ierr);
+
+  sor->ncolors = ncolors;
+  ierr = PetscMalloc2(ncolors+1,PetscInt,&sor->colorstart,m,PetscInt,&sor->rows);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(A,(ncolors+1+m)*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscMemzero(sor->colorstart,(ncolors+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<m; i++) sor->colorstart[color[i]+1]++;
+  for (c=0; c<ncolors; c++) sor->colorstart[c+1] += sor->colorstart[c];
+  for (i=0; i<m; i++) sor->rows[sor->colorstart[color[i]]++] = i;
+  for (c=ncolors; c>0; c--) sor->colorstart[c] = sor->colorstart[c-1];
+  sor->colorstart[0] = 0;
+  ierr = PetscFree2(color,mark);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSORThreadedBlocks_Private"
+/* the blocks of the hybrid sweeps are the rows of the threads, for each row find its columns inside the block */
+static PetscErrorCode MatSORThreadedBlocks_Private(Mat A,Mat_SeqAIJ_SORThreaded *sor)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  PetscErrorCode ierr;
+  PetscInt       m = A->rmap->n,*ai = a->i,*aj = a->j,i,j,k,start,end;
+
+  PetscFunctionBegin;
+  ierr = PetscThreadCommGetNThreads(((PetscObject)A)->comm,&sor->nblocks);CHKERRQ(ierr);
+  ierr = MatSeqXAIJComputeThreadPartition(A,m,ai,&sor->bstarts);CHKERRQ(ierr);
+  ierr = PetscMalloc4(m,PetscInt,&sor->blo,m,PetscInt,&sor->bhi,m,PetscScalar,&sor->xold[0],m,PetscScalar,&sor->xold[1]);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(A,2*m*(sizeof(PetscInt)+sizeof(PetscScalar)));CHKERRQ(ierr);
+  for (k=0; k<sor->nblocks; k++) {
+    start = sor->bstarts[k];
+    end   = sor->bstarts[k+1];
+    for (i=start; i<end; i++) {
+      for (j=ai[i]; j<ai[i+1] && aj[j] < start; j++) ;
+      sor->blo[i] = j;
+      for (; j<ai[i+1] && aj[j] < end; j++) ;
+      sor->bhi[i] = j;
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJUseSORThreaded"
+/*
+   MatSeqAIJUseSORThreaded - Called by MatSOR_SeqAIJ() and MatSOR_SeqAIJ_Inode(); on the first call it reads
+   -mat_sor_threaded and sets up the coloring or the blocks. Returns whether the sweeps given by flag are done
+   by MatSOR_SeqAIJ_Threaded(), the Eisenstat trick and the application of the triangular parts are not.
+*/
+PetscErrorCode MatSeqAIJUseSORThreaded(Mat A,MatSORType flag,PetscBool *use)
+{
+  Mat_SeqAIJ             *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJ_SORThreaded *sor;
+  PetscErrorCode         ierr;
+  PetscInt               type = MAT_SOR_THREADED_NONE;
+
+  PetscFunctionBegin;
+  if (!a->sorthreaded) {
+    ierr = PetscNewLog(A,Mat_SeqAIJ_SORThreaded,&sor);CHKERRQ(ierr);
+    ierr = PetscOptionsGetEList(((PetscObject)A)->prefix,"-mat_sor_threaded",MatSORThreadedTypes,3,&type,PETSC_NULL);CHKERRQ(ierr);
+    sor->type = (MatSORThreadedType)type;
+    if (sor->type == MAT_SOR_THREADED_MULTICOLOR) {
+      ierr = MatSORThreadedColor_Private(A,sor);CHKERRQ(ierr);
+      ierr = PetscInfo2(A,"Threaded SOR with %D colors of %D rows\n",sor->ncolors,A->rmap->n);CHKERRQ(ierr);
+    } else if (sor->type == MAT_SOR_THREADED_HYBRID) {
+      ierr = MatSORThreadedBlocks_Private(A,sor);CHKERRQ(ierr);
+      ierr = PetscInfo2(A,"Threaded SOR with %D blocks of %D rows\n",sor->nblocks,A->rmap->n);CHKERRQ(ierr);
+    }
+    a->sorthreaded = sor;
+  }
+  *use = (PetscBool)(a->sorthreaded->type != MAT_SOR_THREADED_NONE && !(flag & (SOR_EISENSTAT | SOR_APPLY_UPPER | SOR_APPLY_LOWER)));
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJSORThreadedDestroy_Private"
+PetscErrorCode MatSeqAIJSORThreadedDestroy_Private(Mat_SeqAIJ_SORThreaded **sor)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!*sor) PetscFunctionReturn(0);
+  if ((*sor)->rows) {ierr = PetscFree2((*sor)->colorstart,(*sor)->rows);CHKERRQ(ierr);}
+  if ((*sor)->blo) {ierr = PetscFree4((*sor)->blo,(*sor)->bhi,(*sor)->xold[0],(*sor)->xold[1]);CHKERRQ(ierr);}
+  ierr = PetscFree((*sor)->bstarts);CHKERRQ(ierr);
+  ierr = PetscFree(*sor);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSORThreadedColor_Task"
+/* task t of the current color, its rows are not coupled to each other so the order does not matter */
+static PetscErrorCode MatSORThreadedColor_Task(PetscInt thread_id,PetscInt t,PetscInt tend,void *ctx)
+{
+  MatSORThreadedCtx *sc = (MatSORThreadedCtx*)ctx;
+  Mat_SeqAIJ        *a = sc->a;
+  const PetscInt    *cs = sc->sor->colorstart + sc->color,*rows = sc->sor->rows,*ai = a->i,*idx;
+  const MatScalar   *v;
+  const PetscScalar *b = sc->b,*idiag = a->idiag,*mdiag = a->mdiag;
+  PetscScalar       *x = sc->x,sum,omega = sc->omega;
+  PetscInt          k,i,n,kstart = cs[0] + ((cs[1]-cs[0])*t)/sc->ntasks,kend = cs[0] + ((cs[1]-cs[0])*tend)/sc->ntasks;
+
+  for (k=kstart; k<kend; k++) {
+    i    = rows[k];
+    n    = ai[i+1] - ai[i];
+    idx  = a->j + ai[i];
+    v    = a->a + ai[i];
+    sum  = b[i];
+    PetscSparseDenseMinusDot(sum,x,v,idx,n);
+    x[i] = (1. - omega)*x[i] + (sum + mdiag[i]*x[i])*idiag[i];
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSORThreadedHybrid_Task"
+/* Gauss-Seidel on the rows start to end-1, the columns outside of them are taken from xold; the result is also put in xnext */
+static PetscErrorCode MatSORThreadedHybrid_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  MatSORThreadedCtx *sc = (MatSORThreadedCtx*)ctx;
+  Mat_SeqAIJ        *a = sc->a;
+  const PetscInt    *ai = a->i,*blo = sc->sor->blo,*bhi = sc->sor->bhi,*idx;
+  const MatScalar   *v;
+  const PetscScalar *b = sc->b,*xold = sc->xold,*idiag = a->idiag,*mdiag = a->mdiag;
+  PetscScalar       *x = sc->x,sum,omega = sc->omega;
+  PetscInt          i,k,n;
+  PetscErrorCode    ierr;
+
+  for (k=start; k<end; k++) {
+    i    = sc->backward ? start + end - 1 - k : k;
+    sum  = b[i];
+    /* columns before the block, in the block and after the block */
+    n    = blo[i] - ai[i];
+    idx  = a->j + ai[i];
+    v    = a->a + ai[i];
+    PetscSparseDenseMinusDot(sum,xold,v,idx,n);
+    n    = bhi[i] - blo[i];
+    idx  = a->j + blo[i];
+    v    = a->a + blo[i];
+    PetscSparseDenseMinusDot(sum,x,v,idx,n);
+    n    = ai[i+1] - bhi[i];
+    idx  = a->j + bhi[i];
+    v    = a->a + bhi[i];
+    PetscSparseDenseMinusDot(sum,xold,v,idx,n);
+    x[i] = (1. - omega)*x[i] + (sum + mdiag[i]*x[i])*idiag[i];
+  }
+  ierr = PetscMemcpy(sc->xnext+start,x+start,(end-start)*sizeof(PetscScalar));CHKERRQ(ierr);
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSORThreadedSweep_Private"
+static PetscErrorCode MatSORThreadedSweep_Private(Mat A,MatSORThreadedCtx *sc,PetscBool backward)
+{
+  Mat_SeqAIJ_SORThreaded *sor = sc->sor;
+  MPI_Comm               comm = ((PetscObject)A)->comm;
+  PetscErrorCode         ierr;
+  PetscInt               nthreads,c,k,len;
+  const PetscScalar      *xold;
+
+  PetscFunctionBegin;
+  sc->backward = backward;
+  if (sor->type == MAT_SOR_THREADED_MULTICOLOR) {
+    ierr = PetscThreadCommGetNThreads(comm,&nthreads);CHKERRQ(ierr);
+    for (k=0; k<sor->ncolors; k++) {
+      c          = backward ? sor->ncolors - 1 - k : k;
+      len        = sor->colorstart[c+1] - sor->colorstart[c];
+      sc->color  = c;
+      sc->ntasks = PetscMax(1,PetscMin(4*nthreads,len/MATSORTHREADED_MINROWS));
+      ierr = PetscThreadCommRunTasks(comm,sc->ntasks,PETSC_NULL,MatSORThreadedColor_Task,sc);CHKERRQ(ierr);
+    }
+  } else {
+    ierr = PetscThreadCommRunTasks(comm,sor->nblocks,sor->bstarts,MatSORThreadedHybrid_Task,sc);CHKERRQ(ierr);
+    /* the two copies of x alternate, the next sweep reads the one filled by this sweep */
+    xold      = sc->xold;
+    sc->xold  = sc->xnext;
+    sc->xnext = (PetscScalar*)xold;
+  }
+  ierr = PetscLogFlops(2.0*sc->a->nz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSOR_SeqAIJ_Threaded"
+/*
+   The forward, backward and symmetric sweeps of MatSOR_SeqAIJ() with the threads; the local sweeps are
+   the same as the global ones. With a zero initial guess x is zeroed and the sweeps are done as usual.
+*/
+PetscErrorCode MatSOR_SeqAIJ_Threaded(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscReal fshift,PetscInt its,PetscInt lits,Vec xx)
+{
+  Mat_SeqAIJ             *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJ_SORThreaded *sor = a->sorthreaded;
+  MatSORThreadedCtx      sc;
+  PetscErrorCode         ierr;
+  PetscInt               m = A->rmap->n;
+  PetscScalar            *x;
+  const PetscScalar      *b;
+
+  PetscFunctionBegin;
+  its = its*lits;
+
+  if (fshift != a->fshift || omega != a->omega) a->idiagvalid = PETSC_FALSE; /* must recompute idiag[] */
+  if (!a->idiagvalid) {ierr = MatInvertDiagonal_SeqAIJ(A,omega,fshift);CHKERRQ(ierr);}
+  a->fshift = fshift;
+  a->omega  = omega;
+
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  if (flag & SOR_ZERO_INITIAL_GUESS) {ierr = PetscMemzero(x,m*sizeof(PetscScalar));CHKERRQ(ierr);}
+  sc.a     = a;
+  sc.sor   = sor;
+  sc.b     = b;
+  sc.x     = x;
+  sc.omega = omega;
+  if (sor->type == MAT_SOR_THREADED_HYBRID) {
+    ierr     = PetscMemcpy(sor->xold[0],x,m*sizeof(PetscScalar));CHKERRQ(ierr);
+    sc.xold  = sor->xold[0];
+    sc.xnext = sor->xold[1];
+  }
+  while (its--) {
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      ierr = MatSORThreadedSweep_Private(A,&sc,PETSC_FALSE);CHKERRQ(ierr);
+    }
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      ierr = MatSORThreadedSweep_Private(A,&sc,PETSC_TRUE);CHKERRQ(ierr);
+    }
+  }
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
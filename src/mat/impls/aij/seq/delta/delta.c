@@ -0,0 +1,423 @@
+/*
+  Defines basic operations for the MATSEQAIJDELTA matrix class.
+  This class is derived from the MATSEQAIJ class and retains the
+  compressed row storage (aka Yale sparse matrix format) but augments
+  it with a copy of the column indices stored as 16 bit differences
+  between consecutive columns of a row, which is used for the
+  matrix-vector products.
+
+  The products are limited by the memory bandwidth; they read 8 bytes
+  per nonzero for the value and 4 (8 with 64 bit indices) for its column,
+  the differences cut the latter to 2. The values of the AIJ matrix are
+  used in place, only the index array is duplicated.
+*/
+
+#include <../src/mat/impls/aij/seq/delta/delta.h>
+#include <petscthreadcomm.h>
+
+extern PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat,MatAssemblyType);
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJDeltaFree_Private"
+static PetscErrorCode MatSeqAIJDeltaFree_Private(Mat_SeqAIJDelta *dlt)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree2(dlt->rowbase,dlt->delta);CHKERRQ(ierr);
+  dlt->built = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqAIJDelta_SeqAIJ"
+PetscErrorCode  MatConvert_SeqAIJDelta_SeqAIJ(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  /* This routine is only called to convert a MATSEQAIJDELTA to its base PETSc type, */
+  /* so we will ignore 'MatType type'. */
+  PetscErrorCode  ierr;
+  Mat             B = *newmat;
+  Mat_SeqAIJDelta *dlt;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+  dlt = (Mat_SeqAIJDelta*)B->spptr;
+
+  /* Reset the original function pointers; the inode routines are restored at the next assembly */
+  B->ops->assemblyend      = MatAssemblyEnd_SeqAIJ;
+  B->ops->destroy          = MatDestroy_SeqAIJ;
+  B->ops->duplicate        = MatDuplicate_SeqAIJ;
+  B->ops->mult             = MatMult_SeqAIJ;
+  B->ops->multadd          = MatMultAdd_SeqAIJ;
+  B->ops->multtranspose    = MatMultTranspose_SeqAIJ;
+  B->ops->multtransposeadd = MatMultTransposeAdd_SeqAIJ;
+
+  ierr = MatSeqAIJDeltaFree_Private(dlt);CHKERRQ(ierr);
+  ierr = PetscFree(B->spptr);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaijdelta_seqaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQAIJ);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDestroy_SeqAIJDelta"
+PetscErrorCode MatDestroy_SeqAIJDelta(Mat A)
+{
+  PetscErrorCode  ierr;
+  Mat_SeqAIJDelta *dlt = (Mat_SeqAIJDelta*)A->spptr;
+
+  PetscFunctionBegin;
+  /* Free everything in the Mat_SeqAIJDelta data structure. */
+  if (dlt) {
+    ierr = MatSeqAIJDeltaFree_Private(dlt);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(A->spptr);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_seqaijdelta_seqaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)A,MATSEQAIJ);CHKERRQ(ierr);
+  ierr = MatDestroy_SeqAIJ(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJDelta_create_delta"
+/*
+   Encodes the column indices of the current AIJ data. The matrix must be assembled.
+*/
+PetscErrorCode MatSeqAIJDelta_create_delta(Mat A)
+{
+  Mat_SeqAIJ      *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJDelta *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  PetscInt        m = A->rmap->n,*ai = a->i,*aj = a->j,i,k,nwide = 0,nonzerorowcnt = 0;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJDeltaFree_Private(dlt);CHKERRQ(ierr);
+  ierr = PetscMalloc2(m,PetscInt,&dlt->rowbase,ai[m],MatDeltaIndex,&dlt->delta);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    dlt->rowbase[i] = 0;
+    if (ai[i+1] == ai[i]) continue;
+    nonzerorowcnt++;
+    for (k=ai[i]+1; k<ai[i+1]; k++) {
+      if (aj[k] - aj[k-1] > MAT_DELTA_MAX) break;
+    }
+    if (k < ai[i+1]) {
+      dlt->rowbase[i] = -1;
+      nwide++;
+      continue;
+    }
+    dlt->rowbase[i]   = aj[ai[i]];
+    dlt->delta[ai[i]] = 0;
+    for (k=ai[i]+1; k<ai[i+1]; k++) dlt->delta[k] = (MatDeltaIndex)(aj[k] - aj[k-1]);
+  }
+  dlt->nwide         = nwide;
+  dlt->nonzerorowcnt = nonzerorowcnt;
+  dlt->built         = PETSC_TRUE;
+  ierr = PetscInfo3(A,"Column differences of %D rows, %D of them need the full column indices, %D nonzeros\n",m,nwide,ai[m]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJDeltaUpdate_Private"
+/* the index arrays only depend on the nonzero structure, which can only change in an assembly */
+PETSC_STATIC_INLINE PetscErrorCode MatSeqAIJDeltaUpdate_Private(Mat A)
+{
+  Mat_SeqAIJDelta *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  if (!dlt->built) {
+    ierr = MatSeqAIJDelta_create_delta(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/* z[i] = y[i] + (A x)[i] for the rows start to end-1, y may be PETSC_NULL */
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqAIJDelta_Kernel"
+PetscErrorCode MatMultAdd_SeqAIJDelta_Kernel(PetscInt thread_id,Mat A,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_SeqAIJ          *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJDelta     *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  const PetscInt      *ai = a->i,*rowbase = dlt->rowbase,*aj;
+  const MatDeltaIndex *d;
+  const MatScalar     *aa;
+  PetscInt            i,k,n,col,start = a->trstarts[thread_id],end = a->trstarts[thread_id+1];
+  PetscScalar         sum;
+
+  for (i=start; i<end; i++) {
+    n   = ai[i+1] - ai[i];
+    aa  = a->a + ai[i];
+    sum = y ? y[i] : 0.0;
+    if (rowbase[i] >= 0) {
+      d   = dlt->delta + ai[i];
+      col = rowbase[i];
+      for (k=0; k<n; k++) {
+        col += d[k];
+        sum += aa[k]*x[col];
+      }
+    } else {
+      aj = a->j + ai[i];
+      PetscSparseDensePlusDot(sum,x,aa,aj,n);
+    }
+    z[i] = sum;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqAIJDelta"
+PetscErrorCode MatMult_SeqAIJDelta(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJDelta   *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  const PetscScalar *x;
+  PetscScalar       *y;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJDeltaUpdate_Private(A);CHKERRQ(ierr);
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,A->rmap->n,a->i,&a->trstarts);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqAIJDelta_Kernel,4,A,x,(const PetscScalar*)PETSC_NULL,y);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz - dlt->nonzerorowcnt);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqAIJDelta"
+/*
+   zz = yy + A*xx
+*/
+PetscErrorCode MatMultAdd_SeqAIJDelta(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *y,*z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJDeltaUpdate_Private(A);CHKERRQ(ierr);
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,A->rmap->n,a->i,&a->trstarts);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  } else {
+    y = z;
+  }
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqAIJDelta_Kernel,4,A,x,y,z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTransposeAdd_SeqAIJDelta"
+/*
+   zz = yy + A'*xx
+*/
+PetscErrorCode MatMultTransposeAdd_SeqAIJDelta(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqAIJ          *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqAIJDelta     *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  PetscInt            m = A->rmap->n,i,k,n,col;
+  const PetscInt      *ai,*aj,*rowbase;
+  const MatDeltaIndex *d;
+  const MatScalar     *aa;
+  const PetscScalar   *x;
+  PetscScalar         *z,alpha;
+  PetscErrorCode      ierr;
+
+  PetscFunctionBegin;
+  ierr    = MatSeqAIJDeltaUpdate_Private(A);CHKERRQ(ierr);
+  if (zz != yy) {ierr = VecCopy(yy,zz);CHKERRQ(ierr);}
+  ai      = a->i;
+  rowbase = dlt->rowbase;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    n     = ai[i+1] - ai[i];
+    aa    = a->a + ai[i];
+    alpha = x[i];
+    if (rowbase[i] >= 0) {
+      d   = dlt->delta + ai[i];
+      col = rowbase[i];
+      for (k=0; k<n; k++) {
+        col    += d[k];
+        z[col] += alpha*aa[k];
+      }
+    } else {
+      aj = a->j + ai[i];
+      for (k=0; k<n; k++) z[aj[k]] += alpha*aa[k];
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTranspose_SeqAIJDelta"
+PetscErrorCode MatMultTranspose_SeqAIJDelta(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSet(yy,0.0);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_SeqAIJDelta(A,xx,yy,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJDeltaSetOps_Private"
+static PetscErrorCode MatSeqAIJDeltaSetOps_Private(Mat B)
+{
+  PetscFunctionBegin;
+  B->ops->mult             = MatMult_SeqAIJDelta;
+  B->ops->multadd          = MatMultAdd_SeqAIJDelta;
+  B->ops->multtranspose    = MatMultTranspose_SeqAIJDelta;
+  B->ops->multtransposeadd = MatMultTransposeAdd_SeqAIJDelta;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_SeqAIJDelta"
+PetscErrorCode MatAssemblyEnd_SeqAIJDelta(Mat A, MatAssemblyType mode)
+{
+  PetscErrorCode  ierr;
+  Mat_SeqAIJDelta *dlt = (Mat_SeqAIJDelta*)A->spptr;
+  PetscLogDouble  mallocs = A->info.mallocs;
+
+  PetscFunctionBegin;
+  ierr = MatAssemblyEnd_SeqAIJ(A,mode);CHKERRQ(ierr);
+  /* the inode check may have installed its own multiply routines */
+  ierr = MatSeqAIJDeltaSetOps_Private(A);CHKERRQ(ierr);
+  if (mode == MAT_FLUSH_ASSEMBLY) PetscFunctionReturn(0);
+
+  /* The nonzero structure only changed if the assembly compressed out unused space or MatSetValues() had to
+     allocate; then the index arrays are rebuilt lazily by the first product after the assembly */
+  if (A->info.nz_unneeded || A->info.mallocs != mallocs) dlt->built = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDuplicate_SeqAIJDelta"
+PetscErrorCode MatDuplicate_SeqAIJDelta(Mat A, MatDuplicateOption op, Mat *M)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatDuplicate_SeqAIJ(A,op,M);CHKERRQ(ierr);
+  ierr = MatSeqAIJDeltaSetOps_Private(*M);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/* MatConvert_SeqAIJ_SeqAIJDelta converts a SeqAIJ matrix into a
+ * SeqAIJDelta matrix.  This routine is called by the MatCreate_SeqAIJDelta()
+ * routine, but can also be used to convert an assembled SeqAIJ matrix
+ * into a SeqAIJDelta one. */
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqAIJ_SeqAIJDelta"
+PetscErrorCode  MatConvert_SeqAIJ_SeqAIJDelta(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  PetscErrorCode  ierr;
+  Mat             B = *newmat;
+  Mat_SeqAIJDelta *dlt;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+
+  ierr = PetscNewLog(B,Mat_SeqAIJDelta,&dlt);CHKERRQ(ierr);
+  B->spptr = (void*)dlt;
+
+  /* Set function pointers for methods that we inherit from AIJ but override. */
+  B->ops->duplicate   = MatDuplicate_SeqAIJDelta;
+  B->ops->assemblyend = MatAssemblyEnd_SeqAIJDelta;
+  B->ops->destroy     = MatDestroy_SeqAIJDelta;
+  ierr = MatSeqAIJDeltaSetOps_Private(B);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqaijdelta_seqaij_C","MatConvert_SeqAIJDelta_SeqAIJ",MatConvert_SeqAIJDelta_SeqAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQAIJDELTA);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCreateSeqAIJDelta"
+/*@C
+   MatCreateSeqAIJDelta - Creates a sparse matrix of type SEQAIJDELTA.
+   This type inherits from AIJ, but additionally stores the column indices
+   as 16 bit differences between consecutive columns of each row, which are
+   used by the matrix vector products. This reduces the memory traffic of
+   the products by 2 (4 with 64 bit indices) bytes per nonzero. As with the
+   AIJ type, it is important to preallocate matrix storage in order to get
+   good assembly performance.
+
+   Collective on MPI_Comm
+
+   Input Parameters:
++  comm - MPI communicator, set to PETSC_COMM_SELF
+.  m - number of rows
+.  n - number of columns
+.  nz - number of nonzeros per row (same for all rows)
+-  nnz - array containing the number of nonzeros in the various rows
+         (possibly different for each row) or PETSC_NULL
+
+   Output Parameter:
+.  A - the matrix
+
+   Notes:
+   If nnz is given then nz is ignored
+
+   Rows in which two consecutive nonzeros are more than 65535 columns apart
+   use the AIJ column indices.
+
+   Level: intermediate
+
+.keywords: matrix, aij, compressed indices, sparse
+
+.seealso: MatCreate(), MatCreateAIJDelta(), MatSetValues(), MATSEQAIJDELTA, MATAIJDELTA
+@*/
+PetscErrorCode  MatCreateSeqAIJDelta(MPI_Comm comm,PetscInt m,PetscInt n,PetscInt nz,const PetscInt nnz[],Mat *A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(comm,A);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,m,n,m,n);CHKERRQ(ierr);
+  ierr = MatSetType(*A,MATSEQAIJDELTA);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation_SeqAIJ(*A,nz,nnz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatCreate_SeqAIJDelta"
+PetscErrorCode  MatCreate_SeqAIJDelta(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSetType(A,MATSEQAIJ);CHKERRQ(ierr);
+  ierr = MatConvert_SeqAIJ_SeqAIJDelta(A,MATSEQAIJDELTA,MAT_REUSE_MATRIX,&A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
@@ -0,0 +1,31 @@
+#if !defined(__DELTA_H)
+#define __DELTA_H
+
+#include <../src/mat/impls/aij/seq/aij.h>
+
+/*
+   Column indices of the MATSEQAIJDELTA matrix class, stored as 16 bit differences.
+
+   The entries of row i keep the positions a->i[i] to a->i[i+1]-1 of the AIJ arrays, so the values
+   a->a are used directly. The column of the first entry is rowbase[i] (and delta[a->i[i]] is 0),
+   the column of each further entry is that of the previous one plus delta[k]. Rows with two
+   consecutive columns more than MAT_DELTA_MAX apart are marked with rowbase[i] = -1 and use a->j.
+*/
+typedef unsigned short MatDeltaIndex;
+#define MAT_DELTA_MAX 65535
+
+typedef struct {
+  PetscInt      *rowbase;         /* column of the first entry of each row, -1 for rows stored with a->j */
+  MatDeltaIndex *delta;           /* column differences, indexed like a->j */
+  PetscInt      nwide;            /* number of rows that use a->j */
+  PetscInt      nonzerorowcnt;    /* number of nonempty rows, used for flop logging */
+  PetscBool     built;            /* the delta arrays are available */
+} Mat_SeqAIJDelta;
+
+extern PetscErrorCode MatSeqAIJDelta_create_delta(Mat);
+extern PetscErrorCode MatMult_SeqAIJDelta(Mat,Vec,Vec);
+extern PetscErrorCode MatMultAdd_SeqAIJDelta(Mat,Vec,Vec,Vec);
+extern PetscErrorCode MatMultTranspose_SeqAIJDelta(Mat,Vec,Vec);
+extern PetscErrorCode MatMultTransposeAdd_SeqAIJDelta(Mat,Vec,Vec,Vec);
+
+#endif
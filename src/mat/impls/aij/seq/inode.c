@@ -1181,12 +1181,13 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode(Mat B,Mat A,const MatFactorInfo *
   Mat_SeqAIJ       *a=(Mat_SeqAIJ*)A->data,*b=(Mat_SeqAIJ *)C->data;
   IS               isrow = b->row,isicol = b->icol;
   PetscErrorCode   ierr;
+  PetscBool        single;
   const PetscInt   *r,*ic,*ics;
   const PetscInt   n=A->rmap->n,*ai=a->i,*aj=a->j,*bi=b->i,*bj=b->j,*bdiag=b->diag;
   PetscInt         i,j,k,nz,nzL,row,*pj;
   const PetscInt   *ajtmp,*bjtmp;
   MatScalar        *pc,*pc1,*pc2,*pc3,*pc4,mul1,mul2,mul3,mul4,*pv,*rtmp1,*rtmp2,*rtmp3,*rtmp4;
-  const  MatScalar *aa=a->a,*v,*v1,*v2,*v3,*v4;
+  const  MatScalar *aa,*v,*v1,*v2,*v3,*v4;
   FactorShiftCtx   sctx;
   const PetscInt   *ddiag;
   PetscReal        rs;
@@ -1196,6 +1197,8 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode(Mat B,Mat A,const MatFactorInfo *
   PetscInt         *tmp_vec1,*tmp_vec2,*nsmap;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,B,&single);CHKERRQ(ierr);
+  aa   = a->a;
   /* MatPivotSetUp(): initialize shift context sctx */
   ierr = PetscMemzero(&sctx,sizeof(FactorShiftCtx));CHKERRQ(ierr);
 
@@ -1890,6 +1893,8 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode(Mat B,Mat A,const MatFactorInfo *
     }
   }
   ierr = Mat_CheckInode_FactorLU(C,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatSeqAIJCheckSolveLevels(C);CHKERRQ(ierr);
+  ierr = MatSeqAIJFactorEndSingle_Private(A,B,single,PETSC_TRUE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -1901,6 +1906,7 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode_inplace(Mat B,Mat A,const MatFact
   Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data,*b = (Mat_SeqAIJ*)C->data;
   IS                iscol = b->col,isrow = b->row,isicol = b->icol;
   PetscErrorCode    ierr;
+  PetscBool         single;
   const PetscInt    *r,*ic,*c,*ics;
   PetscInt          n = A->rmap->n,*bi = b->i;
   PetscInt          *bj = b->j,*nbj=b->j +1,*ajtmp,*bjtmp,nz,nz_tmp,row,prow;
@@ -1908,11 +1914,13 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode_inplace(Mat B,Mat A,const MatFact
   PetscInt          *ns,*tmp_vec1,*tmp_vec2,*nsmap,*pj;
   PetscScalar       mul1,mul2,mul3,tmp;
   MatScalar         *pc1,*pc2,*pc3,*ba = b->a,*pv,*rtmp11,*rtmp22,*rtmp33;
-  const MatScalar   *v1,*v2,*v3,*aa = a->a,*rtmp1;
+  const MatScalar   *v1,*v2,*v3,*aa,*rtmp1;
   PetscReal         rs=0.0;
   FactorShiftCtx    sctx;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJFactorBeginSingle_Private(A,B,&single);CHKERRQ(ierr);
+  aa   = a->a;
   sctx.shift_top      = 0;
   sctx.nshift_max     = 0;
   sctx.shift_lo       = 0;
@@ -2317,6 +2325,7 @@ PetscErrorCode MatLUFactorNumeric_SeqAIJ_Inode_inplace(Mat B,Mat A,const MatFact
   }
   ierr = PetscLogFlops(C->cmap->n);CHKERRQ(ierr);
   ierr = Mat_CheckInode(C,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = MatSeqAIJFactorEndSingle_Private(A,B,single,PETSC_FALSE);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -2766,8 +2775,14 @@ PetscErrorCode MatSOR_SeqAIJ_Inode(Mat A,Vec bb,PetscReal omega,MatSORType flag,
   PetscErrorCode     ierr;
   PetscInt           n,m = a->inode.node_count,*sizes = a->inode.size,cnt = 0,i,j,row,i1,i2;
   PetscInt           *idx,*diag = a->diag,*ii = a->i,sz,k,ipvt[5];
+  PetscBool          threaded;
 
   PetscFunctionBegin;
+  ierr = MatSeqAIJUseSORThreaded(A,flag,&threaded);CHKERRQ(ierr);
+  if (threaded) {
+    ierr = MatSOR_SeqAIJ_Threaded(A,bb,omega,flag,fshift,its,lits,xx);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (omega != 1.0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support for omega != 1.0; use -mat_no_inode");
   if (fshift != 0.0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support for fshift != 0.0; use -mat_no_inode");
 
@@ -8,6 +8,7 @@
 #include <../src/mat/utils/freespace.h>
 #include <../src/mat/utils/petscheap.h>
 #include <petscbt.h>
+#include <petscthreadcomm.h>
 #include <../src/mat/impls/dense/seq/dense.h> 
 
 #undef __FUNCT__
@@ -15,7 +16,7 @@
 PetscErrorCode MatMatMult_SeqAIJ_SeqAIJ(Mat A,Mat B,MatReuse scall,PetscReal fill,Mat *C)
 {
   PetscErrorCode ierr;
-  PetscBool      scalable=PETSC_FALSE,scalable_fast=PETSC_FALSE,heap = PETSC_FALSE,btheap = PETSC_FALSE;
+  PetscBool      scalable=PETSC_FALSE,scalable_fast=PETSC_FALSE,heap = PETSC_FALSE,btheap = PETSC_FALSE,hash = PETSC_FALSE;
 
   PetscFunctionBegin;
   if (scall == MAT_INITIAL_MATRIX){
@@ -24,8 +25,11 @@ PetscErrorCode MatMatMult_SeqAIJ_SeqAIJ(Mat A,Mat B,MatReuse scall,PetscReal fil
     ierr = PetscOptionsBool("-matmatmult_scalable_fast","Use a scalable but slower C=A*B","",scalable_fast,&scalable_fast,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscOptionsBool("-matmatmult_heap","Use heap implementation of symbolic factorization C=A*B","",heap,&heap,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscOptionsBool("-matmatmult_btheap","Use btheap implementation of symbolic factorization C=A*B","",btheap,&btheap,PETSC_NULL);CHKERRQ(ierr);
+    ierr = PetscOptionsBool("-matmatmult_hash","Use threaded hash accumulators for C=A*B","",hash,&hash,PETSC_NULL);CHKERRQ(ierr);
     ierr = PetscOptionsEnd();CHKERRQ(ierr);
-    if (scalable_fast){
+    if (hash) {
+      ierr = MatMatMultSymbolic_SeqAIJ_SeqAIJ_Hash(A,B,fill,C);CHKERRQ(ierr);
+    } else if (scalable_fast){
       ierr = MatMatMultSymbolic_SeqAIJ_SeqAIJ_Scalable_fast(A,B,fill,C);CHKERRQ(ierr);
     } else if (scalable){
       ierr = MatMatMultSymbolic_SeqAIJ_SeqAIJ_Scalable(A,B,fill,C);CHKERRQ(ierr);
@@ -687,6 +691,266 @@ PetscErrorCode MatMatMultSymbolic_SeqAIJ_SeqAIJ_BTHeap(Mat A,Mat B,PetscReal fil
   PetscFunctionReturn(0);
 }
 
+/*
+   Row-parallel product C = L*R of two matrices in compressed row form, using the threads of the
+   thread communicator. Each row of C is accumulated in an open addressing hash table owned by the
+   thread computing it, whose size only depends on the length of the longest row instead of the
+   number of columns. The symbolic product runs in two phases, the first one counts the nonzeros
+   of each row, the second one fills the sorted column indices into the allocated arrays.
+
+   The values of L may be given through a permutation, L(i,j) = la[lperm[k]], so that P^T*(A*P)
+   can use the structure of P^T with the values of P.
+*/
+typedef struct {
+  const PetscInt  *li,*lj,*lperm,*ri,*rj;
+  const MatScalar *la,*ra;
+  PetscInt        *ci,*cj;
+  MatScalar       *ca;
+  PetscBool       fill;      /* second phase of the symbolic product */
+  PetscInt        nthreads;
+  PetscInt        hsize;     /* size of each hash table, a power of 2 */
+  PetscInt        maxrow;    /* bound on the length of a row of C */
+  PetscInt        *htables;  /* for each thread the keys, the values and the list of used slots */
+} MatSeqAIJHashProduct;
+
+#define MatSeqAIJHashSlot(col,mask) ((PetscInt)(((size_t)(col)*2654435761U) & (size_t)(mask)))
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJHashProductSetUp_Private"
+/* Splits the rows into tasks of equal work, work[i] being the number of products in row i, and allocates the hash tables */
+static PetscErrorCode MatSeqAIJHashProductSetUp_Private(MPI_Comm comm,PetscInt m,const PetscInt work[],PetscInt maxrow,MatSeqAIJHashProduct *hp,PetscInt *ntasks,PetscInt **tstarts)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,t,n,hstride;
+  PetscLogDouble total = 0.0,sum = 0.0;
+
+  PetscFunctionBegin;
+  ierr = PetscThreadCommGetNThreads(comm,&hp->nthreads);CHKERRQ(ierr);
+  /* several tasks per thread, so that the scheduler can balance rows of different cost */
+  n = (hp->nthreads > 1) ? PetscMin(m,16*hp->nthreads) : PetscMin(m,1);
+  ierr = PetscMalloc((n+1)*sizeof(PetscInt),tstarts);CHKERRQ(ierr);
+  for (i=0; i<m; i++) total += work[i] + 1;
+  (*tstarts)[0] = 0;
+  for (i=0,t=1; i<m && t<n; i++) {
+    sum += work[i] + 1;
+    while (t < n && sum >= total*t/n) (*tstarts)[t++] = i+1;
+  }
+  for (; t<=n; t++) (*tstarts)[t] = m;
+  *ntasks = n;
+
+  hp->maxrow = maxrow;
+  for (hp->hsize=16; hp->hsize < 2*maxrow; hp->hsize *= 2) ;
+  hstride = 2*hp->hsize + maxrow;
+  ierr = PetscMalloc(hp->nthreads*hstride*sizeof(PetscInt),&hp->htables);CHKERRQ(ierr);
+  for (t=0; t<hp->nthreads; t++) {
+    for (i=0; i<hp->hsize; i++) hp->htables[t*hstride+i] = -1;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJHashProductSymbolic_Task"
+static PetscErrorCode MatSeqAIJHashProductSymbolic_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  MatSeqAIJHashProduct *hp = (MatSeqAIJHashProduct*)ctx;
+  const PetscInt       *li = hp->li,*lj = hp->lj,*ri = hp->ri,*rj = hp->rj,mask = hp->hsize-1;
+  PetscInt             *keys = hp->htables + thread_id*(2*hp->hsize+hp->maxrow),*used = keys + 2*hp->hsize;
+  PetscInt             i,j,k,h,col,nused;
+  PetscErrorCode       ierr;
+
+  for (i=start; i<end; i++) {
+    nused = 0;
+    for (j=li[i]; j<li[i+1]; j++) {
+      for (k=ri[lj[j]]; k<ri[lj[j]+1]; k++) {
+        col = rj[k];
+        h   = MatSeqAIJHashSlot(col,mask);
+        while (keys[h] >= 0 && keys[h] != col) h = (h+1) & mask;
+        if (keys[h] < 0) {keys[h] = col; used[nused++] = h;}
+      }
+    }
+    if (hp->fill) {
+      PetscInt *cj = hp->cj + hp->ci[i];
+
+      for (j=0; j<nused; j++) cj[j] = keys[used[j]];
+      ierr = PetscSortInt(nused,cj);CHKERRQ(ierr);
+    } else {
+      hp->ci[i+1] = nused;
+    }
+    for (j=0; j<nused; j++) keys[used[j]] = -1;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJHashProductNumeric_Task"
+static PetscErrorCode MatSeqAIJHashProductNumeric_Task(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+{
+  MatSeqAIJHashProduct *hp = (MatSeqAIJHashProduct*)ctx;
+  const PetscInt       *li = hp->li,*lj = hp->lj,*lperm = hp->lperm,*ri = hp->ri,*rj = hp->rj,*ci = hp->ci,mask = hp->hsize-1;
+  const MatScalar      *la = hp->la,*ra = hp->ra;
+  PetscInt             *keys = hp->htables + thread_id*(2*hp->hsize+hp->maxrow),*pos = keys + hp->hsize,*used = pos + hp->hsize;
+  PetscInt             i,j,k,h,col;
+  MatScalar            lval,*ca;
+
+  for (i=start; i<end; i++) {
+    const PetscInt *cj = hp->cj + ci[i];
+
+    ca = hp->ca + ci[i];
+    for (j=0; j<ci[i+1]-ci[i]; j++) {
+      h = MatSeqAIJHashSlot(cj[j],mask);
+      while (keys[h] >= 0) h = (h+1) & mask;
+      keys[h] = cj[j];
+      pos[h]  = j;
+      used[j] = h;
+      ca[j]   = 0.0;
+    }
+    for (j=li[i]; j<li[i+1]; j++) {
+      lval = lperm ? la[lperm[j]] : la[j];
+      for (k=ri[lj[j]]; k<ri[lj[j]+1]; k++) {
+        col = rj[k];
+        h   = MatSeqAIJHashSlot(col,mask);
+        while (keys[h] != col) {
+          if (keys[h] < 0) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Column %D is missing from the structure of row %D",col,i);
+          h = (h+1) & mask;
+        }
+        ca[pos[h]] += lval*ra[k];
+      }
+    }
+    for (j=0; j<ci[i+1]-ci[i]; j++) keys[used[j]] = -1;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJHashProductSymbolic"
+/*
+   MatSeqAIJHashProductSymbolic - Computes the structure of C = L*R, with m rows and rn columns, using
+   hash accumulators on the threads of comm. ci[] and cj[] are allocated with PetscMalloc().
+*/
+PetscErrorCode MatSeqAIJHashProductSymbolic(MPI_Comm comm,PetscInt m,PetscInt rn,const PetscInt li[],const PetscInt lj[],const PetscInt ri[],const PetscInt rj[],PetscInt *ci[],PetscInt *cj[])
+{
+  PetscErrorCode       ierr;
+  MatSeqAIJHashProduct hp;
+  PetscInt             i,j,maxrow = 0,ntasks,*tstarts,*work;
+
+  PetscFunctionBegin;
+  ierr = PetscMemzero(&hp,sizeof(hp));CHKERRQ(ierr);
+  ierr = PetscMalloc((m+1)*sizeof(PetscInt),ci);CHKERRQ(ierr);
+  ierr = PetscMalloc((m+1)*sizeof(PetscInt),&work);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    work[i] = 0;
+    for (j=li[i]; j<li[i+1]; j++) work[i] += ri[lj[j]+1] - ri[lj[j]];
+    maxrow = PetscMax(maxrow,PetscMin(work[i],rn));
+  }
+  ierr = MatSeqAIJHashProductSetUp_Private(comm,m,work,maxrow,&hp,&ntasks,&tstarts);CHKERRQ(ierr);
+  hp.li = li; hp.lj = lj; hp.ri = ri; hp.rj = rj; hp.ci = *ci;
+
+  /* count the nonzeros of each row into ci[i+1] */
+  hp.fill = PETSC_FALSE;
+  ierr = PetscThreadCommRunTasks(comm,ntasks,tstarts,MatSeqAIJHashProductSymbolic_Task,&hp);CHKERRQ(ierr);
+  (*ci)[0] = 0;
+  for (i=0; i<m; i++) (*ci)[i+1] += (*ci)[i];
+
+  /* fill the column indices */
+  ierr = PetscMalloc(((*ci)[m]+1)*sizeof(PetscInt),cj);CHKERRQ(ierr);
+  hp.fill = PETSC_TRUE;
+  hp.cj   = *cj;
+  ierr = PetscThreadCommRunTasks(comm,ntasks,tstarts,MatSeqAIJHashProductSymbolic_Task,&hp);CHKERRQ(ierr);
+  ierr = PetscFree(hp.htables);CHKERRQ(ierr);
+  ierr = PetscFree(tstarts);CHKERRQ(ierr);
+  ierr = PetscFree(work);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqAIJHashProductNumeric"
+/*
+   MatSeqAIJHashProductNumeric - Computes the values of C = L*R, whose structure comes from MatSeqAIJHashProductSymbolic(),
+   using hash accumulators on the threads of comm. If lperm is not PETSC_NULL the values of L are la[lperm[]].
+*/
+PetscErrorCode MatSeqAIJHashProductNumeric(MPI_Comm comm,PetscInt m,const PetscInt li[],const PetscInt lj[],const PetscInt lperm[],const MatScalar la[],const PetscInt ri[],const PetscInt rj[],const MatScalar ra[],const PetscInt ci[],const PetscInt cj[],MatScalar ca[])
+{
+  PetscErrorCode       ierr;
+  MatSeqAIJHashProduct hp;
+  PetscInt             i,j,maxrow = 0,ntasks,*tstarts,*work;
+  PetscLogDouble       flops = 0.0;
+
+  PetscFunctionBegin;
+  ierr = PetscMemzero(&hp,sizeof(hp));CHKERRQ(ierr);
+  ierr = PetscMalloc((m+1)*sizeof(PetscInt),&work);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    work[i] = 0;
+    for (j=li[i]; j<li[i+1]; j++) work[i] += ri[lj[j]+1] - ri[lj[j]];
+    flops  += 2.0*work[i];
+    maxrow  = PetscMax(maxrow,ci[i+1]-ci[i]);
+  }
+  ierr = MatSeqAIJHashProductSetUp_Private(comm,m,work,maxrow,&hp,&ntasks,&tstarts);CHKERRQ(ierr);
+  hp.li = li; hp.lj = lj; hp.lperm = lperm; hp.la = la;
+  hp.ri = ri; hp.rj = rj; hp.ra = ra;
+  hp.ci = (PetscInt*)ci; hp.cj = (PetscInt*)cj; hp.ca = ca;
+  ierr = PetscThreadCommRunTasks(comm,ntasks,tstarts,MatSeqAIJHashProductNumeric_Task,&hp);CHKERRQ(ierr);
+  ierr = PetscFree(hp.htables);CHKERRQ(ierr);
+  ierr = PetscFree(tstarts);CHKERRQ(ierr);
+  ierr = PetscFree(work);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMatMultSymbolic_SeqAIJ_SeqAIJ_Hash"
+PetscErrorCode MatMatMultSymbolic_SeqAIJ_SeqAIJ_Hash(Mat A,Mat B,PetscReal fill,Mat *C)
+{
+  PetscErrorCode ierr;
+  Mat_SeqAIJ     *a=(Mat_SeqAIJ*)A->data,*b=(Mat_SeqAIJ*)B->data,*c;
+  PetscInt       *ci,*cj,am=A->rmap->N,bn=B->cmap->N,bm=B->rmap->N;
+  MatScalar      *ca;
+  PetscReal      afill;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJHashProductSymbolic(((PetscObject)A)->comm,am,bn,a->i,a->j,b->i,b->j,&ci,&cj);CHKERRQ(ierr);
+  ierr = PetscMalloc((ci[am]+1)*sizeof(MatScalar),&ca);CHKERRQ(ierr);
+
+  /* put together the new symbolic matrix */
+  ierr = MatCreateSeqAIJWithArrays(((PetscObject)A)->comm,am,bn,ci,cj,ca,C);CHKERRQ(ierr);
+  (*C)->rmap->bs = A->rmap->bs;
+  (*C)->cmap->bs = B->cmap->bs;
+
+  /* MatCreateSeqAIJWithArrays flags matrix so PETSc doesn't free the user's arrays. */
+  /* These are PETSc arrays, so change flags so arrays can be deleted by PETSc */
+  c = (Mat_SeqAIJ *)((*C)->data);
+  c->free_a  = PETSC_TRUE;
+  c->free_ij = PETSC_TRUE;
+  c->nonew   = 0;
+  (*C)->ops->matmultnumeric = MatMatMultNumeric_SeqAIJ_SeqAIJ_Hash;
+
+  /* set MatInfo */
+  afill = (PetscReal)ci[am]/(a->i[am]+b->i[bm]) + 1.e-5;
+  if (afill < 1.0) afill = 1.0;
+  (*C)->info.mallocs           = 0;
+  (*C)->info.fill_ratio_given  = fill;
+  (*C)->info.fill_ratio_needed = afill;
+#if defined(PETSC_USE_INFO)
+  ierr = PetscInfo2((*C),"Hash product with %D nonzeros, fill ratio needed %G\n",ci[am],afill);CHKERRQ(ierr);
+#endif
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMatMultNumeric_SeqAIJ_SeqAIJ_Hash"
+PetscErrorCode MatMatMultNumeric_SeqAIJ_SeqAIJ_Hash(Mat A,Mat B,Mat C)
+{
+  PetscErrorCode ierr;
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ *)A->data;
+  Mat_SeqAIJ     *b = (Mat_SeqAIJ *)B->data;
+  Mat_SeqAIJ     *c = (Mat_SeqAIJ *)C->data;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJHashProductNumeric(((PetscObject)A)->comm,A->rmap->N,a->i,a->j,PETSC_NULL,a->a,b->i,b->j,b->a,c->i,c->j,c->a);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /* This routine is not used. Should be removed! */
 #undef __FUNCT__
 #define __FUNCT__ "MatMatTransposeMult_SeqAIJ_SeqAIJ"
@@ -34,6 +34,7 @@ PetscErrorCode MatDestroy_SeqAIJ_PtAP(Mat A)
   ierr = PetscFree(ptap->apa);CHKERRQ(ierr);
   ierr = PetscFree(ptap->api);CHKERRQ(ierr);
   ierr = PetscFree(ptap->apj);CHKERRQ(ierr);
+  ierr = PetscFree3(ptap->pti,ptap->ptj,ptap->ptperm);CHKERRQ(ierr);
   ierr = (ptap->destroy)(A);CHKERRQ(ierr);
   ierr = PetscFree(ptap);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -260,7 +261,7 @@ PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
   MatScalar          *ca;
   Mat_PtAP           *ptap;
   Mat                Pt,AP;
-  PetscBool          sparse_axpy=PETSC_TRUE;
+  PetscBool          sparse_axpy=PETSC_TRUE,hash=PETSC_FALSE;
 
   PetscFunctionBegin;
   ierr = PetscObjectOptionsBegin((PetscObject)A);CHKERRQ(ierr);
@@ -268,7 +269,12 @@ PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
        0: do dense axpy in MatPtAPNumeric() - fastest, but requires storage of struct A*P;
        1: do two sparse axpy in MatPtAPNumeric() - slowest, does not store structure of A*P. */
   ierr = PetscOptionsBool("-matptap_scalable","Use sparse axpy but slower MatPtAPNumeric()","",sparse_axpy,&sparse_axpy,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsBool("-matptap_hash","Use threaded hash accumulators for MatPtAP()","",hash,&hash,PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscOptionsEnd();CHKERRQ(ierr);
+  if (hash) {
+    ierr = MatPtAPSymbolic_SeqAIJ_SeqAIJ_Hash(A,P,fill,C);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (sparse_axpy){
     ierr = MatPtAPSymbolic_SeqAIJ_SeqAIJ_SparseAxpy(A,P,fill,C);CHKERRQ(ierr);
     PetscFunctionReturn(0);
@@ -318,6 +324,93 @@ PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ(Mat A,Mat P,PetscReal fill,Mat *C)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPSymbolic_SeqAIJ_SeqAIJ_Hash"
+/*
+   Forms A*P and then P^T*(A*P) with the threaded hash products of matmatmult.c. P^T is never
+   assembled, its structure is kept together with the location of each of its entries in P.
+*/
+PetscErrorCode MatPtAPSymbolic_SeqAIJ_SeqAIJ_Hash(Mat A,Mat P,PetscReal fill,Mat *C)
+{
+  PetscErrorCode     ierr;
+  Mat_SeqAIJ         *a = (Mat_SeqAIJ*)A->data,*p = (Mat_SeqAIJ*)P->data,*c;
+  PetscInt           *pi=p->i,*pj=p->j,*pti,*ptj,*ptperm,*api,*apj,*ci,*cj;
+  PetscInt           am=A->rmap->N,pm=P->rmap->N,pn=P->cmap->N,i,k,pos;
+  MatScalar          *ca;
+  Mat_PtAP           *ptap;
+  MPI_Comm           comm = ((PetscObject)A)->comm;
+
+  PetscFunctionBegin;
+  /* structure of P^T and location of its entries in P, the rows of P^T are sorted */
+  ierr = PetscMalloc3(pn+1,PetscInt,&pti,pi[pm]+1,PetscInt,&ptj,pi[pm]+1,PetscInt,&ptperm);CHKERRQ(ierr);
+  ierr = PetscMemzero(pti,(pn+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (k=0; k<pi[pm]; k++) pti[pj[k]+1]++;
+  for (i=0; i<pn; i++) pti[i+1] += pti[i];
+  for (i=0; i<pm; i++) {
+    for (k=pi[i]; k<pi[i+1]; k++) {
+      pos         = pti[pj[k]]++;
+      ptj[pos]    = i;
+      ptperm[pos] = k;
+    }
+  }
+  for (i=pn; i>0; i--) pti[i] = pti[i-1];
+  pti[0] = 0;
+
+  /* symbolic A*P and P^T*(A*P) */
+  ierr = MatSeqAIJHashProductSymbolic(comm,am,pn,a->i,a->j,pi,pj,&api,&apj);CHKERRQ(ierr);
+  ierr = MatSeqAIJHashProductSymbolic(comm,pn,pn,pti,ptj,api,apj,&ci,&cj);CHKERRQ(ierr);
+  ierr = PetscMalloc((ci[pn]+1)*sizeof(MatScalar),&ca);CHKERRQ(ierr);
+  ierr = PetscMemzero(ca,(ci[pn]+1)*sizeof(MatScalar));CHKERRQ(ierr);
+
+  /* put together the new matrix */
+  ierr = MatCreateSeqAIJWithArrays(comm,pn,pn,ci,cj,ca,C);CHKERRQ(ierr);
+  (*C)->rmap->bs = P->cmap->bs;
+  (*C)->cmap->bs = P->cmap->bs;
+
+  /* MatCreateSeqAIJWithArrays flags matrix so PETSc doesn't free the user's arrays. */
+  /* Since these are PETSc arrays, change flags to free them as necessary. */
+  c = (Mat_SeqAIJ *)((*C)->data);
+  c->free_a  = PETSC_TRUE;
+  c->free_ij = PETSC_TRUE;
+  c->nonew   = 0;
+
+  /* Create a supporting struct for reuse by MatPtAPNumeric() */
+  ierr = PetscNew(Mat_PtAP,&ptap);CHKERRQ(ierr);
+  c->ptap            = ptap;
+  ptap->destroy      = (*C)->ops->destroy;
+  (*C)->ops->destroy = MatDestroy_SeqAIJ_PtAP;
+  ptap->api          = api;
+  ptap->apj          = apj;
+  ptap->pti          = pti;
+  ptap->ptj          = ptj;
+  ptap->ptperm       = ptperm;
+  ierr = PetscMalloc((api[am]+1)*sizeof(PetscScalar),&ptap->apa);CHKERRQ(ierr);
+  (*C)->ops->ptapnumeric = MatPtAPNumeric_SeqAIJ_SeqAIJ_Hash;
+#if defined(PETSC_USE_INFO)
+  ierr = PetscInfo2((*C),"Hash product, nonzeros in A*P %D, in P^T*A*P %D\n",api[am],ci[pn]);CHKERRQ(ierr);
+#endif
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatPtAPNumeric_SeqAIJ_SeqAIJ_Hash"
+PetscErrorCode MatPtAPNumeric_SeqAIJ_SeqAIJ_Hash(Mat A,Mat P,Mat C)
+{
+  PetscErrorCode ierr;
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ *) A->data;
+  Mat_SeqAIJ     *p = (Mat_SeqAIJ *) P->data;
+  Mat_SeqAIJ     *c = (Mat_SeqAIJ *) C->data;
+  Mat_PtAP       *ptap = c->ptap;
+  MPI_Comm       comm = ((PetscObject)A)->comm;
+
+  PetscFunctionBegin;
+  ierr = MatSeqAIJHashProductNumeric(comm,A->rmap->N,a->i,a->j,PETSC_NULL,a->a,p->i,p->j,p->a,ptap->api,ptap->apj,ptap->apa);CHKERRQ(ierr);
+  ierr = MatSeqAIJHashProductNumeric(comm,C->rmap->N,ptap->pti,ptap->ptj,ptap->ptperm,p->a,ptap->api,ptap->apj,ptap->apa,c->i,c->j,c->a);CHKERRQ(ierr);
+  ierr = MatAssemblyBegin(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  ierr = MatAssemblyEnd(C,MAT_FINAL_ASSEMBLY);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /* #define PROFILE_MatPtAPNumeric */
 #undef __FUNCT__
 #define __FUNCT__ "MatPtAPNumeric_SeqAIJ_SeqAIJ"
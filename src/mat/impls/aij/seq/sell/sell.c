@@ -0,0 +1,511 @@
+
+/*
+  Defines basic operations for the MATSEQSELL matrix class.
+  This class is derived from the MATSEQAIJ class and retains the
+  compressed row storage (aka Yale sparse matrix format) but augments
+  it with a sliced ELLPACK (SELL-C-sigma) copy of the matrix that is
+  used for the matrix-vector products.
+
+  Rows are grouped into slices of C (the slice height) consecutive rows and
+  each slice is padded only to the length of its own longest row, so unlike
+  MATSEQAIJCRL a few long rows do not force padding of the entire matrix.
+  Sorting the rows by length within windows of sigma rows (sigma >= C)
+  reduces the padding further, at the price of a permuted write of the result.
+  Within a slice the entries are stored column by column, hence the inner
+  loops of the kernels run over C contiguous entries and vectorize.
+*/
+
+#include <../src/mat/impls/aij/seq/sell/sell.h>
+
+extern PetscErrorCode MatAssemblyEnd_SeqAIJ(Mat,MatAssemblyType);
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqSELLFree_Private"
+static PetscErrorCode MatSeqSELLFree_Private(Mat_SeqSELL *sell)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(sell->sliidx);CHKERRQ(ierr);
+  ierr = PetscFree2(sell->colidx,sell->val);CHKERRQ(ierr);
+  ierr = PetscFree(sell->perm);CHKERRQ(ierr);
+  sell->built = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqSELL_SeqAIJ"
+PetscErrorCode  MatConvert_SeqSELL_SeqAIJ(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  /* This routine is only called to convert a MATSEQSELL to its base PETSc type, */
+  /* so we will ignore 'MatType type'. */
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+  Mat_SeqSELL    *sell;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+  sell = (Mat_SeqSELL*)B->spptr;
+
+  /* Reset the original function pointers; the inode routines are restored at the next assembly */
+  B->ops->assemblyend      = MatAssemblyEnd_SeqAIJ;
+  B->ops->destroy          = MatDestroy_SeqAIJ;
+  B->ops->duplicate        = MatDuplicate_SeqAIJ;
+  B->ops->mult             = MatMult_SeqAIJ;
+  B->ops->multadd          = MatMultAdd_SeqAIJ;
+  B->ops->multtranspose    = MatMultTranspose_SeqAIJ;
+  B->ops->multtransposeadd = MatMultTransposeAdd_SeqAIJ;
+
+  ierr = MatSeqSELLFree_Private(sell);CHKERRQ(ierr);
+  ierr = PetscFree(B->spptr);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqsell_seqaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQAIJ);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDestroy_SeqSELL"
+PetscErrorCode MatDestroy_SeqSELL(Mat A)
+{
+  PetscErrorCode ierr;
+  Mat_SeqSELL    *sell = (Mat_SeqSELL*)A->spptr;
+
+  PetscFunctionBegin;
+  /* Free everything in the Mat_SeqSELL data structure. */
+  if (sell) {
+    ierr = MatSeqSELLFree_Private(sell);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(A->spptr);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)A,"MatConvert_seqsell_seqaij_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)A,MATSEQAIJ);CHKERRQ(ierr);
+  ierr = MatDestroy_SeqAIJ(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqSELL_create_sell"
+/*
+   Builds the SELL-C-sigma copy of the current AIJ data. The matrix must be assembled.
+*/
+PetscErrorCode MatSeqSELL_create_sell(Mat A)
+{
+  Mat_SeqAIJ     *a = (Mat_SeqAIJ*)A->data;
+  Mat_SeqSELL    *sell = (Mat_SeqSELL*)A->spptr;
+  PetscInt       m = A->rmap->n,C = sell->sliceheight,sigma = sell->sigma;
+  PetscInt       *ai = a->i,*aj = a->j,*sliidx,*colidx,*perm = PETSC_NULL,*rlen;
+  PetscInt       s,r,j,k,row,len,width,start,end,totalslices,nz,nonzerorowcnt = 0;
+  MatScalar      *aa = a->a,*val;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqSELLFree_Private(sell);CHKERRQ(ierr);
+  totalslices = (m+C-1)/C;
+
+  /* sort the rows by decreasing length inside each window of sigma rows; windows no taller than a slice gain nothing */
+  ierr = PetscMalloc(m*sizeof(PetscInt),&rlen);CHKERRQ(ierr);
+  if (sigma > C && m > C) {
+    ierr = PetscMalloc(m*sizeof(PetscInt),&perm);CHKERRQ(ierr);
+    for (row=0; row<m; row++) {
+      perm[row] = row;
+      rlen[row] = -(ai[row+1]-ai[row]);
+    }
+    for (start=0; start<m; start+=sigma) {
+      end  = PetscMin(start+sigma,m);
+      ierr = PetscSortIntWithArray(end-start,rlen+start,perm+start);CHKERRQ(ierr);
+    }
+    for (row=0; row<m; row++) rlen[row] = -rlen[row];
+  } else {
+    for (row=0; row<m; row++) rlen[row] = ai[row+1]-ai[row];
+  }
+
+  /* each slice is as wide as its longest row */
+  ierr = PetscMalloc((totalslices+1)*sizeof(PetscInt),&sliidx);CHKERRQ(ierr);
+  sliidx[0]           = 0;
+  sell->maxslicewidth = 0;
+  for (s=0; s<totalslices; s++) {
+    width = 0;
+    for (row=s*C; row<PetscMin((s+1)*C,m); row++) {
+      width = PetscMax(width,rlen[row]);
+      nonzerorowcnt += (rlen[row] > 0);
+    }
+    sell->maxslicewidth = PetscMax(sell->maxslicewidth,width);
+    sliidx[s+1]         = sliidx[s] + width*C;
+  }
+  nz   = sliidx[totalslices];
+  ierr = PetscMalloc2(nz,PetscInt,&colidx,nz,MatScalar,&val);CHKERRQ(ierr);
+
+  for (s=0; s<totalslices; s++) {
+    width = (sliidx[s+1]-sliidx[s])/C;
+    for (r=0; r<C; r++) {
+      row = s*C + r;
+      len = 0;
+      k   = 0;
+      if (row < m) {
+        len = rlen[row];
+        k   = ai[perm ? perm[row] : row];
+      }
+      for (j=0; j<len; j++) {
+        colidx[sliidx[s]+j*C+r] = aj[k+j];
+        val[sliidx[s]+j*C+r]    = aa[k+j];
+      }
+      /* padding repeats the last column of the row so it does not touch new cache lines of x */
+      for (; j<width; j++) {
+        colidx[sliidx[s]+j*C+r] = len ? aj[k+len-1] : 0;
+        val[sliidx[s]+j*C+r]    = 0.0;
+      }
+    }
+  }
+  ierr = PetscFree(rlen);CHKERRQ(ierr);
+
+  sell->totalslices   = totalslices;
+  sell->sliidx        = sliidx;
+  sell->colidx        = colidx;
+  sell->val           = val;
+  sell->perm          = perm;
+  sell->nonzerorowcnt = nonzerorowcnt;
+  sell->state         = ((PetscObject)A)->state;
+  sell->built         = PETSC_TRUE;
+  ierr = PetscInfo4(A,"Slice height %D, sigma %D, %D slices, percentage of 0's introduced for vectorized multiply %g\n",C,sigma,totalslices,nz ? 1.0-((double)a->nz)/((double)nz) : 0.0);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqSELLUpdate_Private"
+/*
+   The values may have been changed without a new assembly (MatScale(), MatZeroEntries(), ...);
+   all such operations increase the object state, so compare with the state the SELL arrays were built for.
+*/
+PETSC_STATIC_INLINE PetscErrorCode MatSeqSELLUpdate_Private(Mat A)
+{
+  Mat_SeqSELL    *sell = (Mat_SeqSELL*)A->spptr;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!sell->built || sell->state != ((PetscObject)A)->state) {
+    ierr = MatSeqSELL_create_sell(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+/*
+   Computes sum[r] = sum_j val[j*C+r]*x[colidx[j*C+r]] for one slice of nnz stored entries.
+   It is always called with a literal slice height so that the compiler keeps sum[] in vector
+   registers and generates SIMD code for the loop over r.
+*/
+PETSC_STATIC_INLINE void MatMultSlice_SeqSELL_Private(const PetscInt C,PetscInt nnz,const PetscInt *PETSC_RESTRICT colidx,const MatScalar *PETSC_RESTRICT val,const PetscScalar *PETSC_RESTRICT x,PetscScalar *PETSC_RESTRICT sum)
+{
+  PetscInt j,r;
+
+  for (r=0; r<C; r++) sum[r] = 0.0;
+  for (j=0; j<nnz; j+=C) {
+    for (r=0; r<C; r++) sum[r] += val[j+r]*x[colidx[j+r]];
+  }
+}
+
+#define MatMultSlice_SeqSELL(C,nnz,colidx,val,x,sum) do {                             \
+    switch (C) {                                                                        \
+    case 4:  MatMultSlice_SeqSELL_Private(4,nnz,colidx,val,x,sum);  break;               \
+    case 8:  MatMultSlice_SeqSELL_Private(8,nnz,colidx,val,x,sum);  break;               \
+    case 16: MatMultSlice_SeqSELL_Private(16,nnz,colidx,val,x,sum); break;               \
+    default: MatMultSlice_SeqSELL_Private(C,nnz,colidx,val,x,sum);                       \
+    }                                                                                   \
+  } while (0)
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqSELL"
+PetscErrorCode MatMult_SeqSELL(Mat A,Vec xx,Vec yy)
+{
+  Mat_SeqSELL       *sell = (Mat_SeqSELL*)A->spptr;
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscInt          m = A->rmap->n,C,s,r,row,nrows,*sliidx,*colidx,*perm;
+  MatScalar         *val;
+  const PetscScalar *x;
+  PetscScalar       *y,sum[MAT_SELL_MAX_SLICE_HEIGHT];
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr   = MatSeqSELLUpdate_Private(A);CHKERRQ(ierr);
+  C      = sell->sliceheight;
+  sliidx = sell->sliidx;
+  colidx = sell->colidx;
+  val    = sell->val;
+  perm   = sell->perm;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  for (s=0; s<sell->totalslices; s++) {
+    MatMultSlice_SeqSELL(C,sliidx[s+1]-sliidx[s],colidx+sliidx[s],val+sliidx[s],x,sum);
+    row   = s*C;
+    nrows = PetscMin(C,m-row);
+    if (perm) {
+      for (r=0; r<nrows; r++) y[perm[row+r]] = sum[r];
+    } else {
+      for (r=0; r<nrows; r++) y[row+r] = sum[r];
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz - sell->nonzerorowcnt);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqSELL"
+/*
+   zz = yy + A*xx
+*/
+PetscErrorCode MatMultAdd_SeqSELL(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqSELL       *sell = (Mat_SeqSELL*)A->spptr;
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscInt          m = A->rmap->n,C,s,r,row,nrows,*sliidx,*colidx,*perm;
+  MatScalar         *val;
+  const PetscScalar *x;
+  PetscScalar       *y,*z,sum[MAT_SELL_MAX_SLICE_HEIGHT];
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr   = MatSeqSELLUpdate_Private(A);CHKERRQ(ierr);
+  C      = sell->sliceheight;
+  sliidx = sell->sliidx;
+  colidx = sell->colidx;
+  val    = sell->val;
+  perm   = sell->perm;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecGetArray(yy,&y);CHKERRQ(ierr);
+  } else {
+    y = z;
+  }
+  for (s=0; s<sell->totalslices; s++) {
+    MatMultSlice_SeqSELL(C,sliidx[s+1]-sliidx[s],colidx+sliidx[s],val+sliidx[s],x,sum);
+    row   = s*C;
+    nrows = PetscMin(C,m-row);
+    if (perm) {
+      for (r=0; r<nrows; r++) z[perm[row+r]] = y[perm[row+r]] + sum[r];
+    } else {
+      for (r=0; r<nrows; r++) z[row+r] = y[row+r] + sum[r];
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  if (zz != yy) {
+    ierr = VecRestoreArray(yy,&y);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTransposeAdd_SeqSELL"
+/*
+   zz = yy + A'*xx
+*/
+PetscErrorCode MatMultTransposeAdd_SeqSELL(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqSELL       *sell = (Mat_SeqSELL*)A->spptr;
+  Mat_SeqAIJ        *a = (Mat_SeqAIJ*)A->data;
+  PetscInt          m = A->rmap->n,C,s,r,j,row,nrows,*sliidx,*colidx,*perm;
+  MatScalar         *val;
+  const PetscScalar *x;
+  PetscScalar       *z,xs[MAT_SELL_MAX_SLICE_HEIGHT];
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr   = MatSeqSELLUpdate_Private(A);CHKERRQ(ierr);
+  if (zz != yy) {ierr = VecCopy(yy,zz);CHKERRQ(ierr);}
+  C      = sell->sliceheight;
+  sliidx = sell->sliidx;
+  colidx = sell->colidx;
+  val    = sell->val;
+  perm   = sell->perm;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  for (s=0; s<sell->totalslices; s++) {
+    row   = s*C;
+    nrows = PetscMin(C,m-row);
+    if (perm) {
+      for (r=0; r<nrows; r++) xs[r] = x[perm[row+r]];
+    } else {
+      for (r=0; r<nrows; r++) xs[r] = x[row+r];
+    }
+    for (; r<C; r++) xs[r] = 0.0;
+    for (j=sliidx[s]; j<sliidx[s+1]; j+=C) {
+      for (r=0; r<C; r++) z[colidx[j+r]] += val[j+r]*xs[r];
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTranspose_SeqSELL"
+PetscErrorCode MatMultTranspose_SeqSELL(Mat A,Vec xx,Vec yy)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSet(yy,0.0);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_SeqSELL(A,xx,yy,yy);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqSELLSetOps_Private"
+static PetscErrorCode MatSeqSELLSetOps_Private(Mat B)
+{
+  PetscFunctionBegin;
+  B->ops->mult             = MatMult_SeqSELL;
+  B->ops->multadd          = MatMultAdd_SeqSELL;
+  B->ops->multtranspose    = MatMultTranspose_SeqSELL;
+  B->ops->multtransposeadd = MatMultTransposeAdd_SeqSELL;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_SeqSELL"
+PetscErrorCode MatAssemblyEnd_SeqSELL(Mat A, MatAssemblyType mode)
+{
+  PetscErrorCode ierr;
+  Mat_SeqSELL    *sell = (Mat_SeqSELL*)A->spptr;
+
+  PetscFunctionBegin;
+  ierr = MatAssemblyEnd_SeqAIJ(A,mode);CHKERRQ(ierr);
+  /* the inode check may have installed its own multiply routines */
+  ierr = MatSeqSELLSetOps_Private(A);CHKERRQ(ierr);
+  if (mode == MAT_FLUSH_ASSEMBLY) PetscFunctionReturn(0);
+
+  /* The SELL arrays are built lazily by the first product after the assembly */
+  sell->built = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDuplicate_SeqSELL"
+PetscErrorCode MatDuplicate_SeqSELL(Mat A, MatDuplicateOption op, Mat *M)
+{
+  PetscErrorCode ierr;
+  Mat_SeqSELL    *sell = (Mat_SeqSELL*)A->spptr,*sell_dest;
+
+  PetscFunctionBegin;
+  ierr = MatDuplicate_SeqAIJ(A,op,M);CHKERRQ(ierr);
+  ierr = MatSeqSELLSetOps_Private(*M);CHKERRQ(ierr);
+  sell_dest              = (Mat_SeqSELL*)(*M)->spptr;
+  sell_dest->sliceheight = sell->sliceheight;
+  sell_dest->sigma       = sell->sigma;
+  PetscFunctionReturn(0);
+}
+
+/* MatConvert_SeqAIJ_SeqSELL converts a SeqAIJ matrix into a
+ * SeqSELL matrix.  This routine is called by the MatCreate_SeqSELL()
+ * routine, but can also be used to convert an assembled SeqAIJ matrix
+ * into a SeqSELL one. */
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqAIJ_SeqSELL"
+PetscErrorCode  MatConvert_SeqAIJ_SeqSELL(Mat A,MatType type,MatReuse reuse,Mat *newmat)
+{
+  PetscErrorCode ierr;
+  Mat            B = *newmat;
+  Mat_SeqSELL    *sell;
+
+  PetscFunctionBegin;
+  if (reuse == MAT_INITIAL_MATRIX) {
+    ierr = MatDuplicate(A,MAT_COPY_VALUES,&B);CHKERRQ(ierr);
+  }
+
+  ierr = PetscNewLog(B,Mat_SeqSELL,&sell);CHKERRQ(ierr);
+  B->spptr          = (void*)sell;
+  sell->sliceheight = 8;
+  sell->sigma       = 1;
+  ierr = PetscOptionsBegin(((PetscObject)B)->comm,((PetscObject)B)->prefix,"SELL matrix options","Mat");CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-mat_sell_slice_height","Number of rows stored together in a slice","MatCreateSeqSELL",sell->sliceheight,&sell->sliceheight,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsInt("-mat_sell_sigma","Rows are sorted by length within windows of this many rows","MatCreateSeqSELL",sell->sigma,&sell->sigma,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsEnd();CHKERRQ(ierr);
+  if (sell->sliceheight < 1 || sell->sliceheight > MAT_SELL_MAX_SLICE_HEIGHT) SETERRQ2(((PetscObject)B)->comm,PETSC_ERR_ARG_OUTOFRANGE,"Slice height %D must be between 1 and %D",sell->sliceheight,(PetscInt)MAT_SELL_MAX_SLICE_HEIGHT);
+  if (sell->sigma < 1) SETERRQ1(((PetscObject)B)->comm,PETSC_ERR_ARG_OUTOFRANGE,"Sigma %D must be positive",sell->sigma);
+
+  /* Set function pointers for methods that we inherit from AIJ but override. */
+  B->ops->duplicate   = MatDuplicate_SeqSELL;
+  B->ops->assemblyend = MatAssemblyEnd_SeqSELL;
+  B->ops->destroy     = MatDestroy_SeqSELL;
+  ierr = MatSeqSELLSetOps_Private(B);CHKERRQ(ierr);
+
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatConvert_seqsell_seqaij_C","MatConvert_SeqSELL_SeqAIJ",MatConvert_SeqSELL_SeqAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectChangeTypeName((PetscObject)B,MATSEQSELL);CHKERRQ(ierr);
+  *newmat = B;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCreateSeqSELL"
+/*@C
+   MatCreateSeqSELL - Creates a sparse matrix of type SEQSELL.
+   This type inherits from AIJ, but additionally stores the matrix in the
+   sliced ELLPACK format SELL-C-sigma: groups of C consecutive rows are padded
+   to the length of their longest row and stored column by column, so that
+   the matrix vector products operate on C rows at a time with stride-1
+   memory accesses. As with the AIJ type, it is important to preallocate
+   matrix storage in order to get good assembly performance.
+
+   Collective on MPI_Comm
+
+   Input Parameters:
++  comm - MPI communicator, set to PETSC_COMM_SELF
+.  m - number of rows
+.  n - number of columns
+.  nz - number of nonzeros per row (same for all rows)
+-  nnz - array containing the number of nonzeros in the various rows
+         (possibly different for each row) or PETSC_NULL
+
+   Output Parameter:
+.  A - the matrix
+
+   Options Database Keys:
++  -mat_sell_slice_height <8> - number of rows C in each slice (at most 64)
+-  -mat_sell_sigma <1> - rows are sorted by decreasing length within windows of this many rows,
+                         values larger than the slice height reduce the padding for irregular matrices
+
+   Notes:
+   If nnz is given then nz is ignored
+
+   Level: intermediate
+
+.keywords: matrix, sell, sliced ellpack, sparse, vectorization
+
+.seealso: MatCreate(), MatCreateSELL(), MatSetValues(), MATSEQSELL, MATSELL
+@*/
+PetscErrorCode  MatCreateSeqSELL(MPI_Comm comm,PetscInt m,PetscInt n,PetscInt nz,const PetscInt nnz[],Mat *A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatCreate(comm,A);CHKERRQ(ierr);
+  ierr = MatSetSizes(*A,m,n,m,n);CHKERRQ(ierr);
+  ierr = MatSetType(*A,MATSEQSELL);CHKERRQ(ierr);
+  ierr = MatSeqAIJSetPreallocation_SeqAIJ(*A,nz,nnz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatCreate_SeqSELL"
+PetscErrorCode  MatCreate_SeqSELL(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSetType(A,MATSEQAIJ);CHKERRQ(ierr);
+  ierr = MatConvert_SeqAIJ_SeqSELL(A,MATSEQSELL,MAT_REUSE_MATRIX,&A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
@@ -0,0 +1,38 @@
+
+#if !defined(__SELL_H)
+#define __SELL_H
+
+#include <../src/mat/impls/aij/seq/aij.h>
+
+/*
+   SELL-C-sigma (sliced ELLPACK) storage for the MATSEQSELL matrix class.
+
+   The rows of the matrix (after an optional sort by length inside windows of
+   sigma rows) are grouped into slices of C consecutive rows. Each slice is padded
+   to the length of its longest row and stored column by column, so that the C
+   entries val[sliidx[s]+j*C+r], r=0,..,C-1, are contiguous in memory and can be
+   processed with SIMD instructions.
+*/
+#define MAT_SELL_MAX_SLICE_HEIGHT 64
+
+typedef struct {
+  PetscInt    sliceheight;    /* C: number of rows in each slice */
+  PetscInt    sigma;          /* rows are sorted by decreasing length within windows of sigma rows */
+  PetscInt    totalslices;    /* number of slices */
+  PetscInt    maxslicewidth;  /* largest number of columns stored for any slice */
+  PetscInt    *sliidx;        /* sliidx[s] is the offset of slice s in colidx[] and val[]; length totalslices+1 */
+  PetscInt    *colidx;        /* column indices, stored slice by slice, column by column within a slice */
+  MatScalar   *val;           /* values, stored as colidx */
+  PetscInt    *perm;          /* perm[k] is the AIJ row stored in position k, PETSC_NULL if rows are not permuted */
+  PetscInt    nonzerorowcnt;  /* number of nonempty rows, used for flop logging */
+  PetscInt    state;          /* object state of the matrix the SELL arrays were built from */
+  PetscBool   built;          /* the SELL arrays are available */
+} Mat_SeqSELL;
+
+extern PetscErrorCode MatSeqSELL_create_sell(Mat);
+extern PetscErrorCode MatMult_SeqSELL(Mat,Vec,Vec);
+extern PetscErrorCode MatMultAdd_SeqSELL(Mat,Vec,Vec,Vec);
+extern PetscErrorCode MatMultTranspose_SeqSELL(Mat,Vec,Vec);
+extern PetscErrorCode MatMultTransposeAdd_SeqSELL(Mat,Vec,Vec,Vec);
+
+#endif
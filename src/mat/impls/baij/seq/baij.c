@@ -6,6 +6,9 @@
 #include <../src/mat/impls/baij/seq/baij.h>  /*I   "petscmat.h"  I*/
 #include <petscblaslapack.h>
 #include <../src/mat/blockinvert.h>
+#if defined(PETSC_THREADCOMM_ACTIVE)
+#include <petscthreadcomm.h>
+#endif
 
 
 #undef __FUNCT__
@@ -1424,6 +1427,8 @@ PetscErrorCode MatDestroy_SeqBAIJ(Mat A)
   ierr = PetscFree(a->saved_values);CHKERRQ(ierr);
   ierr = PetscFree(a->xtoy);CHKERRQ(ierr);
   ierr = PetscFree2(a->compressedrow.i,a->compressedrow.rindex);CHKERRQ(ierr);
+  ierr = PetscFree(a->trstarts);CHKERRQ(ierr);
+  ierr = MatSeqXAIJDestroySingle_Private(A);CHKERRQ(ierr);
 
   ierr = MatDestroy(&a->sbaijMat);CHKERRQ(ierr);
   ierr = MatDestroy(&a->parent);CHKERRQ(ierr);
@@ -1433,6 +1438,7 @@ PetscErrorCode MatDestroy_SeqBAIJ(Mat A)
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatInvertBlockDiagonal_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatStoreValues_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatRetrieveValues_C","",PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunction((PetscObject)A,"MatStoreSinglePrecision_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatSeqBAIJSetColumnIndices_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatConvert_seqbaij_seqaij_C","",PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunction((PetscObject)A,"MatConvert_seqbaij_seqsbaij_C","",PETSC_NULL);CHKERRQ(ierr);
@@ -1473,6 +1479,13 @@ PetscErrorCode MatSetOption_SeqBAIJ(Mat A,MatOption op,PetscBool  flg)
   case MAT_CHECK_COMPRESSED_ROW:
     a->compressedrow.check = flg;
     break;
+  case MAT_CONCURRENT_ADD_VALUES:
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+    A->concurrentadd  = flg;
+#else
+    if (flg) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"MAT_CONCURRENT_ADD_VALUES needs atomic operations that are not available with this compiler or precision");
+#endif
+    break;
   case MAT_NEW_DIAGONALS:
   case MAT_IGNORE_OFF_PROC_ENTRIES:
   case MAT_USE_HASH_TABLE:
@@ -1961,6 +1974,85 @@ PetscErrorCode MatGetValues_SeqBAIJ(Mat A,PetscInt m,const PetscInt im[],PetscIn
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValuesBlocked_SeqBAIJ_Concurrent"
+/*
+   Adds blocks into the existing nonzero structure only, may be called by several threads at once,
+   see MAT_CONCURRENT_ADD_VALUES
+*/
+static PetscErrorCode MatSetValuesBlocked_SeqBAIJ_Concurrent(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[])
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscInt    *rp,*ai = a->i,*ailen = a->ilen,*aj = a->j;
+  PetscInt          k,l,t,ii,jj,row,col,nrow,low,high,lastcol,bs = A->rmap->bs,bs2 = a->bs2,stepval;
+  PetscBool         roworiented = a->roworiented;
+  const PetscScalar *value;
+  MatScalar         *ap,*bap,*aa = a->a;
+
+  PetscFunctionBegin;
+  if (roworiented) {
+    stepval = (n-1)*bs;
+  } else {
+    stepval = (m-1)*bs;
+  }
+  for (k=0; k<m; k++) { /* loop over added rows */
+    row  = im[k];
+    if (row < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+    if (row >= a->mbs) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row too large: row %D max %D",row,a->mbs-1);
+#endif
+    rp      = aj + ai[row];
+    ap      = aa + bs2*ai[row];
+    nrow    = ailen[row];
+    low     = 0;
+    high    = nrow;
+    lastcol = -1;
+    for (l=0; l<n; l++) { /* loop over added columns */
+      if (in[l] < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+      if (in[l] >= a->nbs) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Column too large: col %D max %D",in[l],a->nbs-1);
+#endif
+      col = in[l];
+      if (roworiented) {
+        value = v + (k*(stepval+bs) + l)*bs;
+      } else {
+        value = v + (l*(stepval+bs) + k)*bs;
+      }
+      if (col <= lastcol) low = 0; else high = nrow;
+      lastcol = col;
+      while (high-low > 7) {
+        t = (low+high)/2;
+        if (rp[t] > col) high = t;
+        else             low  = t;
+      }
+      while (low < high && rp[low] < col) low++;
+      if (low == high || rp[low] != col) {
+        if (a->nonew == 1) continue;
+        SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero block (%D, %D) is not allowed with MAT_CONCURRENT_ADD_VALUES",row,col);
+      }
+      bap = ap + bs2*low;
+      if (roworiented) {
+        for (ii=0; ii<bs; ii++,value+=stepval) {
+          for (jj=ii; jj<bs2; jj+=bs) {
+            MatAtomicAdd_Private(bap+jj,*value++);
+          }
+        }
+      } else {
+        for (ii=0; ii<bs; ii++,value+=bs+stepval) {
+          for (jj=0; jj<bs; jj++) {
+            MatAtomicAdd_Private(bap+jj,value[jj]);
+          }
+          bap += bs;
+        }
+      }
+      low++;
+    }
+  }
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatSetValuesBlocked_SeqBAIJ"
 PetscErrorCode MatSetValuesBlocked_SeqBAIJ(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
@@ -1975,6 +2067,12 @@ PetscErrorCode MatSetValuesBlocked_SeqBAIJ(Mat A,PetscInt m,const PetscInt im[],
   MatScalar         *ap,*aa = a->a,*bap;
 
   PetscFunctionBegin;
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+  if (A->concurrentadd) {
+    ierr = MatSetValuesBlocked_SeqBAIJ_Concurrent(A,m,im,n,in,v);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   if (roworiented) {
     stepval = (n-1)*bs;
   } else {
@@ -2140,6 +2238,10 @@ PetscErrorCode MatAssemblyEnd_SeqBAIJ(Mat A,MatAssemblyType mode)
 
   ierr = MatCheckCompressedRow(A,&a->compressedrow,a->i,mbs,ratio);CHKERRQ(ierr);
   A->same_nonzero = PETSC_TRUE;
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  ierr = MatSeqXAIJComputeThreadPartition(A,mbs,a->i,&a->trstarts);CHKERRQ(ierr);
+#endif
+  if (a->storesingle) {ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);}
   PetscFunctionReturn(0);
 }
 
@@ -2334,6 +2436,66 @@ PetscErrorCode MatZeroRowsColumns_SeqBAIJ(Mat A,PetscInt is_n,const PetscInt is_
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValues_SeqBAIJ_Concurrent"
+/*
+   Adds values into the existing nonzero structure only, may be called by several threads at once,
+   see MAT_CONCURRENT_ADD_VALUES
+*/
+static PetscErrorCode MatSetValues_SeqBAIJ_Concurrent(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[])
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  const PetscInt *rp,*ai = a->i,*ailen = a->ilen,*aj = a->j;
+  PetscInt       k,l,t,row,col,brow,bcol,ridx,cidx,nrow,low,high,lastcol,bs = A->rmap->bs,bs2 = a->bs2;
+  PetscBool      roworiented = a->roworiented;
+  MatScalar      *ap,value,*aa = a->a;
+
+  PetscFunctionBegin;
+  for (k=0; k<m; k++) { /* loop over added rows */
+    row  = im[k];
+    if (row < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+    if (row >= A->rmap->N) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row too large: row %D max %D",row,A->rmap->N-1);
+#endif
+    brow    = row/bs;
+    ridx    = row % bs;
+    rp      = aj + ai[brow];
+    ap      = aa + bs2*ai[brow];
+    nrow    = ailen[brow];
+    low     = 0;
+    high    = nrow;
+    lastcol = -1;
+    for (l=0; l<n; l++) { /* loop over added columns */
+      if (in[l] < 0) continue;
+#if defined(PETSC_USE_DEBUG)
+      if (in[l] >= A->cmap->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Column too large: col %D max %D",in[l],A->cmap->n-1);
+#endif
+      col = in[l]; bcol = col/bs; cidx = col % bs;
+      if (roworiented) {
+        value = v[l + k*n];
+      } else {
+        value = v[k + l*m];
+      }
+      if (bcol <= lastcol) low = 0; else high = nrow;
+      lastcol = bcol;
+      while (high-low > 7) {
+        t = (low+high)/2;
+        if (rp[t] > bcol) high = t;
+        else              low  = t;
+      }
+      while (low < high && rp[low] < bcol) low++;
+      if (low == high || rp[low] != bcol) {
+        if (a->nonew == 1) continue;
+        SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Inserting a new nonzero (%D, %D) is not allowed with MAT_CONCURRENT_ADD_VALUES",row,col);
+      }
+      MatAtomicAdd_Private(ap + bs2*low + bs*cidx + ridx,value);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatSetValues_SeqBAIJ"
 PetscErrorCode MatSetValues_SeqBAIJ(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
@@ -2348,6 +2510,12 @@ PetscErrorCode MatSetValues_SeqBAIJ(Mat A,PetscInt m,const PetscInt im[],PetscIn
   MatScalar      *ap,value,*aa=a->a,*bap;
 
   PetscFunctionBegin;
+#if defined(PETSC_USE_MAT_ATOMIC_ADD)
+  if (A->concurrentadd) {
+    ierr = MatSetValues_SeqBAIJ_Concurrent(A,m,im,n,in,v);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
   if (v) PetscValidScalarPointer(v,6);
   for (k=0; k<m; k++) { /* loop over added rows */
     row  = im[k];
@@ -2618,6 +2786,13 @@ PetscErrorCode MatAXPY_SeqBAIJ(Mat Y,PetscScalar a,Mat X,MatStructure str)
   PetscBLASInt   one=1;
 
   PetscFunctionBegin;
+  if (x->single) {
+    /* the values of X are stored in single precision, MatAXPY_SeqBAIJ_Single() has already unpacked Y */
+    ierr = MatSeqBAIJUnpackSingle_Private(X);CHKERRQ(ierr);
+    ierr = MatAXPY_SeqBAIJ(Y,a,X,str);CHKERRQ(ierr);
+    ierr = MatSeqBAIJPackSingle_Private(X);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   if (str == SAME_NONZERO_PATTERN) {
     PetscScalar alpha = a;
     PetscBLASInt bnz = PetscBLASIntCast(x->nz*bs2);
@@ -3045,7 +3220,12 @@ PetscErrorCode  MatStoreValues_SeqBAIJ(Mat mat)
   }
 
   /* copy values over */
-  ierr = PetscMemcpy(aij->saved_values,aij->a,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+  if (aij->single) {
+    PetscInt i;
+    for (i=0; i<nz; i++) aij->saved_values[i] = aij->single->a[i];
+  } else {
+    ierr = PetscMemcpy(aij->saved_values,aij->a,nz*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
   PetscFunctionReturn(0);
 }
 EXTERN_C_END
@@ -3062,6 +3242,7 @@ PetscErrorCode  MatRetrieveValues_SeqBAIJ(Mat mat)
   PetscFunctionBegin;
   if (aij->nonew != 1) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ORDER,"Must call MatSetOption(A,MAT_NEW_NONZERO_LOCATIONS,PETSC_FALSE);first");
   if (!aij->saved_values) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ORDER,"Must call MatStoreValues(A);first");
+  ierr = MatSeqBAIJUnpackSingle_Private(mat);CHKERRQ(ierr);
 
   /* copy values over */
   ierr = PetscMemcpy(aij->a,aij->saved_values,nz*sizeof(PetscScalar));CHKERRQ(ierr);
@@ -3082,6 +3263,9 @@ PetscErrorCode  MatSeqBAIJSetPreallocation_SeqBAIJ(Mat B,PetscInt bs,PetscInt nz
   Mat_SeqBAIJ    *b;
   PetscErrorCode ierr;
   PetscInt       i,mbs,nbs,bs2;
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  PetscInt       nthreads;
+#endif
   PetscBool      flg,skipallocation = PETSC_FALSE,realalloc = PETSC_FALSE;
 
   PetscFunctionBegin;
@@ -3115,6 +3299,7 @@ PetscErrorCode  MatSeqBAIJSetPreallocation_SeqBAIJ(Mat B,PetscInt bs,PetscInt nz
   }
 
   b       = (Mat_SeqBAIJ*)B->data;
+  ierr = MatSeqBAIJUnpackSingle_Private(B);CHKERRQ(ierr);
   ierr = PetscOptionsBegin(((PetscObject)B)->comm,PETSC_NULL,"Optimize options for SEQBAIJ matrix 2 ","Mat");CHKERRQ(ierr);
     ierr = PetscOptionsBool("-mat_no_unroll","Do not optimize for block size (slow)",PETSC_NULL,PETSC_FALSE,&flg,PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscOptionsEnd();CHKERRQ(ierr);
@@ -3156,10 +3341,50 @@ PetscErrorCode  MatSeqBAIJSetPreallocation_SeqBAIJ(Mat B,PetscInt bs,PetscInt nz
       B->ops->multadd         = MatMultAdd_SeqBAIJ_7;
       B->ops->sor             = MatSOR_SeqBAIJ_7;
       break;
+    case 8:
+      B->ops->mult            = MatMult_SeqBAIJ_8;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_8;
+      B->ops->sor             = MatSOR_SeqBAIJ_8;
+      break;
+    case 9:
+      B->ops->mult            = MatMult_SeqBAIJ_9;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_9;
+      B->ops->sor             = MatSOR_SeqBAIJ_9;
+      break;
+    case 10:
+      B->ops->mult            = MatMult_SeqBAIJ_10;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_10;
+      B->ops->sor             = MatSOR_SeqBAIJ_10;
+      break;
+    case 11:
+      B->ops->mult            = MatMult_SeqBAIJ_11;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_11;
+      B->ops->sor             = MatSOR_SeqBAIJ_11;
+      break;
+    case 12:
+      B->ops->mult            = MatMult_SeqBAIJ_12;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_12;
+      B->ops->sor             = MatSOR_SeqBAIJ_12;
+      break;
+    case 13:
+      B->ops->mult            = MatMult_SeqBAIJ_13;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_13;
+      B->ops->sor             = MatSOR_SeqBAIJ_13;
+      break;
+    case 14:
+      B->ops->mult            = MatMult_SeqBAIJ_14;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_14;
+      B->ops->sor             = MatSOR_SeqBAIJ_14;
+      break;
     case 15:
       B->ops->mult            = MatMult_SeqBAIJ_15_ver1;
-      B->ops->multadd         = MatMultAdd_SeqBAIJ_N;
-      B->ops->sor             = MatSOR_SeqBAIJ_N;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_15;
+      B->ops->sor             = MatSOR_SeqBAIJ_15;
+      break;
+    case 16:
+      B->ops->mult            = MatMult_SeqBAIJ_16;
+      B->ops->multadd         = MatMultAdd_SeqBAIJ_16;
+      B->ops->sor             = MatSOR_SeqBAIJ_16;
       break;
     default:
       B->ops->mult            = MatMult_SeqBAIJ_N;
@@ -3168,6 +3393,15 @@ PetscErrorCode  MatSeqBAIJSetPreallocation_SeqBAIJ(Mat B,PetscInt bs,PetscInt nz
       break;
     }
   }
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  /* with more than one thread the products are split between the threads with the nonzero balanced partition,
+     at the cost of using one kernel for all block sizes */
+  ierr = PetscThreadCommGetNThreads(((PetscObject)B)->comm,&nthreads);CHKERRQ(ierr);
+  if (nthreads > 1) {
+    B->ops->mult    = MatMult_SeqBAIJ_Threaded;
+    B->ops->multadd = MatMultAdd_SeqBAIJ_Threaded;
+  }
+#endif
   b->mbs       = mbs;
   b->nbs       = nbs;
   if (!skipallocation) {
@@ -3345,6 +3579,9 @@ PetscErrorCode  MatCreate_SeqBAIJ(Mat B)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatRetrieveValues_C",
                                      "MatRetrieveValues_SeqBAIJ",
                                       MatRetrieveValues_SeqBAIJ);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatStoreSinglePrecision_C",
+                                     "MatStoreSinglePrecision_SeqBAIJ",
+                                      MatStoreSinglePrecision_SeqBAIJ);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)B,"MatSeqBAIJSetColumnIndices_C",
                                      "MatSeqBAIJSetColumnIndices_SeqBAIJ",
                                       MatSeqBAIJSetColumnIndices_SeqBAIJ);CHKERRQ(ierr);
@@ -3408,6 +3645,7 @@ PetscErrorCode MatDuplicateNoCreate_SeqBAIJ(Mat C,Mat A,MatDuplicateOption cpval
       c->free_a       = PETSC_TRUE;
       c->free_ij      = PETSC_FALSE;
       c->parent       = A;
+      a->shared_ij    = PETSC_TRUE;
       C->preallocated = PETSC_TRUE;
       C->assembled    = PETSC_TRUE;
       ierr = PetscObjectReference((PetscObject)A);CHKERRQ(ierr);
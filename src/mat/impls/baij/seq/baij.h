@@ -32,7 +32,10 @@ typedef struct {
 
 EXTERN_C_BEGIN
 extern PetscErrorCode MatSeqBAIJSetPreallocation_SeqBAIJ(Mat,PetscInt,PetscInt,PetscInt*);
+extern PetscErrorCode MatStoreSinglePrecision_SeqBAIJ(Mat,PetscBool);
 EXTERN_C_END
+extern PetscErrorCode MatSeqBAIJPackSingle_Private(Mat);
+extern PetscErrorCode MatSeqBAIJUnpackSingle_Private(Mat);
 extern PetscErrorCode MatILUFactorSymbolic_SeqBAIJ_inplace(Mat,Mat,IS,IS,const MatFactorInfo*);
 extern PetscErrorCode MatILUFactorSymbolic_SeqBAIJ(Mat,Mat,IS,IS,const MatFactorInfo*);
 extern PetscErrorCode MatICCFactorSymbolic_SeqBAIJ(Mat,Mat,IS,const MatFactorInfo*);
@@ -212,6 +215,29 @@ extern PetscErrorCode MatMultAdd_SeqBAIJ_5(Mat,Vec,Vec,Vec);
 extern PetscErrorCode MatMultAdd_SeqBAIJ_6(Mat,Vec,Vec,Vec);
 extern PetscErrorCode MatMultAdd_SeqBAIJ_7(Mat,Vec,Vec,Vec);
 extern PetscErrorCode MatMultAdd_SeqBAIJ_N(Mat,Vec,Vec,Vec);
+
+/* kernels for the block sizes 8 to 16, generated from baijbs.h in baijbs.c */
+#define MatSeqBAIJDeclareKernels(bs) \
+extern PetscErrorCode MatMult_SeqBAIJ_##bs(Mat,Vec,Vec); \
+extern PetscErrorCode MatMultAdd_SeqBAIJ_##bs(Mat,Vec,Vec,Vec); \
+extern PetscErrorCode MatSOR_SeqBAIJ_##bs(Mat,Vec,PetscReal,MatSORType,PetscReal,PetscInt,PetscInt,Vec); \
+extern PetscErrorCode MatSolve_SeqBAIJ_##bs(Mat,Vec,Vec); \
+extern PetscErrorCode MatSolve_SeqBAIJ_##bs##_NaturalOrdering(Mat,Vec,Vec); \
+extern PetscErrorCode MatLUFactorNumeric_SeqBAIJ_##bs(Mat,Mat,const MatFactorInfo*)
+MatSeqBAIJDeclareKernels(8);
+MatSeqBAIJDeclareKernels(9);
+MatSeqBAIJDeclareKernels(10);
+MatSeqBAIJDeclareKernels(11);
+MatSeqBAIJDeclareKernels(12);
+MatSeqBAIJDeclareKernels(13);
+MatSeqBAIJDeclareKernels(14);
+MatSeqBAIJDeclareKernels(15);
+MatSeqBAIJDeclareKernels(16);
+
+#if defined(PETSC_THREADCOMM_ACTIVE)
+extern PetscErrorCode MatMult_SeqBAIJ_Threaded(Mat,Vec,Vec);
+extern PetscErrorCode MatMultAdd_SeqBAIJ_Threaded(Mat,Vec,Vec,Vec);
+#endif
 extern PetscErrorCode MatLoad_SeqBAIJ(Mat,PetscViewer);
 extern PetscErrorCode MatSeqBAIJSetNumericFactorization_inplace(Mat,PetscBool );
 extern PetscErrorCode MatSeqBAIJSetNumericFactorization(Mat,PetscBool );
@@ -3,6 +3,9 @@
 #include <../src/mat/blockinvert.h>
 #include <petscbt.h>
 #include <petscblaslapack.h>
+#if defined(PETSC_THREADCOMM_ACTIVE)
+#include <petscthreadcomm.h>
+#endif
 
 #undef __FUNCT__
 #define __FUNCT__ "MatIncreaseOverlap_SeqBAIJ"
@@ -1561,6 +1564,101 @@ PetscErrorCode MatMultAdd_SeqBAIJ_N(Mat A,Vec xx,Vec yy,Vec zz)
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_THREADCOMM_ACTIVE)
+/*
+   Threaded z = y + A x (z = A x when y is PETSC_NULL) for any block size, each thread working on the
+   block rows a->trstarts[thread_id] to a->trstarts[thread_id+1] that have about the same number of blocks
+*/
+PetscErrorCode MatMultAdd_SeqBAIJ_Kernel(PetscInt thread_id,Mat A,const PetscScalar *x,const PetscScalar *y,PetscScalar *z)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscInt    *ai = a->i,*aj = a->j,*idx,bs = A->rmap->bs,bs2 = a->bs2;
+  const MatScalar   *v;
+  const PetscScalar *xb;
+  PetscScalar       *zb,sum,xv;
+  PetscInt          i,j,k,r,n,start,end;
+
+  start = a->trstarts[thread_id];
+  end   = a->trstarts[thread_id+1];
+  if (bs == 1) {
+    for (i=start; i<end; i++) {
+      n   = ai[i+1] - ai[i];
+      idx = aj + ai[i];
+      v   = a->a + ai[i];
+      sum = y ? y[i] : 0.0;
+      PetscSparseDensePlusDot(sum,x,v,idx,n);
+      z[i] = sum;
+    }
+    return 0;
+  }
+  for (i=start; i<end; i++) {
+    zb = z + bs*i;
+    if (y) {
+      if (y != z) for (r=0; r<bs; r++) zb[r] = y[bs*i+r];
+    } else {
+      for (r=0; r<bs; r++) zb[r] = 0.0;
+    }
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      xb = x + bs*aj[j];
+      v  = a->a + bs2*j;
+      for (k=0; k<bs; k++) { /* the blocks are stored by columns */
+        xv = xb[k];
+        for (r=0; r<bs; r++) zb[r] += v[r]*xv;
+        v += bs;
+      }
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqBAIJ_Threaded"
+PetscErrorCode MatMult_SeqBAIJ_Threaded(Mat A,Vec xx,Vec zz)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,a->mbs,a->i,&a->trstarts);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqBAIJ_Kernel,4,A,x,PETSC_NULL,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz*a->bs2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqBAIJ_Threaded"
+PetscErrorCode MatMultAdd_SeqBAIJ_Threaded(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscScalar *x,*y;
+  PetscScalar       *z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,a->mbs,a->i,&a->trstarts);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy != zz) {
+    ierr = VecGetArrayRead(yy,&y);CHKERRQ(ierr);
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  } else {
+    ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+    y    = z;
+  }
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatMultAdd_SeqBAIJ_Kernel,4,A,x,y,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  if (yy != zz) {ierr = VecRestoreArrayRead(yy,&y);CHKERRQ(ierr);}
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz*a->bs2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatMultHermitianTranspose_SeqBAIJ"
 PetscErrorCode MatMultHermitianTranspose_SeqBAIJ(Mat A,Vec xx,Vec zz)
@@ -1966,6 +2064,13 @@ PetscErrorCode MatEqual_SeqBAIJ(Mat A,Mat B,PetscBool * flg)
     *flg = PETSC_FALSE;
     PetscFunctionReturn(0);
   }
+  if (b->single) {
+    /* the values of B are stored in single precision, MatEqual_SeqBAIJ_Single() has already unpacked A */
+    ierr = MatSeqBAIJUnpackSingle_Private(B);CHKERRQ(ierr);
+    ierr = MatEqual_SeqBAIJ(A,B,flg);CHKERRQ(ierr);
+    ierr = MatSeqBAIJPackSingle_Private(B);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
 
   /* if the a->i are the same */
   ierr = PetscMemcmp(a->i,b->i,(a->mbs+1)*sizeof(PetscInt),flg);CHKERRQ(ierr);
@@ -1984,40 +2089,75 @@ PetscErrorCode MatEqual_SeqBAIJ(Mat A,Mat B,PetscBool * flg)
 
 }
 
+#if defined(PETSC_THREADCOMM_ACTIVE)
+PetscErrorCode MatGetDiagonal_SeqBAIJ_Kernel(PetscInt thread_id,Mat A,PetscScalar *x)
+{
+  Mat_SeqBAIJ     *a = (Mat_SeqBAIJ*)A->data;
+  const PetscInt  *ai = a->i,*aj = a->j,bs = A->rmap->bs,bs2 = a->bs2;
+  const MatScalar *aa_j;
+  PetscInt        i,j,k,row,start,end;
+
+  start = a->trstarts[thread_id];
+  end   = a->trstarts[thread_id+1];
+  for (i=start; i<end; i++) {
+    for (k=0; k<bs; k++) x[i*bs+k] = 0.0;
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      if (aj[j] == i) {
+        row  = i*bs;
+        aa_j = a->a+j*bs2;
+        for (k=0; k<bs2; k+=(bs+1),row++) x[row] = aa_j[k];
+        break;
+      }
+    }
+  }
+  return 0;
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "MatGetDiagonal_SeqBAIJ"
 PetscErrorCode MatGetDiagonal_SeqBAIJ(Mat A,Vec v)
 {
   Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
   PetscErrorCode ierr;
-  PetscInt       i,j,k,n,row,bs,*ai,*aj,ambs,bs2;
-  PetscScalar    *x,zero = 0.0;
-  MatScalar      *aa,*aa_j;
+  PetscInt       n,*ai,ambs;
+  PetscScalar    *x;
 
   PetscFunctionBegin;
   if (A->factortype) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Not for factored matrix");
-  bs   = A->rmap->bs;
-  aa   = a->a;
   ai   = a->i;
-  aj   = a->j;
   ambs = a->mbs;
-  bs2  = a->bs2;
 
-  ierr = VecSet(v,zero);CHKERRQ(ierr);
-  ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+#if defined(PETSC_THREADCOMM_ACTIVE)
   ierr = VecGetLocalSize(v,&n);CHKERRQ(ierr);
   if (n != A->rmap->N) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Nonconforming matrix and vector");
-  for (i=0; i<ambs; i++) {
-    for (j=ai[i]; j<ai[i+1]; j++) {
-      if (aj[j] == i) {
-        row  = i*bs;
-        aa_j = aa+j*bs2;
-        for (k=0; k<bs2; k+=(bs+1),row++) x[row] = aa_j[k];
-        break;
+  if (!a->trstarts) {ierr = MatSeqXAIJComputeThreadPartition(A,ambs,ai,&a->trstarts);CHKERRQ(ierr);}
+  ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+  ierr = PetscThreadCommRunKernel(((PetscObject)A)->comm,(PetscThreadKernel)MatGetDiagonal_SeqBAIJ_Kernel,2,A,x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+#else
+  {
+    PetscInt    i,j,k,row,bs = A->rmap->bs,*aj = a->j,bs2 = a->bs2;
+    PetscScalar zero = 0.0;
+    MatScalar   *aa = a->a,*aa_j;
+
+    ierr = VecSet(v,zero);CHKERRQ(ierr);
+    ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+    ierr = VecGetLocalSize(v,&n);CHKERRQ(ierr);
+    if (n != A->rmap->N) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Nonconforming matrix and vector");
+    for (i=0; i<ambs; i++) {
+      for (j=ai[i]; j<ai[i+1]; j++) {
+        if (aj[j] == i) {
+          row  = i*bs;
+          aa_j = aa+j*bs2;
+          for (k=0; k<bs2; k+=(bs+1),row++) x[row] = aa_j[k];
+          break;
+        }
       }
     }
+    ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
   }
-  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+#endif
   PetscFunctionReturn(0);
 }
 
@@ -0,0 +1,26 @@
+
+/*
+    Products, SOR, triangular solves and LU factorization for BAIJ format with the block sizes 8 to 16,
+    generated from baijbs.h; the block sizes 1 to 7 have hand written kernels.
+*/
+#include <../src/mat/impls/baij/seq/baij.h>
+#include <../src/mat/blockinvert.h>
+
+#define BS 8
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 9
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 10
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 11
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 12
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 13
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 14
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 15
+#include <../src/mat/impls/baij/seq/baijbs.h>
+#define BS 16
+#include <../src/mat/impls/baij/seq/baijbs.h>
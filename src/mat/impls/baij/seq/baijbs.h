@@ -0,0 +1,483 @@
+
+/*
+     Defines MatMult_SeqBAIJ_BS(), MatMultAdd_SeqBAIJ_BS(), MatSOR_SeqBAIJ_BS(), MatSolve_SeqBAIJ_BS(),
+     MatSolve_SeqBAIJ_BS_NaturalOrdering() and MatLUFactorNumeric_SeqBAIJ_BS() for the block sizes that
+     have no hand written kernels. This is included by baijbs.c with different values for BS.
+
+     The block size is a compile time constant so the compiler fully unrolls, and where it can vectorizes,
+     the loops over a block; the blocks are stored by columns so the innermost loops run over contiguous
+     entries of the block and of the result.
+*/
+#define PETSCMAP1_a(a,b)  a ## _ ## b
+#define PETSCMAP1_b(a,b)  PETSCMAP1_a(a,b)
+#define PETSCMAP1(a)      PETSCMAP1_b(a,BS)
+#define PETSCMAP2_a(a,b)  a ## _ ## b ## _NaturalOrdering
+#define PETSCMAP2_b(a,b)  PETSCMAP2_a(a,b)
+#define PETSCMAP2(a)      PETSCMAP2_b(a,BS)
+#define BS2               (BS*BS)
+
+/*
+   z = z + A x and z = z - A x; the even and odd columns go to separate sums so the additions do not all
+   wait on each other
+*/
+PETSC_STATIC_INLINE void PETSCMAP1(MatSeqBAIJBlockMultAdd)(PetscScalar *z,const MatScalar *v,const PetscScalar *x)
+{
+  PetscScalar t0[BS],t1[BS];
+  PetscInt    r,c;
+
+  for (r=0; r<BS; r++) {t0[r] = 0.0; t1[r] = 0.0;}
+  for (c=0; c<BS-1; c+=2) {
+    for (r=0; r<BS; r++) {
+      t0[r] += v[r+BS*c]*x[c];
+      t1[r] += v[r+BS*(c+1)]*x[c+1];
+    }
+  }
+  if (BS%2) {
+    for (r=0; r<BS; r++) t0[r] += v[r+BS*(BS-1)]*x[BS-1];
+  }
+  for (r=0; r<BS; r++) z[r] += t0[r] + t1[r];
+}
+
+PETSC_STATIC_INLINE void PETSCMAP1(MatSeqBAIJBlockMultSub)(PetscScalar *z,const MatScalar *v,const PetscScalar *x)
+{
+  PetscScalar t[BS];
+  PetscInt    r;
+
+  for (r=0; r<BS; r++) t[r] = 0.0;
+  PETSCMAP1(MatSeqBAIJBlockMultAdd)(t,v,x);
+  for (r=0; r<BS; r++) z[r] -= t[r];
+}
+
+/* z = A x */
+PETSC_STATIC_INLINE void PETSCMAP1(MatSeqBAIJBlockMult)(PetscScalar *z,const MatScalar *v,const PetscScalar *x)
+{
+  PetscInt r;
+
+  for (r=0; r<BS; r++) z[r] = 0.0;
+  PETSCMAP1(MatSeqBAIJBlockMultAdd)(z,v,x);
+}
+
+/* C = A B */
+PETSC_STATIC_INLINE void PETSCMAP1(MatSeqBAIJBlockMatMult)(MatScalar *C,const MatScalar *A,const MatScalar *B)
+{
+  PetscInt r,c,k;
+
+  for (c=0; c<BS; c++) {
+    for (r=0; r<BS; r++) C[r+BS*c] = 0.0;
+    for (k=0; k<BS; k++) {
+      for (r=0; r<BS; r++) C[r+BS*c] += A[r+BS*k]*B[k+BS*c];
+    }
+  }
+}
+
+/* C = C - A B */
+PETSC_STATIC_INLINE void PETSCMAP1(MatSeqBAIJBlockMatMultSub)(MatScalar *C,const MatScalar *A,const MatScalar *B)
+{
+  PetscInt r,c,k;
+
+  for (c=0; c<BS; c++) {
+    for (k=0; k<BS; k++) {
+      for (r=0; r<BS; r++) C[r+BS*c] -= A[r+BS*k]*B[k+BS*c];
+    }
+  }
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqBAIJ_" PetscStringize(BS)
+PetscErrorCode PETSCMAP1(MatMult_SeqBAIJ)(Mat A,Vec xx,Vec zz)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *z,*zarray,sum[BS];
+  const MatScalar   *v = a->a;
+  const PetscInt    *idx = a->j,*ii,*ridx = PETSC_NULL;
+  PetscInt          mbs,i,j,n,r,nonzerorow = 0;
+  PetscBool         usecprow = a->compressedrow.use;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&zarray);CHKERRQ(ierr);
+  if (usecprow) {
+    mbs  = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+    ierr = PetscMemzero(zarray,A->rmap->n*sizeof(PetscScalar));CHKERRQ(ierr);
+  } else {
+    mbs = a->mbs;
+    ii  = a->i;
+  }
+  for (i=0; i<mbs; i++) {
+    n = ii[i+1] - ii[i];
+    nonzerorow += (n>0);
+    for (r=0; r<BS; r++) sum[r] = 0.0;
+    for (j=0; j<n; j++) {
+      PETSCMAP1(MatSeqBAIJBlockMultAdd)(sum,v,x+BS*idx[j]);
+      v += BS2;
+    }
+    idx += n;
+    z    = zarray + BS*(usecprow ? ridx[i] : i);
+    for (r=0; r<BS; r++) z[r] = sum[r];
+  }
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&zarray);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz*BS2 - BS*nonzerorow);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqBAIJ_" PetscStringize(BS)
+PetscErrorCode PETSCMAP1(MatMultAdd_SeqBAIJ)(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscScalar *x;
+  PetscScalar       *z,*zarray,sum[BS];
+  const MatScalar   *v = a->a;
+  const PetscInt    *idx = a->j,*ii,*ridx = PETSC_NULL;
+  PetscInt          mbs,i,j,n,r;
+  PetscBool         usecprow = a->compressedrow.use;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (yy != zz) {ierr = VecCopy(yy,zz);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&zarray);CHKERRQ(ierr);
+  if (usecprow) {
+    mbs  = a->compressedrow.nrows;
+    ii   = a->compressedrow.i;
+    ridx = a->compressedrow.rindex;
+  } else {
+    mbs = a->mbs;
+    ii  = a->i;
+  }
+  for (i=0; i<mbs; i++) {
+    n    = ii[i+1] - ii[i];
+    z    = zarray + BS*(usecprow ? ridx[i] : i);
+    for (r=0; r<BS; r++) sum[r] = z[r];
+    for (j=0; j<n; j++) {
+      PETSCMAP1(MatSeqBAIJBlockMultAdd)(sum,v,x+BS*idx[j]);
+      v += BS2;
+    }
+    idx += n;
+    for (r=0; r<BS; r++) z[r] = sum[r];
+  }
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&zarray);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz*BS2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSOR_SeqBAIJ_" PetscStringize(BS)
+/* point block SOR with the restrictions of MatSOR_SeqBAIJ_N(), except that a nonzero initial guess is supported */
+PetscErrorCode PETSCMAP1(MatSOR_SeqBAIJ)(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscReal fshift,PetscInt its,PetscInt lits,Vec xx)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalar   *aa = a->a,*v,*idiag,*mdiag;
+  const PetscScalar *b;
+  PetscScalar       *x,w[BS];
+  const PetscInt    *ai = a->i,*aj = a->j,*diag,m = a->mbs;
+  PetscInt          i,j,r;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  its = its*lits;
+  if (flag & SOR_EISENSTAT) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support yet for Eisenstat");
+  if (its <= 0) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Relaxation requires global its %D and local its %D both positive",its,lits);
+  if (fshift) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for diagonal shift");
+  if (omega != 1.0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for non-trivial relaxation factor");
+  if ((flag & SOR_APPLY_UPPER) || (flag & SOR_APPLY_LOWER)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for applying upper or lower triangular parts");
+  if (its > 1) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support yet for multiple point block SOR iterations");
+
+  if (!a->idiagvalid) {ierr = MatInvertBlockDiagonal(A,PETSC_NULL);CHKERRQ(ierr);}
+  diag = a->diag;
+
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+
+  if (!(flag & SOR_ZERO_INITIAL_GUESS)) {
+    /* the sweeps use the current values of x in all the off-diagonal blocks */
+    if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+      idiag = a->idiag;
+      for (i=0; i<m; i++) {
+        for (r=0; r<BS; r++) w[r] = b[BS*i+r];
+        v = aa + BS2*ai[i];
+        for (j=ai[i]; j<ai[i+1]; j++) {
+          if (j != diag[i]) PETSCMAP1(MatSeqBAIJBlockMultSub)(w,v,x+BS*aj[j]);
+          v += BS2;
+        }
+        PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,idiag,w);
+        idiag += BS2;
+      }
+      ierr = PetscLogFlops(2.0*BS2*a->nz);CHKERRQ(ierr);
+    }
+    if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+      idiag = a->idiag + BS2*(m-1);
+      for (i=m-1; i>=0; i--) {
+        for (r=0; r<BS; r++) w[r] = b[BS*i+r];
+        v = aa + BS2*ai[i];
+        for (j=ai[i]; j<ai[i+1]; j++) {
+          if (j != diag[i]) PETSCMAP1(MatSeqBAIJBlockMultSub)(w,v,x+BS*aj[j]);
+          v += BS2;
+        }
+        PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,idiag,w);
+        idiag -= BS2;
+      }
+      ierr = PetscLogFlops(2.0*BS2*a->nz);CHKERRQ(ierr);
+    }
+    ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
+  if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+    idiag = a->idiag;
+    for (i=0; i<m; i++) {
+      for (r=0; r<BS; r++) w[r] = b[BS*i+r];
+      v = aa + BS2*ai[i];
+      for (j=ai[i]; j<diag[i]; j++) {
+        PETSCMAP1(MatSeqBAIJBlockMultSub)(w,v,x+BS*aj[j]);
+        v += BS2;
+      }
+      PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,idiag,w);
+      idiag += BS2;
+    }
+    ierr = PetscLogFlops(1.0*BS2*a->nz);CHKERRQ(ierr);
+  }
+  if ((flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) &&
+      (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP)) {
+    mdiag = a->idiag + BS2*m;
+    for (i=0; i<m; i++) {
+      for (r=0; r<BS; r++) w[r] = x[BS*i+r];
+      PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,mdiag,w);
+      mdiag += BS2;
+    }
+    ierr = PetscLogFlops(2.0*BS*(BS-1)*m);CHKERRQ(ierr);
+  } else if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+    ierr = PetscMemcpy(x,b,A->rmap->n*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+  if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+    idiag = a->idiag + BS2*(m-1);
+    for (i=m-1; i>=0; i--) {
+      for (r=0; r<BS; r++) w[r] = x[BS*i+r];
+      v = aa + BS2*(diag[i]+1);
+      for (j=diag[i]+1; j<ai[i+1]; j++) {
+        PETSCMAP1(MatSeqBAIJBlockMultSub)(w,v,x+BS*aj[j]);
+        v += BS2;
+      }
+      PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,idiag,w);
+      idiag -= BS2;
+    }
+    ierr = PetscLogFlops(1.0*BS2*a->nz);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolve_SeqBAIJ_" PetscStringize(BS) "_NaturalOrdering"
+PetscErrorCode PETSCMAP2(MatSolve_SeqBAIJ)(Mat A,Vec bb,Vec xx)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  const PetscInt    *ai = a->i,*aj = a->j,*adiag = a->diag,*vi,n = a->mbs;
+  const MatScalar   *aa = a->a,*v;
+  const PetscScalar *b;
+  PetscScalar       *x,s[BS];
+  PetscInt          i,k,r,nz;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+
+  /* forward solve the lower triangular */
+  for (i=0; i<n; i++) {
+    v  = aa + BS2*ai[i];
+    vi = aj + ai[i];
+    nz = ai[i+1] - ai[i];
+    for (r=0; r<BS; r++) s[r] = b[BS*i+r];
+    for (k=0; k<nz; k++) {
+      PETSCMAP1(MatSeqBAIJBlockMultSub)(s,v,x+BS*vi[k]);
+      v += BS2;
+    }
+    for (r=0; r<BS; r++) x[BS*i+r] = s[r];
+  }
+
+  /* backward solve the upper triangular, the diagonal blocks are stored inverted */
+  for (i=n-1; i>=0; i--) {
+    v  = aa + BS2*(adiag[i+1]+1);
+    vi = aj + adiag[i+1]+1;
+    nz = adiag[i] - adiag[i+1] - 1;
+    for (r=0; r<BS; r++) s[r] = x[BS*i+r];
+    for (k=0; k<nz; k++) {
+      PETSCMAP1(MatSeqBAIJBlockMultSub)(s,v,x+BS*vi[k]);
+      v += BS2;
+    }
+    PETSCMAP1(MatSeqBAIJBlockMult)(x+BS*i,aa+BS2*adiag[i],s);
+  }
+
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*BS2*a->nz - BS*A->cmap->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolve_SeqBAIJ_" PetscStringize(BS)
+PetscErrorCode PETSCMAP1(MatSolve_SeqBAIJ)(Mat A,Vec bb,Vec xx)
+{
+  Mat_SeqBAIJ       *a = (Mat_SeqBAIJ*)A->data;
+  IS                iscol = a->col,isrow = a->row;
+  const PetscInt    *r,*c,*ai = a->i,*aj = a->j,*adiag = a->diag,*vi,n = a->mbs;
+  const MatScalar   *aa = a->a,*v;
+  const PetscScalar *b;
+  PetscScalar       *x,*t,s[BS];
+  PetscInt          i,k,p,nz;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = ISGetIndices(isrow,&r);CHKERRQ(ierr);
+  ierr = ISGetIndices(iscol,&c);CHKERRQ(ierr);
+  t    = a->solve_work;
+
+  /* forward solve the lower triangular */
+  for (i=0; i<n; i++) {
+    v  = aa + BS2*ai[i];
+    vi = aj + ai[i];
+    nz = ai[i+1] - ai[i];
+    for (p=0; p<BS; p++) s[p] = b[BS*r[i]+p];
+    for (k=0; k<nz; k++) {
+      PETSCMAP1(MatSeqBAIJBlockMultSub)(s,v,t+BS*vi[k]);
+      v += BS2;
+    }
+    for (p=0; p<BS; p++) t[BS*i+p] = s[p];
+  }
+
+  /* backward solve the upper triangular, the diagonal blocks are stored inverted */
+  for (i=n-1; i>=0; i--) {
+    v  = aa + BS2*(adiag[i+1]+1);
+    vi = aj + adiag[i+1]+1;
+    nz = adiag[i] - adiag[i+1] - 1;
+    for (p=0; p<BS; p++) s[p] = t[BS*i+p];
+    for (k=0; k<nz; k++) {
+      PETSCMAP1(MatSeqBAIJBlockMultSub)(s,v,t+BS*vi[k]);
+      v += BS2;
+    }
+    PETSCMAP1(MatSeqBAIJBlockMult)(t+BS*i,aa+BS2*adiag[i],s);
+    for (p=0; p<BS; p++) x[BS*c[i]+p] = t[BS*i+p];
+  }
+
+  ierr = ISRestoreIndices(isrow,&r);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(iscol,&c);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*BS2*a->nz - BS*A->cmap->n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatLUFactorNumeric_SeqBAIJ_" PetscStringize(BS)
+/* the same algorithm as MatLUFactorNumeric_SeqBAIJ_N(), for any ordering */
+PetscErrorCode PETSCMAP1(MatLUFactorNumeric_SeqBAIJ)(Mat B,Mat A,const MatFactorInfo *info)
+{
+  Mat             C = B;
+  Mat_SeqBAIJ     *a = (Mat_SeqBAIJ*)A->data,*b = (Mat_SeqBAIJ*)C->data;
+  IS              isrow = b->row,isicol = b->icol;
+  const PetscInt  *r,*ic,*ai = a->i,*aj = a->j,*bi = b->i,*bj = b->j,*bdiag = b->diag,*ajtmp,*bjtmp,*pj;
+  PetscInt        i,j,k,n = a->mbs,nz,nzL,row,flg,v_pivots[BS];
+  MatScalar       *rtmp,*pc,*pv,mwork[BS2],v_work[BS];
+  const MatScalar *v,*aa = a->a;
+  PetscBool       row_identity,col_identity;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  ierr = ISGetIndices(isrow,&r);CHKERRQ(ierr);
+  ierr = ISGetIndices(isicol,&ic);CHKERRQ(ierr);
+  ierr = PetscMalloc(BS2*n*sizeof(MatScalar),&rtmp);CHKERRQ(ierr);
+  ierr = PetscMemzero(rtmp,BS2*n*sizeof(MatScalar));CHKERRQ(ierr);
+
+  for (i=0; i<n; i++) {
+    /* zero rtmp in the L and U parts of the row */
+    nz    = bi[i+1] - bi[i];
+    bjtmp = bj + bi[i];
+    for (j=0; j<nz; j++) {ierr = PetscMemzero(rtmp+BS2*bjtmp[j],BS2*sizeof(MatScalar));CHKERRQ(ierr);}
+    nz    = bdiag[i] - bdiag[i+1];
+    bjtmp = bj + bdiag[i+1]+1;
+    for (j=0; j<nz; j++) {ierr = PetscMemzero(rtmp+BS2*bjtmp[j],BS2*sizeof(MatScalar));CHKERRQ(ierr);}
+
+    /* load in initial (unfactored row) */
+    nz    = ai[r[i]+1] - ai[r[i]];
+    ajtmp = aj + ai[r[i]];
+    v     = aa + BS2*ai[r[i]];
+    for (j=0; j<nz; j++) {ierr = PetscMemcpy(rtmp+BS2*ic[ajtmp[j]],v+BS2*j,BS2*sizeof(MatScalar));CHKERRQ(ierr);}
+
+    /* elimination */
+    bjtmp = bj + bi[i];
+    nzL   = bi[i+1] - bi[i];
+    for (k=0; k<nzL; k++) {
+      row = bjtmp[k];
+      pc  = rtmp + BS2*row;
+      for (flg=0,j=0; j<BS2; j++) {
+        if (pc[j] != 0.0) {flg = 1; break;}
+      }
+      if (flg) {
+        /* pc = pc * inv(diagonal[row]) */
+        PETSCMAP1(MatSeqBAIJBlockMatMult)(mwork,pc,b->a+BS2*bdiag[row]);
+        ierr = PetscMemcpy(pc,mwork,BS2*sizeof(MatScalar));CHKERRQ(ierr);
+        pj = b->j + bdiag[row+1]+1;
+        pv = b->a + BS2*(bdiag[row+1]+1);
+        nz = bdiag[row] - bdiag[row+1] - 1;
+        for (j=0; j<nz; j++) {
+          PETSCMAP1(MatSeqBAIJBlockMatMultSub)(rtmp+BS2*pj[j],pc,pv+BS2*j);
+        }
+        ierr = PetscLogFlops(2.0*BS2*BS*(nz+1)-BS2);CHKERRQ(ierr);
+      }
+    }
+
+    /* finished row so stick it into b->a: the L part */
+    pv = b->a + BS2*bi[i];
+    pj = b->j + bi[i];
+    nz = bi[i+1] - bi[i];
+    for (j=0; j<nz; j++) {ierr = PetscMemcpy(pv+BS2*j,rtmp+BS2*pj[j],BS2*sizeof(MatScalar));CHKERRQ(ierr);}
+
+    /* the inverted diagonal for simpler triangular solves */
+    pv   = b->a + BS2*bdiag[i];
+    pj   = b->j + bdiag[i];
+    ierr = PetscMemcpy(pv,rtmp+BS2*pj[0],BS2*sizeof(MatScalar));CHKERRQ(ierr);
+    ierr = PetscKernel_A_gets_inverse_A(BS,pv,v_pivots,v_work);CHKERRQ(ierr);
+
+    /* the U part */
+    pv = b->a + BS2*(bdiag[i+1]+1);
+    pj = b->j + bdiag[i+1]+1;
+    nz = bdiag[i] - bdiag[i+1] - 1;
+    for (j=0; j<nz; j++) {ierr = PetscMemcpy(pv+BS2*j,rtmp+BS2*pj[j],BS2*sizeof(MatScalar));CHKERRQ(ierr);}
+  }
+
+  ierr = PetscFree(rtmp);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(isicol,&ic);CHKERRQ(ierr);
+  ierr = ISRestoreIndices(isrow,&r);CHKERRQ(ierr);
+
+  ierr = ISIdentity(isrow,&row_identity);CHKERRQ(ierr);
+  ierr = ISIdentity(isicol,&col_identity);CHKERRQ(ierr);
+  if (row_identity && col_identity) {
+    C->ops->solve = PETSCMAP2(MatSolve_SeqBAIJ);
+  } else {
+    C->ops->solve = PETSCMAP1(MatSolve_SeqBAIJ);
+  }
+  C->ops->solvetranspose = MatSolveTranspose_SeqBAIJ_N;
+  C->assembled = PETSC_TRUE;
+  ierr = PetscLogFlops(1.333333333333*BS*BS2*b->mbs);CHKERRQ(ierr); /* from inverting diagonal blocks */
+  PetscFunctionReturn(0);
+}
+
+#undef PETSCMAP1_a
+#undef PETSCMAP1_b
+#undef PETSCMAP1
+#undef PETSCMAP2_a
+#undef PETSCMAP2_b
+#undef PETSCMAP2
+#undef BS2
+#undef BS
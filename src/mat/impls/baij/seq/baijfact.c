@@ -672,6 +672,7 @@ PetscErrorCode MatGetFactor_seqbaij_petsc(Mat A,MatFactorType ftype,Mat *B)
 #if defined(PETSC_USE_COMPLEX)
   if (A->hermitian && (ftype == MAT_FACTOR_CHOLESKY || ftype == MAT_FACTOR_ICC))SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Hermitian Factor is not supported");
 #endif
+  if (((Mat_SeqBAIJ*)A->data)->single) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Cannot factor a SEQBAIJ matrix with values stored in single precision, see MatStoreSinglePrecision()");
   ierr = MatCreate(((PetscObject)A)->comm,B);CHKERRQ(ierr);
   ierr = MatSetSizes(*B,n,n,n,n);CHKERRQ(ierr);
   if (ftype == MAT_FACTOR_LU || ftype == MAT_FACTOR_ILU || ftype == MAT_FACTOR_ILUDT) {
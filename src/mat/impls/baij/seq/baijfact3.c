@@ -36,9 +36,33 @@ PetscErrorCode MatSeqBAIJSetNumericFactorization(Mat fact,PetscBool  natural)
     case 7:
       fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_7_NaturalOrdering;
       break;
+    case 8:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_8;
+      break;
+    case 9:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_9;
+      break;
+    case 10:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_10;
+      break;
+    case 11:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_11;
+      break;
+    case 12:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_12;
+      break;
+    case 13:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_13;
+      break;
+    case 14:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_14;
+      break;
     case 15:
       fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_15_NaturalOrdering;
       break;
+    case 16:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_16;
+      break;
     default:
       fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_N;
       break;
@@ -66,6 +90,33 @@ PetscErrorCode MatSeqBAIJSetNumericFactorization(Mat fact,PetscBool  natural)
     case 7:
       fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_7;
       break;
+    case 8:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_8;
+      break;
+    case 9:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_9;
+      break;
+    case 10:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_10;
+      break;
+    case 11:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_11;
+      break;
+    case 12:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_12;
+      break;
+    case 13:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_13;
+      break;
+    case 14:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_14;
+      break;
+    case 15:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_15;
+      break;
+    case 16:
+      fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_16;
+      break;
     default:
       fact->ops->lufactornumeric = MatLUFactorNumeric_SeqBAIJ_N;
       break;
@@ -0,0 +1,714 @@
+/*
+   Storage of the values of SeqBAIJ matrices in single precision, see MatStoreSinglePrecision()
+
+   The single precision copy of the values is made by MatSeqXAIJPackSingle_Private(), shared with SeqAIJ;
+   the products and the point block SOR below work on it for any block size and accumulate in PetscScalar.
+*/
+#include <../src/mat/impls/baij/seq/baij.h>   /*I "petscmat.h" I*/
+#include <../src/mat/blockinvert.h>
+
+#if defined(PETSC_USE_COMPLEX)
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqBAIJPackSingle_Private"
+PetscErrorCode MatSeqBAIJPackSingle_Private(Mat A)
+{
+  PetscFunctionBegin;
+  SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Single precision storage of the values is not available with complex numbers");
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqBAIJUnpackSingle_Private"
+PetscErrorCode MatSeqBAIJUnpackSingle_Private(Mat A)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision_SeqBAIJ"
+PetscErrorCode MatStoreSinglePrecision_SeqBAIJ(Mat A,PetscBool flg)
+{
+  PetscFunctionBegin;
+  if (flg) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Single precision storage of the values is not available with complex numbers");
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#else
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqBAIJ_Single_Private"
+/* z += A x, with the blocks stored by columns */
+static PetscErrorCode MatMultAdd_SeqBAIJ_Single_Private(Mat A,const PetscScalar *x,PetscScalar *z)
+{
+  Mat_SeqBAIJ           *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalarSingle *v = a->single->a;
+  const PetscInt        *ai = a->i,*aj = a->j,bs = A->rmap->bs,bs2 = a->bs2,mbs = a->mbs;
+  const PetscScalar     *xb;
+  PetscScalar           *zb,xc;
+  PetscInt              i,j,r,c;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  for (i=0; i<mbs; i++) {
+    zb = z + bs*i;
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      xb = x + bs*aj[j];
+      for (c=0; c<bs; c++) {
+        xc = xb[c];
+        for (r=0; r<bs; r++) zb[r] += v[r+bs*c]*xc;
+      }
+      v += bs2;
+    }
+  }
+  ierr = PetscLogFlops(2.0*a->nz*bs2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMult_SeqBAIJ_Single"
+static PetscErrorCode MatMult_SeqBAIJ_Single(Mat A,Vec xx,Vec zz)
+{
+  const PetscScalar *x;
+  PetscScalar       *z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSet(zz,0.0);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqBAIJ_Single_Private(A,x,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultAdd_SeqBAIJ_Single"
+static PetscErrorCode MatMultAdd_SeqBAIJ_Single(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  const PetscScalar *x;
+  PetscScalar       *z;
+  PetscErrorCode    ierr;
+
+  PetscFunctionBegin;
+  if (yy != zz) {ierr = VecCopy(yy,zz);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  ierr = MatMultAdd_SeqBAIJ_Single_Private(A,x,z);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTransposeAdd_SeqBAIJ_Single"
+static PetscErrorCode MatMultTransposeAdd_SeqBAIJ_Single(Mat A,Vec xx,Vec yy,Vec zz)
+{
+  Mat_SeqBAIJ           *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalarSingle *v = a->single->a;
+  const PetscInt        *ai = a->i,*aj = a->j,bs = A->rmap->bs,bs2 = a->bs2,mbs = a->mbs;
+  const PetscScalar     *x,*xb;
+  PetscScalar           *z,*zb,sum;
+  PetscInt              i,j,r,c;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  if (yy != zz) {ierr = VecCopy(yy,zz);CHKERRQ(ierr);}
+  ierr = VecGetArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArray(zz,&z);CHKERRQ(ierr);
+  for (i=0; i<mbs; i++) {
+    xb = x + bs*i;
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      zb = z + bs*aj[j];
+      for (c=0; c<bs; c++) {
+        sum = 0.0;
+        for (r=0; r<bs; r++) sum += v[r+bs*c]*xb[r];
+        zb[c] += sum;
+      }
+      v += bs2;
+    }
+  }
+  ierr = VecRestoreArrayRead(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArray(zz,&z);CHKERRQ(ierr);
+  ierr = PetscLogFlops(2.0*a->nz*bs2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatMultTranspose_SeqBAIJ_Single"
+static PetscErrorCode MatMultTranspose_SeqBAIJ_Single(Mat A,Vec xx,Vec zz)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = VecSet(zz,0.0);CHKERRQ(ierr);
+  ierr = MatMultTransposeAdd_SeqBAIJ_Single(A,xx,zz,zz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetDiagonal_SeqBAIJ_Single"
+static PetscErrorCode MatGetDiagonal_SeqBAIJ_Single(Mat A,Vec v)
+{
+  Mat_SeqBAIJ           *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalarSingle *aa = a->single->a,*aa_j;
+  const PetscInt        *ai = a->i,*aj = a->j,bs = A->rmap->bs,bs2 = a->bs2;
+  PetscInt              i,j,k,n,row;
+  PetscScalar           *x;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  ierr = VecGetLocalSize(v,&n);CHKERRQ(ierr);
+  if (n != A->rmap->N) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_SIZ,"Nonconforming matrix and vector");
+  ierr = VecSet(v,0.0);CHKERRQ(ierr);
+  ierr = VecGetArray(v,&x);CHKERRQ(ierr);
+  for (i=0; i<a->mbs; i++) {
+    for (j=ai[i]; j<ai[i+1]; j++) {
+      if (aj[j] == i) {
+        row  = i*bs;
+        aa_j = aa + j*bs2;
+        for (k=0; k<bs2; k+=(bs+1),row++) x[row] = aa_j[k];
+        break;
+      }
+    }
+  }
+  ierr = VecRestoreArray(v,&x);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroEntries_SeqBAIJ_Single"
+static PetscErrorCode MatZeroEntries_SeqBAIJ_Single(Mat A)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscMemzero(a->single->a,a->i[a->mbs]*a->bs2*sizeof(MatScalarSingle));CHKERRQ(ierr);
+  a->idiagvalid = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatScale_SeqBAIJ_Single"
+static PetscErrorCode MatScale_SeqBAIJ_Single(Mat A,PetscScalar alpha)
+{
+  Mat_SeqBAIJ     *a = (Mat_SeqBAIJ*)A->data;
+  MatScalarSingle *v = a->single->a;
+  PetscInt        k,nz = a->i[a->mbs]*a->bs2;
+  PetscErrorCode  ierr;
+
+  PetscFunctionBegin;
+  for (k=0; k<nz; k++) v[k] = (MatScalarSingle)(alpha*v[k]);
+  a->idiagvalid = PETSC_FALSE;
+  ierr = PetscLogFlops(nz);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatInvertBlockDiagonal_SeqBAIJ_Single"
+/* the inverses of the diagonal blocks are kept in full precision, computed from the rounded values */
+static PetscErrorCode MatInvertBlockDiagonal_SeqBAIJ_Single(Mat A,const PetscScalar **values)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (a->idiagvalid) {
+    if (values) *values = a->idiag;
+    PetscFunctionReturn(0);
+  }
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->invertblockdiagonal)(A,values);CHKERRQ(ierr);
+  ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSOR_SeqBAIJ_Single"
+/* point block SOR with the restrictions of MatSOR_SeqBAIJ_N() */
+static PetscErrorCode MatSOR_SeqBAIJ_Single(Mat A,Vec bb,PetscReal omega,MatSORType flag,PetscReal fshift,PetscInt its,PetscInt lits,Vec xx)
+{
+  Mat_SeqBAIJ           *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalarSingle *aa,*v;
+  const MatScalar       *idiag,*mdiag;
+  const PetscScalar     *b,*xb;
+  PetscScalar           *x,*w,*work,xc;
+  const PetscInt        *ai = a->i,*aj = a->j,*diag,m = a->mbs,bs = A->rmap->bs,bs2 = a->bs2;
+  PetscInt              i,j,r,c,k;
+  PetscErrorCode        ierr;
+
+  PetscFunctionBegin;
+  its = its*lits;
+  if (flag & SOR_EISENSTAT) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support yet for Eisenstat");
+  if (its <= 0) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Relaxation requires global its %D and local its %D both positive",its,lits);
+  if (fshift) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for diagonal shift");
+  if (omega != 1.0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for non-trivial relaxation factor");
+  if ((flag & SOR_APPLY_UPPER) || (flag & SOR_APPLY_LOWER)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support for applying upper or lower triangular parts");
+  if (its > 1) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Sorry, no support yet for multiple point block SOR iterations");
+  if (!(flag & SOR_ZERO_INITIAL_GUESS)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Only supports point block SOR with zero initial guess");
+
+  /* inverting the diagonal blocks repacks the values */
+  if (!a->idiagvalid) {ierr = MatInvertBlockDiagonal(A,PETSC_NULL);CHKERRQ(ierr);}
+  aa   = a->single->a;
+  diag = a->diag;
+  if (!a->mult_work) {
+    k    = PetscMax(A->rmap->n,A->cmap->n);
+    ierr = PetscMalloc((k+1)*sizeof(PetscScalar),&a->mult_work);CHKERRQ(ierr);
+  }
+  work = a->mult_work;
+  if (!a->sor_work) {
+    ierr = PetscMalloc(bs*sizeof(PetscScalar),&a->sor_work);CHKERRQ(ierr);
+  }
+  w = a->sor_work;
+
+  ierr = VecGetArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&b);CHKERRQ(ierr);
+
+  if (flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) {
+    idiag = a->idiag;
+    for (i=0; i<m; i++) {
+      ierr = PetscMemcpy(w,b+bs*i,bs*sizeof(PetscScalar));CHKERRQ(ierr);
+      v = aa + bs2*ai[i];
+      for (j=ai[i]; j<diag[i]; j++) {
+        xb = x + bs*aj[j];
+        for (c=0; c<bs; c++) {
+          xc = xb[c];
+          for (r=0; r<bs; r++) w[r] -= v[r+bs*c]*xc;
+        }
+        v += bs2;
+      }
+      PetscKernel_w_gets_Ar_times_v(bs,bs,w,idiag,x+bs*i);
+      idiag += bs2;
+    }
+    ierr = PetscLogFlops(1.0*bs2*a->nz);CHKERRQ(ierr);
+  }
+  if ((flag & SOR_FORWARD_SWEEP || flag & SOR_LOCAL_FORWARD_SWEEP) &&
+      (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP)) {
+    mdiag = a->idiag + bs2*m;
+    ierr  = PetscMemcpy(work,x,m*bs*sizeof(PetscScalar));CHKERRQ(ierr);
+    for (i=0; i<m; i++) {
+      PetscKernel_w_gets_Ar_times_v(bs,bs,work+bs*i,mdiag,x+bs*i);
+      mdiag += bs2;
+    }
+    ierr = PetscLogFlops(2.0*bs*(bs-1)*m);CHKERRQ(ierr);
+  } else if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+    ierr = PetscMemcpy(x,b,A->rmap->N*sizeof(PetscScalar));CHKERRQ(ierr);
+  }
+  if (flag & SOR_BACKWARD_SWEEP || flag & SOR_LOCAL_BACKWARD_SWEEP) {
+    idiag = a->idiag + bs2*(m-1);
+    for (i=m-1; i>=0; i--) {
+      ierr = PetscMemcpy(w,x+bs*i,bs*sizeof(PetscScalar));CHKERRQ(ierr);
+      v = aa + bs2*(diag[i]+1);
+      for (j=diag[i]+1; j<ai[i+1]; j++) {
+        xb = x + bs*aj[j];
+        for (c=0; c<bs; c++) {
+          xc = xb[c];
+          for (r=0; r<bs; r++) w[r] -= v[r+bs*c]*xc;
+        }
+        v += bs2;
+      }
+      PetscKernel_w_gets_Ar_times_v(bs,bs,w,idiag,x+bs*i);
+      idiag -= bs2;
+    }
+    ierr = PetscLogFlops(1.0*bs2*a->nz);CHKERRQ(ierr);
+  }
+  ierr = VecRestoreArray(xx,&x);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+/*
+   Operations that change the values return to full precision first; those that need the values in the
+   layout of a->a work on a temporary full precision copy
+*/
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValues_SeqBAIJ_Single"
+static PetscErrorCode MatSetValues_SeqBAIJ_Single(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->setvalues)(A,m,im,n,in,v,is);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetValuesBlocked_SeqBAIJ_Single"
+static PetscErrorCode MatSetValuesBlocked_SeqBAIJ_Single(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],const PetscScalar v[],InsertMode is)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->setvaluesblocked)(A,m,im,n,in,v,is);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRows_SeqBAIJ_Single"
+static PetscErrorCode MatZeroRows_SeqBAIJ_Single(Mat A,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->zerorows)(A,N,rows,diag,x,b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatZeroRowsColumns_SeqBAIJ_Single"
+static PetscErrorCode MatZeroRowsColumns_SeqBAIJ_Single(Mat A,PetscInt N,const PetscInt rows[],PetscScalar diag,Vec x,Vec b)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->zerorowscolumns)(A,N,rows,diag,x,b);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAssemblyEnd_SeqBAIJ_Single"
+/* nothing changed since the values were stored in single precision, MatSetValues() would have undone it */
+static PetscErrorCode MatAssemblyEnd_SeqBAIJ_Single(Mat A,MatAssemblyType mode)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetValues_SeqBAIJ_Single"
+static PetscErrorCode MatGetValues_SeqBAIJ_Single(Mat A,PetscInt m,const PetscInt im[],PetscInt n,const PetscInt in[],PetscScalar v[])
+{
+  Mat_SeqBAIJ           *a = (Mat_SeqBAIJ*)A->data;
+  const MatScalarSingle *ap;
+  PetscInt              *rp,k,l,i,t,low,high,row,col,brow,bcol,nrow,bs = A->rmap->bs,bs2 = a->bs2;
+
+  PetscFunctionBegin;
+  for (k=0; k<m; k++) {
+    row = im[k];
+    if (row < 0) {v += n; continue;}
+    if (row >= A->rmap->N) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Row %D too large",row);
+    brow = row/bs;
+    rp   = a->j + a->i[brow];
+    ap   = a->single->a + bs2*a->i[brow];
+    nrow = a->ilen[brow];
+    for (l=0; l<n; l++) {
+      col = in[l];
+      if (col < 0) {v++; continue;}
+      if (col >= A->cmap->n) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Column %D too large",col);
+      bcol = col/bs;
+      high = nrow; low = 0;
+      while (high-low > 5) {
+        t = (low+high)/2;
+        if (rp[t] > bcol) high = t;
+        else              low  = t;
+      }
+      *v = 0.0;
+      for (i=low; i<high; i++) {
+        if (rp[i] > bcol) break;
+        if (rp[i] == bcol) {*v = ap[bs2*i+bs*(col%bs)+row%bs]; break;}
+      }
+      v++;
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatNorm_SeqBAIJ_Single"
+static PetscErrorCode MatNorm_SeqBAIJ_Single(Mat A,NormType type,PetscReal *nrm)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->norm)(A,type,nrm);CHKERRQ(ierr);
+  ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatView_SeqBAIJ_Single"
+static PetscErrorCode MatView_SeqBAIJ_Single(Mat A,PetscViewer viewer)
+{
+  PetscErrorCode    ierr;
+  PetscBool         iascii;
+  PetscViewerFormat format;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->view)(A,viewer);CHKERRQ(ierr);
+  ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERASCII,&iascii);CHKERRQ(ierr);
+  if (iascii) {
+    ierr = PetscViewerGetFormat(viewer,&format);CHKERRQ(ierr);
+    if (format == PETSC_VIEWER_ASCII_INFO || format == PETSC_VIEWER_ASCII_INFO_DETAIL) {
+      ierr = PetscViewerASCIIPrintf(viewer,"values stored in single precision\n");CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDuplicate_SeqBAIJ_Single"
+static PetscErrorCode MatDuplicate_SeqBAIJ_Single(Mat A,MatDuplicateOption op,Mat *B)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->duplicate)(A,op,B);CHKERRQ(ierr);
+  ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  ((Mat_SeqBAIJ*)(*B)->data)->storesingle = a->storesingle;
+  ierr = MatSeqBAIJPackSingle_Private(*B);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetSubMatrices_SeqBAIJ_Single"
+static PetscErrorCode MatGetSubMatrices_SeqBAIJ_Single(Mat A,PetscInt n,const IS irow[],const IS icol[],MatReuse scall,Mat *B[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getsubmatrices)(A,n,irow,icol,scall,B);CHKERRQ(ierr);
+  ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqBAIJRepackSingle_Private"
+/* stores the values in single precision again after a temporary unpack, also when the operation replaced the data of A */
+static PetscErrorCode MatSeqBAIJRepackSingle_Private(Mat A)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ((Mat_SeqBAIJ*)A->data)->storesingle = PETSC_TRUE;
+  if (A->assembled) {ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatDiagonalScale_SeqBAIJ_Single"
+static PetscErrorCode MatDiagonalScale_SeqBAIJ_Single(Mat A,Vec l,Vec r)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->diagonalscale)(A,l,r);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatAXPY_SeqBAIJ_Single"
+/* MatAXPY_SeqBAIJ() itself unpacks X when only X is stored in single precision */
+static PetscErrorCode MatAXPY_SeqBAIJ_Single(Mat Y,PetscScalar a,Mat X,MatStructure str)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(Y);CHKERRQ(ierr);
+  ierr = (*Y->ops->axpy)(Y,a,X,str);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(Y);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatCopy_SeqBAIJ_Single"
+static PetscErrorCode MatCopy_SeqBAIJ_Single(Mat A,Mat B,MatStructure str)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->copy)(A,B,str);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatEqual_SeqBAIJ_Single"
+static PetscErrorCode MatEqual_SeqBAIJ_Single(Mat A,Mat B,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->equal)(A,B,flg);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatTranspose_SeqBAIJ_Single"
+static PetscErrorCode MatTranspose_SeqBAIJ_Single(Mat A,MatReuse reuse,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->transpose)(A,reuse,B);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetSubMatrix_SeqBAIJ_Single"
+static PetscErrorCode MatGetSubMatrix_SeqBAIJ_Single(Mat A,IS isrow,IS iscol,MatReuse scall,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getsubmatrix)(A,isrow,iscol,scall,B);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatGetRowMaxAbs_SeqBAIJ_Single"
+static PetscErrorCode MatGetRowMaxAbs_SeqBAIJ_Single(Mat A,Vec v,PetscInt idx[])
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = (*A->ops->getrowmaxabs)(A,v,idx);CHKERRQ(ierr);
+  ierr = MatSeqBAIJRepackSingle_Private(A);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatConvert_SeqBAIJ_Single"
+/* composed in place of the conversions of SeqBAIJ, which read a->a, and also used for MatConvert_Basic() */
+PetscErrorCode MatConvert_SeqBAIJ_Single(Mat A,MatType newtype,MatReuse reuse,Mat *B)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  ierr = MatConvert(A,newtype,reuse,B);CHKERRQ(ierr);
+  /* an in place conversion replaced the data of A */
+  if (reuse != MAT_REUSE_MATRIX) {ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);}
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSetOps_SeqBAIJ_Single"
+static PetscErrorCode MatSetOps_SeqBAIJ_Single(Mat A)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  struct _MatOps *full = &a->single->ops;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  A->ops->mult                = MatMult_SeqBAIJ_Single;
+  A->ops->multadd             = MatMultAdd_SeqBAIJ_Single;
+  A->ops->multtranspose       = MatMultTranspose_SeqBAIJ_Single;
+  A->ops->multtransposeadd    = MatMultTransposeAdd_SeqBAIJ_Single;
+  A->ops->sor                 = MatSOR_SeqBAIJ_Single;
+  A->ops->getdiagonal         = MatGetDiagonal_SeqBAIJ_Single;
+  A->ops->invertblockdiagonal = MatInvertBlockDiagonal_SeqBAIJ_Single;
+  A->ops->zeroentries         = MatZeroEntries_SeqBAIJ_Single;
+  A->ops->scale               = MatScale_SeqBAIJ_Single;
+  A->ops->setvalues           = MatSetValues_SeqBAIJ_Single;
+  A->ops->setvaluesblocked    = MatSetValuesBlocked_SeqBAIJ_Single;
+  A->ops->zerorows            = MatZeroRows_SeqBAIJ_Single;
+  A->ops->zerorowscolumns     = MatZeroRowsColumns_SeqBAIJ_Single;
+  A->ops->assemblyend         = MatAssemblyEnd_SeqBAIJ_Single;
+  A->ops->norm                = MatNorm_SeqBAIJ_Single;
+  A->ops->view                = MatView_SeqBAIJ_Single;
+  A->ops->duplicate           = MatDuplicate_SeqBAIJ_Single;
+  A->ops->getsubmatrices      = MatGetSubMatrices_SeqBAIJ_Single;
+  A->ops->getvalues           = MatGetValues_SeqBAIJ_Single;
+
+  /* these work on a temporary full precision copy of the values */
+  A->ops->diagonalscale = full->diagonalscale ? MatDiagonalScale_SeqBAIJ_Single : 0;
+  A->ops->axpy          = full->axpy ? MatAXPY_SeqBAIJ_Single : 0;
+  A->ops->copy          = full->copy ? MatCopy_SeqBAIJ_Single : 0;
+  A->ops->equal         = full->equal ? MatEqual_SeqBAIJ_Single : 0;
+  A->ops->transpose     = full->transpose ? MatTranspose_SeqBAIJ_Single : 0;
+  A->ops->getsubmatrix  = full->getsubmatrix ? MatGetSubMatrix_SeqBAIJ_Single : 0;
+  A->ops->getrowmaxabs  = full->getrowmaxabs ? MatGetRowMaxAbs_SeqBAIJ_Single : 0;
+  A->ops->convert       = full->convert ? MatConvert_SeqBAIJ_Single : 0;
+  ierr = MatSeqXAIJSetConvertersSingle_Private(A,MatConvert_SeqBAIJ_Single);CHKERRQ(ierr);
+
+  /* these only use the nonzero structure */
+  A->ops->destroy         = full->destroy;
+  A->ops->setoption       = full->setoption;
+  A->ops->getinfo         = full->getinfo;
+  A->ops->setup           = full->setup;
+  A->ops->getvecs         = full->getvecs;
+  A->ops->getrowij        = full->getrowij;
+  A->ops->restorerowij    = full->restorerowij;
+  A->ops->getcolumnij     = full->getcolumnij;
+  A->ops->restorecolumnij = full->restorecolumnij;
+  A->ops->increaseoverlap = full->increaseoverlap;
+  A->ops->missingdiagonal = full->missingdiagonal;
+  A->ops->setblocksizes   = full->setblocksizes;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqBAIJPackSingle_Private"
+/*
+   MatSeqBAIJPackSingle_Private - Stores the values of an assembled SeqBAIJ matrix in single precision
+*/
+PetscErrorCode MatSeqBAIJPackSingle_Private(Mat A)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = MatSeqXAIJPackSingle_Private(A,a->mbs,a->i[a->mbs],a->bs2,MatSetOps_SeqBAIJ_Single);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqBAIJUnpackSingle_Private"
+PetscErrorCode MatSeqBAIJUnpackSingle_Private(Mat A)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!a->single) PetscFunctionReturn(0);
+  ierr = MatSeqXAIJUnpackSingle_Private(A,a->i[a->mbs],a->bs2);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "MatStoreSinglePrecision_SeqBAIJ"
+PetscErrorCode MatStoreSinglePrecision_SeqBAIJ(Mat A,PetscBool flg)
+{
+  Mat_SeqBAIJ    *a = (Mat_SeqBAIJ*)A->data;
+  PetscBool      isseqbaij;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscObjectTypeCompare((PetscObject)A,MATSEQBAIJ,&isseqbaij);CHKERRQ(ierr);
+  if (flg && !isseqbaij) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_SUP,"Not for matrix type %s",((PetscObject)A)->type_name);
+  a->storesingle = flg;
+  if (!flg) {
+    ierr = MatSeqBAIJUnpackSingle_Private(A);CHKERRQ(ierr);
+  } else if (A->assembled) {
+    ierr = MatSeqBAIJPackSingle_Private(A);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+#endif
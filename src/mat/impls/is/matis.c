@@ -184,19 +184,7 @@ PetscErrorCode MatSetLocalToGlobalMapping_IS(Mat A,ISLocalToGlobalMapping rmappi
   PetscFunctionReturn(0);
 }
 
-#define ISG2LMapApply(mapping,n,in,out) 0;\
-  if (!(mapping)->globals) {\
-   PetscErrorCode _ierr = ISGlobalToLocalMappingApply((mapping),IS_GTOLM_MASK,0,0,0,0);CHKERRQ(_ierr);\
-  }\
-  {\
-    PetscInt _i,*_globals = (mapping)->globals,_start = (mapping)->globalstart,_end = (mapping)->globalend;\
-    for (_i=0; _i<n; _i++) {\
-      if (in[_i] < 0)           out[_i] = in[_i];\
-      else if (in[_i] < _start) out[_i] = -1;\
-      else if (in[_i] > _end)   out[_i] = -1;\
-      else                      out[_i] = _globals[in[_i] - _start];\
-    }\
-  }
+#define ISG2LMapApply(mapping,n,in,out) ISGlobalToLocalMappingApply((mapping),IS_GTOLM_MASK,(n),(in),PETSC_NULL,(out))
 
 #undef __FUNCT__
 #define __FUNCT__ "MatSetValues_IS"
@@ -24,6 +24,7 @@ typedef struct {
   Mat_SeqAIJ_Inode inode;
   unsigned short   *jshort;
   PetscBool        free_jshort;
+  Mat_SeqAIJ_SolveLevels *solvelevels; /* used by MatSolve() of bs=1 factors with -mat_solve_levels */
 } Mat_SeqSBAIJ;
 
 EXTERN_C_BEGIN
@@ -115,6 +116,8 @@ extern PetscErrorCode MatCholeskyFactorNumeric_SeqSBAIJ_7(Mat,Mat,const MatFacto
 extern PetscErrorCode MatSolve_SeqSBAIJ_N_inplace(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqSBAIJ_1_inplace(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqSBAIJ_1(Mat,Vec,Vec);
+extern PetscErrorCode MatSolve_SeqSBAIJ_1_Levels(Mat,Vec,Vec);
+extern PetscErrorCode MatSeqSBAIJCheckSolveLevels(Mat);
 extern PetscErrorCode MatSolve_SeqSBAIJ_2_inplace(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqSBAIJ_3_inplace(Mat,Vec,Vec);
 extern PetscErrorCode MatSolve_SeqSBAIJ_4_inplace(Mat,Vec,Vec);
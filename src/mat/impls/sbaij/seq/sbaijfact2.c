@@ -6,6 +6,8 @@
 #include <../src/mat/impls/sbaij/seq/sbaij.h>
 #include <../src/mat/impls/baij/seq/baij.h>
 #include <../src/mat/blockinvert.h>
+#include <petscthreadcomm.h>
+#include <petsc-private/threadcommimpl.h>
 
 #undef __FUNCT__
 #define __FUNCT__ "MatSolve_SeqSBAIJ_N_inplace"
@@ -1655,6 +1657,228 @@ PetscErrorCode MatSolve_SeqSBAIJ_1(Mat A,Vec bb,Vec xx)
   PetscFunctionReturn(0);
 }
 
+/*
+   Level scheduled solves of SeqSBAIJ bs=1 factors, see MatSeqAIJCheckSolveLevels().
+
+   The forward solve with U^T is done by columns of U, that is rows of U^T, so that each row only
+   reads the rows it depends on; the columns of U are stored with the levels.
+*/
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSeqSBAIJCheckSolveLevels"
+/*
+   MatSeqSBAIJCheckSolveLevels - Called at the end of the numeric Cholesky/ICC factorization with block
+   size 1; with -mat_solve_levels or -mat_solve_levels_syncfree it computes the levels of the factor and
+   replaces its MatSolve() with the threaded one.
+*/
+PetscErrorCode MatSeqSBAIJCheckSolveLevels(Mat A)
+{
+  Mat_SeqSBAIJ           *a = (Mat_SeqSBAIJ*)A->data;
+  Mat_SeqAIJ_SolveLevels *sl;
+  PetscErrorCode         ierr;
+  PetscInt               n = a->mbs,*ai = a->i,*aj = a->j,*lev,*ti,i,k,p,l,nzoff;
+
+  PetscFunctionBegin;
+  ierr = MatSolveLevelsCreate_Private(A,&a->solvelevels);CHKERRQ(ierr);
+  if (!(sl = a->solvelevels)) PetscFunctionReturn(0);
+
+  /* columns of the strictly upper triangular part of U, row k has the entries ai[k] to ai[k+1]-2 */
+  nzoff = ai[n] - n;
+  if (sl->ti) {ierr = PetscFree3(sl->ti,sl->trow,sl->tpos);CHKERRQ(ierr);}
+  ierr = PetscMalloc3(n+1,PetscInt,&sl->ti,nzoff,PetscInt,&sl->trow,nzoff,PetscInt,&sl->tpos);CHKERRQ(ierr);
+  ti   = sl->ti;
+  ierr = PetscMemzero(ti,(n+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (p=0; p<ai[n]; p++) ti[aj[p]+1]++;
+  for (i=0; i<n; i++) ti[i+1] += ti[i] - 1; /* minus the diagonal */
+  for (k=0; k<n; k++) {
+    for (p=ai[k]; p<ai[k+1]-1; p++) {
+      sl->trow[ti[aj[p]]] = k;
+      sl->tpos[ti[aj[p]]++] = p;
+    }
+  }
+  for (i=n; i>0; i--) ti[i] = ti[i-1];
+  ti[0] = 0;
+
+  ierr = PetscMalloc(n*sizeof(PetscInt),&lev);CHKERRQ(ierr);
+  /* U^T, forward from the first row */
+  for (i=0; i<n; i++) {
+    for (p=ti[i],l=0; p<ti[i+1]; p++) l = PetscMax(l,lev[sl->trow[p]]+1);
+    lev[i] = l;
+  }
+  ierr = MatSolveLevelsSetLevels_Private(sl,0,n,lev);CHKERRQ(ierr);
+  /* U, backward from the last row */
+  for (k=n-1; k>=0; k--) {
+    for (p=ai[k],l=0; p<ai[k+1]-1; p++) l = PetscMax(l,lev[aj[p]]+1);
+    lev[k] = l;
+  }
+  ierr = MatSolveLevelsSetLevels_Private(sl,1,n,lev);CHKERRQ(ierr);
+  ierr = PetscFree(lev);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(A,(n+1+2*nzoff)*sizeof(PetscInt));CHKERRQ(ierr);
+
+  A->ops->solve          = MatSolve_SeqSBAIJ_1_Levels;
+  A->ops->solvetranspose = MatSolve_SeqSBAIJ_1_Levels;
+  ierr = PetscInfo4(A,"Triangular solves with %D levels for U^T and %D levels for U of %D rows%s\n",sl->nlevels[0],sl->nlevels[1],n,sl->syncfree ? ", sync-free" : "");CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsForward_SeqSBAIJ_Task"
+/* task t of the current level of U^T, tmp[] gets D*y which is scaled by the backward solve */
+static PetscErrorCode MatSolveLevelsForward_SeqSBAIJ_Task(PetscInt thread_id,PetscInt t,PetscInt tend,void *ctx)
+{
+  MatSolveLevelsCtx          *lc = (MatSolveLevelsCtx*)ctx;
+  const PetscInt             *ls = lc->sl->levelstart[0] + lc->level,*rows = lc->sl->rows[0],*ti = lc->sl->ti,*trow = lc->sl->trow,*tpos = lc->sl->tpos;
+  const MatScalar            *aa = lc->aa;
+  PetscScalar                *tmp = lc->tmp,sum;
+  PetscInt                   k,i,p,kstart = ls[0] + ((ls[1]-ls[0])*t)/lc->ntasks,kend = ls[0] + ((ls[1]-ls[0])*(t+1))/lc->ntasks;
+
+  for (k=kstart; k<kend; k++) {
+    i   = rows[k];
+    sum = lc->b[lc->r[i]];
+    for (p=ti[i]; p<ti[i+1]; p++) sum += aa[tpos[p]]*tmp[trow[p]];
+    tmp[i] = sum;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsBackward_SeqSBAIJ_Task"
+static PetscErrorCode MatSolveLevelsBackward_SeqSBAIJ_Task(PetscInt thread_id,PetscInt t,PetscInt tend,void *ctx)
+{
+  MatSolveLevelsCtx          *lc = (MatSolveLevelsCtx*)ctx;
+  const PetscInt             *ls = lc->sl->levelstart[1] + lc->level,*rows = lc->sl->rows[1],*ai = lc->ai,*aj = lc->aj;
+  const MatScalar            *aa = lc->aa;
+  PetscScalar                *tmp = lc->tmp,sum;
+  PetscInt                   k,i,p,kstart = ls[0] + ((ls[1]-ls[0])*t)/lc->ntasks,kend = ls[0] + ((ls[1]-ls[0])*(t+1))/lc->ntasks;
+
+  for (k=kstart; k<kend; k++) {
+    i   = rows[k];
+    sum = tmp[i]*aa[ai[i+1]-1]; /* aa[ai[i+1]-1] = 1/D(i) */
+    for (p=ai[i]; p<ai[i+1]-1; p++) sum += aa[p]*tmp[aj[p]];
+    lc->x[lc->r[i]] = tmp[i] = sum;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsForward_SeqSBAIJ_SyncFree"
+static PetscErrorCode MatSolveLevelsForward_SeqSBAIJ_SyncFree(PetscInt thread_id,MatSolveLevelsCtx *lc)
+{
+  Mat_SeqAIJ_SolveLevels *sl = lc->sl;
+  const PetscInt         *ls = sl->levelstart[0],*rows = sl->rows[0],*ti = sl->ti,*trow = sl->trow,*tpos = sl->tpos;
+  const MatScalar        *aa = lc->aa;
+  PetscScalar            *tmp = lc->tmp,sum;
+  PetscInt               *ready = sl->ready,stamp = lc->stamp,nt = lc->nthreads,l,k,i,p,m,kstart,kend;
+
+  for (l=0; l<sl->nlevels[0]; l++) {
+    kstart = ls[l] + ((ls[l+1]-ls[l])*thread_id)/nt;
+    kend   = ls[l] + ((ls[l+1]-ls[l])*(thread_id+1))/nt;
+    for (k=kstart; k<kend; k++) {
+      i   = rows[k];
+      sum = lc->b[lc->r[i]];
+      for (p=ti[i]; p<ti[i+1]; p++) {
+        m = trow[p];
+        while (PetscReadOnce(PetscInt,ready[m]) != stamp) ;
+        PetscReadMemoryBarrier();
+        sum += aa[tpos[p]]*PetscReadOnce(PetscScalar,tmp[m]);
+      }
+      PetscReadOnce(PetscScalar,tmp[i]) = sum;
+      PetscWriteMemoryBarrier();
+      PetscReadOnce(PetscInt,ready[i]) = stamp;
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolveLevelsBackward_SeqSBAIJ_SyncFree"
+static PetscErrorCode MatSolveLevelsBackward_SeqSBAIJ_SyncFree(PetscInt thread_id,MatSolveLevelsCtx *lc)
+{
+  Mat_SeqAIJ_SolveLevels *sl = lc->sl;
+  const PetscInt         *ls = sl->levelstart[1],*rows = sl->rows[1],*ai = lc->ai,*aj = lc->aj;
+  const MatScalar        *aa = lc->aa;
+  PetscScalar            *tmp = lc->tmp,sum;
+  PetscInt               *ready = sl->ready,stamp = lc->stamp,nt = lc->nthreads,l,k,i,p,col,kstart,kend;
+
+  for (l=0; l<sl->nlevels[1]; l++) {
+    kstart = ls[l] + ((ls[l+1]-ls[l])*thread_id)/nt;
+    kend   = ls[l] + ((ls[l+1]-ls[l])*(thread_id+1))/nt;
+    for (k=kstart; k<kend; k++) {
+      i   = rows[k];
+      sum = tmp[i]*aa[ai[i+1]-1];
+      for (p=ai[i]; p<ai[i+1]-1; p++) {
+        col = aj[p];
+        while (PetscReadOnce(PetscInt,ready[col]) != stamp) ;
+        PetscReadMemoryBarrier();
+        sum += aa[p]*PetscReadOnce(PetscScalar,tmp[col]);
+      }
+      lc->x[lc->r[i]] = sum;
+      PetscReadOnce(PetscScalar,tmp[i]) = sum;
+      PetscWriteMemoryBarrier();
+      PetscReadOnce(PetscInt,ready[i]) = stamp;
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatSolve_SeqSBAIJ_1_Levels"
+PetscErrorCode MatSolve_SeqSBAIJ_1_Levels(Mat A,Vec bb,Vec xx)
+{
+  Mat_SeqSBAIJ               *a = (Mat_SeqSBAIJ*)A->data;
+  Mat_SeqAIJ_SolveLevels     *sl = a->solvelevels;
+  MPI_Comm                   comm = ((PetscObject)A)->comm;
+  PetscErrorCode             ierr;
+  PetscInt                   n = a->mbs,l,k,nrows;
+  MatSolveLevelsCtx          lc;
+
+  PetscFunctionBegin;
+  if (!n) PetscFunctionReturn(0);
+  ierr = PetscThreadCommGetNThreads(comm,&lc.nthreads);CHKERRQ(ierr);
+  ierr = VecGetArrayRead(bb,&lc.b);CHKERRQ(ierr);
+  ierr = VecGetArray(xx,&lc.x);CHKERRQ(ierr);
+  ierr = ISGetIndices(a->row,&lc.r);CHKERRQ(ierr);
+  lc.sl  = sl;
+  lc.ai  = a->i;
+  lc.aj  = a->j;
+  lc.aa  = a->a;
+  lc.tmp = a->solve_work;
+
+  if (sl->syncfree && lc.nthreads > 1) {
+    if (sl->stamp > PETSC_MAX_INT - 2) {
+      for (k=0; k<n; k++) sl->ready[k] = -1;
+      sl->stamp = 0;
+    }
+    /* lc lives on this stack and tmp[] is shared by both solves, see MatSolve_SeqAIJ_Levels() */
+    lc.stamp = ++sl->stamp;
+    ierr = PetscThreadCommRunKernel(comm,(PetscThreadKernel)MatSolveLevelsForward_SeqSBAIJ_SyncFree,1,&lc);CHKERRQ(ierr);
+    ierr = PetscThreadCommBarrier(comm);CHKERRQ(ierr);
+    lc.stamp = ++sl->stamp;
+    ierr = PetscThreadCommRunKernel(comm,(PetscThreadKernel)MatSolveLevelsBackward_SeqSBAIJ_SyncFree,1,&lc);CHKERRQ(ierr);
+    ierr = PetscThreadCommBarrier(comm);CHKERRQ(ierr);
+  } else {
+    for (k=0; k<2; k++) {
+      PetscThreadTaskKernel kernel = k ? MatSolveLevelsBackward_SeqSBAIJ_Task : MatSolveLevelsForward_SeqSBAIJ_Task;
+      for (l=0; l<sl->nlevels[k]; l++) {
+        nrows     = sl->levelstart[k][l+1] - sl->levelstart[k][l];
+        lc.level  = l;
+        lc.ntasks = PetscMax(1,PetscMin(lc.nthreads,nrows/MATSOLVELEVELS_MINROWS));
+        if (lc.ntasks == 1) {
+          ierr = (*kernel)(0,0,1,&lc);CHKERRQ(ierr);
+        } else {
+          ierr = PetscThreadCommRunTasks(comm,lc.ntasks,PETSC_NULL,kernel,&lc);CHKERRQ(ierr);
+        }
+      }
+    }
+  }
+
+  ierr = ISRestoreIndices(a->row,&lc.r);CHKERRQ(ierr);
+  ierr = VecRestoreArrayRead(bb,&lc.b);CHKERRQ(ierr);
+  ierr = VecRestoreArray(xx,&lc.x);CHKERRQ(ierr);
+  ierr = PetscLogFlops(4.0*a->nz - 3.0*n);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatSolve_SeqSBAIJ_1_inplace"
 PetscErrorCode MatSolve_SeqSBAIJ_1_inplace(Mat A,Vec bb,Vec xx)
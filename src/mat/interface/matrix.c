@@ -910,6 +910,18 @@ $    int    *number nonzeros in each row
 $    int    *column indices of all nonzeros (starting index is zero)
 $    PetscScalar *values of all nonzeros
 
+   AIJ matrices viewed with PetscViewerBinarySetPartitioned() are instead stored in chunks of rows,
+   with an index so that each process reads only its own rows, on any number of processes
+
+$    int    MAT_FILE_CLASSID
+$    int    number of rows
+$    int    number of columns
+$    int    MATRIX_BINARY_FORMAT_PARTITIONED
+$    int    number of chunks
+$    int    *first row of each chunk, followed by the number of rows
+$    int    *number of nonzeros in each chunk
+$    for each chunk, the number of nonzeros in each row, the column indices and the values of its rows
+
    PETSc automatically does the byte swapping for
 machines that store the bytes reversed, e.g.  DEC alpha, freebsd,
 linux, Windows and the paragon; thus if you write your own binary
@@ -918,7 +930,7 @@ and PetscBinaryWrite() to see how this may be done.
 
 .keywords: matrix, load, binary, input
 
-.seealso: PetscViewerBinaryOpen(), MatView(), VecLoad()
+.seealso: PetscViewerBinaryOpen(), PetscViewerBinarySetPartitioned(), MatView(), VecLoad()
 
  @*/
 PetscErrorCode  MatLoad(Mat newmat,PetscViewer viewer)
@@ -1053,6 +1065,7 @@ PetscErrorCode  MatSetValues(Mat mat,PetscInt m,const PetscInt idxm[],PetscInt n
   PetscValidIntPointer(idxn,5);
   if (v) PetscValidScalarPointer(v,6);
   MatCheckPreallocated(mat,1);
+  if (mat->concurrentadd && addv != ADD_VALUES) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Only ADD_VALUES can be used with MAT_CONCURRENT_ADD_VALUES");
   if (mat->insertmode == NOT_SET_VALUES) {
     mat->insertmode = addv;
   }
@@ -1079,9 +1092,9 @@ PetscErrorCode  MatSetValues(Mat mat,PetscInt m,const PetscInt idxm[],PetscInt n
     mat->was_assembled = PETSC_TRUE;
     mat->assembled     = PETSC_FALSE;
   }
-  ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
   ierr = (*mat->ops->setvalues)(mat,m,idxm,n,idxn,v,addv);CHKERRQ(ierr);
-  ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
 #if defined(PETSC_HAVE_CUSP)
   if (mat->valid_GPU_matrix != PETSC_CUSP_UNALLOCATED) {
     mat->valid_GPU_matrix = PETSC_CUSP_CPU;
@@ -1566,6 +1579,7 @@ PetscErrorCode  MatSetValuesBlocked(Mat mat,PetscInt m,const PetscInt idxm[],Pet
   PetscValidIntPointer(idxn,5);
   PetscValidScalarPointer(v,6);
   MatCheckPreallocated(mat,1);
+  if (mat->concurrentadd && addv != ADD_VALUES) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Only ADD_VALUES can be used with MAT_CONCURRENT_ADD_VALUES");
   if (mat->insertmode == NOT_SET_VALUES) {
     mat->insertmode = addv;
   }
@@ -1579,7 +1593,7 @@ PetscErrorCode  MatSetValuesBlocked(Mat mat,PetscInt m,const PetscInt idxm[],Pet
     mat->was_assembled = PETSC_TRUE;
     mat->assembled     = PETSC_FALSE;
   }
-  ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
   if (mat->ops->setvaluesblocked) {
     ierr = (*mat->ops->setvaluesblocked)(mat,m,idxm,n,idxn,v,addv);CHKERRQ(ierr);
   } else {
@@ -1604,7 +1618,7 @@ PetscErrorCode  MatSetValuesBlocked(Mat mat,PetscInt m,const PetscInt idxm[],Pet
     ierr = MatSetValues(mat,m*bs,iidxm,n*bs,iidxn,v,addv);CHKERRQ(ierr);
     ierr = PetscFree2(bufr,bufc);CHKERRQ(ierr);
   }
-  ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
 #if defined(PETSC_HAVE_CUSP)
   if (mat->valid_GPU_matrix != PETSC_CUSP_UNALLOCATED) {
     mat->valid_GPU_matrix = PETSC_CUSP_CPU;
@@ -1915,6 +1929,7 @@ PetscErrorCode  MatSetValuesLocal(Mat mat,PetscInt nrow,const PetscInt irow[],Pe
   PetscValidIntPointer(irow,3);
   PetscValidIntPointer(icol,5);
   PetscValidScalarPointer(y,6);
+  if (mat->concurrentadd && addv != ADD_VALUES) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Only ADD_VALUES can be used with MAT_CONCURRENT_ADD_VALUES");
   if (mat->insertmode == NOT_SET_VALUES) {
     mat->insertmode = addv;
   }
@@ -1928,7 +1943,7 @@ PetscErrorCode  MatSetValuesLocal(Mat mat,PetscInt nrow,const PetscInt irow[],Pe
     mat->was_assembled = PETSC_TRUE;
     mat->assembled     = PETSC_FALSE;
   }
-  ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
   if (mat->ops->setvalueslocal) {
     ierr = (*mat->ops->setvalueslocal)(mat,nrow,irow,ncol,icol,y,addv);CHKERRQ(ierr);
   } else {
@@ -1944,7 +1959,7 @@ PetscErrorCode  MatSetValuesLocal(Mat mat,PetscInt nrow,const PetscInt irow[],Pe
     ierr = MatSetValues(mat,nrow,irowm,ncol,icolm,y,addv);CHKERRQ(ierr);
     ierr = PetscFree2(bufr,bufc);CHKERRQ(ierr);
   }
-  ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
 #if defined(PETSC_HAVE_CUSP)
   if (mat->valid_GPU_matrix != PETSC_CUSP_UNALLOCATED) {
     mat->valid_GPU_matrix = PETSC_CUSP_CPU;
@@ -2003,6 +2018,7 @@ PetscErrorCode  MatSetValuesBlockedLocal(Mat mat,PetscInt nrow,const PetscInt ir
   PetscValidIntPointer(irow,3);
   PetscValidIntPointer(icol,5);
   PetscValidScalarPointer(y,6);
+  if (mat->concurrentadd && addv != ADD_VALUES) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Only ADD_VALUES can be used with MAT_CONCURRENT_ADD_VALUES");
   if (mat->insertmode == NOT_SET_VALUES) {
     mat->insertmode = addv;
   }
@@ -2016,7 +2032,7 @@ PetscErrorCode  MatSetValuesBlockedLocal(Mat mat,PetscInt nrow,const PetscInt ir
     mat->was_assembled = PETSC_TRUE;
     mat->assembled     = PETSC_FALSE;
   }
-  ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventBegin(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
   if (mat->ops->setvaluesblockedlocal) {
     ierr = (*mat->ops->setvaluesblockedlocal)(mat,nrow,irow,ncol,icol,y,addv);CHKERRQ(ierr);
   } else {
@@ -2050,7 +2066,7 @@ PetscErrorCode  MatSetValuesBlockedLocal(Mat mat,PetscInt nrow,const PetscInt ir
       ierr = PetscFree2(bufr,bufc);CHKERRQ(ierr);
     }
   }
-  ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);
+  if (!mat->concurrentadd) {ierr = PetscLogEventEnd(MAT_SetValues,mat,0,0,0);CHKERRQ(ierr);}
 #if defined(PETSC_HAVE_CUSP)
   if (mat->valid_GPU_matrix != PETSC_CUSP_UNALLOCATED) {
     mat->valid_GPU_matrix = PETSC_CUSP_CPU;
@@ -4049,6 +4065,7 @@ PetscErrorCode  MatDuplicate(Mat mat,MatDuplicateOption op,Mat *M)
 
   B->nooffproczerorows = mat->nooffproczerorows;
   B->nooffprocentries  = mat->nooffprocentries;
+  B->sameoffprocentries = mat->sameoffprocentries;
   ierr = PetscLogEventEnd(MAT_Convert,mat,0,0,0);CHKERRQ(ierr);
   ierr = PetscObjectStateIncrease((PetscObject)B);CHKERRQ(ierr);
   PetscFunctionReturn(0);
@@ -4750,6 +4767,9 @@ static PetscInt MatAssemblyEnd_InUse = 0;
    out by assembly. If you intend to use that extra space on a subsequent assembly, be sure to insert explicit zeros
    before MAT_FINAL_ASSEMBLY so the space is not compressed out.
 
+   Options Database Keys:
+.  -matstash_coalesce - combine the cached values destined for the same (row,column) of another process before sending them
+
    Level: beginner
 
    Concepts: matrices^assembling
@@ -4986,9 +5006,11 @@ PetscErrorCode  MatAssemblyEnd(Mat mat,MatAssemblyType type)
 .    MAT_IGNORE_OFF_PROC_ENTRIES - drops off-processor entries
 .    MAT_NEW_NONZERO_LOCATION_ERR - generates an error for new matrix entry
 .    MAT_USE_HASH_TABLE - uses a hash table to speed up matrix assembly
-+    MAT_NO_OFF_PROC_ENTRIES - you know each process will only set values for its own rows, will generate an error if
+.    MAT_NO_OFF_PROC_ENTRIES - you know each process will only set values for its own rows, will generate an error if
         any process sets values for another process. This avoids all reductions in the MatAssembly routines and thus improves
         performance for very large process counts.
+-    MAT_SAME_OFF_PROC_ENTRIES - you know each process will set the same entries in the rows of other processes, in the
+        same order, in every assembly. The communication of the next assembly is recorded and reused by the following ones.
 
    Notes:
    Some options are relevant only for particular matrix types and
@@ -5047,6 +5069,22 @@ PetscErrorCode  MatAssemblyEnd(Mat mat,MatAssemblyType type)
    MAT_IGNORE_LOWER_TRIANGULAR - For SBAIJ matrices will ignore any insertions you make in the lower triangular
         part of the matrix (since they should match the upper triangular part).
 
+   MAT_CONCURRENT_ADD_VALUES - allows several threads to call MatSetValues(), MatSetValuesBlocked() and their local
+        variants at the same time on one matrix. Only ADD_VALUES is allowed, the values are added with atomic operations
+        into the existing nonzero structure, and an error is generated for any entry that is not already present in it.
+        So the nonzero structure must be set first, for example by a first assembly. No logging of MatSetValues() is done
+        while this option is set. (Currently supported for SeqAIJ and SeqBAIJ formats only.)
+
+   MAT_SAME_OFF_PROC_ENTRIES - the first assembly after this option is set records which processes each process sends
+        values to, how many, and the row and column indices the owners receive. The following assemblies only send the
+        values, into the recorded buffers, and the owners take the indices from the record. MPIAIJ matrices whose nonzero
+        structure cannot change (MAT_NEW_NONZERO_LOCATIONS set to PETSC_FALSE, or MAT_NEW_NONZERO_LOCATION_ERR; not
+        MAT_NEW_NONZERO_ALLOCATION_ERR, which still allows new nonzeros in the preallocated space) also remember where
+        each received value is stored, and put it there directly. With MAT_IGNORE_ZERO_ENTRIES the zero values are not
+        stashed, so they must be zero in the same places every time. An error is generated if a process sets a different
+        number of off-process entries (or, in debug mode, different entries) than in the recorded assembly. Unset the
+        option to drop the record. The option must be set on all processes.
+
    Notes: Can only be called after MatSetSizes() and MatSetType() have been set.
 
    Level: intermediate
@@ -5078,6 +5116,10 @@ PetscErrorCode  MatSetOption(Mat mat,MatOption op,PetscBool  flg)
     mat->nooffproczerorows               = flg;
     PetscFunctionReturn(0);
     break;
+  case MAT_SAME_OFF_PROC_ENTRIES:
+    mat->sameoffprocentries              = flg;
+    PetscFunctionReturn(0);
+    break;
   case MAT_SPD:
     mat->spd_set                         = PETSC_TRUE;
     mat->spd                             = flg;
@@ -5113,6 +5155,7 @@ PetscErrorCode  MatSetOption(Mat mat,MatOption op,PetscBool  flg)
   if (mat->ops->setoption) {
     ierr = (*mat->ops->setoption)(mat,op,flg);CHKERRQ(ierr);
   }
+  if (op == MAT_CONCURRENT_ADD_VALUES && flg && !mat->concurrentadd) SETERRQ1(((PetscObject)mat)->comm,PETSC_ERR_SUP,"Matrix type %s does not support MAT_CONCURRENT_ADD_VALUES",((PetscObject)mat)->type_name);
   PetscFunctionReturn(0);
 }
 
@@ -8086,6 +8129,10 @@ PetscErrorCode  MatFactorInfoInitialize(MatFactorInfo *info)
    Output Parameters:
 .  C - the product matrix
 
+   Options Database Keys:
++  -matptap_hash - for SeqAIJ, accumulates the rows of the products in hash tables, using the threads of the communicator
+-  -matptap_allatonce - for MPIAIJ, computes the product without forming A*P, which needs much less memory
+
    Notes:
    C will be created and must be destroyed by the user with MatDestroy().
 
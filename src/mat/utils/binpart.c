@@ -0,0 +1,307 @@
+
+/*
+   Binary input and output of AIJ matrices in the partitioned format, see PetscViewerBinarySetPartitioned().
+
+   After the header MAT_FILE_CLASSID, M, N, MATRIX_BINARY_FORMAT_PARTITIONED comes the index: the number of
+   chunks, the first row of each chunk followed by M, and the number of nonzeros of each chunk. Then come the
+   chunks, each one a block of consecutive rows stored as in the standard format: the row lengths, the column
+   indices and the values. A process finds in the index where its rows are and reads only those.
+*/
+#include <petsc-private/matimpl.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "MatBinaryPartitionedIO_Private"
+/*
+   Reads, or writes with MPI-IO, npieces pieces of lens[] values of type dtype at the offsets displs[]
+   (in bytes, from start) to or from the contiguous buffer buf. Collective with MPI-IO.
+*/
+static PetscErrorCode MatBinaryPartitionedIO_Private(PetscViewer viewer,PetscBool write,off_t start,PetscInt npieces,const off_t displs[],const PetscInt lens[],PetscDataType dtype,void *buf)
+{
+  PetscErrorCode ierr;
+  PetscInt       p;
+  int            fd;
+  size_t         dsize;
+  off_t          newoff;
+  char           *cbuf = (char*)buf;
+#if defined(PETSC_HAVE_MPIIO)
+  PetscBool      useMPIIO;
+#endif
+
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_MPIIO)
+  ierr = PetscViewerBinaryGetMPIIO(viewer,&useMPIIO);CHKERRQ(ierr);
+  if (useMPIIO) {
+    MPI_File     mfdes;
+    MPI_Datatype etype,ftype;
+    MPI_Status   status;
+    PetscMPIInt  *blens,cnt = 0,nblocks = 0;
+    MPI_Aint     *bdispls;
+
+    ierr = PetscViewerBinaryGetMPIIODescriptor(viewer,&mfdes);CHKERRQ(ierr);
+    ierr = PetscDataTypeToMPIDataType(dtype,&etype);CHKERRQ(ierr);
+    ierr = PetscMalloc2(npieces,PetscMPIInt,&blens,npieces,MPI_Aint,&bdispls);CHKERRQ(ierr);
+    for (p=0; p<npieces; p++) {
+      if (!lens[p]) continue;
+      blens[nblocks]   = PetscMPIIntCast(lens[p]);
+      bdispls[nblocks] = (MPI_Aint)displs[p];
+      cnt             += blens[nblocks++];
+    }
+    /* a process without values still takes part in the collective call, with an empty read or write */
+    if (nblocks) {
+      ierr = MPI_Type_create_hindexed(nblocks,blens,bdispls,etype,&ftype);CHKERRQ(ierr);
+      ierr = MPI_Type_commit(&ftype);CHKERRQ(ierr);
+    } else ftype = etype;
+    ierr = MPI_File_set_view(mfdes,(MPI_Offset)start,etype,ftype,(char *)"native",MPI_INFO_NULL);CHKERRQ(ierr);
+    if (write) {
+      ierr = MPIU_File_write_all(mfdes,buf,cnt,etype,&status);CHKERRQ(ierr);
+    } else {
+      ierr = MPIU_File_read_all(mfdes,buf,cnt,etype,&status);CHKERRQ(ierr);
+    }
+    if (nblocks) {ierr = MPI_Type_free(&ftype);CHKERRQ(ierr);}
+    ierr = PetscFree2(blens,bdispls);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+#endif
+  if (write) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Only MPI-IO writes the pieces of each process");
+  ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
+  ierr = PetscDataTypeGetSize(dtype,&dsize);CHKERRQ(ierr);
+  for (p=0; p<npieces; p++) {
+    if (!lens[p]) continue;
+    ierr  = PetscBinarySeek(fd,start+displs[p],PETSC_BINARY_SEEK_SET,&newoff);CHKERRQ(ierr);
+    ierr  = PetscBinaryRead(fd,cbuf,lens[p],dtype);CHKERRQ(ierr);
+    cbuf += lens[p]*dsize;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatView_Binary_Partitioned_Private"
+/*
+   Writes an AIJ matrix in the partitioned format, the rows of each process are one chunk.
+
+   Collective on Mat
+
+   Input Parameters:
++  mat - the matrix, the header and sizes are taken from it
+.  viewer - the binary viewer
+.  nz - the number of local nonzeros
+.  rowlens - the lengths of the local rows
+.  cols - the global column indices of the local rows, sorted in each row
+-  vals - the values
+
+   With MPI-IO every process writes its own chunk, otherwise the first process writes them all.
+*/
+PetscErrorCode MatView_Binary_Partitioned_Private(Mat mat,PetscViewer viewer,PetscInt nz,PetscInt rowlens[],PetscInt cols[],PetscScalar vals[])
+{
+  PetscErrorCode ierr;
+  MPI_Comm       comm = ((PetscObject)mat)->comm;
+  PetscMPIInt    rank,size,tag = ((PetscObject)viewer)->tag;
+  PetscInt       i,m = mat->rmap->n,header[4],*index,*crow,*cnz,mmax,nzmax,*rl,*rc;
+  PetscInt       message_count,flowcontrolcount;
+  PetscScalar    *rv;
+  int            fd;
+  FILE           *file;
+#if defined(PETSC_HAVE_MPIIO)
+  PetscBool      useMPIIO;
+#endif
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  ierr = PetscMalloc((2*size+2)*sizeof(PetscInt),&index);CHKERRQ(ierr);
+  index[0] = size;
+  crow     = index + 1;
+  cnz      = index + size + 2;
+  for (i=0; i<=size; i++) crow[i] = mat->rmap->range[i];
+  ierr = MPI_Allgather(&nz,1,MPIU_INT,cnz,1,MPIU_INT,comm);CHKERRQ(ierr);
+
+  header[0] = MAT_FILE_CLASSID;
+  header[1] = mat->rmap->N;
+  header[2] = mat->cmap->N;
+  header[3] = MATRIX_BINARY_FORMAT_PARTITIONED;
+  ierr = PetscViewerBinaryWrite(viewer,header,4,PETSC_INT,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryWrite(viewer,index,2*size+2,PETSC_INT,PETSC_FALSE);CHKERRQ(ierr);
+
+#if defined(PETSC_HAVE_MPIIO)
+  ierr = PetscViewerBinaryGetMPIIO(viewer,&useMPIIO);CHKERRQ(ierr);
+  if (useMPIIO) {
+    MPI_Offset moff;
+    off_t      off = 0,total = 0,len,displs[3];
+    PetscInt   lens[3];
+
+    for (i=0; i<size; i++) {
+      len    = (off_t)(crow[i+1] - crow[i] + cnz[i])*sizeof(PetscInt) + (off_t)cnz[i]*sizeof(PetscScalar);
+      if (i < rank) off += len;
+      total += len;
+    }
+    displs[0] = off; displs[1] = off + m*sizeof(PetscInt); displs[2] = off + (off_t)(m + nz)*sizeof(PetscInt);
+    lens[0]   = m;   lens[1]   = nz;                       lens[2]   = nz;
+    ierr = PetscViewerBinaryGetMPIIOOffset(viewer,&moff);CHKERRQ(ierr);
+    ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_TRUE,(off_t)moff,1,displs,lens,PETSC_INT,rowlens);CHKERRQ(ierr);
+    ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_TRUE,(off_t)moff,1,displs+1,lens+1,PETSC_INT,cols);CHKERRQ(ierr);
+    ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_TRUE,(off_t)moff,1,displs+2,lens+2,PETSC_SCALAR,vals);CHKERRQ(ierr);
+    ierr = PetscViewerBinaryAddMPIIOOffset(viewer,(MPI_Offset)total);CHKERRQ(ierr);
+  } else {
+#endif
+    /* the first process writes the chunks one after the other */
+    ierr = PetscViewerFlowControlStart(viewer,&message_count,&flowcontrolcount);CHKERRQ(ierr);
+    if (!rank) {
+      ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
+      ierr = PetscBinaryWrite(fd,rowlens,m,PETSC_INT,PETSC_FALSE);CHKERRQ(ierr);
+      ierr = PetscBinaryWrite(fd,cols,nz,PETSC_INT,PETSC_FALSE);CHKERRQ(ierr);
+      ierr = PetscBinaryWrite(fd,vals,nz,PETSC_SCALAR,PETSC_FALSE);CHKERRQ(ierr);
+      mmax = nzmax = 0;
+      for (i=1; i<size; i++) {
+        mmax  = PetscMax(mmax,crow[i+1] - crow[i]);
+        nzmax = PetscMax(nzmax,cnz[i]);
+      }
+      ierr = PetscMalloc3(mmax+1,PetscInt,&rl,nzmax+1,PetscInt,&rc,nzmax+1,PetscScalar,&rv);CHKERRQ(ierr);
+      for (i=1; i<size; i++) {
+        ierr = PetscViewerFlowControlStepMaster(viewer,i,message_count,flowcontrolcount);CHKERRQ(ierr);
+        ierr = MPIULong_Recv(rl,crow[i+1]-crow[i],MPIU_INT,i,tag,comm);CHKERRQ(ierr);
+        ierr = MPIULong_Recv(rc,cnz[i],MPIU_INT,i,tag,comm);CHKERRQ(ierr);
+        ierr = MPIULong_Recv(rv,cnz[i],MPIU_SCALAR,i,tag,comm);CHKERRQ(ierr);
+        ierr = PetscBinaryWrite(fd,rl,crow[i+1]-crow[i],PETSC_INT,PETSC_TRUE);CHKERRQ(ierr);
+        ierr = PetscBinaryWrite(fd,rc,cnz[i],PETSC_INT,PETSC_TRUE);CHKERRQ(ierr);
+        ierr = PetscBinaryWrite(fd,rv,cnz[i],PETSC_SCALAR,PETSC_TRUE);CHKERRQ(ierr);
+      }
+      ierr = PetscViewerFlowControlEndMaster(viewer,message_count);CHKERRQ(ierr);
+      ierr = PetscFree3(rl,rc,rv);CHKERRQ(ierr);
+    } else {
+      ierr = PetscViewerFlowControlStepWorker(viewer,rank,message_count);CHKERRQ(ierr);
+      ierr = MPIULong_Send(rowlens,m,MPIU_INT,0,tag,comm);CHKERRQ(ierr);
+      ierr = MPIULong_Send(cols,nz,MPIU_INT,0,tag,comm);CHKERRQ(ierr);
+      ierr = MPIULong_Send(vals,nz,MPIU_SCALAR,0,tag,comm);CHKERRQ(ierr);
+      ierr = PetscViewerFlowControlEndWorker(viewer,message_count);CHKERRQ(ierr);
+    }
+#if defined(PETSC_HAVE_MPIIO)
+  }
+#endif
+  ierr = PetscFree(index);CHKERRQ(ierr);
+
+  ierr = PetscViewerBinaryGetInfoPointer(viewer,&file);CHKERRQ(ierr);
+  if (file) {
+    fprintf(file,"-matload_block_size %d\n",(int)mat->rmap->bs);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "MatLoad_Binary_Partitioned_Private"
+/*
+   Loads an AIJ matrix stored in the partitioned format, the header was already read.
+
+   Collective on Mat
+
+   Input Parameters:
++  mat - the matrix, its sizes must be set
+-  viewer - the binary viewer
+
+   Each process reads the index and then only the parts of the chunks with its rows, directly from the file.
+   The matrix may be loaded on a different number of processes than it was written with.
+*/
+PetscErrorCode MatLoad_Binary_Partitioned_Private(Mat mat,PetscViewer viewer)
+{
+  PetscErrorCode ierr;
+  MPI_Comm       comm = ((PetscObject)viewer)->comm;
+  PetscMPIInt    rank;
+  PetscInt       nchunks,*crow,*cnz,c,c0,c1,p,npieces,i,j,k,rstart,rend,m,nz,nrl,lo,hi,skip;
+  PetscInt       *rl,*ii,*jj,*plens,*nzlens;
+  PetscScalar    *aa;
+  off_t          *coff,*pdispls,*jdispls,*adispls,start = 0,newoff;
+  PetscBool      useMPIIO = PETSC_FALSE,flg;
+  int            fd;
+
+  PetscFunctionBegin;
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryRead(viewer,&nchunks,1,PETSC_INT);CHKERRQ(ierr);
+  if (nchunks < 1) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"Partitioned matrix in file has %D chunks",nchunks);
+  ierr = PetscMalloc3(nchunks+1,PetscInt,&crow,nchunks,PetscInt,&cnz,nchunks+1,off_t,&coff);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryRead(viewer,crow,nchunks+1,PETSC_INT);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryRead(viewer,cnz,nchunks,PETSC_INT);CHKERRQ(ierr);
+  if (crow[0] || crow[nchunks] != mat->rmap->N) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"Index of partitioned matrix in file covers rows %D to %D",crow[0],crow[nchunks]);
+  coff[0] = 0;
+  for (c=0; c<nchunks; c++) {
+    if (crow[c+1] < crow[c] || cnz[c] < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_UNEXPECTED,"Corrupt index of partitioned matrix in file at chunk %D",c);
+    coff[c+1] = coff[c] + (off_t)(crow[c+1] - crow[c] + cnz[c])*sizeof(PetscInt) + (off_t)cnz[c]*sizeof(PetscScalar);
+  }
+
+  /* where the chunks start in the file */
+#if defined(PETSC_HAVE_MPIIO)
+  ierr = PetscViewerBinaryGetMPIIO(viewer,&useMPIIO);CHKERRQ(ierr);
+  if (useMPIIO) {
+    MPI_Offset moff;
+    ierr  = PetscViewerBinaryGetMPIIOOffset(viewer,&moff);CHKERRQ(ierr);
+    start = (off_t)moff;
+  }
+#endif
+  if (!useMPIIO) {
+    long long lstart;
+
+    ierr = PetscViewerBinaryGetDescriptor(viewer,&fd);CHKERRQ(ierr);
+    flg  = (PetscBool)(fd > 0);
+    ierr = MPI_Allreduce(MPI_IN_PLACE,&flg,1,MPIU_BOOL,MPI_LAND,comm);CHKERRQ(ierr);
+    if (!flg) SETERRQ(comm,PETSC_ERR_FILE_OPEN,"Every process must be able to open the file to load a partitioned matrix, or use -viewer_binary_mpiio");
+    if (!rank) {ierr = PetscBinarySeek(fd,0,PETSC_BINARY_SEEK_CUR,&start);CHKERRQ(ierr);}
+    lstart = (long long)start;
+    ierr   = MPI_Bcast(&lstart,1,MPI_LONG_LONG_INT,0,comm);CHKERRQ(ierr);
+    start  = (off_t)lstart;
+  }
+
+  /* the chunks with local rows */
+  ierr   = PetscLayoutSetUp(mat->rmap);CHKERRQ(ierr);
+  ierr   = PetscLayoutSetUp(mat->cmap);CHKERRQ(ierr);
+  rstart = mat->rmap->rstart;
+  rend   = mat->rmap->rend;
+  m      = rend - rstart;
+  for (c0=0; c0<nchunks && crow[c0+1] <= rstart; c0++) ;
+  for (c1=c0; c1<nchunks && crow[c1] < rend; c1++) ;
+  if (!m) c1 = c0;
+  npieces = c1 - c0;
+
+  /* the row lengths from the start of each chunk, the position of the local rows depends on the rows before them */
+  ierr = PetscMalloc5(npieces,PetscInt,&plens,npieces,PetscInt,&nzlens,npieces,off_t,&pdispls,npieces,off_t,&jdispls,npieces,off_t,&adispls);CHKERRQ(ierr);
+  for (p=0,nrl=0; p<npieces; p++) {
+    c          = c0 + p;
+    plens[p]   = PetscMin(rend,crow[c+1]) - crow[c];
+    pdispls[p] = coff[c];
+    nrl       += plens[p];
+  }
+  ierr = PetscMalloc(nrl*sizeof(PetscInt),&rl);CHKERRQ(ierr);
+  ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_FALSE,start,npieces,pdispls,plens,PETSC_INT,rl);CHKERRQ(ierr);
+
+  ierr  = PetscMalloc((m+1)*sizeof(PetscInt),&ii);CHKERRQ(ierr);
+  ii[0] = 0;
+  for (p=0,k=0,i=0; p<npieces; k+=plens[p],p++) {
+    c    = c0 + p;
+    lo   = PetscMax(rstart,crow[c]) - crow[c];
+    hi   = plens[p];
+    for (j=0,skip=0; j<lo; j++) skip += rl[k+j];
+    for (j=lo; j<hi; j++,i++) ii[i+1] = ii[i] + rl[k+j];
+    nzlens[p]  = 0;
+    for (j=lo; j<hi; j++) nzlens[p] += rl[k+j];
+    jdispls[p] = coff[c] + (off_t)(crow[c+1] - crow[c] + skip)*sizeof(PetscInt);
+    adispls[p] = coff[c] + (off_t)(crow[c+1] - crow[c] + cnz[c])*sizeof(PetscInt) + (off_t)skip*sizeof(PetscScalar);
+  }
+  if (i != m) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_PLIB,"Read %D rows instead of %D",i,m);
+  nz   = ii[m];
+  ierr = PetscMalloc2(nz+1,PetscInt,&jj,nz+1,PetscScalar,&aa);CHKERRQ(ierr);
+  ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_FALSE,start,npieces,jdispls,nzlens,PETSC_INT,jj);CHKERRQ(ierr);
+  ierr = MatBinaryPartitionedIO_Private(viewer,PETSC_FALSE,start,npieces,adispls,nzlens,PETSC_SCALAR,aa);CHKERRQ(ierr);
+
+  /* continue after the matrix */
+#if defined(PETSC_HAVE_MPIIO)
+  if (useMPIIO) {ierr = PetscViewerBinaryAddMPIIOOffset(viewer,(MPI_Offset)coff[nchunks]);CHKERRQ(ierr);}
+#endif
+  if (!useMPIIO && !rank) {ierr = PetscBinarySeek(fd,start+coff[nchunks],PETSC_BINARY_SEEK_SET,&newoff);CHKERRQ(ierr);}
+
+  ierr = MatSeqAIJSetPreallocationCSR(mat,ii,jj,aa);CHKERRQ(ierr);
+  ierr = MatMPIAIJSetPreallocationCSR(mat,ii,jj,aa);CHKERRQ(ierr);
+
+  ierr = PetscFree(rl);CHKERRQ(ierr);
+  ierr = PetscFree(ii);CHKERRQ(ierr);
+  ierr = PetscFree2(jj,aa);CHKERRQ(ierr);
+  ierr = PetscFree5(plens,nzlens,pdispls,jdispls,adispls);CHKERRQ(ierr);
+  ierr = PetscFree3(crow,cnz,coff);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
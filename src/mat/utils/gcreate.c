@@ -202,6 +202,10 @@ PetscErrorCode  MatSetFromOptions(Mat B)
       ierr = (*B->ops->setfromoptions)(B);CHKERRQ(ierr);
     }
 
+    flg = PETSC_FALSE;
+    ierr = PetscOptionsBool("-mat_store_single","Store the values in single precision","MatStoreSinglePrecision",flg,&flg,PETSC_NULL);CHKERRQ(ierr);
+    if (flg) {ierr = PetscTryMethod(B,"MatStoreSinglePrecision_C",(Mat,PetscBool),(B,PETSC_TRUE));CHKERRQ(ierr);}
+
     flg = PETSC_FALSE;
     ierr = PetscOptionsBool("-mat_new_nonzero_location_err","Generate an error if new nonzeros are created in the matrix structure (useful to test preallocation)","MatSetOption",flg,&flg,&set);CHKERRQ(ierr);
     if (set) {ierr = MatSetOption(B,MAT_NEW_NONZERO_LOCATION_ERR,flg);CHKERRQ(ierr);}
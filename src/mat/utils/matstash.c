@@ -1,14 +1,20 @@
 
 #include <petsc-private/matimpl.h>
+#include <../src/sys/utils/hash.h>
 
 #define DEFAULT_STASH_SIZE   10000
 
+/* maps the (row,col) of a stashed entry to the first stashed entry with the same indices */
+KHASH_INIT(MatStashIJ,PetscHashIJKey,PetscInt,1,IJKeyHash,IJKeyEqual)
+
 /*
   MatStashCreate_Private - Creates a stash,currently used for all the parallel
   matrix implementations. The stash is where elements of a matrix destined
   to be stored on other processors are kept until matrix assembly is done.
 
   This is a simple minded stash. Simply adds entries to end of stash.
+  With -matstash_coalesce the entries with the same (row,col) are combined
+  in MatStashScatterBegin_Private() so that each is sent only once.
 
   Input Parameters:
   comm - communicator, required for scatters.
@@ -71,6 +77,38 @@ PetscErrorCode MatStashCreate_Private(MPI_Comm comm,PetscInt bs,MatStash *stash)
 
   stash->reproduce   = PETSC_FALSE;
   ierr = PetscOptionsGetBool(PETSC_NULL,"-matstash_reproduce",&stash->reproduce,PETSC_NULL);CHKERRQ(ierr);
+  stash->coalesce    = PETSC_FALSE;
+  ierr = PetscOptionsGetBool(PETSC_NULL,"-matstash_coalesce",&stash->coalesce,PETSC_NULL);CHKERRQ(ierr);
+  stash->plan        = 0;
+  PetscFunctionReturn(0);
+}
+
+/*
+   MatStashPlanDestroy_Private - Destroys the communication plan of the stash,
+   and the message buffers that were kept with it
+*/
+#undef __FUNCT__
+#define __FUNCT__ "MatStashPlanDestroy_Private"
+static PetscErrorCode MatStashPlanDestroy_Private(MatStash *stash)
+{
+  PetscErrorCode ierr;
+  MatStashPlan   *plan = stash->plan;
+
+  PetscFunctionBegin;
+  if (!plan) PetscFunctionReturn(0);
+  ierr = PetscFree(plan->slot);CHKERRQ(ierr);
+  ierr = PetscFree(plan->idx);CHKERRQ(ierr);
+  ierr = PetscFree3(plan->sranks,plan->sstarts,plan->slens);CHKERRQ(ierr);
+  ierr = PetscFree3(plan->rranks,plan->rstarts,plan->rlens);CHKERRQ(ierr);
+  ierr = PetscFree(plan->loc);CHKERRQ(ierr);
+  ierr = PetscFree(stash->plan);CHKERRQ(ierr);
+  ierr = PetscFree(stash->send_waits);CHKERRQ(ierr);
+  ierr = PetscFree(stash->recv_waits);CHKERRQ(ierr);
+  ierr = PetscFree2(stash->svalues,stash->sindices);CHKERRQ(ierr);
+  ierr = PetscFree(stash->rvalues[0]);CHKERRQ(ierr);
+  ierr = PetscFree(stash->rvalues);CHKERRQ(ierr);
+  ierr = PetscFree(stash->rindices[0]);CHKERRQ(ierr);
+  ierr = PetscFree(stash->rindices);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -87,6 +125,7 @@ PetscErrorCode MatStashDestroy_Private(MatStash *stash)
   ierr = PetscMatStashSpaceDestroy(&stash->space_head);CHKERRQ(ierr);
   stash->space = 0;
   ierr = PetscFree(stash->flg_v);CHKERRQ(ierr);
+  ierr = MatStashPlanDestroy_Private(stash);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -103,15 +142,16 @@ PetscErrorCode MatStashDestroy_Private(MatStash *stash)
 PetscErrorCode MatStashScatterEnd_Private(MatStash *stash)
 {
   PetscErrorCode ierr;
-  PetscInt       nsends=stash->nsends,bs2,oldnmax,i;
+  PetscInt       nreqs=2*stash->nsends,bs2,oldnmax,i;
   MPI_Status     *send_status;
 
   PetscFunctionBegin;
   for (i=0; i<2*stash->size; i++) stash->flg_v[i] = -1;
-  /* wait on sends */
-  if (nsends) {
-    ierr = PetscMalloc(2*nsends*sizeof(MPI_Status),&send_status);CHKERRQ(ierr);
-    ierr = MPI_Waitall(2*nsends,stash->send_waits,send_status);CHKERRQ(ierr);
+  /* wait on sends, the plan sends only the values */
+  if (stash->plan && stash->plan->inuse) nreqs = stash->nsends;
+  if (nreqs) {
+    ierr = PetscMalloc(nreqs*sizeof(MPI_Status),&send_status);CHKERRQ(ierr);
+    ierr = MPI_Waitall(nreqs,stash->send_waits,send_status);CHKERRQ(ierr);
     ierr = PetscFree(send_status);CHKERRQ(ierr);
   }
 
@@ -130,6 +170,11 @@ PetscErrorCode MatStashScatterEnd_Private(MatStash *stash)
   stash->nprocessed = 0;
   ierr = PetscMatStashSpaceDestroy(&stash->space_head);CHKERRQ(ierr);
   stash->space      = 0;
+  /* the message buffers are reused by the next assembly */
+  if (stash->plan) {
+    stash->plan->inuse = PETSC_TRUE;
+    PetscFunctionReturn(0);
+  }
   ierr = PetscFree(stash->send_waits);CHKERRQ(ierr);
   ierr = PetscFree(stash->recv_waits);CHKERRQ(ierr);
   ierr = PetscFree2(stash->svalues,stash->sindices);CHKERRQ(ierr);
@@ -429,7 +474,62 @@ PetscErrorCode MatStashValuesColBlocked_Private(MatStash *stash,PetscInt row,Pet
   Notes: The 'owners' array in the cased of the blocked-stash has the
   ranges specified blocked global indices, and for the regular stash in
   the proper global indices.
+
+  If the stash coalesces, the entries with the same (row,col) are combined
+  with mat->insertmode before packing: added for ADD_VALUES, while for
+  INSERT_VALUES the last one stashed is kept, which is what the owner would
+  have done with them.
+
+  With MAT_SAME_OFF_PROC_ENTRIES the first scatter records the plan of the
+  messages, and the following ones are done by MatStashScatterBeginPlan_Private().
 */
+#undef __FUNCT__
+#define __FUNCT__ "MatStashScatterBeginPlan_Private"
+/*
+  MatStashScatterBeginPlan_Private - Sends the stashed values with the recorded
+  plan: no message lengths are exchanged, no indices are sent, and the values
+  are packed directly at their recorded position in the send buffer.
+*/
+static PetscErrorCode MatStashScatterBeginPlan_Private(Mat mat,MatStash *stash)
+{
+  MatStashPlan       *plan = stash->plan;
+  PetscInt           i,k,l,bs2 = stash->bs*stash->bs,*slot = plan->slot;
+  PetscScalar        *buf,*val;
+  PetscMatStashSpace space;
+  PetscErrorCode     ierr;
+
+  PetscFunctionBegin;
+  if (stash->n != plan->n) SETERRQ2(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"%D off-process entries were set, but %D in the first assembly with MAT_SAME_OFF_PROC_ENTRIES",stash->n,plan->n);
+  for (i=0; i<plan->nrecvs; i++) {
+    ierr = MPI_Irecv(stash->rvalues[i],bs2*plan->rlens[i],MPIU_SCALAR,plan->rranks[i],stash->tag2,stash->comm,stash->recv_waits+i);CHKERRQ(ierr);
+  }
+  i = 0;
+  for (space=stash->space_head; space; space=space->next) {
+    for (l=0; l<space->local_used; l++,i++) {
+#if defined(PETSC_USE_DEBUG)
+      if (space->idx[l] != plan->idx[2*i] || space->idy[l] != plan->idx[2*i+1]) SETERRQ4(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Off-process entry (%D,%D) was set where (%D,%D) was set in the first assembly with MAT_SAME_OFF_PROC_ENTRIES",space->idx[l],space->idy[l],plan->idx[2*i],plan->idx[2*i+1]);
+#endif
+      val = space->val + bs2*l;
+      if (slot[i] >= 0) {
+        buf = stash->svalues + bs2*slot[i];
+        for (k=0; k<bs2; k++) buf[k] = val[k];
+      } else {
+        buf = stash->svalues + bs2*slot[-(slot[i]+1)];
+        if (mat->insertmode == ADD_VALUES) {for (k=0; k<bs2; k++) buf[k] += val[k];}
+        else                               {for (k=0; k<bs2; k++) buf[k]  = val[k];}
+      }
+    }
+  }
+  for (i=0; i<plan->nsends; i++) {
+    ierr = MPI_Isend(stash->svalues+bs2*plan->sstarts[i],bs2*plan->slens[i],MPIU_SCALAR,plan->sranks[i],stash->tag2,stash->comm,stash->send_waits+i);CHKERRQ(ierr);
+  }
+  stash->nsends          = plan->nsends;
+  stash->nrecvs          = plan->nrecvs;
+  stash->nprocessed      = 0;
+  stash->reproduce_count = 0;
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "MatStashScatterBegin_Private"
 PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *owners)
@@ -445,9 +545,34 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
   PetscInt          *sp_idx,*sp_idy;
   PetscScalar       *sp_val;
   PetscMatStashSpace space,space_next;
+  PetscInt          *slot = PETSC_NULL,nunique;
+  khash_t(MatStashIJ) *ht = PETSC_NULL;
+  PetscHashIJKey    key;
+  khiter_t          hi;
+  khint_t           hret;
+  MatStashPlan      *plan = PETSC_NULL;
 
   PetscFunctionBegin;
   bs2 = stash->bs*stash->bs;
+  if (stash->plan && !mat->sameoffprocentries) {
+    ierr = MatStashPlanDestroy_Private(stash);CHKERRQ(ierr);
+  }
+  if (stash->plan) {
+    ierr = MatStashScatterBeginPlan_Private(mat,stash);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+  if (mat->sameoffprocentries) {
+    ierr = PetscMalloc(sizeof(MatStashPlan),&plan);CHKERRQ(ierr);
+    ierr = PetscMemzero(plan,sizeof(MatStashPlan));CHKERRQ(ierr);
+  }
+  if ((stash->coalesce || plan) && stash->n) {
+    /* slot[i] is -(first+1) if entry i repeats the indices of entry first, and later its position in svalues */
+    ierr = PetscMalloc(stash->n*sizeof(PetscInt),&slot);CHKERRQ(ierr);
+  }
+  if (stash->coalesce && stash->n) {
+    ht   = kh_init(MatStashIJ);
+    kh_resize(MatStashIJ,ht,stash->n);
+  }
 
   /*  first count number of contributors to each processor */
   ierr  = PetscMalloc(size*sizeof(PetscMPIInt),&nprocs);CHKERRQ(ierr);
@@ -458,11 +583,21 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
 
   i = j    = 0;
   lastidx  = -1;
+  nunique  = 0;
   space    = stash->space_head;
   while (space != PETSC_NULL){
     space_next = space->next;
     sp_idx     = space->idx;
+    sp_idy     = space->idy;
     for (l=0; l<space->local_used; l++){
+      if (slot) slot[i] = 0;
+      if (ht) {
+        key.i = sp_idx[l]; key.j = sp_idy[l];
+        hi    = kh_put(MatStashIJ,ht,key,&hret);
+        if (!hret) {slot[i] = -(kh_val(ht,hi)+1); i++; continue;}
+        kh_val(ht,hi) = i;
+        nunique++;
+      }
       /* if indices are NOT locally sorted, need to start search at the beginning */
       if (lastidx > (idx = sp_idx[l])) j = 0;
       lastidx = idx;
@@ -475,6 +610,7 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
     }
     space = space_next;
   }
+  if (ht) kh_destroy(MatStashIJ,ht);
   /* Now check what procs get messages - and compute nsends. */
   for (i=0, nsends=0 ; i<size; i++) {
     if (nlengths[i]) { nprocs[i] = 1; nsends ++;}
@@ -485,6 +621,16 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
   ierr = PetscGatherNumberOfMessages(comm,nprocs,nlengths,&nreceives);CHKERRQ(ierr);
   ierr = PetscGatherMessageLengths(comm,nsends,nreceives,nlengths,&onodes,&olengths);CHKERRQ(ierr);
   /* since clubbing row,col - lengths are multiplied by 2 */
+  if (plan) {
+    plan->nrecvs = nreceives;
+    ierr = PetscMalloc3(nreceives,PetscMPIInt,&plan->rranks,nreceives+1,PetscInt,&plan->rstarts,nreceives,PetscInt,&plan->rlens);CHKERRQ(ierr);
+    plan->rstarts[0] = 0;
+    for (i=0; i<nreceives; i++) {
+      plan->rranks[i]    = onodes[i];
+      plan->rlens[i]     = olengths[i];
+      plan->rstarts[i+1] = plan->rstarts[i] + olengths[i];
+    }
+  }
   for (i=0; i<nreceives; i++) olengths[i] *=2;
   ierr = PetscPostIrecvInt(comm,tag1,nreceives,onodes,olengths,&rindices,&recv_waits1);CHKERRQ(ierr);
   /* values are size 'bs2' lengths (and remove earlier factor 2 */
@@ -516,7 +662,18 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
     sp_idy = space->idy;
     sp_val = space->val;
     for (l=0; l<space->local_used; l++){
+      if (slot && slot[i] < 0) {
+        PetscInt    k;
+        PetscScalar *buf1,*buf2;
+        buf1 = svalues+bs2*slot[-(slot[i]+1)];
+        buf2 = sp_val + bs2*l;
+        if (mat->insertmode == ADD_VALUES) {for (k=0; k<bs2; k++) buf1[k] += buf2[k];}
+        else                               {for (k=0; k<bs2; k++) buf1[k]  = buf2[k];}
+        i++;
+        continue;
+      }
       j = owner[i];
+      if (slot) slot[i] = startv[j];
       if (bs2 == 1) {
         svalues[startv[j]] = sp_val[l];
       } else {
@@ -543,7 +700,37 @@ PetscErrorCode MatStashScatterBegin_Private(Mat mat,MatStash *stash,PetscInt *ow
       ierr = MPI_Isend(svalues+bs2*startv[i],bs2*nlengths[i],MPIU_SCALAR,i,tag2,comm,send_waits+count++);CHKERRQ(ierr);
     }
   }
+  if (plan) {
+    plan->n      = stash->n;
+    plan->slot   = slot;
+    plan->nsends = nsends;
+    ierr = PetscMalloc3(nsends,PetscMPIInt,&plan->sranks,nsends,PetscInt,&plan->sstarts,nsends,PetscInt,&plan->slens);CHKERRQ(ierr);
+    for (i=0,count=0; i<size; i++) {
+      if (nprocs[i]) {
+        plan->sranks[count]  = i;
+        plan->sstarts[count] = startv[i];
+        plan->slens[count++] = nlengths[i];
+      }
+    }
+    ierr = PetscMalloc((plan->rstarts[nreceives]+1)*sizeof(PetscInt),&plan->loc);CHKERRQ(ierr);
+    plan->locstate[0] = plan->locstate[1] = -1;
+#if defined(PETSC_USE_DEBUG)
+    ierr = PetscMalloc((2*stash->n+1)*sizeof(PetscInt),&plan->idx);CHKERRQ(ierr);
+    for (space=stash->space_head,i=0; space; space=space->next) {
+      for (l=0; l<space->local_used; l++,i++) {
+        plan->idx[2*i]   = space->idx[l];
+        plan->idx[2*i+1] = space->idy[l];
+      }
+    }
+#endif
+    stash->plan = plan;
+  } else {
+    ierr = PetscFree(slot);CHKERRQ(ierr);
+  }
 #if defined(PETSC_USE_INFO)
+  if (stash->coalesce) {
+    ierr = PetscInfo2(mat,"Coalesced %D stashed entries into %D\n",stash->n,nunique);CHKERRQ(ierr);
+  }
   ierr = PetscInfo1(mat,"No of messages: %d \n",nsends);CHKERRQ(ierr);
   for (i=0; i<size; i++) {
     if (nprocs[i]) {
@@ -613,6 +800,23 @@ PetscErrorCode MatStashScatterGetMesg_Private(MatStash *stash,PetscMPIInt *nvals
   if (stash->nprocessed == stash->nrecvs) { PetscFunctionReturn(0); }
 
   bs2   = stash->bs*stash->bs;
+  if (stash->plan && stash->plan->inuse) {
+    /* only the values are received, the indices are those recorded with the plan */
+    if (stash->reproduce) {
+      i = stash->reproduce_count++;
+      ierr = MPI_Wait(stash->recv_waits+i,&recv_status);CHKERRQ(ierr);
+    } else {
+      ierr = MPI_Waitany(stash->nrecvs,stash->recv_waits,&i,&recv_status);CHKERRQ(ierr);
+    }
+    *nvals              = stash->plan->rlens[i];
+    *rows               = stash->rindices[i];
+    *cols               = *rows + *nvals;
+    *vals               = stash->rvalues[i];
+    *flg                = 1;
+    stash->plan->current = i;
+    stash->nprocessed++;
+    PetscFunctionReturn(0);
+  }
   /* If a matching pair of receives are found, process them, and return the data to
      the calling function. Until then keep receiving messages */
   while (!match_found) {
@@ -651,3 +855,33 @@ PetscErrorCode MatStashScatterGetMesg_Private(MatStash *stash,PetscMPIInt *nvals
   }
   PetscFunctionReturn(0);
 }
+
+/*
+   MatStashPlanGetMesgLocations_Private - Gets the locations of the entries of
+   the message last returned by MatStashScatterGetMesg_Private(), when the
+   stash uses a communication plan. The matrix type computes and stores them
+   there, and keeps in locstate[] whatever it needs to know they are still valid.
+
+   Input Parameters:
+   stash - the stash
+
+   Output Parameters:
+   loc      - one location per entry of the message, or PETSC_NULL if the stash does not use a plan
+   locstate - two integers describing the matrix storage loc was computed for, -1 if it was not computed
+*/
+#undef __FUNCT__
+#define __FUNCT__ "MatStashPlanGetMesgLocations_Private"
+PetscErrorCode MatStashPlanGetMesgLocations_Private(MatStash *stash,PetscInt **loc,PetscInt **locstate)
+{
+  MatStashPlan *plan = stash->plan;
+
+  PetscFunctionBegin;
+  if (plan && plan->inuse) {
+    *loc      = plan->loc + plan->rstarts[plan->current];
+    *locstate = plan->locstate;
+  } else {
+    *loc      = PETSC_NULL;
+    *locstate = PETSC_NULL;
+  }
+  PetscFunctionReturn(0);
+}
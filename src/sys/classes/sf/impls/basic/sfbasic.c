@@ -1,40 +1,5 @@
 #define PETSC_DESIRE_COMPLEX
-#include <petsc-private/sfimpl.h> /*I "petscsf.h" I*/
-
-typedef struct _n_PetscSFBasicPack *PetscSFBasicPack;
-struct _n_PetscSFBasicPack {
-  void (*Pack)(PetscInt,const PetscInt*,const void*,void*);
-  void (*UnpackInsert)(PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackAdd)(PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMin)(PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMax)(PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMinloc)(PetscInt,const PetscInt*,void*,const void*);
-  void (*UnpackMaxloc)(PetscInt,const PetscInt*,void*,const void*);
-  void (*FetchAndInsert)(PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndAdd)(PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMin)(PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMax)(PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMinloc)(PetscInt,const PetscInt*,void*,void*);
-  void (*FetchAndMaxloc)(PetscInt,const PetscInt*,void*,void*);
-  MPI_Datatype unit;
-  size_t unitbytes;             /* Number of bytes in a unit */
-  const void *key;              /* Array used as key for operation */
-  char *root;                   /* Packed root data, contiguous by leaf rank */
-  char *leaf;                   /* Packed leaf data, contiguous by root rank */
-  MPI_Request *requests;        /* Array of root requests followed by leaf requests */
-  PetscSFBasicPack next;
-};
-
-typedef struct {
-  PetscMPIInt tag;
-  PetscInt niranks;             /* Number of incoming ranks (ranks accessing my roots) */
-  PetscMPIInt *iranks;          /* Array of ranks that reference my roots */
-  PetscInt itotal;              /* Total number of graph edges referencing my roots */
-  PetscInt *ioffset;            /* Array of length niranks+1 holding offset in irootloc[] for each rank */
-  PetscInt *irootloc;           /* Incoming roots referenced by ranks starting at ioffset[rank] */
-  PetscSFBasicPack avail;       /* One or more entries per MPI Datatype, lazily constructed */
-  PetscSFBasicPack inuse;       /* Buffers being used for transactions that have not yet completed */
-} PetscSF_Basic;
+#include <../src/sys/classes/sf/impls/basic/sfbasic.h> /*I "petscsf.h" I*/
 
 #if !defined(PETSC_HAVE_MPI_TYPE_DUP) /* Danger: type is not reference counted; subject to ABA problem */
 PETSC_STATIC_INLINE PetscErrorCode MPI_Type_dup(MPI_Datatype datatype,MPI_Datatype *newtype) { *newtype = datatype; return 0; }
@@ -305,7 +270,7 @@ DEF_Block(int,8)
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFSetUp_Basic"
-static PetscErrorCode PetscSFSetUp_Basic(PetscSF sf)
+PetscErrorCode PetscSFSetUp_Basic(PetscSF sf)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode ierr;
@@ -396,7 +361,7 @@ static PetscErrorCode PetscSFBasicPackTypeSetup(PetscSFBasicPack link,MPI_Dataty
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicPackGetUnpackOp"
-static PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF sf,PetscSFBasicPack link,MPI_Op op,void (**UnpackOp)(PetscInt,const PetscInt*,void*,const void*))
+PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF sf,PetscSFBasicPack link,MPI_Op op,void (**UnpackOp)(PetscInt,const PetscInt*,void*,const void*))
 {
   PetscFunctionBegin;
   *UnpackOp = PETSC_NULL;
@@ -451,7 +416,7 @@ static PetscErrorCode PetscSFBasicPackWaitall(PetscSF sf,PetscSFBasicPack link)
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicGetRootInfo"
-static PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,const PetscMPIInt **rootranks,const PetscInt **rootoffset,const PetscInt **rootloc)
+PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,const PetscMPIInt **rootranks,const PetscInt **rootoffset,const PetscInt **rootloc)
 {
   PetscSF_Basic  *bas = (PetscSF_Basic*)sf->data;
 
@@ -465,7 +430,7 @@ static PetscErrorCode PetscSFBasicGetRootInfo(PetscSF sf,PetscInt *nrootranks,co
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicGetLeafInfo"
-static PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,const PetscMPIInt **leafranks,const PetscInt **leafoffset,const PetscInt **leafloc)
+PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,const PetscMPIInt **leafranks,const PetscInt **leafoffset,const PetscInt **leafloc)
 {
   PetscFunctionBegin;
   if (nleafranks) *nleafranks = sf->nranks;
@@ -477,7 +442,7 @@ static PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF sf,PetscInt *nleafranks,co
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicGetPack"
-static PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const void *key,PetscSFBasicPack *mylink)
+PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const void *key,PetscSFBasicPack *mylink)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode ierr;
@@ -515,7 +480,7 @@ static PetscErrorCode PetscSFBasicGetPack(PetscSF sf,MPI_Datatype unit,const voi
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicGetPackInUse"
-static PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,const void *key,PetscCopyMode cmode,PetscSFBasicPack *mylink)
+PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,const void *key,PetscCopyMode cmode,PetscSFBasicPack *mylink)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode ierr;
@@ -542,7 +507,7 @@ static PetscErrorCode PetscSFBasicGetPackInUse(PetscSF sf,MPI_Datatype unit,cons
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFBasicReclaimPack"
-static PetscErrorCode PetscSFBasicReclaimPack(PetscSF sf,PetscSFBasicPack *link)
+PetscErrorCode PetscSFBasicReclaimPack(PetscSF sf,PetscSFBasicPack *link)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
 
@@ -568,7 +533,7 @@ static PetscErrorCode PetscSFSetFromOptions_Basic(PetscSF sf)
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFReset_Basic"
-static PetscErrorCode PetscSFReset_Basic(PetscSF sf)
+PetscErrorCode PetscSFReset_Basic(PetscSF sf)
 {
   PetscSF_Basic *bas = (PetscSF_Basic*)sf->data;
   PetscErrorCode ierr;
@@ -603,7 +568,7 @@ static PetscErrorCode PetscSFDestroy_Basic(PetscSF sf)
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFView_Basic"
-static PetscErrorCode PetscSFView_Basic(PetscSF sf,PetscViewer viewer)
+PetscErrorCode PetscSFView_Basic(PetscSF sf,PetscViewer viewer)
 {
   /* PetscSF_Basic *bas = (PetscSF_Basic*)sf->data; */
   PetscErrorCode ierr;
@@ -736,7 +701,7 @@ static PetscErrorCode PetscSFReduceEnd_Basic(PetscSF sf,MPI_Datatype unit,const
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFFetchAndOpBegin_Basic"
-static PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
 {
   PetscErrorCode ierr;
 
@@ -747,7 +712,7 @@ static PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF sf,MPI_Datatype unit,
 
 #undef __FUNCT__
 #define __FUNCT__ "PetscSFFetchAndOpEnd_Basic"
-static PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
+PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF sf,MPI_Datatype unit,void *rootdata,const void *leafdata,void *leafupdate,MPI_Op op)
 {
   PetscSF_Basic     *bas = (PetscSF_Basic*)sf->data;
   void              (*FetchAndOp)(PetscInt,const PetscInt*,void*,void*);
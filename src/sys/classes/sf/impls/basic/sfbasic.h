@@ -0,0 +1,54 @@
+#if !defined(__SFBASIC_H)
+#define __SFBASIC_H
+
+#include <petsc-private/sfimpl.h>
+
+typedef struct _n_PetscSFBasicPack *PetscSFBasicPack;
+struct _n_PetscSFBasicPack {
+  void (*Pack)(PetscInt,const PetscInt*,const void*,void*);
+  void (*UnpackInsert)(PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackAdd)(PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMin)(PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMax)(PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMinloc)(PetscInt,const PetscInt*,void*,const void*);
+  void (*UnpackMaxloc)(PetscInt,const PetscInt*,void*,const void*);
+  void (*FetchAndInsert)(PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndAdd)(PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMin)(PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMax)(PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMinloc)(PetscInt,const PetscInt*,void*,void*);
+  void (*FetchAndMaxloc)(PetscInt,const PetscInt*,void*,void*);
+  MPI_Datatype unit;
+  size_t unitbytes;             /* Number of bytes in a unit */
+  const void *key;              /* Array used as key for operation */
+  char *root;                   /* Packed root data, contiguous by leaf rank */
+  char *leaf;                   /* Packed leaf data, contiguous by root rank */
+  MPI_Request *requests;        /* Array of root requests followed by leaf requests */
+  PetscSFBasicPack next;
+};
+
+typedef struct {
+  PetscMPIInt tag;
+  PetscInt niranks;             /* Number of incoming ranks (ranks accessing my roots) */
+  PetscMPIInt *iranks;          /* Array of ranks that reference my roots */
+  PetscInt itotal;              /* Total number of graph edges referencing my roots */
+  PetscInt *ioffset;            /* Array of length niranks+1 holding offset in irootloc[] for each rank */
+  PetscInt *irootloc;           /* Incoming roots referenced by ranks starting at ioffset[rank] */
+  PetscSFBasicPack avail;       /* One or more entries per MPI Datatype, lazily constructed */
+  PetscSFBasicPack inuse;       /* Buffers being used for transactions that have not yet completed */
+} PetscSF_Basic;
+
+extern PetscErrorCode PetscSFSetUp_Basic(PetscSF);
+extern PetscErrorCode PetscSFReset_Basic(PetscSF);
+extern PetscErrorCode PetscSFView_Basic(PetscSF,PetscViewer);
+extern PetscErrorCode PetscSFReduceBegin_Basic(PetscSF,MPI_Datatype,const void*,void*,MPI_Op);
+extern PetscErrorCode PetscSFFetchAndOpBegin_Basic(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op);
+extern PetscErrorCode PetscSFFetchAndOpEnd_Basic(PetscSF,MPI_Datatype,void*,const void*,void*,MPI_Op);
+extern PetscErrorCode PetscSFBasicGetRootInfo(PetscSF,PetscInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
+extern PetscErrorCode PetscSFBasicGetLeafInfo(PetscSF,PetscInt*,const PetscMPIInt**,const PetscInt**,const PetscInt**);
+extern PetscErrorCode PetscSFBasicGetPack(PetscSF,MPI_Datatype,const void*,PetscSFBasicPack*);
+extern PetscErrorCode PetscSFBasicGetPackInUse(PetscSF,MPI_Datatype,const void*,PetscCopyMode,PetscSFBasicPack*);
+extern PetscErrorCode PetscSFBasicReclaimPack(PetscSF,PetscSFBasicPack*);
+extern PetscErrorCode PetscSFBasicPackGetUnpackOp(PetscSF,PetscSFBasicPack,MPI_Op,void (**)(PetscInt,const PetscInt*,void*,const void*));
+
+#endif
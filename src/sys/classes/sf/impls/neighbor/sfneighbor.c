@@ -0,0 +1,196 @@
+#include <../src/sys/classes/sf/impls/basic/sfbasic.h> /*I "petscsf.h" I*/
+
+/*
+ * The neighbor implementation uses the rank information computed by PetscSFSetUp_Basic() and the packing
+ * routines of the basic implementation, but moves all the data of one operation with a single
+ * MPI_Neighbor_alltoallv() on a distributed graph communicator instead of one message per rank.
+ */
+
+typedef struct {
+  PetscSF_Basic bas;            /* Must be first, the basic routines access sf->data as PetscSF_Basic */
+  MPI_Comm      distcomm[2];    /* Graph communicators for data flowing root to leaf (Bcast) and leaf to root (Reduce) */
+  PetscMPIInt   *rootcounts;    /* Number of units exchanged with each root rank (bas.iranks) */
+  PetscMPIInt   *rootdispls;    /* Offset in units of each root rank in the packed root buffer */
+  PetscMPIInt   *leafcounts;    /* Number of units exchanged with each leaf rank (sf->ranks) */
+  PetscMPIInt   *leafdispls;    /* Offset in units of each leaf rank in the packed leaf buffer */
+} PetscSF_Neighbor;
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFSetUp_Neighbor"
+static PetscErrorCode PetscSFSetUp_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor  *dat = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode    ierr;
+  PetscInt          i,nrootranks,nleafranks;
+  const PetscInt    *rootoffset,*leafoffset;
+  const PetscMPIInt *rootranks,*leafranks;
+  PetscMPIInt       indegree,outdegree;
+
+  PetscFunctionBegin;
+  ierr = PetscSFSetUp_Basic(sf);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,&rootranks,&rootoffset,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,&leafranks,&leafoffset,PETSC_NULL);CHKERRQ(ierr);
+
+  /* The offsets do not depend on the unit, so the counts are computed once for all operations */
+  ierr = PetscMalloc4(nrootranks,PetscMPIInt,&dat->rootcounts,nrootranks,PetscMPIInt,&dat->rootdispls,nleafranks,PetscMPIInt,&dat->leafcounts,nleafranks,PetscMPIInt,&dat->leafdispls);CHKERRQ(ierr);
+  for (i=0; i<nrootranks; i++) {
+    dat->rootcounts[i] = PetscMPIIntCast(rootoffset[i+1] - rootoffset[i]);
+    dat->rootdispls[i] = PetscMPIIntCast(rootoffset[i]);
+  }
+  for (i=0; i<nleafranks; i++) {
+    dat->leafcounts[i] = PetscMPIIntCast(leafoffset[i+1] - leafoffset[i]);
+    dat->leafdispls[i] = PetscMPIIntCast(leafoffset[i]);
+  }
+
+  /* Roots send to the ranks referencing them and leaves receive from the ranks owning their roots; Reduce is the reverse */
+  indegree  = PetscMPIIntCast(nleafranks);
+  outdegree = PetscMPIIntCast(nrootranks);
+  ierr = MPI_Dist_graph_create_adjacent(((PetscObject)sf)->comm,indegree,(PetscMPIInt*)leafranks,MPI_UNWEIGHTED,outdegree,(PetscMPIInt*)rootranks,MPI_UNWEIGHTED,MPI_INFO_NULL,0,&dat->distcomm[0]);CHKERRQ(ierr);
+  ierr = MPI_Dist_graph_create_adjacent(((PetscObject)sf)->comm,outdegree,(PetscMPIInt*)rootranks,MPI_UNWEIGHTED,indegree,(PetscMPIInt*)leafranks,MPI_UNWEIGHTED,MPI_INFO_NULL,0,&dat->distcomm[1]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFSetFromOptions_Neighbor"
+static PetscErrorCode PetscSFSetFromOptions_Neighbor(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscOptionsHead("PetscSF Neighbor options");CHKERRQ(ierr);
+  ierr = PetscOptionsTail();CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFReset_Neighbor"
+static PetscErrorCode PetscSFReset_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor *dat = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode   ierr;
+  PetscInt         i;
+
+  PetscFunctionBegin;
+  for (i=0; i<2; i++) {
+    if (dat->distcomm[i] != MPI_COMM_NULL) {ierr = MPI_Comm_free(&dat->distcomm[i]);CHKERRQ(ierr);}
+  }
+  ierr = PetscFree4(dat->rootcounts,dat->rootdispls,dat->leafcounts,dat->leafdispls);CHKERRQ(ierr);
+  ierr = PetscSFReset_Basic(sf);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFDestroy_Neighbor"
+static PetscErrorCode PetscSFDestroy_Neighbor(PetscSF sf)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscSFReset_Neighbor(sf);CHKERRQ(ierr);
+  ierr = PetscFree(sf->data);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFBcastBegin_Neighbor"
+/* Send from roots to leaves; MPI_Neighbor_alltoallv() is blocking so all communication is done here */
+static PetscErrorCode PetscSFBcastBegin_Neighbor(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata)
+{
+  PetscSF_Neighbor *dat = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+  PetscInt         nrootranks;
+  const PetscInt   *rootoffset,*rootloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,PETSC_NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetPack(sf,unit,rootdata,&link);CHKERRQ(ierr);
+  /* The packed root buffer is contiguous by rank, so it is packed with one call */
+  (*link->Pack)(rootoffset[nrootranks],rootloc,rootdata,link->root);
+  ierr = MPI_Neighbor_alltoallv(link->root,dat->rootcounts,dat->rootdispls,unit,link->leaf,dat->leafcounts,dat->leafdispls,unit,dat->distcomm[0]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFBcastEnd_Neighbor"
+static PetscErrorCode PetscSFBcastEnd_Neighbor(PetscSF sf,MPI_Datatype unit,const void *rootdata,void *leafdata)
+{
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+  PetscInt         nleafranks;
+  const PetscInt   *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,PETSC_NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+  (*link->UnpackInsert)(leafoffset[nleafranks],leafloc,leafdata,link->leaf);
+  ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFReduceBegin_Neighbor"
+/* leaf -> root with reduction */
+static PetscErrorCode PetscSFReduceBegin_Neighbor(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  PetscSF_Neighbor *dat = (PetscSF_Neighbor*)sf->data;
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+  PetscInt         nleafranks;
+  const PetscInt   *leafoffset,*leafloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetLeafInfo(sf,&nleafranks,PETSC_NULL,&leafoffset,&leafloc);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetPack(sf,unit,rootdata,&link);CHKERRQ(ierr);
+  (*link->Pack)(leafoffset[nleafranks],leafloc,leafdata,link->leaf);
+  ierr = MPI_Neighbor_alltoallv(link->leaf,dat->leafcounts,dat->leafdispls,unit,link->root,dat->rootcounts,dat->rootdispls,unit,dat->distcomm[1]);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFReduceEnd_Neighbor"
+static PetscErrorCode PetscSFReduceEnd_Neighbor(PetscSF sf,MPI_Datatype unit,const void *leafdata,void *rootdata,MPI_Op op)
+{
+  void             (*UnpackOp)(PetscInt,const PetscInt*,void*,const void*);
+  PetscErrorCode   ierr;
+  PetscSFBasicPack link;
+  PetscInt         nrootranks;
+  const PetscInt   *rootoffset,*rootloc;
+
+  PetscFunctionBegin;
+  ierr = PetscSFBasicGetPackInUse(sf,unit,rootdata,PETSC_OWN_POINTER,&link);CHKERRQ(ierr);
+  ierr = PetscSFBasicGetRootInfo(sf,&nrootranks,PETSC_NULL,&rootoffset,&rootloc);CHKERRQ(ierr);
+  ierr = PetscSFBasicPackGetUnpackOp(sf,link,op,&UnpackOp);CHKERRQ(ierr);
+  /* Roots referenced more than once are combined in rank order, as in the basic implementation */
+  (*UnpackOp)(rootoffset[nrootranks],rootloc,rootdata,link->root);
+  ierr = PetscSFBasicReclaimPack(sf,&link);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscSFCreate_Neighbor"
+PETSC_EXTERN_C PetscErrorCode PetscSFCreate_Neighbor(PetscSF sf)
+{
+  PetscSF_Neighbor *dat;
+  PetscErrorCode   ierr;
+
+  PetscFunctionBegin;
+  sf->ops->SetUp           = PetscSFSetUp_Neighbor;
+  sf->ops->SetFromOptions  = PetscSFSetFromOptions_Neighbor;
+  sf->ops->Reset           = PetscSFReset_Neighbor;
+  sf->ops->Destroy         = PetscSFDestroy_Neighbor;
+  sf->ops->View            = PetscSFView_Basic;
+  sf->ops->BcastBegin      = PetscSFBcastBegin_Neighbor;
+  sf->ops->BcastEnd        = PetscSFBcastEnd_Neighbor;
+  sf->ops->ReduceBegin     = PetscSFReduceBegin_Neighbor;
+  sf->ops->ReduceEnd       = PetscSFReduceEnd_Neighbor;
+  /* Fetch-and-op needs a round trip with a local update in between, it uses the point-to-point messages of the basic implementation */
+  sf->ops->FetchAndOpBegin = PetscSFFetchAndOpBegin_Basic;
+  sf->ops->FetchAndOpEnd   = PetscSFFetchAndOpEnd_Basic;
+
+  ierr = PetscNewLog(sf,PetscSF_Neighbor,&dat);CHKERRQ(ierr);
+  dat->distcomm[0] = MPI_COMM_NULL;
+  dat->distcomm[1] = MPI_COMM_NULL;
+  sf->data = (void*)dat;
+  PetscFunctionReturn(0);
+}
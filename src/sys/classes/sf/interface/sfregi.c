@@ -4,6 +4,9 @@
 PETSC_EXTERN_C PetscErrorCode PetscSFCreate_Window(PetscSF);
 #endif
 PETSC_EXTERN_C PetscErrorCode PetscSFCreate_Basic(PetscSF);
+#if defined(PETSC_HAVE_MPI_DIST_GRAPH_CREATE_ADJACENT) && defined(PETSC_HAVE_MPI_NEIGHBOR_ALLTOALLV)
+PETSC_EXTERN_C PetscErrorCode PetscSFCreate_Neighbor(PetscSF);
+#endif
 
 PetscFunctionList PetscSFunctionList;
 
@@ -30,6 +33,9 @@ PetscErrorCode  PetscSFRegisterAll(const char path[])
   ierr = PetscSFRegisterDynamic(PETSCSFWINDOW,       path,"PetscSFCreate_Window",       PetscSFCreate_Window);CHKERRQ(ierr);
 #endif
   ierr = PetscSFRegisterDynamic(PETSCSFBASIC,        path,"PetscSFCreate_Basic",        PetscSFCreate_Basic);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_MPI_DIST_GRAPH_CREATE_ADJACENT) && defined(PETSC_HAVE_MPI_NEIGHBOR_ALLTOALLV)
+  ierr = PetscSFRegisterDynamic(PETSCSFNEIGHBOR,     path,"PetscSFCreate_Neighbor",     PetscSFCreate_Neighbor);CHKERRQ(ierr);
+#endif
   PetscFunctionReturn(0);
 }
 
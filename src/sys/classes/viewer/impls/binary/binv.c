@@ -7,6 +7,51 @@
 #if defined (PETSC_HAVE_IO_H)
 #include <io.h>
 #endif
+#if defined(PETSC_HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+#include <errno.h>
+#if defined(PETSC_HAVE_MMAP) && defined(PETSC_HAVE_SYS_MMAN_H)
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+/*
+   Asynchronous writes: the values are gathered into a staging buffer on one aggregator process per group
+   of consecutive processes, the aggregator writes its contiguous piece of the file in the background
+*/
+typedef struct _n_PetscViewerBinaryAsyncJob *PetscViewerBinaryAsyncJob;
+struct _n_PetscViewerBinaryAsyncJob {
+  char                      *buf;      /* staged values of the group */
+  size_t                    len;       /* length of buf in bytes */
+  size_t                    unit;      /* size of the items to byte swap, 1 if none */
+  off_t                     off;       /* location of buf in the file */
+  PetscBool                 done;
+  PetscViewerBinaryAsyncJob next;
+};
+
+typedef struct {
+  MPI_Comm                  comm;      /* the processes sharing one aggregator, process 0 of it is the aggregator */
+  int                       fdes;      /* the aggregator's own descriptor for the file, -1 on the other processes */
+  int                       err;       /* errno of the first failed write */
+  PetscViewerBinaryAsyncJob head,tail; /* staged writes in the order they were made */
+  PetscViewerBinaryAsyncJob pending;   /* first staged write not yet started */
+#if defined(PETSC_HAVE_PTHREAD)
+  PetscBool                 running,stop;
+  pthread_t                 thread;
+  pthread_mutex_t           mutex;
+  pthread_cond_t            work,done;
+#endif
+} PetscViewerBinaryAsync;
+
+/*
+   The file mapped copy-on-write for PetscViewerBinaryReadMapped(), it is kept until the viewer and all
+   the objects using memory in it are destroyed
+*/
+typedef struct {
+  char   *addr;
+  size_t len;
+} PetscViewerBinaryMap;
 
 typedef struct  {
   int           fdes;            /* file descriptor, ignored if using MPI IO */
@@ -23,6 +68,13 @@ typedef struct  {
   PetscBool     skipoptions;     /* don't use PETSc options database when loading */
   PetscInt      flowcontrol;     /* allow only <flowcontrol> messages outstanding at a time while doing IO */
   PetscBool     skipheader;      /* don't write header, only raw data */
+  PetscBool     async;           /* stage the values of vectors and write them in the background */
+  PetscInt      asyncgroup;      /* number of processes sharing one aggregator for asynchronous writes */
+  PetscViewerBinaryAsync *actx;  /* created by the first asynchronous write */
+  PetscBool     usemmap;         /* let objects loaded from the file use the memory mapped file */
+  PetscContainer map;           /* the PetscViewerBinaryMap, created by the first mapped read */
+  off_t         mapend;          /* end of the part of the file handed out by mapped reads */
+  PetscBool     partitioned;     /* store AIJ matrices in blocks of rows with an index */
 } PetscViewer_Binary;
 
 #undef __FUNCT__
@@ -40,6 +92,10 @@ PetscErrorCode PetscViewerGetSingleton_Binary(PetscViewer viewer,PetscViewer *ou
     ierr    = PetscViewerSetType(*outviewer,PETSCVIEWERBINARY);CHKERRQ(ierr);
     obinary = (PetscViewer_Binary*)(*outviewer)->data;
     ierr    = PetscMemcpy(obinary,vbinary,sizeof(PetscViewer_Binary));CHKERRQ(ierr);
+    obinary->async   = PETSC_FALSE;
+    obinary->actx    = 0;
+    obinary->usemmap = PETSC_FALSE;
+    obinary->map     = 0;
   } else {
     *outviewer = 0;
   }
@@ -556,6 +612,218 @@ PetscErrorCode  PetscViewerBinaryGetInfoPointer(PetscViewer viewer,FILE **file)
   PetscFunctionReturn(0);
 }
 
+#if defined(PETSC_HAVE_PWRITE) && defined(PETSC_HAVE_FTRUNCATE)
+/*
+   Writes one staged piece of the file; runs in the background thread so it must not call PETSc
+*/
+static void PetscViewerBinaryAsyncRun_Private(PetscViewerBinaryAsync *actx,PetscViewerBinaryAsyncJob job)
+{
+  char    *p = job->buf;
+  size_t  m = job->len;
+  off_t   off = job->off;
+  ssize_t w;
+#if !defined(PETSC_WORDS_BIGENDIAN)
+  size_t  i,j,u = job->unit;
+  char    c;
+
+  /* binary files are big endian */
+  if (u > 1) {
+    for (i=0; i<m; i+=u) {
+      for (j=0; j<u/2; j++) {
+        c = p[i+j]; p[i+j] = p[i+u-1-j]; p[i+u-1-j] = c;
+      }
+    }
+  }
+#endif
+  while (m) {
+    w = pwrite(actx->fdes,p,m,off);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) {
+      if (!actx->err) actx->err = (w < 0) ? errno : EIO;
+      break;
+    }
+    p += w; m -= (size_t)w; off += w;
+  }
+}
+
+#if defined(PETSC_HAVE_PTHREAD)
+static void* PetscViewerBinaryAsyncThread_Private(void *arg)
+{
+  PetscViewerBinaryAsync    *actx = (PetscViewerBinaryAsync*)arg;
+  PetscViewerBinaryAsyncJob job;
+
+  pthread_mutex_lock(&actx->mutex);
+  while (1) {
+    while (!actx->pending && !actx->stop) pthread_cond_wait(&actx->work,&actx->mutex);
+    if (!actx->pending) break;
+    job           = actx->pending;
+    actx->pending = job->next;
+    pthread_mutex_unlock(&actx->mutex);
+    PetscViewerBinaryAsyncRun_Private(actx,job);
+    pthread_mutex_lock(&actx->mutex);
+    job->done = PETSC_TRUE;
+    pthread_cond_signal(&actx->done);
+  }
+  pthread_mutex_unlock(&actx->mutex);
+  return 0;
+}
+#endif
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncPush_Private"
+/* hands a staged write to the background thread, or does it right away without threads */
+static PetscErrorCode PetscViewerBinaryAsyncPush_Private(PetscViewerBinaryAsync *actx,PetscViewerBinaryAsyncJob job)
+{
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_PTHREAD)
+  if (!actx->running) {
+    if (pthread_create(&actx->thread,PETSC_NULL,PetscViewerBinaryAsyncThread_Private,actx)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SYS,"Unable to create thread for asynchronous writes");
+    actx->running = PETSC_TRUE;
+  }
+  pthread_mutex_lock(&actx->mutex);
+  if (actx->tail) actx->tail->next = job;
+  else            actx->head       = job;
+  actx->tail = job;
+  if (!actx->pending) actx->pending = job;
+  pthread_cond_signal(&actx->work);
+  pthread_mutex_unlock(&actx->mutex);
+#else
+  PetscViewerBinaryAsyncRun_Private(actx,job);
+  job->done = PETSC_TRUE;
+  if (actx->tail) actx->tail->next = job;
+  else            actx->head       = job;
+  actx->tail = job;
+#endif
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncReap_Private"
+/* frees the staging buffers of the completed writes, with wait it first waits for all of them to complete */
+static PetscErrorCode PetscViewerBinaryAsyncReap_Private(PetscViewerBinaryAsync *actx,PetscBool wait)
+{
+  PetscErrorCode            ierr;
+  PetscViewerBinaryAsyncJob list = 0,last,next;
+
+  PetscFunctionBegin;
+#if defined(PETSC_HAVE_PTHREAD)
+  pthread_mutex_lock(&actx->mutex);
+  /* the writes complete in order */
+  while (wait && actx->tail && !actx->tail->done) pthread_cond_wait(&actx->done,&actx->mutex);
+#endif
+  if (actx->head && actx->head->done) {
+    list = last = actx->head;
+    while (last->next && last->next->done) last = last->next;
+    actx->head = last->next;
+    last->next = 0;
+    if (!actx->head) actx->tail = 0;
+  }
+#if defined(PETSC_HAVE_PTHREAD)
+  pthread_mutex_unlock(&actx->mutex);
+#endif
+  while (list) {
+    next = list->next;
+    ierr = PetscFree(list->buf);CHKERRQ(ierr);
+    ierr = PetscFree(list);CHKERRQ(ierr);
+    list = next;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncWait_Private"
+static PetscErrorCode PetscViewerBinaryAsyncWait_Private(PetscViewer viewer)
+{
+  PetscViewer_Binary     *vbinary = (PetscViewer_Binary*)viewer->data;
+  PetscViewerBinaryAsync *actx = vbinary->actx;
+  PetscErrorCode         ierr;
+  int                    err,gerr;
+
+  PetscFunctionBegin;
+  if (!actx) PetscFunctionReturn(0);
+  ierr = PetscViewerBinaryAsyncReap_Private(actx,PETSC_TRUE);CHKERRQ(ierr);
+  err  = actx->err;
+  actx->err = 0;
+  ierr = MPI_Allreduce(&err,&gerr,1,MPI_INT,MPI_MAX,((PetscObject)viewer)->comm);CHKERRQ(ierr);
+  if (err) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_WRITE,"Error writing staged values to file, errno %d",err);
+  if (gerr) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_WRITE,"Error writing staged values to file on another process");
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncGetContext_Private"
+static PetscErrorCode PetscViewerBinaryAsyncGetContext_Private(PetscViewer viewer,PetscViewerBinaryAsync **actx)
+{
+  PetscViewer_Binary *vbinary = (PetscViewer_Binary*)viewer->data;
+  PetscErrorCode     ierr;
+  PetscMPIInt        rank;
+
+  PetscFunctionBegin;
+  if (!vbinary->actx) {
+    ierr = PetscNew(PetscViewerBinaryAsync,&vbinary->actx);CHKERRQ(ierr);
+    ierr = MPI_Comm_rank(((PetscObject)viewer)->comm,&rank);CHKERRQ(ierr);
+    ierr = MPI_Comm_split(((PetscObject)viewer)->comm,rank/PetscMax(vbinary->asyncgroup,1),rank,&vbinary->actx->comm);CHKERRQ(ierr);
+    vbinary->actx->fdes = -1;
+#if defined(PETSC_HAVE_PTHREAD)
+    pthread_mutex_init(&vbinary->actx->mutex,PETSC_NULL);
+    pthread_cond_init(&vbinary->actx->work,PETSC_NULL);
+    pthread_cond_init(&vbinary->actx->done,PETSC_NULL);
+#endif
+  }
+  *actx = vbinary->actx;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncDestroy_Private"
+/* completes the staged writes and stops the background thread, must be called before the file is closed */
+static PetscErrorCode PetscViewerBinaryAsyncDestroy_Private(PetscViewer viewer)
+{
+  PetscViewer_Binary     *vbinary = (PetscViewer_Binary*)viewer->data;
+  PetscViewerBinaryAsync *actx = vbinary->actx;
+  PetscErrorCode         ierr,werr;
+
+  PetscFunctionBegin;
+  if (!actx) PetscFunctionReturn(0);
+  werr = PetscViewerBinaryAsyncWait_Private(viewer);
+#if defined(PETSC_HAVE_PTHREAD)
+  if (actx->running) {
+    pthread_mutex_lock(&actx->mutex);
+    actx->stop = PETSC_TRUE;
+    pthread_cond_signal(&actx->work);
+    pthread_mutex_unlock(&actx->mutex);
+    pthread_join(actx->thread,PETSC_NULL);
+  }
+  pthread_cond_destroy(&actx->done);
+  pthread_cond_destroy(&actx->work);
+  pthread_mutex_destroy(&actx->mutex);
+#endif
+  if (actx->fdes != -1) close(actx->fdes);
+  ierr = MPI_Comm_free(&actx->comm);CHKERRQ(ierr);
+  ierr = PetscFree(vbinary->actx);CHKERRQ(ierr);
+  CHKERRQ(werr);
+  PetscFunctionReturn(0);
+}
+
+#else
+/* without pwrite() and ftruncate() PetscViewerBinaryWriteAsync() writes the values right away, nothing is staged */
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncWait_Private"
+static PetscErrorCode PetscViewerBinaryAsyncWait_Private(PetscViewer viewer)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryAsyncDestroy_Private"
+static PetscErrorCode PetscViewerBinaryAsyncDestroy_Private(PetscViewer viewer)
+{
+  PetscFunctionBegin;
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "PetscViewerFileClose_Binary"
 static PetscErrorCode PetscViewerFileClose_Binary(PetscViewer v)
@@ -566,7 +834,10 @@ static PetscErrorCode PetscViewerFileClose_Binary(PetscViewer v)
   int                err;
 
   PetscFunctionBegin;
+  ierr = PetscViewerBinaryAsyncDestroy_Private(v);CHKERRQ(ierr);
   ierr = MPI_Comm_rank(((PetscObject)v)->comm,&rank);CHKERRQ(ierr);
+  ierr = PetscContainerDestroy(&vbinary->map);CHKERRQ(ierr);
+  vbinary->mapend = 0;
   if ((!rank || vbinary->btype == FILE_MODE_READ) && vbinary->fdes) {
     close(vbinary->fdes);
     if (!rank && vbinary->storecompressed) {
@@ -615,6 +886,7 @@ static PetscErrorCode PetscViewerFileClose_MPIIO(PetscViewer v)
   PetscErrorCode     ierr;
 
   PetscFunctionBegin;
+  ierr = PetscViewerBinaryAsyncDestroy_Private(v);CHKERRQ(ierr);
   if (vbinary->mfdes) {
     ierr = MPI_File_close(&vbinary->mfdes);CHKERRQ(ierr);
   }
@@ -810,6 +1082,560 @@ PetscErrorCode  PetscViewerBinaryWrite(PetscViewer viewer,void *data,PetscInt co
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinarySetMmap"
+/*@
+    PetscViewerBinarySetMmap - objects loaded from the file may use the memory mapped file for their values
+    instead of copies read from the file
+
+    Not Collective
+
+    Input Parameters:
++   viewer - PetscViewer context, obtained from PetscViewerBinaryOpen()
+-   flg - PETSC_TRUE to use the memory mapped file
+
+    Options Database Key:
+.   -viewer_binary_mmap - use the memory mapped file
+
+    Level: advanced
+
+    Notes: Only used by sequential viewers, for example the per process files of a partitioned data set
+    opened on PETSC_COMM_SELF, in FILE_MODE_READ. The file is mapped copy-on-write, so changing the loaded objects
+    does not change the file. The mapping is released when the viewer and all the objects using it are destroyed.
+
+    This must be called after PetscViewerSetType()
+
+   Concepts: PetscViewerBinary^memory mapped files
+
+.seealso: PetscViewerBinaryOpen(), PetscViewerBinaryGetMmap(), PetscViewerBinaryReadMapped(), VecLoad(), MatLoad()
+@*/
+PetscErrorCode  PetscViewerBinarySetMmap(PetscViewer viewer,PetscBool flg)
+{
+  PetscViewer_Binary *vbinary;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  vbinary = (PetscViewer_Binary*)viewer->data;
+  vbinary->usemmap = flg;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryGetMmap"
+/*@
+    PetscViewerBinaryGetMmap - checks if objects loaded from the file may use the memory mapped file
+
+    Not Collective
+
+    Input Parameter:
+.   viewer - PetscViewer context, obtained from PetscViewerBinaryOpen()
+
+    Output Parameter:
+.   flg - PETSC_TRUE if the memory mapped file may be used
+
+    Level: advanced
+
+.seealso: PetscViewerBinaryOpen(), PetscViewerBinarySetMmap(), PetscViewerBinaryReadMapped()
+@*/
+PetscErrorCode  PetscViewerBinaryGetMmap(PetscViewer viewer,PetscBool *flg)
+{
+  PetscViewer_Binary *vbinary;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidPointer(flg,2);
+  vbinary = (PetscViewer_Binary*)viewer->data;
+  *flg = vbinary->usemmap;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinarySetPartitioned"
+/*@
+    PetscViewerBinarySetPartitioned - AIJ matrices are stored in blocks of rows with an index, so that
+    each process loads only its own rows
+
+    Logically Collective on PetscViewer
+
+    Input Parameters:
++   viewer - PetscViewer context, obtained from PetscViewerBinaryOpen()
+-   flg - PETSC_TRUE to store the matrices partitioned
+
+    Options Database Key:
+.   -viewer_binary_partitioned - store the matrices partitioned
+
+    Level: advanced
+
+    Notes: The rows of each process are stored as one block, after the index giving the first row and the number
+    of nonzeros of each block. MatLoad() recognizes the format by itself, each process reads the index and then
+    only the parts of the blocks holding its rows, with MPI-IO when the viewer uses it (-viewer_binary_mpiio) and
+    otherwise from its own file descriptor, so all the processes must see the file. The matrix may be loaded on any
+    number of processes.
+
+    With MPI-IO each process writes its own block, otherwise the first process writes them all.
+
+    This must be called after PetscViewerSetType()
+
+   Concepts: PetscViewerBinary^partitioned matrices
+
+.seealso: PetscViewerBinaryOpen(), PetscViewerBinaryGetPartitioned(), PetscViewerBinarySetMPIIO(), MatView(), MatLoad()
+@*/
+PetscErrorCode  PetscViewerBinarySetPartitioned(PetscViewer viewer,PetscBool flg)
+{
+  PetscViewer_Binary *vbinary;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidLogicalCollectiveBool(viewer,flg,2);
+  vbinary = (PetscViewer_Binary*)viewer->data;
+  vbinary->partitioned = flg;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryGetPartitioned"
+/*@
+    PetscViewerBinaryGetPartitioned - checks if AIJ matrices are stored in blocks of rows with an index
+
+    Not Collective
+
+    Input Parameter:
+.   viewer - PetscViewer context, obtained from PetscViewerBinaryOpen()
+
+    Output Parameter:
+.   flg - PETSC_TRUE if the matrices are stored partitioned
+
+    Level: advanced
+
+.seealso: PetscViewerBinaryOpen(), PetscViewerBinarySetPartitioned()
+@*/
+PetscErrorCode  PetscViewerBinaryGetPartitioned(PetscViewer viewer,PetscBool *flg)
+{
+  PetscViewer_Binary *vbinary;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidPointer(flg,2);
+  vbinary = (PetscViewer_Binary*)viewer->data;
+  *flg = vbinary->partitioned;
+  PetscFunctionReturn(0);
+}
+
+#if defined(PETSC_HAVE_MMAP) && defined(PETSC_HAVE_SYS_MMAN_H)
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryMapDestroy_Private"
+static PetscErrorCode PetscViewerBinaryMapDestroy_Private(void *ctx)
+{
+  PetscErrorCode       ierr;
+  PetscViewerBinaryMap *map = (PetscViewerBinaryMap*)ctx;
+
+  PetscFunctionBegin;
+  if (munmap(map->addr,map->len)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SYS,"munmap() failed");
+  ierr = PetscFree(map);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+#endif
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryReadMapped"
+/*@C
+   PetscViewerBinaryReadMapped - gives the next values in the file in place in the memory mapped file,
+       if the viewer allows it
+
+   Not Collective, only for sequential viewers
+
+   Input Parameters:
++  viewer - the binary viewer
+.  count - number of items of data to read
+-  dtype - type of data to read, PETSC_INT, PETSC_SCALAR, PETSC_DOUBLE or PETSC_FLOAT
+
+   Output Parameters:
++  data - the values, in the native byte order, or PETSC_NULL if they could not be mapped
+-  map - the mapping, the object using data must keep a reference to it with PetscObjectCompose() (optional)
+
+   Level: developer
+
+   Notes: When data is PETSC_NULL nothing was read and the values must be read with PetscViewerBinaryRead().
+   This happens unless PetscViewerBinarySetMmap() was used, for parallel and MPI-IO viewers and when the
+   values are not aligned in the file.
+
+   The pages are mapped copy-on-write. PETSc binary files are big-endian, so on little-endian machines the
+   values are swapped in place, which touches all their pages; on big-endian machines they are read only
+   when used.
+
+   Concepts: binary files
+   Concepts: PetscViewerBinary^memory mapped files
+
+.seealso: PetscViewerBinaryRead(), PetscViewerBinarySetMmap(), PetscViewerBinaryOpen()
+@*/
+PetscErrorCode  PetscViewerBinaryReadMapped(PetscViewer viewer,PetscInt count,PetscDataType dtype,void **data,PetscObject *map)
+{
+#if defined(PETSC_HAVE_MMAP) && defined(PETSC_HAVE_SYS_MMAN_H)
+  PetscErrorCode       ierr;
+  PetscViewer_Binary   *vbinary = (PetscViewer_Binary*)viewer->data;
+  PetscViewerBinaryMap *vmap;
+  PetscBool            isbinary;
+  PetscMPIInt          size;
+  size_t               tsize,unit;
+  off_t                off,len;
+  struct stat          sbuf;
+  void                 *addr;
+#endif
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidPointer(data,4);
+  *data = PETSC_NULL;
+  if (map) *map = PETSC_NULL;
+#if defined(PETSC_HAVE_MMAP) && defined(PETSC_HAVE_SYS_MMAN_H)
+  ierr = PetscObjectTypeCompare((PetscObject)viewer,PETSCVIEWERBINARY,&isbinary);CHKERRQ(ierr);
+  if (!isbinary || !vbinary->usemmap || vbinary->btype != FILE_MODE_READ || count <= 0) PetscFunctionReturn(0);
+#if defined(PETSC_HAVE_MPIIO)
+  if (vbinary->MPIIO) PetscFunctionReturn(0);
+#endif
+  ierr = MPI_Comm_size(((PetscObject)viewer)->comm,&size);CHKERRQ(ierr);
+  if (size > 1) PetscFunctionReturn(0);
+  /* PETSC_SCALAR is one of the real types or PETSC_COMPLEX */
+  if (dtype == PETSC_INT)          unit = sizeof(PetscInt);
+  else if (dtype == PETSC_DOUBLE)  unit = sizeof(double);
+  else if (dtype == PETSC_FLOAT)   unit = sizeof(float);
+#if defined(PETSC_USE_COMPLEX) && !defined(PETSC_USE_REAL___FLOAT128)
+  else if (dtype == PETSC_COMPLEX) unit = sizeof(PetscReal);
+#endif
+  else PetscFunctionReturn(0);
+  ierr = PetscDataTypeGetSize(dtype,&tsize);CHKERRQ(ierr);
+  len  = (off_t)tsize*count;
+  off  = lseek(vbinary->fdes,0,SEEK_CUR);
+  if (off < 0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_READ,"lseek() failed on binary file");
+  /* values handed out before are already swapped, never map them again */
+  if (off % unit || off < vbinary->mapend) PetscFunctionReturn(0);
+
+  if (!vbinary->map) {
+    if (fstat(vbinary->fdes,&sbuf)) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_READ,"fstat() failed on binary file");
+    if (sbuf.st_size < off + len) PetscFunctionReturn(0);
+    addr = mmap(0,(size_t)sbuf.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,vbinary->fdes,0);
+    if (addr == MAP_FAILED) {
+      ierr = PetscInfo1(viewer,"mmap() failed with errno %d, reading the file instead\n",errno);CHKERRQ(ierr);
+      vbinary->usemmap = PETSC_FALSE;
+      PetscFunctionReturn(0);
+    }
+    ierr = PetscNew(PetscViewerBinaryMap,&vmap);CHKERRQ(ierr);
+    vmap->addr = (char*)addr;
+    vmap->len  = (size_t)sbuf.st_size;
+    ierr = PetscContainerCreate(PETSC_COMM_SELF,&vbinary->map);CHKERRQ(ierr);
+    ierr = PetscContainerSetPointer(vbinary->map,vmap);CHKERRQ(ierr);
+    ierr = PetscContainerSetUserDestroy(vbinary->map,PetscViewerBinaryMapDestroy_Private);CHKERRQ(ierr);
+  }
+  ierr = PetscContainerGetPointer(vbinary->map,(void**)&vmap);CHKERRQ(ierr);
+  if ((off_t)vmap->len < off + len) PetscFunctionReturn(0);
+  addr = vmap->addr + off;
+#if !defined(PETSC_WORDS_BIGENDIAN)
+  ierr = PetscByteSwap(addr,dtype,count);CHKERRQ(ierr);
+#endif
+  if (lseek(vbinary->fdes,off+len,SEEK_SET) < 0) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_FILE_READ,"lseek() failed on binary file");
+  vbinary->mapend = off + len;
+  *data = addr;
+  if (map) *map = (PetscObject)vbinary->map;
+#endif
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryWriteAsync"
+/*@C
+   PetscViewerBinaryWriteAsync - writes values distributed over all the processes to a binary file, in process order,
+       without waiting for them to reach the file
+
+   Collective on PetscViewer
+
+   Input Parameters:
++  viewer - the binary viewer
+.  data - the values of this process
+.  count - number of values of this process
+-  dtype - type of the values
+
+   Level: developer
+
+   Notes: The values of each group of consecutive processes are gathered into a staging buffer on the first
+   process of the group, the aggregator, which writes them as one contiguous piece of the file from a background
+   thread. data may be changed as soon as this routine returns. The staging buffers are kept until the writes
+   complete, PetscViewerBinaryWait() waits for them. On systems without pwrite() and ftruncate() the values are
+   written before this routine returns.
+
+   This is used by VecView() when the viewer is set with PetscViewerBinarySetAsync().
+
+   Concepts: binary files
+
+.seealso: PetscViewerBinarySetAsync(), PetscViewerBinaryWait(), PetscViewerBinaryWrite()
+@*/
+PetscErrorCode  PetscViewerBinaryWriteAsync(PetscViewer viewer,const void *data,PetscInt count,PetscDataType dtype)
+{
+  PetscViewer_Binary        *vbinary = (PetscViewer_Binary*)viewer->data;
+  PetscErrorCode            ierr;
+  MPI_Comm                  comm = ((PetscObject)viewer)->comm;
+  PetscMPIInt               rank,len,*lens = 0,*displs = 0,i;
+  PetscInt                  start,total;
+  size_t                    esize;
+  char                      *buf = 0;
+#if defined(PETSC_HAVE_PWRITE) && defined(PETSC_HAVE_FTRUNCATE)
+  PetscViewerBinaryAsync    *actx = 0;
+  PetscViewerBinaryAsyncJob job;
+  PetscMPIInt               grank,gsize;
+  PetscInt                  glen = 0;
+  size_t                    unit;
+  long long                 off = 0;
+#else
+  PetscMPIInt               size;
+#endif
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  if (vbinary->btype == FILE_MODE_READ) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONGSTATE,"Cannot write to a binary viewer opened for reading");
+#if defined(PETSC_USE_REAL___FLOAT128)
+  if (dtype == PETSC_SCALAR) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Asynchronous writes do not support __float128");
+#endif
+  if (dtype == PETSC_BIT_LOGICAL || dtype == PETSC_FUNCTION) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Asynchronous writes do not support this data type");
+  ierr = PetscDataTypeGetSize(dtype,&esize);CHKERRQ(ierr);
+
+  /* where the values of this process go in the file */
+  ierr = MPI_Comm_rank(comm,&rank);CHKERRQ(ierr);
+  ierr = MPI_Scan(&count,&start,1,MPIU_INT,MPI_SUM,comm);CHKERRQ(ierr);
+  ierr = MPI_Allreduce(&count,&total,1,MPIU_INT,MPI_SUM,comm);CHKERRQ(ierr);
+  start -= count;
+  len   = PetscMPIIntCast(count*(PetscInt)esize);
+
+#if defined(PETSC_HAVE_PWRITE) && defined(PETSC_HAVE_FTRUNCATE)
+  unit = esize;
+#if defined(PETSC_USE_COMPLEX)
+  if (dtype == PETSC_SCALAR) unit = sizeof(PetscReal);
+#endif
+  ierr = PetscViewerBinaryAsyncGetContext_Private(viewer,&actx);CHKERRQ(ierr);
+  ierr = PetscViewerBinaryAsyncReap_Private(actx,PETSC_FALSE);CHKERRQ(ierr);
+
+  /* the file exists on all processes after this */
+#if defined(PETSC_HAVE_MPIIO)
+  if (vbinary->MPIIO) {
+    off            = (long long)vbinary->moff;
+    vbinary->moff += (MPI_Offset)(total*esize);
+  } else {
+#endif
+    if (!rank) {
+      off_t cur;
+
+      /* reserve the space for the values, later writes go after it */
+      cur = lseek(vbinary->fdes,0,(vbinary->btype == FILE_MODE_APPEND) ? SEEK_END : SEEK_CUR);
+      if (cur < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_WRITE,"Error seeking in file, errno %d",errno);
+      if (ftruncate(vbinary->fdes,cur+(off_t)(total*esize))) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_WRITE,"Error extending file, errno %d",errno);
+      if (lseek(vbinary->fdes,cur+(off_t)(total*esize),SEEK_SET) < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_WRITE,"Error seeking in file, errno %d",errno);
+      off = (long long)cur;
+    }
+    ierr = MPI_Bcast(&off,1,MPI_LONG_LONG_INT,0,comm);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_MPIIO)
+  }
+#endif
+
+  /* gather the values of the group into one contiguous staging buffer on the aggregator */
+  ierr = MPI_Comm_rank(actx->comm,&grank);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(actx->comm,&gsize);CHKERRQ(ierr);
+  if (!grank) {
+    if (actx->fdes == -1) {
+#if defined(PETSC_HAVE_O_BINARY)
+      actx->fdes = open(vbinary->filename,O_WRONLY|O_BINARY,0);
+#else
+      actx->fdes = open(vbinary->filename,O_WRONLY,0);
+#endif
+      if (actx->fdes == -1) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_FILE_OPEN,"Cannot open file %s for writing",vbinary->filename);
+    }
+    ierr = PetscMalloc2(gsize,PetscMPIInt,&lens,gsize,PetscMPIInt,&displs);CHKERRQ(ierr);
+  }
+  ierr = MPI_Gather(&len,1,MPI_INT,lens,1,MPI_INT,0,actx->comm);CHKERRQ(ierr);
+  if (!grank) {
+    for (i=0; i<gsize; i++) {
+      displs[i] = PetscMPIIntCast(glen);
+      glen     += lens[i];
+    }
+    ierr = PetscMalloc(glen*sizeof(char),&buf);CHKERRQ(ierr);
+  }
+  ierr = MPI_Gatherv((void*)data,len,MPI_BYTE,buf,lens,displs,MPI_BYTE,0,actx->comm);CHKERRQ(ierr);
+  if (!grank) {
+    ierr = PetscFree2(lens,displs);CHKERRQ(ierr);
+    if (glen) {
+      ierr      = PetscNew(struct _n_PetscViewerBinaryAsyncJob,&job);CHKERRQ(ierr);
+      job->buf  = buf;
+      job->len  = (size_t)glen;
+      job->unit = unit;
+      job->off  = (off_t)(off + start*(long long)esize);
+      ierr      = PetscViewerBinaryAsyncPush_Private(actx,job);CHKERRQ(ierr);
+    } else {
+      ierr = PetscFree(buf);CHKERRQ(ierr);
+    }
+  }
+#else
+  /* the values are written right away */
+#if defined(PETSC_HAVE_MPIIO)
+  if (vbinary->MPIIO) {
+    MPI_Datatype mdtype;
+
+    ierr = PetscDataTypeToMPIDataType(dtype,&mdtype);CHKERRQ(ierr);
+    ierr = MPI_File_set_view(vbinary->mfdes,vbinary->moff+(MPI_Offset)(start*esize),mdtype,mdtype,(char *)"native",MPI_INFO_NULL);CHKERRQ(ierr);
+    ierr = MPIU_File_write_all(vbinary->mfdes,(void*)data,PetscMPIIntCast(count),mdtype,MPI_STATUS_IGNORE);CHKERRQ(ierr);
+    vbinary->moff += (MPI_Offset)(total*esize);
+    PetscFunctionReturn(0);
+  }
+#endif
+  /* gathered on the first process, which writes them at the current end of the file */
+  ierr = MPI_Comm_size(comm,&size);CHKERRQ(ierr);
+  if (!rank) {ierr = PetscMalloc2(size,PetscMPIInt,&lens,size,PetscMPIInt,&displs);CHKERRQ(ierr);}
+  ierr = MPI_Gather(&len,1,MPI_INT,lens,1,MPI_INT,0,comm);CHKERRQ(ierr);
+  if (!rank) {
+    displs[0] = 0;
+    for (i=1; i<size; i++) displs[i] = displs[i-1] + lens[i-1];
+    ierr = PetscMalloc((total*esize+1)*sizeof(char),&buf);CHKERRQ(ierr);
+  }
+  ierr = MPI_Gatherv((void*)data,len,MPI_BYTE,buf,lens,displs,MPI_BYTE,0,comm);CHKERRQ(ierr);
+  if (!rank) {
+    ierr = PetscBinaryWrite(vbinary->fdes,buf,total,dtype,PETSC_TRUE);CHKERRQ(ierr);
+    ierr = PetscFree(buf);CHKERRQ(ierr);
+    ierr = PetscFree2(lens,displs);CHKERRQ(ierr);
+  }
+#endif
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryWait"
+/*@
+   PetscViewerBinaryWait - waits until all the values written asynchronously with the viewer are in the file
+
+   Collective on PetscViewer
+
+   Input Parameter:
+.  viewer - the binary viewer
+
+   Level: intermediate
+
+   Notes: PetscViewerDestroy() also waits for the asynchronous writes. Call this to know that a checkpoint
+   is complete, or to release the staging buffers before the next one.
+
+   Concepts: binary files
+
+.seealso: PetscViewerBinarySetAsync(), PetscViewerBinaryWriteAsync()
+@*/
+PetscErrorCode  PetscViewerBinaryWait(PetscViewer viewer)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  ierr = PetscTryMethod(viewer,"PetscViewerBinaryWait_C",(PetscViewer),(viewer));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinarySetAsync"
+/*@
+   PetscViewerBinarySetAsync - VecView() with the viewer stages the values and returns, they are written
+       to the file in the background
+
+   Logically Collective on PetscViewer
+
+   Input Parameters:
++  viewer - the binary viewer
+-  flg - PETSC_TRUE to write asynchronously
+
+   Options Database Keys:
++  -viewer_binary_async - write asynchronously
+-  -viewer_binary_async_group <n> - number of consecutive processes whose values are written by one aggregator process, default 64
+
+   Level: intermediate
+
+   Notes: A checkpoint then only costs the copy of the values to the aggregators; the vector may be changed as
+   soon as VecView() returns. Use PetscViewerBinaryWait() to wait for the values to be in the file; destroying
+   the viewer also waits. The headers and the .info file are still written directly.
+
+   Concepts: binary files
+
+.seealso: PetscViewerBinaryWait(), PetscViewerBinaryGetAsync(), PetscViewerBinaryWriteAsync(), PetscViewerBinaryOpen()
+@*/
+PetscErrorCode  PetscViewerBinarySetAsync(PetscViewer viewer,PetscBool flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidLogicalCollectiveBool(viewer,flg,2);
+  ierr = PetscTryMethod(viewer,"PetscViewerBinarySetAsync_C",(PetscViewer,PetscBool),(viewer,flg));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryGetAsync"
+/*@
+   PetscViewerBinaryGetAsync - checks if VecView() with the viewer writes asynchronously
+
+   Not Collective
+
+   Input Parameter:
+.  viewer - the binary viewer
+
+   Output Parameter:
+.  flg - PETSC_TRUE if the values are written asynchronously
+
+   Level: intermediate
+
+.seealso: PetscViewerBinarySetAsync(), PetscViewerBinaryWait()
+@*/
+PetscErrorCode  PetscViewerBinaryGetAsync(PetscViewer viewer,PetscBool *flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(viewer,PETSC_VIEWER_CLASSID,1);
+  PetscValidPointer(flg,2);
+  *flg = PETSC_FALSE;
+  ierr = PetscTryMethod(viewer,"PetscViewerBinaryGetAsync_C",(PetscViewer,PetscBool*),(viewer,flg));CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryWait_Binary"
+PetscErrorCode PetscViewerBinaryWait_Binary(PetscViewer viewer)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  ierr = PetscViewerBinaryAsyncWait_Private(viewer);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinarySetAsync_Binary"
+PetscErrorCode PetscViewerBinarySetAsync_Binary(PetscViewer viewer,PetscBool flg)
+{
+  PetscViewer_Binary *vbinary = (PetscViewer_Binary*)viewer->data;
+
+  PetscFunctionBegin;
+  vbinary->async = flg;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
+EXTERN_C_BEGIN
+#undef __FUNCT__
+#define __FUNCT__ "PetscViewerBinaryGetAsync_Binary"
+PetscErrorCode PetscViewerBinaryGetAsync_Binary(PetscViewer viewer,PetscBool *flg)
+{
+  PetscViewer_Binary *vbinary = (PetscViewer_Binary*)viewer->data;
+
+  PetscFunctionBegin;
+  *flg = vbinary->async;
+  PetscFunctionReturn(0);
+}
+EXTERN_C_END
+
 #undef __FUNCT__
 #define __FUNCT__ "PetscViewerBinaryWriteStringArray"
 /*@C
@@ -1054,16 +1880,20 @@ PetscErrorCode PetscViewerFileSetName_Binary(PetscViewer viewer,const char name[
   ierr = PetscViewerFileClose_Binary(viewer);CHKERRQ(ierr);
   ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_skip_info",&vbinary->skipinfo,PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_skip_options",&vbinary->skipoptions,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_async",&vbinary->async,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_partitioned",&vbinary->partitioned,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(((PetscObject)viewer)->prefix,"-viewer_binary_async_group",&vbinary->asyncgroup,PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_skip_header",&vbinary->skipheader,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_mmap",&vbinary->usemmap,PETSC_NULL);CHKERRQ(ierr);
 
   ierr = MPI_Comm_rank(((PetscObject)viewer)->comm,&rank);CHKERRQ(ierr);
 
   /* copy name so we can edit it */
   ierr = PetscStrallocpy(name,&vbinary->filename);CHKERRQ(ierr);
 
-  /* if ends in .gz strip that off and note user wants file compressed */
+  /* if ends in .gz strip that off and note user wants file compressed, only the first process compresses it */
   vbinary->storecompressed = PETSC_FALSE;
-  if (!rank && type == FILE_MODE_WRITE) {
+  if (type == FILE_MODE_WRITE) {
     /* remove .gz if it ends library name */
     ierr = PetscStrstr(vbinary->filename,".gz",&gz);CHKERRQ(ierr);
     if (gz) {
@@ -1164,6 +1994,9 @@ PetscErrorCode PetscViewerFileSetName_MPIIO(PetscViewer viewer,const char name[]
   ierr = PetscViewerFileClose_MPIIO(viewer);CHKERRQ(ierr);
   ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_skip_info",&vbinary->skipinfo,PETSC_NULL);CHKERRQ(ierr);
   ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_skip_options",&vbinary->skipoptions,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_async",&vbinary->async,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetBool(((PetscObject)viewer)->prefix,"-viewer_binary_partitioned",&vbinary->partitioned,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(((PetscObject)viewer)->prefix,"-viewer_binary_async_group",&vbinary->asyncgroup,PETSC_NULL);CHKERRQ(ierr);
 
   ierr = MPI_Comm_rank(((PetscObject)viewer)->comm,&rank);CHKERRQ(ierr);
   ierr = PetscStrallocpy(name,&vbinary->filename);CHKERRQ(ierr);
@@ -1276,6 +2109,13 @@ PetscErrorCode PetscViewerCreate_Binary(PetscViewer v)
   vbinary->storecompressed = PETSC_FALSE;
   vbinary->filename        = 0;
   vbinary->flowcontrol     = 256; /* seems a good number for Cray XT-5 */
+  vbinary->async           = PETSC_FALSE;
+  vbinary->asyncgroup      = 64;
+  vbinary->actx            = 0;
+  vbinary->usemmap         = PETSC_FALSE;
+  vbinary->map             = 0;
+  vbinary->mapend          = 0;
+  vbinary->partitioned     = PETSC_FALSE;
 
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinaryGetFlowControl_C",
                                     "PetscViewerBinaryGetFlowControl_Binary",
@@ -1289,6 +2129,15 @@ PetscErrorCode PetscViewerCreate_Binary(PetscViewer v)
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinaryGetSkipHeader_C",
                                     "PetscViewerBinaryGetSkipHeader_Binary",
                                      PetscViewerBinaryGetSkipHeader_Binary);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinarySetAsync_C",
+                                    "PetscViewerBinarySetAsync_Binary",
+                                     PetscViewerBinarySetAsync_Binary);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinaryGetAsync_C",
+                                    "PetscViewerBinaryGetAsync_Binary",
+                                     PetscViewerBinaryGetAsync_Binary);CHKERRQ(ierr);
+  ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinaryWait_C",
+                                    "PetscViewerBinaryWait_Binary",
+                                     PetscViewerBinaryWait_Binary);CHKERRQ(ierr);
   ierr = PetscObjectComposeFunctionDynamic((PetscObject)v,"PetscViewerBinaryGetInfoPointer_C",
                                     "PetscViewerBinaryGetInfoPointer_Binary",
                                      PetscViewerBinaryGetInfoPointer_Binary);CHKERRQ(ierr);
@@ -0,0 +1,66 @@
+
+static char help[] = "Tests the options database with many options: lookups with prefixes, mixed case and numbered keys, and removing options.\n\
+Input arguments are:\n\
+  -n <options> : number of options to put in the database\n\n";
+
+#include <petscsys.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,n = 2000,v,left;
+  char           name[64],value[64];
+  PetscBool      flg;
+
+  PetscInitialize(&argc,&argv,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+
+  /* more options than the initial size of the table */
+  for (i=0; i<n; i++) {
+    ierr = PetscSNPrintf(name,sizeof(name),"-sub_%D_ksp_max_it",i);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(value,sizeof(value),"%D",i);CHKERRQ(ierr);
+    ierr = PetscOptionsSetValue(name,value);CHKERRQ(ierr);
+  }
+  ierr = PetscOptionsSetValue("-sub_KSP_Type","cg");CHKERRQ(ierr);
+
+  /* every option is found with its prefix, whatever the case */
+  for (i=0; i<n; i++) {
+    ierr = PetscSNPrintf(name,sizeof(name),"sub_%D_",i);CHKERRQ(ierr);
+    ierr = PetscOptionsGetInt(name,(i%2) ? "-ksp_max_it" : "-KSP_Max_It",&v,&flg);CHKERRQ(ierr);
+    if (!flg || v != i) {
+      ierr = PetscPrintf(PETSC_COMM_WORLD,"Option -%sksp_max_it not found or wrong value\n",name);CHKERRQ(ierr);
+    }
+  }
+  ierr = PetscOptionsGetString("sub_","-ksp_type",value,sizeof(value),&flg);CHKERRQ(ierr);
+  if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"Option -sub_ksp_type not found\n");CHKERRQ(ierr);}
+
+  /* a numbered prefix falls back to the option without the number */
+  ierr = PetscSNPrintf(name,sizeof(name),"sub_%D_",n);CHKERRQ(ierr);
+  ierr = PetscOptionsGetString(name,"-ksp_type",value,sizeof(value),&flg);CHKERRQ(ierr);
+  if (!flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"Option -%sksp_type did not fall back to -sub_ksp_type\n",name);CHKERRQ(ierr);}
+  ierr = PetscOptionsHasName(name,"-ksp_max_it",&flg);CHKERRQ(ierr);
+  if (flg) {ierr = PetscPrintf(PETSC_COMM_WORLD,"Option -%sksp_max_it should not be found\n",name);CHKERRQ(ierr);}
+
+  /* removed options are not found, the others are */
+  for (i=0; i<n; i+=3) {
+    ierr = PetscSNPrintf(name,sizeof(name),"-sub_%D_ksp_max_it",i);CHKERRQ(ierr);
+    ierr = PetscOptionsClearValue(name);CHKERRQ(ierr);
+  }
+  for (i=0; i<n; i++) {
+    ierr = PetscSNPrintf(name,sizeof(name),"-sub_%D_ksp_max_it",i);CHKERRQ(ierr);
+    ierr = PetscOptionsGetInt(PETSC_NULL,name,&v,&flg);CHKERRQ(ierr);
+    if (flg != (PetscBool)(i%3 != 0)) {
+      ierr = PetscPrintf(PETSC_COMM_WORLD,"Option %s %s after removing options\n",name,flg ? "found" : "not found");CHKERRQ(ierr);
+    }
+  }
+
+  /* all the options that are left were queried */
+  ierr = PetscOptionsAllUsed(&left);CHKERRQ(ierr);
+  if (left) {ierr = PetscPrintf(PETSC_COMM_WORLD,"%D options were not used\n",left);CHKERRQ(ierr);}
+
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -25,19 +25,40 @@
 #include <yaml.h>
 #endif
 
+#include <../src/sys/utils/hash.h>
+
 /*
-    This table holds all the options set by the user. For simplicity, we use a static size database
+    This table holds all the options set by the user. The names are stored in the order they are added, in
+    arrays that grow as needed starting with room for MAXOPTIONS entries; a hash table from the names (compared
+    without regard to case) to their location in the arrays makes adding and finding options independent of
+    the number of options. The names are sorted only when they are listed.
 */
 #define MAXOPTIONS 512
 #define MAXALIASES 25
 #define MAXOPTIONSMONITORS 5
 #define MAXPREFIXES 25
 
+PETSC_STATIC_INLINE khint_t PetscOptionsHashFunc(const char *key)
+{
+  khint_t h = 0;
+  for (; *key; key++) h = (h << 5) - h + (khint_t)tolower((unsigned char)*key);
+  return h;
+}
+
+PETSC_STATIC_INLINE int PetscOptionsHashEqual(const char *a,const char *b)
+{
+  for (; *a && tolower((unsigned char)*a) == tolower((unsigned char)*b); a++,b++) ;
+  return tolower((unsigned char)*a) == tolower((unsigned char)*b);
+}
+
+KHASH_INIT(HOPT,const char*,int,1,PetscOptionsHashFunc,PetscOptionsHashEqual)
+
 typedef struct {
-  int            N,argc,Naliases;
-  char           **args,*names[MAXOPTIONS],*values[MAXOPTIONS];
+  int            N,argc,Naliases,Nalloc;
+  char           **args,**names,**values;
   char           *aliases1[MAXALIASES],*aliases2[MAXALIASES];
-  PetscBool      used[MAXOPTIONS];
+  PetscBool      *used;
+  khash_t(HOPT)  *ht;                   /* location of each name in names[] */
   PetscBool      namegiven;
   char           programname[PETSC_MAX_PATH_LEN]; /* HP includes entire path in name */
 
@@ -56,6 +77,40 @@ typedef struct {
 static PetscOptionsTable      *options = 0;
 extern PetscOptionsObjectType PetscOptionsObject;
 
+#undef __FUNCT__
+#define __FUNCT__ "PetscOptionsHashFind_Private"
+/*
+    Finds the location of name (without the leading -) in options->names[], or -1
+*/
+static PetscErrorCode PetscOptionsHashFind_Private(const char name[],PetscInt *loc)
+{
+  khiter_t k;
+
+  PetscFunctionBegin;
+  k    = kh_get(HOPT,options->ht,name);
+  *loc = (k != kh_end(options->ht)) ? kh_val(options->ht,k) : -1;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscOptionsSorted_Private"
+/*
+    Returns the locations of the options in alphabetical order of their names, for listing them;
+    free with free()
+*/
+static PetscErrorCode PetscOptionsSorted_Private(PetscInt **perm)
+{
+  PetscErrorCode ierr;
+  PetscInt       i;
+
+  PetscFunctionBegin;
+  *perm = (PetscInt*)malloc((options->N+1)*sizeof(PetscInt));
+  if (!*perm) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_MEM,"Unable to allocate the list of options");
+  for (i=0; i<options->N; i++) (*perm)[i] = i;
+  ierr = PetscSortStrWithPermutation(options->N,(const char**)options->names,*perm);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
 /*
     Options events monitor
 */
@@ -684,7 +739,7 @@ PetscErrorCode  PetscOptionsInsert(int *argc,char ***args,const char file[])
 PetscErrorCode  PetscOptionsView(PetscViewer viewer)
 {
   PetscErrorCode ierr;
-  PetscInt       i;
+  PetscInt       i,j,*perm;
   PetscBool      isascii;
 
   PetscFunctionBegin;
@@ -698,13 +753,16 @@ PetscErrorCode  PetscOptionsView(PetscViewer viewer)
   } else {
     ierr = PetscViewerASCIIPrintf(viewer,"#No PETSc Option Table entries\n");CHKERRQ(ierr);
   }
+  ierr = PetscOptionsSorted_Private(&perm);CHKERRQ(ierr);
   for (i=0; i<options->N; i++) {
-    if (options->values[i]) {
-      ierr = PetscViewerASCIIPrintf(viewer,"-%s %s\n",options->names[i],options->values[i]);CHKERRQ(ierr);
+    j = perm[i];
+    if (options->values[j]) {
+      ierr = PetscViewerASCIIPrintf(viewer,"-%s %s\n",options->names[j],options->values[j]);CHKERRQ(ierr);
     } else {
-      ierr = PetscViewerASCIIPrintf(viewer,"-%s\n",options->names[i]);CHKERRQ(ierr);
+      ierr = PetscViewerASCIIPrintf(viewer,"-%s\n",options->names[j]);CHKERRQ(ierr);
     }
   }
+  free(perm);
   if (options->N) {
     ierr = PetscViewerASCIIPrintf(viewer,"#End of PETSc Option Table entries\n");CHKERRQ(ierr);
   }
@@ -732,7 +790,7 @@ PetscErrorCode  PetscOptionsView(PetscViewer viewer)
 PetscErrorCode  PetscOptionsGetAll(char *copts[])
 {
   PetscErrorCode ierr;
-  PetscInt       i;
+  PetscInt       i,j,*perm;
   size_t         len = 1,lent = 0;
   char           *coptions = PETSC_NULL;
 
@@ -750,15 +808,18 @@ PetscErrorCode  PetscOptionsGetAll(char *copts[])
   }
   ierr = PetscMalloc(len*sizeof(char),&coptions);CHKERRQ(ierr);
   coptions[0] = 0;
+  ierr = PetscOptionsSorted_Private(&perm);CHKERRQ(ierr);
   for (i=0; i<options->N; i++) {
+    j    = perm[i];
     ierr = PetscStrcat(coptions,"-");CHKERRQ(ierr);
-    ierr = PetscStrcat(coptions,options->names[i]);CHKERRQ(ierr);
+    ierr = PetscStrcat(coptions,options->names[j]);CHKERRQ(ierr);
     ierr = PetscStrcat(coptions," ");CHKERRQ(ierr);
-    if (options->values[i]) {
-      ierr = PetscStrcat(coptions,options->values[i]);CHKERRQ(ierr);
+    if (options->values[j]) {
+      ierr = PetscStrcat(coptions,options->values[j]);CHKERRQ(ierr);
       ierr = PetscStrcat(coptions," ");CHKERRQ(ierr);
     }
   }
+  free(perm);
   *copts = coptions;
   PetscFunctionReturn(0);
 }
@@ -865,6 +926,7 @@ PetscErrorCode  PetscOptionsClear(void)
   options->prefixind = 0;
   options->N        = 0;
   options->Naliases = 0;
+  if (options->ht) kh_clear(HOPT,options->ht);
   PetscFunctionReturn(0);
 }
 
@@ -888,6 +950,10 @@ PetscErrorCode  PetscOptionsDestroy(void)
   PetscFunctionBegin;
   if (!options) PetscFunctionReturn(0);
   ierr = PetscOptionsClear();CHKERRQ(ierr);
+  if (options->ht) kh_destroy(HOPT,options->ht);
+  free(options->names);
+  free(options->values);
+  free(options->used);
   free(options);
   options = 0;
   PetscFunctionReturn(0);
@@ -921,10 +987,11 @@ PetscErrorCode  PetscOptionsSetValue(const char iname[],const char value[])
   size_t         len;
   PetscErrorCode ierr;
   PetscInt       N,n,i;
-  char           **names;
   char           fullname[2048];
   const char     *name = iname;
-  PetscBool      gt,match;
+  PetscBool      match;
+  khiter_t       k;
+  khint_t        ret;
 
   PetscFunctionBegin;
   if (!options) {ierr = PetscOptionsInsert(0,0,0);CHKERRQ(ierr);}
@@ -950,46 +1017,38 @@ PetscErrorCode  PetscOptionsSetValue(const char iname[],const char value[])
     }
   }
 
-  N     = options->N;
-  n     = N;
-  names = options->names;
-
-  for (i=0; i<N; i++) {
-    ierr = PetscStrcasecmp(names[i],name,&match);CHKERRQ(ierr);
-    ierr  = PetscStrgrt(names[i],name,&gt);CHKERRQ(ierr);
-    if (match) {
-      if (options->values[i]) free(options->values[i]);
-      ierr = PetscStrlen(value,&len);CHKERRQ(ierr);
-      if (len) {
-        options->values[i] = (char*)malloc((len+1)*sizeof(char));
-        ierr = PetscStrcpy(options->values[i],value);CHKERRQ(ierr);
-      } else { options->values[i] = 0;}
-      PetscOptionsMonitor(name,value);
-      PetscFunctionReturn(0);
-    } else if (gt) {
-      n = i;
-      break;
-    }
-  }
-  if (N >= MAXOPTIONS) {
-    SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_PLIB,"No more room in option table, limit %d recompile \n src/sys/objects/options.c with larger value for MAXOPTIONS\n",MAXOPTIONS);
+  ierr = PetscOptionsHashFind_Private(name,&n);CHKERRQ(ierr);
+  if (n >= 0) {
+    if (options->values[n]) free(options->values[n]);
+    ierr = PetscStrlen(value,&len);CHKERRQ(ierr);
+    if (len) {
+      options->values[n] = (char*)malloc((len+1)*sizeof(char));
+      ierr = PetscStrcpy(options->values[n],value);CHKERRQ(ierr);
+    } else { options->values[n] = 0;}
+    PetscOptionsMonitor(name,value);
+    PetscFunctionReturn(0);
   }
-  /* shift remaining values down 1 */
-  for (i=N; i>n; i--) {
-    options->names[i]  = options->names[i-1];
-    options->values[i] = options->values[i-1];
-    options->used[i]   = options->used[i-1];
+  N = options->N;
+  if (N >= options->Nalloc) {
+    int nalloc = options->Nalloc ? 2*options->Nalloc : MAXOPTIONS;
+    options->names  = (char**)realloc(options->names,nalloc*sizeof(char*));
+    options->values = (char**)realloc(options->values,nalloc*sizeof(char*));
+    options->used   = (PetscBool*)realloc(options->used,nalloc*sizeof(PetscBool));
+    if (!options->names || !options->values || !options->used) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_MEM,"Unable to grow the options table to %d entries",nalloc);
+    options->Nalloc = nalloc;
   }
-  /* insert new name and value */
+  /* append the new name and value */
   ierr = PetscStrlen(name,&len);CHKERRQ(ierr);
-  options->names[n] = (char*)malloc((len+1)*sizeof(char));
-  ierr = PetscStrcpy(options->names[n],name);CHKERRQ(ierr);
+  options->names[N] = (char*)malloc((len+1)*sizeof(char));
+  ierr = PetscStrcpy(options->names[N],name);CHKERRQ(ierr);
   ierr = PetscStrlen(value,&len);CHKERRQ(ierr);
   if (len) {
-    options->values[n] = (char*)malloc((len+1)*sizeof(char));
-    ierr = PetscStrcpy(options->values[n],value);CHKERRQ(ierr);
-  } else {options->values[n] = 0;}
-  options->used[n] = PETSC_FALSE;
+    options->values[N] = (char*)malloc((len+1)*sizeof(char));
+    ierr = PetscStrcpy(options->values[N],value);CHKERRQ(ierr);
+  } else {options->values[N] = 0;}
+  options->used[N] = PETSC_FALSE;
+  k = kh_put(HOPT,options->ht,options->names[N],&ret);
+  kh_val(options->ht,k) = N;
   options->N++;
   PetscOptionsMonitor(name,value);
   PetscFunctionReturn(0);
@@ -1015,9 +1074,8 @@ PetscErrorCode  PetscOptionsSetValue(const char iname[],const char value[])
 PetscErrorCode  PetscOptionsClearValue(const char iname[])
 {
   PetscErrorCode ierr;
-  PetscInt       N,n,i;
-  char           **names,*name=(char*)iname;
-  PetscBool      gt,match;
+  PetscInt       N,n;
+  char           *name=(char*)iname;
 
   PetscFunctionBegin;
   if (name[0] != '-') SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Name must begin with -: Instead %s",name);
@@ -1025,31 +1083,21 @@ PetscErrorCode  PetscOptionsClearValue(const char iname[])
 
   name++;
 
-  N     = options->N; n = 0;
-  names = options->names;
-
-  for (i=0; i<N; i++) {
-    ierr  = PetscStrcasecmp(names[i],name,&match);CHKERRQ(ierr);
-    ierr  = PetscStrgrt(names[i],name,&gt);CHKERRQ(ierr);
-    if (match) {
-      if (options->names[i])  free(options->names[i]);
-      if (options->values[i]) free(options->values[i]);
-      PetscOptionsMonitor(name,"");
-      break;
-    } else if (gt) {
-      PetscFunctionReturn(0); /* it was not listed */
-    }
-    n++;
-  }
-  if (n == N) PetscFunctionReturn(0); /* it was not listed */
-
-  /* shift remaining values down 1 */
-  for (i=n; i<N-1; i++) {
-    options->names[i]  = options->names[i+1];
-    options->values[i] = options->values[i+1];
-    options->used[i]   = options->used[i+1];
+  ierr = PetscOptionsHashFind_Private(name,&n);CHKERRQ(ierr);
+  if (n < 0) PetscFunctionReturn(0); /* it was not listed */
+  kh_del(HOPT,options->ht,kh_get(HOPT,options->ht,options->names[n]));
+  free(options->names[n]);
+  if (options->values[n]) free(options->values[n]);
+  PetscOptionsMonitor(name,"");
+
+  /* move the last option into the free location */
+  N = --options->N;
+  if (n < N) {
+    options->names[n]  = options->names[N];
+    options->values[n] = options->values[N];
+    options->used[n]   = options->used[N];
+    kh_val(options->ht,kh_get(HOPT,options->ht,options->names[n])) = n;
   }
-  options->N--;
   PetscFunctionReturn(0);
 }
 
@@ -1104,15 +1152,12 @@ PetscErrorCode  PetscOptionsSetAlias(const char inewname[],const char ioldname[]
 PetscErrorCode PetscOptionsFindPair_Private(const char pre[],const char name[],char *value[],PetscBool  *flg)
 {
   PetscErrorCode ierr;
-  PetscInt       i,N;
+  PetscInt       i;
   size_t         len;
-  char           **names,tmp[256];
-  PetscBool      match;
+  char           tmp[256];
 
   PetscFunctionBegin;
   if (!options) {ierr = PetscOptionsInsert(0,0,0);CHKERRQ(ierr);}
-  N = options->N;
-  names = options->names;
 
   if (name[0] != '-') SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Name must begin with -: Instead %s",name);
 
@@ -1143,18 +1188,13 @@ PetscErrorCode PetscOptionsFindPair_Private(const char pre[],const char name[],c
   }
 #endif
 
-  /* slow search */
   *flg = PETSC_FALSE;
-  for (i=0; i<N; i++) {
-    ierr = PetscStrcasecmp(names[i],tmp,&match);CHKERRQ(ierr);
-    if (match) {
-       *value           = options->values[i];
-       options->used[i] = PETSC_TRUE;
-       *flg             = PETSC_TRUE;
-       break;
-     }
-  }
-  if (!*flg) {
+  ierr = PetscOptionsHashFind_Private(tmp,&i);CHKERRQ(ierr);
+  if (i >= 0) {
+    *value           = options->values[i];
+    options->used[i] = PETSC_TRUE;
+    *flg             = PETSC_TRUE;
+  } else {
     PetscInt j,cnt = 0,locs[16],loce[16];
     size_t   n;
     ierr = PetscStrlen(tmp,&n);CHKERRQ(ierr);
@@ -1190,10 +1230,10 @@ PetscErrorCode PetscOptionsFindPair_Private(const char pre[],const char name[],c
 PetscErrorCode PetscOptionsFindPairPrefix_Private(const char pre[], const char name[], char *value[], PetscBool *flg)
 {
   PetscErrorCode ierr;
-  PetscInt       i,N;
+  PetscInt       i,j,N;
   size_t         len;
   char           **names,tmp[256];
-  PetscBool      match;
+  PetscBool      match,gt;
 
   PetscFunctionBegin;
   if (!options) {ierr = PetscOptionsInsert(0,0,0);CHKERRQ(ierr);}
@@ -1229,18 +1269,22 @@ PetscErrorCode PetscOptionsFindPairPrefix_Private(const char pre[], const char n
   }
 #endif
 
-  /* slow search */
+  /* slow search, the options are not sorted so find the first match in alphabetical order */
   *flg = PETSC_FALSE;
   ierr = PetscStrlen(tmp,&len);CHKERRQ(ierr);
-  for (i = 0; i < N; ++i) {
+  for (i = 0, j = -1; i < N; ++i) {
     ierr = PetscStrncmp(names[i], tmp, len, &match);CHKERRQ(ierr);
     if (match) {
-      if (value) *value = options->values[i];
-      options->used[i]  = PETSC_TRUE;
-      if (flg)   *flg   = PETSC_TRUE;
-      break;
+      gt = PETSC_TRUE;
+      if (j >= 0) {ierr = PetscStrgrt(names[j], names[i], &gt);CHKERRQ(ierr);}
+      if (gt) j = i;
     }
   }
+  if (j >= 0) {
+    if (value) *value = options->values[j];
+    options->used[j]  = PETSC_TRUE;
+    if (flg)   *flg   = PETSC_TRUE;
+  }
   PetscFunctionReturn(0);
 }
 
@@ -2128,18 +2172,21 @@ PetscErrorCode  PetscOptionsAllUsed(PetscInt *N)
 PetscErrorCode  PetscOptionsLeft(void)
 {
   PetscErrorCode ierr;
-  PetscInt       i;
+  PetscInt       i,j,*perm;
 
   PetscFunctionBegin;
+  ierr = PetscOptionsSorted_Private(&perm);CHKERRQ(ierr);
   for (i=0; i<options->N; i++) {
-    if (!options->used[i]) {
-      if (options->values[i]) {
-        ierr = PetscPrintf(PETSC_COMM_WORLD,"Option left: name:-%s value: %s\n",options->names[i],options->values[i]);CHKERRQ(ierr);
+    j = perm[i];
+    if (!options->used[j]) {
+      if (options->values[j]) {
+        ierr = PetscPrintf(PETSC_COMM_WORLD,"Option left: name:-%s value: %s\n",options->names[j],options->values[j]);CHKERRQ(ierr);
       } else {
-        ierr = PetscPrintf(PETSC_COMM_WORLD,"Option left: name:-%s no value \n",options->names[i]);CHKERRQ(ierr);
+        ierr = PetscPrintf(PETSC_COMM_WORLD,"Option left: name:-%s no value \n",options->names[j]);CHKERRQ(ierr);
       }
     }
   }
+  free(perm);
   PetscFunctionReturn(0);
 }
 
@@ -2159,6 +2206,7 @@ PetscErrorCode  PetscOptionsCreate(void)
   ierr    = PetscMemzero(options,sizeof(PetscOptionsTable));CHKERRQ(ierr);
   options->namegiven            = PETSC_FALSE;
   options->N                    = 0;
+  options->ht                   = kh_init(HOPT);
   options->Naliases             = 0;
   options->numbermonitors       = 0;
 
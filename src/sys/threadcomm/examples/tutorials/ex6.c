@@ -0,0 +1,85 @@
+static char help[] = "Load balancing of irregular work with PetscThreadCommRunTasks().\n\n";
+
+/*T
+   Concepts: PetscThreadComm^basic example: Running tasks of different sizes with work stealing
+T*/
+
+/*
+  Include "petscthreadcomm.h" so that we can use the PetscThreadComm interface.
+*/
+#include <petscthreadcomm.h>
+
+typedef struct {
+  PetscInt    *rowstarts; /* the "rows" of an irregular sparse structure */
+  PetscScalar *a,*y;
+  PetscInt    *owner;     /* which thread computed y[i] */
+} AppCtx;
+
+/* computes y[i] as the sum of the entries of row i for the rows start <= i < end */
+PetscErrorCode rowsum_task(PetscInt trank,PetscInt start,PetscInt end,AppCtx *user)
+{
+  PetscInt    i,j;
+  PetscScalar sum;
+
+  for (i=start; i<end; i++) {
+    sum = 0.0;
+    for (j=user->rowstarts[i]; j<user->rowstarts[i+1]; j++) sum += user->a[j];
+    user->y[i]     = sum;
+    user->owner[i] = trank;
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscInt       m = 1000,chunk = 16,ntasks,*tstarts,i,j,nthreads,nerr = 0,*ntasksrun;
+  PetscScalar    sum;
+  AppCtx         user;
+
+  PetscInitialize(&argc,&argv,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-m",&m,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-chunk",&chunk,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscThreadCommGetNThreads(PETSC_COMM_WORLD,&nthreads);CHKERRQ(ierr);
+
+  /* the first rows are much longer than the rest, so a static partition of the rows is badly balanced */
+  ierr = PetscMalloc2(m+1,PetscInt,&user.rowstarts,m,PetscInt,&user.owner);CHKERRQ(ierr);
+  user.rowstarts[0] = 0;
+  for (i=0; i<m; i++) user.rowstarts[i+1] = user.rowstarts[i] + ((i < m/8) ? 2000 : 1 + i%7);
+  ierr = PetscMalloc2(user.rowstarts[m],PetscScalar,&user.a,m,PetscScalar,&user.y);CHKERRQ(ierr);
+  for (j=0; j<user.rowstarts[m]; j++) user.a[j] = 1.0;
+
+  /* split the rows in tasks of chunk rows */
+  ntasks = (m+chunk-1)/chunk;
+  ierr = PetscMalloc((ntasks+1)*sizeof(PetscInt),&tstarts);CHKERRQ(ierr);
+  for (i=0; i<ntasks; i++) tstarts[i] = i*chunk;
+  tstarts[ntasks] = m;
+
+  ierr = PetscThreadCommRunTasks(PETSC_COMM_WORLD,ntasks,tstarts,(PetscThreadTaskKernel)rowsum_task,&user);CHKERRQ(ierr);
+
+  /* check the result, and count the number of rows computed by each thread */
+  ierr = PetscMalloc(nthreads*sizeof(PetscInt),&ntasksrun);CHKERRQ(ierr);
+  ierr = PetscMemzero(ntasksrun,nthreads*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    sum = (PetscScalar)(user.rowstarts[i+1] - user.rowstarts[i]);
+    if (PetscAbsScalar(user.y[i] - sum) > 0.0) nerr++;
+    if (user.owner[i] >= 0 && user.owner[i] < nthreads) ntasksrun[user.owner[i]]++;
+  }
+  for (i=0; i<nthreads; i++) {
+    ierr = PetscInfo2(0,"Thread %D computed %D rows\n",i,ntasksrun[i]);CHKERRQ(ierr);
+  }
+  if (nerr) {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"Wrong result in %D rows\n",nerr);CHKERRQ(ierr);
+  } else {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"All tasks computed correctly\n");CHKERRQ(ierr);
+  }
+
+  ierr = PetscFree(ntasksrun);CHKERRQ(ierr);
+  ierr = PetscFree(tstarts);CHKERRQ(ierr);
+  ierr = PetscFree2(user.a,user.y);CHKERRQ(ierr);
+  ierr = PetscFree2(user.rowstarts,user.owner);CHKERRQ(ierr);
+  PetscFinalize();
+  return 0;
+}
@@ -19,6 +19,7 @@ PetscErrorCode PetscThreadCommCreate_OpenMP(PetscThreadComm tcomm)
   ierr = PetscStrcpy(tcomm->type,OPENMP);CHKERRQ(ierr);
   tcomm->ops->runkernel = PetscThreadCommRunKernel_OpenMP;
   tcomm->ops->getrank   = PetscThreadCommGetRank_OpenMP;
+  tcomm->ops->runtasks  = PetscThreadCommRunTasks_OpenMP;
 #pragma omp parallel num_threads(tcomm->nworkThreads) shared(tcomm)
   {
 #if defined(PETSC_HAVE_SCHED_CPU_SET_T)
@@ -54,3 +55,23 @@ PetscErrorCode PetscThreadCommRunKernel_OpenMP(MPI_Comm comm,PetscThreadCommJobC
   }
   PetscFunctionReturn(0);
 }
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscThreadCommRunTasks_OpenMP"
+PetscErrorCode PetscThreadCommRunTasks_OpenMP(MPI_Comm comm,PetscInt ntasks,const PetscInt tstarts[],PetscThreadTaskKernel kernel,void *ctx)
+{
+  PetscErrorCode  ierr,terr=0;
+  PetscThreadComm tcomm;
+  PetscInt        t;
+
+  PetscFunctionBegin;
+  ierr = PetscCommGetThreadComm(comm,&tcomm);CHKERRQ(ierr);
+#pragma omp parallel for num_threads(tcomm->nworkThreads) schedule(dynamic,1) shared(tstarts,kernel,ctx,terr) private(ierr)
+  for (t=0; t<ntasks; t++) {
+    if (tstarts) ierr = (*kernel)(omp_get_thread_num(),tstarts[t],tstarts[t+1],ctx);
+    else ierr = (*kernel)(omp_get_thread_num(),t,t+1,ctx);
+    if (ierr) terr = ierr;
+  }
+  ierr = terr;CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
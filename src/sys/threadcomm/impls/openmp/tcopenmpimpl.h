@@ -8,5 +8,6 @@ extern PetscErrorCode PetscThreadCommCreate_OpenMP(PetscThreadComm);
 EXTERN_C_END
 
 extern PetscErrorCode PetscThreadCommRunKernel_OpenMP(MPI_Comm,PetscThreadCommJobCtx);
+extern PetscErrorCode PetscThreadCommRunTasks_OpenMP(MPI_Comm,PetscInt,const PetscInt[],PetscThreadTaskKernel,void*);
 
 #endif
@@ -87,6 +87,7 @@ PetscErrorCode PetscThreadCommDestroy_PThread(PetscThreadComm tcomm)
 
   PetscFunctionBegin;
   if (!ptcomm) PetscFunctionReturn(0);
+  ierr = PetscThreadCommDestroyTasks_PThread(tcomm);CHKERRQ(ierr);
   ptcommcrtct--;
   if (!ptcommcrtct) {
     /* Terminate the thread pool */
@@ -127,6 +128,7 @@ PetscErrorCode PetscThreadCommCreate_PThread(PetscThreadComm tcomm)
   tcomm->ops->runkernel = PetscThreadCommRunKernel_PThread_LockFree;
   tcomm->ops->barrier   = PetscThreadCommBarrier_PThread_LockFree;
   tcomm->ops->getrank   = PetscThreadCommGetRank_PThread;
+  tcomm->ops->runtasks  = PetscThreadCommRunTasks_PThread;
 
   ierr = PetscMalloc(tcomm->nworkThreads*sizeof(PetscInt),&ptcomm->granks);CHKERRQ(ierr);
 
@@ -32,6 +32,19 @@ extern const char *const PetscPTheadCommAffinityPolicyTypes[];
 typedef enum {PTHREADPOOLSPARK_SELF} PetscPThreadCommPoolSparkType;
 extern const char *const PetscPThreadCommPoolSparkTypes[];
 
+/*
+   PetscPThreadTaskDeque - Double-ended queue of tasks owned by one thread, used by PetscThreadCommRunTasks().
+
+   The tasks still to be executed are [head,tail). The owner takes tasks from the head, other threads
+   steal from the tail. The padding keeps the queues of different threads on different cache lines.
+*/
+typedef struct {
+  pthread_mutex_t lock;
+  PetscInt        head,tail;
+  PetscErrorCode  ierr;         /* first error returned by a task kernel run by the owner */
+  char            padding[64];
+} PetscPThreadTaskDeque;
+
 /*
    PetscThreadComm_PThread - The main data structure to manage the thread
    communicator using pthreads. This data structure is shared by NONTHREADED
@@ -56,6 +69,7 @@ struct _p_PetscThreadComm_PThread{
   PetscPThreadCommAffinityPolicyType  aff;    /* affinity policy */
   PetscPThreadCommPoolSparkType       spark;  /* Type for sparking threads */
   PetscBool                           synchronizeafter; /* Whether the main thread should be blocked till all threads complete the given kernel */
+  PetscPThreadTaskDeque               *deques;          /* Task queue of each thread, allocated at the first PetscThreadCommRunTasks() */
   PetscErrorCode (*initialize)(PetscThreadComm);
   PetscErrorCode (*finalize)(PetscThreadComm);
 };
@@ -82,6 +96,8 @@ extern PetscErrorCode PetscPThreadCommInitialize_LockFree(PetscThreadComm);
 extern PetscErrorCode PetscPThreadCommFinalize_LockFree(PetscThreadComm);
 extern PetscErrorCode PetscThreadCommRunKernel_PThread_LockFree(MPI_Comm,PetscThreadCommJobCtx);
 extern PetscErrorCode PetscThreadCommBarrier_PThread_LockFree(PetscThreadComm);
+extern PetscErrorCode PetscThreadCommRunTasks_PThread(MPI_Comm,PetscInt,const PetscInt[],PetscThreadTaskKernel,void*);
+extern PetscErrorCode PetscThreadCommDestroyTasks_PThread(PetscThreadComm);
 
 #if defined(PETSC_HAVE_SCHED_CPU_SET_T)
 extern void PetscPThreadCommDoCoreAffinity();
@@ -0,0 +1,132 @@
+/*
+   Work-stealing task scheduler for the pthread thread communicator, see PetscThreadCommRunTasks()
+*/
+#include <../src/sys/threadcomm/impls/pthread/tcpthreadimpl.h>
+
+typedef struct {
+  PetscThreadComm       tcomm;
+  const PetscInt        *tstarts;
+  PetscThreadTaskKernel kernel;
+  void                  *ctx;
+} PetscPThreadTaskCtx;
+
+/*
+   Executed once by each thread of the communicator: runs the tasks of the own queue and
+   then steals from the other queues until all of them are empty
+*/
+PetscErrorCode PetscThreadCommTaskKernel_PThread(PetscInt trank,PetscPThreadTaskCtx *tctx)
+{
+  PetscThreadComm         tcomm  = tctx->tcomm;
+  PetscThreadComm_PThread ptcomm = (PetscThreadComm_PThread)tcomm->data;
+  PetscPThreadTaskDeque   *deques = ptcomm->deques,*mine,*victim;
+  PetscInt                n = tcomm->nworkThreads,me,i,j,t,rem,maxrem,v,nsteal,start = 0;
+  PetscErrorCode          ierr;
+
+  for (me=0; me<n; me++) if (ptcomm->granks[me] == trank) break;
+  if (me == n) return 0;
+  mine = &deques[me];
+  while (1) {
+    /* work through the own queue from the front */
+    while (1) {
+      pthread_mutex_lock(&mine->lock);
+      t = (mine->head < mine->tail) ? mine->head++ : -1;
+      pthread_mutex_unlock(&mine->lock);
+      if (t < 0) break;
+      if (tctx->tstarts) ierr = (*tctx->kernel)(trank,tctx->tstarts[t],tctx->tstarts[t+1],tctx->ctx);
+      else ierr = (*tctx->kernel)(trank,t,t+1,tctx->ctx);
+      if (ierr && !mine->ierr) mine->ierr = ierr;
+    }
+    /* pick the most loaded queue, the lengths are only a hint since they are read without locking */
+    v = -1; maxrem = 0;
+    for (i=1; i<n; i++) {
+      j   = (me+i)%n;
+      rem = PetscReadOnce(PetscInt,deques[j].tail) - PetscReadOnce(PetscInt,deques[j].head);
+      if (rem > maxrem) {maxrem = rem; v = j;}
+    }
+    /* Every queue is empty. Tasks removed from a queue by a thief but not yet placed in its
+       own queue are executed by that thief, so this thread may stop */
+    if (v < 0) break;
+    /* steal the back half of the victim's tasks */
+    victim = &deques[v];
+    pthread_mutex_lock(&victim->lock);
+    rem    = victim->tail - victim->head;
+    nsteal = (rem > 0) ? (rem+1)/2 : 0;
+    if (nsteal) {
+      victim->tail -= nsteal;
+      start         = victim->tail;
+    }
+    pthread_mutex_unlock(&victim->lock);
+    if (nsteal) {
+      pthread_mutex_lock(&mine->lock);
+      mine->head = start;
+      mine->tail = start+nsteal;
+      pthread_mutex_unlock(&mine->lock);
+    }
+  }
+  return 0;
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscThreadCommRunTasks_PThread"
+PetscErrorCode PetscThreadCommRunTasks_PThread(MPI_Comm comm,PetscInt ntasks,const PetscInt tstarts[],PetscThreadTaskKernel kernel,void *ctx)
+{
+  PetscErrorCode          ierr;
+  PetscThreadComm         tcomm=0;
+  PetscThreadComm_PThread ptcomm;
+  PetscPThreadTaskDeque   *deques;
+  PetscPThreadTaskCtx     tctx;
+  PetscInt                i,n,Q,R,start;
+
+  PetscFunctionBegin;
+  ierr   = PetscCommGetThreadComm(comm,&tcomm);CHKERRQ(ierr);
+  ptcomm = (PetscThreadComm_PThread)tcomm->data;
+  n      = tcomm->nworkThreads;
+  if (!ptcomm->deques) {
+    ierr = PetscMalloc(n*sizeof(PetscPThreadTaskDeque),&ptcomm->deques);CHKERRQ(ierr);
+    for (i=0; i<n; i++) {
+      ierr = pthread_mutex_init(&ptcomm->deques[i].lock,PETSC_NULL);CHKERRQ(ierr);
+    }
+  }
+  deques = ptcomm->deques;
+
+  /* each thread starts with a contiguous block of tasks, as with PetscThreadCommGetOwnershipRanges() */
+  Q     = ntasks/n;
+  R     = ntasks - Q*n;
+  start = 0;
+  for (i=0; i<n; i++) {
+    deques[i].head = start;
+    start         += (i < R) ? Q+1 : Q;
+    deques[i].tail = start;
+    deques[i].ierr = 0;
+  }
+  PetscMemoryBarrier();
+
+  tctx.tcomm   = tcomm;
+  tctx.tstarts = tstarts;
+  tctx.kernel  = kernel;
+  tctx.ctx     = ctx;
+  ierr = PetscThreadCommRunKernel1(comm,(PetscThreadKernel)PetscThreadCommTaskKernel_PThread,&tctx);CHKERRQ(ierr);
+  /* tctx lives on this stack, wait for all threads even if the pool does not synchronize after kernels */
+  if (!ptcomm->synchronizeafter) {ierr = PetscThreadCommBarrier(comm);CHKERRQ(ierr);}
+  for (i=0; i<n; i++) {
+    ierr = deques[i].ierr;CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "PetscThreadCommDestroyTasks_PThread"
+PetscErrorCode PetscThreadCommDestroyTasks_PThread(PetscThreadComm tcomm)
+{
+  PetscErrorCode          ierr;
+  PetscThreadComm_PThread ptcomm=(PetscThreadComm_PThread)tcomm->data;
+  PetscInt                i;
+
+  PetscFunctionBegin;
+  if (!ptcomm->deques) PetscFunctionReturn(0);
+  for (i=0; i<tcomm->nworkThreads; i++) {
+    ierr = pthread_mutex_destroy(&ptcomm->deques[i].lock);CHKERRQ(ierr);
+  }
+  ierr = PetscFree(ptcomm->deques);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
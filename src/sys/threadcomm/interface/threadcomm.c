@@ -1115,6 +1115,66 @@ PetscErrorCode PetscThreadCommRunKernel6(MPI_Comm comm,PetscErrorCode (*func)(Pe
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "PetscThreadCommRunTasks"
+/*@C
+   PetscThreadCommRunTasks - Runs a set of independent tasks on the threads of the thread
+                             communicator associated with the MPI communicator, balancing
+                             the load between the threads dynamically
+
+   Not Collective
+
+   Input Parameters:
++  comm    - the MPI communicator
+.  ntasks  - number of tasks
+.  tstarts - task t works on the range [tstarts[t],tstarts[t+1]), array of length ntasks+1, or
+             PETSC_NULL to let task t work on the range [t,t+1)
+.  kernel  - the task kernel
+-  ctx     - user context passed to the kernel
+
+   Level: developer
+
+   Notes:
+   The task kernel is declared as
+$    PetscErrorCode kernel(PetscInt thread_id,PetscInt start,PetscInt end,void *ctx)
+   and may be called any number of times by each thread, once for every task it executes.
+   The tasks must not depend on each other and must not call the PetscThreadComm
+   reduction routines, which require all threads to take part exactly once.
+
+   With the pthread thread communicator each thread starts with a contiguous block of the
+   tasks in its own double-ended queue, working through it from the front. A thread that has
+   run out of tasks steals the back half of the queue of the most loaded thread, hence
+   irregular work, for example rows with very different lengths, should be split into
+   more tasks than there are threads. The OpenMP thread communicator uses a dynamic
+   schedule, and without threads the tasks are executed in order by the calling thread.
+
+   This routine returns after all tasks have completed.
+
+   Called by the main thread only.
+
+.seealso: PetscThreadCommRunKernel(), PetscThreadCommGetOwnershipRanges()
+@*/
+PetscErrorCode PetscThreadCommRunTasks(MPI_Comm comm,PetscInt ntasks,const PetscInt tstarts[],PetscThreadTaskKernel kernel,void *ctx)
+{
+  PetscErrorCode  ierr;
+  PetscThreadComm tcomm=0;
+  PetscInt        t;
+
+  PetscFunctionBegin;
+  if (ntasks < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of tasks %D cannot be negative",ntasks);
+  if (!ntasks) PetscFunctionReturn(0);
+  ierr = PetscCommGetThreadComm(comm,&tcomm);CHKERRQ(ierr);
+  if (tcomm->isnothread || !tcomm->ops->runtasks || tcomm->nworkThreads == 1) {
+    for (t=0; t<ntasks; t++) {
+      if (tstarts) {ierr = (*kernel)(0,tstarts[t],tstarts[t+1],ctx);CHKERRQ(ierr);}
+      else         {ierr = (*kernel)(0,t,t+1,ctx);CHKERRQ(ierr);}
+    }
+  } else {
+    ierr = (*tcomm->ops->runtasks)(comm,ntasks,tstarts,kernel,ctx);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "Petsc_CopyThreadComm"
 /*
@@ -0,0 +1,84 @@
+
+static char help[] = "Tests ISGlobalToLocalMappingApply() with the hash table against the array lookups.\n\n";
+
+#include <petscis.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CheckMapping"
+/* maps the globals with a mapping using the array and one using the hash table, the results must agree */
+static PetscErrorCode CheckMapping(PetscInt n,const PetscInt indices[],PetscInt m,const PetscInt globals[],const char *label)
+{
+  PetscErrorCode         ierr;
+  ISLocalToGlobalMapping marray,mhash;
+  PetscInt               i,na,nh,*la,*lh;
+
+  PetscFunctionBegin;
+  ierr = ISLocalToGlobalMappingCreate(PETSC_COMM_SELF,n,indices,PETSC_COPY_VALUES,&marray);CHKERRQ(ierr);
+  ierr = ISLocalToGlobalMappingCreate(PETSC_COMM_SELF,n,indices,PETSC_COPY_VALUES,&mhash);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingSetUseHash(marray,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingSetUseHash(mhash,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = PetscMalloc2(m,PetscInt,&la,m,PetscInt,&lh);CHKERRQ(ierr);
+
+  ierr = ISGlobalToLocalMappingApply(marray,IS_GTOLM_MASK,m,globals,&na,la);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingApply(mhash,IS_GTOLM_MASK,m,globals,&nh,lh);CHKERRQ(ierr);
+  for (i=0; i<m; i++) {
+    if (la[i] != lh[i]) {
+      ierr = PetscPrintf(PETSC_COMM_SELF,"%s mask: global %D array %D hash %D\n",label,globals[i],la[i],lh[i]);CHKERRQ(ierr);
+    }
+  }
+
+  ierr = ISGlobalToLocalMappingApply(marray,IS_GTOLM_DROP,m,globals,&na,PETSC_NULL);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingApply(mhash,IS_GTOLM_DROP,m,globals,&nh,PETSC_NULL);CHKERRQ(ierr);
+  if (na != nh) {
+    ierr = PetscPrintf(PETSC_COMM_SELF,"%s drop: array finds %D hash %D\n",label,na,nh);CHKERRQ(ierr);
+  }
+  ierr = ISGlobalToLocalMappingApply(marray,IS_GTOLM_DROP,m,globals,&na,la);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingApply(mhash,IS_GTOLM_DROP,m,globals,&nh,lh);CHKERRQ(ierr);
+  for (i=0; i<PetscMin(na,nh); i++) {
+    if (la[i] != lh[i]) {
+      ierr = PetscPrintf(PETSC_COMM_SELF,"%s drop: entry %D array %D hash %D\n",label,i,la[i],lh[i]);CHKERRQ(ierr);
+    }
+  }
+
+  ierr = PetscFree2(la,lh);CHKERRQ(ierr);
+  ierr = ISLocalToGlobalMappingDestroy(&marray);CHKERRQ(ierr);
+  ierr = ISLocalToGlobalMappingDestroy(&mhash);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,n = 1000,m,N = 100000,*indices,*globals;
+
+  ierr = PetscInitialize(&argc,&argv,(char*)0,help);CHKERRQ(ierr);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  m    = 3*n;
+  ierr = PetscMalloc2(n,PetscInt,&indices,m,PetscInt,&globals);CHKERRQ(ierr);
+
+  /* an owned range in the middle and ghosts spread over the whole global range, some marked -1 */
+  for (i=0; i<n; i++) {
+    if (i < n/2) indices[i] = N/2 + i;
+    else         indices[i] = (i%7 == 3) ? -1 : (i*7919)%N;
+  }
+  /* runs of consecutive globals, scattered globals, negative and out of range globals */
+  for (i=0; i<m; i++) {
+    if (i < n)        globals[i] = N/2 - 3 + i;
+    else if (i < 2*n) globals[i] = ((i-n)*7919)%N;
+    else              globals[i] = (i%5 == 0) ? -1 : ((i%5 == 1) ? N + i : (i*104729)%N);
+  }
+  ierr = CheckMapping(n,indices,m,globals,"unique");CHKERRQ(ierr);
+
+  /* global indices appearing twice in the mapping */
+  for (i=n/2; i<n; i+=10) indices[i] = N/2 + i%(n/2);
+  ierr = CheckMapping(n,indices,m,globals,"duplicates");CHKERRQ(ierr);
+
+  ierr = CheckMapping(0,indices,m,globals,"empty");CHKERRQ(ierr);
+
+  ierr = PetscFree2(indices,globals);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
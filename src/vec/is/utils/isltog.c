@@ -1,8 +1,11 @@
 
 #include <petsc-private/isimpl.h>    /*I "petscis.h"  I*/
+#include <../src/sys/utils/hash.h>
 
 PetscClassId  IS_LTOGM_CLASSID;
 
+static PetscErrorCode ISGlobalToLocalMappingReset_Private(ISLocalToGlobalMapping);
+
 #undef __FUNCT__
 #define __FUNCT__ "ISLocalToGlobalMappingGetSize"
 /*@C
@@ -328,7 +331,7 @@ PetscErrorCode  ISLocalToGlobalMappingDestroy(ISLocalToGlobalMapping *mapping)
   PetscValidHeaderSpecific((*mapping),IS_LTOGM_CLASSID,1);
   if (--((PetscObject)(*mapping))->refct > 0) {*mapping = 0;PetscFunctionReturn(0);}
   ierr = PetscFree((*mapping)->indices);CHKERRQ(ierr);
-  ierr = PetscFree((*mapping)->globals);CHKERRQ(ierr);
+  ierr = ISGlobalToLocalMappingReset_Private(*mapping);CHKERRQ(ierr);
   ierr = PetscHeaderDestroy(mapping);CHKERRQ(ierr);
   *mapping = 0;
   PetscFunctionReturn(0);
@@ -415,6 +418,17 @@ M*/
 
 /* -----------------------------------------------------------------------------------------*/
 
+/*
+    The array from global to local indices is replaced by a hash table when the range of the global
+    indices is more than this many times the number of local indices
+*/
+#define IS_GTOLM_HASH_RATIO 8
+
+typedef struct {
+  PetscHashI ht;        /* local index of each global index */
+  PetscBool  unique;    /* no global index appears twice, so the local index after the previous one found can be tried first */
+} ISGlobalToLocalHash;
+
 #undef __FUNCT__
 #define __FUNCT__ "ISGlobalToLocalMappingSetUp_Private"
 /*
@@ -422,8 +436,12 @@ M*/
 */
 static PetscErrorCode ISGlobalToLocalMappingSetUp_Private(ISLocalToGlobalMapping mapping)
 {
-  PetscErrorCode ierr;
-  PetscInt       i,*idx = mapping->indices,n = mapping->n,end,start,*globals;
+  PetscErrorCode      ierr;
+  PetscInt            i,*idx = mapping->indices,n = mapping->n,end,start,*globals;
+  PetscBool           flg;
+  ISGlobalToLocalHash *gh;
+  khiter_t            k;
+  khint_t             ret;
 
   PetscFunctionBegin;
   end   = 0;
@@ -438,6 +456,27 @@ static PetscErrorCode ISGlobalToLocalMappingSetUp_Private(ISLocalToGlobalMapping
   mapping->globalstart = start;
   mapping->globalend   = end;
 
+  if (!mapping->globalhashset) {
+    ierr = PetscOptionsGetBool(((PetscObject)mapping)->prefix,"-is_globaltolocal_hash",&mapping->globalhash,&flg);CHKERRQ(ierr);
+    if (!flg) mapping->globalhash = (PetscBool)(end-start+1 > IS_GTOLM_HASH_RATIO*n);
+  }
+
+  if (mapping->globalhash) {
+    ierr = PetscNew(ISGlobalToLocalHash,&gh);CHKERRQ(ierr);
+    PetscHashICreate(gh->ht);
+    PetscHashIResize(gh->ht,(khint_t)(n/0.77)+1);
+    gh->unique = PETSC_TRUE;
+    for (i=0; i<n; i++) {
+      if (idx[i] < 0) continue;
+      k = kh_put(HASHI,gh->ht,idx[i],&ret);
+      if (!ret) gh->unique = PETSC_FALSE;
+      kh_val(gh->ht,k) = i;
+    }
+    mapping->globalht = (void*)gh;
+    ierr = PetscLogObjectMemory(mapping,kh_n_buckets(gh->ht)*(2*sizeof(PetscInt)+1));CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
+
   ierr             = PetscMalloc((end-start+2)*sizeof(PetscInt),&globals);CHKERRQ(ierr);
   mapping->globals = globals;
   for (i=0; i<end-start+1; i++) {
@@ -452,6 +491,109 @@ static PetscErrorCode ISGlobalToLocalMappingSetUp_Private(ISLocalToGlobalMapping
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "ISGlobalToLocalMappingReset_Private"
+/*
+    Frees the global to local array or hash table; they are rebuilt on the next use
+*/
+static PetscErrorCode ISGlobalToLocalMappingReset_Private(ISLocalToGlobalMapping mapping)
+{
+  PetscErrorCode      ierr;
+  ISGlobalToLocalHash *gh = (ISGlobalToLocalHash*)mapping->globalht;
+
+  PetscFunctionBegin;
+  ierr = PetscFree(mapping->globals);CHKERRQ(ierr);
+  if (gh) {
+    PetscHashIDestroy(gh->ht);
+    ierr = PetscFree(gh);CHKERRQ(ierr);
+    mapping->globalht = 0;
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "ISGlobalToLocalMappingApply_Hash"
+/*
+    Looks up the global indices in the hash table. Global indices that follow each other usually belong to
+    consecutive local indices (rows of a block, a patch of a mesh) so, when no global index appears twice,
+    the local index following the previous one found is checked first and the table is only probed when
+    such a run ends.
+*/
+static PetscErrorCode ISGlobalToLocalMappingApply_Hash(ISLocalToGlobalMapping mapping,ISGlobalToLocalMappingType type,
+                                                       PetscInt n,const PetscInt idx[],PetscInt *nout,PetscInt idxout[])
+{
+  ISGlobalToLocalHash *gh = (ISGlobalToLocalHash*)mapping->globalht;
+  const PetscInt      *indices = mapping->indices;
+  PetscInt            i,g,loc,last = -1,nf = 0,nl = mapping->n,start = mapping->globalstart,end = mapping->globalend;
+  PetscBool           unique = gh->unique;
+  khiter_t            k;
+
+  PetscFunctionBegin;
+  for (i=0; i<n; i++) {
+    g = idx[i];
+    if (g < 0) {
+      if (type == IS_GTOLM_MASK && idxout) idxout[i] = g;
+      continue;
+    }
+    if (g < start || g > end) loc = -1;
+    else if (unique && last+1 < nl && indices[last+1] == g) loc = last+1;
+    else {
+      k   = kh_get(HASHI,gh->ht,g);
+      loc = (k != kh_end(gh->ht)) ? kh_val(gh->ht,k) : -1;
+    }
+    if (loc >= 0) last = loc;
+    if (type == IS_GTOLM_MASK) {
+      if (idxout) idxout[i] = loc;
+    } else if (loc >= 0) {
+      if (idxout) idxout[nf] = loc;
+      nf++;
+    }
+  }
+  if (nout) *nout = (type == IS_GTOLM_MASK) ? n : nf;
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "ISGlobalToLocalMappingSetUseHash"
+/*@
+    ISGlobalToLocalMappingSetUseHash - Sets whether ISGlobalToLocalMappingApply() finds the local indices
+    with a hash table or with an array covering the range of the global indices of the mapping
+
+    Not collective
+
+    Input Parameters:
++   mapping - mapping between local and global numbering
+-   flg - PETSC_TRUE to use the hash table, PETSC_FALSE for the array
+
+    Options Database Key:
+.   -is_globaltolocal_hash <true,false> - use the hash table
+
+    Notes:
+    By default the hash table is used when the range of the global indices is more than 8 times the number
+    of local indices; then the array would need much more memory than the table, it is O(Nglobal) when the
+    local indices include global indices from both ends of the global numbering. The array gives the
+    fastest lookups.
+
+    Level: advanced
+
+    Concepts: mapping^global to local
+
+.seealso: ISGlobalToLocalMappingApply(), ISLocalToGlobalMappingCreate()
+@*/
+PetscErrorCode  ISGlobalToLocalMappingSetUseHash(ISLocalToGlobalMapping mapping,PetscBool flg)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  PetscValidHeaderSpecific(mapping,IS_LTOGM_CLASSID,1);
+  if ((flg && mapping->globals) || (!flg && mapping->globalht)) {
+    ierr = ISGlobalToLocalMappingReset_Private(mapping);CHKERRQ(ierr);
+  }
+  mapping->globalhash    = flg;
+  mapping->globalhashset = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "ISGlobalToLocalMappingApply"
 /*@
@@ -478,8 +620,8 @@ static PetscErrorCode ISGlobalToLocalMappingSetUp_Private(ISLocalToGlobalMapping
     Notes:
     Either nout or idxout may be PETSC_NULL. idx and idxout may be identical.
 
-    This is not scalable in memory usage. Each processor requires O(Nglobal) size
-    array to compute these.
+    The first call creates an array covering the range of the global indices of the mapping, or a hash
+    table when that range is large; see ISGlobalToLocalMappingSetUseHash().
 
     Level: advanced
 
@@ -489,7 +631,7 @@ static PetscErrorCode ISGlobalToLocalMappingSetUp_Private(ISLocalToGlobalMapping
     Concepts: mapping^global to local
 
 .seealso: ISLocalToGlobalMappingApply(), ISLocalToGlobalMappingCreate(),
-          ISLocalToGlobalMappingDestroy()
+          ISLocalToGlobalMappingDestroy(), ISGlobalToLocalMappingSetUseHash()
 @*/
 PetscErrorCode  ISGlobalToLocalMappingApply(ISLocalToGlobalMapping mapping,ISGlobalToLocalMappingType type,
                                   PetscInt n,const PetscInt idx[],PetscInt *nout,PetscInt idxout[])
@@ -499,9 +641,13 @@ PetscErrorCode  ISGlobalToLocalMappingApply(ISLocalToGlobalMapping mapping,ISGlo
 
   PetscFunctionBegin;
   PetscValidHeaderSpecific(mapping,IS_LTOGM_CLASSID,1);
-  if (!mapping->globals) {
+  if (!mapping->globals && !mapping->globalht) {
     ierr = ISGlobalToLocalMappingSetUp_Private(mapping);CHKERRQ(ierr);
   }
+  if (mapping->globalht) {
+    ierr = ISGlobalToLocalMappingApply_Hash(mapping,type,n,idx,nout,idxout);CHKERRQ(ierr);
+    PetscFunctionReturn(0);
+  }
   globals = mapping->globals;
   start   = mapping->globalstart;
   end     = mapping->globalend;
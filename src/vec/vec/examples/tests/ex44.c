@@ -0,0 +1,86 @@
+
+static char help[] = "Tests VecMultiAXPBYDot() and VecMultiAXPBYDotBegin() against VecAXPBY() and VecDot().\n\n";
+
+#include <petscvec.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  Vec            *V,*W,up[6],ux[6],dx[3],dy[3],wup[6],wux[6],wdx[3],wdy[3];
+  PetscInt       i,j,n = 1000;
+  PetscScalar    alpha[6],beta[6],val[3],sval[3],ref[3];
+  PetscReal      err = 0.0,nrm,enrm;
+  PetscRandom    rctx;
+  /* the update and dot product pattern of one pipelined CG iteration, with vectors reused */
+  PetscInt       iu[6] = {0,1,2,3,4,5},ix[6] = {1,2,4,2,0,1},idx[3] = {5,0,3},idy[3] = {5,4,0};
+
+  PetscInitialize(&argc,&argv,(char*)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rctx);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rctx);CHKERRQ(ierr);
+  ierr = VecCreate(PETSC_COMM_WORLD,&dx[0]);CHKERRQ(ierr);
+  ierr = VecSetSizes(dx[0],n,PETSC_DECIDE);CHKERRQ(ierr);
+  ierr = VecSetFromOptions(dx[0]);CHKERRQ(ierr);
+  ierr = VecDuplicateVecs(dx[0],6,&V);CHKERRQ(ierr);
+  ierr = VecDuplicateVecs(dx[0],6,&W);CHKERRQ(ierr);
+  ierr = VecDestroy(&dx[0]);CHKERRQ(ierr);
+  for (i=0; i<6; i++) {
+    ierr = VecSetRandom(V[i],rctx);CHKERRQ(ierr);
+    ierr = VecCopy(V[i],W[i]);CHKERRQ(ierr);
+  }
+  for (i=0; i<6; i++) {
+    up[i]  = V[iu[i]]; ux[i]  = V[ix[i]];
+    wup[i] = W[iu[i]]; wux[i] = W[ix[i]];
+    alpha[i] = 0.5 - 0.25*i;
+    beta[i]  = (i % 3 == 0) ? 1.0 : ((i % 3 == 1) ? 0.0 : -1.5);
+  }
+  for (j=0; j<3; j++) {
+    dx[j]  = V[idx[j]]; dy[j]  = V[idy[j]];
+    wdx[j] = W[idx[j]]; wdy[j] = W[idy[j]];
+  }
+
+  /* reference result */
+  for (i=0; i<6; i++) {
+    ierr = VecAXPBY(wup[i],alpha[i],beta[i],wux[i]);CHKERRQ(ierr);
+  }
+  for (j=0; j<3; j++) {
+    ierr = VecDot(wdx[j],wdy[j],&ref[j]);CHKERRQ(ierr);
+  }
+  ierr = VecMultiAXPBYDot(6,up,alpha,beta,ux,3,dx,dy,val);CHKERRQ(ierr);
+  for (j=0; j<3; j++) err = PetscMax(err,PetscAbsScalar(val[j]-ref[j])/PetscAbsScalar(ref[j]));
+
+  /* split phase version, the norm is obtained from the first dot product */
+  for (i=0; i<6; i++) {
+    ierr = VecAXPBY(wup[i],alpha[i],beta[i],wux[i]);CHKERRQ(ierr);
+  }
+  for (j=0; j<3; j++) {
+    ierr = VecDot(wdx[j],wdy[j],&ref[j]);CHKERRQ(ierr);
+  }
+  ierr = VecMultiAXPBYDotBegin(6,up,alpha,beta,ux,3,dx,dy,PETSC_NULL);CHKERRQ(ierr);
+  ierr = PetscCommSplitReductionBegin(((PetscObject)dx[0])->comm);CHKERRQ(ierr);
+  ierr = VecNormEnd(dx[0],NORM_2,&nrm);CHKERRQ(ierr);
+  ierr = VecDotEnd(dx[1],dy[1],&sval[1]);CHKERRQ(ierr);
+  ierr = VecDotEnd(dx[2],dy[2],&sval[2]);CHKERRQ(ierr);
+  sval[0] = nrm*nrm;
+  for (j=0; j<3; j++) err = PetscMax(err,PetscAbsScalar(sval[j]-ref[j])/PetscAbsScalar(ref[j]));
+
+  for (i=0; i<6; i++) {
+    ierr = VecAXPY(W[i],-1.0,V[i]);CHKERRQ(ierr);
+    ierr = VecNorm(W[i],NORM_INFINITY,&enrm);CHKERRQ(ierr);
+    ierr = VecNorm(V[i],NORM_INFINITY,&nrm);CHKERRQ(ierr);
+    err  = PetscMax(err,enrm/nrm);
+  }
+  if (err > 1.e-12) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"Error in fused vector updates %G\n",err);CHKERRQ(ierr);
+  } else {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"Fused vector updates and dot products are correct\n");CHKERRQ(ierr);
+  }
+
+  ierr = VecDestroyVecs(6,&V);CHKERRQ(ierr);
+  ierr = VecDestroyVecs(6,&W);CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rctx);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
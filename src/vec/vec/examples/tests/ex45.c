@@ -0,0 +1,128 @@
+
+static char help[] = "Tests the threaded packing and unpacking of parallel VecScatters (-vecscatter_threads).\n\
+Run with -threadcomm_type pthread -threadcomm_nthreads <n> to use the threads.\n\
+Input arguments are:\n\
+  -n <local size> : local size of the vectors\n\n";
+
+#include <petscvec.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "CompareScatters"
+/* applies both scatters in the given mode and checks they produce the same result */
+static PetscErrorCode CompareScatters(VecScatter s1,VecScatter s2,Vec x,Vec y1,Vec y2,InsertMode addv,ScatterMode mode,const char *label)
+{
+  PetscErrorCode ierr;
+  PetscReal      nrm;
+  Vec            from = x,to1 = y1,to2 = y2,w;
+
+  PetscFunctionBegin;
+  if (mode == SCATTER_REVERSE) {
+    ierr = VecDuplicate(x,&w);CHKERRQ(ierr);
+    ierr = VecCopy(x,w);CHKERRQ(ierr);
+    ierr = VecScatterBegin(s1,y1,x,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterEnd(s1,y1,x,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterBegin(s2,y1,w,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterEnd(s2,y1,w,addv,mode);CHKERRQ(ierr);
+    ierr = VecAXPY(w,-1.0,x);CHKERRQ(ierr);
+    ierr = VecNorm(w,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+    ierr = VecDestroy(&w);CHKERRQ(ierr);
+  } else {
+    ierr = VecCopy(to1,to2);CHKERRQ(ierr);
+    ierr = VecScatterBegin(s1,from,to1,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterEnd(s1,from,to1,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterBegin(s2,from,to2,addv,mode);CHKERRQ(ierr);
+    ierr = VecScatterEnd(s2,from,to2,addv,mode);CHKERRQ(ierr);
+    ierr = VecAXPY(to2,-1.0,to1);CHKERRQ(ierr);
+    ierr = VecNorm(to2,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+  }
+  if (nrm > 1.e-12) {
+    ierr = PetscPrintf(PETSC_COMM_WORLD,"%s: threaded scatter differs by %G\n",label,nrm);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **argv)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size,rank;
+  PetscInt       n = 31,bs,N,i,k,m,*ix,*iy;
+  Vec            x,y1,y2;
+  IS             isx,isy;
+  VecScatter     s1,s2,s3;
+  PetscRandom    rctx;
+  char           label[64];
+
+  PetscInitialize(&argc,&argv,(char*)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(PETSC_COMM_WORLD,&size);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+  ierr = PetscRandomCreate(PETSC_COMM_WORLD,&rctx);CHKERRQ(ierr);
+  ierr = PetscRandomSetFromOptions(rctx);CHKERRQ(ierr);
+
+  for (bs=1; bs<=3; bs+=2) {
+    ierr = VecCreate(PETSC_COMM_WORLD,&x);CHKERRQ(ierr);
+    ierr = VecSetSizes(x,bs*n,PETSC_DETERMINE);CHKERRQ(ierr);
+    ierr = VecSetBlockSize(x,bs);CHKERRQ(ierr);
+    ierr = VecSetFromOptions(x);CHKERRQ(ierr);
+    ierr = VecGetSize(x,&N);CHKERRQ(ierr);
+    N    = N/bs;
+
+    /* gather blocks from all over the vector, with repeated blocks so that reverse ADD_VALUES accumulates */
+    m    = 2*n + 5*rank;
+    ierr = PetscMalloc2(m,PetscInt,&ix,m,PetscInt,&iy);CHKERRQ(ierr);
+    for (i=0; i<m; i++) {
+      k     = (7*i + 3*rank*n + (i*i) % 13) % N;
+      if (i % 6 == 5) k = ix[i-1];
+      ix[i] = k;
+      iy[i] = i;
+    }
+    ierr = VecCreate(PETSC_COMM_WORLD,&y1);CHKERRQ(ierr);
+    ierr = VecSetSizes(y1,bs*m,PETSC_DETERMINE);CHKERRQ(ierr);
+    ierr = VecSetBlockSize(y1,bs);CHKERRQ(ierr);
+    ierr = VecSetFromOptions(y1);CHKERRQ(ierr);
+    ierr = VecDuplicate(y1,&y2);CHKERRQ(ierr);
+    ierr = VecGetOwnershipRange(y1,&k,PETSC_NULL);CHKERRQ(ierr);
+    for (i=0; i<m; i++) iy[i] += k/bs;
+    ierr = ISCreateBlock(PETSC_COMM_SELF,bs,m,ix,PETSC_COPY_VALUES,&isx);CHKERRQ(ierr);
+    ierr = ISCreateBlock(PETSC_COMM_SELF,bs,m,iy,PETSC_COPY_VALUES,&isy);CHKERRQ(ierr);
+
+    ierr = PetscOptionsSetValue("-vecscatter_threads","0");CHKERRQ(ierr);
+    ierr = VecScatterCreate(x,isx,y1,isy,&s1);CHKERRQ(ierr);
+    ierr = PetscOptionsSetValue("-vecscatter_threads","1");CHKERRQ(ierr);
+    ierr = VecScatterCreate(x,isx,y1,isy,&s2);CHKERRQ(ierr);
+    ierr = VecScatterCopy(s2,&s3);CHKERRQ(ierr);
+
+    ierr = VecSetRandom(x,rctx);CHKERRQ(ierr);
+    ierr = VecSetRandom(y1,rctx);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D forward insert",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s2,x,y1,y2,INSERT_VALUES,SCATTER_FORWARD,label);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D forward add",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s2,x,y1,y2,ADD_VALUES,SCATTER_FORWARD,label);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D reverse add",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s2,x,y1,y2,ADD_VALUES,SCATTER_REVERSE,label);CHKERRQ(ierr);
+#if !defined(PETSC_USE_COMPLEX)
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D reverse max",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s2,x,y1,y2,MAX_VALUES,SCATTER_REVERSE,label);CHKERRQ(ierr);
+#endif
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D copy forward add",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s3,x,y1,y2,ADD_VALUES,SCATTER_FORWARD,label);CHKERRQ(ierr);
+    ierr = PetscSNPrintf(label,sizeof(label),"bs %D copy reverse add",bs);CHKERRQ(ierr);
+    ierr = CompareScatters(s1,s3,x,y1,y2,ADD_VALUES,SCATTER_REVERSE,label);CHKERRQ(ierr);
+
+    ierr = VecScatterDestroy(&s1);CHKERRQ(ierr);
+    ierr = VecScatterDestroy(&s2);CHKERRQ(ierr);
+    ierr = VecScatterDestroy(&s3);CHKERRQ(ierr);
+    ierr = ISDestroy(&isx);CHKERRQ(ierr);
+    ierr = ISDestroy(&isy);CHKERRQ(ierr);
+    ierr = PetscFree2(ix,iy);CHKERRQ(ierr);
+    ierr = VecDestroy(&x);CHKERRQ(ierr);
+    ierr = VecDestroy(&y1);CHKERRQ(ierr);
+    ierr = VecDestroy(&y2);CHKERRQ(ierr);
+  }
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscRandomDestroy(&rctx);CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
@@ -0,0 +1,86 @@
+
+static char help[] = "Tests asynchronous VecView() with a binary viewer set with PetscViewerBinarySetAsync().\n\
+Input arguments are:\n\
+  -n <n> : local size of the vectors\n\n";
+
+#include <petscvec.h>
+
+#undef __FUNCT__
+#define __FUNCT__ "main"
+int main(int argc,char **args)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    rank;
+  PetscInt       n = 1000,i,k,rstart,nviews = 3;
+  PetscScalar    v;
+  PetscReal      nrm;
+  Vec            x,y,z;
+  PetscViewer    viewer;
+
+  PetscInitialize(&argc,&args,(char *)0,help);
+  ierr = PetscOptionsGetInt(PETSC_NULL,"-n",&n,PETSC_NULL);CHKERRQ(ierr);
+  ierr = MPI_Comm_rank(PETSC_COMM_WORLD,&rank);CHKERRQ(ierr);
+
+  /* local sizes differ between the processes */
+  ierr = VecCreate(PETSC_COMM_WORLD,&x);CHKERRQ(ierr);
+  ierr = VecSetSizes(x,n+7*rank,PETSC_DECIDE);CHKERRQ(ierr);
+  ierr = VecSetFromOptions(x);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&y);CHKERRQ(ierr);
+  ierr = VecDuplicate(x,&z);CHKERRQ(ierr);
+  ierr = VecGetOwnershipRange(x,&rstart,PETSC_NULL);CHKERRQ(ierr);
+
+  /* the vector is changed right after each view, the file must have the values at the time of the view */
+  ierr = PetscViewerBinaryOpen(PETSC_COMM_WORLD,"ex46.dat",FILE_MODE_WRITE,&viewer);CHKERRQ(ierr);
+  ierr = PetscViewerBinarySetAsync(viewer,PETSC_TRUE);CHKERRQ(ierr);
+  for (k=0; k<nviews; k++) {
+    for (i=rstart; i<rstart+n+7*rank; i++) {
+      v    = 1000.0*k + i;
+      ierr = VecSetValues(x,1,&i,&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+    ierr = VecAssemblyBegin(x);CHKERRQ(ierr);
+    ierr = VecAssemblyEnd(x);CHKERRQ(ierr);
+    ierr = VecView(x,viewer);CHKERRQ(ierr);
+    ierr = VecSet(x,-1.0);CHKERRQ(ierr);
+    if (k == 1) {ierr = PetscViewerBinaryWait(viewer);CHKERRQ(ierr);}
+  }
+  /* a synchronous view after the asynchronous ones */
+  ierr = PetscViewerBinarySetAsync(viewer,PETSC_FALSE);CHKERRQ(ierr);
+  ierr = VecSet(x,3.0);CHKERRQ(ierr);
+  ierr = VecView(x,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  /* one more asynchronous view appended to the file */
+  ierr = PetscViewerBinaryOpen(PETSC_COMM_WORLD,"ex46.dat",FILE_MODE_APPEND,&viewer);CHKERRQ(ierr);
+  ierr = PetscViewerBinarySetAsync(viewer,PETSC_TRUE);CHKERRQ(ierr);
+  ierr = VecSet(x,4.0);CHKERRQ(ierr);
+  ierr = VecView(x,viewer);CHKERRQ(ierr);
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  ierr = PetscViewerBinaryOpen(PETSC_COMM_WORLD,"ex46.dat",FILE_MODE_READ,&viewer);CHKERRQ(ierr);
+  for (k=0; k<nviews; k++) {
+    for (i=rstart; i<rstart+n+7*rank; i++) {
+      v    = 1000.0*k + i;
+      ierr = VecSetValues(z,1,&i,&v,INSERT_VALUES);CHKERRQ(ierr);
+    }
+    ierr = VecAssemblyBegin(z);CHKERRQ(ierr);
+    ierr = VecAssemblyEnd(z);CHKERRQ(ierr);
+    ierr = VecLoad(y,viewer);CHKERRQ(ierr);
+    ierr = VecAXPY(y,-1.0,z);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+    if (nrm > 0.0) {ierr = PetscPrintf(PETSC_COMM_WORLD,"Asynchronous view %D loaded wrong, error %G\n",k,nrm);CHKERRQ(ierr);}
+  }
+  for (k=3; k<5; k++) {
+    ierr = VecLoad(y,viewer);CHKERRQ(ierr);
+    ierr = VecShift(y,-(PetscScalar)k);CHKERRQ(ierr);
+    ierr = VecNorm(y,NORM_INFINITY,&nrm);CHKERRQ(ierr);
+    if (nrm > 0.0) {ierr = PetscPrintf(PETSC_COMM_WORLD,"View with value %D loaded wrong, error %G\n",k,nrm);CHKERRQ(ierr);}
+  }
+  ierr = PetscViewerDestroy(&viewer);CHKERRQ(ierr);
+
+  ierr = VecDestroy(&x);CHKERRQ(ierr);
+  ierr = VecDestroy(&y);CHKERRQ(ierr);
+  ierr = VecDestroy(&z);CHKERRQ(ierr);
+  ierr = PetscPrintf(PETSC_COMM_WORLD,"Done\n");CHKERRQ(ierr);
+  ierr = PetscFinalize();
+  return 0;
+}
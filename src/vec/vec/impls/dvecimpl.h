@@ -23,6 +23,7 @@ extern PetscErrorCode VecMAXPY_Seq(Vec,PetscInt,const PetscScalar *,Vec *);
 extern PetscErrorCode VecAYPX_Seq(Vec,PetscScalar,Vec);
 extern PetscErrorCode VecWAXPY_Seq(Vec,PetscScalar,Vec,Vec);
 extern PetscErrorCode VecAXPBYPCZ_Seq(Vec,PetscScalar,PetscScalar,PetscScalar,Vec,Vec);
+extern PetscErrorCode VecMultiAXPBYDot_Seq(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar*);
 extern PetscErrorCode VecMaxPointwiseDivide_Seq(Vec,Vec,PetscReal*);
 extern PetscErrorCode VecPlaceArray_Seq(Vec,const PetscScalar *);
 extern PetscErrorCode VecResetArray_Seq(Vec);
@@ -54,6 +55,7 @@ extern PetscErrorCode VecPointwiseDivide_Seq(Vec,Vec,Vec);
 
 EXTERN_C_BEGIN
 extern PetscErrorCode  VecCreate_Seq(Vec);
+extern PetscErrorCode  VecCreate_Standard(Vec);
 EXTERN_C_END
 extern PetscErrorCode VecCreate_Seq_Private(Vec,const PetscScalar[]);
 
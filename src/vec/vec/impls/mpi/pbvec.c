@@ -159,7 +159,12 @@ static struct _VecOps DvOps = { VecDuplicate_MPI, /* 1 */
             0,
             0,
             VecStrideGather_Default,
-            VecStrideScatter_Default
+            VecStrideScatter_Default,
+            0,
+            0,
+            0,
+            VecMultiAXPBYDot_MPI,
+            VecMultiAXPBYDot_Seq
 };
 
 #undef __FUNCT__
@@ -358,7 +358,7 @@ PetscErrorCode VecView_MPI_Binary(Vec xin,PetscViewer viewer)
 #if defined(PETSC_HAVE_MPIIO)
   PetscBool         isMPIIO;
 #endif
-  PetscBool         skipHeader;
+  PetscBool         skipHeader,isAsync;
   PetscInt          message_count,flowcontrolcount;
 
   PetscFunctionBegin;
@@ -376,9 +376,16 @@ PetscErrorCode VecView_MPI_Binary(Vec xin,PetscViewer viewer)
     ierr = PetscViewerBinaryWrite(viewer,tr,2,PETSC_INT,PETSC_FALSE);CHKERRQ(ierr);
   }
 
+  ierr = PetscViewerBinaryGetAsync(viewer,&isAsync);CHKERRQ(ierr);
 #if defined(PETSC_HAVE_MPIIO)
   ierr = PetscViewerBinaryGetMPIIO(viewer,&isMPIIO);CHKERRQ(ierr);
-  if (!isMPIIO) {
+#endif
+  if (isAsync) {
+    ierr = PetscViewerBinaryWriteAsync(viewer,xarray,n,PETSC_SCALAR);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_MPIIO)
+  } else if (!isMPIIO) {
+#else
+  } else {
 #endif
     ierr = PetscViewerFlowControlStart(viewer,&message_count,&flowcontrolcount);CHKERRQ(ierr);
     if (!rank) {
@@ -419,11 +426,12 @@ PetscErrorCode VecView_MPI_Binary(Vec xin,PetscViewer viewer)
 
     ierr = PetscViewerBinaryGetMPIIODescriptor(viewer,&mfdes);CHKERRQ(ierr);
     ierr = PetscViewerBinaryGetMPIIOOffset(viewer,&off);CHKERRQ(ierr);
+    ierr = MPI_File_set_view(mfdes,off,MPIU_SCALAR,view,(char *)"native",MPI_INFO_NULL);CHKERRQ(ierr);
     ierr = MPIU_File_write_all(mfdes,(void*)xarray,lsizes[0],MPIU_SCALAR,MPI_STATUS_IGNORE);CHKERRQ(ierr);
     ierr = PetscViewerBinaryAddMPIIOOffset(viewer,xin->map->N*sizeof(PetscScalar));CHKERRQ(ierr);
     ierr = MPI_Type_free(&view);CHKERRQ(ierr);
-  }
 #endif
+  }
 
   ierr = VecRestoreArrayRead(xin,&xarray);CHKERRQ(ierr);
   if (!rank) {
@@ -1022,6 +1030,7 @@ PetscErrorCode VecAssemblyBegin_MPI(Vec xin)
   ierr = MPI_Allreduce((PetscEnum*)&xin->stash.insertmode,(PetscEnum*)&addv,1,MPIU_ENUM,MPI_BOR,comm);CHKERRQ(ierr);
   if (addv == (ADD_VALUES|INSERT_VALUES)) SETERRQ(comm,PETSC_ERR_ARG_NOTSAMETYPE,"Some processors inserted values while others added");
   xin->stash.insertmode = addv; /* in case this processor had no cache */
+  xin->bstash.insertmode = addv; /* used if the block-stash coalesces */
 
   bs = xin->map->bs;
   ierr = MPI_Comm_size(((PetscObject)xin)->comm,&size);CHKERRQ(ierr);
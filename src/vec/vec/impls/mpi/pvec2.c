@@ -24,6 +24,27 @@ PetscErrorCode VecMDot_MPI(Vec xin,PetscInt nv,const Vec y[],PetscScalar *z)
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "VecMultiAXPBYDot_MPI"
+PetscErrorCode VecMultiAXPBYDot_MPI(PetscInt nu,Vec w[],const PetscScalar alpha[],const PetscScalar beta[],Vec x[],PetscInt nd,Vec dx[],Vec dy[],PetscScalar *z)
+{
+  PetscScalar    awork[128],*work = awork;
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (nd > 128) {
+    ierr = PetscMalloc(nd*sizeof(PetscScalar),&work);CHKERRQ(ierr);
+  }
+  ierr = VecMultiAXPBYDot_Seq(nu,w,alpha,beta,x,nd,dx,dy,work);CHKERRQ(ierr);
+  if (nd) {
+    ierr = MPI_Allreduce(work,z,nd,MPIU_SCALAR,MPIU_SUM,((PetscObject)dx[0])->comm);CHKERRQ(ierr);
+  }
+  if (nd > 128) {
+    ierr = PetscFree(work);CHKERRQ(ierr);
+  }
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "VecMTDot_MPI"
 PetscErrorCode VecMTDot_MPI(Vec xin,PetscInt nv,const Vec y[],PetscScalar *z)
@@ -19,6 +19,7 @@ typedef struct {
 } Vec_MPI;
 
 extern PetscErrorCode VecMDot_MPI(Vec,PetscInt,const Vec[],PetscScalar *);
+extern PetscErrorCode VecMultiAXPBYDot_MPI(PetscInt,Vec[],const PetscScalar[],const PetscScalar[],Vec[],PetscInt,Vec[],Vec[],PetscScalar*);
 extern PetscErrorCode VecTDot_MPI(Vec,Vec,PetscScalar *);
 extern PetscErrorCode VecMTDot_MPI(Vec,PetscInt,const Vec[],PetscScalar *);
 extern PetscErrorCode VecNorm_MPI(Vec,NormType,PetscReal *);
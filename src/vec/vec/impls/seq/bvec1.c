@@ -453,3 +453,75 @@ PetscErrorCode VecAXPBYPCZ_Seq(Vec zin,PetscScalar alpha,PetscScalar beta,PetscS
   PetscFunctionReturn(0);
 }
 #endif
+
+/*
+   Number of entries of each vector processed together in VecMultiAXPBYDot_Seq(); the
+   pieces of all the vectors involved must fit in the first level cache at the same time.
+*/
+#define VEC_MULTIAXPBYDOT_CHUNK 256
+
+#undef __FUNCT__
+#define __FUNCT__ "VecMultiAXPBYDot_Seq"
+/*
+   Performs w[j] = alpha[j]*x[j] + beta[j]*w[j] for j = 0,...,nu-1 (in this order) followed
+   by the local dot products z[k] = dy[k]^H dx[k], k = 0,...,nd-1, in a single sweep over the
+   vectors. The vectors are processed in short chunks, so each entry is loaded from main
+   memory only once even when a vector appears in several of the updates or dot products.
+*/
+PetscErrorCode VecMultiAXPBYDot_Seq(PetscInt nu,Vec w[],const PetscScalar alpha[],const PetscScalar beta[],Vec x[],PetscInt nd,Vec dx[],Vec dy[],PetscScalar *z)
+{
+  PetscErrorCode    ierr;
+  PetscInt          n,i,j,k,start,end;
+  PetscScalar       **wa,a,b,sum;
+  const PetscScalar **xa,**dxa,**dya,*xx,*yy;
+  PetscScalar       *ww;
+  PetscLogDouble    flops = 0.0;
+
+  PetscFunctionBegin;
+  n    = nu ? w[0]->map->n : dx[0]->map->n;
+  ierr = PetscMalloc4(nu,PetscScalar*,&wa,nu,const PetscScalar*,&xa,nd,const PetscScalar*,&dxa,nd,const PetscScalar*,&dya);CHKERRQ(ierr);
+  for (j=0; j<nu; j++) {
+    ierr = VecGetArray(w[j],&wa[j]);CHKERRQ(ierr);
+    ierr = VecGetArrayRead(x[j],&xa[j]);CHKERRQ(ierr);
+  }
+  for (k=0; k<nd; k++) {
+    ierr = VecGetArrayRead(dx[k],&dxa[k]);CHKERRQ(ierr);
+    ierr = VecGetArrayRead(dy[k],&dya[k]);CHKERRQ(ierr);
+    z[k] = 0.0;
+  }
+
+  for (start=0; start<n; start+=VEC_MULTIAXPBYDOT_CHUNK) {
+    end = PetscMin(n,start+VEC_MULTIAXPBYDOT_CHUNK);
+    for (j=0; j<nu; j++) {
+      ww = wa[j]; xx = xa[j]; a = alpha[j]; b = beta[j];
+      if (b == (PetscScalar)1.0) {
+        for (i=start; i<end; i++) ww[i] += a*xx[i];
+      } else if (b == (PetscScalar)0.0) {
+        for (i=start; i<end; i++) ww[i] = a*xx[i];
+      } else {
+        for (i=start; i<end; i++) ww[i] = a*xx[i] + b*ww[i];
+      }
+    }
+    for (k=0; k<nd; k++) {
+      xx = dxa[k]; yy = dya[k]; sum = 0.0;
+      for (i=start; i<end; i++) sum += xx[i]*PetscConj(yy[i]);
+      z[k] += sum;
+    }
+  }
+
+  for (j=0; j<nu; j++) {
+    ierr = VecRestoreArray(w[j],&wa[j]);CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(x[j],&xa[j]);CHKERRQ(ierr);
+    if (beta[j] == (PetscScalar)1.0)      flops += 2.0*n;
+    else if (beta[j] == (PetscScalar)0.0) flops += n;
+    else                                  flops += 3.0*n;
+  }
+  for (k=0; k<nd; k++) {
+    ierr = VecRestoreArrayRead(dx[k],&dxa[k]);CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(dy[k],&dya[k]);CHKERRQ(ierr);
+    if (n > 0) flops += 2.0*n-1;
+  }
+  ierr = PetscFree4(wa,xa,dxa,dya);CHKERRQ(ierr);
+  ierr = PetscLogFlops(flops);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
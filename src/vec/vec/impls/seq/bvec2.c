@@ -906,7 +906,7 @@ PetscErrorCode VecView_Seq_Binary(Vec xin,PetscViewer viewer)
 #if defined(PETSC_HAVE_MPIIO)
   PetscBool         isMPIIO;
 #endif
-  PetscBool         skipHeader;
+  PetscBool         skipHeader,isAsync;
 
   PetscFunctionBegin;
 
@@ -918,9 +918,18 @@ PetscErrorCode VecView_Seq_Binary(Vec xin,PetscViewer viewer)
   }
 
   /* Write vector contents */
+  ierr = PetscViewerBinaryGetAsync(viewer,&isAsync);CHKERRQ(ierr);
 #if defined(PETSC_HAVE_MPIIO)
   ierr = PetscViewerBinaryGetMPIIO(viewer,&isMPIIO);CHKERRQ(ierr);
-  if (!isMPIIO) {
+#endif
+  if (isAsync) {
+    ierr = VecGetArrayRead(xin,&xv);CHKERRQ(ierr);
+    ierr = PetscViewerBinaryWriteAsync(viewer,xv,n,PETSC_SCALAR);CHKERRQ(ierr);
+    ierr = VecRestoreArrayRead(xin,&xv);CHKERRQ(ierr);
+#if defined(PETSC_HAVE_MPIIO)
+  } else if (!isMPIIO) {
+#else
+  } else {
 #endif
     ierr = PetscViewerBinaryGetDescriptor(viewer,&fdes);CHKERRQ(ierr);
     ierr = VecGetArrayRead(xin,&xv);CHKERRQ(ierr);
@@ -946,8 +955,8 @@ PetscErrorCode VecView_Seq_Binary(Vec xin,PetscViewer viewer)
     ierr = VecRestoreArrayRead(xin,&xv);CHKERRQ(ierr);
     ierr = PetscViewerBinaryAddMPIIOOffset(viewer,n*sizeof(PetscScalar));CHKERRQ(ierr);
     ierr = MPI_Type_free(&view);CHKERRQ(ierr);
-  }
 #endif
+  }
 
   ierr = PetscViewerBinaryGetInfoPointer(viewer,&file);CHKERRQ(ierr);
   if (file) {
@@ -1240,7 +1249,12 @@ static struct _VecOps DvOps = {VecDuplicate_Seq, /* 1 */
             0,
             0,
             VecStrideGather_Default,
-            VecStrideScatter_Default
+            VecStrideScatter_Default,
+            0,
+            0,
+            0,
+            VecMultiAXPBYDot_Seq,
+            VecMultiAXPBYDot_Seq
           };
 
 
@@ -700,6 +700,120 @@ PetscErrorCode  VecAXPBYPCZ(Vec z,PetscScalar alpha,PetscScalar beta,PetscScalar
   PetscFunctionReturn(0);
 }
 
+#undef __FUNCT__
+#define __FUNCT__ "VecMultiAXPBYDotCheck_Private"
+/*
+   Argument checking shared by VecMultiAXPBYDot() and VecMultiAXPBYDotBegin()
+*/
+PetscErrorCode VecMultiAXPBYDotCheck_Private(PetscInt nu,Vec w[],const PetscScalar alpha[],const PetscScalar beta[],Vec x[],PetscInt nd,Vec dx[],Vec dy[],PetscScalar val[])
+{
+  Vec      v;
+  PetscInt j;
+
+  PetscFunctionBegin;
+  if (nu < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of updates (given %D) cannot be negative",nu);
+  if (nd < 0) SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_OUTOFRANGE,"Number of dot products (given %D) cannot be negative",nd);
+  if (nu) {
+    PetscValidPointer(w,2);
+    PetscValidScalarPointer(alpha,3);
+    PetscValidScalarPointer(beta,4);
+    PetscValidPointer(x,5);
+  }
+  if (nd) {
+    PetscValidPointer(dx,7);
+    PetscValidPointer(dy,8);
+  }
+  v = nu ? w[0] : dx[0];
+  PetscValidHeaderSpecific(v,VEC_CLASSID,nu ? 2 : 7);
+  PetscValidType(v,nu ? 2 : 7);
+  for (j=0; j<nu; j++) {
+    PetscValidHeaderSpecific(w[j],VEC_CLASSID,2);
+    PetscValidHeaderSpecific(x[j],VEC_CLASSID,5);
+    PetscCheckSameTypeAndComm(v,2,w[j],2);
+    PetscCheckSameTypeAndComm(v,2,x[j],5);
+    PetscCheckSameSizeVec(v,w[j]);
+    PetscCheckSameSizeVec(v,x[j]);
+    if (w[j] == x[j]) SETERRQ1(((PetscObject)v)->comm,PETSC_ERR_ARG_IDN,"w[%D] and x[%D] must be different vectors",j);
+    PetscValidLogicalCollectiveScalar(v,alpha[j],3);
+    PetscValidLogicalCollectiveScalar(v,beta[j],4);
+  }
+  for (j=0; j<nd; j++) {
+    PetscValidHeaderSpecific(dx[j],VEC_CLASSID,7);
+    PetscValidHeaderSpecific(dy[j],VEC_CLASSID,8);
+    PetscCheckSameTypeAndComm(v,7,dx[j],7);
+    PetscCheckSameTypeAndComm(v,7,dy[j],8);
+    PetscCheckSameSizeVec(v,dx[j]);
+    PetscCheckSameSizeVec(v,dy[j]);
+  }
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "VecMultiAXPBYDot"
+/*@
+   VecMultiAXPBYDot - Computes w[j] = alpha[j] x[j] + beta[j] w[j] for j = 0,...,nu-1, in this
+   order, followed by the dot products val[k] = dy[k]^H dx[k] of the updated vectors, with a single
+   pass over the vector entries.
+
+   Collective on Vec
+
+   Input Parameters:
++  nu - number of vector updates
+.  w - the vectors to update
+.  alpha, beta - arrays of nu scalars
+.  x - the vectors added to the w[j]
+.  nd - number of dot products
+.  dx - first vectors of the dot products
+-  dy - second vectors of the dot products
+
+   Output Parameter:
+.  val - the nd dot products
+
+   Level: advanced
+
+   Notes:
+   The same vector may appear several times in w[], x[], dx[] and dy[]; the result is the same
+   as calling VecAXPBY(w[j],alpha[j],beta[j],x[j]) for each j followed by VecDot(dx[k],dy[k],&val[k])
+   for each k. However, w[j] and x[j] must be different vectors.
+
+   This is intended for the vector updates of pipelined Krylov methods, which are limited by
+   memory bandwidth: each vector is streamed through memory once instead of once per operation.
+   beta[j] = 1 and beta[j] = 0 are handled as special cases.
+
+   Concepts: BLAS
+   Concepts: vector^BLAS
+
+.seealso: VecMultiAXPBYDotBegin(), VecAXPBY(), VecMAXPY(), VecDot(), VecMDot()
+@*/
+PetscErrorCode  VecMultiAXPBYDot(PetscInt nu,Vec w[],const PetscScalar alpha[],const PetscScalar beta[],Vec x[],PetscInt nd,Vec dx[],Vec dy[],PetscScalar val[])
+{
+  PetscErrorCode ierr;
+  Vec            v;
+  PetscInt       j;
+
+  PetscFunctionBegin;
+  if (!nu && !nd) PetscFunctionReturn(0);
+  ierr = VecMultiAXPBYDotCheck_Private(nu,w,alpha,beta,x,nd,dx,dy,val);CHKERRQ(ierr);
+  if (nd) PetscValidScalarPointer(val,9);
+  v = nu ? w[0] : dx[0];
+  if (v->ops->multiaxpbydot) {
+    ierr = PetscLogEventBegin(VEC_MultiAXPBYDot,v,0,0,0);CHKERRQ(ierr);
+    ierr = (*v->ops->multiaxpbydot)(nu,w,alpha,beta,x,nd,dx,dy,val);CHKERRQ(ierr);
+    ierr = PetscLogEventEnd(VEC_MultiAXPBYDot,v,0,0,0);CHKERRQ(ierr);
+    for (j=0; j<nu; j++) {
+      ierr = PetscObjectStateIncrease((PetscObject)w[j]);CHKERRQ(ierr);
+    }
+  } else {
+    for (j=0; j<nu; j++) {
+      ierr = VecAXPBY(w[j],alpha[j],beta[j],x[j]);CHKERRQ(ierr);
+    }
+    for (j=0; j<nd; j++) {
+      ierr = VecDot(dx[j],dy[j],&val[j]);CHKERRQ(ierr);
+    }
+  }
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "VecAYPX"
 /*@
@@ -826,3 +826,80 @@ PetscErrorCode  VecMTDotEnd(Vec x,PetscInt nv,const Vec y[],PetscScalar result[]
   ierr = VecMDotEnd(x,nv,y,result);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
+
+#undef __FUNCT__
+#define __FUNCT__ "VecMultiAXPBYDotBegin"
+/*@
+   VecMultiAXPBYDotBegin - Computes w[j] = alpha[j] x[j] + beta[j] w[j] for j = 0,...,nu-1 and
+   starts the split phase computation of the dot products dy[k]^H dx[k] of the updated vectors.
+   The vector updates and the local parts of the dot products are done in a single pass
+   over the vector entries.
+
+   Collective on Vec
+
+   Input Parameters:
++  nu - number of vector updates
+.  w - the vectors to update
+.  alpha, beta - arrays of nu scalars
+.  x - the vectors added to the w[j]
+.  nd - number of dot products
+.  dx - first vectors of the dot products
+.  dy - second vectors of the dot products
+-  val - where the results will go (can be PETSC_NULL)
+
+   Level: advanced
+
+   Notes:
+   The result of each dot product is obtained, in order, with VecDotEnd(dx[k],dy[k],&val[k]).
+   When dx[k] == dy[k] the dot product is the square of the 2-norm and may be obtained with
+   VecNormEnd(dx[k],NORM_2,&norm) instead; consecutive dot products with the same dx[] vector
+   may be obtained together with VecMDotEnd().
+
+   The same vector may appear several times in w[], x[], dx[] and dy[], but w[j] and x[j]
+   must be different vectors. See VecMultiAXPBYDot() for the blocking version.
+
+.seealso: VecMultiAXPBYDot(), VecDotBegin(), VecDotEnd(), VecNormEnd(), VecMDotEnd(), PetscCommSplitReductionBegin()
+@*/
+PetscErrorCode  VecMultiAXPBYDotBegin(PetscInt nu,Vec w[],const PetscScalar alpha[],const PetscScalar beta[],Vec x[],PetscInt nd,Vec dx[],Vec dy[],PetscScalar val[])
+{
+  PetscErrorCode      ierr;
+  PetscSplitReduction *sr;
+  MPI_Comm            comm;
+  Vec                 v;
+  PetscInt            j;
+
+  PetscFunctionBegin;
+  if (!nu && !nd) PetscFunctionReturn(0);
+  ierr = VecMultiAXPBYDotCheck_Private(nu,w,alpha,beta,x,nd,dx,dy,PETSC_NULL);CHKERRQ(ierr);
+  v    = nu ? w[0] : dx[0];
+  ierr = PetscObjectGetComm((PetscObject)v,&comm);CHKERRQ(ierr);
+  ierr = PetscSplitReductionGet(comm,&sr);CHKERRQ(ierr);
+  if (nd && sr->state != STATE_BEGIN) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_ORDER,"Called before all VecxxxEnd() called");
+  for (j=0; j<nd; j++) {
+    if (sr->numopsbegin+j >= sr->maxops) {
+      ierr = PetscSplitReductionExtend(sr);CHKERRQ(ierr);
+    }
+    sr->reducetype[sr->numopsbegin+j] = REDUCE_SUM;
+    sr->invecs[sr->numopsbegin+j]     = (void*)dx[j];
+  }
+  if (v->ops->multiaxpbydot_local) {
+    ierr = PetscLogEventBegin(VEC_MultiAXPBYDot,v,0,0,0);CHKERRQ(ierr);
+    ierr = (*v->ops->multiaxpbydot_local)(nu,w,alpha,beta,x,nd,dx,dy,sr->lvalues+sr->numopsbegin);CHKERRQ(ierr);
+    ierr = PetscLogEventEnd(VEC_MultiAXPBYDot,v,0,0,0);CHKERRQ(ierr);
+    for (j=0; j<nu; j++) {
+      ierr = PetscObjectStateIncrease((PetscObject)w[j]);CHKERRQ(ierr);
+    }
+  } else {
+    for (j=0; j<nu; j++) {
+      ierr = VecAXPBY(w[j],alpha[j],beta[j],x[j]);CHKERRQ(ierr);
+    }
+    if (nd && !v->ops->dot_local) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"Vector does not suppport local dots");
+    ierr = PetscLogEventBegin(VEC_ReduceArithmetic,0,0,0,0);CHKERRQ(ierr);
+    for (j=0; j<nd; j++) {
+      ierr = (*v->ops->dot_local)(dx[j],dy[j],sr->lvalues+sr->numopsbegin+j);CHKERRQ(ierr);
+    }
+    ierr = PetscLogEventEnd(VEC_ReduceArithmetic,0,0,0,0);CHKERRQ(ierr);
+  }
+  sr->numopsbegin += nd;
+  PetscFunctionReturn(0);
+}
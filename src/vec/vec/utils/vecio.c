@@ -8,6 +8,7 @@
 #include <petscsys.h>
 #include <petscvec.h>         /*I  "petscvec.h"  I*/
 #include <petsc-private/vecimpl.h>
+#include <../src/vec/vec/impls/dvecimpl.h>
 #include <petscmat.h> /* so that MAT_FILE_CLASSID is defined */
 
 #undef __FUNCT__
@@ -71,6 +72,56 @@ static PetscErrorCode VecLoad_Binary_MPIIO(Vec vec, PetscViewer viewer)
 }
 #endif
 
+#if !defined(PETSC_USE_MIXED_PRECISION)
+#undef __FUNCT__
+#define __FUNCT__ "VecLoad_Binary_Mapped"
+/*
+   Makes a sequential vector use its values in place in the memory mapped file, see PetscViewerBinarySetMmap().
+   Only done when the vector is created here or owns its array, otherwise done is PETSC_FALSE and nothing was read.
+*/
+static PetscErrorCode VecLoad_Binary_Mapped(Vec vec,PetscViewer viewer,PetscInt rows,PetscBool *done)
+{
+  PetscErrorCode ierr;
+  PetscMPIInt    size;
+  PetscBool      usemmap,isseq;
+  PetscObject    map,oldmap;
+  Vec_Seq        *s;
+  void           *array;
+
+  PetscFunctionBegin;
+  *done = PETSC_FALSE;
+  ierr = PetscViewerBinaryGetMmap(viewer,&usemmap);CHKERRQ(ierr);
+  ierr = MPI_Comm_size(((PetscObject)vec)->comm,&size);CHKERRQ(ierr);
+  if (!usemmap || size > 1) PetscFunctionReturn(0);
+  if (vec->map->n < 0 && vec->map->N < 0) {
+    /* the creation of the vector was deferred until its size is known, so no array was allocated yet */
+    if (vec->ops->create != VecCreate_Seq && vec->ops->create != VecCreate_Standard) PetscFunctionReturn(0);
+    ierr = PetscViewerBinaryReadMapped(viewer,rows,PETSC_SCALAR,&array,&map);CHKERRQ(ierr);
+    if (!array) PetscFunctionReturn(0);
+    vec->ops->create = 0;
+    ierr = VecSetSizes(vec,rows,rows);CHKERRQ(ierr);
+    ierr = VecCreate_Seq_Private(vec,(PetscScalar*)array);CHKERRQ(ierr);
+  } else {
+    ierr = PetscObjectTypeCompare((PetscObject)vec,VECSEQ,&isseq);CHKERRQ(ierr);
+    if (!isseq || vec->map->N != rows) PetscFunctionReturn(0);
+    s    = (Vec_Seq*)vec->data;
+    ierr = PetscObjectQuery((PetscObject)vec,"PetscViewerBinaryMap",&oldmap);CHKERRQ(ierr);
+    if (s->unplacedarray || (s->array != s->array_allocated && !oldmap)) PetscFunctionReturn(0);
+    ierr = PetscViewerBinaryReadMapped(viewer,rows,PETSC_SCALAR,&array,&map);CHKERRQ(ierr);
+    if (!array) PetscFunctionReturn(0);
+    ierr = PetscFree(s->array_allocated);CHKERRQ(ierr);
+    s->array = (PetscScalar*)array;
+    ierr = PetscObjectStateIncrease((PetscObject)vec);CHKERRQ(ierr);
+  }
+  /* the vector keeps the mapping until it is destroyed */
+  ierr = PetscObjectCompose((PetscObject)vec,"PetscViewerBinaryMap",map);CHKERRQ(ierr);
+  ierr = VecAssemblyBegin(vec);CHKERRQ(ierr);
+  ierr = VecAssemblyEnd(vec);CHKERRQ(ierr);
+  *done = PETSC_TRUE;
+  PetscFunctionReturn(0);
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "VecLoad_Binary"
 PetscErrorCode VecLoad_Binary(Vec vec, PetscViewer viewer)
@@ -100,6 +151,12 @@ PetscErrorCode VecLoad_Binary(Vec vec, PetscViewer viewer)
   if (flag) {
     ierr = VecSetBlockSize(vec, bs);CHKERRQ(ierr);
   }
+#if !defined(PETSC_USE_MIXED_PRECISION)
+  if (size == 1) {
+    ierr = VecLoad_Binary_Mapped(vec,viewer,rows,&flag);CHKERRQ(ierr);
+    if (flag) PetscFunctionReturn(0);
+  }
+#endif
   if (vec->map->n < 0 && vec->map->N < 0) {
      ierr = VecSetSizes(vec,PETSC_DECIDE,rows);CHKERRQ(ierr);
   }
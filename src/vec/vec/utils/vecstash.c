@@ -1,5 +1,6 @@
 
 #include <petsc-private/vecimpl.h>
+#include <../src/sys/utils/hash.h>
 
 #define DEFAULT_STASH_SIZE   100
 
@@ -9,6 +10,8 @@
   to be stored on other processors are kept until matrix assembly is done.
 
   This is a simple minded stash. Simply adds entries to end of stash.
+  With -vecstash_coalesce the entries with the same row are combined
+  in VecStashScatterBegin_Private() so that each is sent only once.
 
   Input Parameters:
   comm - communicator, required for scatters.
@@ -69,6 +72,8 @@ PetscErrorCode VecStashCreate_Private(MPI_Comm comm,PetscInt bs,VecStash *stash)
   stash->nprocessed  = 0;
   stash->donotstash  = PETSC_FALSE;
   stash->ignorenegidx  = PETSC_FALSE;
+  stash->coalesce    = PETSC_FALSE;
+  ierr = PetscOptionsGetBool(PETSC_NULL,"-vecstash_coalesce",&stash->coalesce,PETSC_NULL);CHKERRQ(ierr);
   PetscFunctionReturn(0);
 }
 
@@ -233,6 +238,10 @@ PetscErrorCode VecStashExpand_Private(VecStash *stash,PetscInt incr)
   Notes: The 'owners' array in the cased of the blocked-stash has the
   ranges specified blocked global indices, and for the regular stash in
   the proper global indices.
+
+  If the stash coalesces, the entries with the same row are combined with
+  stash->insertmode before packing: added for ADD_VALUES, while for
+  INSERT_VALUES the last one stashed is kept.
 */
 #undef __FUNCT__
 #define __FUNCT__ "VecStashScatterBegin_Private"
@@ -245,6 +254,10 @@ PetscErrorCode VecStashScatterBegin_Private(VecStash *stash,PetscInt *owners)
   PetscScalar    *rvalues,*svalues;
   MPI_Comm       comm = stash->comm;
   MPI_Request    *send_waits,*recv_waits;
+  PetscInt       *slot = PETSC_NULL,k;
+  PetscHashI     ht = PETSC_NULL;
+  khiter_t       hi;
+  khint_t        hret;
 
   PetscFunctionBegin;
 
@@ -252,10 +265,22 @@ PetscErrorCode VecStashScatterBegin_Private(VecStash *stash,PetscInt *owners)
   ierr   = PetscMalloc(2*size*sizeof(PetscInt),&nprocs);CHKERRQ(ierr);
   ierr   = PetscMemzero(nprocs,2*size*sizeof(PetscInt));CHKERRQ(ierr);
   ierr   = PetscMalloc(stash->n*sizeof(PetscInt),&owner);CHKERRQ(ierr);
+  if (stash->coalesce && stash->n) {
+    /* slot[i] is -(first+1) if entry i repeats the row of entry first, and later its position in svalues */
+    ierr = PetscMalloc(stash->n*sizeof(PetscInt),&slot);CHKERRQ(ierr);
+    PetscHashICreate(ht);
+    PetscHashIResize(ht,stash->n);
+  }
 
   j       = 0;
   lastidx = -1;
   for (i=0; i<stash->n; i++) {
+    if (ht) {
+      hi = kh_put(HASHI,ht,stash->idx[i],&hret);
+      if (!hret) {slot[i] = -(kh_val(ht,hi)+1); continue;}
+      kh_val(ht,hi) = i;
+      slot[i]       = 0;
+    }
     /* if indices are NOT locally sorted, need to start search at the beginning */
     if (lastidx > (idx = stash->idx[i])) j = 0;
     lastidx = idx;
@@ -266,6 +291,10 @@ PetscErrorCode VecStashScatterBegin_Private(VecStash *stash,PetscInt *owners)
     }
   }
   nsends = 0;  for (i=0; i<size; i++) { nsends += nprocs[2*i+1];}
+  if (ht) {
+    ierr = PetscInfo2(PETSC_NULL,"Coalesced %D stashed entries into %D\n",stash->n,(PetscInt)kh_size(ht));CHKERRQ(ierr);
+    PetscHashIDestroy(ht);
+  }
 
   /* inform other processors of number of messages and max length*/
   ierr = PetscMaxSum(comm,nprocs,&nmax,&nreceives);CHKERRQ(ierr);
@@ -295,7 +324,14 @@ PetscErrorCode VecStashScatterBegin_Private(VecStash *stash,PetscInt *owners)
     start[i] = start[i-1] + nprocs[2*i-2];
   }
   for (i=0; i<stash->n; i++) {
+    if (slot && slot[i] < 0) {
+      PetscScalar *buf = svalues+bs*slot[-(slot[i]+1)];
+      if (stash->insertmode == ADD_VALUES) {for (k=0; k<bs; k++) buf[k] += stash->array[bs*i+k];}
+      else                                 {for (k=0; k<bs; k++) buf[k]  = stash->array[bs*i+k];}
+      continue;
+    }
     j = owner[i];
+    if (slot) slot[i] = start[j];
     if (bs == 1) {
       svalues[start[j]] = stash->array[i];
     } else {
@@ -313,6 +349,7 @@ PetscErrorCode VecStashScatterBegin_Private(VecStash *stash,PetscInt *owners)
     }
   }
   ierr = PetscFree(owner);CHKERRQ(ierr);
+  ierr = PetscFree(slot);CHKERRQ(ierr);
   ierr = PetscFree(start);CHKERRQ(ierr);
   /* This memory is reused in scatter end  for a different purpose*/
   for (i=0; i<2*size; i++) nprocs[i] = -1;
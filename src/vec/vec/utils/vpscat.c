@@ -7,6 +7,7 @@
 #include <petsc-private/vecimpl.h>         /*I "petscvec.h" I*/
 #include <../src/vec/vec/impls/dvecimpl.h>
 #include <../src/vec/vec/impls/mpi/pvecimpl.h>
+#include <petscthreadcomm.h>
 
 #undef __FUNCT__
 #define __FUNCT__ "VecScatterView_MPI"
@@ -133,6 +134,95 @@ PetscErrorCode VecScatterLocalOptimize_Private(VecScatter scatter,VecScatter_Seq
 /* --------------------------------------------------------------------------------------*/
 
 /* -------------------------------------------------------------------------------------*/
+/*
+    Sets up the threaded packing and unpacking of one side of a scatter, -vecscatter_threads.
+
+    The entries of the send buffer are split evenly among the threads for packing; with
+    threads_send the split is rounded to whole messages so each thread can start the sends
+    of what it packed. For unpacking, the local vector is split among the threads at the
+    quantiles of the receive indices and each thread only writes the entries that land in
+    its own part, so ADD_VALUES needs no locking and the result does not depend on the
+    order in which the threads run.
+*/
+#undef __FUNCT__
+#define __FUNCT__ "VecScatterSetUpThreads_Private"
+static PetscErrorCode VecScatterSetUpThreads_Private(VecScatter scatter,VecScatter_MPI_General *gen,PetscInt nthreads,PetscBool threads_send)
+{
+  PetscErrorCode ierr;
+  PetscInt       n = gen->n,N = gen->starts[gen->n],i,k,t,lo,hi,mid,*sorted,*bounds,*cnt;
+
+  PetscFunctionBegin;
+  gen->use_threads  = PETSC_TRUE;
+  gen->threads_send = threads_send;
+  gen->nthreads     = nthreads;
+  ierr = PetscMalloc4(nthreads+1,PetscInt,&gen->tpackstarts,nthreads+1,PetscInt,&gen->tmsgstarts,n*nthreads+1,PetscInt,&gen->tunpackstarts,N,PetscInt,&gen->tunpackslots);CHKERRQ(ierr);
+  ierr = PetscMalloc2(n,PetscMPIInt,&gen->tarrived,n,PetscInt,&gen->tbatch);CHKERRQ(ierr);
+  ierr = PetscLogObjectMemory(scatter,(2*nthreads+n*nthreads+N+3)*sizeof(PetscInt)+n*(sizeof(PetscMPIInt)+sizeof(PetscInt)));CHKERRQ(ierr);
+
+  /* packing */
+  if (threads_send) {
+    /* message i goes to the thread owning the middle of its part of the send buffer */
+    gen->tmsgstarts[0] = 0;
+    for (t=0,i=0; t<nthreads; t++) {
+      while (i < n && ((gen->starts[i]+gen->starts[i+1])*nthreads)/(2*N) <= t) i++;
+      gen->tmsgstarts[t+1] = i;
+    }
+    gen->tmsgstarts[nthreads] = n;
+    for (t=0; t<=nthreads; t++) gen->tpackstarts[t] = gen->starts[gen->tmsgstarts[t]];
+  } else {
+    for (t=0; t<=nthreads; t++) {
+      gen->tpackstarts[t] = (N*t)/nthreads;
+      gen->tmsgstarts[t]  = 0;
+    }
+  }
+
+  /* unpacking: thread t owns the entries with bounds[t] <= index < bounds[t+1] */
+  ierr = PetscMalloc3(N,PetscInt,&sorted,nthreads+1,PetscInt,&bounds,n*nthreads+1,PetscInt,&cnt);CHKERRQ(ierr);
+  ierr = PetscMemcpy(sorted,gen->indices,N*sizeof(PetscInt));CHKERRQ(ierr);
+  ierr = PetscSortInt(N,sorted);CHKERRQ(ierr);
+  bounds[0]        = PETSC_MIN_INT;
+  bounds[nthreads] = PETSC_MAX_INT;
+  for (t=1; t<nthreads; t++) bounds[t] = N ? sorted[(N*t)/nthreads] : 0;
+  ierr = PetscMemzero(cnt,(n*nthreads+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    for (k=gen->starts[i]; k<gen->starts[i+1]; k++) {
+      /* largest t with bounds[t] <= indices[k] */
+      lo = 0; hi = nthreads;
+      while (hi - lo > 1) {
+        mid = (lo + hi)/2;
+        if (bounds[mid] <= gen->indices[k]) lo = mid;
+        else hi = mid;
+      }
+      sorted[k] = lo;
+      cnt[i*nthreads+lo+1]++;
+    }
+  }
+  gen->tunpackstarts[0] = 0;
+  for (k=0; k<n*nthreads; k++) gen->tunpackstarts[k+1] = gen->tunpackstarts[k] + cnt[k+1];
+  ierr = PetscMemcpy(cnt,gen->tunpackstarts,(n*nthreads+1)*sizeof(PetscInt));CHKERRQ(ierr);
+  for (i=0; i<n; i++) {
+    for (k=gen->starts[i]; k<gen->starts[i+1]; k++) {
+      gen->tunpackslots[cnt[i*nthreads+sorted[k]]++] = k;
+    }
+  }
+  ierr = PetscFree3(sorted,bounds,cnt);CHKERRQ(ierr);
+  PetscFunctionReturn(0);
+}
+
+#undef __FUNCT__
+#define __FUNCT__ "VecScatterDestroyThreads_Private"
+static PetscErrorCode VecScatterDestroyThreads_Private(VecScatter_MPI_General *gen)
+{
+  PetscErrorCode ierr;
+
+  PetscFunctionBegin;
+  if (!gen->use_threads) PetscFunctionReturn(0);
+  ierr = PetscFree4(gen->tpackstarts,gen->tmsgstarts,gen->tunpackstarts,gen->tunpackslots);CHKERRQ(ierr);
+  ierr = PetscFree2(gen->tarrived,gen->tbatch);CHKERRQ(ierr);
+  gen->use_threads = PETSC_FALSE;
+  PetscFunctionReturn(0);
+}
+
 #undef __FUNCT__
 #define __FUNCT__ "VecScatterDestroy_PtoP"
 PetscErrorCode VecScatterDestroy_PtoP(VecScatter ctx)
@@ -217,6 +307,8 @@ PetscErrorCode VecScatterDestroy_PtoP(VecScatter ctx)
   }
 #endif
 
+  ierr = VecScatterDestroyThreads_Private(to);CHKERRQ(ierr);
+  ierr = VecScatterDestroyThreads_Private(from);CHKERRQ(ierr);
   ierr = PetscFree(to->local.vslots);CHKERRQ(ierr);
   ierr = PetscFree(from->local.vslots);CHKERRQ(ierr);
   ierr = PetscFree2(to->counts,to->displs);CHKERRQ(ierr);
@@ -403,6 +495,11 @@ PetscErrorCode VecScatterCopy_PtoP_X(VecScatter in,VecScatter out)
     }
   }
 
+  if (in_to->use_threads) {
+    ierr = VecScatterSetUpThreads_Private(out,out_to,in_to->nthreads,in_to->threads_send);CHKERRQ(ierr);
+    ierr = VecScatterSetUpThreads_Private(out,out_from,in_from->nthreads,in_from->threads_send);CHKERRQ(ierr);
+  }
+
   PetscFunctionReturn(0);
 }
 
@@ -2142,6 +2239,27 @@ PetscErrorCode VecScatterCreateCommon_PtoS(VecScatter_MPI_General *from,VecScatt
     }
 
     ctx->copy      = VecScatterCopy_PtoP_X;
+
+#if defined(PETSC_THREADCOMM_ACTIVE)
+    {
+      PetscBool use_threads = PETSC_FALSE,threads_send = PETSC_FALSE;
+      PetscInt  nthreads;
+
+      ierr = PetscOptionsGetBool(PETSC_NULL,"-vecscatter_threads",&use_threads,PETSC_NULL);CHKERRQ(ierr);
+      ierr = PetscThreadCommGetNThreads(comm,&nthreads);CHKERRQ(ierr);
+      if (use_threads && nthreads > 1) {
+#if defined(PETSC_HAVE_MPI_INIT_THREAD)
+        PetscMPIInt provided;
+        ierr = MPI_Query_thread(&provided);CHKERRQ(ierr);
+        if (provided == MPI_THREAD_MULTIPLE) threads_send = PETSC_TRUE;
+#endif
+        ierr = PetscInfo2(ctx,"Packing and unpacking with %D threads%s\n",nthreads,threads_send ? ", the threads start the sends" : "");CHKERRQ(ierr);
+        ierr = VecScatterSetUpThreads_Private(ctx,to,nthreads,threads_send);CHKERRQ(ierr);
+        ierr = VecScatterSetUpThreads_Private(ctx,from,nthreads,threads_send);CHKERRQ(ierr);
+        ctx->packtogether = PETSC_FALSE;
+      }
+    }
+#endif
   }
   ierr = PetscInfo1(ctx,"Using blocksize %D scatter\n",bs);CHKERRQ(ierr);
 
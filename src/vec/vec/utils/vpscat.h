@@ -9,6 +9,76 @@
 #define PETSCMAP1_b(a,b)  PETSCMAP1_a(a,b)
 #define PETSCMAP1(a)      PETSCMAP1_b(a,BS)
 
+#if defined(PETSC_THREADCOMM_ACTIVE)
+/*
+   Packs the part of the send buffer assigned to this thread; when MPI allows it the thread
+   then starts the sends of the messages it packed.
+*/
+#undef __FUNCT__
+#define __FUNCT__ "VecScatterPack_Kernel_" PetscStringize(BS)
+PetscErrorCode PETSCMAP1(VecScatterPack_Kernel)(PetscInt thread_id,VecScatter_MPI_General *to,const PetscScalar *xv,MPI_Request *swaits)
+{
+  PetscErrorCode ierr;
+  PetscInt       i,start = to->tpackstarts[thread_id],end = to->tpackstarts[thread_id+1];
+
+  PETSCMAP1(Pack)(end-start,to->indices+start,xv,to->values+BS*start);
+  if (to->threads_send) {
+    for (i=to->tmsgstarts[thread_id]; i<to->tmsgstarts[thread_id+1]; i++) {
+      ierr = MPI_Start(swaits+i);CHKERRQ(ierr);
+    }
+  }
+  return 0;
+}
+
+/*
+   Unpacks the entries of the messages msgs[0:*nmsgs] that land in the part of the vector
+   owned by this thread; threads never write to the same entry of yv.
+*/
+#undef __FUNCT__
+#define __FUNCT__ "VecScatterUnPack_Kernel_" PetscStringize(BS)
+PetscErrorCode PETSCMAP1(VecScatterUnPack_Kernel)(PetscInt thread_id,VecScatter_MPI_General *from,PetscScalar *yv,InsertMode *addv,PetscMPIInt *msgs,PetscInt *nmsgs)
+{
+  PetscInt    i,j,k,p,start,end,nt = from->nthreads;
+  PetscInt    *slots = from->tunpackslots,*indices = from->indices;
+  PetscScalar *rvalues = from->values,*x,*y;
+
+  for (i=0; i<*nmsgs; i++) {
+    start = from->tunpackstarts[msgs[i]*nt+thread_id];
+    end   = from->tunpackstarts[msgs[i]*nt+thread_id+1];
+    switch (*addv) {
+    case INSERT_VALUES:
+    case INSERT_ALL_VALUES:
+      for (p=start; p<end; p++) {
+        k = slots[p]; x = rvalues + BS*k; y = yv + indices[k];
+        for (j=0; j<BS; j++) y[j] = x[j];
+      }
+      break;
+    case ADD_VALUES:
+    case ADD_ALL_VALUES:
+      for (p=start; p<end; p++) {
+        k = slots[p]; x = rvalues + BS*k; y = yv + indices[k];
+        for (j=0; j<BS; j++) y[j] += x[j];
+      }
+      break;
+#if !defined(PETSC_USE_COMPLEX)
+    case MAX_VALUES:
+      for (p=start; p<end; p++) {
+        k = slots[p]; x = rvalues + BS*k; y = yv + indices[k];
+        for (j=0; j<BS; j++) y[j] = PetscMax(y[j],x[j]);
+      }
+      break;
+#else
+    case MAX_VALUES:
+      SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support for MAX_VALUES with complex numbers");
+#endif
+    default:
+      SETERRQ1(PETSC_COMM_SELF,PETSC_ERR_ARG_WRONG,"Cannot handle insert mode %d",*addv);
+    }
+  }
+  return 0;
+}
+#endif
+
 #undef __FUNCT__
 #define __FUNCT__ "VecScatterBegin_" PetscStringize(BS)
 PetscErrorCode PETSCMAP1(VecScatterBegin)(VecScatter ctx,Vec xin,Vec yin,InsertMode addv,ScatterMode mode)
@@ -120,7 +190,23 @@ PetscErrorCode PETSCMAP1(VecScatterBegin)(VecScatter ctx,Vec xin,Vec yin,InsertM
       } else if (nsends) {
         ierr = MPI_Startall_isend(to->starts[to->n],nsends,swaits);CHKERRQ(ierr);
       }
-    } else {
+    } else
+#if defined(PETSC_THREADCOMM_ACTIVE)
+    if (to->use_threads) {
+      /* the threads pack the messages, and start the sends if MPI_THREAD_MULTIPLE is available */
+      ierr = PetscThreadCommRunKernel(((PetscObject)ctx)->comm,(PetscThreadKernel)PETSCMAP1(VecScatterPack_Kernel),3,to,xv,swaits);CHKERRQ(ierr);
+      ierr = PetscThreadCommBarrier(((PetscObject)ctx)->comm);CHKERRQ(ierr);
+      if (!to->threads_send) {
+        if (nsends) {ierr = MPI_Startall_isend(sstarts[nsends],nsends,swaits);CHKERRQ(ierr);}
+      } else {
+#if defined(PETSC_USE_LOG)
+        petsc_isend_ct  += (PetscLogDouble)nsends;
+        petsc_isend_len += (PetscLogDouble)(bs*sstarts[nsends]*sizeof(PetscScalar));
+#endif
+      }
+    } else
+#endif
+    {
       /* this version packs and sends one at a time */
       for (i=0; i<nsends; i++) {
         PETSCMAP1(Pack)(sstarts[i+1]-sstarts[i],indices + sstarts[i],xv,svalues + bs*sstarts[i]);
@@ -199,6 +285,31 @@ PetscErrorCode PETSCMAP1(VecScatterEnd)(VecScatter ctx,Vec xin,Vec yin,InsertMod
 #endif
     if (nrecvs && !to->use_alltoallv) {ierr = MPI_Waitall(nrecvs,rwaits,rstatus);CHKERRQ(ierr);}
     ierr = PETSCMAP1(UnPack)(from->starts[from->n],from->values,indices,yv,addv);CHKERRQ(ierr);
+#if defined(PETSC_THREADCOMM_ACTIVE)
+  } else if (from->use_threads) {
+    /* the threads unpack each batch of messages while the next batch is awaited */
+    PetscInt    first = 0,nbatch = 0;
+    PetscMPIInt outcount;
+
+    /* errors raised inside the kernel do not reach the caller */
+#if defined(PETSC_USE_COMPLEX)
+    if (addv == MAX_VALUES) SETERRQ(PETSC_COMM_SELF,PETSC_ERR_SUP,"No support for MAX_VALUES with complex numbers");
+#endif
+    if (ctx->reproduce && nrecvs) {
+      ierr = MPI_Waitall(nrecvs,rwaits,rstatus);CHKERRQ(ierr);
+      for (first=0; first<nrecvs; first++) from->tarrived[first] = (PetscMPIInt)first;
+      from->tbatch[0] = nrecvs;
+      ierr = PetscThreadCommRunKernel(((PetscObject)ctx)->comm,(PetscThreadKernel)PETSCMAP1(VecScatterUnPack_Kernel),5,from,yv,&addv,from->tarrived,from->tbatch);CHKERRQ(ierr);
+    }
+    while (first < nrecvs) {
+      ierr = MPI_Waitsome(nrecvs,rwaits,&outcount,from->tarrived+first,rstatus);CHKERRQ(ierr);
+      from->tbatch[nbatch] = outcount;
+      ierr = PetscThreadCommRunKernel(((PetscObject)ctx)->comm,(PetscThreadKernel)PETSCMAP1(VecScatterUnPack_Kernel),5,from,yv,&addv,from->tarrived+first,from->tbatch+nbatch);CHKERRQ(ierr);
+      first += outcount;
+      nbatch++;
+    }
+    ierr = PetscThreadCommBarrier(((PetscObject)ctx)->comm);CHKERRQ(ierr);
+#endif
   } else if (!to->use_alltoallw) {
     /* unpack one at a time */
     count = nrecvs;
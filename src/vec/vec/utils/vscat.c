@@ -874,6 +874,8 @@ PetscErrorCode  VecScatterCreateEmpty(MPI_Comm comm,VecScatter *newctx)
 .  -vecscatter_alltoall     - Uses MPI all to all communication for scatter
 .  -vecscatter_window       - Use MPI 2 window operations to move data
 .  -vecscatter_nopack       - Avoid packing to work vector when possible (if used with -vecscatter_alltoall then will use MPI_Alltoallw()
+.  -vecscatter_threads      - Pack and unpack the messages with the threads of the communicator's thread pool (see PetscThreadComm), each
+                              message is unpacked as soon as it arrives; with MPI_THREAD_MULTIPLE the threads also start the sends
 -  -vecscatter_reproduce    - insure that the order of the communications are done the same for each scatter, this under certain circumstances
                               will make the results of scatters deterministic when otherwise they are not (it may be slower also).
 